@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSCPARSELINE_H
+#define TDENGINE_TSCPARSELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hash.h"
+#include "taos.h"
+#include "tarray.h"
+
+typedef struct {
+  char* key;
+  uint8_t type;
+  int16_t length;
+  char* value;
+} TAOS_SML_KV;
+
+typedef struct {
+  char* stableName;
+
+  char* childTableName;
+  TAOS_SML_KV* tags;
+  int32_t tagNum;
+
+  // first kv must be timestamp
+  TAOS_SML_KV* fields;
+  int32_t fieldNum;
+} TAOS_SML_DATA_POINT;
+
+// Memory of the points parsed from a batch of lines, freed all at once with the batch.
+typedef struct SSmlArena SSmlArena;
+
+typedef struct {
+  uint64_t id;
+  SHashObj* smlDataToSchema;
+  int32_t numOfParseThreads;
+  SSmlArena* arena;  // NULL when the points are given by the application
+} SSmlLinesInfo;
+
+uint64_t   genLinesSmlId();
+SSmlArena* tscNewSmlArena();
+void       tscFreeSmlArena(SSmlArena* pArena);
+
+// Parse the lines into points allocated in info->arena. The lines are split into chunks parsed by at most
+// info->numOfParseThreads threads, the points are in the order of the lines.
+int32_t tscParseLines(char* lines[], int numLines, SArray* points, SArray* failedLines, SSmlLinesInfo* info);
+int     tscSmlInsert(TAOS* taos, TAOS_SML_DATA_POINT* points, int numPoint, SSmlLinesInfo* info);
+
+void tscInitSmlSchemaCache();
+void tscCleanupSmlSchemaCache();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSCPARSELINE_H
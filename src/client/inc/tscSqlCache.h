@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSCSQLCACHE_H
+#define TDENGINE_TSCSQLCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tsclient.h"
+
+extern int64_t tscSqlCacheHits;
+extern int64_t tscSqlCacheMisses;
+
+void tscInitSqlCache();
+void tscCleanupSqlCache();
+
+/**
+ * look up the validated query of the sql of pSql. If it is found, the query info of pSql->cmd is built from it
+ * with the time window of the sql and the query is ready to execute.
+ * @param pSql
+ * @return true if the query info is built from the cache
+ */
+bool tscSqlCacheLookup(SSqlObj *pSql);
+
+/**
+ * keep the query info validated for the sql of pSql, if its lookup missed and the query can be cached
+ * @param pSql
+ */
+void tscSqlCachePut(SSqlObj *pSql);
+
+void tscSqlCacheFreeStmt(SSqlObj *pSql);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSCSQLCACHE_H
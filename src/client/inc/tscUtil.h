@@ -112,6 +112,7 @@ int32_t tscCreateDataBlock(size_t initialSize, int32_t rowSize, int32_t startOff
 void tscDestroyDataBlock(STableDataBlocks* pDataBlock, bool removeMeta);
 void    tscSortRemoveDataBlockDupRowsRaw(STableDataBlocks* dataBuf);
 int     tscSortRemoveDataBlockDupRows(STableDataBlocks* dataBuf, SBlockKeyInfo* pBlkKeyInfo);
+int     tscSortRemoveDataBlockDupMemRows(STableDataBlocks* dataBuf, SBlockKeyInfo* pBlkKeyInfo);
 int32_t tsSetBlockInfo(SSubmitBlk *pBlocks, const STableMeta *pTableMeta, int32_t numOfRows);
 
 void tscDestroyBoundColumnInfo(SParsedDataColInfo* pColInfo);
@@ -162,6 +163,8 @@ bool tscIsProjectionQuery(SQueryInfo* pQueryInfo);
 bool tscHasColumnFilter(SQueryInfo* pQueryInfo);
 
 bool tscIsTwoStageSTableQuery(SQueryInfo* pQueryInfo, int32_t tableIndex);
+bool tscServerMergeQuery(SSqlObj* pSql, SQueryInfo* pQueryInfo);
+int32_t tscNumOfQueryPartitions(SQueryInfo* pQueryInfo);
 bool tscQueryTags(SQueryInfo* pQueryInfo);
 bool tscMultiRoundQuery(SQueryInfo* pQueryInfo, int32_t tableIndex);
 bool tscQueryBlockInfo(SQueryInfo* pQueryInfo);
@@ -262,6 +265,7 @@ STableMetaInfo* tscGetMetaInfo(SQueryInfo *pQueryInfo, int32_t tableIndex);
 void        tscInitQueryInfo(SQueryInfo* pQueryInfo);
 void        tscClearSubqueryInfo(SSqlCmd* pCmd);
 int32_t     tscAddQueryInfo(SSqlCmd *pCmd);
+int32_t     tscQueryInfoCopy(SQueryInfo* pQueryInfo, const SQueryInfo* pSrc);
 SQueryInfo *tscGetQueryInfo(SSqlCmd* pCmd);
 SQueryInfo *tscGetQueryInfoS(SSqlCmd *pCmd);
 
@@ -287,6 +291,7 @@ void executeQuery(SSqlObj* pSql, SQueryInfo* pQueryInfo);
 void doExecuteQuery(SSqlObj* pSql, SQueryInfo* pQueryInfo);
 
 SVgroupsInfo* tscVgroupInfoClone(SVgroupsInfo *pInfo);
+SVgroupsInfo* tscVgroupInfoFromIdList(const int32_t* vgIdList, int32_t numOfVgroups);
 void* tscVgroupInfoClear(SVgroupsInfo *pInfo);
 void tscSVgroupInfoCopy(SVgroupInfo* dst, const SVgroupInfo* src);
 /**
@@ -221,7 +221,8 @@ typedef struct STableDataBlocks {
   STableMeta *pTableMeta;   // the tableMeta of current table, the table meta will be used during submit, keep a ref to avoid to be removed from cache
   char       *pData;
   bool        cloned;
-  
+  bool        memRowPayload;  // rows bound from columnar batches are SMemRow already, instead of raw rows
+
   SParsedDataColInfo boundColumnInfo;
 
   // for parameter ('?') binding
@@ -336,6 +337,7 @@ typedef struct STscObj {
   char               sversion[TSDB_VERSION_LEN];
   char               writeAuth : 1;
   char               superAuth : 1;
+  char               rawNchar  : 1;  // keep nchar results in ucs4, as a dnode merging for a client does
   uint32_t           connId;
   uint64_t           rid;      // ref ID returned by taosAddRef
   int64_t            hbrid;
@@ -387,6 +389,10 @@ typedef struct SSqlObj {
 
   int64_t          squeryLock;
   int32_t          retryReason;  // previous error code
+  struct SSqlCacheStmt *pCacheStmt;  // the tokens of the sql from a miss of the sql cache to its validation
+  int8_t           clientMerge;     // the query is merged for a client, whose time window and timezone are used
+  STimeWindow      clientWindow;
+  int64_t          clientTimezone;  // seconds west of UTC
   struct SSqlObj  *prev, *next;
   int64_t          self;
 } SSqlObj;
@@ -412,6 +418,7 @@ typedef struct SSqlStream {
   int64_t stime;     // stream next executed time
   int64_t etime;     // stream end query time, when time is larger then etime, the stream will be closed
   int64_t ltime;     // stream last row time in stream table
+  int64_t incrKey;   // windows starting at or after it are computed incrementally by the CQ, the stream stops there
   SInterval interval;
   void *  pTimer;
 
@@ -445,9 +452,17 @@ int32_t tscTansformFuncForSTableQuery(SQueryInfo *pQueryInfo);
 void    tscRestoreFuncForSTableQuery(SQueryInfo *pQueryInfo);
 
 int32_t tscCreateResPointerInfo(SSqlRes *pRes, SQueryInfo *pQueryInfo);
-void tscSetResRawPtr(SSqlRes* pRes, SQueryInfo* pQueryInfo);
+void tscSetResRawPtr(SSqlRes* pRes, SQueryInfo* pQueryInfo, bool convertNchar);
 void tscSetResRawPtrRv(SSqlRes* pRes, SQueryInfo* pQueryInfo, SSDataBlock* pBlock, bool convertNchar);
 
+/**
+ * copy the current result block column by column, in the layout of SRetrieveTableRsp data
+ * @param pSql
+ * @param data  destination, NULL to get the size only
+ * @return      size of the block in bytes
+ */
+int32_t tscGetResRawBlock(SSqlObj* pSql, char* data);
+
 void handleDownstreamOperator(SSqlObj** pSqlList, int32_t numOfUpstream, SQueryInfo* px, SSqlObj* pParent);
 void destroyTableNameList(SInsertStatementParam* pInsertParam);
 
@@ -476,6 +491,7 @@ void tscCloseTscObj(void *pObj);
 TAOS *taos_connect_a(char *ip, char *user, char *pass, char *db, uint16_t port, void (*fp)(void *, TAOS_RES *, int),
                      void *param, TAOS **taos);
 TAOS_RES* taos_query_h(TAOS* taos, const char *sqlstr, int64_t* res);
+TAOS_RES* taos_query_merge(TAOS* taos, const char *sqlstr, STimeWindow* pWindow, int64_t tz);
 TAOS_RES * taos_query_ra(TAOS *taos, const char *sqlstr, __async_cb_func_t fp, void *param);
 
 void waitForQueryRsp(void *param, TAOS_RES *tres, int code);
@@ -498,6 +514,7 @@ int32_t tscInvalidOperationMsg(char *msg, const char *additionalInfo, const char
 int32_t tscSQLSyntaxErrMsg(char* msg, const char* additionalInfo,  const char* sql);
 
 int32_t tscValidateSqlInfo(SSqlObj *pSql, struct SSqlInfo *pInfo);
+int32_t checkQueryRangeForFill(SSqlCmd *pCmd, SQueryInfo *pQueryInfo);
 
 int32_t tsSetBlockInfo(SSubmitBlk *pBlocks, const STableMeta *pTableMeta, int32_t numOfRows);
 extern int32_t    sentinel;
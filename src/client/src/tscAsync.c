@@ -19,6 +19,7 @@
 #include "tnote.h"
 #include "trpc.h"
 #include "tscLog.h"
+#include "tscSqlCache.h"
 #include "tscSubquery.h"
 #include "tscUtil.h"
 #include "tsched.h"
@@ -60,6 +61,12 @@ void doAsyncQuery(STscObj* pObj, SSqlObj* pSql, __async_cb_func_t fp, void* para
   tscDebugL("0x%"PRIx64" SQL: %s", pSql->self, pSql->sqlstr);
   pCmd->resColumnId = TSDB_RES_COL_ID;
 
+  // a select statement validated before with the same literals but the ones of its time window
+  if (!pSql->clientMerge && tscSqlCacheLookup(pSql)) {
+    executeQuery(pSql, tscGetQueryInfo(pCmd));
+    return;
+  }
+
   int32_t code = tsParseSql(pSql, true);
   if (code == TSDB_CODE_TSC_ACTION_IN_PROGRESS) return;
   
@@ -455,7 +455,7 @@ int32_t tscCreateGlobalMergerEnv(SQueryInfo *pQueryInfo, tExtMemBuffer ***pMemBu
     pg *= 2;
   }
 
-  assert(numOfSub <= pTableMetaInfo->vgroupList->numOfVgroups);
+  assert(numOfSub <= pTableMetaInfo->vgroupList->numOfVgroups * MAX(pQueryInfo->numOfPartitions, 1));
   for (int32_t i = 0; i < numOfSub; ++i) {
     (*pMemBuffer)[i] = createExtMemBuffer(nBufferSizes, rlen, pg, pModel);
     (*pMemBuffer)[i]->flushModel = MULTIPLE_APPEND_MODEL;
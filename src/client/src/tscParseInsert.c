@@ -29,6 +29,7 @@
 #include "taosdef.h"
 
 #include "tscLog.h"
+#include "tscSqlCache.h"
 #include "ttoken.h"
 
 #include "tdataformat.h"
@@ -415,11 +416,6 @@ int32_t tsParseOneColumn(SSchema *pSchema, SStrToken *pToken, char *payload, cha
  * Do not employ sort operation is not involved if server time is used.
  */
 int32_t tsCheckTimestamp(STableDataBlocks *pDataBlocks, const char *start) {
-  // once the data block is disordered, we do NOT keep previous timestamp any more
-  if (!pDataBlocks->ordered) {
-    return TSDB_CODE_SUCCESS;
-  }
-
   TSKEY k = *(TSKEY *)start;
 
   if (k == INT64_MIN) {
@@ -437,6 +433,11 @@ int32_t tsCheckTimestamp(STableDataBlocks *pDataBlocks, const char *start) {
     }
   }
 
+  // once the data block is disordered, we do NOT keep previous timestamp any more
+  if (!pDataBlocks->ordered) {
+    return TSDB_CODE_SUCCESS;
+  }
+
   if (k <= pDataBlocks->prevTS && (pDataBlocks->tsSource == TSDB_USE_CLI_TS)) {
     pDataBlocks->ordered = false;
     tscWarn("NOT ordered input timestamp");
@@ -862,6 +863,57 @@ int tscSortRemoveDataBlockDupRows(STableDataBlocks *dataBuf, SBlockKeyInfo *pBlk
   return 0;
 }
 
+// rows bound from columnar batches are SMemRow of variable length, only the disordered ones need the key tuples
+int tscSortRemoveDataBlockDupMemRows(STableDataBlocks *dataBuf, SBlockKeyInfo *pBlkKeyInfo) {
+  SSubmitBlk *pBlocks = (SSubmitBlk *)dataBuf->pData;
+  int16_t     nRows = pBlocks->numOfRows;
+
+  dataBuf->prevTS = INT64_MIN;
+  if (dataBuf->ordered) {
+    return 0;
+  }
+
+  size_t nAlloc = nRows * sizeof(SBlockKeyTuple);
+  if (pBlkKeyInfo->pKeyTuple == NULL || pBlkKeyInfo->maxBytesAlloc < nAlloc) {
+    char *tmp = trealloc(pBlkKeyInfo->pKeyTuple, nAlloc);
+    if (tmp == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+    pBlkKeyInfo->pKeyTuple = (SBlockKeyTuple *)tmp;
+    pBlkKeyInfo->maxBytesAlloc = (int32_t)nAlloc;
+  }
+
+  SBlockKeyTuple *pBlkKeyTuple = pBlkKeyInfo->pKeyTuple;
+  char *          pBlockData = pBlocks->data;
+  for (int32_t n = 0; n < nRows; ++n) {
+    pBlkKeyTuple[n].skey = memRowKey(pBlockData);
+    pBlkKeyTuple[n].payloadAddr = pBlockData;
+    pBlockData += memRowTLen(pBlockData);
+  }
+
+  qsort(pBlkKeyTuple, nRows, sizeof(SBlockKeyTuple), rowDataCompar);
+
+  int32_t i = 0;
+  int32_t j = 1;
+  while (j < nRows) {
+    if (pBlkKeyTuple[i].skey == pBlkKeyTuple[j].skey) {
+      ++j;
+      continue;
+    }
+
+    int32_t nextPos = (++i);
+    if (nextPos != j) {
+      memmove(pBlkKeyTuple + nextPos, pBlkKeyTuple + j, sizeof(SBlockKeyTuple));
+    }
+    ++j;
+  }
+
+  dataBuf->ordered = true;
+  pBlocks->numOfRows = i + 1;
+
+  return 0;
+}
+
 static int32_t doParseInsertStatement(SInsertStatementParam *pInsertParam, char **str, STableDataBlocks* dataBuf, int32_t *totalNum) {  
   int32_t maxNumOfRows;
   int32_t code = tscAllocateMemIfNeed(dataBuf, getExtendedRowSize(dataBuf), &maxNumOfRows);
@@ -1603,6 +1655,10 @@ int tsParseSql(SSqlObj *pSql, bool initial) {
       strncpy(pCmd->payload, pCmd->insertParam.msg, TSDB_DEFAULT_PAYLOAD_SIZE);
     }
   } else {
+    if (pSql->clientMerge) {
+      taosSetThreadTimezone(true, pSql->clientTimezone);
+    }
+
     SSqlInfo sqlInfo = qSqlParse(pSql->sqlstr);
     ret = tscValidateSqlInfo(pSql, &sqlInfo);
     if (ret == TSDB_CODE_TSC_INVALID_OPERATION && pSql->parseRetry < 1 && sqlInfo.type == TSDB_SQL_SELECT) {
@@ -1614,6 +1670,19 @@ int tsParseSql(SSqlObj *pSql, bool initial) {
       ret = tscValidateSqlInfo(pSql, &sqlInfo);
     }
 
+    if (pSql->clientMerge) {
+      taosSetThreadTimezone(false, 0);
+
+      // now() is evaluated by the client as well, the window it resolved replaces the one of the dnode
+      if (ret == TSDB_CODE_SUCCESS && sqlInfo.type == TSDB_SQL_SELECT) {
+        tscGetQueryInfo(pCmd)->window = pSql->clientWindow;
+      }
+    }
+
+    if (ret == TSDB_CODE_SUCCESS && sqlInfo.type == TSDB_SQL_SELECT) {
+      tscSqlCachePut(pSql);
+    }
+
     SqlInfoDestroy(&sqlInfo);
   }
 
@@ -10,6 +10,7 @@
 #include "tstrbuild.h"
 #include "tname.h"
 #include "hash.h"
+#include "hashfunc.h"
 #include "tskiplist.h"
 
 #include "tscUtil.h"
@@ -17,6 +18,11 @@
 #include "tscLog.h"
 
 #include "taos.h"
+#include "tscParseLine.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 typedef struct  {
   char sTableName[TSDB_TABLE_NAME_LEN];
@@ -25,27 +31,9 @@ typedef struct  {
   SArray* tags; //SArray<SSchema>
   SArray* fields; //SArray<SSchema>
   uint8_t precision;
+  bool schemaCached;  // the db schema is known to hold the tags and fields, it is not loaded nor changed
 } SSmlSTableSchema;
 
-typedef struct {
-  char* key;
-  uint8_t type;
-  int16_t length;
-  char* value;
-} TAOS_SML_KV;
-
-typedef struct {
-  char* stableName;
-
-  char* childTableName;
-  TAOS_SML_KV* tags;
-  int32_t tagNum;
-
-  // first kv must be timestamp
-  TAOS_SML_KV* fields;
-  int32_t fieldNum;
-} TAOS_SML_DATA_POINT;
-
 typedef enum {
   SML_TIME_STAMP_NOW,
   SML_TIME_STAMP_SECONDS,
@@ -54,11 +42,6 @@ typedef enum {
   SML_TIME_STAMP_NANO_SECONDS
 } SMLTimeStampType;
 
-typedef struct {
-  uint64_t id;
-  SHashObj* smlDataToSchema;
-} SSmlLinesInfo;
-
 //=================================================================================================
 
 static uint64_t linesSmlHandleId = 0;
@@ -73,6 +56,81 @@ uint64_t genLinesSmlId() {
   return id;
 }
 
+//=================================================================================================
+
+#define SML_ARENA_BLOCK_SIZE 65536
+
+typedef struct SSmlArenaBlock {
+  struct SSmlArenaBlock* next;
+  size_t size;
+  size_t used;
+  char data[];
+} SSmlArenaBlock;
+
+struct SSmlArena {
+  SSmlArenaBlock* head;  // the block allocated from, the full blocks are after it
+};
+
+SSmlArena* tscNewSmlArena() {
+  return calloc(1, sizeof(SSmlArena));
+}
+
+void tscFreeSmlArena(SSmlArena* pArena) {
+  if (pArena == NULL) return;
+
+  SSmlArenaBlock* pBlock = pArena->head;
+  while (pBlock) {
+    SSmlArenaBlock* next = pBlock->next;
+    free(pBlock);
+    pBlock = next;
+  }
+  free(pArena);
+}
+
+static void* smlArenaAlloc(SSmlArena* pArena, size_t size) {
+  size = (size + 7) & ~((size_t)7);
+
+  SSmlArenaBlock* pBlock = pArena->head;
+  if (pBlock == NULL || pBlock->used + size > pBlock->size) {
+    size_t blockSize = MAX(SML_ARENA_BLOCK_SIZE, size);
+    SSmlArenaBlock* pNew = malloc(sizeof(SSmlArenaBlock) + blockSize);
+    if (pNew == NULL) return NULL;
+
+    pNew->size = blockSize;
+    pNew->used = 0;
+    if (pBlock != NULL && size > SML_ARENA_BLOCK_SIZE / 2) {
+      // a large allocation gets a block of its own, the current block keeps being allocated from
+      pNew->next = pBlock->next;
+      pBlock->next = pNew;
+    } else {
+      pNew->next = pBlock;
+      pArena->head = pNew;
+    }
+    pBlock = pNew;
+  }
+
+  void* p = pBlock->data + pBlock->used;
+  pBlock->used += size;
+  memset(p, 0, size);
+  return p;
+}
+
+// Take all the blocks of pSrc, which is left empty.
+static void smlArenaMerge(SSmlArena* pDst, SSmlArena* pSrc) {
+  SSmlArenaBlock* pTail = pSrc->head;
+  if (pTail == NULL) return;
+
+  while (pTail->next) pTail = pTail->next;
+  pTail->next = pDst->head;
+  pDst->head = pSrc->head;
+  pSrc->head = NULL;
+}
+
+// The points parsed from lines are in the arena of the batch, the ones of taos_sml_insert are allocated by calloc.
+static void* smlCalloc(SSmlLinesInfo* info, size_t size) {
+  return (info->arena != NULL) ? smlArenaAlloc(info->arena, size) : calloc(1, size);
+}
+
 int compareSmlColKv(const void* p1, const void* p2) {
   TAOS_SML_KV* kv1 = (TAOS_SML_KV*)p1;
   TAOS_SML_KV* kv2 = (TAOS_SML_KV*)p2;
@@ -230,7 +288,7 @@ static int32_t buildDataPointSchemas(TAOS_SML_DATA_POINT* points, int numPoint,
       pStableSchema= taosArrayGet(stableSchemas, *pStableIdx);
       stableIdx = *pStableIdx;
     } else {
-      SSmlSTableSchema schema;
+      SSmlSTableSchema schema = {0};
       strncpy(schema.sTableName, point->stableName, stableNameLen);
       schema.sTableName[stableNameLen] = '\0';
       schema.fields = taosArrayInit(64, sizeof(SSchema));
@@ -249,7 +307,7 @@ static int32_t buildDataPointSchemas(TAOS_SML_DATA_POINT* points, int numPoint,
         char childTableName[TSDB_TABLE_NAME_LEN];
         int32_t tableNameLen = TSDB_TABLE_NAME_LEN;
         getSmlMd5ChildTableName(point, childTableName, &tableNameLen, info);
-        point->childTableName = calloc(1, tableNameLen+1);
+        point->childTableName = smlCalloc(info, tableNameLen + 1);
         strncpy(point->childTableName, childTableName, tableNameLen);
         point->childTableName[tableNameLen] = '\0';
       }
@@ -634,11 +692,164 @@ static int32_t loadTableSchemaFromDB(TAOS* taos, char* tableName, SSmlSTableSche
   return code;
 }
 
+//=================================================================================================
+
+/*
+ * The tags and fields of the super tables known to be in the db, by "<db>.<super table>". A batch whose tags and
+ * fields of a super table are the ones of the entry, each with no more bytes, does not load the schema of the super
+ * table from the db. The entry of a super table is dropped when a batch writing to it fails.
+ */
+typedef struct {
+  uint64_t fingerprint;  // of the names and types of the columns
+  uint8_t  precision;
+  int32_t  numOfTags;
+  int32_t  numOfCols;    // the tags and then the fields but the timestamp, each sorted by lowercase name
+  char     tsName[TSDB_COL_NAME_LEN];
+  SSchema  cols[];
+} SSmlSchemaCacheEntry;
+
+static SHashObj* tscSmlSchemaCache = NULL;
+
+void tscInitSmlSchemaCache() {
+  if (tscSmlSchemaCache == NULL) {
+    tscSmlSchemaCache = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_ENTRY_LOCK);
+  }
+}
+
+void tscCleanupSmlSchemaCache() {
+  taosHashCleanup(tscSmlSchemaCache);
+  tscSmlSchemaCache = NULL;
+}
+
+static int32_t compareSmlSchemaName(const void* p1, const void* p2) {
+  return strcmp(((SSchema*)p1)->name, ((SSchema*)p2)->name);
+}
+
+static int32_t getSmlSchemaCacheKey(TAOS* taos, const char* sTableName, char* key) {
+  char sTableNameLowerCase[TSDB_TABLE_NAME_LEN];
+  strtolower(sTableNameLowerCase, sTableName);
+
+  int32_t len = snprintf(key, TSDB_TABLE_FNAME_LEN, "%s.%s", ((STscObj*)taos)->db, sTableNameLowerCase);
+  return MIN(len, TSDB_TABLE_FNAME_LEN - 1);
+}
+
+static SSmlSchemaCacheEntry* buildSmlSchemaCacheEntry(SSmlSTableSchema* pointSchema, size_t* pSize) {
+  int32_t numOfTags = (int32_t)taosArrayGetSize(pointSchema->tags);
+  int32_t numOfFields = (int32_t)taosArrayGetSize(pointSchema->fields) - 1;
+
+  *pSize = sizeof(SSmlSchemaCacheEntry) + sizeof(SSchema) * (numOfTags + numOfFields);
+  SSmlSchemaCacheEntry* pEntry = calloc(1, *pSize);
+  if (pEntry == NULL) return NULL;
+
+  pEntry->precision = pointSchema->precision;
+  pEntry->numOfTags = numOfTags;
+  pEntry->numOfCols = numOfTags + numOfFields;
+  tstrncpy(pEntry->tsName, ((SSchema*)taosArrayGet(pointSchema->fields, 0))->name, TSDB_COL_NAME_LEN);
+
+  for (int32_t i = 0; i < pEntry->numOfCols; ++i) {
+    SSchema* pCol = (i < numOfTags) ? taosArrayGet(pointSchema->tags, i)
+                                    : taosArrayGet(pointSchema->fields, i - numOfTags + 1);
+    pEntry->cols[i] = *pCol;
+    strtolower(pEntry->cols[i].name, pCol->name);
+  }
+  qsort(pEntry->cols, numOfTags, sizeof(SSchema), compareSmlSchemaName);
+  qsort(pEntry->cols + numOfTags, numOfFields, sizeof(SSchema), compareSmlSchemaName);
+
+  uint64_t fingerprint = (uint64_t)numOfTags;
+  for (int32_t i = 0; i < pEntry->numOfCols; ++i) {
+    SSchema* pCol = pEntry->cols + i;
+    fingerprint = fingerprint * 31 + MurmurHash3_32(pCol->name, (uint32_t)strlen(pCol->name));
+    fingerprint = fingerprint * 31 + pCol->type;
+  }
+  pEntry->fingerprint = fingerprint;
+
+  return pEntry;
+}
+
+// Mark the super tables of the batch found in the cache, they take the precision and timestamp name of the entries.
+static void checkSmlSchemaCache(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo* info) {
+  if (tscSmlSchemaCache == NULL) return;
+
+  SSmlSchemaCacheEntry* pCached = NULL;
+  size_t cachedSize = 0;
+
+  size_t numStable = taosArrayGetSize(stableSchemas);
+  for (int32_t i = 0; i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    pointSchema->schemaCached = false;
+
+    char key[TSDB_TABLE_FNAME_LEN];
+    int32_t keyLen = getSmlSchemaCacheKey(taos, pointSchema->sTableName, key);
+    if (taosHashGetCloneExt(tscSmlSchemaCache, key, keyLen, NULL, (void**)&pCached, &cachedSize) == NULL) {
+      continue;
+    }
+
+    size_t size = 0;
+    SSmlSchemaCacheEntry* pEntry = buildSmlSchemaCacheEntry(pointSchema, &size);
+    if (pEntry == NULL) continue;
+
+    bool hit = (pEntry->fingerprint == pCached->fingerprint && pEntry->numOfTags == pCached->numOfTags &&
+                pEntry->numOfCols == pCached->numOfCols);
+    for (int32_t j = 0; hit && j < pEntry->numOfCols; ++j) {
+      SSchema* pCol = pEntry->cols + j;
+      SSchema* pCachedCol = pCached->cols + j;
+      hit = (pCol->type == pCachedCol->type && pCol->bytes <= pCachedCol->bytes && strcmp(pCol->name, pCachedCol->name) == 0);
+    }
+    free(pEntry);
+
+    if (hit) {
+      SSchema* pointColTs = taosArrayGet(pointSchema->fields, 0);
+      tstrncpy(pointColTs->name, pCached->tsName, TSDB_COL_NAME_LEN);
+      pointSchema->precision = pCached->precision;
+      pointSchema->schemaCached = true;
+      tscDebug("SML:0x%"PRIx64" schema of super table %s is cached", info->id, key);
+    }
+  }
+
+  tfree(pCached);
+}
+
+static void updateSmlSchemaCache(TAOS* taos, SArray* stableSchemas) {
+  if (tscSmlSchemaCache == NULL) return;
+
+  size_t numStable = taosArrayGetSize(stableSchemas);
+  for (int32_t i = 0; i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    if (pointSchema->schemaCached) continue;
+
+    size_t size = 0;
+    SSmlSchemaCacheEntry* pEntry = buildSmlSchemaCacheEntry(pointSchema, &size);
+    if (pEntry == NULL) continue;
+
+    char key[TSDB_TABLE_FNAME_LEN];
+    int32_t keyLen = getSmlSchemaCacheKey(taos, pointSchema->sTableName, key);
+    taosHashPut(tscSmlSchemaCache, key, keyLen, pEntry, size);
+    free(pEntry);
+  }
+}
+
+static void removeSmlSchemaCache(TAOS* taos, SArray* stableSchemas) {
+  if (tscSmlSchemaCache == NULL) return;
+
+  size_t numStable = taosArrayGetSize(stableSchemas);
+  for (int32_t i = 0; i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    char key[TSDB_TABLE_FNAME_LEN];
+    int32_t keyLen = getSmlSchemaCacheKey(taos, pointSchema->sTableName, key);
+    taosHashRemove(tscSmlSchemaCache, key, keyLen);
+    pointSchema->schemaCached = false;
+  }
+}
+
 static int32_t modifyDBSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo* info) {
   int32_t code = 0;
   size_t numStable = taosArrayGetSize(stableSchemas);
   for (int i = 0; i < numStable; ++i) {
     SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    if (pointSchema->schemaCached) {
+      continue;
+    }
+
     SSmlSTableSchema  dbSchema;
     memset(&dbSchema, 0, sizeof(SSmlSTableSchema));
 
@@ -882,8 +1093,9 @@ static int32_t insertChildTableBatch(TAOS* taos,  char* cTableName, SArray* cols
   return code;
 }
 
-static int32_t arrangePointsByChildTableName(TAOS_SML_DATA_POINT* points, int numPoints,
-                                             SHashObj* cname2points, SArray* stableSchemas, SSmlLinesInfo* info) {
+// The timestamps are parsed in nanoseconds, they are converted to the precision of the db once before they are written.
+static void convertSmlTimePrecision(TAOS_SML_DATA_POINT* points, int numPoints, SArray* stableSchemas,
+                                    SSmlLinesInfo* info) {
   for (int32_t i = 0; i < numPoints; ++i) {
     TAOS_SML_DATA_POINT * point = points + i;
     uintptr_t valPointer = (uintptr_t)point;
@@ -908,6 +1120,13 @@ static int32_t arrangePointsByChildTableName(TAOS_SML_DATA_POINT* points, int nu
         *(int64_t*)(kv->value) = ts;
       }
     }
+  }
+}
+
+static int32_t arrangePointsByChildTableName(TAOS_SML_DATA_POINT* points, int numPoints,
+                                             SHashObj* cname2points, SArray* stableSchemas, SSmlLinesInfo* info) {
+  for (int32_t i = 0; i < numPoints; ++i) {
+    TAOS_SML_DATA_POINT * point = points + i;
 
     SArray* cTablePoints = NULL;
     SArray** pCTablePoints = taosHashGet(cname2points, point->childTableName, strlen(point->childTableName));
@@ -1072,6 +1291,41 @@ cleanup:
   return code;
 }
 
+static bool hasSmlSchemaCached(SArray* stableSchemas) {
+  size_t numStable = taosArrayGetSize(stableSchemas);
+  for (int32_t i = 0; i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    if (pointSchema->schemaCached) return true;
+  }
+  return false;
+}
+
+// Load the schemas of the super tables taken from the cache. The timestamps are already in the precision of the db.
+static int32_t reloadSmlSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo* info) {
+  size_t numStable = taosArrayGetSize(stableSchemas);
+  SArray* precisions = taosArrayInit(numStable, sizeof(uint8_t));
+  if (precisions == NULL) return TSDB_CODE_TSC_OUT_OF_MEMORY;
+
+  for (int32_t i = 0; i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    taosArrayPush(precisions, &pointSchema->precision);
+  }
+
+  removeSmlSchemaCache(taos, stableSchemas);
+  int32_t code = modifyDBSchemas(taos, stableSchemas, info);
+
+  for (int32_t i = 0; code == 0 && i < numStable; ++i) {
+    SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    if (pointSchema->precision != *(uint8_t*)taosArrayGet(precisions, i)) {
+      tscError("SML:0x%"PRIx64" precision of super table %s is changed", info->id, pointSchema->sTableName);
+      code = TSDB_CODE_TSC_INVALID_TIME_STAMP;
+    }
+  }
+
+  taosArrayDestroy(precisions);
+  return code;
+}
+
 int tscSmlInsert(TAOS* taos, TAOS_SML_DATA_POINT* points, int numPoint, SSmlLinesInfo* info) {
   tscDebug("SML:0x%"PRIx64" taos_sml_insert. number of points: %d", info->id, numPoint);
 
@@ -1086,17 +1340,35 @@ int tscSmlInsert(TAOS* taos, TAOS_SML_DATA_POINT* points, int numPoint, SSmlLine
     goto clean_up;
   }
 
+  checkSmlSchemaCache(taos, stableSchemas, info);
+
   tscDebug("SML:0x%"PRIx64" modify db schemas", info->id);
   code = modifyDBSchemas(taos, stableSchemas, info);
   if (code != 0) {
     tscError("SML:0x%"PRIx64" error change db schema : %s", info->id, tstrerror(code));
+    removeSmlSchemaCache(taos, stableSchemas);
     goto clean_up;
   }
 
+  convertSmlTimePrecision(points, numPoint, stableSchemas, info);
+
   tscDebug("SML:0x%"PRIx64" apply data points", info->id);
   code = applyDataPoints(taos, points, numPoint, stableSchemas, info);
+  if (code != 0 && hasSmlSchemaCached(stableSchemas)) {
+    // the super tables may have been changed since they were cached, their schemas are loaded and the points written
+    // again. The rows written before the failure are written again with the same timestamps and values.
+    tscDebug("SML:0x%"PRIx64" apply data points failed with cached schemas : %s, retry", info->id, tstrerror(code));
+    code = reloadSmlSchemas(taos, stableSchemas, info);
+    if (code == 0) {
+      code = applyDataPoints(taos, points, numPoint, stableSchemas, info);
+    }
+  }
+
   if (code != 0) {
     tscError("SML:0x%"PRIx64" error apply data points : %s", info->id, tstrerror(code));
+    removeSmlSchemaCache(taos, stableSchemas);
+  } else {
+    updateSmlSchemaCache(taos, stableSchemas);
   }
 
 clean_up:
@@ -1493,70 +1765,70 @@ static bool convertStrToNumber(TAOS_SML_KV *pVal, char*str, SSmlLinesInfo* info)
       if (!IS_VALID_TINYINT(val_s)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(int8_t *)(pVal->value) = (int8_t)val_s;
       break;
     case TSDB_DATA_TYPE_UTINYINT:
       if (!IS_VALID_UTINYINT(val_u)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(uint8_t *)(pVal->value) = (uint8_t)val_u;
       break;
     case TSDB_DATA_TYPE_SMALLINT:
       if (!IS_VALID_SMALLINT(val_s)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(int16_t *)(pVal->value) = (int16_t)val_s;
       break;
     case TSDB_DATA_TYPE_USMALLINT:
       if (!IS_VALID_USMALLINT(val_u)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(uint16_t *)(pVal->value) = (uint16_t)val_u;
       break;
     case TSDB_DATA_TYPE_INT:
       if (!IS_VALID_INT(val_s)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(int32_t *)(pVal->value) = (int32_t)val_s;
       break;
     case TSDB_DATA_TYPE_UINT:
       if (!IS_VALID_UINT(val_u)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(uint32_t *)(pVal->value) = (uint32_t)val_u;
       break;
     case TSDB_DATA_TYPE_BIGINT:
       if (!IS_VALID_BIGINT(val_s)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(int64_t *)(pVal->value) = (int64_t)val_s;
       break;
     case TSDB_DATA_TYPE_UBIGINT:
       if (!IS_VALID_UBIGINT(val_u)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(uint64_t *)(pVal->value) = (uint64_t)val_u;
       break;
     case TSDB_DATA_TYPE_FLOAT:
       if (!IS_VALID_FLOAT(val_d)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(float *)(pVal->value) = (float)val_d;
       break;
     case TSDB_DATA_TYPE_DOUBLE:
       if (!IS_VALID_DOUBLE(val_d)) {
         return false;
       }
-      pVal->value = calloc(length, 1);
+      pVal->value = smlCalloc(info, length);
       *(double *)(pVal->value) = (double)val_d;
       break;
     default:
@@ -1667,7 +1939,7 @@ static bool convertSmlValueType(TAOS_SML_KV *pVal, char *value,
   if (isBinary(value, len)) {
     pVal->type = TSDB_DATA_TYPE_BINARY;
     pVal->length = len - 2;
-    pVal->value = calloc(pVal->length, 1);
+    pVal->value = smlCalloc(info, pVal->length);
     //copy after "
     memcpy(pVal->value, value + 1, pVal->length);
     return true;
@@ -1676,7 +1948,7 @@ static bool convertSmlValueType(TAOS_SML_KV *pVal, char *value,
   if (isNchar(value, len)) {
     pVal->type = TSDB_DATA_TYPE_NCHAR;
     pVal->length = len - 3;
-    pVal->value = calloc(pVal->length, 1);
+    pVal->value = smlCalloc(info, pVal->length);
     //copy after L"
     memcpy(pVal->value, value + 2, pVal->length);
     return true;
@@ -1686,7 +1958,7 @@ static bool convertSmlValueType(TAOS_SML_KV *pVal, char *value,
   if (isBool(value, len, &bVal)) {
     pVal->type = TSDB_DATA_TYPE_BOOL;
     pVal->length = (int16_t)tDataTypes[pVal->type].bytes;
-    pVal->value = calloc(pVal->length, 1);
+    pVal->value = smlCalloc(info, pVal->length);
     memcpy(pVal->value, &bVal, pVal->length);
     return true;
   }
@@ -1767,48 +2039,65 @@ static int32_t convertSmlTimeStamp(TAOS_SML_KV *pVal, char *value,
 
   pVal->type = TSDB_DATA_TYPE_TIMESTAMP;
   pVal->length = (int16_t)tDataTypes[pVal->type].bytes;
-  pVal->value = calloc(pVal->length, 1);
+  pVal->value = smlCalloc(info, pVal->length);
   memcpy(pVal->value, &tsVal, pVal->length);
   return TSDB_CODE_SUCCESS;
 }
 
-static int32_t parseSmlTimeStamp(TAOS_SML_KV **pTS, const char **index, SSmlLinesInfo* info) {
-  const char *start, *cur;
-  int32_t ret = TSDB_CODE_SUCCESS;
-  int len = 0;
-  char key[] = "_ts";
-  char *value = NULL;
+// Position of the first of c1, c2, '\\' and '\0' from p. The loads are aligned to 16 bytes, so they never cross the
+// page of the terminating '\0'.
+static FORCE_INLINE const char *findSmlSpecialChar(const char *p, char c1, char c2) {
+#if defined(__SSE2__)
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+  const __m128i vEscape = _mm_set1_epi8('\\');
+  const __m128i vZero = _mm_setzero_si128();
 
-  start = cur = *index;
-  *pTS = calloc(1, sizeof(TAOS_SML_KV));
+  uint32_t       offset = (uint32_t)((uintptr_t)p & 15);
+  const __m128i *pBlock = (const __m128i *)(p - offset);
+  uint32_t       mask = (0xFFFFu << offset) & 0xFFFFu;  // the bytes before p are skipped
 
-  while(*cur != '\0') {
-    cur++;
-    len++;
-  }
+  while (1) {
+    __m128i v = _mm_load_si128(pBlock);
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, vEscape), _mm_cmpeq_epi8(v, vZero)));
+    uint32_t bits = (uint32_t)_mm_movemask_epi8(m) & mask;
+    if (bits != 0) {
+      return (const char *)pBlock + __builtin_ctz(bits);
+    }
+    mask = 0xFFFFu;
+    pBlock++;
+  }
+#else
+  while (*p != c1 && *p != c2 && *p != '\\' && *p != '\0') {
+    p++;
+  }
+  return p;
+#endif
+}
 
-  if (len > 0) {
-    value = calloc(len + 1, 1);
-    memcpy(value, start, len);
-  }
+// The timestamp is the rest of the line.
+static int32_t parseSmlTimeStamp(TAOS_SML_KV *pTS, const char **index, SSmlLinesInfo* info) {
+  const char *start = *index;
+  int32_t ret = TSDB_CODE_SUCCESS;
+  char key[] = "_ts";
+  size_t len = strlen(start);
 
-  ret = convertSmlTimeStamp(*pTS, value, len, info);
+  ret = convertSmlTimeStamp(pTS, (char *)start, (uint16_t)len, info);
   if (ret) {
-    free(value);
-    free(*pTS);
     return ret;
   }
-  free(value);
 
-  (*pTS)->key = calloc(sizeof(key), 1);
-  memcpy((*pTS)->key, key, sizeof(key));
+  pTS->key = smlCalloc(info, sizeof(key));
+  memcpy(pTS->key, key, sizeof(key));
+  *index = start + len;
   return ret;
 }
 
 static bool checkDuplicateKey(char *key, SHashObj *pHash, SSmlLinesInfo* info) {
   char *val = NULL;
   char *cur = key;
-  char keyLower[TSDB_COL_NAME_LEN];
+  char keyLower[TSDB_COL_NAME_LEN + 2];
   size_t keyLen = 0;
   while(*cur != '\0') {
     keyLower[keyLen] = tolower(*cur);
@@ -1829,9 +2118,10 @@ static bool checkDuplicateKey(char *key, SHashObj *pHash, SSmlLinesInfo* info) {
   return false;
 }
 
+
 static int32_t parseSmlKey(TAOS_SML_KV *pKV, const char **index, SHashObj *pHash, SSmlLinesInfo* info) {
   const char *cur = *index;
-  char key[TSDB_COL_NAME_LEN + 1];  // +1 to avoid key[len] over write
+  char key[TSDB_COL_NAME_LEN + 2];  // +2 to avoid key[len] over write
   uint16_t len = 0;
 
   //key field cannot start with digit
@@ -1844,6 +2134,18 @@ static int32_t parseSmlKey(TAOS_SML_KV *pKV, const char **index, SHashObj *pHash
       tscError("SML:0x%"PRIx64" Key field cannot exceeds 65 characters", info->id);
       return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
     }
+    //copy the plain characters up to the next special one at once
+    const char *next = findSmlSpecialChar(cur, '=', '=');
+    uint16_t n = (uint16_t)MIN(next - cur, TSDB_COL_NAME_LEN + 1 - len);
+    if (n > 0) {
+      memcpy(key + len, cur, n);
+      cur += n;
+      len += n;
+      continue;
+    }
+    if (*cur == '\0') {
+      break;
+    }
     //unescaped '=' identifies a tag key
     if (*cur == '=' && *(cur - 1) != '\\') {
       break;
@@ -1862,7 +2164,7 @@ static int32_t parseSmlKey(TAOS_SML_KV *pKV, const char **index, SHashObj *pHash
     return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
   }
 
-  pKV->key = calloc(len + 1, 1);
+  pKV->key = smlCalloc(info, len + 1);
   memcpy(pKV->key, key, len + 1);
   //tscDebug("SML:0x%"PRIx64" Key:%s|len:%d", info->id, pKV->key, len);
   *index = cur + 1;
@@ -1873,13 +2175,18 @@ static int32_t parseSmlKey(TAOS_SML_KV *pKV, const char **index, SHashObj *pHash
 static bool parseSmlValue(TAOS_SML_KV *pKV, const char **index,
                           bool *is_last_kv, SSmlLinesInfo* info) {
   const char *start, *cur;
+  char buf[128];
   char *value = NULL;
   uint16_t len = 0;
   start = cur = *index;
 
   while (1) {
+    //skip the plain characters up to the next special one at once
+    const char *next = findSmlSpecialChar(cur, ',', ' ');
+    len += (uint16_t)(next - cur);
+    cur = next;
     // unescaped ',' or ' ' or '\0' identifies a value
-    if ((*cur == ',' || *cur == ' ' || *cur == '\0') && *(cur - 1) != '\\') {
+    if (*cur == '\0' || ((*cur == ',' || *cur == ' ') && *(cur - 1) != '\\')) {
       //unescaped ' ' or '\0' indicates end of value
       *is_last_kv = (*cur == ' ' || *cur == '\0') ? true : false;
       break;
@@ -1892,19 +2199,21 @@ static bool parseSmlValue(TAOS_SML_KV *pKV, const char **index,
     len++;
   }
 
-  value = calloc(len + 1, 1);
+  // the value is converted in place, a short one is copied to the stack
+  value = (len < sizeof(buf)) ? buf : malloc(len + 1);
+  if (value == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
   memcpy(value, start, len);
   value[len] = '\0';
   if (!convertSmlValueType(pKV, value, len, info)) {
     tscError("SML:0x%"PRIx64" Failed to convert sml value string(%s) to any type",
             info->id, value);
-    //free previous alocated key field
-    free(pKV->key);
     pKV->key = NULL;
-    free(value);
+    if (value != buf) free(value);
     return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
   }
-  free(value);
+  if (value != buf) free(value);
 
   *index = (*cur == '\0') ? cur : cur + 1;
   return TSDB_CODE_SUCCESS;
@@ -1913,26 +2222,31 @@ static bool parseSmlValue(TAOS_SML_KV *pKV, const char **index,
 static int32_t parseSmlMeasurement(TAOS_SML_DATA_POINT *pSml, const char **index,
                                    uint8_t *has_tags, SSmlLinesInfo* info) {
   const char *cur = *index;
+  char stableName[TSDB_TABLE_NAME_LEN + 2];  // +2 to avoid stableName[len] over write
   uint16_t len = 0;
 
-  pSml->stableName = calloc(TSDB_TABLE_NAME_LEN + 1, 1);    // +1 to avoid 1772 line over write
-  if (pSml->stableName == NULL){
-      return TSDB_CODE_TSC_OUT_OF_MEMORY;
-  }
   if (isdigit(*cur)) {
     tscError("SML:0x%"PRIx64" Measurement field cannnot start with digit", info->id);
-    free(pSml->stableName);
-    pSml->stableName = NULL;
     return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
   }
 
   while (*cur != '\0') {
     if (len > TSDB_TABLE_NAME_LEN) {
       tscError("SML:0x%"PRIx64" Measurement field cannot exceeds 193 characters", info->id);
-      free(pSml->stableName);
-      pSml->stableName = NULL;
       return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
     }
+    //copy the plain characters up to the next special one at once
+    const char *next = findSmlSpecialChar(cur, ',', ' ');
+    uint16_t n = (uint16_t)MIN(next - cur, TSDB_TABLE_NAME_LEN + 1 - len);
+    if (n > 0) {
+      memcpy(stableName + len, cur, n);
+      cur += n;
+      len += n;
+      continue;
+    }
+    if (*cur == '\0') {
+      break;
+    }
     //first unescaped comma or space identifies measurement
     //if space detected first, meaning no tag in the input
     if (*cur == ',' && *(cur - 1) != '\\') {
@@ -1946,11 +2260,17 @@ static int32_t parseSmlMeasurement(TAOS_SML_DATA_POINT *pSml, const char **index
     if (*cur == '\\') {
       escapeSpecialCharacter(1, &cur);
     }
-    pSml->stableName[len] = *cur;
+    stableName[len] = *cur;
     cur++;
     len++;
   }
-  pSml->stableName[len] = '\0';
+  stableName[len] = '\0';
+
+  pSml->stableName = smlCalloc(info, len + 1);
+  if (pSml->stableName == NULL){
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+  memcpy(pSml->stableName, stableName, len + 1);
   *index = cur + 1;
   tscDebug("SML:0x%"PRIx64" Stable name in measurement:%s|len:%d", info->id, pSml->stableName, len);
 
@@ -1969,191 +2289,272 @@ static int32_t isValidChildTableName(const char *pTbName, int16_t len) {
 }
 
 
+
+// Scratch memory of the lines parsed by one thread, reused from line to line.
+typedef struct {
+  SHashObj*    keyHash;   // keys of the line, to find the duplicated ones
+  TAOS_SML_KV* kvs;       // kvs of the tags or fields being parsed, copied to the arena when they are all parsed
+  int32_t      capacity;
+} SSmlParseCtx;
+
 static int32_t parseSmlKvPairs(TAOS_SML_KV **pKVs, int *num_kvs,
                                const char **index, bool isField,
-                               TAOS_SML_DATA_POINT* smlData, SHashObj *pHash,
+                               TAOS_SML_DATA_POINT* smlData, SSmlParseCtx *pCtx,
                                SSmlLinesInfo* info) {
   const char *cur = *index;
   int32_t ret = TSDB_CODE_SUCCESS;
-  TAOS_SML_KV *pkv;
   bool is_last_kv = false;
 
-  int32_t capacity = 0;
-  if (isField) {
-    capacity = 64;
-    *pKVs = calloc(capacity, sizeof(TAOS_SML_KV));
-    // leave space for timestamp;
-    pkv = *pKVs;
-    pkv++;
-  } else {
-    capacity = 8;
-    *pKVs = calloc(capacity, sizeof(TAOS_SML_KV));
-    pkv = *pKVs;
-  }
+  // leave space for timestamp
+  int32_t num = isField ? 1 : 0;
 
   while (*cur != '\0') {
-    ret = parseSmlKey(pkv, &cur, pHash, info);
+    //reallocate addtional memory for more kvs
+    if (num + 1 > pCtx->capacity) {
+      int32_t capacity = MAX(64, pCtx->capacity * 3 / 2);
+      TAOS_SML_KV *more_kvs = realloc(pCtx->kvs, capacity * sizeof(TAOS_SML_KV));
+      if (more_kvs == NULL) {
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+      pCtx->kvs = more_kvs;
+      pCtx->capacity = capacity;
+    }
+
+    TAOS_SML_KV *pkv = pCtx->kvs + num;
+    memset(pkv, 0, sizeof(TAOS_SML_KV));
+
+    ret = parseSmlKey(pkv, &cur, pCtx->keyHash, info);
     if (ret) {
       tscError("SML:0x%"PRIx64" Unable to parse key", info->id);
-      goto error;
+      return ret;
     }
     ret = parseSmlValue(pkv, &cur, &is_last_kv, info);
     if (ret) {
       tscError("SML:0x%"PRIx64" Unable to parse value", info->id);
-      goto error;
+      return ret;
     }
     if (!isField &&
         (strcasecmp(pkv->key, "ID") == 0) && pkv->type == TSDB_DATA_TYPE_BINARY) {
       ret = isValidChildTableName(pkv->value, pkv->length);
       if (ret) {
-        goto error;
+        return ret;
       }
-      smlData->childTableName = malloc( pkv->length + 1);
+      smlData->childTableName = smlCalloc(info, pkv->length + 1);
       memcpy(smlData->childTableName, pkv->value, pkv->length);
       smlData->childTableName[pkv->length] = '\0';
-      free(pkv->key);
-      free(pkv->value);
     } else {
-      *num_kvs += 1;
+      num++;
     }
     if (is_last_kv) {
-      goto done;
-    }
-
-    //reallocate addtional memory for more kvs
-    TAOS_SML_KV *more_kvs = NULL;
-
-    if (isField) {
-      if ((*num_kvs + 2) > capacity) {
-        capacity *= 3; capacity /= 2;
-        more_kvs = realloc(*pKVs, capacity * sizeof(TAOS_SML_KV));
-      } else {
-        more_kvs = *pKVs;
-      }
-    } else {
-      if ((*num_kvs + 1) > capacity) {
-        capacity *= 3; capacity /= 2;
-        more_kvs = realloc(*pKVs, capacity * sizeof(TAOS_SML_KV));
-      } else {
-        more_kvs = *pKVs;
-      }
-    }
-
-    if (!more_kvs) {
-      goto error;
-    }
-    *pKVs = more_kvs;
-    //move pKV points to next TAOS_SML_KV block
-    if (isField) {
-      pkv = *pKVs + *num_kvs + 1;
-    } else {
-      pkv = *pKVs + *num_kvs;
+      break;
     }
   }
-  goto done;
 
-error:
-  return ret;
-done:
+  *pKVs = smlCalloc(info, MAX(num, 1) * sizeof(TAOS_SML_KV));
+  if (*pKVs == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+  if (num > 0) {
+    memcpy(*pKVs, pCtx->kvs, num * sizeof(TAOS_SML_KV));
+  }
+  *num_kvs = isField ? num - 1 : num;
   *index = cur;
   return ret;
 }
 
-static void moveTimeStampToFirstKv(TAOS_SML_DATA_POINT** smlData, TAOS_SML_KV *ts) {
-  TAOS_SML_KV* tsField = (*smlData)->fields;
-  tsField->length = ts->length;
-  tsField->type = ts->type;
-  tsField->value = malloc(ts->length);
-  tsField->key = malloc(strlen(ts->key) + 1);
-  memcpy(tsField->key, ts->key, strlen(ts->key) + 1);
-  memcpy(tsField->value, ts->value, ts->length);
-  (*smlData)->fieldNum = (*smlData)->fieldNum + 1;
-
-  free(ts->key);
-  free(ts->value);
-  free(ts);
-}
-
-int32_t tscParseLine(const char* sql, TAOS_SML_DATA_POINT* smlData, SSmlLinesInfo* info) {
+static int32_t parseSmlLine(const char* sql, TAOS_SML_DATA_POINT* smlData, SSmlParseCtx* pCtx, SSmlLinesInfo* info) {
   const char* index = sql;
   int32_t ret = TSDB_CODE_SUCCESS;
   uint8_t has_tags = 0;
-  TAOS_SML_KV *timestamp = NULL;
-  SHashObj *keyHashTable = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+
+  taosHashClear(pCtx->keyHash);
 
   ret = parseSmlMeasurement(smlData, &index, &has_tags, info);
   if (ret) {
     tscError("SML:0x%"PRIx64" Unable to parse measurement", info->id);
-    taosHashCleanup(keyHashTable);
     return ret;
   }
   tscDebug("SML:0x%"PRIx64" Parse measurement finished, has_tags:%d", info->id, has_tags);
 
   //Parse Tags
   if (has_tags) {
-    ret = parseSmlKvPairs(&smlData->tags, &smlData->tagNum, &index, false, smlData, keyHashTable, info);
+    ret = parseSmlKvPairs(&smlData->tags, &smlData->tagNum, &index, false, smlData, pCtx, info);
     if (ret) {
       tscError("SML:0x%"PRIx64" Unable to parse tag", info->id);
-      taosHashCleanup(keyHashTable);
       return ret;
     }
   }
   tscDebug("SML:0x%"PRIx64" Parse tags finished, num of tags:%d", info->id, smlData->tagNum);
 
   //Parse fields
-  ret = parseSmlKvPairs(&smlData->fields, &smlData->fieldNum, &index, true, smlData, keyHashTable, info);
+  ret = parseSmlKvPairs(&smlData->fields, &smlData->fieldNum, &index, true, smlData, pCtx, info);
   if (ret) {
     tscError("SML:0x%"PRIx64" Unable to parse field", info->id);
-    taosHashCleanup(keyHashTable);
     return ret;
   }
   tscDebug("SML:0x%"PRIx64" Parse fields finished, num of fields:%d", info->id, smlData->fieldNum);
-  taosHashCleanup(keyHashTable);
 
-  //Parse timestamp
-  ret = parseSmlTimeStamp(&timestamp, &index, info);
+  //Parse timestamp, the first kv of the fields
+  ret = parseSmlTimeStamp(smlData->fields, &index, info);
   if (ret) {
     tscError("SML:0x%"PRIx64" Unable to parse timestamp", info->id);
     return ret;
   }
-  moveTimeStampToFirstKv(&smlData, timestamp);
+  smlData->fieldNum = smlData->fieldNum + 1;
   tscDebug("SML:0x%"PRIx64" Parse timestamp finished", info->id);
 
   return TSDB_CODE_SUCCESS;
 }
 
-//=========================================================================
-
-void destroySmlDataPoint(TAOS_SML_DATA_POINT* point) {
-  for (int i=0; i<point->tagNum; ++i) {
-    free((point->tags+i)->key);
-    free((point->tags+i)->value);
-  }
-  free(point->tags);
-  for (int i=0; i<point->fieldNum; ++i) {
-    free((point->fields+i)->key);
-    free((point->fields+i)->value);
+static int32_t parseSmlLineRange(char* lines[], int32_t start, int32_t end, SArray* points, SSmlLinesInfo* info) {
+  SSmlParseCtx ctx = {0};
+  ctx.keyHash = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
+  if (ctx.keyHash == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
   }
-  free(point->fields);
-  free(point->stableName);
-  free(point->childTableName);
-}
 
-int32_t tscParseLines(char* lines[], int numLines, SArray* points, SArray* failedLines, SSmlLinesInfo* info) {
-  for (int32_t i = 0; i < numLines; ++i) {
+  int32_t code = TSDB_CODE_SUCCESS;
+  for (int32_t i = start; i < end; ++i) {
     TAOS_SML_DATA_POINT point = {0};
-    int32_t code = tscParseLine(lines[i], &point, info);
+    code = parseSmlLine(lines[i], &point, &ctx, info);
     if (code != TSDB_CODE_SUCCESS) {
       tscError("SML:0x%"PRIx64" data point line parse failed. line %d : %s", info->id, i, lines[i]);
-      destroySmlDataPoint(&point);
-      return TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+      code = TSDB_CODE_TSC_LINE_SYNTAX_ERROR;
+      break;
     } else {
       tscDebug("SML:0x%"PRIx64" data point line parse success. line %d", info->id, i);
     }
 
     taosArrayPush(points, &point);
   }
-  return 0;
+
+  taosHashCleanup(ctx.keyHash);
+  tfree(ctx.kvs);
+  return code;
+}
+
+//=========================================================================
+
+/*
+ * The lines of a batch are split into chunks parsed by the client workers and by the caller, each into the points and
+ * the arena of its task. A task still in the queue when the caller is done with its own chunk is parsed by the caller,
+ * so the caller does not wait for busy workers. The messages of the tasks in the queue keep the batch alive.
+ */
+#define SML_MIN_LINES_PER_PARSE_TASK 1024
+
+typedef struct {
+  int8_t        taken;
+  int32_t       start;
+  int32_t       end;
+  int32_t       code;
+  SArray*       points;
+  SSmlLinesInfo info;  // the one of the batch, with the arena of the task
+} SSmlParseTask;
+
+typedef struct {
+  char**        lines;
+  int32_t       numOfTasks;
+  int32_t       pending;  // tasks not parsed yet
+  int32_t       ref;      // the caller and the messages in the queue
+  tsem_t        done;
+  SSmlParseTask tasks[];
+} SSmlParseBatch;
+
+static void runSmlParseTask(SSmlParseBatch* pBatch, int32_t i) {
+  SSmlParseTask* pTask = pBatch->tasks + i;
+  if (atomic_val_compare_exchange_8(&pTask->taken, 0, 1) != 0) {
+    return;
+  }
+
+  pTask->code = parseSmlLineRange(pBatch->lines, pTask->start, pTask->end, pTask->points, &pTask->info);
+  if (atomic_sub_fetch_32(&pBatch->pending, 1) == 0) {
+    tsem_post(&pBatch->done);
+  }
+}
+
+static void releaseSmlParseBatch(SSmlParseBatch* pBatch) {
+  if (atomic_sub_fetch_32(&pBatch->ref, 1) > 0) {
+    return;
+  }
+
+  for (int32_t i = 0; i < pBatch->numOfTasks; ++i) {
+    taosArrayDestroy(pBatch->tasks[i].points);
+    tscFreeSmlArena(pBatch->tasks[i].info.arena);
+  }
+  tsem_destroy(&pBatch->done);
+  free(pBatch);
+}
+
+static void smlParseTaskFp(SSchedMsg* pMsg) {
+  SSmlParseBatch* pBatch = pMsg->ahandle;
+  runSmlParseTask(pBatch, (int32_t)(intptr_t)pMsg->thandle);
+  releaseSmlParseBatch(pBatch);
+}
+
+int32_t tscParseLines(char* lines[], int numLines, SArray* points, SArray* failedLines, SSmlLinesInfo* info) {
+  int32_t numOfTasks = MIN(info->numOfParseThreads,
+                           (numLines + SML_MIN_LINES_PER_PARSE_TASK - 1) / SML_MIN_LINES_PER_PARSE_TASK);
+  if (numOfTasks <= 1 || tscQhandle == NULL) {
+    return parseSmlLineRange(lines, 0, numLines, points, info);
+  }
+
+  SSmlParseBatch* pBatch = calloc(1, sizeof(SSmlParseBatch) + sizeof(SSmlParseTask) * numOfTasks);
+  if (pBatch == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  pBatch->lines = lines;
+  pBatch->numOfTasks = numOfTasks;
+  pBatch->pending = numOfTasks;
+  pBatch->ref = numOfTasks;
+  tsem_init(&pBatch->done, 0, 0);
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  for (int32_t i = 0; i < numOfTasks; ++i) {
+    SSmlParseTask* pTask = pBatch->tasks + i;
+    pTask->start = (int32_t)((int64_t)numLines * i / numOfTasks);
+    pTask->end = (int32_t)((int64_t)numLines * (i + 1) / numOfTasks);
+    pTask->points = taosArrayInit(pTask->end - pTask->start, sizeof(TAOS_SML_DATA_POINT));
+    pTask->info = *info;
+    pTask->info.arena = tscNewSmlArena();
+    if (pTask->points == NULL || pTask->info.arena == NULL) {
+      code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    pBatch->ref = 1;
+    releaseSmlParseBatch(pBatch);
+    return code;
+  }
+
+  for (int32_t i = 1; i < numOfTasks; ++i) {
+    SSchedMsg schedMsg = {0};
+    schedMsg.fp = smlParseTaskFp;
+    schedMsg.ahandle = pBatch;
+    schedMsg.thandle = (void*)(intptr_t)i;
+    taosScheduleTask(tscQhandle, &schedMsg);
+  }
+
+  for (int32_t i = 0; i < numOfTasks; ++i) {
+    runSmlParseTask(pBatch, i);
+  }
+  tsem_wait(&pBatch->done);
+
+  for (int32_t i = 0; i < numOfTasks; ++i) {
+    SSmlParseTask* pTask = pBatch->tasks + i;
+    if (code == TSDB_CODE_SUCCESS) {
+      code = pTask->code;
+    }
+    if (code == TSDB_CODE_SUCCESS) {
+      taosArrayAddAll(points, pTask->points);
+    }
+    smlArenaMerge(info->arena, pTask->info.arena);
+  }
+
+  tscDebug("SML:0x%"PRIx64" %d lines parsed by %d tasks, code:%d", info->id, numLines, numOfTasks, code);
+  releaseSmlParseBatch(pBatch);
+  return code;
 }
 
 int taos_insert_lines(TAOS* taos, char* lines[], int numLines) {
@@ -2161,9 +2562,11 @@ int taos_insert_lines(TAOS* taos, char* lines[], int numLines) {
 
   SSmlLinesInfo* info = calloc(1, sizeof(SSmlLinesInfo));
   info->id = genLinesSmlId();
+  info->numOfParseThreads = tsNumOfSmlParseThreads;
 
   if (numLines <= 0 || numLines > 65536) {
     tscError("SML:0x%"PRIx64" taos_insert_lines numLines should be between 1 and 65536. numLines: %d", info->id, numLines);
+    free(info);
     code = TSDB_CODE_TSC_APP_ERROR;
     return code;
   }
@@ -2178,8 +2581,11 @@ int taos_insert_lines(TAOS* taos, char* lines[], int numLines) {
   }
 
   SArray* lpPoints = taosArrayInit(numLines, sizeof(TAOS_SML_DATA_POINT));
-  if (lpPoints == NULL) {
+  info->arena = tscNewSmlArena();
+  if (lpPoints == NULL || info->arena == NULL) {
     tscError("SML:0x%"PRIx64" taos_insert_lines failed to allocate memory", info->id);
+    taosArrayDestroy(lpPoints);
+    tscFreeSmlArena(info->arena);
     free(info);
     return TSDB_CODE_TSC_OUT_OF_MEMORY;
   }
@@ -2200,15 +2606,10 @@ int taos_insert_lines(TAOS* taos, char* lines[], int numLines) {
 
 cleanup:
   tscDebug("SML:0x%"PRIx64" taos_insert_lines finish inserting %d lines. code: %d", info->id, numLines, code);
-  points = TARRAY_GET_START(lpPoints);
-  numPoints = taosArrayGetSize(lpPoints);
-  for (int i=0; i<numPoints; ++i) {
-    destroySmlDataPoint(points+i);
-  }
-
+  // the points are all in the arena
   taosArrayDestroy(lpPoints);
+  tscFreeSmlArena(info->arena);
 
   free(info);
   return code;
 }
-
@@ -911,6 +911,234 @@ static int doBindBatchParam(STableDataBlocks* pBlock, SParamInfo* param, TAOS_MU
   return TSDB_CODE_SUCCESS;
 }
 
+// The columnar batch is written as SMemRow directly when every column is bound in the order of the schema and the
+// timestamps are given by the client, instead of as raw rows converted again when the submit block is merged.
+static bool insertStmtMemRowBindable(STableDataBlocks* pBlock, TAOS_MULTI_BIND* bind, int32_t rowNum) {
+  SSchema* pSchema = tscGetTableSchema(pBlock->pTableMeta);
+  int32_t  numOfCols = tscGetNumOfColumns(pBlock->pTableMeta);
+  if (pBlock->numOfParams != numOfCols) {
+    return false;
+  }
+
+  int32_t offset = 0;
+  for (int32_t j = 0; j < numOfCols; ++j) {
+    if (pBlock->params[j].offset != offset) {
+      return false;
+    }
+    offset += pSchema[j].bytes;
+  }
+
+  TAOS_MULTI_BIND* tsBind = &bind[pBlock->params[0].idx];
+  if (tsBind->buffer_type != TSDB_DATA_TYPE_TIMESTAMP || tsBind->num != rowNum) {
+    return false;
+  }
+
+  for (int32_t i = 0; tsBind->is_null != NULL && i < rowNum; ++i) {
+    if (tsBind->is_null[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+typedef struct SMemRowColBind {
+  int8_t    type;
+  int16_t   bytes;
+  int32_t   toffset;  // offset in the tuple of the data row
+  char*     buffer;
+  uintptr_t bufferLength;
+  int32_t*  length;
+  char*     isNull;
+} SMemRowColBind;
+
+static int doBindBatchMemRows(STableDataBlocks* pBlock, TAOS_MULTI_BIND* bind, int32_t rowNum) {
+  STableMeta* pTableMeta = pBlock->pTableMeta;
+  int32_t     numOfCols = tscGetNumOfColumns(pTableMeta);
+
+  SMemRowColBind* cols = malloc(numOfCols * sizeof(SMemRowColBind));
+  if (cols == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  int32_t flen = 0;
+  int32_t maxRowLen = TD_MEM_ROW_DATA_HEAD_SIZE;
+  for (int32_t j = 0; j < numOfCols; ++j) {
+    SParamInfo*      param = &pBlock->params[j];
+    TAOS_MULTI_BIND* b = &bind[param->idx];
+    if (b->buffer_type != param->type || !isValidDataType(param->type) || b->num != rowNum) {
+      tscError("column mismatch or invalid");
+      code = TSDB_CODE_TSC_INVALID_VALUE;
+      goto _end;
+    }
+
+    if (IS_VAR_DATA_TYPE(param->type) && b->length == NULL) {
+      tscError("BINARY/NCHAR no length");
+      code = TSDB_CODE_TSC_INVALID_VALUE;
+      goto _end;
+    }
+
+    cols[j] = (SMemRowColBind){.type = param->type, .bytes = param->bytes, .toffset = TD_DATA_ROW_HEAD_SIZE + flen,
+                               .buffer = b->buffer, .bufferLength = b->buffer_length, .length = b->length,
+                               .isNull = b->is_null};
+
+    flen += TYPE_BYTES[param->type];
+    maxRowLen += TYPE_BYTES[param->type] + (IS_VAR_DATA_TYPE(param->type) ? param->bytes : 0);
+  }
+
+  // the timestamps decide if the rows need to be sorted when the submit block is merged, every one of them is checked
+  // for a server time mixed with the client ones
+  for (int32_t i = 0; i < rowNum; ++i) {
+    if (tsCheckTimestamp(pBlock, cols[0].buffer + cols[0].bufferLength * i) != TSDB_CODE_SUCCESS) {
+      tscError("invalid timestamp");
+      code = TSDB_CODE_TSC_INVALID_VALUE;
+      goto _end;
+    }
+  }
+
+  uint32_t totalDataSize = pBlock->size + rowNum * maxRowLen;
+  if (totalDataSize > pBlock->nAllocSize) {
+    const double factor = 1.5;
+
+    void* tmp = realloc(pBlock->pData, (uint32_t)(totalDataSize * factor));
+    if (tmp == NULL) {
+      code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+      goto _end;
+    }
+
+    pBlock->pData = (char*)tmp;
+    pBlock->nAllocSize = (uint32_t)(totalDataSize * factor);
+  }
+
+  char* p = pBlock->pData + pBlock->size;
+  for (int32_t i = 0; i < rowNum; ++i) {
+    memRowSetType(p, SMEM_ROW_DATA);
+    SDataRow trow = memRowDataBody(p);
+    dataRowSetVersion(trow, pTableMeta->sversion);
+
+    uint16_t len = (uint16_t)(TD_DATA_ROW_HEAD_SIZE + flen);
+    for (int32_t j = 0; j < numOfCols; ++j) {
+      SMemRowColBind* pCol = &cols[j];
+      char*           dst = POINTER_SHIFT(trow, pCol->toffset);
+      char*           value = pCol->buffer + pCol->bufferLength * i;
+
+      if (pCol->isNull != NULL && pCol->isNull[i]) {
+        value = (char*)getNullValue(pCol->type);
+        if (IS_VAR_DATA_TYPE(pCol->type)) {
+          *(VarDataOffsetT*)dst = len;
+          memcpy(POINTER_SHIFT(trow, len), value, varDataTLen(value));
+          len += varDataTLen(value);
+          continue;
+        }
+      }
+
+      switch (pCol->type) {
+        case TSDB_DATA_TYPE_BOOL:
+        case TSDB_DATA_TYPE_TINYINT:
+        case TSDB_DATA_TYPE_UTINYINT:
+          *(int8_t*)dst = *(int8_t*)value;
+          break;
+        case TSDB_DATA_TYPE_SMALLINT:
+        case TSDB_DATA_TYPE_USMALLINT:
+          *(int16_t*)dst = *(int16_t*)value;
+          break;
+        case TSDB_DATA_TYPE_INT:
+        case TSDB_DATA_TYPE_UINT:
+        case TSDB_DATA_TYPE_FLOAT:
+          *(int32_t*)dst = *(int32_t*)value;
+          break;
+        case TSDB_DATA_TYPE_BIGINT:
+        case TSDB_DATA_TYPE_UBIGINT:
+        case TSDB_DATA_TYPE_DOUBLE:
+          *(int64_t*)dst = *(int64_t*)value;
+          break;
+        case TSDB_DATA_TYPE_TIMESTAMP:
+          *(TKEY*)dst = (j == PRIMARYKEY_TIMESTAMP_COL_INDEX) ? tdGetTKEY(*(TSKEY*)value) : *(TSKEY*)value;
+          break;
+        default: {  // BINARY or NCHAR
+          char* pVar = POINTER_SHIFT(trow, len);
+          if (pCol->length[i] < 0 || pCol->length[i] > pCol->bytes - VARSTR_HEADER_SIZE) {
+            tscError("binary/nchar length too long, max:%d, actual:%d", (int32_t)(pCol->bytes - VARSTR_HEADER_SIZE),
+                     pCol->length[i]);
+            code = TSDB_CODE_TSC_INVALID_VALUE;
+            goto _end;
+          }
+
+          if (pCol->type == TSDB_DATA_TYPE_BINARY) {
+            STR_WITH_SIZE_TO_VARSTR(pVar, value, (VarDataLenT)pCol->length[i]);
+          } else {
+            int32_t output = 0;
+            if (!taosMbsToUcs4(value, pCol->length[i], varDataVal(pVar), pCol->bytes - VARSTR_HEADER_SIZE, &output)) {
+              tscError("convert nchar string to UCS4_LE failed:%s", value);
+              code = TSDB_CODE_TSC_INVALID_VALUE;
+              goto _end;
+            }
+            varDataSetLen(pVar, output);
+          }
+
+          *(VarDataOffsetT*)dst = len;
+          len += varDataTLen(pVar);
+        }
+      }
+    }
+
+    dataRowSetLen(trow, len);
+    p += TD_MEM_ROW_TYPE_SIZE + len;
+  }
+
+  pBlock->size = (uint32_t)(p - pBlock->pData);
+  pBlock->memRowPayload = true;
+
+_end:
+  free(cols);
+  return code;
+}
+
+// Columns are bound one by one or the rows one at a time into a block of SMemRow, convert it back to raw rows.
+static int insertStmtMemRowsToRaw(STableDataBlocks* pBlock, int32_t rowNum) {
+  SSchema* pSchema = tscGetTableSchema(pBlock->pTableMeta);
+  int32_t  numOfCols = tscGetNumOfColumns(pBlock->pTableMeta);
+
+  uint32_t nAllocSize = (uint32_t)(sizeof(SSubmitBlk) + (rowNum + 1) * pBlock->rowSize);
+  char*    pData = malloc(nAllocSize);
+  if (pData == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  memcpy(pData, pBlock->pData, sizeof(SSubmitBlk));
+
+  char* src = pBlock->pData + sizeof(SSubmitBlk);
+  char* dst = pData + sizeof(SSubmitBlk);
+  for (int32_t i = 0; i < rowNum; ++i) {
+    SDataRow trow = memRowDataBody(src);
+
+    int32_t toffset = TD_DATA_ROW_HEAD_SIZE;
+    for (int32_t j = 0; j < numOfCols; ++j) {
+      void* value = tdGetRowDataOfCol(trow, pSchema[j].type, toffset);
+      if (j == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+        *(TSKEY*)dst = dataRowKey(trow);
+      } else if (IS_VAR_DATA_TYPE(pSchema[j].type)) {
+        memcpy(dst, value, varDataTLen(value));
+      } else {
+        memcpy(dst, value, TYPE_BYTES[pSchema[j].type]);
+      }
+
+      toffset += TYPE_BYTES[pSchema[j].type];
+      dst += pSchema[j].bytes;
+    }
+
+    src += memRowTLen(src);
+  }
+
+  free(pBlock->pData);
+  pBlock->pData = pData;
+  pBlock->nAllocSize = nAllocSize;
+  pBlock->size = (uint32_t)(sizeof(SSubmitBlk) + rowNum * pBlock->rowSize);
+  pBlock->memRowPayload = false;
+  return TSDB_CODE_SUCCESS;
+}
+
 static int insertStmtBindParam(STscStmt* stmt, TAOS_BIND* bind) {
   SSqlCmd* pCmd = &stmt->pSql->cmd;
   STscStmt* pStmt = (STscStmt*)stmt;
@@ -946,6 +1174,13 @@ static int insertStmtBindParam(STscStmt* stmt, TAOS_BIND* bind) {
     }
   }
 
+  if (pBlock->memRowPayload) {
+    int32_t code = insertStmtMemRowsToRaw(pBlock, pCmd->batchSize);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
   uint32_t totalDataSize = sizeof(SSubmitBlk) + (pCmd->batchSize + 1) * pBlock->rowSize;
   if (totalDataSize > pBlock->nAllocSize) {
     const double factor = 1.5;
@@ -1015,6 +1250,28 @@ static int insertStmtBindParamBatch(STscStmt* stmt, TAOS_MULTI_BIND* bind, int c
     return invalidOperationMsg(tscGetErrorMsgPayload(&stmt->pSql->cmd), "invalid param colIdx");
   }
 
+  if (colIdx == -1 && (pBlock->memRowPayload || pCmd->batchSize == 0) && insertStmtMemRowBindable(pBlock, bind, rowNum)) {
+    if (pCmd->batchSize == 0) {
+      pBlock->size = sizeof(SSubmitBlk);
+    }
+
+    int code = doBindBatchMemRows(pBlock, bind, rowNum);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscError("0x%"PRIx64" bind columns: type mismatch or invalid", pStmt->pSql->self);
+      return invalidOperationMsg(tscGetErrorMsgPayload(&stmt->pSql->cmd), "bind column type mismatch or invalid");
+    }
+
+    pCmd->batchSize += rowNum - 1;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  if (pBlock->memRowPayload) {
+    int code = insertStmtMemRowsToRaw(pBlock, pCmd->batchSize);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
   uint32_t totalDataSize = sizeof(SSubmitBlk) + (pCmd->batchSize + rowNum) * pBlock->rowSize;
   if (totalDataSize > pBlock->nAllocSize) {
     const double factor = 1.5;
@@ -1086,7 +1343,9 @@ static int insertStmtUpdateBatch(STscStmt* stmt) {
 
   STableMeta* pTableMeta = pBlock->pTableMeta;
 
-  pBlock->size = sizeof(SSubmitBlk) + pCmd->batchSize * pBlock->rowSize;
+  if (!pBlock->memRowPayload) {
+    pBlock->size = sizeof(SSubmitBlk) + pCmd->batchSize * pBlock->rowSize;
+  }
   SSubmitBlk* pBlk = (SSubmitBlk*) pBlock->pData;
   pBlk->numOfRows = pCmd->batchSize;
   pBlk->dataLen = 0;
@@ -1109,22 +1368,48 @@ static int insertStmtAddBatch(STscStmt* stmt) {
 
 static int insertStmtReset(STscStmt* pStmt) {
   SSqlCmd* pCmd = &pStmt->pSql->cmd;
-  if (pCmd->batchSize > 2) {
+  // no data blocks are merged before the first execution
+  if (pCmd->batchSize > 2 && pCmd->insertParam.pDataBlocks != NULL) {
     int32_t alloced = (pCmd->batchSize + 1) / 2;
 
     size_t size = taosArrayGetSize(pCmd->insertParam.pDataBlocks);
     for (int32_t i = 0; i < size; ++i) {
       STableDataBlocks* pBlock = taosArrayGetP(pCmd->insertParam.pDataBlocks, i);
+      SSubmitBlk*       pSubmit = (SSubmitBlk*)pBlock->pData;
 
-      uint32_t totalDataSize = pBlock->size - sizeof(SSubmitBlk);
-      pBlock->size = sizeof(SSubmitBlk) + totalDataSize / alloced;
+      if (pBlock->memRowPayload) {
+        // the SMemRow rows are of variable length, keep the first ones whole
+        char* p = pSubmit->data;
+        for (int32_t j = 0; j < pSubmit->numOfRows / alloced; ++j) {
+          p += memRowTLen(p);
+        }
+        pBlock->size = (uint32_t)(p - pBlock->pData);
+      } else {
+        uint32_t totalDataSize = pBlock->size - sizeof(SSubmitBlk);
+        pBlock->size = sizeof(SSubmitBlk) + totalDataSize / alloced;
+      }
 
-      SSubmitBlk* pSubmit = (SSubmitBlk*)pBlock->pData;
       pSubmit->numOfRows = pSubmit->numOfRows / alloced;
     }
   }
   pCmd->batchSize = 0;
 
+  // the rows bound from columnar batches are dropped, the next bind starts with raw rows or a new batch
+  if (pCmd->insertParam.pTableBlockHashList != NULL) {
+    STableDataBlocks** p = taosHashIterate(pCmd->insertParam.pTableBlockHashList, NULL);
+    while (p != NULL) {
+      STableDataBlocks* pBlock = *p;
+      if (pBlock->memRowPayload) {
+        pBlock->size = sizeof(SSubmitBlk);
+        ((SSubmitBlk*)pBlock->pData)->numOfRows = 0;
+        pBlock->memRowPayload = false;
+        pBlock->ordered = true;
+        pBlock->prevTS = INT64_MIN;
+      }
+      p = taosHashIterate(pCmd->insertParam.pTableBlockHashList, p);
+    }
+  }
+
   STableMetaInfo* pTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, 0);
   pTableMetaInfo->vgroupIndex = 0;
   return TSDB_CODE_SUCCESS;
@@ -1154,7 +1439,9 @@ static int insertStmtExecute(STscStmt* stmt) {
       tscGetDataBlockFromList(pCmd->insertParam.pTableBlockHashList, pTableMeta->id.uid, TSDB_PAYLOAD_SIZE, sizeof(SSubmitBlk),
                               pTableMeta->tableInfo.rowSize, &pTableMetaInfo->name, pTableMeta, &pBlock, NULL);
   assert(ret == 0);
-  pBlock->size = sizeof(SSubmitBlk) + pCmd->batchSize * pBlock->rowSize;
+  if (!pBlock->memRowPayload) {
+    pBlock->size = sizeof(SSubmitBlk) + pCmd->batchSize * pBlock->rowSize;
+  }
   SSubmitBlk* pBlk = (SSubmitBlk*) pBlock->pData;
   pBlk->numOfRows = pCmd->batchSize;
   pBlk->dataLen = 0;
@@ -139,7 +139,6 @@ static int32_t validateSqlNode(SSqlObj* pSql, SSqlNode* pSqlNode, SQueryInfo* pQ
 
 static int32_t exprTreeFromSqlExpr(SSqlCmd* pCmd, tExprNode **pExpr, const tSqlExpr* pSqlExpr, SQueryInfo* pQueryInfo, SArray* pCols, uint64_t *uid);
 static bool    validateDebugFlag(int32_t v);
-static int32_t checkQueryRangeForFill(SSqlCmd* pCmd, SQueryInfo* pQueryInfo);
 static int32_t loadAllTableMeta(SSqlObj* pSql, struct SSqlInfo* pInfo);
 static tSqlExpr* extractExprForSTable(SSqlCmd* pCmd, tSqlExpr** pExpr, SQueryInfo* pQueryInfo, int32_t tableIndex);
 
@@ -5996,7 +5995,7 @@ int32_t validateOrderbyNode(SSqlCmd* pCmd, SQueryInfo* pQueryInfo, SSqlNode* pSq
       }
     }
 
-  } else if (UTIL_TABLE_IS_NORMAL_TABLE(pTableMetaInfo) || UTIL_TABLE_IS_CHILD_TABLE(pTableMetaInfo)) { // check order by clause for normal table & temp table
+  } else if (!UTIL_TABLE_IS_TMP_TABLE(pTableMetaInfo)) { // check order by clause for normal table & child table
     if (getColumnIndexByName(&columnName, pQueryInfo, &index, pMsgBuf) != TSDB_CODE_SUCCESS) {
       return invalidOperationMsg(pMsgBuf, msg1);
     }
@@ -6657,6 +6656,22 @@ int32_t validateLocalConfig(SMiscInfo* pOptions) {
     SStrToken* pValToken = taosArrayGet(pOptions->a, 1);
 
     int32_t val = strtol(pValToken->z, NULL, 10);
+
+    // the partitions of a vgroup queried in parallel, taken by the queries issued afterwards
+    if (pOptionToken->n == 16 && strncasecmp("queryParallelism", pOptionToken->z, pOptionToken->n) == 0) {
+      return (val >= 1 && val <= 64) ? TSDB_CODE_SUCCESS : TSDB_CODE_TSC_INVALID_OPERATION;
+    }
+
+    // the queries issued afterwards are merged by a dnode or by the client
+    if (pOptionToken->n == 11 && strncasecmp("serverMerge", pOptionToken->z, pOptionToken->n) == 0) {
+      return (val == 0 || val == 1) ? TSDB_CODE_SUCCESS : TSDB_CODE_TSC_INVALID_OPERATION;
+    }
+
+    // the buffer in MB of the order operators of the outer queries issued afterwards
+    if (pOptionToken->n == 14 && strncasecmp("sortBufferSize", pOptionToken->z, pOptionToken->n) == 0) {
+      return (val >= 1 && val <= 65536) ? TSDB_CODE_SUCCESS : TSDB_CODE_TSC_INVALID_OPERATION;
+    }
+
     if (!validateDebugFlag(val)) {
       return TSDB_CODE_TSC_INVALID_OPERATION;
     }
@@ -8683,32 +8698,11 @@ static int32_t doLoadAllTableMeta(SSqlObj* pSql, SQueryInfo* pQueryInfo, SSqlNod
     assert(pTableMetaInfo->pTableMeta != NULL);
 
     if (p->vgroupIdList != NULL) {
-      size_t s = taosArrayGetSize(p->vgroupIdList);
-
-      size_t vgroupsz = sizeof(SVgroupInfo) * s + sizeof(SVgroupsInfo);
-      pTableMetaInfo->vgroupList = calloc(1, vgroupsz);
+      int32_t s = (int32_t) taosArrayGetSize(p->vgroupIdList);
+      pTableMetaInfo->vgroupList = tscVgroupInfoFromIdList(TARRAY_GET_START(p->vgroupIdList), s);
       if (pTableMetaInfo->vgroupList == NULL) {
         return TSDB_CODE_TSC_OUT_OF_MEMORY;
       }
-
-      pTableMetaInfo->vgroupList->numOfVgroups = (int32_t) s;
-      for(int32_t j = 0; j < s; ++j) {
-        int32_t* id = taosArrayGet(p->vgroupIdList, j);
-
-        // check if current buffer contains the vgroup info. If not, add it
-        SNewVgroupInfo existVgroupInfo = {.inUse = -1,};
-        taosHashGetClone(tscVgroupMap, id, sizeof(*id), NULL, &existVgroupInfo);
-
-        assert(existVgroupInfo.inUse >= 0);
-        SVgroupInfo *pVgroup = &pTableMetaInfo->vgroupList->vgroups[j];
-
-        pVgroup->numOfEps = existVgroupInfo.numOfEps;
-        pVgroup->vgId = existVgroupInfo.vgId;
-        for (int32_t k = 0; k < existVgroupInfo.numOfEps; ++k) {
-          pVgroup->epAddr[k].port = existVgroupInfo.ep[k].port;
-          pVgroup->epAddr[k].fqdn = strndup(existVgroupInfo.ep[k].fqdn, TSDB_FQDN_LEN);
-        }
-      }
     }
   }
 
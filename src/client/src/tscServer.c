@@ -399,7 +399,9 @@ void tscProcessMsgFromServer(SRpcMsg *rpcMsg, SRpcEpSet *pEpSet) {
 
   if (pEpSet) {
     if (!tscEpSetIsEqual(&pSql->epSet, pEpSet)) {
-      if (pCmd->command < TSDB_SQL_MGMT) {
+      if (pQueryInfo != NULL && pQueryInfo->serverMerge) {
+        pSql->epSet = *pEpSet;
+      } else if (pCmd->command < TSDB_SQL_MGMT) {
         tscUpdateVgroupInfo(pSql, pEpSet);
       } else {
         tscUpdateMgmtEpSet(pSql, pEpSet);
@@ -609,6 +611,17 @@ int tscBuildFetchMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   pRetrieveMsg->free = htons(pQueryInfo->type);
   pRetrieveMsg->qId  = htobe64(pSql->res.qId);
 
+  // results merged by a dnode are fetched from the same dnode, whose epSet is kept by the sql object
+  if (pQueryInfo->serverMerge) {
+    pRetrieveMsg->header.vgId = 0;
+    pRetrieveMsg->header.contLen = htonl(sizeof(SRetrieveTableMsg));
+
+    pSql->cmd.payloadLen = sizeof(SRetrieveTableMsg);
+    pSql->cmd.msgType = TSDB_MSG_TYPE_MERGE_FETCH;
+    tscDebug("0x%"PRIx64" build merge fetch msg, qId:0x%" PRIx64, pSql->self, pSql->res.qId);
+    return TSDB_CODE_SUCCESS;
+  }
+
   // todo valid the vgroupId at the client side
   STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
   
@@ -877,9 +890,66 @@ static int32_t serializeSqlExpr(SSqlExpr* pExpr, STableMetaInfo* pTableMetaInfo,
   return TSDB_CODE_SUCCESS;
 }
 
+/*
+ * The sql string is sent to the dnode of one vgroup of the super table, which runs the query with its embedded
+ * client, pulls the partial results of all the vgroups and merges them, so only the final rows come back.
+ */
+static int32_t tscBuildMergeQueryMsg(SSqlObj *pSql) {
+  SSqlCmd *pCmd = &pSql->cmd;
+
+  int32_t sqlLen = (int32_t)strlen(pSql->sqlstr);
+  int32_t size = (int32_t)sizeof(SMergeQueryMsg) + sqlLen + 1;
+  if (TSDB_CODE_SUCCESS != tscAllocPayload(pCmd, size)) {
+    tscError("0x%"PRIx64" failed to malloc for merge query msg", pSql->self);
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  SQueryInfo     *pQueryInfo = tscGetQueryInfo(pCmd);
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+
+  // spread the merge work of different queries over the dnodes of the vgroups
+  SVgroupInfo *pVgroupInfo = NULL;
+  if (pTableMetaInfo->pVgroupTables != NULL) {
+    size_t numOfVgroups = taosArrayGetSize(pTableMetaInfo->pVgroupTables);
+    SVgroupTableInfo *pTableIdList = taosArrayGet(pTableMetaInfo->pVgroupTables, (size_t)pSql->self % numOfVgroups);
+    pVgroupInfo = &pTableIdList->vgInfo;
+  } else {
+    int32_t numOfVgroups = pTableMetaInfo->vgroupList->numOfVgroups;
+    pVgroupInfo = &pTableMetaInfo->vgroupList->vgroups[pSql->self % numOfVgroups];
+  }
+
+  tscSetDnodeEpSet(&pSql->epSet, pVgroupInfo);
+
+  SMergeQueryMsg *pMergeMsg = (SMergeQueryMsg *)pCmd->payload;
+  extractDBName(pSql->pTscObj->db, pMergeMsg->db);
+#if defined(WINDOWS) && _MSC_VER >= 1900
+  int64_t timezone = _timezone;
+#endif
+
+  pMergeMsg->skey = htobe64(pQueryInfo->window.skey);
+  pMergeMsg->ekey = htobe64(pQueryInfo->window.ekey);
+  pMergeMsg->timezone = htobe64(timezone);
+  pMergeMsg->sqlLen = htonl(sqlLen);
+  memcpy(pMergeMsg->sql, pSql->sqlstr, sqlLen + 1);
+
+  pMergeMsg->header.vgId = 0;
+  pMergeMsg->header.contLen = htonl(size);
+
+  pCmd->payloadLen = size;
+  pCmd->msgType = TSDB_MSG_TYPE_MERGE_QUERY;
+
+  tscDebug("0x%"PRIx64" merge query msg built, merged by the dnode of vgId:%d, db:%s", pSql->self, pVgroupInfo->vgId,
+           pMergeMsg->db);
+  return TSDB_CODE_SUCCESS;
+}
+
 int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   SSqlCmd *pCmd = &pSql->cmd;
 
+  if (tscGetQueryInfo(pCmd)->serverMerge) {
+    return tscBuildMergeQueryMsg(pSql);
+  }
+
   int32_t code = TSDB_CODE_SUCCESS;
   int32_t size = tscEstimateQueryMsgSize(pSql);
 
@@ -955,6 +1025,8 @@ int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   pQueryMsg->tbnameCondLen  = htonl(pQueryInfo->tagCond.tbnameCond.len);
   pQueryMsg->queryType      = htonl(pQueryInfo->type);
   pQueryMsg->prevResultLen  = htonl(pQueryInfo->bufLen);
+  pQueryMsg->numOfPartitions = htons(pQueryInfo->numOfPartitions);
+  pQueryMsg->partitionIndex  = htons(pQueryInfo->partitionIndex);
 
   // set column list ids
   size_t numOfCols = taosArrayGetSize(pQueryInfo->colList);
@@ -1763,7 +1835,7 @@ static int tscLocalResultCommonBuilder(SSqlObj *pSql, int32_t numOfRes) {
       return pRes->code;
     }
 
-    tscSetResRawPtr(pRes, pQueryInfo);
+    tscSetResRawPtr(pRes, pQueryInfo, true);
   } else {
     tscResetForNextRetrieve(pRes);
   }
@@ -1829,7 +1901,7 @@ int tscProcessRetrieveGlobalMergeRsp(SSqlObj *pSql) {
 
   uint64_t localQueryId = pSql->self;
   qTableQuery(pQueryInfo->pQInfo, &localQueryId);
-  convertQueryResult(pRes, pQueryInfo, pSql->self, true);
+  convertQueryResult(pRes, pQueryInfo, pSql->self, !pSql->pTscObj->rawNchar);
 
   code = pRes->code;
   if (pRes->code == TSDB_CODE_SUCCESS) {
@@ -2734,8 +2806,9 @@ int tscProcessRetrieveRspFromNode(SSqlObj *pSql) {
        !TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_SUBQUERY)) ||
       (tscNonOrderedProjectionQueryOnSTable(pQueryInfo, 0) &&
        !TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_JOIN_QUERY) &&
-       !TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_JOIN_SEC_STAGE))) {
-    tscSetResRawPtr(pRes, pQueryInfo);
+       !TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_JOIN_SEC_STAGE)) ||
+      pQueryInfo->serverMerge) {
+    tscSetResRawPtr(pRes, pQueryInfo, !pSql->pTscObj->rawNchar);
   }
 
   if (pSql->pSubscription != NULL) {
@@ -323,7 +323,8 @@ static void waitForRetrieveRsp(void *param, TAOS_RES *tres, int numOfRows) {
   tsem_post(&pSql->rspSem);
 }
 
-TAOS_RES* taos_query_c(TAOS *taos, const char *sqlstr, uint32_t sqlLen, int64_t* res) {
+static TAOS_RES* doQuery(TAOS *taos, const char *sqlstr, uint32_t sqlLen, int64_t* res, STimeWindow* pWindow,
+                         int64_t tz) {
   STscObj *pObj = (STscObj *)taos;
   if (pObj == NULL || pObj->signature != pObj) {
     terrno = TSDB_CODE_TSC_DISCONNECTED;
@@ -345,6 +346,12 @@ TAOS_RES* taos_query_c(TAOS *taos, const char *sqlstr, uint32_t sqlLen, int64_t*
     return NULL;
   }
   
+  if (pWindow != NULL) {
+    pSql->clientMerge = 1;
+    pSql->clientWindow = *pWindow;
+    pSql->clientTimezone = tz;
+  }
+
   tsem_init(&pSql->rspSem, 0, 0);
   doAsyncQuery(pObj, pSql, waitForQueryRsp, taos, sqlstr, sqlLen);
 
@@ -356,6 +363,15 @@ TAOS_RES* taos_query_c(TAOS *taos, const char *sqlstr, uint32_t sqlLen, int64_t*
   return pSql; 
 }
 
+TAOS_RES* taos_query_c(TAOS *taos, const char *sqlstr, uint32_t sqlLen, int64_t* res) {
+  return doQuery(taos, sqlstr, sqlLen, res, NULL, 0);
+}
+
+// a query merged by a dnode is run in the time window resolved by the client and parsed in the client's timezone
+TAOS_RES* taos_query_merge(TAOS* taos, const char *sqlstr, STimeWindow* pWindow, int64_t tz) {
+  return doQuery(taos, sqlstr, (uint32_t)strlen(sqlstr), NULL, pWindow, tz);
+}
+
 TAOS_RES* taos_query(TAOS *taos, const char *sqlstr) {
   return taos_query_c(taos, sqlstr, (uint32_t)strlen(sqlstr), NULL);
 }
@@ -571,7 +587,7 @@ static bool tscKillQueryInDnode(SSqlObj* pSql) {
 
   SQueryInfo *pQueryInfo = tscGetQueryInfo(pCmd);
 
-  if ((pQueryInfo == NULL) || pQueryInfo->globalMerge) {
+  if ((pQueryInfo == NULL) || (pQueryInfo->globalMerge && !pQueryInfo->serverMerge)) {
     return true;
   }
 
@@ -0,0 +1,817 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tcache.h"
+#include "tglobal.h"
+#include "tlist.h"
+#include "tscLog.h"
+#include "tscSqlCache.h"
+#include "tscUtil.h"
+#include "tsclient.h"
+#include "ttoken.h"
+#include "ttokendef.h"
+#include "tutil.h"
+
+/*
+ * The select statements validated by the client, by the db of the connection and the sql with each literal replaced
+ * by "?" and its token type. The sql that runs again with other values of the conditions on the primary timestamp,
+ * like a dashboard whose range moves on, copies the query info of its entry and sets the time window of its own
+ * values, without the parser and the validation. The other literals must be the ones of the entry, otherwise the sql
+ * is validated again and replaces the entry. An entry is only used while the meta of its table is the one it is
+ * validated with.
+ */
+
+#define SQL_CACHE_MAX_LEN      4096          // longer sql is not cached
+#define SQL_CACHE_KEEP_MS      (600 * 1000)  // an entry not used in 10 minutes is removed
+#define SQL_CACHE_REFRESH_SEC  60
+#define SQL_CACHE_MAX_TIME_STR 128
+
+typedef struct SSqlCacheStmt {
+  int64_t    parseTs;      // now in nanoseconds before the sql is parsed
+  int32_t    numOfTokens;  // the tokens of the sql but the spaces and comments
+  int32_t    keyLen;
+  SStrToken *tokens;
+  char      *key;
+} SSqlCacheStmt;
+
+typedef struct {
+  uint32_t optr;   // TK_GE, TK_GT, TK_LE, TK_LT or TK_EQ
+  int32_t  start;  // the tokens of the time value
+  int32_t  end;
+} SSqlCacheTimeCond;
+
+typedef struct {
+  SQueryInfo        *pQueryInfo;
+  int16_t            precision;
+  int32_t            resColumnId;
+  int32_t            numOfTokens;
+  int32_t            numOfConds;
+  char              *sql;        // the tokens point into it
+  SStrToken         *tokens;
+  int8_t            *timeToken;  // the tokens of the time values, which are not compared
+  SSqlCacheTimeCond *conds;
+} SSqlCacheEntry;
+
+int64_t tscSqlCacheHits = 0;
+int64_t tscSqlCacheMisses = 0;
+
+static SCacheObj *tscSqlCache = NULL;
+
+// the keys in the order their entries are added or replaced, the oldest at the head. A key whose entry is removed
+// after its keep time stays until it is the oldest one. The list and the map of its nodes are guarded by the mutex.
+static pthread_mutex_t tscSqlCacheMutex;
+static SList          *tscSqlCacheKeys = NULL;
+static SHashObj       *tscSqlCacheNodes = NULL;
+
+static void freeSqlCacheEntry(void *data) {
+  SSqlCacheEntry *pEntry = *(SSqlCacheEntry **)data;
+  if (pEntry == NULL) {
+    return;
+  }
+
+  if (pEntry->pQueryInfo != NULL) {
+    SSqlCmd cmd = {.pQueryInfo = pEntry->pQueryInfo};
+    tscFreeQueryInfo(&cmd, false, 0);
+  }
+
+  tfree(pEntry->sql);
+  tfree(pEntry->tokens);
+  tfree(pEntry->timeToken);
+  tfree(pEntry->conds);
+  tfree(pEntry);
+}
+
+void tscInitSqlCache() {
+  if (tsSqlCacheSize <= 0) {
+    return;
+  }
+
+  tscSqlCacheKeys = tdListNew(0);
+  tscSqlCacheNodes = taosHashInit(tsSqlCacheSize, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, false);
+  if (tscSqlCacheKeys == NULL || tscSqlCacheNodes == NULL) {
+    tscError("failed to init sql cache");
+    tscSqlCacheKeys = tdListFree(tscSqlCacheKeys);
+    taosHashCleanup(tscSqlCacheNodes);
+    tscSqlCacheNodes = NULL;
+    return;
+  }
+
+  pthread_mutex_init(&tscSqlCacheMutex, NULL);
+  tscSqlCache = taosCacheInit(TSDB_DATA_TYPE_BINARY, SQL_CACHE_REFRESH_SEC, true, freeSqlCacheEntry, "sqlCache");
+}
+
+void tscCleanupSqlCache() {
+  if (tscSqlCache == NULL) {
+    return;
+  }
+
+  tscDebug("sql cache cleanup, hits:%" PRId64 ", misses:%" PRId64, tscSqlCacheHits, tscSqlCacheMisses);
+  taosCacheCleanup(tscSqlCache);
+  tscSqlCache = NULL;
+
+  taosHashCleanup(tscSqlCacheNodes);
+  tscSqlCacheNodes = NULL;
+  tscSqlCacheKeys = tdListFree(tscSqlCacheKeys);
+  pthread_mutex_destroy(&tscSqlCacheMutex);
+}
+
+static bool isSqlCacheLiteral(uint32_t type) {
+  return type == TK_INTEGER || type == TK_FLOAT || type == TK_STRING || type == TK_VARIABLE || type == TK_BOOL ||
+         type == TK_HEX || type == TK_BIN;
+}
+
+static void destroySqlCacheStmt(SSqlCacheStmt *pStmt) {
+  if (pStmt == NULL) {
+    return;
+  }
+
+  tfree(pStmt->tokens);
+  tfree(pStmt->key);
+  tfree(pStmt);
+}
+
+// the tokens and the key of a select statement, or NULL if the sql is not cached
+static SSqlCacheStmt *createSqlCacheStmt(SSqlObj *pSql) {
+  char   *sql = pSql->sqlstr;
+  size_t  sqlLen = strlen(sql);
+  if (sqlLen > SQL_CACHE_MAX_LEN) {
+    return NULL;
+  }
+
+  SSqlCacheStmt *pStmt = calloc(1, sizeof(SSqlCacheStmt));
+  if (pStmt == NULL) {
+    return NULL;
+  }
+
+  // a literal of one character is replaced by "?" and at most 3 digits of its type
+  const char *db = pSql->pTscObj->db;
+  int32_t     capacity = 64;
+  pStmt->key = malloc(strlen(db) + 1 + sqlLen * 4 + 1);
+  pStmt->tokens = malloc(sizeof(SStrToken) * capacity);
+  if (pStmt->key == NULL || pStmt->tokens == NULL) {
+    goto _error;
+  }
+
+  pStmt->keyLen = sprintf(pStmt->key, "%s|", db);
+
+  int32_t numOfSelect = 0;
+  for (uint32_t i = 0; sql[i] != 0;) {
+    uint32_t type = 0;
+    uint32_t len = tGetToken(sql + i, &type);
+
+    // the placeholders of a stmt, the unions and the subqueries are validated each time
+    if (len == 0 || type == TK_ILLEGAL || type == TK_QUESTION || type == TK_UNION ||
+        (type == TK_SELECT && ++numOfSelect > 1)) {
+      goto _error;
+    }
+
+    if (type != TK_SPACE && type != TK_COMMENT) {
+      if (pStmt->numOfTokens >= capacity) {
+        capacity *= 2;
+        SStrToken *tmp = realloc(pStmt->tokens, sizeof(SStrToken) * capacity);
+        if (tmp == NULL) {
+          goto _error;
+        }
+        pStmt->tokens = tmp;
+      }
+
+      pStmt->tokens[pStmt->numOfTokens++] = (SStrToken){.n = len, .type = type, .z = sql + i};
+    }
+
+    if (isSqlCacheLiteral(type)) {
+      pStmt->keyLen += sprintf(pStmt->key + pStmt->keyLen, "?%u", type);
+    } else {
+      memcpy(pStmt->key + pStmt->keyLen, sql + i, len);
+      pStmt->keyLen += len;
+    }
+
+    i += len;
+  }
+
+  pStmt->key[pStmt->keyLen] = 0;
+  return pStmt;
+
+_error:
+  destroySqlCacheStmt(pStmt);
+  return NULL;
+}
+
+static bool isSqlCacheWhereEnd(uint32_t type) {
+  switch (type) {
+    case TK_INTERVAL:
+    case TK_SESSION:
+    case TK_STATE_WINDOW:
+    case TK_SLIDING:
+    case TK_FILL:
+    case TK_EVERY:
+    case TK_GROUP:
+    case TK_HAVING:
+    case TK_ORDER:
+    case TK_SLIMIT:
+    case TK_LIMIT:
+    case TK_SEMI:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// the end of the time value that starts at the token i, or -1 if it is not a value that the cache binds
+static int32_t getSqlCacheTimeValueEnd(const SStrToken *tokens, int32_t i, int32_t end) {
+  if (i >= end) {
+    return -1;
+  }
+
+  uint32_t type = tokens[i].type;
+  if (type == TK_STRING || type == TK_INTEGER) {
+    return i + 1;
+  }
+
+  if ((type == TK_MINUS || type == TK_PLUS) && i + 1 < end && tokens[i + 1].type == TK_INTEGER) {
+    return i + 2;
+  }
+
+  if (type == TK_NOW) {
+    i += 1;
+    while (i + 1 < end && (tokens[i].type == TK_PLUS || tokens[i].type == TK_MINUS) &&
+           tokens[i + 1].type == TK_VARIABLE) {
+      i += 2;
+    }
+    return i;
+  }
+
+  return -1;
+}
+
+/*
+ * The conditions on the primary timestamp that are joined by AND at the top of the where clause. If the primary
+ * timestamp is in any other place, or "now" is out of these conditions, the statement is not cached.
+ */
+static int32_t getSqlCacheTimeConds(const SSqlCacheStmt *pStmt, const char *tsName, SSqlCacheTimeCond *conds,
+                                    int32_t *numOfConds, int8_t *timeToken) {
+  const SStrToken *t = pStmt->tokens;
+  int32_t          n = pStmt->numOfTokens;
+  uint32_t         tsLen = (uint32_t)strlen(tsName);
+
+  int32_t where = -1;
+  for (int32_t i = 0; i < n && where < 0; ++i) {
+    if (t[i].type == TK_WHERE) {
+      where = i;
+    }
+  }
+
+  int32_t end = n;
+  bool    hasOr = false;
+  for (int32_t i = where + 1; where >= 0 && i < n; ++i) {
+    if (isSqlCacheWhereEnd(t[i].type)) {
+      end = i;
+      break;
+    }
+
+    if (t[i].type == TK_OR || t[i].type == TK_NOT) {
+      hasOr = true;
+    }
+  }
+
+  *numOfConds = 0;
+  for (int32_t i = where + 1; where >= 0 && i < end; ++i) {
+    if (t[i].type != TK_ID || t[i].n != tsLen || strncasecmp(t[i].z, tsName, tsLen) != 0) {
+      continue;
+    }
+
+    // the name of a table
+    if (i + 1 < end && t[i + 1].type == TK_DOT) {
+      return -1;
+    }
+
+    int32_t prev = i - 1;
+    if (t[prev].type == TK_DOT) {
+      if (i - 2 <= where || t[i - 2].type != TK_ID) {
+        return -1;
+      }
+      prev = i - 3;
+    }
+
+    if (hasOr || (t[prev].type != TK_WHERE && t[prev].type != TK_AND && t[prev].type != TK_LP) || i + 1 >= end) {
+      return -1;
+    }
+
+    int32_t  next = -1;
+    uint32_t optr = t[i + 1].type;
+    if (optr == TK_BETWEEN) {
+      int32_t e = getSqlCacheTimeValueEnd(t, i + 2, end);
+      if (e < 0 || e >= end || t[e].type != TK_AND) {
+        return -1;
+      }
+
+      next = getSqlCacheTimeValueEnd(t, e + 1, end);
+      if (next < 0) {
+        return -1;
+      }
+
+      conds[(*numOfConds)++] = (SSqlCacheTimeCond){.optr = TK_GE, .start = i + 2, .end = e};
+      conds[(*numOfConds)++] = (SSqlCacheTimeCond){.optr = TK_LE, .start = e + 1, .end = next};
+    } else if (optr == TK_GE || optr == TK_GT || optr == TK_LE || optr == TK_LT || optr == TK_EQ) {
+      next = getSqlCacheTimeValueEnd(t, i + 2, end);
+      if (next < 0) {
+        return -1;
+      }
+
+      conds[(*numOfConds)++] = (SSqlCacheTimeCond){.optr = optr, .start = i + 2, .end = next};
+    } else {
+      return -1;
+    }
+
+    if (next < end && t[next].type != TK_AND && t[next].type != TK_RP) {
+      return -1;
+    }
+
+    i = next - 1;
+  }
+
+  for (int32_t i = 0; i < *numOfConds; ++i) {
+    memset(timeToken + conds[i].start, 1, conds[i].end - conds[i].start);
+  }
+
+  for (int32_t i = 0; i < n; ++i) {
+    if (t[i].type == TK_NOW && !timeToken[i]) {
+      return -1;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t getSqlCacheTimeValue(const SStrToken *tokens, const SSqlCacheTimeCond *pCond, int16_t precision,
+                                    int64_t now, int64_t *val) {
+  const SStrToken *t = &tokens[pCond->start];
+
+  if (t->type == TK_NOW) {
+    int64_t v = now;
+    for (int32_t i = pCond->start + 1; i < pCond->end; i += 2) {
+      int64_t d = 0;
+      char    unit = 0;
+      if (parseAbsoluteDuration(tokens[i + 1].z, tokens[i + 1].n, &d, &unit, TSDB_TIME_PRECISION_NANO) !=
+          TSDB_CODE_SUCCESS) {
+        return -1;
+      }
+      v = (tokens[i].type == TK_PLUS) ? v + d : v - d;
+    }
+
+    *val = convertTimePrecision(v, TSDB_TIME_PRECISION_NANO, precision);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  char buf[SQL_CACHE_MAX_TIME_STR];
+  if (t->type == TK_STRING) {
+    if (t->n >= sizeof(buf)) {
+      return -1;
+    }
+
+    memcpy(buf, t->z, t->n);
+    buf[t->n] = 0;
+
+    int32_t len = strdequote(buf);
+    if (strnchr(buf, '-', len, false) != NULL) {
+      return taosParseTime(buf, val, len, precision, tsDaylight);
+    }
+  } else {
+    bool neg = (t->type == TK_MINUS);
+    if (t->type == TK_MINUS || t->type == TK_PLUS) {
+      t += 1;
+    }
+
+    if (t->n + 1 >= sizeof(buf)) {
+      return -1;
+    }
+
+    buf[0] = neg ? '-' : '+';
+    memcpy(buf + 1, t->z, t->n);
+    buf[t->n + 1] = 0;
+  }
+
+  // the epoch time in the precision of the database
+  char *p = (buf[0] == '-' || buf[0] == '+') ? buf + 1 : buf;
+  if (*p == 0) {
+    return -1;
+  }
+  for (; *p != 0; ++p) {
+    if (!isdigit(*p)) {
+      return -1;
+    }
+  }
+
+  errno = 0;
+  *val = strtoll(buf, NULL, 10);
+  return (errno == 0) ? TSDB_CODE_SUCCESS : -1;
+}
+
+static int32_t getSqlCacheTimeWindow(const SStrToken *tokens, const SSqlCacheTimeCond *conds, int32_t numOfConds,
+                                     int16_t precision, int64_t now, STimeWindow *win) {
+  *win = TSWINDOW_INITIALIZER;
+
+  for (int32_t i = 0; i < numOfConds; ++i) {
+    int64_t val = 0;
+    if (getSqlCacheTimeValue(tokens, &conds[i], precision, now, &val) != TSDB_CODE_SUCCESS) {
+      return -1;
+    }
+
+    switch (conds[i].optr) {
+      case TK_GE: win->skey = MAX(win->skey, val); break;
+      case TK_GT: win->skey = MAX(win->skey, val + 1); break;
+      case TK_LE: win->ekey = MIN(win->ekey, val); break;
+      case TK_LT: win->ekey = MIN(win->ekey, val - 1); break;
+      default:
+        win->skey = MAX(win->skey, val);
+        win->ekey = MIN(win->ekey, val);
+        break;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// the meta of the client is still the one the query is validated with
+static bool isSqlCacheMetaValid(STableMetaInfo *pTableMetaInfo) {
+  STableMeta *pMeta = pTableMetaInfo->pTableMeta;
+
+  char name[TSDB_TABLE_FNAME_LEN] = {0};
+  tNameExtractFullName(&pTableMetaInfo->name, name);
+
+  STableMeta *pCurrent = NULL;
+  size_t      size = 0;
+  taosHashGetCloneExt(tscTableMetaMap, name, strnlen(name, TSDB_TABLE_FNAME_LEN), NULL, (void **)&pCurrent, &size);
+
+  bool valid = (pCurrent != NULL && pCurrent->id.uid == pMeta->id.uid && pCurrent->tableType == pMeta->tableType);
+  if (valid && pCurrent->tableType == TSDB_CHILD_TABLE) {
+    // the schema of a child table is the one of its super table
+    STableMeta *pSTableMeta = NULL;
+    size = 0;
+    taosHashGetCloneExt(tscTableMetaMap, pCurrent->sTableName, strnlen(pCurrent->sTableName, TSDB_TABLE_FNAME_LEN),
+                        NULL, (void **)&pSTableMeta, &size);
+
+    valid = (pSTableMeta != NULL && pSTableMeta->id.uid == pCurrent->suid &&
+             pSTableMeta->sversion == pMeta->sversion && pSTableMeta->tversion == pMeta->tversion);
+    tfree(pSTableMeta);
+  } else if (valid) {
+    valid = (pCurrent->sversion == pMeta->sversion && pCurrent->tversion == pMeta->tversion);
+  }
+
+  tfree(pCurrent);
+  return valid;
+}
+
+// the vgroups of a super table from the vgroup list buffer, which keeps them for a few seconds
+static int32_t getSqlCacheVgroupList(STableMetaInfo *pTableMetaInfo) {
+  char name[TSDB_TABLE_FNAME_LEN] = {0};
+  tNameExtractFullName(&pTableMetaInfo->name, name);
+
+  void *pv = taosCacheAcquireByKey(tscVgroupListBuf, name, strnlen(name, TSDB_TABLE_FNAME_LEN));
+  if (pv == NULL) {
+    return -1;
+  }
+
+  tFilePage    *pData = (tFilePage *)pv;
+  SVgroupsInfo *pList = tscVgroupInfoFromIdList((int32_t *)pData->data, (int32_t)pData->num);
+  taosCacheRelease(tscVgroupListBuf, &pv, false);
+
+  if (pList == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  pTableMetaInfo->vgroupList = pList;
+  return TSDB_CODE_SUCCESS;
+}
+
+// the fields that tscQueryInfoCopy leaves to the validation
+static int32_t copySqlCacheQueryInfo(SQueryInfo *pDst, SQueryInfo *pSrc) {
+  int32_t code = tscQueryInfoCopy(pDst, pSrc);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pDst->distinct = pSrc->distinct;
+  pDst->onlyHasTagCond = pSrc->onlyHasTagCond;
+  pDst->udColumnId = pSrc->udColumnId;
+  pDst->havingFieldNum = pSrc->havingFieldNum;
+  pDst->stableQuery = pSrc->stableQuery;
+  pDst->groupbyColumn = pSrc->groupbyColumn;
+  pDst->simpleAgg = pSrc->simpleAgg;
+  pDst->projectionQuery = pSrc->projectionQuery;
+  pDst->hasFilter = pSrc->hasFilter;
+  pDst->onlyTagQuery = pSrc->onlyTagQuery;
+  pDst->stateWindow = pSrc->stateWindow;
+  pDst->globalMerge = pSrc->globalMerge;
+
+  if (!pSrc->arithmeticOnAgg && pSrc->exprList1 != NULL) {
+    pDst->exprList1 = taosArrayInit(4, POINTER_BYTES);
+    if (pDst->exprList1 == NULL || tscExprCopyAll(pDst->exprList1, pSrc->exprList1, true) != 0) {
+      code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+  }
+
+  return code;
+}
+
+static int32_t buildSqlCacheQueryInfo(SSqlObj *pSql, SSqlCacheEntry *pEntry, STimeWindow *win) {
+  SSqlCmd    *pCmd = &pSql->cmd;
+  SQueryInfo *pTemplate = pEntry->pQueryInfo;
+
+  int32_t code = tscAllocPayload(pCmd, TSDB_DEFAULT_PAYLOAD_SIZE);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tscAddQueryInfo(pCmd);
+  }
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  SQueryInfo *pQueryInfo = tscGetQueryInfo(pCmd);
+  if ((code = copySqlCacheQueryInfo(pQueryInfo, pTemplate)) != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  STableMetaInfo *pSrcInfo = tscGetMetaInfo(pTemplate, 0);
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  tstrncpy(pTableMetaInfo->aliasName, pSrcInfo->aliasName, sizeof(pTableMetaInfo->aliasName));
+
+  if (UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo)) {
+    pTableMetaInfo->vgroupList = tscVgroupInfoClear(pTableMetaInfo->vgroupList);
+    if ((code = getSqlCacheVgroupList(pTableMetaInfo)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  pQueryInfo->window = *win;
+  if (pQueryInfo->fillType != TSDB_FILL_NONE && (code = checkQueryRangeForFill(pCmd, pQueryInfo)) != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pCmd->command = TSDB_SQL_SELECT;
+  pCmd->active = pQueryInfo;
+  pCmd->resColumnId = pEntry->resColumnId;
+  pSql->res.precision = pEntry->precision;
+  return TSDB_CODE_SUCCESS;
+}
+
+static bool bindSqlCacheEntry(SSqlObj *pSql, SSqlCacheStmt *pStmt, SSqlCacheEntry *pEntry) {
+  if (pEntry->numOfTokens != pStmt->numOfTokens) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pStmt->numOfTokens; ++i) {
+    SStrToken *t = &pStmt->tokens[i];
+    SStrToken *s = &pEntry->tokens[i];
+    if (isSqlCacheLiteral(t->type) && !pEntry->timeToken[i] && (t->n != s->n || strncmp(t->z, s->z, t->n) != 0)) {
+      return false;
+    }
+  }
+
+  STimeWindow win;
+  if (getSqlCacheTimeWindow(pStmt->tokens, pEntry->conds, pEntry->numOfConds, pEntry->precision,
+                            taosGetTimestampNs(), &win) != TSDB_CODE_SUCCESS ||
+      win.skey > win.ekey) {
+    return false;
+  }
+
+  if (!isSqlCacheMetaValid(tscGetMetaInfo(pEntry->pQueryInfo, 0))) {
+    return false;
+  }
+
+  if (buildSqlCacheQueryInfo(pSql, pEntry, &win) != TSDB_CODE_SUCCESS) {
+    tscResetSqlCmd(&pSql->cmd, false, pSql->self);
+    return false;
+  }
+
+  tscDebug("0x%" PRIx64 " sql cache hit, window:%" PRId64 "-%" PRId64, pSql->self, win.skey, win.ekey);
+  return true;
+}
+
+bool tscSqlCacheLookup(SSqlObj *pSql) {
+  if (tscSqlCache == NULL) {
+    return false;
+  }
+
+  const char *sql = pSql->sqlstr;
+  while (isspace((unsigned char)*sql)) {
+    ++sql;
+  }
+
+  if (strncasecmp(sql, "select", 6) != 0) {
+    return false;
+  }
+
+  SSqlCacheStmt *pStmt = createSqlCacheStmt(pSql);
+  if (pStmt == NULL) {
+    atomic_add_fetch_64(&tscSqlCacheMisses, 1);
+    return false;
+  }
+
+  pStmt->parseTs = taosGetTimestampNs();
+
+  bool             hit = false;
+  SSqlCacheEntry **ppEntry = taosCacheAcquireByKey(tscSqlCache, pStmt->key, pStmt->keyLen);
+  if (ppEntry != NULL) {
+    hit = bindSqlCacheEntry(pSql, pStmt, *ppEntry);
+    taosCacheRelease(tscSqlCache, (void **)&ppEntry, false);
+  }
+
+  if (hit) {
+    atomic_add_fetch_64(&tscSqlCacheHits, 1);
+    destroySqlCacheStmt(pStmt);
+  } else {
+    atomic_add_fetch_64(&tscSqlCacheMisses, 1);
+    pSql->pCacheStmt = pStmt;
+  }
+
+  return hit;
+}
+
+// a single table queried by a plain select, whose query info does not depend on more than the time window
+static bool isSqlCacheQuery(SSqlCmd *pCmd) {
+  if (pCmd->command != TSDB_SQL_SELECT || pCmd->pQueryInfo == NULL || pCmd->pQueryInfo->sibling != NULL ||
+      pCmd->pQueryInfo != pCmd->active) {
+    return false;
+  }
+
+  SQueryInfo *pQueryInfo = pCmd->pQueryInfo;
+  if (pQueryInfo->numOfTables != 1 || taosArrayGetSize(pQueryInfo->pUpstream) > 0 || pQueryInfo->tsBuf != NULL ||
+      pQueryInfo->pUdfInfo != NULL || pQueryInfo->havingFieldNum > 0 || QUERY_IS_JOIN_QUERY(pQueryInfo->type) ||
+      tscIsPointInterpQuery(pQueryInfo)) {
+    return false;
+  }
+
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  return pTableMetaInfo->pTableMeta != NULL && pTableMetaInfo->pVgroupTables == NULL;
+}
+
+static bool isSqlCacheWindowIn(int64_t key, int64_t k1, int64_t k2) { return key >= MIN(k1, k2) && key <= MAX(k1, k2); }
+
+static SSqlCacheEntry *createSqlCacheEntry(SSqlObj *pSql, SSqlCacheStmt *pStmt) {
+  SSqlCmd        *pCmd = &pSql->cmd;
+  SQueryInfo     *pQueryInfo = tscGetQueryInfo(pCmd);
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  int16_t         precision = tscGetTableInfo(pTableMetaInfo->pTableMeta).precision;
+
+  SSqlCacheEntry *pEntry = calloc(1, sizeof(SSqlCacheEntry));
+  if (pEntry == NULL) {
+    return NULL;
+  }
+
+  int32_t n = pStmt->numOfTokens;
+  pEntry->precision = precision;
+  pEntry->resColumnId = pCmd->resColumnId;
+  pEntry->numOfTokens = n;
+  pEntry->sql = strdup(pSql->sqlstr);
+  pEntry->tokens = malloc(sizeof(SStrToken) * n);
+  pEntry->timeToken = calloc(n, sizeof(int8_t));
+  pEntry->conds = calloc(n / 2 + 1, sizeof(SSqlCacheTimeCond));
+  if (pEntry->sql == NULL || pEntry->tokens == NULL || pEntry->timeToken == NULL || pEntry->conds == NULL) {
+    goto _error;
+  }
+
+  const char *tsName = tscGetTableSchema(pTableMetaInfo->pTableMeta)[PRIMARYKEY_TIMESTAMP_COL_INDEX].name;
+  if (getSqlCacheTimeConds(pStmt, tsName, pEntry->conds, &pEntry->numOfConds, pEntry->timeToken) !=
+      TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  // the window of the validation is the one of these conditions, with "now" taken between the parse and this moment
+  STimeWindow w1, w2;
+  if (getSqlCacheTimeWindow(pStmt->tokens, pEntry->conds, pEntry->numOfConds, precision, pStmt->parseTs, &w1) !=
+          TSDB_CODE_SUCCESS ||
+      getSqlCacheTimeWindow(pStmt->tokens, pEntry->conds, pEntry->numOfConds, precision, taosGetTimestampNs(), &w2) !=
+          TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  if (!isSqlCacheWindowIn(pQueryInfo->window.skey, w1.skey, w2.skey) ||
+      !isSqlCacheWindowIn(pQueryInfo->window.ekey, w1.ekey, w2.ekey)) {
+    tscDebug("0x%" PRIx64 " sql not cached, window:%" PRId64 "-%" PRId64 " of the conditions:%" PRId64 "-%" PRId64,
+             pSql->self, pQueryInfo->window.skey, pQueryInfo->window.ekey, w1.skey, w1.ekey);
+    goto _error;
+  }
+
+  for (int32_t i = 0; i < n; ++i) {
+    pEntry->tokens[i] = pStmt->tokens[i];
+    pEntry->tokens[i].z = pEntry->sql + (pStmt->tokens[i].z - pSql->sqlstr);
+  }
+
+  pEntry->pQueryInfo = calloc(1, sizeof(SQueryInfo));
+  if (pEntry->pQueryInfo == NULL) {
+    goto _error;
+  }
+
+  tscInitQueryInfo(pEntry->pQueryInfo);
+  if (copySqlCacheQueryInfo(pEntry->pQueryInfo, pQueryInfo) != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  tstrncpy(tscGetMetaInfo(pEntry->pQueryInfo, 0)->aliasName, pTableMetaInfo->aliasName,
+           sizeof(pTableMetaInfo->aliasName));
+  return pEntry;
+
+_error:
+  freeSqlCacheEntry(&pEntry);
+  return NULL;
+}
+
+// remove the entry added or replaced the earliest, the cache is full
+static void evictSqlCacheEntry() {
+  SListNode *pNode = tdListPopHead(tscSqlCacheKeys);
+  if (pNode == NULL) {
+    return;
+  }
+
+  int32_t keyLen = *(int32_t *)pNode->data;
+  char   *key = pNode->data + sizeof(int32_t);
+  taosHashRemove(tscSqlCacheNodes, key, keyLen);
+
+  void *pData = taosCacheAcquireByKey(tscSqlCache, key, keyLen);
+  if (pData != NULL) {
+    taosCacheRelease(tscSqlCache, &pData, true);
+  }
+
+  listNodeFree(pNode);
+}
+
+// the key becomes the newest one of the list, false if there is no memory for it
+static bool touchSqlCacheKey(const char *key, int32_t keyLen) {
+  SListNode **ppNode = taosHashGet(tscSqlCacheNodes, key, keyLen);
+  if (ppNode != NULL) {
+    tdListPopNode(tscSqlCacheKeys, *ppNode);
+    tdListAppendNode(tscSqlCacheKeys, *ppNode);
+    return true;
+  }
+
+  SListNode *pNode = malloc(sizeof(SListNode) + sizeof(int32_t) + keyLen);
+  if (pNode == NULL) {
+    return false;
+  }
+
+  pNode->next = pNode->prev = NULL;
+  *(int32_t *)pNode->data = keyLen;
+  memcpy(pNode->data + sizeof(int32_t), key, keyLen);
+  if (taosHashPut(tscSqlCacheNodes, key, keyLen, &pNode, POINTER_BYTES) != 0) {
+    listNodeFree(pNode);
+    return false;
+  }
+
+  // the entry of the same key is replaced, otherwise the oldest one makes room for the new one
+  while (listNEles(tscSqlCacheKeys) >= tsSqlCacheSize) {
+    evictSqlCacheEntry();
+  }
+
+  tdListAppendNode(tscSqlCacheKeys, pNode);
+  return true;
+}
+
+void tscSqlCachePut(SSqlObj *pSql) {
+  SSqlCacheStmt *pStmt = pSql->pCacheStmt;
+  if (pStmt == NULL) {
+    return;
+  }
+
+  pSql->pCacheStmt = NULL;
+  if (tscSqlCache == NULL || !isSqlCacheQuery(&pSql->cmd)) {
+    destroySqlCacheStmt(pStmt);
+    return;
+  }
+
+  SSqlCacheEntry *pEntry = createSqlCacheEntry(pSql, pStmt);
+  if (pEntry != NULL) {
+    void *p = NULL;
+
+    pthread_mutex_lock(&tscSqlCacheMutex);
+    if (touchSqlCacheKey(pStmt->key, pStmt->keyLen)) {
+      p = taosCachePut(tscSqlCache, pStmt->key, pStmt->keyLen, &pEntry, POINTER_BYTES, SQL_CACHE_KEEP_MS);
+    }
+    pthread_mutex_unlock(&tscSqlCacheMutex);
+
+    if (p != NULL) {
+      tscDebug("0x%" PRIx64 " sql cached, time conditions:%d", pSql->self, pEntry->numOfConds);
+      taosCacheRelease(tscSqlCache, &p, false);
+    } else {
+      freeSqlCacheEntry(&pEntry);
+    }
+  }
+
+  destroySqlCacheStmt(pStmt);
+}
+
+void tscSqlCacheFreeStmt(SSqlObj *pSql) {
+  destroySqlCacheStmt(pSql->pCacheStmt);
+  pSql->pCacheStmt = NULL;
+}
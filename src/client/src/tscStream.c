@@ -46,6 +46,14 @@ static bool isProjectStream(SQueryInfo* pQueryInfo) {
   return true;
 }
 
+/*
+ * the last window computed by query starts before incrKey and ends at this key, the query range shall not go beyond it
+ * to avoid writing partial results of windows which are computed incrementally.
+ */
+static int64_t tscGetStreamIncrEndKey(SSqlStream* pStream) {
+  return pStream->incrKey - pStream->interval.sliding + pStream->interval.interval;
+}
+
 static int64_t tscGetRetryDelayTime(SSqlStream* pStream, int64_t slidingTime, int16_t prec) {
   float retryRangeFactor = 0.3f;
   int64_t retryDelta = (int64_t)(tsRetryStreamCompDelay * retryRangeFactor);
@@ -146,6 +154,12 @@ static void tscProcessStreamTimer(void *handle, void *tmrId) {
   SQueryInfo* pQueryInfo = tscGetQueryInfo(&pSql->cmd);
   tscDebug("0x%"PRIx64" add into timer", pSql->self);
 
+  if (!pStream->isProject && pStream->stime >= pStream->incrKey) {
+    tscDebug("0x%"PRIx64" stream:%p, windows from %" PRId64 " are computed incrementally, stop querying", pSql->self, pStream,
+             pStream->incrKey);
+    return;
+  }
+
   if (pStream->isProject) {
     /*
      * pQueryInfo->window.ekey, which is the start time, does not change in case of
@@ -173,6 +187,9 @@ static void tscProcessStreamTimer(void *handle, void *tmrId) {
     } else {
       etime = taosTimeTruncate(etime, &pStream->interval, pStream->precision);
     }
+    if (pStream->incrKey != INT64_MAX && etime > tscGetStreamIncrEndKey(pStream)) {
+      etime = tscGetStreamIncrEndKey(pStream);
+    }
     pQueryInfo->window.ekey = etime;
     if (pQueryInfo->window.skey >= pQueryInfo->window.ekey) {
       int64_t timer = pStream->interval.sliding;
@@ -286,9 +303,15 @@ static void tscProcessStreamRetrieveResult(void *param, TAOS_RES *res, int numOf
   STableMetaInfo *pTableMetaInfo = pQueryInfo->pTableMetaInfo[0];
 
   if (numOfRows > 0) { // when reaching here the first execution of stream computing is successful.
+    int32_t numOfIncrRows = 0;
     for(int32_t i = 0; i < numOfRows; ++i) {
       TAOS_ROW row = taos_fetch_row(res);
       if (row != NULL) {
+        if (!pStream->isProject && *(TSKEY *)row[0] >= pStream->incrKey) {
+          numOfIncrRows++;  // this window is written by the CQ
+          continue;
+        }
+
         tscDebug("0x%"PRIx64" stream:%p fetch result", pSql->self, pStream);
         tscStreamFillTimeGap(pStream, *(TSKEY*)row[0]);
         pStream->stime = *(TSKEY *)row[0];
@@ -298,7 +321,7 @@ static void tscProcessStreamRetrieveResult(void *param, TAOS_RES *res, int numOf
       }
     }
 
-    if (!pStream->isProject) {
+    if (!pStream->isProject && numOfIncrRows < numOfRows) {
       pStream->stime = taosTimeAdd(pStream->stime, pStream->interval.sliding, pStream->interval.slidingUnit, pStream->precision);
     }
     // actually only one row is returned. this following is not necessary
@@ -319,6 +342,11 @@ static void tscProcessStreamRetrieveResult(void *param, TAOS_RES *res, int numOf
       pStream->stime += 1;
     }
 
+    // all windows before the incremental part are done, hand over to the CQ
+    if (!pStream->isProject && pStream->incrKey != INT64_MAX && pQueryInfo->window.ekey >= tscGetStreamIncrEndKey(pStream)) {
+      pStream->stime = pStream->incrKey;
+    }
+
     tscDebug("0x%"PRIx64" stream:%p, query on:%s, fetch result completed, fetched rows:%" PRId64, pSql->self, pStream, tNameGetTableName(&pTableMetaInfo->name),
              pStream->numOfRes);
 
@@ -593,6 +621,11 @@ static void tscCreateStream(void *param, TAOS_RES *res, int code) {
     pStream->stime = pStream->ltime;
   }
 
+  // notify the CQ that the stream is opened, it may take over the time windows from pStream->incrKey
+  if (pStream->cqhandle != NULL && !pStream->isProject) {
+    pStream->fp(pStream->param, pSql, NULL);
+  }
+
   int64_t starttime = tscGetLaunchTimestamp(pStream);
   pCmd->command = TSDB_SQL_SELECT;
 
@@ -694,6 +727,7 @@ TAOS_STREAM *taos_open_stream_withname(TAOS *taos, const char* dstTable, const c
   }
 
   pStream->ltime = INT64_MIN;
+  pStream->incrKey = INT64_MAX;
   pStream->stime = stime;
   pStream->fp = fp;
   pStream->callback = callback;
@@ -2480,11 +2480,14 @@ int32_t tscHandleMasterSTableQuery(SSqlObj *pSql) {
   STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
   SSubqueryState *pState = &pSql->subState;
 
+  // each vgroup is queried by one subquery for each partition of its tables
+  pQueryInfo->numOfPartitions = (int16_t)tscNumOfQueryPartitions(pQueryInfo);
+
   pState->numOfSub = 0;
   if (pTableMetaInfo->pVgroupTables == NULL) {
-    pState->numOfSub = pTableMetaInfo->vgroupList->numOfVgroups;
+    pState->numOfSub = pTableMetaInfo->vgroupList->numOfVgroups * pQueryInfo->numOfPartitions;
   } else {
-    pState->numOfSub = (int32_t)taosArrayGetSize(pTableMetaInfo->pVgroupTables);
+    pState->numOfSub = (int32_t)taosArrayGetSize(pTableMetaInfo->pVgroupTables) * pQueryInfo->numOfPartitions;
   }
 
   assert(pState->numOfSub > 0);
@@ -3050,9 +3053,18 @@ static SSqlObj *tscCreateSTableSubquery(SSqlObj *pSql, SRetrieveSupport *trsuppo
 
     assert(trsupport->subqueryIndex < pSql->subState.numOfSub);
     
-    // launch subquery for each vnode, so the subquery index equals to the vgroupIndex.
+    // launch subquery for each partition of each vnode, so the subquery index is the vgroupIndex times the number of
+    // partitions plus the partition index.
+    int16_t numOfParts = tscGetQueryInfo(&pSql->cmd)->numOfPartitions;
+    if (numOfParts > 1) {
+      pQueryInfo->numOfPartitions = numOfParts;
+      pQueryInfo->partitionIndex  = (int16_t)(trsupport->subqueryIndex % numOfParts);
+    } else {
+      numOfParts = 1;
+    }
+
     STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, table_index);
-    pTableMetaInfo->vgroupIndex = trsupport->subqueryIndex;
+    pTableMetaInfo->vgroupIndex = trsupport->subqueryIndex / numOfParts;
 
     pSql->pSubs[trsupport->subqueryIndex] = pNew;
   }
@@ -3078,7 +3090,7 @@ void tscRetrieveDataRes(void *param, TAOS_RES *tres, int code) {
   assert(pQueryInfo->numOfTables == 1);
   
   STableMetaInfo *pTableMetaInfo = tscGetTableMetaInfoFromCmd(&pSql->cmd, 0);
-  SVgroupInfo* pVgroup = &pTableMetaInfo->vgroupList->vgroups[trsupport->subqueryIndex];
+  SVgroupInfo* pVgroup = &pTableMetaInfo->vgroupList->vgroups[pTableMetaInfo->vgroupIndex];
 
   // stable query killed or other subquery failed, all query stopped
   if (pParentSql->res.code != TSDB_CODE_SUCCESS) {
@@ -3491,7 +3503,7 @@ static void doBuildResFromSubqueries(SSqlObj* pSql) {
   doArithmeticCalculate(pQueryInfo, pFilePage, rowSize, finalRowSize);
 
   pRes->data = pFilePage->data;
-  tscSetResRawPtr(pRes, pQueryInfo);
+  tscSetResRawPtr(pRes, pQueryInfo, true);
 }
 
 void tscBuildResFromSubqueries(SSqlObj *pSql) {
@@ -21,6 +21,8 @@
 #include "ttimer.h"
 #include "tsched.h"
 #include "tscLog.h"
+#include "tscParseLine.h"
+#include "tscSqlCache.h"
 #include "tsclient.h"
 #include "tglobal.h"
 #include "tconfig.h"
@@ -192,6 +194,8 @@ void taos_init_imp(void) {
     tscVgroupMap     = taosHashInit(256, taosGetDefaultHashFunction(TSDB_DATA_TYPE_INT), true, HASH_ENTRY_LOCK);
     tscTableMetaMap  = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_ENTRY_LOCK);
     tscVgroupListBuf = taosCacheInit(TSDB_DATA_TYPE_BINARY, 5, false, NULL, "stable-vgroup-list");
+    tscInitSmlSchemaCache();
+    tscInitSqlCache();
     tscDebug("TableMeta:%p, vgroup:%p is initialized", tscTableMetaMap, tscVgroupMap);
   }
    
@@ -227,6 +231,9 @@ void taos_cleanup(void) {
   taosHashCleanup(tscVgroupMap);
   tscVgroupMap = NULL;
 
+  tscCleanupSmlSchemaCache();
+  tscCleanupSqlCache();
+
   int32_t id = tscObjRef;
   tscObjRef = -1;
   taosCloseRef(id);
@@ -23,6 +23,7 @@
 #include "tscGlobalmerge.h"
 #include "tscLog.h"
 #include "tscProfile.h"
+#include "tscSqlCache.h"
 #include "tscSubquery.h"
 #include "tsched.h"
 #include "qTableMeta.h"
@@ -234,6 +235,41 @@ bool tscIsTwoStageSTableQuery(SQueryInfo* pQueryInfo, int32_t tableIndex) {
   return false;
 }
 
+bool tscServerMergeQuery(SSqlObj* pSql, SQueryInfo* pQueryInfo) {
+  // the dnode merging the query runs it with the embedded client, which shall merge it by itself
+  if (!tsServerMerge || tscEmbedded) {
+    return false;
+  }
+
+  // only a plain select statement is sent to the dnode as it is, streams and subscriptions keep their own state
+  if (pSql->sqlstr == NULL || pSql->pStream != NULL || pSql->pSubscription != NULL) {
+    return false;
+  }
+
+  if (pSql->cmd.pQueryInfo != pQueryInfo || pQueryInfo->sibling != NULL || taosArrayGetSize(pQueryInfo->pUpstream) > 0 ||
+      TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_SUBQUERY | TSDB_QUERY_TYPE_NEST_SUBQUERY |
+                                                TSDB_QUERY_TYPE_JOIN_QUERY)) {
+    return false;
+  }
+
+  STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  if (pTableMetaInfo->pVgroupTables != NULL) {
+    return taosArrayGetSize(pTableMetaInfo->pVgroupTables) > 0;
+  }
+
+  return pTableMetaInfo->vgroupList != NULL && pTableMetaInfo->vgroupList->numOfVgroups > 0;
+}
+
+int32_t tscNumOfQueryPartitions(SQueryInfo* pQueryInfo) {
+  // the partial results of the partitions of a vgroup are merged the same way as the ones of different vgroups, but
+  // the timestamps of a join and the block distribution belong to the whole vgroup
+  if (tsQueryParallelism <= 1 || pQueryInfo->tsBuf != NULL || tscQueryBlockInfo(pQueryInfo)) {
+    return 1;
+  }
+
+  return tsQueryParallelism;
+}
+
 bool tscIsProjectionQueryOnSTable(SQueryInfo* pQueryInfo, int32_t tableIndex) {
   STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(pQueryInfo, tableIndex);
   
@@ -712,7 +748,7 @@ static void setResRawPtrImpl(SSqlRes* pRes, SInternalField* pInfo, int32_t i, bo
   }
 }
 
-void tscSetResRawPtr(SSqlRes* pRes, SQueryInfo* pQueryInfo) {
+void tscSetResRawPtr(SSqlRes* pRes, SQueryInfo* pQueryInfo, bool convertNchar) {
   assert(pRes->numOfCols > 0);
   if (pRes->numOfRows == 0) {
     return;
@@ -725,10 +761,29 @@ void tscSetResRawPtr(SSqlRes* pRes, SQueryInfo* pQueryInfo) {
     pRes->length[i] = pInfo->field.bytes;
 
     offset += pInfo->field.bytes;
-    setResRawPtrImpl(pRes, pInfo, i, true);
+    setResRawPtrImpl(pRes, pInfo, i, convertNchar);
   }
 }
 
+int32_t tscGetResRawBlock(SSqlObj* pSql, char* data) {
+  SSqlRes*    pRes = &pSql->res;
+  SQueryInfo* pQueryInfo = tscGetQueryInfo(&pSql->cmd);
+
+  int32_t len = 0;
+  for (int32_t i = 0; i < pQueryInfo->fieldsInfo.numOfOutput; ++i) {
+    SInternalField* pInfo = (SInternalField*)TARRAY_GET_ELEM(pQueryInfo->fieldsInfo.internalField, i);
+
+    int32_t size = pInfo->field.bytes * pRes->numOfRows;
+    if (data != NULL && size > 0) {
+      memcpy(data + len, pRes->urow[i], size);
+    }
+
+    len += size;
+  }
+
+  return len;
+}
+
 void tscSetResRawPtrRv(SSqlRes* pRes, SQueryInfo* pQueryInfo, SSDataBlock* pBlock, bool convertNchar) {
   assert(pRes->numOfCols > 0);
 
@@ -1551,6 +1606,7 @@ void tscFreeSqlObj(SSqlObj* pSql) {
 
   tscFreeSqlResult(pSql);
   tscResetSqlCmd(pCmd, false, pSql->self);
+  tscSqlCacheFreeStmt(pSql);
 
   tfree(pCmd->payload);
   pCmd->allocSize = 0;
@@ -1868,7 +1924,19 @@ static int trimDataBlock(void* pDataBlock, STableDataBlocks* pTableDataBlock, SI
   pBlock->dataLen = 0;
   int32_t numOfRows = htons(pBlock->numOfRows);
 
-  if (IS_RAW_PAYLOAD(insertParam->payloadType)) {
+  if (pTableDataBlock->memRowPayload) {
+    if (blkKeyTuple == NULL) {  // the rows are in order, copy them at once
+      pBlock->dataLen = pTableDataBlock->size - sizeof(SSubmitBlk);
+      memcpy(pDataBlock, p, pBlock->dataLen);
+    } else {
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        TDRowTLenT rowTLen = memRowTLen((blkKeyTuple + i)->payloadAddr);
+        memcpy(pDataBlock, (blkKeyTuple + i)->payloadAddr, rowTLen);
+        pDataBlock = POINTER_SHIFT(pDataBlock, rowTLen);
+        pBlock->dataLen += rowTLen;
+      }
+    }
+  } else if (IS_RAW_PAYLOAD(insertParam->payloadType)) {
     for (int32_t i = 0; i < numOfRows; ++i) {
       SMemRow memRow = (SMemRow)pDataBlock;
       memRowSetType(memRow, SMEM_ROW_DATA);
@@ -1995,7 +2063,22 @@ int32_t tscMergeTableDataBlocks(SInsertStatementParam *pInsertParam, bool freeBl
         }
       }
 
-      if (isRawPayload) {
+      SBlockKeyTuple* pKeyTuple = NULL;
+      if (pOneTableBlock->memRowPayload) {
+        bool ordered = pOneTableBlock->ordered;
+        if ((code = tscSortRemoveDataBlockDupMemRows(pOneTableBlock, &blkKeyInfo)) != 0) {
+          taosHashCleanup(pVnodeDataBlockHashList);
+          tscDestroyBlockArrayList(pVnodeDataBlockList);
+          tfree(dataBuf->pData);
+          tfree(blkKeyInfo.pKeyTuple);
+          return code;
+        }
+
+        pKeyTuple = ordered ? NULL : blkKeyInfo.pKeyTuple;
+        tscDebug("0x%" PRIx64 " name:%s, tid:%d rows:%d sversion:%d mem rows, ordered:%d", pInsertParam->objectId,
+                 tNameGetTableName(&pOneTableBlock->tableName), pBlocks->tid, pBlocks->numOfRows, pBlocks->sversion,
+                 ordered);
+      } else if (isRawPayload) {
         tscSortRemoveDataBlockDupRowsRaw(pOneTableBlock);
         char* ekey = (char*)pBlocks->data + pOneTableBlock->rowSize * (pBlocks->numOfRows - 1);
 
@@ -2011,6 +2094,7 @@ int32_t tscMergeTableDataBlocks(SInsertStatementParam *pInsertParam, bool freeBl
           return code;
         }
         ASSERT(blkKeyInfo.pKeyTuple != NULL && pBlocks->numOfRows > 0);
+        pKeyTuple = blkKeyInfo.pKeyTuple;
 
         SBlockKeyTuple* pLastKeyTuple = blkKeyInfo.pKeyTuple + pBlocks->numOfRows - 1;
         tscDebug("0x%" PRIx64 " name:%s, tid:%d rows:%d sversion:%d skey:%" PRId64 ", ekey:%" PRId64,
@@ -2029,7 +2113,7 @@ int32_t tscMergeTableDataBlocks(SInsertStatementParam *pInsertParam, bool freeBl
       pBlocks->schemaLen = 0;
 
       // erase the empty space reserved for binary data
-      int32_t finalLen = trimDataBlock(dataBuf->pData + dataBuf->size, pOneTableBlock, pInsertParam, blkKeyInfo.pKeyTuple);
+      int32_t finalLen = trimDataBlock(dataBuf->pData + dataBuf->size, pOneTableBlock, pInsertParam, pKeyTuple);
       assert(finalLen <= len);
 
       dataBuf->size += (finalLen + sizeof(SSubmitBlk));
@@ -2040,6 +2124,7 @@ int32_t tscMergeTableDataBlocks(SInsertStatementParam *pInsertParam, bool freeBl
       dataBuf->numOfTables += 1;
 
       pBlocks->numOfRows = 0;
+      pOneTableBlock->memRowPayload = false;
     }else {
       tscDebug("0x%"PRIx64" table %s data block is empty", pInsertParam->objectId, pOneTableBlock->tableName.tname);
     }
@@ -3823,6 +3908,9 @@ void doExecuteQuery(SSqlObj* pSql, SQueryInfo* pQueryInfo) {
     tscHandleMasterJoinQuery(pSql);
   } else if (tscMultiRoundQuery(pQueryInfo, 0) && pQueryInfo->round == 0) {
     tscHandleFirstRoundStableQuery(pSql);                // todo lock?
+  } else if (tscIsTwoStageSTableQuery(pQueryInfo, 0) && tscServerMergeQuery(pSql, pQueryInfo)) {
+    pQueryInfo->serverMerge = true;
+    tscBuildAndSendRequest(pSql, pQueryInfo);
   } else if (tscIsTwoStageSTableQuery(pQueryInfo, 0)) {  // super table query
     tscLockByThread(&pSql->squeryLock);
     tscHandleMasterSTableQuery(pSql);
@@ -4430,6 +4518,32 @@ SVgroupsInfo* tscVgroupInfoClone(SVgroupsInfo *vgroupList) {
   return pNew;
 }
 
+SVgroupsInfo* tscVgroupInfoFromIdList(const int32_t* vgIdList, int32_t numOfVgroups) {
+  SVgroupsInfo* pNew = calloc(1, sizeof(SVgroupsInfo) + sizeof(SVgroupInfo) * numOfVgroups);
+  if (pNew == NULL) {
+    return NULL;
+  }
+
+  pNew->numOfVgroups = numOfVgroups;
+  for(int32_t i = 0; i < numOfVgroups; ++i) {
+    // check if current buffer contains the vgroup info. If not, add it
+    SNewVgroupInfo existVgroupInfo = {.inUse = -1,};
+    taosHashGetClone(tscVgroupMap, &vgIdList[i], sizeof(int32_t), NULL, &existVgroupInfo);
+
+    assert(existVgroupInfo.inUse >= 0);
+    SVgroupInfo *pVgroup = &pNew->vgroups[i];
+
+    pVgroup->numOfEps = existVgroupInfo.numOfEps;
+    pVgroup->vgId = existVgroupInfo.vgId;
+    for (int32_t k = 0; k < existVgroupInfo.numOfEps; ++k) {
+      pVgroup->epAddr[k].port = existVgroupInfo.ep[k].port;
+      pVgroup->epAddr[k].fqdn = strndup(existVgroupInfo.ep[k].fqdn, TSDB_FQDN_LEN);
+    }
+  }
+
+  return pNew;
+}
+
 void* tscVgroupInfoClear(SVgroupsInfo *vgroupList) {
   if (vgroupList == NULL) {
     return NULL;
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taos.h"
+#include "taoserror.h"
+#include "tglobal.h"
+
+#include "tscParseLine.h"
+
+/*
+ * Lines per second of the schemaless line parser on Telegraf like payloads, by number of parse threads. With -i the
+ * lines are also written by taos_insert_lines to the database smlbench of the server, the schemas of the super tables
+ * are cached after the first batch.
+ */
+
+typedef struct {
+  const char *name;
+  const char *format;  // host, tag, 4 values and the timestamp in ms
+} SBenchMeasurement;
+
+static SBenchMeasurement measurements[] = {
+    {"cpu",
+     "cpu,host=\"host%d\",cpu=\"cpu%d\",region=\"us-west-2\",datacenter=\"us-west-2a\",rack=\"rack17\",os=\"Ubuntu16.10\" "
+     "usage_user=%d.25f64,usage_system=%d.5f64,usage_idle=%d.125f64,usage_nice=0f64,usage_iowait=%d.75f64,"
+     "usage_irq=0.5f64,usage_softirq=0.25f64,usage_steal=0f64,usage_guest=0f64,usage_guest_nice=0f64 %" PRId64 "ms"},
+    {"mem",
+     "mem,host=\"host%d\",region=\"us-west-2\",datacenter=\"us-west-2a\",rack=\"rack%d\" "
+     "total=8589934592i64,available=%di64,used=%di64,free=%di64,cached=%di64,buffered=0i64,used_percent=42.5f64,"
+     "available_percent=57.5f64 %" PRId64 "ms"},
+    {"disk",
+     "disk,host=\"host%d\",path=\"/dev/sda%d\",fstype=\"ext4\",mode=\"rw\" total=512000000000i64,free=%di64,used=%di64,"
+     "used_percent=%d.5f64,inodes_total=32000000i64,inodes_free=%di64,device=\"sda1\",readonly=false %" PRId64 "ms"},
+};
+
+static char **genLines(int32_t numLines, int32_t numHosts) {
+  char **lines = calloc(numLines, POINTER_BYTES);
+  char   buf[1024];
+
+  for (int32_t i = 0; i < numLines; ++i) {
+    SBenchMeasurement *pMeasure = measurements + i % tListLen(measurements);
+    int32_t            host = (i / tListLen(measurements)) % numHosts;
+    int64_t            ts = 1626006833000LL + i / (tListLen(measurements) * numHosts);
+    int32_t            v = rand() % 100000;
+
+    snprintf(buf, sizeof(buf), pMeasure->format, host, i % 8, v, v / 3, v / 5, v / 7, ts);
+    lines[i] = strdup(buf);
+  }
+  return lines;
+}
+
+static void freeLines(char **lines, int32_t numLines) {
+  for (int32_t i = 0; i < numLines; ++i) {
+    free(lines[i]);
+  }
+  free(lines);
+}
+
+static int64_t parseLines(char **lines, int32_t numLines, int32_t batch, int32_t threads) {
+  int64_t st = taosGetTimestampUs();
+
+  for (int32_t start = 0; start < numLines; start += batch) {
+    int32_t       n = MIN(batch, numLines - start);
+    SArray *      points = taosArrayInit(n, sizeof(TAOS_SML_DATA_POINT));
+    SSmlLinesInfo info = {0};
+    info.id = genLinesSmlId();
+    info.numOfParseThreads = threads;
+    info.arena = tscNewSmlArena();
+
+    int32_t code = tscParseLines(lines + start, n, points, NULL, &info);
+    if (code != 0 || taosArrayGetSize(points) != n) {
+      printf("failed to parse lines, code:%s\n", tstrerror(code));
+      exit(1);
+    }
+
+    taosArrayDestroy(points);
+    tscFreeSmlArena(info.arena);
+  }
+
+  return taosGetTimestampUs() - st;
+}
+
+static int64_t insertLines(TAOS *taos, char **lines, int32_t numLines, int32_t batch) {
+  int64_t st = taosGetTimestampUs();
+
+  for (int32_t start = 0; start < numLines; start += batch) {
+    int32_t code = taos_insert_lines(taos, lines + start, MIN(batch, numLines - start));
+    if (code != 0) {
+      printf("failed to insert lines, code:%s\n", tstrerror(code));
+      exit(1);
+    }
+  }
+
+  return taosGetTimestampUs() - st;
+}
+
+static double kLinesPerSec(int64_t lines, int64_t us) { return us > 0 ? (double)lines * 1000 / us : 0; }
+
+int main(int argc, char *argv[]) {
+  int32_t     numLines = 262144;
+  int32_t     numHosts = 100;
+  int32_t     maxThreads = 8;
+  bool        insert = false;
+  const char *host = "127.0.0.1";
+  const char *cfgDir = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numLines = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i < argc - 1) {
+      numHosts = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      maxThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-h") == 0 && i < argc - 1) {
+      host = argv[++i];
+    } else if (strcmp(argv[i], "-c") == 0 && i < argc - 1) {
+      cfgDir = argv[++i];
+    } else if (strcmp(argv[i], "-i") == 0) {
+      insert = true;
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-n]: number of lines, default: %d\n", numLines);
+      printf("  [-m]: number of hosts, default: %d\n", numHosts);
+      printf("  [-t]: max number of parse threads, default: %d\n", maxThreads);
+      printf("  [-i]: insert the lines into the database smlbench\n");
+      printf("  [-h]: host of the server, default: %s\n", host);
+      printf("  [-c]: config directory\n");
+      exit(0);
+    }
+  }
+
+  if (cfgDir != NULL) {
+    taos_options(TSDB_OPTION_CONFIGDIR, cfgDir);
+  }
+  taos_init();  // the parse tasks run on the client workers
+
+  srand(7);
+  char **lines = genLines(numLines, numHosts);
+  size_t bytes = 0;
+  for (int32_t i = 0; i < numLines; ++i) bytes += strlen(lines[i]);
+
+  printf("lines:%d avg bytes per line:%.1f, throughput in thousand lines/s\n", numLines, (double)bytes / numLines);
+  printf("%-8s", "batch");
+  for (int32_t t = 1; t <= maxThreads; t *= 2) printf(" %8d-thr", t);
+  printf("\n");
+
+  int32_t batches[] = {1000, 5000, 20000, 65536};
+  for (int32_t b = 0; b < tListLen(batches); ++b) {
+    printf("%-8d", batches[b]);
+    for (int32_t t = 1; t <= maxThreads; t *= 2) {
+      int64_t us = parseLines(lines, numLines, batches[b], t);
+      printf(" %12.1f", kLinesPerSec(numLines, us));
+    }
+    printf("\n");
+  }
+
+  if (insert) {
+    TAOS *taos = taos_connect(host, "root", "taosdata", NULL, 0);
+    if (taos == NULL) {
+      printf("failed to connect to %s\n", host);
+      exit(1);
+    }
+
+    TAOS_RES *res = taos_query(taos, "create database if not exists smlbench precision 'ms'");
+    taos_free_result(res);
+    taos_select_db(taos, "smlbench");
+
+    // the first pass creates the super tables and child tables, the second one writes to them
+    for (int32_t pass = 0; pass < 2; ++pass) {
+      int64_t us = insertLines(taos, lines, numLines, 20000);
+      printf("insert pass %d, batch 20000, %d parse threads: %.1f thousand lines/s\n", pass, tsNumOfSmlParseThreads,
+             kLinesPerSec(numLines, us));
+    }
+
+    taos_close(taos);
+  }
+
+  freeLines(lines, numLines);
+  taos_cleanup();
+  return 0;
+}
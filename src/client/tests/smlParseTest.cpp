@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "os.h"
+#include "taos.h"
+#include "taoserror.h"
+
+#include "tscParseLine.h"
+
+namespace {
+
+std::vector<std::string> genLines(int32_t n) {
+  std::vector<std::string> lines;
+  char                     buf[512];
+  for (int32_t i = 0; i < n; ++i) {
+    snprintf(buf, sizeof(buf),
+             "st%d,t\\=%d=\"tag%d\",ID=\"ct%d\" c\\,0=%di32,c1=\"ab%d\",c2=%d.5f64,c3=%s %" PRId64 "ns", i % 3,
+             i % 2, i, i % 10, i, i, i, (i % 2) ? "true" : "F", (int64_t)1626006833000000000 + i);
+    lines.push_back(buf);
+  }
+  return lines;
+}
+
+std::string dumpKv(TAOS_SML_KV* kv) {
+  std::string s = std::string(kv->key) + ":" + std::to_string(kv->type) + ":";
+  switch (kv->type) {
+    case TSDB_DATA_TYPE_BOOL:
+      s += std::to_string(*(int8_t*)kv->value);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      s += std::to_string(*(int32_t*)kv->value);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      s += std::to_string(*(double*)kv->value);
+      break;
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      s += std::to_string(*(int64_t*)kv->value);
+      break;
+    default:
+      s.append(kv->value, kv->length);
+  }
+  return s;
+}
+
+std::string dumpPoint(TAOS_SML_DATA_POINT* point) {
+  std::string s = std::string(point->stableName) + "/" + (point->childTableName ? point->childTableName : "");
+  for (int32_t i = 0; i < point->tagNum; ++i) s += " " + dumpKv(point->tags + i);
+  for (int32_t i = 0; i < point->fieldNum; ++i) s += " " + dumpKv(point->fields + i);
+  return s;
+}
+
+int32_t parseLines(std::vector<std::string>& lines, int32_t threads, std::vector<std::string>* dumps) {
+  std::vector<char*> pLines;
+  for (auto& line : lines) pLines.push_back(&line[0]);
+
+  SArray*       points = (SArray*)taosArrayInit(lines.size(), sizeof(TAOS_SML_DATA_POINT));
+  SSmlLinesInfo info = {0};
+  info.id = genLinesSmlId();
+  info.numOfParseThreads = threads;
+  info.arena = tscNewSmlArena();
+
+  int32_t code = tscParseLines(pLines.data(), (int)pLines.size(), points, NULL, &info);
+  for (size_t i = 0; code == 0 && i < taosArrayGetSize(points); ++i) {
+    dumps->push_back(dumpPoint((TAOS_SML_DATA_POINT*)taosArrayGet(points, i)));
+  }
+
+  taosArrayDestroy(points);
+  tscFreeSmlArena(info.arena);
+  return code;
+}
+
+}  // namespace
+
+// the points parsed by several threads are the ones parsed by the caller alone, in the order of the lines
+TEST(testCase, sml_parse_lines_test) {
+  taos_init();
+
+  std::vector<std::string> lines = genLines(10000);
+  std::vector<std::string> serial, parallel;
+
+  ASSERT_EQ(parseLines(lines, 1, &serial), 0);
+  ASSERT_EQ(parseLines(lines, 4, &parallel), 0);
+  ASSERT_EQ(serial.size(), lines.size());
+  EXPECT_EQ(serial, parallel);
+
+  EXPECT_EQ(serial[7], "st1/ct7 t=1:8:tag7 _ts:9:1626006833000000007 c,0:4:7 c1:8:ab7 c2:7:7.500000 c3:1:1");
+
+  lines[7777] = "st0,t=\"x\" c0=bad 0";
+  std::vector<std::string> failed;
+  EXPECT_EQ(parseLines(lines, 1, &failed), TSDB_CODE_TSC_LINE_SYNTAX_ERROR);
+  EXPECT_EQ(parseLines(lines, 4, &failed), TSDB_CODE_TSC_LINE_SYNTAX_ERROR);
+  EXPECT_TRUE(failed.empty());
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taos.h"
+#include "taoserror.h"
+#include "tscSqlCache.h"
+
+/*
+ * Client CPU and wall clock microseconds per select statement on the database sqlcachebench of the server. The
+ * "moving window" sql only changes the time range, like a dashboard that refreshes, and is bound to the query info
+ * cached by the first one. The "other filter" sql changes a literal of its column filter as well, which keeps all the
+ * rows, and is parsed and validated each time.
+ */
+
+static void checkCode(TAOS_RES *res, const char *sql) {
+  if (taos_errno(res) != 0) {
+    printf("failed to run %s, reason:%s\n", sql, taos_errstr(res));
+    exit(1);
+  }
+}
+
+static void execSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  checkCode(res, sql);
+  taos_free_result(res);
+}
+
+static int64_t cpuTimeUs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+         usage.ru_stime.tv_usec;
+}
+
+static int64_t runQueries(TAOS *taos, const char *table, int32_t numOfQueries, bool otherFilter, int64_t ts0,
+                          int64_t *cpuUs) {
+  char    sql[512];
+  int64_t rows = 0;
+  int64_t st = taosGetTimestampUs();
+  *cpuUs = cpuTimeUs();
+
+  for (int32_t i = 0; i < numOfQueries; ++i) {
+    int64_t skey = ts0 + (i % 100) * 1000;
+    snprintf(sql, sizeof(sql),
+             "select count(*), avg(c1), max(c2), last(c3) from %s where ts >= %" PRId64 " and ts < %" PRId64
+             " and c1 > -%d interval(10s) fill(null)",
+             table, skey, skey + 60000, otherFilter ? i + 1 : 1);
+
+    TAOS_RES *res = taos_query(taos, sql);
+    checkCode(res, sql);
+    while (taos_fetch_row(res) != NULL) {
+      rows += 1;
+    }
+    taos_free_result(res);
+  }
+
+  *cpuUs = cpuTimeUs() - *cpuUs;
+  int64_t us = taosGetTimestampUs() - st;
+  return rows > 0 ? us : -1;
+}
+
+int main(int argc, char *argv[]) {
+  int32_t     numOfTables = 10;
+  int32_t     numOfQueries = 10000;
+  const char *host = "127.0.0.1";
+  const char *cfgDir = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      numOfTables = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numOfQueries = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-h") == 0 && i < argc - 1) {
+      host = argv[++i];
+    } else if (strcmp(argv[i], "-c") == 0 && i < argc - 1) {
+      cfgDir = argv[++i];
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-t]: number of child tables, default: %d\n", numOfTables);
+      printf("  [-n]: number of queries of each case, default: %d\n", numOfQueries);
+      printf("  [-h]: host of the server, default: %s\n", host);
+      printf("  [-c]: config directory\n");
+      exit(0);
+    }
+  }
+
+  if (cfgDir != NULL) {
+    taos_options(TSDB_OPTION_CONFIGDIR, cfgDir);
+  }
+
+  TAOS *taos = taos_connect(host, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to %s\n", host);
+    exit(1);
+  }
+
+  int64_t ts0 = 1626006833000LL;
+  execSql(taos, "drop database if exists sqlcachebench");
+  execSql(taos, "create database sqlcachebench precision 'ms' keep 36500");
+  taos_select_db(taos, "sqlcachebench");
+  execSql(taos, "create table st (ts timestamp, c1 int, c2 double, c3 binary(16)) tags(t1 int)");
+
+  for (int32_t t = 0; t < numOfTables; ++t) {
+    char sql[256];
+    snprintf(sql, sizeof(sql), "create table ct%d using st tags(%d)", t, t);
+    execSql(taos, sql);
+
+    // a row per second for 3 minutes
+    for (int32_t i = 0; i < 180; i += 60) {
+      char values[8192];
+      int32_t len = snprintf(values, sizeof(values), "insert into ct%d values", t);
+      for (int32_t j = i; j < i + 60; ++j) {
+        len += snprintf(values + len, sizeof(values) - len, " (%" PRId64 ", %d, %f, 'v%d')", ts0 + j * 1000, j,
+                        j * 0.5, j);
+      }
+      execSql(taos, values);
+    }
+  }
+
+  printf("tables:%d queries:%d, microseconds per query\n", numOfTables, numOfQueries);
+  printf("%-22s %12s %12s %10s %10s\n", "", "client cpu", "wall", "hits", "misses");
+
+  const char *tables[] = {"ct0", "st"};
+  for (int32_t t = 0; t < tListLen(tables); ++t) {
+    for (int32_t f = 0; f < 2; ++f) {
+      int64_t hits = tscSqlCacheHits, misses = tscSqlCacheMisses;
+      int64_t cpuUs = 0;
+      int64_t us = runQueries(taos, tables[t], numOfQueries, f == 1, ts0, &cpuUs);
+      if (us < 0) {
+        printf("no rows are returned from %s\n", tables[t]);
+        exit(1);
+      }
+
+      char name[64];
+      snprintf(name, sizeof(name), "%s %s", tables[t], f == 0 ? "moving window" : "other filter");
+      printf("%-22s %12.1f %12.1f %10" PRId64 " %10" PRId64 "\n", name, (double)cpuUs / numOfQueries,
+             (double)us / numOfQueries, tscSqlCacheHits - hits, tscSqlCacheMisses - misses);
+    }
+  }
+
+  taos_close(taos);
+  taos_cleanup();
+  return 0;
+}
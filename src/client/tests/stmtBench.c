@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taos.h"
+#include "taoserror.h"
+
+/*
+ * Rows per second written by prepared statements into the database stmtbench of the server, with columnar batches
+ * bound at once by taos_stmt_bind_param_batch, built into SMemRow directly, against the same batches bound column by
+ * column by taos_stmt_bind_single_param_batch, which goes through the raw rows. With -u the timestamps of every batch
+ * are shuffled so the rows are sorted before they are sent.
+ */
+
+#define BENCH_NUM_OF_COLS 8
+#define BENCH_BINARY_LEN  16
+#define BENCH_NCHAR_LEN   8
+
+typedef struct {
+  int64_t *ts;
+  int32_t *c1;
+  int64_t *c2;
+  double * c3;
+  float *  c4;
+  char *   c5;
+  char *   c6;
+  int8_t * c7;
+  char *   isNull;
+  int32_t *len5;
+  int32_t *len6;
+
+  TAOS_MULTI_BIND bind[BENCH_NUM_OF_COLS];
+} SBenchBatch;
+
+static void setBind(TAOS_MULTI_BIND *b, int type, void *buffer, uintptr_t bufLen, int32_t *length, char *isNull,
+                    int num) {
+  b->buffer_type = type;
+  b->buffer = buffer;
+  b->buffer_length = bufLen;
+  b->length = length;
+  b->is_null = isNull;
+  b->num = num;
+}
+
+static void initBatch(SBenchBatch *pBatch, int32_t rows) {
+  pBatch->ts = calloc(rows, sizeof(int64_t));
+  pBatch->c1 = calloc(rows, sizeof(int32_t));
+  pBatch->c2 = calloc(rows, sizeof(int64_t));
+  pBatch->c3 = calloc(rows, sizeof(double));
+  pBatch->c4 = calloc(rows, sizeof(float));
+  pBatch->c5 = calloc(rows, BENCH_BINARY_LEN);
+  pBatch->c6 = calloc(rows, BENCH_NCHAR_LEN);
+  pBatch->c7 = calloc(rows, sizeof(int8_t));
+  pBatch->isNull = calloc(rows, sizeof(char));
+  pBatch->len5 = calloc(rows, sizeof(int32_t));
+  pBatch->len6 = calloc(rows, sizeof(int32_t));
+
+  TAOS_MULTI_BIND *b = pBatch->bind;
+  setBind(b + 0, TSDB_DATA_TYPE_TIMESTAMP, pBatch->ts, sizeof(int64_t), NULL, NULL, rows);
+  setBind(b + 1, TSDB_DATA_TYPE_INT, pBatch->c1, sizeof(int32_t), NULL, pBatch->isNull, rows);
+  setBind(b + 2, TSDB_DATA_TYPE_BIGINT, pBatch->c2, sizeof(int64_t), NULL, NULL, rows);
+  setBind(b + 3, TSDB_DATA_TYPE_DOUBLE, pBatch->c3, sizeof(double), NULL, NULL, rows);
+  setBind(b + 4, TSDB_DATA_TYPE_FLOAT, pBatch->c4, sizeof(float), NULL, NULL, rows);
+  setBind(b + 5, TSDB_DATA_TYPE_BINARY, pBatch->c5, BENCH_BINARY_LEN, pBatch->len5, NULL, rows);
+  setBind(b + 6, TSDB_DATA_TYPE_NCHAR, pBatch->c6, BENCH_NCHAR_LEN, pBatch->len6, NULL, rows);
+  setBind(b + 7, TSDB_DATA_TYPE_BOOL, pBatch->c7, sizeof(int8_t), NULL, NULL, rows);
+}
+
+static void freeBatch(SBenchBatch *pBatch) {
+  free(pBatch->ts);
+  free(pBatch->c1);
+  free(pBatch->c2);
+  free(pBatch->c3);
+  free(pBatch->c4);
+  free(pBatch->c5);
+  free(pBatch->c6);
+  free(pBatch->c7);
+  free(pBatch->isNull);
+  free(pBatch->len5);
+  free(pBatch->len6);
+}
+
+static void fillBatch(SBenchBatch *pBatch, int32_t rows, int64_t startTs, bool shuffle) {
+  for (int32_t i = 0; i < rows; ++i) {
+    int64_t v = startTs + i;
+    pBatch->ts[i] = v;
+    pBatch->c1[i] = (int32_t)(v % 100000);
+    pBatch->c2[i] = v;
+    pBatch->c3[i] = v * 0.5;
+    pBatch->c4[i] = (float)(i % 1000) * 0.25f;
+    pBatch->c7[i] = (int8_t)(i & 1);
+    pBatch->isNull[i] = (i % 17 == 0);
+    pBatch->len5[i] = snprintf(pBatch->c5 + i * BENCH_BINARY_LEN, BENCH_BINARY_LEN, "b%d", i % 100000);
+    pBatch->len6[i] = snprintf(pBatch->c6 + i * BENCH_NCHAR_LEN, BENCH_NCHAR_LEN, "n%d", i % 1000);
+  }
+
+  // the same batches are shuffled in the same way for both ways of binding
+  uint32_t seed = (uint32_t)startTs;
+  for (int32_t i = rows - 1; shuffle && i > 0; --i) {
+    seed = seed * 1103515245 + 12345;
+    int32_t j = (int32_t)((seed >> 8) % (uint32_t)(i + 1));
+    int64_t t = pBatch->ts[i];
+    pBatch->ts[i] = pBatch->ts[j];
+    pBatch->ts[j] = t;
+  }
+}
+
+static void checkCode(int32_t code, TAOS_STMT *stmt, const char *msg) {
+  if (code != 0) {
+    printf("failed to %s, code:%s, reason:%s\n", msg, tstrerror(code), stmt ? taos_stmt_errstr(stmt) : "");
+    exit(1);
+  }
+}
+
+static void execSql(TAOS *taos, const char *sql) {
+  TAOS_RES *res = taos_query(taos, sql);
+  checkCode(taos_errno(res), NULL, sql);
+  taos_free_result(res);
+}
+
+static int64_t insertRows(TAOS *taos, const char *stable, int32_t numOfTables, int32_t rowsPerTable, int32_t batch,
+                          bool columnar, bool shuffle, int64_t *bindUs) {
+  char sql[256];
+  snprintf(sql, sizeof(sql), "insert into ? using %s tags(?) values(?,?,?,?,?,?,?,?)", stable);
+
+  SBenchBatch b = {0};
+  initBatch(&b, batch);
+
+  TAOS_STMT *stmt = taos_stmt_init(taos);
+  checkCode(taos_stmt_prepare(stmt, sql, 0), stmt, "prepare");
+
+  int64_t used = 0;
+  *bindUs = 0;
+  for (int32_t start = 0; start < rowsPerTable; start += batch) {
+    int32_t rows = MIN(batch, rowsPerTable - start);
+    for (int32_t c = 0; c < BENCH_NUM_OF_COLS; ++c) b.bind[c].num = rows;
+
+    // the batch is generated outside of the timing, a collector gets it from the network
+    fillBatch(&b, rows, 1626006833000LL + start, shuffle);
+
+    for (int32_t t = 0; t < numOfTables; ++t) {
+      int64_t st = taosGetTimestampUs();
+
+      char tbname[32];
+      int32_t tag = t;
+      snprintf(tbname, sizeof(tbname), "%s_%d", stable, t);
+      TAOS_BIND tags = {.buffer_type = TSDB_DATA_TYPE_INT, .buffer = &tag, .buffer_length = sizeof(tag)};
+      checkCode(taos_stmt_set_tbname_tags(stmt, tbname, &tags), stmt, "set table name");
+
+      if (columnar) {
+        checkCode(taos_stmt_bind_param_batch(stmt, b.bind), stmt, "bind batch");
+      } else {
+        for (int32_t c = 0; c < BENCH_NUM_OF_COLS; ++c) {
+          checkCode(taos_stmt_bind_single_param_batch(stmt, b.bind + c, c), stmt, "bind column");
+        }
+      }
+
+      checkCode(taos_stmt_add_batch(stmt), stmt, "add batch");
+      *bindUs += taosGetTimestampUs() - st;
+    }
+
+    int64_t st = taosGetTimestampUs();
+    checkCode(taos_stmt_execute(stmt), stmt, "execute");
+    used += taosGetTimestampUs() - st;
+  }
+
+  used += *bindUs;
+
+  taos_stmt_close(stmt);
+  freeBatch(&b);
+  return used;
+}
+
+static void checkRows(TAOS *taos, const char *stable, int64_t rows) {
+  char sql[256];
+  snprintf(sql, sizeof(sql), "select count(*), count(c1), sum(c2), last(c5) from %s", stable);
+
+  TAOS_RES *res = taos_query(taos, sql);
+  checkCode(taos_errno(res), NULL, sql);
+  TAOS_ROW  row = taos_fetch_row(res);
+  int32_t *lengths = taos_fetch_lengths(res);
+  if (row == NULL || *(int64_t *)row[0] != rows) {
+    printf("%s: expect %" PRId64 " rows, actual %" PRId64 "\n", stable, rows, row ? *(int64_t *)row[0] : 0);
+    exit(1);
+  }
+
+  printf("  %s rows:%" PRId64 " non null c1:%" PRId64 " sum(c2):%" PRId64 " last(c5):%.*s\n", stable,
+         *(int64_t *)row[0], *(int64_t *)row[1], *(int64_t *)row[2], lengths[3], (char *)row[3]);
+  taos_free_result(res);
+}
+
+static int64_t cpuTimeUs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+         usage.ru_stime.tv_usec;
+}
+
+static double kRowsPerSec(int64_t rows, int64_t us) { return us > 0 ? (double)rows * 1000 / us : 0; }
+
+int main(int argc, char *argv[]) {
+  int32_t     numOfTables = 10;
+  int32_t     rowsPerTable = 100000;
+  int32_t     batch = 10000;
+  bool        shuffle = false;
+  const char *host = "127.0.0.1";
+  const char *cfgDir = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      numOfTables = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      rowsPerTable = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-b") == 0 && i < argc - 1) {
+      batch = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-h") == 0 && i < argc - 1) {
+      host = argv[++i];
+    } else if (strcmp(argv[i], "-c") == 0 && i < argc - 1) {
+      cfgDir = argv[++i];
+    } else if (strcmp(argv[i], "-u") == 0) {
+      shuffle = true;
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-t]: number of tables, default: %d\n", numOfTables);
+      printf("  [-n]: number of rows per table, default: %d\n", rowsPerTable);
+      printf("  [-b]: rows per table of each batch, default: %d\n", batch);
+      printf("  [-u]: shuffle the timestamps of each batch\n");
+      printf("  [-h]: host of the server, default: %s\n", host);
+      printf("  [-c]: config directory\n");
+      exit(0);
+    }
+  }
+
+  if (batch > INT16_MAX) {
+    batch = INT16_MAX;
+  }
+
+  if (cfgDir != NULL) {
+    taos_options(TSDB_OPTION_CONFIGDIR, cfgDir);
+  }
+
+  TAOS *taos = taos_connect(host, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    printf("failed to connect to %s\n", host);
+    exit(1);
+  }
+
+  execSql(taos, "drop database if exists stmtbench");
+  execSql(taos, "create database stmtbench precision 'ms' keep 36500");
+  taos_select_db(taos, "stmtbench");
+
+  const char *stables[] = {"st_columnar", "st_by_column"};
+  for (int32_t s = 0; s < tListLen(stables); ++s) {
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+             "create table %s (ts timestamp, c1 int, c2 bigint, c3 double, c4 float, c5 binary(%d), c6 nchar(%d), "
+             "c7 bool) tags(t1 int)",
+             stables[s], BENCH_BINARY_LEN, BENCH_NCHAR_LEN);
+    execSql(taos, sql);
+  }
+
+  int64_t totalRows = (int64_t)numOfTables * rowsPerTable;
+  printf("tables:%d rows per table:%d batch:%d%s, throughput in thousand rows/s\n", numOfTables, rowsPerTable, batch,
+         shuffle ? " shuffled" : "");
+  printf("%-14s %10s %10s %10s\n", "", "bind", "client cpu", "total");
+
+  for (int32_t s = 0; s < tListLen(stables); ++s) {
+    int64_t bindUs = 0;
+    int64_t cpuUs = cpuTimeUs();
+    int64_t us = insertRows(taos, stables[s], numOfTables, rowsPerTable, batch, s == 0, shuffle, &bindUs);
+    cpuUs = cpuTimeUs() - cpuUs;
+    printf("%-14s %10.1f %10.1f %10.1f\n", s == 0 ? "bind batch" : "bind columns", kRowsPerSec(totalRows, bindUs),
+           kRowsPerSec(totalRows, cpuUs), kRowsPerSec(totalRows, us));
+  }
+
+  for (int32_t s = 0; s < tListLen(stables); ++s) {
+    checkRows(taos, stables[s], totalRows);
+  }
+
+  taos_close(taos);
+  taos_cleanup();
+  return 0;
+}
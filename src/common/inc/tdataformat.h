@@ -320,6 +320,32 @@ static FORCE_INLINE void tdCopyColOfRowBySchema(SDataRow dst, STSchema *pDstSche
 }
 
 
+// ----------------- Validity bitmap of a column
+/*
+ * Bit i is set when row i is not NULL. The bitmap is kept along with the NULL values written in the column data, so
+ * code that checks the NULL value row by row still works, while scans can skip the NULL rows word by word.
+ */
+#define TD_BITMAP_BYTES(nEle) ((((nEle) + 63) >> 6) << 3)
+
+static FORCE_INLINE bool tdBitmapIsSet(const uint8_t *pBitmap, int idx) { return (pBitmap[idx >> 3] >> (idx & 7)) & 1; }
+
+static FORCE_INLINE void tdBitmapSetTo(uint8_t *pBitmap, int idx, bool valid) {
+  if (valid) {
+    pBitmap[idx >> 3] |= (uint8_t)(1u << (idx & 7));
+  } else {
+    pBitmap[idx >> 3] &= (uint8_t)(~(1u << (idx & 7)));
+  }
+}
+
+void tdBitmapSetRange(uint8_t *pBitmap, int start, int nEle, bool valid);
+// dst may overlap src only when it starts before it
+void tdBitmapCopy(uint8_t *dst, int dstStart, const uint8_t *src, int srcStart, int nEle);
+int  tdBitmapCount(const uint8_t *pBitmap, int start, int nEle);
+// position of the first bit equal to valid in [start, end), or end
+int  tdBitmapFind(const uint8_t *pBitmap, int start, int end, bool valid);
+// build the bitmap from the NULL values of the data, return the number of NULL values
+int  tdBitmapFromData(uint8_t *pBitmap, const void *pData, VarDataOffsetT *dataOff, int8_t type, int nEle);
+
 // ----------------- Data column structure
 typedef struct SDataCol {
   int8_t          type;       // column type
@@ -330,6 +356,7 @@ typedef struct SDataCol {
   int             len;        // column data length
   VarDataOffsetT *dataOff;    // For binary and nchar data, the offset in the data column
   void *          pData;      // Actual data pointer
+  uint8_t *       pBitmap;    // validity bitmap in the space of pData, valid when len > 0
   TSKEY           ts;         // only used in last NULL column
 } SDataCol;
 
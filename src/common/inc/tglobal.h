@@ -47,12 +47,20 @@ extern int64_t  tsDnodeStartTime;
 extern int      tsRpcTimer;
 extern int      tsRpcMaxTime;
 extern int      tsRpcForceTcp; // all commands go to tcp protocol if this is enabled
+extern int32_t  tsRpcMaxEvents;
+extern int32_t  tsRpcRecvBufSize;
 extern int32_t  tsMaxConnections;
 extern int32_t  tsMaxShellConns;
 extern int32_t  tsShellActivityTimer;
 extern uint32_t tsMaxTmrCtrl;
 extern float    tsNumOfThreadsPerCore;
 extern int32_t  tsNumOfCommitThreads;
+extern int32_t  tsNumOfCommitFSetThreads;
+extern int32_t  tsNumOfReadAheadThreads;
+extern int32_t  tsReadAheadDepth;
+extern int8_t   tsBlockIdxCache;
+extern int32_t  tsBlockIdxCacheSize;
+extern int8_t   tsBlockFilter;
 extern float    tsRatioOfQueryCores;
 extern int8_t   tsDaylight;
 extern char     tsTimezone[];
@@ -70,11 +78,17 @@ extern int64_t  tsQueryBufferSizeBytes; // maximum allowed usage buffer size in
 extern int32_t  tsRetrieveBlockingModel;// retrieve threads will be blocked
 
 extern int8_t   tsKeepOriginalColumnName;
+extern int8_t   tsServerMerge;
+extern int32_t  tsMaxMergeConns;
+extern int32_t  tsQueryParallelism;
+extern int32_t  tsSortBufferSize;
 
 // client
 extern int32_t tsMaxSQLStringLen;
 extern int32_t tsMaxWildCardsLen;
 extern int32_t tsMaxRegexStringLen;
+extern int32_t tsNumOfSmlParseThreads;
+extern int32_t tsSqlCacheSize;
 extern int8_t  tsTscEnableRecordSql;
 extern int32_t tsMaxNumOfOrderedResults;
 extern int32_t tsMinSlidingTime;
@@ -83,12 +97,14 @@ extern int32_t tsMaxStreamComputDelay;
 extern int32_t tsStreamCompStartDelay;
 extern int32_t tsRetryStreamCompDelay;
 extern float   tsStreamComputDelayRatio;  // the delayed computing ration of the whole time window
+extern int8_t  tsIncrementalStream;
 extern int32_t tsProjectExecInterval;
 extern int64_t tsMaxRetentWindow;
 
 // db parameters in client
 extern int32_t tsCacheBlockSize;
 extern int32_t tsBlocksPerVnode;
+extern int32_t tsMemPoolBudget;
 extern int32_t tsMinTablePerVnode;
 extern int32_t tsMaxTablePerVnode;
 extern int32_t tsTableIncStepPerVnode;
@@ -102,6 +118,8 @@ extern int32_t tsTimePrecision;
 extern int8_t  tsCompression;
 extern int8_t  tsWAL;
 extern int32_t tsFsyncPeriod;
+extern int8_t  tsWalGroupCommit;
+extern int32_t tsSyncWalChunkSize;
 extern int32_t tsReplications;
 extern int16_t tsPartitons;
 extern int32_t tsQuorum;
@@ -34,6 +34,7 @@ typedef struct SDataStatis {
 typedef struct SColumnInfoData {
   SColumnInfo info;
   char* pData;    // the corresponding block data in memory
+  uint8_t* pBitmap;  // validity bitmap of the rows in pData, NULL if the block only has the NULL values in pData
 } SColumnInfoData;
 
 typedef struct SResPair {
@@ -28,6 +28,7 @@ int tdAllocMemForCol(SDataCol *pCol, int maxPoints) {
   if(IS_VAR_DATA_TYPE(pCol->type)) {
     spaceNeeded += sizeof(VarDataOffsetT) * maxPoints;
   }
+  spaceNeeded += TD_BITMAP_BYTES(maxPoints);
   if(pCol->spaceSize < spaceNeeded) {
     void* ptr = realloc(pCol->pData, spaceNeeded);
     if(ptr == NULL) {
@@ -41,6 +42,9 @@ int tdAllocMemForCol(SDataCol *pCol, int maxPoints) {
   }
   if(IS_VAR_DATA_TYPE(pCol->type)) {
     pCol->dataOff = POINTER_SHIFT(pCol->pData, pCol->bytes * maxPoints);
+    pCol->pBitmap = POINTER_SHIFT(pCol->dataOff, sizeof(VarDataOffsetT) * maxPoints);
+  } else {
+    pCol->pBitmap = POINTER_SHIFT(pCol->pData, pCol->bytes * maxPoints);
   }
   return 0;
 }
@@ -256,6 +260,8 @@ int dataColAppendVal(SDataCol *pCol, const void *value, int numOfRows, int maxPo
     }
   }
 
+  tdBitmapSetTo(pCol->pBitmap, numOfRows, !isNull(value, pCol->type));
+
   if (IS_VAR_DATA_TYPE(pCol->type)) {
     // set offset
     pCol->dataOff[numOfRows] = pCol->len;
@@ -288,6 +294,7 @@ bool isNEleNull(SDataCol *pCol, int nEle) {
 }
 
 static FORCE_INLINE void dataColSetNullAt(SDataCol *pCol, int index) {
+  tdBitmapSetTo(pCol->pBitmap, index, false);
   if (IS_VAR_DATA_TYPE(pCol->type)) {
     pCol->dataOff[index] = pCol->len;
     char *ptr = POINTER_SHIFT(pCol->pData, pCol->len);
@@ -300,6 +307,8 @@ static FORCE_INLINE void dataColSetNullAt(SDataCol *pCol, int index) {
 }
 
 static void dataColSetNEleNull(SDataCol *pCol, int nEle) {
+  tdBitmapSetRange(pCol->pBitmap, 0, nEle, false);
+
   if (IS_VAR_DATA_TYPE(pCol->type)) {
     pCol->len = 0;
     for (int i = 0; i < nEle; i++) {
@@ -311,6 +320,129 @@ static void dataColSetNEleNull(SDataCol *pCol, int nEle) {
   }
 }
 
+void tdBitmapSetRange(uint8_t *pBitmap, int start, int nEle, bool valid) {
+  int end = start + nEle;
+  int i = start;
+
+  for (; i < end && (i & 7) != 0; ++i) {
+    tdBitmapSetTo(pBitmap, i, valid);
+  }
+
+  if (end - i >= 8) {
+    memset(pBitmap + (i >> 3), valid ? 0xFF : 0, (end - i) >> 3);
+    i += (end - i) & ~7;
+  }
+
+  for (; i < end; ++i) {
+    tdBitmapSetTo(pBitmap, i, valid);
+  }
+}
+
+void tdBitmapCopy(uint8_t *dst, int dstStart, const uint8_t *src, int srcStart, int nEle) {
+  int i = 0;
+
+  if ((dstStart & 7) == 0 && (srcStart & 7) == 0) {
+    memmove(dst + (dstStart >> 3), src + (srcStart >> 3), nEle >> 3);
+    i = nEle & ~7;
+  }
+
+  for (; i < nEle; ++i) {
+    tdBitmapSetTo(dst, dstStart + i, tdBitmapIsSet(src, srcStart + i));
+  }
+}
+
+static FORCE_INLINE int tdPopCount64(uint64_t v) {
+  v = v - ((v >> 1) & 0x5555555555555555ULL);
+  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (int)((v * 0x0101010101010101ULL) >> 56);
+}
+
+int tdBitmapCount(const uint8_t *pBitmap, int start, int nEle) {
+  int end = start + nEle;
+  int i = start;
+  int n = 0;
+
+  for (; i < end && (i & 7) != 0; ++i) {
+    n += tdBitmapIsSet(pBitmap, i);
+  }
+
+  for (; i + 64 <= end; i += 64) {
+    uint64_t w;
+    memcpy(&w, pBitmap + (i >> 3), sizeof(w));
+    n += tdPopCount64(w);
+  }
+
+  for (; i < end; ++i) {
+    n += tdBitmapIsSet(pBitmap, i);
+  }
+
+  return n;
+}
+
+int tdBitmapFind(const uint8_t *pBitmap, int start, int end, bool valid) {
+  uint64_t none = valid ? 0 : UINT64_MAX;  // a word without any bit of the value
+  int      i = start;
+
+  for (; i < end && (i & 7) != 0; ++i) {
+    if (tdBitmapIsSet(pBitmap, i) == valid) return i;
+  }
+
+  for (; i + 64 <= end; i += 64) {
+    uint64_t w;
+    memcpy(&w, pBitmap + (i >> 3), sizeof(w));
+    if (w != none) break;
+  }
+
+  for (; i < end; ++i) {
+    if (tdBitmapIsSet(pBitmap, i) == valid) return i;
+  }
+
+  return end;
+}
+
+#define BITMAP_FROM_DATA(T, nullv)                    \
+  do {                                                \
+    const T *d = (const T *)pData;                    \
+    for (int i = 0; i < nEle; i += 8) {               \
+      int     m = (nEle - i < 8) ? (nEle - i) : 8;    \
+      uint8_t b = 0;                                  \
+      for (int j = 0; j < m; ++j) {                   \
+        b |= (uint8_t)((d[i + j] != (T)(nullv)) << j); \
+      }                                               \
+      pBitmap[i >> 3] = b;                            \
+      numOfNull += m - tdPopCount64(b);               \
+    }                                                 \
+  } while (0)
+
+int tdBitmapFromData(uint8_t *pBitmap, const void *pData, VarDataOffsetT *dataOff, int8_t type, int nEle) {
+  int numOfNull = 0;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL: BITMAP_FROM_DATA(uint8_t, TSDB_DATA_BOOL_NULL); break;
+    case TSDB_DATA_TYPE_TINYINT: BITMAP_FROM_DATA(uint8_t, TSDB_DATA_TINYINT_NULL); break;
+    case TSDB_DATA_TYPE_UTINYINT: BITMAP_FROM_DATA(uint8_t, TSDB_DATA_UTINYINT_NULL); break;
+    case TSDB_DATA_TYPE_SMALLINT: BITMAP_FROM_DATA(uint16_t, TSDB_DATA_SMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_USMALLINT: BITMAP_FROM_DATA(uint16_t, TSDB_DATA_USMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_INT: BITMAP_FROM_DATA(uint32_t, TSDB_DATA_INT_NULL); break;
+    case TSDB_DATA_TYPE_UINT: BITMAP_FROM_DATA(uint32_t, TSDB_DATA_UINT_NULL); break;
+    case TSDB_DATA_TYPE_FLOAT: BITMAP_FROM_DATA(uint32_t, TSDB_DATA_FLOAT_NULL); break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: BITMAP_FROM_DATA(uint64_t, TSDB_DATA_BIGINT_NULL); break;
+    case TSDB_DATA_TYPE_UBIGINT: BITMAP_FROM_DATA(uint64_t, TSDB_DATA_UBIGINT_NULL); break;
+    case TSDB_DATA_TYPE_DOUBLE: BITMAP_FROM_DATA(uint64_t, TSDB_DATA_DOUBLE_NULL); break;
+    default:
+      for (int i = 0; i < nEle; ++i) {
+        bool valid = !isNull(POINTER_SHIFT(pData, dataOff[i]), type);
+        tdBitmapSetTo(pBitmap, i, valid);
+        numOfNull += !valid;
+      }
+      break;
+  }
+
+  return numOfNull;
+}
+
 void dataColSetOffset(SDataCol *pCol, int nEle) {
   ASSERT(((pCol->type == TSDB_DATA_TYPE_BINARY) || (pCol->type == TSDB_DATA_TYPE_NCHAR)));
 
@@ -425,6 +557,7 @@ SDataCols *tdDupDataCols(SDataCols *pDataCols, bool keepData) {
           int dataOffSize = sizeof(VarDataOffsetT) * pDataCols->maxPoints;
           memcpy(pRet->cols[i].dataOff, pDataCols->cols[i].dataOff, dataOffSize);
         }
+        memcpy(pRet->cols[i].pBitmap, pDataCols->cols[i].pBitmap, TD_BITMAP_BYTES(pDataCols->numOfRows));
       }
     }
   }
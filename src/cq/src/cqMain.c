@@ -26,8 +26,11 @@
 #include "taosmsg.h"
 #include "ttimer.h"
 #include "tcq.h"
+#include "qAggMain.h"
+#include "tscUtil.h"
 #include "tdataformat.h"
 #include "tglobal.h"
+#include "hash.h"
 #include "tlog.h"
 #include "twal.h"
 
@@ -52,10 +55,15 @@ typedef struct SCqObj {
   struct SCqObj *prev;
   struct SCqObj *next;
   SCqContext *   pContext;
+  struct SCqInc *pInc;         // partial aggregates if the CQ is computed incrementally
+  int8_t         incDisabled;  // the rows can not be folded incrementally, always query
 } SCqObj;
 
 static void cqProcessStreamRes(void *param, TAOS_RES *tres, TAOS_ROW row); 
 static void cqCreateStream(SCqContext *pContext, SCqObj *pObj);
+static void cqWriteRow(SCqObj *pObj, void **row, int32_t *lengths);
+static void cqStartIncremental(SCqObj *pObj, SSqlStream *pStream);
+static void cqStopIncremental(SCqObj *pObj);
 
 int32_t    cqObjRef = -1;
 int32_t    cqVnodeNum = 0;
@@ -83,6 +91,8 @@ static void freeSCqContext(void *handle) {
   }
   SCqContext *pContext = handle;
   pthread_mutex_destroy(&pContext->mutex);
+  pthread_mutex_destroy(&pContext->incMutex);
+  taosHashCleanup(pContext->pIncTables);
 
   taosTmrCleanUp(pContext->tmrCtrl);
   pContext->tmrCtrl = NULL;
@@ -110,6 +120,8 @@ void cqFree(void *handle) {
     pObj->tmrId = 0;
   }
 
+  cqStopIncremental(pObj);
+
   cInfo("vgId:%d, id:%d CQ:%s is dropped", pContext->vgId, pObj->tid, pObj->sqlStr); 
   tdFreeSchema(pObj->pSchema);
   free(pObj->dstTable);
@@ -173,6 +185,8 @@ void *cqOpen(void *ahandle, const SCqCfg *pCfg) {
   tscEmbedded = 1;
 
   pthread_mutex_init(&pContext->mutex, NULL);
+  pthread_mutex_init(&pContext->incMutex, NULL);
+  pContext->pIncTables = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_UBIGINT), true, HASH_NO_LOCK);
 
 
   cDebug("vgId:%d, CQ is opened", pContext->vgId);
@@ -461,6 +475,7 @@ static void cqProcessStreamRes(void *param, TAOS_RES *tres, TAOS_ROW row) {
     taos_close_stream(pObj->pStream);
 
     pObj->pStream = NULL;
+    cqStopIncremental(pObj);
 
     taosReleaseRef(cqObjRef, (int64_t)param);
 
@@ -468,14 +483,29 @@ static void cqProcessStreamRes(void *param, TAOS_RES *tres, TAOS_ROW row) {
   }
 
   SCqContext *pContext = pObj->pContext;
-  STSchema   *pSchema = pObj->pSchema;
   if (pObj->pStream == NULL) {    
     taosReleaseRef(cqObjRef, (int64_t)param);
     return;
   }
+
+  // the stream is opened, see if the windows can be computed incrementally
+  if (row == NULL) {
+    cqStartIncremental(pObj, pObj->pStream);
+    taosReleaseRef(cqObjRef, (int64_t)param);
+    return;
+  }
   
   cDebug("vgId:%d, id:%d CQ:%s stream result is ready", pContext->vgId, pObj->tid, pObj->sqlStr);
 
+  cqWriteRow(pObj, row, taos_fetch_lengths(tres));
+  
+  taosReleaseRef(cqObjRef, (int64_t)param);
+}
+
+static void cqWriteRow(SCqObj *pObj, void **row, int32_t *lengths) {
+  SCqContext *pContext = pObj->pContext;
+  STSchema   *pSchema = pObj->pSchema;
+
   int32_t size = sizeof(SWalHead) + sizeof(SSubmitMsg) + sizeof(SSubmitBlk) + TD_MEM_ROW_DATA_HEAD_SIZE + pObj->rowSize;
   char *buffer = calloc(size, 1);
 
@@ -497,7 +527,7 @@ static void cqProcessStreamRes(void *param, TAOS_RES *tres, TAOS_ROW row) {
       val = ((char*)val) - sizeof(VarDataLenT);
     } else if (c->type == TSDB_DATA_TYPE_NCHAR) {
       char buf[TSDB_MAX_NCHAR_LEN];
-      int32_t len = taos_fetch_lengths(tres)[i];
+      int32_t len = lengths[i];
       taosMbsToUcs4(val, len, buf, sizeof(buf), &len);
       memcpy((char *)val + sizeof(VarDataLenT), buf, len);
       varDataLen(val) = len;
@@ -526,7 +556,659 @@ static void cqProcessStreamRes(void *param, TAOS_RES *tres, TAOS_ROW row) {
   // write into vnode write queue
   pContext->cqWrite(pContext->vgId, pHead, TAOS_QTYPE_CQ, NULL);
   free(buffer);
-  
+}
+
+/*
+ * Incremental CQ
+ *
+ * If a CQ aggregates a table in the same vnode with decomposable functions only, the rows inserted into the table are
+ * folded into the partial aggregates of the time windows they fall in, and each closed window is written into the
+ * stream table directly. The stream keeps querying the windows before startKey, and it is reopened to query all the
+ * windows again once the rows can not be folded anymore, e.g. the schema of the table is changed.
+ */
+#define CQ_INC_MAX_WINDOWS 4096
+
+#define CQ_SET_INC_VAL(_dst, _type, _v)                                    \
+  do {                                                                     \
+    if ((_type) == TSDB_DATA_TYPE_TIMESTAMP) {                             \
+      *(int64_t *)(_dst) = (int64_t)(_v);                                  \
+    } else {                                                               \
+      SET_TYPED_DATA(_dst, _type, _v);                                     \
+    }                                                                      \
+  } while (0)
+
+typedef union {
+  int64_t  i;
+  uint64_t u;
+  double   d;
+} SCqIncVal;
+
+typedef struct {
+  int16_t functionId;
+  int16_t colIndex;
+  int16_t colId;
+  int8_t  type;     // type of the column in source table
+  int8_t  dstType;  // type of the column in stream table
+  int32_t offset;   // offset of the column in a data row, including the head
+} SCqIncExpr;
+
+typedef struct {
+  int64_t   count;  // number of non-null values
+  SCqIncVal sum;
+  SCqIncVal min;
+  SCqIncVal max;
+  SCqIncVal first;
+  SCqIncVal last;
+  TSKEY     firstKey;
+  TSKEY     lastKey;
+} SCqIncAgg;
+
+typedef struct {
+  TSKEY     skey;
+  int64_t   numOfRows;
+  SCqIncAgg agg[];
+} SCqIncWindow;
+
+typedef struct SCqInc {
+  SCqContext *pContext;
+  int64_t     rid;        // rid of the SCqObj
+  uint64_t    uid;        // uid of the source table
+  int16_t     sversion;   // schema version of the source table
+  int16_t     precision;
+  bool        failed;
+  SInterval   interval;
+  TSKEY       startKey;   // the first window computed incrementally
+  TSKEY       nextKey;    // windows before it are closed
+  tmr_h       tmrId;
+  SArray *    pWindows;   // SArray<SCqIncWindow*>, ordered by skey
+  int32_t     numOfExprs;
+  SCqIncExpr  expr[];
+} SCqInc;
+
+typedef struct {
+  SCqContext *pContext;
+  SArray *    pIncs;  // SArray<SCqInc*> computed from the same table
+} SCqIncTable;
+
+static void cqProcessIncTimer(void *param, void *tmrId);
+
+static bool cqIsIncFunction(int16_t functionId) {
+  switch (functionId) {
+    case TSDB_FUNC_COUNT:
+    case TSDB_FUNC_SUM:
+    case TSDB_FUNC_AVG:
+    case TSDB_FUNC_MIN:
+    case TSDB_FUNC_MAX:
+    case TSDB_FUNC_FIRST:
+    case TSDB_FUNC_LAST:
+    case TSDB_FUNC_SPREAD:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static SCqIncVal cqGetIncVal(const void *data, int8_t type) {
+  SCqIncVal v = {0};
+  if (IS_FLOAT_TYPE(type)) {
+    GET_TYPED_DATA(v.d, double, type, data);
+  } else if (IS_UNSIGNED_NUMERIC_TYPE(type)) {
+    GET_TYPED_DATA(v.u, uint64_t, type, data);
+  } else {
+    GET_TYPED_DATA(v.i, int64_t, type, data);
+  }
+  return v;
+}
+
+static double cqIncValToDouble(SCqIncVal v, int8_t type) {
+  if (IS_FLOAT_TYPE(type)) return v.d;
+  if (IS_UNSIGNED_NUMERIC_TYPE(type)) return (double)v.u;
+  return (double)v.i;
+}
+
+static void cqSetIncVal(void *dst, int8_t dstType, SCqIncVal v, int8_t type) {
+  if (IS_FLOAT_TYPE(type)) {
+    CQ_SET_INC_VAL(dst, dstType, v.d);
+  } else if (IS_UNSIGNED_NUMERIC_TYPE(type)) {
+    CQ_SET_INC_VAL(dst, dstType, v.u);
+  } else {
+    CQ_SET_INC_VAL(dst, dstType, v.i);
+  }
+}
+
+static void cqFoldIncVal(SCqIncAgg *pAgg, SCqIncVal v, int8_t type, TSKEY key) {
+  if (pAgg->count++ == 0) {
+    pAgg->sum = pAgg->min = pAgg->max = pAgg->first = pAgg->last = v;
+    pAgg->firstKey = pAgg->lastKey = key;
+    return;
+  }
+
+  if (IS_FLOAT_TYPE(type)) {
+    pAgg->sum.d += v.d;
+    if (v.d < pAgg->min.d) pAgg->min = v;
+    if (v.d > pAgg->max.d) pAgg->max = v;
+  } else if (IS_UNSIGNED_NUMERIC_TYPE(type)) {
+    pAgg->sum.u += v.u;
+    if (v.u < pAgg->min.u) pAgg->min = v;
+    if (v.u > pAgg->max.u) pAgg->max = v;
+  } else {
+    pAgg->sum.i += v.i;
+    if (v.i < pAgg->min.i) pAgg->min = v;
+    if (v.i > pAgg->max.i) pAgg->max = v;
+  }
+
+  if (key < pAgg->firstKey) {
+    pAgg->first = v;
+    pAgg->firstKey = key;
+  }
+
+  if (key > pAgg->lastKey) {
+    pAgg->last = v;
+    pAgg->lastKey = key;
+  }
+}
+
+static SCqInc *cqBuildIncremental(SCqObj *pObj, SSqlStream *pStream) {
+  SCqContext *pContext = pObj->pContext;
+  SSqlObj *   pSql = pStream->pSql;
+  if (pSql == NULL) return NULL;
+
+  SQueryInfo *pQueryInfo = tscGetQueryInfo(&pSql->cmd);
+  if (pQueryInfo == NULL || pQueryInfo->numOfTables != 1) return NULL;
+
+  STableMeta *pTableMeta = tscGetMetaInfo(pQueryInfo, 0)->pTableMeta;
+  if (pTableMeta == NULL || pTableMeta->vgId != pContext->vgId ||
+      (pTableMeta->tableType != TSDB_NORMAL_TABLE && pTableMeta->tableType != TSDB_CHILD_TABLE)) {
+    return NULL;
+  }
+
+  SInterval *pInterval = &pQueryInfo->interval;
+  if (pInterval->intervalUnit == 'n' || pInterval->intervalUnit == 'y' || pInterval->interval <= 0 ||
+      pInterval->sliding <= 0 || pInterval->offset != 0) {
+    return NULL;
+  }
+
+  if (pQueryInfo->groupbyExpr.numOfGroupCols > 0 || pQueryInfo->fillType != TSDB_FILL_NONE ||
+      pQueryInfo->limit.limit != -1 || pQueryInfo->limit.offset > 0 || pQueryInfo->havingFieldNum > 0 ||
+      pQueryInfo->sessionWindow.gap > 0 || pQueryInfo->stateWindow || pQueryInfo->arithmeticOnAgg ||
+      pQueryInfo->order.order != TSDB_ORDER_ASC || tscHasColumnFilter(pQueryInfo) ||
+      (pQueryInfo->colCond != NULL && taosArrayGetSize(pQueryInfo->colCond) > 0) ||
+      (pQueryInfo->exprList1 != NULL && taosArrayGetSize(pQueryInfo->exprList1) > 0) ||
+      (pQueryInfo->pUdfInfo != NULL && taosArrayGetSize(pQueryInfo->pUdfInfo) > 0)) {
+    return NULL;
+  }
+
+  STSchema *pDstSchema = pObj->pSchema;
+  int32_t   numOfExprs = (int32_t)tscNumOfExprs(pQueryInfo);
+  int32_t   numOfCols = tscGetNumOfColumns(pTableMeta);
+  if (numOfExprs != pQueryInfo->fieldsInfo.numOfOutput || numOfExprs != schemaNCols(pDstSchema)) {
+    return NULL;
+  }
+
+  // the offsets of columns in a data row are derived from the schema of source table
+  STSchemaBuilder schemaBuilder = {0};
+  if (tdInitTSchemaBuilder(&schemaBuilder, pTableMeta->sversion) < 0) return NULL;
+
+  SSchema *pSchema = tscGetTableSchema(pTableMeta);
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    tdAddColToSchema(&schemaBuilder, pSchema[i].type, pSchema[i].colId, pSchema[i].bytes);
+  }
+
+  STSchema *pSrcSchema = tdGetSchemaFromBuilder(&schemaBuilder);
+  tdDestroyTSchemaBuilder(&schemaBuilder);
+  if (pSrcSchema == NULL) return NULL;
+
+  SCqInc *pInc = calloc(1, sizeof(SCqInc) + sizeof(SCqIncExpr) * numOfExprs);
+  if (pInc == NULL) {
+    tdFreeSchema(pSrcSchema);
+    return NULL;
+  }
+
+  for (int32_t i = 0; i < numOfExprs; ++i) {
+    SExprInfo * pExpr = tscExprGet(pQueryInfo, i);
+    SCqIncExpr *pIncExpr = &pInc->expr[i];
+    int16_t     functionId = pExpr->base.functionId;
+    int16_t     colIndex = pExpr->base.colInfo.colIndex;
+
+    pIncExpr->functionId = functionId;
+    pIncExpr->dstType = schemaColAt(pDstSchema, i)->type;
+    if ((i == 0) != (functionId == TSDB_FUNC_TS) || IS_VAR_DATA_TYPE(pIncExpr->dstType)) {
+      goto _fail;
+    }
+
+    if (functionId == TSDB_FUNC_TS) {
+      continue;
+    }
+
+    if (!cqIsIncFunction(functionId) || !TSDB_COL_IS_NORMAL_COL(pExpr->base.colInfo.flag) || colIndex < 0 ||
+        colIndex >= numOfCols) {
+      goto _fail;
+    }
+
+    STColumn *pCol = schemaColAt(pSrcSchema, colIndex);
+    if (functionId != TSDB_FUNC_COUNT && IS_VAR_DATA_TYPE(pCol->type)) {
+      goto _fail;
+    }
+
+    pIncExpr->colIndex = colIndex;
+    pIncExpr->colId = pCol->colId;
+    pIncExpr->type = pCol->type;
+    pIncExpr->offset = pCol->offset + TD_DATA_ROW_HEAD_SIZE;
+  }
+
+  tdFreeSchema(pSrcSchema);
+
+  pInc->pContext = pContext;
+  pInc->rid = pObj->rid;
+  pInc->uid = pTableMeta->id.uid;
+  pInc->sversion = pTableMeta->sversion;
+  pInc->precision = pStream->precision;
+  pInc->interval = *pInterval;
+  pInc->numOfExprs = numOfExprs;
+  pInc->pWindows = taosArrayInit(4, POINTER_BYTES);
+
+  /*
+   * rows are folded from now on, the windows starting after now plus the max computing delay only contain rows
+   * inserted from now on, even if the clocks of the clients are a little ahead.
+   */
+  int64_t now = taosGetTimestamp(pInc->precision) +
+                convertTimePrecision(tsMaxStreamComputDelay, TSDB_TIME_PRECISION_MILLI, pInc->precision);
+  TSKEY skey = taosTimeTruncate(now, &pInc->interval, pInc->precision);
+  while (skey <= now) {
+    skey += pInc->interval.sliding;
+  }
+
+  pInc->startKey = skey;
+  pInc->nextKey = skey;
+  return pInc;
+
+_fail:
+  tdFreeSchema(pSrcSchema);
+  free(pInc);
+  return NULL;
+}
+
+static void cqFreeIncWindow(void *p) {
+  SCqIncWindow *pWin = *(SCqIncWindow **)p;
+  free(pWin);
+}
+
+static void cqFreeIncremental(SCqInc *pInc) {
+  taosArrayDestroyEx(pInc->pWindows, cqFreeIncWindow);
+  free(pInc);
+}
+
+static void cqSetIncTimer(SCqInc *pInc) {
+  // the next window is closed after the max computing delay, the same as the stream
+  int64_t delay = convertTimePrecision(tsMaxStreamComputDelay, TSDB_TIME_PRECISION_MILLI, pInc->precision);
+  int64_t timer = pInc->nextKey + pInc->interval.interval + delay - taosGetTimestamp(pInc->precision);
+
+  timer = convertTimePrecision(timer, pInc->precision, TSDB_TIME_PRECISION_MILLI);
+  if (timer < 10) {
+    timer = 10;
+  } else if (timer > 3600 * 1000) {
+    timer = 3600 * 1000;
+  }
+
+  taosTmrReset(cqProcessIncTimer, (int32_t)timer, (void *)pInc->rid, pInc->pContext->tmrCtrl, &pInc->tmrId);
+}
+
+// incMutex shall be locked in caller
+static void cqSetIncFailed(SCqInc *pInc) {
+  if (pInc->failed) return;
+
+  pInc->failed = true;
+  cWarn("vgId:%d, CQ rid:%" PRId64 " can not be computed incrementally anymore, fall back to query",
+        pInc->pContext->vgId, pInc->rid);
+
+  taosTmrReset(cqProcessIncTimer, 10, (void *)pInc->rid, pInc->pContext->tmrCtrl, &pInc->tmrId);
+}
+
+static void cqStartIncremental(SCqObj *pObj, SSqlStream *pStream) {
+  SCqContext *pContext = pObj->pContext;
+  if (!tsIncrementalStream || pObj->incDisabled) return;
+
+  pthread_mutex_lock(&pContext->incMutex);
+
+  // the stream is reopened since query failed, the partial aggregates are still valid
+  if (pObj->pInc != NULL) {
+    pStream->incrKey = pObj->pInc->startKey;
+    pthread_mutex_unlock(&pContext->incMutex);
+    return;
+  }
+
+  SCqInc *pInc = cqBuildIncremental(pObj, pStream);
+  if (pInc == NULL) {
+    pthread_mutex_unlock(&pContext->incMutex);
+    cDebug("vgId:%d, id:%d CQ:%s is computed by query", pContext->vgId, pObj->tid, pObj->sqlStr);
+    return;
+  }
+
+  SCqIncTable * pTable = NULL;
+  SCqIncTable **ppTable = taosHashGet(pContext->pIncTables, &pInc->uid, sizeof(pInc->uid));
+  if (ppTable == NULL) {
+    pTable = calloc(1, sizeof(SCqIncTable));
+    pTable->pContext = pContext;
+    pTable->pIncs = taosArrayInit(4, POINTER_BYTES);
+    taosHashPut(pContext->pIncTables, &pInc->uid, sizeof(pInc->uid), &pTable, POINTER_BYTES);
+  } else {
+    pTable = *ppTable;
+  }
+
+  taosArrayPush(pTable->pIncs, &pInc);
+  pObj->pInc = pInc;
+  atomic_add_fetch_32(&pContext->incNum, 1);
+
+  pStream->incrKey = pInc->startKey;
+  cqSetIncTimer(pInc);
+
+  pthread_mutex_unlock(&pContext->incMutex);
+
+  cInfo("vgId:%d, id:%d CQ:%s is computed incrementally from %" PRId64, pContext->vgId, pObj->tid, pObj->sqlStr,
+        pInc->startKey);
+}
+
+static void cqStopIncremental(SCqObj *pObj) {
+  SCqContext *pContext = pObj->pContext;
+  if (pContext == NULL) return;
+
+  pthread_mutex_lock(&pContext->incMutex);
+
+  SCqInc *pInc = pObj->pInc;
+  if (pInc == NULL) {
+    pthread_mutex_unlock(&pContext->incMutex);
+    return;
+  }
+
+  pObj->pInc = NULL;
+
+  SCqIncTable **ppTable = taosHashGet(pContext->pIncTables, &pInc->uid, sizeof(pInc->uid));
+  if (ppTable != NULL) {
+    SCqIncTable *pTable = *ppTable;
+    size_t       num = taosArrayGetSize(pTable->pIncs);
+    for (int32_t i = 0; i < num; ++i) {
+      if (taosArrayGetP(pTable->pIncs, i) == pInc) {
+        taosArrayRemove(pTable->pIncs, i);
+        break;
+      }
+    }
+
+    if (taosArrayGetSize(pTable->pIncs) == 0) {
+      taosHashRemove(pContext->pIncTables, &pInc->uid, sizeof(pInc->uid));
+      taosArrayDestroy(pTable->pIncs);
+      free(pTable);
+    }
+  }
+
+  atomic_sub_fetch_32(&pContext->incNum, 1);
+  taosTmrStop(pInc->tmrId);
+  pInc->tmrId = NULL;
+
+  pthread_mutex_unlock(&pContext->incMutex);
+
+  cqFreeIncremental(pInc);
+}
+
+static void cqWriteIncWindow(SCqObj *pObj, SCqInc *pInc, SCqIncWindow *pWin) {
+  int32_t numOfExprs = pInc->numOfExprs;
+  void ** row = calloc(numOfExprs, POINTER_BYTES + sizeof(int64_t));
+  if (row == NULL) return;
+
+  char *buf = (char *)(row + numOfExprs);
+  for (int32_t i = 0; i < numOfExprs; ++i) {
+    SCqIncExpr *pExpr = &pInc->expr[i];
+    SCqIncAgg * pAgg = &pWin->agg[i];
+    char *      val = buf + i * sizeof(int64_t);
+
+    if (pExpr->functionId == TSDB_FUNC_TS) {
+      *(TSKEY *)val = pWin->skey;
+      row[i] = val;
+      continue;
+    }
+
+    if (pExpr->functionId == TSDB_FUNC_COUNT) {
+      SCqIncVal v = {.i = pAgg->count};
+      cqSetIncVal(val, pExpr->dstType, v, TSDB_DATA_TYPE_BIGINT);
+      row[i] = val;
+      continue;
+    }
+
+    if (pAgg->count == 0) {  // all values are NULL
+      continue;
+    }
+
+    SCqIncVal v = {0};
+    switch (pExpr->functionId) {
+      case TSDB_FUNC_SUM:    cqSetIncVal(val, pExpr->dstType, pAgg->sum, pExpr->type); break;
+      case TSDB_FUNC_MIN:    cqSetIncVal(val, pExpr->dstType, pAgg->min, pExpr->type); break;
+      case TSDB_FUNC_MAX:    cqSetIncVal(val, pExpr->dstType, pAgg->max, pExpr->type); break;
+      case TSDB_FUNC_FIRST:  cqSetIncVal(val, pExpr->dstType, pAgg->first, pExpr->type); break;
+      case TSDB_FUNC_LAST:   cqSetIncVal(val, pExpr->dstType, pAgg->last, pExpr->type); break;
+      case TSDB_FUNC_AVG:
+        v.d = cqIncValToDouble(pAgg->sum, pExpr->type) / pAgg->count;
+        cqSetIncVal(val, pExpr->dstType, v, TSDB_DATA_TYPE_DOUBLE);
+        break;
+      case TSDB_FUNC_SPREAD:
+        v.d = cqIncValToDouble(pAgg->max, pExpr->type) - cqIncValToDouble(pAgg->min, pExpr->type);
+        cqSetIncVal(val, pExpr->dstType, v, TSDB_DATA_TYPE_DOUBLE);
+        break;
+      default:
+        break;
+    }
+
+    row[i] = val;
+  }
+
+  cqWriteRow(pObj, row, NULL);
+  free(row);
+}
+
+static void cqFallbackToQuery(SCqObj *pObj) {
+  SCqContext *pContext = pObj->pContext;
+
+  pthread_mutex_lock(&pContext->mutex);
+
+  pObj->incDisabled = 1;
+  if (pObj->pStream != NULL) {
+    taos_close_stream(pObj->pStream);
+    pObj->pStream = NULL;
+    cqStopIncremental(pObj);
+
+    // the stream restarts from the last row of stream table
+    if (pContext->master) cqCreateStream(pContext, pObj);
+  }
+
+  pthread_mutex_unlock(&pContext->mutex);
+}
+
+static void cqProcessIncTimer(void *param, void *tmrId) {
+  SCqObj *pObj = (SCqObj *)taosAcquireRef(cqObjRef, (int64_t)param);
+  if (pObj == NULL) {
+    return;
+  }
+
+  SCqContext *pContext = pObj->pContext;
+  pthread_mutex_lock(&pContext->incMutex);
+
+  SCqInc *pInc = pObj->pInc;
+  if (pInc == NULL || pInc->tmrId != tmrId) {
+    pthread_mutex_unlock(&pContext->incMutex);
+    taosReleaseRef(cqObjRef, (int64_t)param);
+    return;
+  }
+
+  if (pInc->failed) {
+    pthread_mutex_unlock(&pContext->incMutex);
+    cqFallbackToQuery(pObj);
+    taosReleaseRef(cqObjRef, (int64_t)param);
+    return;
+  }
+
+  int64_t delay = convertTimePrecision(tsMaxStreamComputDelay, TSDB_TIME_PRECISION_MILLI, pInc->precision);
+  TSKEY   limit = taosGetTimestamp(pInc->precision) - delay;
+
+  // write the closed windows into the stream table
+  int32_t numOfClosed = 0;
+  size_t  num = taosArrayGetSize(pInc->pWindows);
+  while (numOfClosed < num) {
+    SCqIncWindow *pWin = taosArrayGetP(pInc->pWindows, numOfClosed);
+    if (pWin->skey + pInc->interval.interval > limit) {
+      break;
+    }
+
+    cqWriteIncWindow(pObj, pInc, pWin);
+    cqFreeIncWindow(&pWin);
+    numOfClosed++;
+  }
+
+  for (int32_t i = 0; i < numOfClosed; ++i) {
+    taosArrayRemove(pInc->pWindows, 0);
+  }
+
+  // rows arriving later than the max computing delay are discarded, the same as the stream
+  TSKEY nextKey = taosTimeTruncate(limit, &pInc->interval, pInc->precision);
+  if (nextKey > pInc->nextKey) {
+    pInc->nextKey = nextKey;
+  }
+
+  if (numOfClosed > 0) {
+    cDebug("vgId:%d, id:%d CQ:%s %d windows are written, next window:%" PRId64, pContext->vgId, pObj->tid,
+           pObj->sqlStr, numOfClosed, pInc->nextKey);
+  }
+
+  cqSetIncTimer(pInc);
+  pthread_mutex_unlock(&pContext->incMutex);
+
   taosReleaseRef(cqObjRef, (int64_t)param);
 }
 
+static SCqIncWindow *cqGetIncWindow(SCqInc *pInc, TSKEY skey) {
+  // rows are mostly inserted into the latest windows
+  int32_t i = (int32_t)taosArrayGetSize(pInc->pWindows) - 1;
+  for (; i >= 0; --i) {
+    SCqIncWindow *pWin = taosArrayGetP(pInc->pWindows, i);
+    if (pWin->skey == skey) return pWin;
+    if (pWin->skey < skey) break;
+  }
+
+  if (taosArrayGetSize(pInc->pWindows) >= CQ_INC_MAX_WINDOWS) {
+    return NULL;
+  }
+
+  SCqIncWindow *pWin = calloc(1, sizeof(SCqIncWindow) + sizeof(SCqIncAgg) * pInc->numOfExprs);
+  if (pWin == NULL) return NULL;
+
+  pWin->skey = skey;
+  taosArrayInsert(pInc->pWindows, i + 1, &pWin);
+  return pWin;
+}
+
+static void cqFoldIncRow(SCqInc *pInc, SCqIncWindow *pWin, SMemRow row, TSKEY key) {
+  pWin->numOfRows++;
+
+  for (int32_t i = 0; i < pInc->numOfExprs; ++i) {
+    SCqIncExpr *pExpr = &pInc->expr[i];
+    if (pExpr->functionId == TSDB_FUNC_TS) {
+      continue;
+    }
+
+    void *data = NULL;
+    if (pExpr->colIndex == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+      data = &key;
+    } else {
+      data = tdGetMemRowDataOfCol(row, pExpr->colId, pExpr->type, pExpr->offset);
+      if (data == NULL || isNull(data, pExpr->type)) continue;
+    }
+
+    SCqIncVal v = {0};
+    if (pExpr->functionId != TSDB_FUNC_COUNT) {
+      v = cqGetIncVal(data, pExpr->type);
+    }
+
+    cqFoldIncVal(&pWin->agg[i], v, pExpr->type, key);
+  }
+}
+
+bool cqWatchTable(void *handle, uint64_t uid) {
+  SCqContext *pContext = handle;
+  if (pContext == NULL || atomic_load_32(&pContext->incNum) <= 0) {
+    return false;
+  }
+
+  pthread_mutex_lock(&pContext->incMutex);
+  bool watched = (taosHashGet(pContext->pIncTables, &uid, sizeof(uid)) != NULL);
+  pthread_mutex_unlock(&pContext->incMutex);
+
+  return watched;
+}
+
+// incMutex shall be locked in caller
+static void cqAppendRow(SCqIncTable *pTable, TSKEY keyBase, SMemRow row) {
+  TSKEY  key = memRowKey(row);
+  size_t num = taosArrayGetSize(pTable->pIncs);
+
+  for (int32_t i = 0; i < num; ++i) {
+    SCqInc *pInc = taosArrayGetP(pTable->pIncs, i);
+    if (pInc->failed) {
+      continue;
+    }
+
+    if (memRowVersion(row) != pInc->sversion || memRowDeleted(row)) {
+      cqSetIncFailed(pInc);
+      continue;
+    }
+
+    // a row falls in interval / sliding windows
+    TSKEY skey = taosTimeTruncate(key, &pInc->interval, pInc->precision);
+    for (; skey <= key; skey += pInc->interval.sliding) {
+      if (skey < pInc->nextKey) {
+        continue;
+      }
+
+      // the key may be committed already, then the row is discarded by TSDB and can not be folded
+      if (key <= keyBase) {
+        cqSetIncFailed(pInc);
+        break;
+      }
+
+      SCqIncWindow *pWin = cqGetIncWindow(pInc, skey);
+      if (pWin == NULL) {
+        cqSetIncFailed(pInc);
+        break;
+      }
+
+      cqFoldIncRow(pInc, pWin, row, key);
+    }
+  }
+}
+
+void cqAppendRows(void *handle, uint64_t uid, int8_t update, TSKEY keyBase, SMemRow *rows, int32_t numOfRows) {
+  SCqContext *pContext = handle;
+
+  pthread_mutex_lock(&pContext->incMutex);
+
+  SCqIncTable **ppTable = taosHashGet(pContext->pIncTables, &uid, sizeof(uid));
+  if (ppTable == NULL) {
+    pthread_mutex_unlock(&pContext->incMutex);
+    return;
+  }
+
+  SCqIncTable *pTable = *ppTable;
+
+  // updated rows can not be folded into the partial aggregates
+  if (update != TD_ROW_DISCARD_UPDATE) {
+    size_t num = taosArrayGetSize(pTable->pIncs);
+    for (int32_t i = 0; i < num; ++i) {
+      cqSetIncFailed(taosArrayGetP(pTable->pIncs, i));
+    }
+
+    pthread_mutex_unlock(&pContext->incMutex);
+    return;
+  }
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    cqAppendRow(pTable, keyBase, rows[i]);
+  }
+
+  pthread_mutex_unlock(&pContext->incMutex);
+}
@@ -23,6 +23,7 @@ extern "C" {
 
 int32_t dnodeInitShell();
 void    dnodeCleanupShell();
+int32_t dnodeGetUserSecret(char *user, char *secret);
 
 #ifdef __cplusplus
 }
@@ -33,6 +33,7 @@
 #include "dnodeVRead.h"
 #include "dnodeVWrite.h"
 #include "dnodeVMgmt.h"
+#include "dnodeMerge.h"
 #include "dnodeVnodes.h"
 #include "dnodeMRead.h"
 #include "dnodeMWrite.h"
@@ -74,6 +75,7 @@ static SStep tsDnodeSteps[] = {
   {"dnode-vread",     dnodeInitVRead,      dnodeCleanupVRead},
   {"dnode-vwrite",    dnodeInitVWrite,     dnodeCleanupVWrite},
   {"dnode-vmgmt",     dnodeInitVMgmt,      dnodeCleanupVMgmt},
+  {"dnode-merge",     dnodeInitMerge,      dnodeCleanupMerge},
   {"dnode-mread",     dnodeInitMRead,      NULL},
   {"dnode-mwrite",    dnodeInitMWrite,     NULL},
   {"dnode-mpeer",     dnodeInitMPeer,      NULL},  
@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taos.h"
+#include "tsclient.h"
+#include "hash.h"
+#include "tkey.h"
+#include "tqueue.h"
+#include "tref.h"
+#include "ttimer.h"
+#include "tworker.h"
+#include "dnodeShell.h"
+#include "dnodeMerge.h"
+
+/*
+ * A dnode merges super table queries for clients configured with serverMerge. The query runs with the embedded
+ * client under the identity of the requesting user, which sends the subqueries to all the vgroups and merges their
+ * partial results here. The client only fetches the final rows, whose nchar columns are kept in ucs4 as vnodes
+ * return them. The time window and timezone of the query are the ones resolved by the client.
+ *
+ * The connections are kept for the later queries of the same user and db, at most maxMergeConns of them. A timer
+ * frees the queries the clients stop fetching and closes the connections no query has used for the same span.
+ */
+#define MERGE_KEY_LEN (TSDB_USER_LEN + TSDB_KEY_LEN * 2 + TSDB_DB_NAME_LEN + 2)
+
+typedef struct {
+  TAOS *  pConn;
+  char    key[MERGE_KEY_LEN];
+  int32_t keyLen;
+  int32_t numOfQueries;  // the queries using the connection, which is closed only when it is 0
+  int64_t lastTime;      // ms, the last time a query using the connection is started or freed
+} SMergeConn;
+
+typedef struct {
+  SSqlObj *   pSql;
+  SMergeConn *pConn;
+  int64_t     rid;       // ref id, sent to the client as the qId
+  int64_t     lastTime;  // ms, the query is freed if the client stops fetching
+} SMergeQuery;
+
+extern void *tsDnodeTmr;
+
+static SWorkerPool     tsMergeWP;
+static taos_queue      tsMergeQueue = NULL;
+static int32_t         tsMergeQueryRef = -1;
+static SHashObj *      tsMergeConns = NULL;  // connection of each user and db, "user:secret:db" -> SMergeConn*
+static pthread_mutex_t tsMergeMutex;
+static void *          tsMergeTimer = NULL;
+
+static void *dnodeProcessMergeQueue(void *wparam);
+static void  dnodeReapMergeQueries(void *param, void *tmrId);
+
+// the idle span of a vnode query handle
+static int64_t dnodeMergeIdleTime() { return (int64_t)tsShellActivityTimer * 2 * 1000; }
+static int32_t dnodeMergeReapInterval() { return (int32_t)MIN(dnodeMergeIdleTime(), 10000); }
+
+static void dnodeReleaseMergeConn(SMergeConn *pConn) {
+  pthread_mutex_lock(&tsMergeMutex);
+  pConn->numOfQueries--;
+  pConn->lastTime = taosGetTimestampMs();
+  pthread_mutex_unlock(&tsMergeMutex);
+}
+
+static void dnodeFreeMergeQuery(void *param) {
+  SMergeQuery *pQuery = param;
+  taos_free_result(pQuery->pSql);
+  dnodeReleaseMergeConn(pQuery->pConn);
+  free(pQuery);
+}
+
+int32_t dnodeInitMerge() {
+  tsMergeQueryRef = taosOpenRef(1000, dnodeFreeMergeQuery);
+  tsMergeConns = taosHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  pthread_mutex_init(&tsMergeMutex, NULL);
+  taosTmrReset(dnodeReapMergeQueries, dnodeMergeReapInterval(), NULL, tsDnodeTmr, &tsMergeTimer);
+
+  tsMergeWP.name = "vmerge";
+  tsMergeWP.workerFp = dnodeProcessMergeQueue;
+  tsMergeWP.min = MAX(2, tsNumOfCores / 2);
+  tsMergeWP.max = tsMergeWP.min;
+  if (tWorkerInit(&tsMergeWP) != 0) return -1;
+
+  tsMergeQueue = tWorkerAllocQueue(&tsMergeWP, NULL);
+  if (tsMergeQueue == NULL) return -1;
+
+  dInfo("dnode merge is initialized, workers:%d", tsMergeWP.max);
+  return 0;
+}
+
+void dnodeCleanupMerge() {
+  if (tsMergeTimer != NULL) {
+    taosTmrStopA(&tsMergeTimer);
+    tsMergeTimer = NULL;
+  }
+
+  if (tsMergeQueue != NULL) {
+    tWorkerFreeQueue(&tsMergeWP, tsMergeQueue);
+    tsMergeQueue = NULL;
+  }
+  tWorkerCleanup(&tsMergeWP);
+
+  SMergeQuery *pQuery = taosIterateRef(tsMergeQueryRef, 0);
+  while (pQuery) {
+    int64_t rid = pQuery->rid;
+    taosRemoveRef(tsMergeQueryRef, rid);
+    pQuery = taosIterateRef(tsMergeQueryRef, rid);
+  }
+  taosCloseRef(tsMergeQueryRef);
+  tsMergeQueryRef = -1;
+
+  if (tsMergeConns != NULL) {
+    SMergeConn **ppConn = taosHashIterate(tsMergeConns, NULL);
+    while (ppConn) {
+      taos_close((*ppConn)->pConn);
+      free(*ppConn);
+      ppConn = taosHashIterate(tsMergeConns, ppConn);
+    }
+
+    taosHashCleanup(tsMergeConns);
+    tsMergeConns = NULL;
+  }
+
+  pthread_mutex_destroy(&tsMergeMutex);
+  dInfo("dnode merge is closed");
+}
+
+void dnodeDispatchToMergeQueue(SRpcMsg *pMsg) {
+  SRpcMsg *pItem = taosAllocateQitem(sizeof(SRpcMsg));
+  if (pItem == NULL || tsMergeQueue == NULL) {
+    SRpcMsg rpcRsp = {.handle = pMsg->handle, .code = TSDB_CODE_DND_OUT_OF_MEMORY};
+    rpcSendResponse(&rpcRsp);
+    rpcFreeCont(pMsg->pCont);
+    taosFreeQitem(pItem);
+    return;
+  }
+
+  *pItem = *pMsg;
+  taosWriteQitem(tsMergeQueue, TAOS_QTYPE_RPC, pItem);
+}
+
+// the least recently used connection without queries makes room for a new one
+static bool dnodeEvictMergeConn() {
+  SMergeConn * pVictim = NULL;
+  SMergeConn **ppConn = taosHashIterate(tsMergeConns, NULL);
+  while (ppConn) {
+    SMergeConn *pConn = *ppConn;
+    if (pConn->numOfQueries == 0 && (pVictim == NULL || pConn->lastTime < pVictim->lastTime)) {
+      pVictim = pConn;
+    }
+    ppConn = taosHashIterate(tsMergeConns, ppConn);
+  }
+
+  if (pVictim == NULL) {
+    return false;
+  }
+
+  dDebug("connection to merge queries:%p is closed to make room for a new one", pVictim->pConn);
+  taosHashRemove(tsMergeConns, pVictim->key, pVictim->keyLen);
+  taos_close(pVictim->pConn);
+  free(pVictim);
+  return true;
+}
+
+static SMergeConn *dnodeAcquireMergeConn(char *user, char *db, int32_t *code) {
+  char secret[TSDB_KEY_LEN] = {0};
+  *code = dnodeGetUserSecret(user, secret);
+  if (*code != TSDB_CODE_SUCCESS) {
+    return NULL;
+  }
+
+  char *auth = base64_encode((unsigned char *)secret, TSDB_KEY_LEN);
+  if (auth == NULL) {
+    *code = TSDB_CODE_DND_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  char    key[MERGE_KEY_LEN] = {0};
+  int32_t keyLen = snprintf(key, sizeof(key), "%s:%s:%s", user, auth, db);
+
+  pthread_mutex_lock(&tsMergeMutex);
+
+  SMergeConn * pConn = NULL;
+  SMergeConn **ppConn = taosHashGet(tsMergeConns, key, keyLen);
+  if (ppConn != NULL) {
+    pConn = *ppConn;
+  } else if ((int32_t)taosHashGetSize(tsMergeConns) >= tsMaxMergeConns && !dnodeEvictMergeConn()) {
+    *code = TSDB_CODE_DND_TOO_MANY_MERGE_CONNS;
+  } else if ((pConn = calloc(1, sizeof(SMergeConn))) == NULL) {
+    *code = TSDB_CODE_DND_OUT_OF_MEMORY;
+  } else {
+    pConn->pConn = taos_connect_auth(NULL, user, auth, (db[0] == 0) ? NULL : db, 0);
+    if (pConn->pConn == NULL) {
+      *code = (terrno != TSDB_CODE_SUCCESS) ? terrno : TSDB_CODE_RPC_NETWORK_UNAVAIL;
+      tfree(pConn);
+    } else {
+      ((STscObj *)pConn->pConn)->rawNchar = 1;
+      tstrncpy(pConn->key, key, sizeof(pConn->key));
+      pConn->keyLen = keyLen;
+      taosHashPut(tsMergeConns, key, keyLen, &pConn, POINTER_BYTES);
+      dDebug("user:%s, connection to merge queries on db:%s is created", user, db);
+    }
+  }
+
+  if (pConn != NULL) {
+    pConn->numOfQueries++;
+    pConn->lastTime = taosGetTimestampMs();
+  }
+
+  pthread_mutex_unlock(&tsMergeMutex);
+
+  free(auth);
+  return pConn;
+}
+
+// free the queries not fetched within the idle span, and close the connections not used for as long
+static void dnodeReapMergeQueries(void *param, void *tmrId) {
+  if (tsMergeConns == NULL) return;
+
+  int64_t now = taosGetTimestampMs();
+  int64_t idleTime = dnodeMergeIdleTime();
+
+  SMergeQuery *pQuery = taosIterateRef(tsMergeQueryRef, 0);
+  while (pQuery) {
+    int64_t rid = pQuery->rid;
+    if (now - pQuery->lastTime > idleTime) {
+      dWarn("qId:0x%" PRIx64 ", merge query is not fetched for %" PRId64 "ms, freed", rid, now - pQuery->lastTime);
+      taosRemoveRef(tsMergeQueryRef, rid);
+    }
+
+    pQuery = taosIterateRef(tsMergeQueryRef, rid);
+  }
+
+  pthread_mutex_lock(&tsMergeMutex);
+
+  SArray *pIdle = taosArrayInit(4, POINTER_BYTES);
+  SMergeConn **ppConn = taosHashIterate(tsMergeConns, NULL);
+  while (ppConn) {
+    SMergeConn *pConn = *ppConn;
+    if (pConn->numOfQueries == 0 && now - pConn->lastTime > idleTime && pIdle != NULL) {
+      taosArrayPush(pIdle, &pConn);
+    }
+    ppConn = taosHashIterate(tsMergeConns, ppConn);
+  }
+
+  for (int32_t i = 0; i < (int32_t)taosArrayGetSize(pIdle); ++i) {
+    SMergeConn *pConn = *(SMergeConn **)taosArrayGet(pIdle, i);
+    dDebug("connection to merge queries:%p is idle for %" PRId64 "ms, closed", pConn->pConn, now - pConn->lastTime);
+    taosHashRemove(tsMergeConns, pConn->key, pConn->keyLen);
+    taos_close(pConn->pConn);
+    free(pConn);
+  }
+
+  pthread_mutex_unlock(&tsMergeMutex);
+  taosArrayDestroy(pIdle);
+
+  taosTmrReset(dnodeReapMergeQueries, dnodeMergeReapInterval(), NULL, tsDnodeTmr, &tsMergeTimer);
+}
+
+static int32_t dnodeProcessMergeQueryMsg(SRpcMsg *pMsg, SRpcMsg *pRsp) {
+  SMergeQueryMsg *pMergeMsg = pMsg->pCont;
+  if (pMsg->contLen < (int32_t)sizeof(SMergeQueryMsg)) {
+    return TSDB_CODE_DND_INVALID_MSG_LEN;
+  }
+
+  int32_t sqlLen = htonl(pMergeMsg->sqlLen);
+  if (sqlLen <= 0 || pMsg->contLen < (int32_t)sizeof(SMergeQueryMsg) + sqlLen + 1) {
+    return TSDB_CODE_DND_INVALID_MSG_LEN;
+  }
+
+  pMergeMsg->sql[sqlLen] = 0;
+  pMergeMsg->db[sizeof(pMergeMsg->db) - 1] = 0;
+
+  SRpcConnInfo connInfo = {0};
+  if (rpcGetConnInfo(pMsg->handle, &connInfo) != 0) {
+    return TSDB_CODE_RPC_NETWORK_UNAVAIL;
+  }
+
+  int32_t     code = TSDB_CODE_SUCCESS;
+  SMergeConn *pConn = dnodeAcquireMergeConn(connInfo.user, pMergeMsg->db, &code);
+  if (pConn == NULL) {
+    dError("user:%s, failed to connect to merge query on db:%s, reason:%s", connInfo.user, pMergeMsg->db,
+           tstrerror(code));
+    return code;
+  }
+
+  STimeWindow window = {.skey = (int64_t)htobe64(pMergeMsg->skey), .ekey = (int64_t)htobe64(pMergeMsg->ekey)};
+  int64_t     tz = (int64_t)htobe64(pMergeMsg->timezone);
+
+  SSqlObj *pSql = taos_query_merge(pConn->pConn, pMergeMsg->sql, &window, tz);
+  code = taos_errno(pSql);
+  if (code != TSDB_CODE_SUCCESS) {
+    dDebug("user:%s, failed to merge query, reason:%s, sql:%s", connInfo.user, tstrerror(code), pMergeMsg->sql);
+    taos_free_result(pSql);
+    dnodeReleaseMergeConn(pConn);
+    return code;
+  }
+
+  SMergeQuery *pQuery = calloc(1, sizeof(SMergeQuery));
+  if (pQuery == NULL) {
+    taos_free_result(pSql);
+    dnodeReleaseMergeConn(pConn);
+    return TSDB_CODE_DND_OUT_OF_MEMORY;
+  }
+
+  pQuery->pSql = pSql;
+  pQuery->pConn = pConn;
+  pQuery->lastTime = taosGetTimestampMs();
+
+  int64_t rid = taosAddRef(tsMergeQueryRef, pQuery);
+  if (rid < 0) {
+    dnodeFreeMergeQuery(pQuery);
+    return terrno;
+  }
+  pQuery->rid = rid;
+
+  SQueryTableRsp *pQueryRsp = rpcMallocCont(sizeof(SQueryTableRsp));
+  pQueryRsp->code = 0;
+  pQueryRsp->qId = htobe64(rid);
+
+  pRsp->pCont = pQueryRsp;
+  pRsp->contLen = sizeof(SQueryTableRsp);
+
+  dDebug("qId:0x%" PRIx64 ", merge query is started for user:%s, sql:%s", rid, connInfo.user, pMergeMsg->sql);
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t dnodeProcessMergeFetchMsg(SRpcMsg *pMsg, SRpcMsg *pRsp) {
+  SRetrieveTableMsg *pRetrieve = pMsg->pCont;
+  if (pMsg->contLen < (int32_t)sizeof(SRetrieveTableMsg)) {
+    return TSDB_CODE_DND_INVALID_MSG_LEN;
+  }
+
+  int64_t  rid = (int64_t)htobe64(pRetrieve->qId);
+  uint16_t freeType = htons(pRetrieve->free);
+
+  SMergeQuery *pQuery = taosAcquireRef(tsMergeQueryRef, rid);
+  if (pQuery == NULL) {
+    dError("qId:0x%" PRIx64 ", invalid qId in fetching merged results", rid);
+    return TSDB_CODE_QRY_INVALID_QHANDLE;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  int32_t numOfRows = 0;
+  int32_t len = 0;
+
+  if ((freeType & TSDB_QUERY_TYPE_FREE_RESOURCE) == 0) {
+    TAOS_ROW rows = NULL;
+    numOfRows = taos_fetch_block(pQuery->pSql, &rows);
+    code = taos_errno(pQuery->pSql);
+    if (code == TSDB_CODE_SUCCESS && numOfRows > 0) {
+      len = tscGetResRawBlock(pQuery->pSql, NULL);
+    }
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    SRetrieveTableRsp *pRetrieveRsp = rpcMallocCont(sizeof(SRetrieveTableRsp) + len);
+    if (pRetrieveRsp == NULL) {
+      code = TSDB_CODE_DND_OUT_OF_MEMORY;
+    } else {
+      memset(pRetrieveRsp, 0, sizeof(SRetrieveTableRsp));
+      pRetrieveRsp->numOfRows = htonl(numOfRows);
+      pRetrieveRsp->completed = (numOfRows <= 0) ? 1 : 0;
+      pRetrieveRsp->precision = htons((int16_t)taos_result_precision(pQuery->pSql));
+      if (len > 0) {
+        tscGetResRawBlock(pQuery->pSql, pRetrieveRsp->data);
+      }
+
+      pRsp->pCont = pRetrieveRsp;
+      pRsp->contLen = sizeof(SRetrieveTableRsp) + len;
+    }
+  }
+
+  // the last block has been sent, or the client gives the query up
+  bool completed = (code != TSDB_CODE_SUCCESS || numOfRows <= 0);
+  if (!completed) {
+    pQuery->lastTime = taosGetTimestampMs();
+  }
+
+  taosReleaseRef(tsMergeQueryRef, rid);
+  if (completed) {
+    dDebug("qId:0x%" PRIx64 ", merge query is completed, code:%s free:%d", rid, tstrerror(code), freeType);
+    taosRemoveRef(tsMergeQueryRef, rid);
+  }
+
+  return code;
+}
+
+static void *dnodeProcessMergeQueue(void *wparam) {
+  SWorker *    pWorker = wparam;
+  SWorkerPool *pPool = pWorker->pPool;
+  SRpcMsg *    pMsg;
+  int32_t      qtype;
+  void *       unUsed;
+
+  setThreadName("dnodeMergeQ");
+
+  while (1) {
+    if (taosReadQitemFromQset(pPool->qset, &qtype, (void **)&pMsg, &unUsed) == 0) {
+      dDebug("dnode merge got no message from qset:%p, exiting", pPool->qset);
+      break;
+    }
+
+    dTrace("msg:%p, type:%s will be processed in merge queue", pMsg->ahandle, taosMsg[pMsg->msgType]);
+
+    SRpcMsg rpcRsp = {.handle = pMsg->handle};
+    if (pMsg->msgType == TSDB_MSG_TYPE_MERGE_QUERY) {
+      rpcRsp.code = dnodeProcessMergeQueryMsg(pMsg, &rpcRsp);
+    } else {
+      rpcRsp.code = dnodeProcessMergeFetchMsg(pMsg, &rpcRsp);
+    }
+
+    rpcSendResponse(&rpcRsp);
+    rpcFreeCont(pMsg->pCont);
+    taosFreeQitem(pMsg);
+  }
+
+  return NULL;
+}
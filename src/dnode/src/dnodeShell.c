@@ -23,6 +23,7 @@
 #include "dnodeMWrite.h"
 #include "dnodeShell.h"
 #include "dnodeStep.h"
+#include "dnodeMerge.h"
 
 static void  (*dnodeProcessShellMsgFp[TSDB_MSG_TYPE_MAX])(SRpcMsg *);
 static void    dnodeProcessMsgFromShell(SRpcMsg *pMsg, SRpcEpSet *);
@@ -36,6 +37,8 @@ int32_t dnodeInitShell() {
   dnodeProcessShellMsgFp[TSDB_MSG_TYPE_QUERY]          = dnodeDispatchToVReadQueue;
   dnodeProcessShellMsgFp[TSDB_MSG_TYPE_FETCH]          = dnodeDispatchToVReadQueue;
   dnodeProcessShellMsgFp[TSDB_MSG_TYPE_UPDATE_TAG_VAL] = dnodeDispatchToVWriteQueue;
+  dnodeProcessShellMsgFp[TSDB_MSG_TYPE_MERGE_QUERY]    = dnodeDispatchToMergeQueue;
+  dnodeProcessShellMsgFp[TSDB_MSG_TYPE_MERGE_FETCH]    = dnodeDispatchToMergeQueue;
 
   // the following message shall be treated as mnode write
   dnodeProcessShellMsgFp[TSDB_MSG_TYPE_CM_CREATE_ACCT] = dnodeDispatchToMWriteQueue;
@@ -247,3 +250,11 @@ SStatisInfo dnodeGetStatisInfo() {
 
   return info;
 }
+
+int32_t dnodeGetUserSecret(char *user, char *secret) {
+  char spi = 0;
+  char encrypt = 0;
+  char ckey[TSDB_KEY_LEN] = {0};
+
+  return dnodeRetrieveUserAuthInfo(user, &spi, &encrypt, secret, ckey);
+}
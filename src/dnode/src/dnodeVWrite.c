@@ -206,16 +206,32 @@ static void *dnodeProcessVWriteQueue(void *wparam) {
       dTrace("msg:%p, app:%p type:%s will be processed in vwrite queue, qtype:%s hver:%" PRIu64, pWrite,
              pWrite->rpcMsg.ahandle, taosMsg[pWrite->walHead.msgType], qtypeStr[qtype], pWrite->walHead.version);
 
-      pWrite->code = vnodeProcessWrite(pVnode, &pWrite->walHead, qtype, pWrite);
+      pWrite->code = vnodeLogWrite(pVnode, &pWrite->walHead, qtype, pWrite);
+      if (pWrite->code >= 0 && pWrite->walHead.msgType != TSDB_MSG_TYPE_SUBMIT) forceFsync = true;
+    }
+
+    // the messages are applied only after the WAL of the whole batch is written, so the rows of a failed batch are
+    // never visible and a writer retrying on the error does not write them twice
+    int32_t walCode = walFsync(vnodeGetWal(pVnode), forceFsync);
+
+    taosResetQitems(pWorker->qall);
+    for (int32_t i = 0; i < numOfMsgs; ++i) {
+      taosGetQitem(pWorker->qall, &qtype, (void **)&pWrite);
+      if (pWrite->code >= 0) {
+        if (walCode != 0) {
+          if (pWrite->code > 0) atomic_sub_fetch_32(&pWrite->processedCount, 1);
+          pWrite->code = walCode;
+        } else {
+          pWrite->code = vnodeApplyWrite(pVnode, &pWrite->walHead, pWrite->code, pWrite);
+        }
+      }
+
       if (pWrite->code <= 0) atomic_add_fetch_32(&pWrite->processedCount, 1);
       if (pWrite->code > 0) pWrite->code = 0;
-      if (pWrite->code == 0 && pWrite->walHead.msgType != TSDB_MSG_TYPE_SUBMIT) forceFsync = true;
 
       dTrace("msg:%p is processed in vwrite queue, code:0x%x", pWrite, pWrite->code);
     }
 
-    walFsync(vnodeGetWal(pVnode), forceFsync);
-
     // browse all items, and process them one by one
     taosResetQitems(pWorker->qall);
     for (int32_t i = 0; i < numOfMsgs; ++i) {
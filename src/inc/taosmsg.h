@@ -45,8 +45,8 @@ TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_SUBMIT, "submit" )
 TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_QUERY, "query" )
 TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_FETCH, "fetch" )
 TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_UPDATE_TAG_VAL, "update-tag-val" )
-TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_DUMMY1, "dummy1" )
-TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_DUMMY2, "dummy2" )
+TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_MERGE_QUERY, "merge-query" )
+TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_MERGE_FETCH, "merge-fetch" )
 TAOS_DEFINE_MESSAGE_TYPE( TSDB_MSG_TYPE_DUMMY3, "dummy3" )
 
 // message from mnode to dnode
@@ -515,6 +515,8 @@ typedef struct {
   int32_t     udfNum;           // number of udf function
   int32_t     udfContentOffset;
   int32_t     udfContentLen;
+  int16_t     numOfPartitions;  // the tables of the vnode are split into partitions by tid, each queried by one msg
+  int16_t     partitionIndex;   // the partition of the tables queried by this msg
   SColumnInfo tableCols[];
 } SQueryTableMsg;
 
@@ -523,6 +525,17 @@ typedef struct {
   union{uint64_t qhandle; uint64_t qId;}; // query handle
 } SQueryTableRsp;
 
+// super table query merged by the receiving dnode, answered with SQueryTableRsp and fetched by merge-fetch
+typedef struct {
+  SMsgHead header;
+  char     db[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN];  // current db of the client connection, may be empty
+  int64_t  skey;      // the time window and timezone resolved by the client
+  int64_t  ekey;
+  int64_t  timezone;  // seconds west of UTC
+  int32_t  sqlLen;
+  char     sql[];
+} SMergeQueryMsg;
+
 // todo: the show handle should be replaced with id
 typedef struct {
   SMsgHead header;
@@ -46,6 +46,9 @@ typedef struct {
   pthread_mutex_t mutex;
   int32_t delete;
   int32_t cqObjNum;
+  int32_t incNum;    // number of CQs computed incrementally
+  void   *pIncTables;  // source table uid -> CQs computed incrementally from it
+  pthread_mutex_t incMutex;
 } SCqContext;
 
 // the following API shall be called by vnode
@@ -64,6 +67,12 @@ void *cqCreate(void *handle, uint64_t uid, int32_t sid, const char* dstTable, ch
 // cqDrop is called by TSDB to stop an instance of CQ, handle is the return value of cqCreate
 void  cqDrop(void *handle);
 
+// the following API shall be called by TSDB to feed the rows inserted into a table to the incremental CQs,
+// cqWatchTable tells if any CQ is interested in the table, cqAppendRows is called with the rows accepted then.
+// The rows are new keys of the mem table, but a key not larger than keyBase may repeat one committed before.
+bool  cqWatchTable(void *handle, uint64_t uid);
+void  cqAppendRows(void *handle, uint64_t uid, int8_t update, TSKEY keyBase, SMemRow *rows, int32_t numOfRows);
+
 extern int32_t cqDebugFlag;
 
 
@@ -53,6 +53,8 @@ typedef struct {
   int (*eventCallBack)(void *);
   void *(*cqCreateFunc)(void *handle, uint64_t uid, int32_t sid, const char *dstTable, char *sqlStr, STSchema *pSchema, int start);
   void (*cqDropFunc)(void *handle);
+  bool (*cqWatchTableFunc)(void *handle, uint64_t uid);
+  void (*cqAppendRowsFunc)(void *handle, uint64_t uid, int8_t update, TSKEY keyBase, SMemRow *rows, int32_t numOfRows);
 } STsdbAppH;
 
 // --------- TSDB REPOSITORY CONFIGURATION DEFINITION
@@ -333,6 +335,15 @@ void tsdbRetrieveDataBlockInfo(TsdbQueryHandleT *pQueryHandle, SDataBlockInfo *p
  */
 int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT *pQueryHandle, SDataStatis **pBlockStatis);
 
+/**
+ *
+ * Check a value against the bloom filter of a column of current data block.
+ *
+ * @param val   the value in the column type, or the content of a binary/nchar value without the length header
+ * @return false if the column of the block has a filter and the value is not in it, otherwise true
+ */
+bool tsdbDataBlockMayContain(TsdbQueryHandleT pQueryHandle, int16_t colId, const void *val, int32_t len);
+
 /**
  *
  * The query condition with primary timestamp is passed to iterator during its constructor function,
@@ -360,6 +371,14 @@ int32_t tsdbQuerySTableByTagCond(STsdbRepo *tsdb, uint64_t uid, TSKEY key, const
  */
 void tsdbDestroyTableGroup(STableGroupInfo *pGroupList);
 
+/**
+ * keep only the tables of one partition in the table group list, the tables are split into partitions by tid
+ * @param pGroupList
+ * @param numOfParts  the number of partitions
+ * @param index       the partition to keep
+ */
+void tsdbPartitionTableGroup(STableGroupInfo *pGroupList, int32_t numOfParts, int32_t index);
+
 /**
  * create the table group result including only one table, used to handle the normal table query
  *
@@ -400,8 +419,33 @@ int32_t tsdbGetFileBlocksDistInfo(TsdbQueryHandleT* queryHandle, STableBlockDist
  */
 void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage);
 
+typedef struct {
+  int32_t bufBlockSize;
+  int32_t numOfBlocks;       // blocks owned by the buffer pool, including grown ones
+  int32_t numOfFreeBlocks;
+  int32_t numOfExtraBlocks;  // blocks grown beyond the configured number of blocks
+  int32_t peakExtraBlocks;
+  int64_t numOfGrows;
+  int64_t numOfShrinks;
+  int64_t dnodePoolMem;      // bytes held by the buffer pools of all vnodes
+} STsdbBufPoolStatis;
+
+/**
+ * get the occupancy of the buffer pool
+ * @param repo. point to the tsdbrepo
+ * @param pStatis. statistics of the buffer pool
+ */
+void tsdbGetBufPoolStatis(STsdbRepo *repo, STsdbBufPoolStatis *pStatis);
+
+/**
+ * check whether writes to the repo should be held until a commit frees buffer blocks
+ */
+bool tsdbIsBufPoolFull(STsdbRepo *repo);
+
 int  tsdbInitCommitQueue();
 void tsdbDestroyCommitQueue();
+int  tsdbInitReadAheadPool();
+void tsdbCleanupReadAheadPool();
 int  tsdbSyncCommit(STsdbRepo *repo);
 void tsdbIncCommitRef(int vgId);
 void tsdbDecCommitRef(int vgId);
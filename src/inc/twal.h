@@ -48,6 +48,13 @@ typedef struct {
   EWalKeep keep;         // keep the wal file when closed
 } SWalCfg;
 
+typedef struct {
+  int64_t numOfBatches;  // writes issued to wal files
+  int64_t numOfRecords;  // records carried by these writes
+  int64_t numOfFsyncs;
+  int64_t fsyncUs;       // total time spent in fsync
+} SWalStatis;
+
 typedef void *  twalh;  // WAL HANDLE
 typedef int32_t FWalWrite(void *ahandle, void *pHead, int32_t qtype, void *pMsg);
 
@@ -61,11 +68,12 @@ int32_t  walRenew(twalh);
 void     walRemoveOneOldFile(twalh);
 void     walRemoveAllOldFiles(twalh);
 int32_t  walWrite(twalh, SWalHead *);
-void     walFsync(twalh, bool forceFsync);
+int32_t  walFsync(twalh, bool forceFsync);
 int32_t  walRestore(twalh, void *pVnode, FWalWrite writeFp);
 int32_t  walGetWalFile(twalh, char *fileName, int64_t *fileId);
 uint64_t walGetVersion(twalh);
 void     walResetVersion(twalh, uint64_t newVer);
+void     walGetStatis(SWalStatis *pStatis);
 
 #ifdef __cplusplus
 }
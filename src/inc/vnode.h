@@ -21,6 +21,7 @@ extern "C" {
 #endif
 #include "trpc.h"
 #include "twal.h"
+#include "tsdb.h"
 
 typedef struct {
   int32_t len;
@@ -74,11 +75,14 @@ void*   vnodeGetWal(void *pVnode);
 int32_t vnodeGetVnodeList(int32_t vnodeList[], int32_t *numOfVnodes);
 void    vnodeBuildStatusMsg(void *pStatus);
 void    vnodeSetAccess(SVgroupAccess *pAccess, int32_t numOfVnodes);
+int32_t vnodeGetBufPoolStatis(int32_t vgId, STsdbBufPoolStatis *pStatis);
 
 // vnodeWrite
 int32_t vnodeWriteToWQueue(void *pVnode, void *pHead, int32_t qtype, void *pRpcMsg);
 void    vnodeFreeFromWQueue(void *pVnode, SVWriteMsg *pWrite);
 int32_t vnodeProcessWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+int32_t vnodeLogWrite(void *pVnode, void *pHead, int32_t qtype, void *pRspRet);
+int32_t vnodeApplyWrite(void *pVnode, void *pHead, int32_t syncCode, void *pRspRet);
 
 // vnodeSync
 void    vnodeConfirmForward(void *pVnode, uint64_t version, int32_t code, bool force);
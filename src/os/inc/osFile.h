@@ -38,6 +38,7 @@ typedef int32_t SocketFd;
 #endif
 
 int64_t taosRead(FileFd fd, void *buf, int64_t count);
+int64_t taosPRead(FileFd fd, void *buf, int64_t count, int64_t offset);  // read at offset, the file offset is unchanged
 int64_t taosWrite(FileFd fd, void *buf, int64_t count);
 
 int64_t taosLSeek(FileFd fd, int64_t offset, int32_t whence);
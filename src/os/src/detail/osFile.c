@@ -101,6 +101,43 @@ int64_t taosRead(FileFd fd, void *buf, int64_t count) {
   return count;
 }
 
+int64_t taosPRead(FileFd fd, void *buf, int64_t count, int64_t offset) {
+  int64_t leftbytes = count;
+  int64_t readbytes;
+  char *  tbuf = (char *)buf;
+
+  while (leftbytes > 0) {
+#if defined(_TD_WINDOWS_64) || defined(_TD_WINDOWS_32)
+    OVERLAPPED ov = {0};
+    DWORD      nread = 0;
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    if (!ReadFile((HANDLE)_get_osfhandle(fd), tbuf, (DWORD)leftbytes, &nread, &ov)) {
+      if (GetLastError() != ERROR_HANDLE_EOF) return -1;
+    }
+    readbytes = nread;
+#else
+    readbytes = pread(fd, (void *)tbuf, (size_t)leftbytes, (off_t)offset);
+    if (readbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else {
+        return -1;
+      }
+    }
+#endif
+    if (readbytes == 0) {
+      return (int64_t)(count - leftbytes);
+    }
+
+    leftbytes -= readbytes;
+    tbuf += readbytes;
+    offset += readbytes;
+  }
+
+  return count;
+}
+
 int64_t taosWrite(FileFd fd, void *buf, int64_t n) {
   int64_t nleft = n;
   int64_t nwritten = 0;
@@ -85,6 +85,7 @@ static int64_t parseFraction(char* str, char** end, int32_t timePrec);
 static int32_t parseTimeWithTz(char* timestr, int64_t* time, int32_t timePrec, char delim);
 static int32_t parseLocaltime(char* timestr, int64_t* time, int32_t timePrec);
 static int32_t parseLocaltimeWithDst(char* timestr, int64_t* time, int32_t timePrec);
+static int32_t parseTimeWithOffset(char* timestr, int64_t* time, int32_t timePrec, int64_t tz);
 static char* forwardToTimeStringEnd(char* str);
 static bool checkTzPresent(char *str, int32_t len);
 
@@ -93,14 +94,25 @@ static int32_t (*parseLocaltimeFp[]) (char* timestr, int64_t* time, int32_t time
   parseLocaltimeWithDst
 };
 
+// the timezone of the client whose sql is parsed by this thread, used in place of the local one
+static threadlocal bool    tsThreadTzSet = false;
+static threadlocal int64_t tsThreadTz = 0;
+
 int32_t taosGetTimestampSec() { return (int32_t)time(NULL); }
 
+void taosSetThreadTimezone(bool set, int64_t tz) {
+  tsThreadTzSet = set;
+  tsThreadTz = tz;
+}
+
 int32_t taosParseTime(char* timestr, int64_t* time, int32_t len, int32_t timePrec, int8_t day_light) {
   /* parse datatime string in with tz */
   if (strnchr(timestr, 'T', len, false) != NULL) {
     return parseTimeWithTz(timestr, time, timePrec, 'T');
   } else if (checkTzPresent(timestr, len)) {
     return parseTimeWithTz(timestr, time, timePrec, 0);
+  } else if (tsThreadTzSet) {
+    return parseTimeWithOffset(timestr, time, timePrec, tsThreadTz);
   } else {
     return (*parseLocaltimeFp[day_light])(timestr, time, timePrec);
   }
@@ -345,6 +357,32 @@ int32_t parseLocaltime(char* timestr, int64_t* time, int32_t timePrec) {
   return 0;
 }
 
+// tz is in seconds west of UTC, as the global timezone
+int32_t parseTimeWithOffset(char* timestr, int64_t* time, int32_t timePrec, int64_t tz) {
+  *time = 0;
+  struct tm tm = {0};
+
+  char* str = strptime(timestr, "%Y-%m-%d %H:%M:%S", &tm);
+  if (str == NULL) {
+    return -1;
+  }
+
+  int64_t seconds = user_mktime64(tm.tm_year+1900, tm.tm_mon+1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, tz);
+
+  int64_t fraction = 0;
+  if (*str == '.') {
+    if ((fraction = parseFraction(str + 1, &str, timePrec)) < 0) {
+      return -1;
+    }
+  }
+
+  int64_t factor = (timePrec == TSDB_TIME_PRECISION_MILLI) ? 1000 :
+                   (timePrec == TSDB_TIME_PRECISION_MICRO ? 1000000 : 1000000000);
+  *time = factor * seconds + fraction;
+
+  return 0;
+}
+
 int32_t parseLocaltimeWithDst(char* timestr, int64_t* time, int32_t timePrec) {
   *time = 0;
   struct tm tm = {0};
@@ -23,6 +23,8 @@
 #include "tscUtil.h"
 #include "tsclient.h"
 #include "dnode.h"
+#include "twal.h"
+#include "vnode.h"
 #include "monitor.h"
 #include "taoserror.h"
 
@@ -46,6 +48,9 @@ typedef enum {
   MON_CMD_CREATE_TB_DN,
   MON_CMD_CREATE_TB_ACCT_ROOT,
   MON_CMD_CREATE_TB_SLOWQUERY,
+  MON_CMD_CREATE_MT_WAL,
+  MON_CMD_CREATE_TB_WAL,
+  MON_CMD_CREATE_MT_POOL,
   MON_CMD_MAX
 } EMonCmd;
 
@@ -67,6 +72,8 @@ typedef struct {
 
 static SMonConn tsMonitor = {0};
 static void  monSaveSystemInfo();
+static void  monSaveWalInfo();
+static void  monSaveBufPoolInfo();
 static void *monThreadFunc(void *param);
 static void  monBuildMonitorSql(char *sql, int32_t cmd);
 extern int32_t (*monStartSystemFp)();
@@ -174,6 +181,8 @@ static void *monThreadFunc(void *param) {
     if (tsMonitor.state == MON_STATE_INITED) {
       if (accessTimes % tsMonitorInterval == 0) {
         monSaveSystemInfo();
+        monSaveWalInfo();
+        monSaveBufPoolInfo();
       }
     }
   }
@@ -234,6 +243,23 @@ static void monBuildMonitorSql(char *sql, int32_t cmd) {
              "create table if not exists %s.slowquery(ts timestamp, username "
              "binary(%d), created_time timestamp, time bigint, sql binary(%d))",
              tsMonitorDbName, TSDB_TABLE_FNAME_LEN - 1, TSDB_SLOW_QUERY_SQL_LEN);
+  } else if (cmd == MON_CMD_CREATE_MT_WAL) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.walinfo(ts timestamp"
+             ", batches int, records int, avg_batch_size float"
+             ", fsyncs int, avg_fsync_us float"
+             ") tags (dnodeid int, fqdn binary(%d))",
+             tsMonitorDbName, TSDB_FQDN_LEN);
+  } else if (cmd == MON_CMD_CREATE_TB_WAL) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.walinfo%d using %s.walinfo tags(%d, '%s')", tsMonitorDbName,
+             dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MON_CMD_CREATE_MT_POOL) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.mempool(ts timestamp"
+             ", block_size int, total_blocks int, free_blocks int, extra_blocks int, peak_extra_blocks int"
+             ", grows bigint, shrinks bigint, dnode_pool_mb float"
+             ") tags (dnodeid int, fqdn binary(%d), vgid int)",
+             tsMonitorDbName, TSDB_FQDN_LEN);
   } else if (cmd == MON_CMD_CREATE_TB_LOG) {
     snprintf(sql, SQL_LENGTH,
              "create table if not exists %s.log(ts timestamp, level tinyint, "
@@ -351,6 +377,60 @@ static void monSaveSystemInfo() {
   }
 }
 
+static void monSaveWalInfo() {
+  SWalStatis info = {0};
+  walGetStatis(&info);
+
+  float avgBatch = info.numOfBatches > 0 ? (float)info.numOfRecords / info.numOfBatches : 0;
+  float avgFsync = info.numOfFsyncs > 0 ? (float)info.fsyncUs / info.numOfFsyncs : 0;
+
+  char *sql = tsMonitor.sql;
+  snprintf(sql, SQL_LENGTH, "insert into %s.walinfo%d values(%" PRId64 ", %d, %d, %f, %d, %f)", tsMonitorDbName,
+           dnodeGetDnodeId(), taosGetTimestampUs(), (int32_t)info.numOfBatches, (int32_t)info.numOfRecords, avgBatch,
+           (int32_t)info.numOfFsyncs, avgFsync);
+
+  void *  res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int32_t code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monError("failed to save wal info, reason:%s, sql:%s", tstrerror(code), tsMonitor.sql);
+  } else {
+    monDebug("successfully to save wal info, sql:%s", tsMonitor.sql);
+  }
+}
+
+static void monSaveBufPoolInfo() {
+  int32_t vnodeList[TSDB_MAX_VNODES] = {0};
+  int32_t numOfVnodes = 0;
+  vnodeGetVnodeList(vnodeList, &numOfVnodes);
+  if (numOfVnodes > TSDB_MAX_VNODES) numOfVnodes = TSDB_MAX_VNODES;
+
+  int64_t ts = taosGetTimestampUs();
+  for (int32_t i = 0; i < numOfVnodes; ++i) {
+    STsdbBufPoolStatis info = {0};
+    if (vnodeGetBufPoolStatis(vnodeList[i], &info) != TSDB_CODE_SUCCESS) continue;
+
+    char *sql = tsMonitor.sql;
+    snprintf(sql, SQL_LENGTH,
+             "insert into %s.mempool%d_%d using %s.mempool tags(%d, '%s', %d) values(%" PRId64
+             ", %d, %d, %d, %d, %d, %" PRId64 ", %" PRId64 ", %f)",
+             tsMonitorDbName, dnodeGetDnodeId(), vnodeList[i], tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp,
+             vnodeList[i], ts, info.bufBlockSize, info.numOfBlocks, info.numOfFreeBlocks, info.numOfExtraBlocks,
+             info.peakExtraBlocks, info.numOfGrows, info.numOfShrinks, (float)info.dnodePoolMem / (1024 * 1024));
+
+    void *  res = taos_query(tsMonitor.conn, tsMonitor.sql);
+    int32_t code = taos_errno(res);
+    taos_free_result(res);
+
+    if (code != 0) {
+      monError("failed to save buffer pool info, reason:%s, sql:%s", tstrerror(code), tsMonitor.sql);
+    } else {
+      monDebug("successfully to save buffer pool info, sql:%s", tsMonitor.sql);
+    }
+  }
+}
+
 static void monExecSqlCb(void *param, TAOS_RES *result, int32_t code) {
   int32_t c = taos_errno(result);
   if (c != TSDB_CODE_SUCCESS) {
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QAGGKERNEL_H
+#define TDENGINE_QAGGKERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+// SIMD level of the aggregate kernels, detected from the CPU at first use
+#define AGG_SIMD_NONE 0
+#define AGG_SIMD_AVX2 1
+
+int32_t aggGetSimdLevel();
+int32_t aggSetSimdLevel(int32_t level);
+
+/*
+ * Kernels over one column of a data block. The NULL value of the data type is skipped when hasNull is true,
+ * and every kernel returns the number of values that are not NULL.
+ */
+
+// sum of an integer column. The sum wraps like the int64_t/uint64_t accumulators, so it serves both.
+int32_t aggSumInteger(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, int64_t *sum);
+
+// sum of a numeric column with every value converted to double. Lanes are summed apart, so the result of a
+// float or double column may differ from a sequential sum in the last bits.
+int32_t aggSumDouble(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, double *sum);
+
+// number of values that are not NULL, bytes is the width of one value for the non-numeric types
+int32_t aggCountNotNull(const void *pData, int32_t type, int32_t bytes, int32_t numOfRows);
+
+/*
+ * Position of the minimum or maximum value of a numeric column in *index, or -1 if all values are NULL.
+ * Ties resolve like the row by row comparison of min/max: the last minimum and the first maximum.
+ */
+int32_t aggMinMax(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, bool isMin, int32_t *index);
+
+/*
+ * The same kernels over a column with a validity bitmap, row i of pData is bit bitOffset + i of pBitmap. Words of
+ * NULL rows are skipped and the runs of valid rows are passed to the kernels above without the NULL check.
+ */
+int32_t aggSumIntegerBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap,
+                            int32_t bitOffset, int64_t *sum);
+int32_t aggSumDoubleBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap,
+                           int32_t bitOffset, double *sum);
+int32_t aggMinMaxBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap, int32_t bitOffset,
+                        bool isMin, int32_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QAGGKERNEL_H
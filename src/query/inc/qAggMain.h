@@ -168,6 +168,8 @@ typedef struct SExtTagsInfo {
 typedef struct SQLFunctionCtx {
   int32_t      size;      // number of rows
   void *       pInput;    // input data buffer
+  uint8_t *    pInputBitmap;  // validity bitmap of the input data, NULL if only the NULL values are in the data
+  int32_t      inputBitmapOffset;  // bit of the first row of pInput in pInputBitmap
   uint32_t     order;     // asc|desc
   int16_t      inputType;
   int16_t      inputBytes;
@@ -20,6 +20,7 @@
 #include "hash.h"
 #include "qAggMain.h"
 #include "qFill.h"
+#include "qHashTable.h"
 #include "qResultbuf.h"
 #include "qSqlparser.h"
 #include "qTableMeta.h"
@@ -282,8 +283,8 @@ typedef struct SQueryRuntimeEnv {
   int32_t               prevGroupId;      // previous executed group id
   bool                  enableGroupData;
   SDiskbasedResultBuf*  pResultBuf;       // query result buffer based on blocked-wised disk file
-  SHashObj*             pResultRowHashTable; // quick locate the window object for each result
-  SHashObj*             pResultRowListSet;   // used to check if current ResultRowInfo has ResultRow object or not
+  SQHashObj*            pResultRowHashTable; // quick locate the window object for each result
+  SQHashObj*            pResultRowListSet;   // used to check if current ResultRowInfo has ResultRow object or not
   char*                 keyBuf;           // window key buffer
   SResultRowPool*       pool;             // window result object pool
   char**                prevRow;
@@ -533,7 +534,7 @@ typedef struct SDistinctDataInfo {
 } SDistinctDataInfo; 
 
 typedef struct SDistinctOperatorInfo {
-  SHashObj         *pSet;
+  SQHashObj        *pSet;
   SSDataBlock      *pRes;
   bool              recordNullVal;  //has already record the null value, no need to try again
   int64_t           threshold;
@@ -565,11 +566,32 @@ typedef struct SMultiwayMergeInfo {
   bool                 multiGroupResults;
 } SMultiwayMergeInfo;
 
-// todo support the disk-based sort
+typedef struct SSortRunCursor {
+  SIDList      pageIdList;  // pages of the run, in the order of the rows
+  int32_t      pageIndex;
+  int32_t      rowIndex;    // row in the current page, -1 if the run is exhausted
+  tFilePage   *pPage;
+} SSortRunCursor;
+
+// The rows are sorted in pDataBlock as long as they fit in tsSortBufferSize. Beyond it, every capacity rows are
+// sorted and spilled as a run into pSortBuf, and the runs are merged by a loser tree into pRes. With a limit, only the
+// first limit + offset rows are kept in pDataBlock by a heap.
 typedef struct SOrderOperatorInfo {
-  int32_t      colIndex;
-  int32_t      order;
-  SSDataBlock *pDataBlock;
+  int32_t                colIndex;
+  int32_t                order;
+  SSDataBlock           *pDataBlock;
+  __compar_fn_t          comp;
+  int32_t                rowSize;    // a spilled row is the values of all columns one after another
+  int32_t                keyOffset;  // offset of the order by column in a spilled row
+  int32_t                capacity;   // maximum rows of pDataBlock
+  int32_t                topN;       // number of rows kept by the heap, 0 without limit
+  int32_t               *pHeap;      // rows of pDataBlock, the last one in the order on the top
+  int32_t                pageSize;
+  SDiskbasedResultBuf   *pSortBuf;
+  int32_t                numOfRuns;
+  SSortRunCursor        *pCursor;
+  struct SLoserTreeInfo *pTree;
+  SSDataBlock           *pRes;
 } SOrderOperatorInfo;
 
 void appendUpstream(SOperatorInfo* p, SOperatorInfo* pUpstream);
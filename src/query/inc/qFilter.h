@@ -23,6 +23,7 @@ extern "C" {
 #include "texpr.h"
 #include "hash.h"
 #include "tname.h"
+#include "tdataformat.h"
 
 #define FILTER_DEFAULT_GROUP_SIZE 4
 #define FILTER_DEFAULT_UNIT_SIZE 4
@@ -106,6 +107,7 @@ typedef struct SFilterColRange {
 typedef bool (*rangeCompFunc) (const void *, const void *, const void *, const void *, __compar_fn_t);
 typedef int32_t(*filter_desc_compare_func)(const void *, const void *);
 typedef bool(*filter_exec_func)(void *, int32_t, int8_t**, SDataStatis *, int16_t);
+typedef bool(*filter_bloom_func)(void *, int16_t, const void *, int32_t);
 
 typedef struct SFilterRangeCompare {
   int64_t s;
@@ -150,6 +152,7 @@ typedef struct SFilterField {
   uint16_t flag;
   void*    desc;
   void*    data;
+  uint8_t* bitmap;  // validity bitmap of a column field, NULL if the data only has the NULL values
 } SFilterField;
 
 typedef struct SFilterFields {
@@ -202,6 +205,7 @@ typedef struct SFilterUnit {
 
 typedef struct SFilterComUnit {
   void *colData;
+  uint8_t *colBitmap;
   void *valData;
   void *valData2;
   uint16_t colId;
@@ -297,6 +301,8 @@ typedef struct SFilterInfo {
 #define FILTER_UNIT_DATA_TYPE(u) ((u)->compare.type)
 #define FILTER_UNIT_COL_DESC(i, u) FILTER_GET_COL_FIELD_DESC(FILTER_UNIT_LEFT_FIELD(i, u))
 #define FILTER_UNIT_COL_DATA(i, u, ri) FILTER_GET_COL_FIELD_DATA(FILTER_UNIT_LEFT_FIELD(i, u), ri)
+#define FILTER_UNIT_COL_BITMAP(i, u) (FILTER_UNIT_LEFT_FIELD(i, u)->bitmap)
+#define FILTER_UNIT_COL_IS_NULL(cu, colData, ri) ((cu)->colBitmap ? !tdBitmapIsSet((cu)->colBitmap, ri) : isNull(colData, (cu)->dataType))
 #define FILTER_UNIT_COL_SIZE(i, u) FILTER_GET_COL_FIELD_SIZE(FILTER_UNIT_LEFT_FIELD(i, u))
 #define FILTER_UNIT_COL_ID(i, u) FILTER_GET_COL_FIELD_ID(FILTER_UNIT_LEFT_FIELD(i, u))
 #define FILTER_UNIT_VAL_DATA(i, u) FILTER_GET_VAL_FIELD_DATA(FILTER_UNIT_RIGHT_FIELD(i, u))
@@ -331,6 +337,7 @@ extern int32_t filterConverNcharColumns(SFilterInfo* pFilterInfo, int32_t rows,
 extern int32_t filterFreeNcharColumns(SFilterInfo* pFilterInfo);
 extern void filterFreeInfo(SFilterInfo *info);
 extern bool filterRangeExecute(SFilterInfo *info, SDataStatis *pDataStatis, int32_t numOfCols, int32_t numOfRows);
+extern bool filterBloomExecute(SFilterInfo *info, filter_bloom_func func, void *param);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_QHASHTABLE_H
+#define TDENGINE_QHASHTABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+/*
+ * Open addressing hash table of the query executor, for the result rows of group by and time windows and for the
+ * distinct values. It is used by one query thread, so there is no lock.
+ *
+ * The slots are probed linearly, and a removal shifts the following slots of the run back instead of leaving a
+ * tombstone. Keys of up to QHASH_INLINE_KEY_LEN bytes, which covers a table uid with any fixed width column value or
+ * a time window, are kept in the slot. Longer keys are copied into an arena of the table, which is only released by
+ * qHashClear or qHashCleanup. A value is at most 8 bytes, and the pointer returned by qHashGet is valid until the
+ * next put.
+ */
+#define QHASH_INLINE_KEY_LEN 24
+#define QHASH_MAX_DATA_LEN   8
+
+typedef struct SQHashSlot {
+  uint32_t hashVal;
+  uint32_t keyLen;  // 0 if the slot is empty
+  union {
+    char  key[QHASH_INLINE_KEY_LEN];
+    char *pKey;
+  } u;
+  char     data[QHASH_MAX_DATA_LEN];
+} SQHashSlot;
+
+typedef struct SQHashArena {
+  struct SQHashArena *next;
+  int32_t             size;
+  int32_t             used;
+  char                data[];
+} SQHashArena;
+
+typedef struct SQHashObj {
+  SQHashSlot  *pSlots;
+  uint32_t     capacity;  // power of 2
+  uint32_t     size;
+  SQHashArena *pArena;
+  int64_t      arenaSize;
+} SQHashObj;
+
+SQHashObj *qHashInit(size_t capacity);
+
+void *qHashGet(SQHashObj *pHashObj, const void *key, size_t keyLen);
+
+// add the key or overwrite its value, return -1 if out of memory
+int32_t qHashPut(SQHashObj *pHashObj, const void *key, size_t keyLen, const void *data, size_t dataLen);
+
+// return -1 if the key does not exist
+int32_t qHashRemove(SQHashObj *pHashObj, const void *key, size_t keyLen);
+
+void qHashClear(SQHashObj *pHashObj);
+
+size_t qHashGetSize(const SQHashObj *pHashObj);
+
+size_t qHashGetMemSize(const SQHashObj *pHashObj);
+
+void qHashCleanup(SQHashObj *pHashObj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_QHASHTABLE_H
@@ -144,6 +144,8 @@ typedef struct SQueryInfo {
   int32_t          round;         // 0/1/....
   int32_t          bufLen;
   char*            buf;
+  int16_t          numOfPartitions;  // the tables of each vgroup are split into partitions, queried by subqueries in parallel
+  int16_t          partitionIndex;
 
   bool               udfCopy;
   SArray            *pUdfInfo;
@@ -166,6 +168,7 @@ typedef struct SQueryInfo {
   bool               stateWindow;
   bool               globalMerge;
   bool               multigroupResult;
+  bool               serverMerge;  // the global merge is done by a dnode, which returns the final rows
 } SQueryInfo;
 
 /**
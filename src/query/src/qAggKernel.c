@@ -0,0 +1,698 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+
+#include "qAggKernel.h"
+#include "taosdef.h"
+#include "tdataformat.h"
+#include "ttype.h"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(WINDOWS)
+#include <immintrin.h>
+#define TD_AGG_AVX2
+#define AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#endif
+
+static int8_t tsAggSimdLevel = -1;  // -1 means not resolved yet
+
+static int32_t aggDetectSimdLevel() {
+#ifdef TD_AGG_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return AGG_SIMD_AVX2;
+#endif
+  return AGG_SIMD_NONE;
+}
+
+int32_t aggGetSimdLevel() {
+  int32_t level = atomic_load_8(&tsAggSimdLevel);
+  if (level < 0) {
+    level = aggDetectSimdLevel();
+    atomic_store_8(&tsAggSimdLevel, (int8_t)level);
+  }
+  return level;
+}
+
+int32_t aggSetSimdLevel(int32_t level) {
+  int32_t supported = aggDetectSimdLevel();
+  if (level > supported) level = supported;
+  if (level < AGG_SIMD_NONE) level = AGG_SIMD_NONE;
+  atomic_store_8(&tsAggSimdLevel, (int8_t)level);
+  return level;
+}
+
+// ---------------- SCALAR KERNELS ----------------
+// The NULL value is compared on the bits of the value, so the float and double NULL (a NaN) is found as well.
+#define IS_NULL_BITS(UT, v, nullv) ((UT)(v) == (UT)(nullv))
+
+#define SUM_INTEGER_SCALAR(T, UT, nullv)                      \
+  do {                                                        \
+    const T *d = (const T *)(pData);                          \
+    if (!(hasNull)) {                                         \
+      for (int32_t i = start; i < numOfRows; ++i) {           \
+        s += (uint64_t)(int64_t)d[i];                         \
+      }                                                       \
+      n += numOfRows - start;                                 \
+    } else {                                                  \
+      for (int32_t i = start; i < numOfRows; ++i) {           \
+        int32_t notNull = !IS_NULL_BITS(UT, d[i], nullv);     \
+        s += notNull ? (uint64_t)(int64_t)d[i] : 0;           \
+        n += notNull;                                         \
+      }                                                       \
+    }                                                         \
+  } while (0)
+
+#define SUM_DOUBLE_SCALAR(T, UT, nullv)                            \
+  do {                                                             \
+    const T * d = (const T *)(pData);                              \
+    const UT *b = (const UT *)(pData);                             \
+    if (!(hasNull)) {                                              \
+      for (int32_t i = start; i < numOfRows; ++i) {                \
+        s += (double)d[i];                                         \
+      }                                                            \
+      n += numOfRows - start;                                      \
+    } else {                                                       \
+      for (int32_t i = start; i < numOfRows; ++i) {                \
+        int32_t notNull = !IS_NULL_BITS(UT, b[i], nullv);          \
+        s += notNull ? (double)d[i] : 0;                           \
+        n += notNull;                                              \
+      }                                                            \
+    }                                                              \
+  } while (0)
+
+#define COUNT_SCALAR(UT, nullv)                          \
+  do {                                                   \
+    const UT *b = (const UT *)(pData);                   \
+    for (int32_t i = start; i < numOfRows; ++i) {        \
+      n += !IS_NULL_BITS(UT, b[i], nullv);               \
+    }                                                    \
+  } while (0)
+
+// NaN which is not the NULL value never becomes the min/max value, the same on all code paths
+#define MINMAX_SCALAR(T, UT, nullv)                                              \
+  do {                                                                           \
+    const T * d = (const T *)(pData);                                            \
+    const UT *b = (const UT *)(pData);                                           \
+    T         m = 0;                                                             \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                    \
+      if ((hasNull) && IS_NULL_BITS(UT, b[i], nullv)) continue;                  \
+      n += 1;                                                                    \
+      if (d[i] != d[i]) continue;                                                \
+      if (idx < 0 || ((isMin) ? (d[i] <= m) : (d[i] > m))) {                     \
+        m = d[i];                                                                \
+        idx = i;                                                                 \
+      }                                                                          \
+    }                                                                            \
+  } while (0)
+
+// find the position of value m found by a vector kernel, from the end for min and from the start for max
+#define MINMAX_FIND(T, UT, nullv, m)                                             \
+  do {                                                                           \
+    const T * d = (const T *)(pData);                                            \
+    const UT *b = (const UT *)(pData);                                           \
+    if (isMin) {                                                                 \
+      for (int32_t i = numOfRows - 1; i >= 0; --i) {                             \
+        if (d[i] == (m) && !((hasNull) && IS_NULL_BITS(UT, b[i], nullv))) {      \
+          idx = i;                                                               \
+          break;                                                                 \
+        }                                                                        \
+      }                                                                          \
+    } else {                                                                     \
+      for (int32_t i = 0; i < numOfRows; ++i) {                                  \
+        if (d[i] == (m) && !((hasNull) && IS_NULL_BITS(UT, b[i], nullv))) {      \
+          idx = i;                                                               \
+          break;                                                                 \
+        }                                                                        \
+      }                                                                          \
+    }                                                                            \
+  } while (0)
+
+// ---------------- AVX2 KERNELS ----------------
+#ifdef TD_AGG_AVX2
+
+AVX2_TARGET static int64_t aggHsum64(__m256i v) {
+  uint64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, v);
+  return (int64_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+
+AVX2_TARGET static double aggHsumPd(__m256d v) {
+  double lanes[4];
+  _mm256_storeu_pd(lanes, v);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+// The values are biased by 0x80 so that sad_epu8 adds them as unsigned bytes. NULL (0x80) then adds nothing.
+AVX2_TARGET static int32_t aggSumI8Avx2(const int8_t *d, int32_t rows, bool hasNull, int64_t *sum, int32_t *pn) {
+  const __m256i bias = _mm256_set1_epi8((char)0x80);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i       acc = zero;
+  int32_t       n = 0, i = 0;
+
+  for (; i + 32 <= rows; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));
+    if (hasNull) n += 32 - __builtin_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bias)));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_xor_si256(v, bias), zero));
+  }
+
+  if (!hasNull) n = i;
+  *sum = (int64_t)((uint64_t)aggHsum64(acc) - (uint64_t)128 * (hasNull ? n : i));
+  *pn = n;
+  return i;
+}
+
+AVX2_TARGET static int32_t aggSumU8Avx2(const uint8_t *d, int32_t rows, bool hasNull, int64_t *sum, int32_t *pn) {
+  const __m256i nullv = _mm256_set1_epi8((char)TSDB_DATA_UTINYINT_NULL);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i       acc = zero;
+  int32_t       n = 0, i = 0;
+
+  for (; i + 32 <= rows; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));
+    if (hasNull) {
+      __m256i isNull = _mm256_cmpeq_epi8(v, nullv);
+      n += 32 - __builtin_popcount((uint32_t)_mm256_movemask_epi8(isNull));
+      v = _mm256_andnot_si256(isNull, v);
+    }
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+  }
+
+  *sum = aggHsum64(acc);
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+#define SUM_WIDEN_AVX2(name, T, loadnull, cmpnull, widen32, widen64, step)                               \
+  AVX2_TARGET static int32_t name(const T *d, int32_t rows, bool hasNull, int64_t *sum, int32_t *pn) {   \
+    const __m128i nullv = loadnull;                                                                    \
+    __m256i       acc = _mm256_setzero_si256();                                                        \
+    int32_t       n = 0, i = 0;                                                                        \
+    for (; i + (step) <= rows; i += (step)) {                                                          \
+      __m128i v = _mm_loadu_si128((const __m128i *)(d + i));                                           \
+      if (hasNull) {                                                                                   \
+        __m128i isNull = cmpnull(v, nullv);                                                            \
+        n += (step) - __builtin_popcount((uint32_t)_mm_movemask_epi8(isNull)) / (int32_t)sizeof(T);    \
+        v = _mm_andnot_si128(isNull, v);                                                               \
+      }                                                                                                \
+      __m256i w = widen32(v);                                                                          \
+      acc = _mm256_add_epi64(acc, widen64(_mm256_castsi256_si128(w)));                                 \
+      if ((step) == 8) acc = _mm256_add_epi64(acc, widen64(_mm256_extracti128_si256(w, 1)));           \
+    }                                                                                                  \
+    *sum = aggHsum64(acc);                                                                             \
+    *pn = hasNull ? n : i;                                                                             \
+    return i;                                                                                          \
+  }
+
+#define AGG_NOP_WIDEN(v) _mm256_castsi128_si256(v)
+
+SUM_WIDEN_AVX2(aggSumI16Avx2, int16_t, _mm_set1_epi16((short)TSDB_DATA_SMALLINT_NULL), _mm_cmpeq_epi16,
+               _mm256_cvtepi16_epi32, _mm256_cvtepi32_epi64, 8)
+SUM_WIDEN_AVX2(aggSumU16Avx2, uint16_t, _mm_set1_epi16((short)TSDB_DATA_USMALLINT_NULL), _mm_cmpeq_epi16,
+               _mm256_cvtepu16_epi32, _mm256_cvtepi32_epi64, 8)
+SUM_WIDEN_AVX2(aggSumI32Avx2, int32_t, _mm_set1_epi32((int)TSDB_DATA_INT_NULL), _mm_cmpeq_epi32, AGG_NOP_WIDEN,
+               _mm256_cvtepi32_epi64, 4)
+SUM_WIDEN_AVX2(aggSumU32Avx2, uint32_t, _mm_set1_epi32((int)TSDB_DATA_UINT_NULL), _mm_cmpeq_epi32, AGG_NOP_WIDEN,
+               _mm256_cvtepu32_epi64, 4)
+
+AVX2_TARGET static int32_t aggSumI64Avx2(const int64_t *d, int32_t rows, bool hasNull, uint64_t nullBits,
+                                         int64_t *sum, int32_t *pn) {
+  const __m256i nullv = _mm256_set1_epi64x((int64_t)nullBits);
+  __m256i       acc = _mm256_setzero_si256();
+  int32_t       n = 0, i = 0;
+
+  for (; i + 4 <= rows; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));
+    if (hasNull) {
+      __m256i isNull = _mm256_cmpeq_epi64(v, nullv);
+      n += 4 - __builtin_popcount((uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(isNull)));
+      v = _mm256_andnot_si256(isNull, v);
+    }
+    acc = _mm256_add_epi64(acc, v);
+  }
+
+  *sum = aggHsum64(acc);
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+// two accumulators hide the latency of the floating point add
+AVX2_TARGET static int32_t aggSumFloatAvx2(const float *d, int32_t rows, bool hasNull, double *sum, int32_t *pn) {
+  const __m128i nullv = _mm_set1_epi32((int)TSDB_DATA_FLOAT_NULL);
+  __m256d       acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  int32_t       n = 0, i = 0;
+
+  for (; i + 8 <= rows; i += 8) {
+    __m128i v0 = _mm_loadu_si128((const __m128i *)(d + i));
+    __m128i v1 = _mm_loadu_si128((const __m128i *)(d + i + 4));
+    if (hasNull) {
+      __m128i isNull0 = _mm_cmpeq_epi32(v0, nullv);
+      __m128i isNull1 = _mm_cmpeq_epi32(v1, nullv);
+      n += 8 - __builtin_popcount((uint32_t)(_mm_movemask_ps(_mm_castsi128_ps(isNull0)) |
+                                             (_mm_movemask_ps(_mm_castsi128_ps(isNull1)) << 4)));
+      v0 = _mm_andnot_si128(isNull0, v0);
+      v1 = _mm_andnot_si128(isNull1, v1);
+    }
+    acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm_castsi128_ps(v0)));
+    acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm_castsi128_ps(v1)));
+  }
+
+  *sum = aggHsumPd(_mm256_add_pd(acc0, acc1));
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+AVX2_TARGET static int32_t aggSumDoubleAvx2(const double *d, int32_t rows, bool hasNull, double *sum, int32_t *pn) {
+  const __m256i nullv = _mm256_set1_epi64x((int64_t)TSDB_DATA_DOUBLE_NULL);
+  __m256d       acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  int32_t       n = 0, i = 0;
+
+  for (; i + 8 <= rows; i += 8) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)(d + i));
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(d + i + 4));
+    if (hasNull) {
+      __m256i isNull0 = _mm256_cmpeq_epi64(v0, nullv);
+      __m256i isNull1 = _mm256_cmpeq_epi64(v1, nullv);
+      n += 8 - __builtin_popcount((uint32_t)(_mm256_movemask_pd(_mm256_castsi256_pd(isNull0)) |
+                                             (_mm256_movemask_pd(_mm256_castsi256_pd(isNull1)) << 4)));
+      v0 = _mm256_andnot_si256(isNull0, v0);
+      v1 = _mm256_andnot_si256(isNull1, v1);
+    }
+    acc0 = _mm256_add_pd(acc0, _mm256_castsi256_pd(v0));
+    acc1 = _mm256_add_pd(acc1, _mm256_castsi256_pd(v1));
+  }
+
+  *sum = aggHsumPd(_mm256_add_pd(acc0, acc1));
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+// count of the NULL values in 32 bytes, each value takes `bytes` bits of the byte mask
+AVX2_TARGET static int32_t aggCountNotNullAvx2(const void *pData, int32_t bytes, uint64_t nullBits, int32_t rows,
+                                               int32_t *pn) {
+  const char *d = (const char *)pData;
+  int32_t     step = 32 / bytes;
+  int32_t     nullBytes = 0, i = 0;
+  __m256i     nullv;
+
+  switch (bytes) {
+    case 1: nullv = _mm256_set1_epi8((char)nullBits); break;
+    case 2: nullv = _mm256_set1_epi16((short)nullBits); break;
+    case 4: nullv = _mm256_set1_epi32((int)nullBits); break;
+    default: nullv = _mm256_set1_epi64x((int64_t)nullBits); break;
+  }
+
+  for (; i + step <= rows; i += step) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(d + (size_t)i * bytes));
+    __m256i isNull;
+    switch (bytes) {
+      case 1: isNull = _mm256_cmpeq_epi8(v, nullv); break;
+      case 2: isNull = _mm256_cmpeq_epi16(v, nullv); break;
+      case 4: isNull = _mm256_cmpeq_epi32(v, nullv); break;
+      default: isNull = _mm256_cmpeq_epi64(v, nullv); break;
+    }
+    nullBytes += __builtin_popcount((uint32_t)_mm256_movemask_epi8(isNull));
+  }
+
+  *pn = i - nullBytes / bytes;
+  return i;
+}
+
+/*
+ * First pass of min/max: the extreme value of the vector part, NULL replaced by a value that never wins. For the
+ * signed max and unsigned min the NULL value is already the one that never wins.
+ */
+#define MINMAX_INT_AVX2(name, T, set1, cmpeq, vmin, vmax, tmax, tmin, nullv, step)                                 \
+  AVX2_TARGET static int32_t name(const T *d, int32_t rows, bool hasNull, bool isMin, T *pm, int32_t *pn) {       \
+    const __m256i vnull = set1((T)(nullv));                                                                      \
+    const __m256i vnone = set1(isMin ? (T)(tmax) : (T)(tmin));                                                   \
+    __m256i       acc = vnone;                                                                                   \
+    int32_t       n = 0, i = 0;                                                                                  \
+    for (; i + (step) <= rows; i += (step)) {                                                                    \
+      __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));                                                  \
+      if (hasNull) {                                                                                             \
+        __m256i isNull = cmpeq(v, vnull);                                                                        \
+        n += (step) - __builtin_popcount((uint32_t)_mm256_movemask_epi8(isNull)) / (int32_t)sizeof(T);           \
+        v = _mm256_blendv_epi8(v, vnone, isNull);                                                                \
+      }                                                                                                          \
+      acc = isMin ? vmin(acc, v) : vmax(acc, v);                                                                 \
+    }                                                                                                            \
+    T lanes[step];                                                                                               \
+    _mm256_storeu_si256((__m256i *)lanes, acc);                                                                  \
+    T m = lanes[0];                                                                                              \
+    for (int32_t j = 1; j < (step); ++j) {                                                                       \
+      if (isMin ? (lanes[j] < m) : (lanes[j] > m)) m = lanes[j];                                                 \
+    }                                                                                                            \
+    *pm = m;                                                                                                     \
+    *pn = hasNull ? n : i;                                                                                       \
+    return i;                                                                                                    \
+  }
+
+#define AGG_SET1_I8(v)  _mm256_set1_epi8((char)(v))
+#define AGG_SET1_I16(v) _mm256_set1_epi16((short)(v))
+#define AGG_SET1_I32(v) _mm256_set1_epi32((int)(v))
+
+MINMAX_INT_AVX2(aggMinMaxI8Avx2, int8_t, AGG_SET1_I8, _mm256_cmpeq_epi8, _mm256_min_epi8, _mm256_max_epi8, INT8_MAX,
+                INT8_MIN, TSDB_DATA_TINYINT_NULL, 32)
+MINMAX_INT_AVX2(aggMinMaxU8Avx2, uint8_t, AGG_SET1_I8, _mm256_cmpeq_epi8, _mm256_min_epu8, _mm256_max_epu8, UINT8_MAX,
+                0, TSDB_DATA_UTINYINT_NULL, 32)
+MINMAX_INT_AVX2(aggMinMaxI16Avx2, int16_t, AGG_SET1_I16, _mm256_cmpeq_epi16, _mm256_min_epi16, _mm256_max_epi16,
+                INT16_MAX, INT16_MIN, TSDB_DATA_SMALLINT_NULL, 16)
+MINMAX_INT_AVX2(aggMinMaxU16Avx2, uint16_t, AGG_SET1_I16, _mm256_cmpeq_epi16, _mm256_min_epu16, _mm256_max_epu16,
+                UINT16_MAX, 0, TSDB_DATA_USMALLINT_NULL, 16)
+MINMAX_INT_AVX2(aggMinMaxI32Avx2, int32_t, AGG_SET1_I32, _mm256_cmpeq_epi32, _mm256_min_epi32, _mm256_max_epi32,
+                INT32_MAX, INT32_MIN, TSDB_DATA_INT_NULL, 8)
+MINMAX_INT_AVX2(aggMinMaxU32Avx2, uint32_t, AGG_SET1_I32, _mm256_cmpeq_epi32, _mm256_min_epu32, _mm256_max_epu32,
+                UINT32_MAX, 0, TSDB_DATA_UINT_NULL, 8)
+
+// min_ps/max_ps return the second operand when one is NaN, so NaN in the data never replaces the accumulator
+AVX2_TARGET static int32_t aggMinMaxFloatAvx2(const float *d, int32_t rows, bool hasNull, bool isMin, float *pm,
+                                              int32_t *pn) {
+  const __m256i vnull = _mm256_set1_epi32((int)TSDB_DATA_FLOAT_NULL);
+  const __m256  vnone = _mm256_set1_ps(isMin ? INFINITY : -INFINITY);
+  __m256        acc = vnone;
+  int32_t       n = 0, i = 0;
+
+  for (; i + 8 <= rows; i += 8) {
+    __m256 v = _mm256_loadu_ps(d + i);
+    if (hasNull) {
+      __m256i isNull = _mm256_cmpeq_epi32(_mm256_castps_si256(v), vnull);
+      n += 8 - __builtin_popcount((uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(isNull)));
+      v = _mm256_blendv_ps(v, vnone, _mm256_castsi256_ps(isNull));
+    }
+    acc = isMin ? _mm256_min_ps(v, acc) : _mm256_max_ps(v, acc);
+  }
+
+  float lanes[8];
+  _mm256_storeu_ps(lanes, acc);
+  float m = lanes[0];
+  for (int32_t j = 1; j < 8; ++j) {
+    if (isMin ? (lanes[j] < m) : (lanes[j] > m)) m = lanes[j];
+  }
+
+  *pm = m;
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+AVX2_TARGET static int32_t aggMinMaxDoubleAvx2(const double *d, int32_t rows, bool hasNull, bool isMin, double *pm,
+                                               int32_t *pn) {
+  const __m256i vnull = _mm256_set1_epi64x((int64_t)TSDB_DATA_DOUBLE_NULL);
+  const __m256d vnone = _mm256_set1_pd(isMin ? INFINITY : -INFINITY);
+  __m256d       acc = vnone;
+  int32_t       n = 0, i = 0;
+
+  for (; i + 4 <= rows; i += 4) {
+    __m256d v = _mm256_loadu_pd(d + i);
+    if (hasNull) {
+      __m256i isNull = _mm256_cmpeq_epi64(_mm256_castpd_si256(v), vnull);
+      n += 4 - __builtin_popcount((uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(isNull)));
+      v = _mm256_blendv_pd(v, vnone, _mm256_castsi256_pd(isNull));
+    }
+    acc = isMin ? _mm256_min_pd(v, acc) : _mm256_max_pd(v, acc);
+  }
+
+  double lanes[4];
+  _mm256_storeu_pd(lanes, acc);
+  double m = lanes[0];
+  for (int32_t j = 1; j < 4; ++j) {
+    if (isMin ? (lanes[j] < m) : (lanes[j] > m)) m = lanes[j];
+  }
+
+  *pm = m;
+  *pn = hasNull ? n : i;
+  return i;
+}
+
+#endif  // TD_AGG_AVX2
+
+// ---------------- KERNEL ENTRIES ----------------
+int32_t aggSumInteger(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, int64_t *sum) {
+  uint64_t s = 0;
+  int32_t  n = 0;
+  int32_t  start = 0;
+
+#ifdef TD_AGG_AVX2
+  if (aggGetSimdLevel() >= AGG_SIMD_AVX2) {
+    int64_t vs = 0;
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT: start = aggSumI8Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_UTINYINT: start = aggSumU8Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_SMALLINT: start = aggSumI16Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_USMALLINT: start = aggSumU16Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_INT: start = aggSumI32Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_UINT: start = aggSumU32Avx2(pData, numOfRows, hasNull, &vs, &n); break;
+      case TSDB_DATA_TYPE_BIGINT:
+        start = aggSumI64Avx2(pData, numOfRows, hasNull, TSDB_DATA_BIGINT_NULL, &vs, &n);
+        break;
+      case TSDB_DATA_TYPE_UBIGINT:
+        start = aggSumI64Avx2(pData, numOfRows, hasNull, TSDB_DATA_UBIGINT_NULL, &vs, &n);
+        break;
+      default: break;
+    }
+    s = (uint64_t)vs;
+  }
+#endif
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: SUM_INTEGER_SCALAR(int8_t, uint8_t, TSDB_DATA_TINYINT_NULL); break;
+    case TSDB_DATA_TYPE_UTINYINT: SUM_INTEGER_SCALAR(uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL); break;
+    case TSDB_DATA_TYPE_SMALLINT: SUM_INTEGER_SCALAR(int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_USMALLINT: SUM_INTEGER_SCALAR(uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_INT: SUM_INTEGER_SCALAR(int32_t, uint32_t, TSDB_DATA_INT_NULL); break;
+    case TSDB_DATA_TYPE_UINT: SUM_INTEGER_SCALAR(uint32_t, uint32_t, TSDB_DATA_UINT_NULL); break;
+    case TSDB_DATA_TYPE_BIGINT: SUM_INTEGER_SCALAR(int64_t, uint64_t, TSDB_DATA_BIGINT_NULL); break;
+    case TSDB_DATA_TYPE_UBIGINT: SUM_INTEGER_SCALAR(uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL); break;
+    default: assert(0);
+  }
+
+  *sum = (int64_t)s;
+  return n;
+}
+
+int32_t aggSumDouble(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, double *sum) {
+  double  s = 0;
+  int32_t n = 0;
+  int32_t start = 0;
+
+#ifdef TD_AGG_AVX2
+  if (aggGetSimdLevel() >= AGG_SIMD_AVX2) {
+    if (type == TSDB_DATA_TYPE_FLOAT) {
+      start = aggSumFloatAvx2(pData, numOfRows, hasNull, &s, &n);
+    } else if (type == TSDB_DATA_TYPE_DOUBLE) {
+      start = aggSumDoubleAvx2(pData, numOfRows, hasNull, &s, &n);
+    }
+  }
+#endif
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: SUM_DOUBLE_SCALAR(int8_t, uint8_t, TSDB_DATA_TINYINT_NULL); break;
+    case TSDB_DATA_TYPE_UTINYINT: SUM_DOUBLE_SCALAR(uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL); break;
+    case TSDB_DATA_TYPE_SMALLINT: SUM_DOUBLE_SCALAR(int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_USMALLINT: SUM_DOUBLE_SCALAR(uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_INT: SUM_DOUBLE_SCALAR(int32_t, uint32_t, TSDB_DATA_INT_NULL); break;
+    case TSDB_DATA_TYPE_UINT: SUM_DOUBLE_SCALAR(uint32_t, uint32_t, TSDB_DATA_UINT_NULL); break;
+    case TSDB_DATA_TYPE_BIGINT: SUM_DOUBLE_SCALAR(int64_t, uint64_t, TSDB_DATA_BIGINT_NULL); break;
+    case TSDB_DATA_TYPE_UBIGINT: SUM_DOUBLE_SCALAR(uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL); break;
+    case TSDB_DATA_TYPE_FLOAT: SUM_DOUBLE_SCALAR(float, uint32_t, TSDB_DATA_FLOAT_NULL); break;
+    case TSDB_DATA_TYPE_DOUBLE: SUM_DOUBLE_SCALAR(double, uint64_t, TSDB_DATA_DOUBLE_NULL); break;
+    default: assert(0);
+  }
+
+  *sum = s;
+  return n;
+}
+
+int32_t aggCountNotNull(const void *pData, int32_t type, int32_t bytes, int32_t numOfRows) {
+  uint64_t nullBits = 0;
+  int32_t  n = 0;
+  int32_t  start = 0;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: nullBits = TSDB_DATA_TINYINT_NULL; break;
+    case TSDB_DATA_TYPE_UTINYINT: nullBits = TSDB_DATA_UTINYINT_NULL; break;
+    case TSDB_DATA_TYPE_SMALLINT: nullBits = TSDB_DATA_SMALLINT_NULL; break;
+    case TSDB_DATA_TYPE_USMALLINT: nullBits = TSDB_DATA_USMALLINT_NULL; break;
+    case TSDB_DATA_TYPE_INT: nullBits = TSDB_DATA_INT_NULL; break;
+    case TSDB_DATA_TYPE_UINT: nullBits = TSDB_DATA_UINT_NULL; break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: nullBits = TSDB_DATA_BIGINT_NULL; break;
+    case TSDB_DATA_TYPE_UBIGINT: nullBits = TSDB_DATA_UBIGINT_NULL; break;
+    case TSDB_DATA_TYPE_FLOAT: nullBits = TSDB_DATA_FLOAT_NULL; break;
+    case TSDB_DATA_TYPE_DOUBLE: nullBits = TSDB_DATA_DOUBLE_NULL; break;
+    default: {
+      // bool and the var length types keep their NULL flag in a different place
+      const char *d = (const char *)pData;
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        n += !isNull(d + (size_t)i * bytes, type);
+      }
+      return n;
+    }
+  }
+
+#ifdef TD_AGG_AVX2
+  if (aggGetSimdLevel() >= AGG_SIMD_AVX2) {
+    start = aggCountNotNullAvx2(pData, bytes, nullBits, numOfRows, &n);
+  }
+#endif
+
+  switch (bytes) {
+    case 1: COUNT_SCALAR(uint8_t, nullBits); break;
+    case 2: COUNT_SCALAR(uint16_t, nullBits); break;
+    case 4: COUNT_SCALAR(uint32_t, nullBits); break;
+    default: COUNT_SCALAR(uint64_t, nullBits); break;
+  }
+
+  return n;
+}
+
+int32_t aggMinMax(const void *pData, int32_t type, int32_t numOfRows, bool hasNull, bool isMin, int32_t *index) {
+  int32_t idx = -1;
+  int32_t n = 0;
+
+#ifdef TD_AGG_AVX2
+  // AVX2 has no 64 bit integer min/max, emulating it and searching the index in a second pass is slower than the
+  // single scalar pass
+  if (aggGetSimdLevel() >= AGG_SIMD_AVX2 && type != TSDB_DATA_TYPE_BIGINT && type != TSDB_DATA_TYPE_UBIGINT) {
+    // the vector pass finds the value, the tail is folded into it and a second pass finds where it is
+#define MINMAX_VECTOR(fn, T, UT, nullv)                                                        \
+  do {                                                                                         \
+    T        _m = 0;                                                                           \
+    int32_t  _k = fn(pData, numOfRows, hasNull, isMin, &_m, &n);                               \
+    const T *_d = (const T *)(pData);                                                          \
+    for (; _k < numOfRows; ++_k) {                                                             \
+      if (hasNull && IS_NULL_BITS(UT, ((const UT *)(pData))[_k], nullv)) continue;             \
+      n += 1;                                                                                  \
+      if (isMin ? (_d[_k] < _m) : (_d[_k] > _m)) _m = _d[_k];                                  \
+    }                                                                                          \
+    if (n > 0) MINMAX_FIND(T, UT, nullv, _m);                                                  \
+  } while (0)
+
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT: MINMAX_VECTOR(aggMinMaxI8Avx2, int8_t, uint8_t, TSDB_DATA_TINYINT_NULL); break;
+      case TSDB_DATA_TYPE_UTINYINT: MINMAX_VECTOR(aggMinMaxU8Avx2, uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL); break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        MINMAX_VECTOR(aggMinMaxI16Avx2, int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL);
+        break;
+      case TSDB_DATA_TYPE_USMALLINT:
+        MINMAX_VECTOR(aggMinMaxU16Avx2, uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL);
+        break;
+      case TSDB_DATA_TYPE_INT: MINMAX_VECTOR(aggMinMaxI32Avx2, int32_t, uint32_t, TSDB_DATA_INT_NULL); break;
+      case TSDB_DATA_TYPE_UINT: MINMAX_VECTOR(aggMinMaxU32Avx2, uint32_t, uint32_t, TSDB_DATA_UINT_NULL); break;
+      case TSDB_DATA_TYPE_FLOAT: MINMAX_VECTOR(aggMinMaxFloatAvx2, float, uint32_t, TSDB_DATA_FLOAT_NULL); break;
+      case TSDB_DATA_TYPE_DOUBLE:
+        MINMAX_VECTOR(aggMinMaxDoubleAvx2, double, uint64_t, TSDB_DATA_DOUBLE_NULL);
+        break;
+      default: assert(0);
+    }
+
+#undef MINMAX_VECTOR
+    *index = idx;
+    return n;
+  }
+#endif
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: MINMAX_SCALAR(int8_t, uint8_t, TSDB_DATA_TINYINT_NULL); break;
+    case TSDB_DATA_TYPE_UTINYINT: MINMAX_SCALAR(uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL); break;
+    case TSDB_DATA_TYPE_SMALLINT: MINMAX_SCALAR(int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_USMALLINT: MINMAX_SCALAR(uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL); break;
+    case TSDB_DATA_TYPE_INT: MINMAX_SCALAR(int32_t, uint32_t, TSDB_DATA_INT_NULL); break;
+    case TSDB_DATA_TYPE_UINT: MINMAX_SCALAR(uint32_t, uint32_t, TSDB_DATA_UINT_NULL); break;
+    case TSDB_DATA_TYPE_BIGINT: MINMAX_SCALAR(int64_t, uint64_t, TSDB_DATA_BIGINT_NULL); break;
+    case TSDB_DATA_TYPE_UBIGINT: MINMAX_SCALAR(uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL); break;
+    case TSDB_DATA_TYPE_FLOAT: MINMAX_SCALAR(float, uint32_t, TSDB_DATA_FLOAT_NULL); break;
+    case TSDB_DATA_TYPE_DOUBLE: MINMAX_SCALAR(double, uint64_t, TSDB_DATA_DOUBLE_NULL); break;
+    default: assert(0);
+  }
+
+  *index = idx;
+  return n;
+}
+
+// ---------------- KERNELS OVER A VALIDITY BITMAP ----------------
+#define FOR_EACH_VALID_RUN(pBitmap, bitOffset, numOfRows, s, e)                                   \
+  for (int32_t s = tdBitmapFind(pBitmap, bitOffset, (bitOffset) + (numOfRows), true), e = 0;      \
+       s < (bitOffset) + (numOfRows) &&                                                           \
+       ((e = tdBitmapFind(pBitmap, s, (bitOffset) + (numOfRows), false)), true);                  \
+       s = tdBitmapFind(pBitmap, e, (bitOffset) + (numOfRows), true))
+
+int32_t aggSumIntegerBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap,
+                            int32_t bitOffset, int64_t *sum) {
+  int32_t  bytes = tDataTypes[type].bytes;
+  uint64_t s = 0;
+  int32_t  n = 0;
+
+  FOR_EACH_VALID_RUN(pBitmap, bitOffset, numOfRows, start, end) {
+    int64_t rs = 0;
+    n += aggSumInteger(POINTER_SHIFT(pData, (start - bitOffset) * bytes), type, end - start, false, &rs);
+    s += (uint64_t)rs;
+  }
+
+  *sum = (int64_t)s;
+  return n;
+}
+
+int32_t aggSumDoubleBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap,
+                           int32_t bitOffset, double *sum) {
+  int32_t bytes = tDataTypes[type].bytes;
+  double  s = 0;
+  int32_t n = 0;
+
+  FOR_EACH_VALID_RUN(pBitmap, bitOffset, numOfRows, start, end) {
+    double rs = 0;
+    n += aggSumDouble(POINTER_SHIFT(pData, (start - bitOffset) * bytes), type, end - start, false, &rs);
+    s += rs;
+  }
+
+  *sum = s;
+  return n;
+}
+
+// whether row a replaces row b as the result, with the same ties as aggMinMax
+#define MINMAX_BETTER(T) (isMin ? (((const T *)pData)[a] <= ((const T *)pData)[b]) : (((const T *)pData)[a] > ((const T *)pData)[b]))
+
+static bool aggMinMaxBetter(const void *pData, int32_t type, int32_t a, int32_t b, bool isMin) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: return MINMAX_BETTER(int8_t);
+    case TSDB_DATA_TYPE_UTINYINT: return MINMAX_BETTER(uint8_t);
+    case TSDB_DATA_TYPE_SMALLINT: return MINMAX_BETTER(int16_t);
+    case TSDB_DATA_TYPE_USMALLINT: return MINMAX_BETTER(uint16_t);
+    case TSDB_DATA_TYPE_INT: return MINMAX_BETTER(int32_t);
+    case TSDB_DATA_TYPE_UINT: return MINMAX_BETTER(uint32_t);
+    case TSDB_DATA_TYPE_BIGINT: return MINMAX_BETTER(int64_t);
+    case TSDB_DATA_TYPE_UBIGINT: return MINMAX_BETTER(uint64_t);
+    case TSDB_DATA_TYPE_FLOAT: return MINMAX_BETTER(float);
+    case TSDB_DATA_TYPE_DOUBLE: return MINMAX_BETTER(double);
+    default: assert(0); return false;
+  }
+}
+
+int32_t aggMinMaxBitmap(const void *pData, int32_t type, int32_t numOfRows, const uint8_t *pBitmap, int32_t bitOffset,
+                        bool isMin, int32_t *index) {
+  int32_t bytes = tDataTypes[type].bytes;
+  int32_t idx = -1;
+  int32_t n = 0;
+
+  FOR_EACH_VALID_RUN(pBitmap, bitOffset, numOfRows, start, end) {
+    int32_t k = -1;
+    n += aggMinMax(POINTER_SHIFT(pData, (start - bitOffset) * bytes), type, end - start, false, isMin, &k);
+    if (k < 0) continue;  // NaN only
+
+    k += start - bitOffset;
+    if (idx < 0 || aggMinMaxBetter(pData, type, k, idx, isMin)) idx = k;
+  }
+
+  *index = idx;
+  return n;
+}
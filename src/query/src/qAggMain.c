@@ -22,6 +22,7 @@
 #include "tglobal.h"
 
 #include "qAggMain.h"
+#include "qAggKernel.h"
 #include "qFill.h"
 #include "qHistogram.h"
 #include "qPercentile.h"
@@ -445,6 +446,25 @@ static void function_finalizer(SQLFunctionCtx *pCtx) {
   doFinalizer(pCtx);
 }
 
+// an input with a validity bitmap skips the NULL rows by the bitmap instead of checking the value of each row
+#define INPUT_HAS_BITMAP(ctx) ((ctx)->hasNull && (ctx)->pInputBitmap != NULL)
+
+static int32_t sumIntegerOfInput(SQLFunctionCtx *pCtx, int64_t *sum) {
+  if (INPUT_HAS_BITMAP(pCtx)) {
+    return aggSumIntegerBitmap(GET_INPUT_DATA_LIST(pCtx), pCtx->inputType, pCtx->size, pCtx->pInputBitmap,
+                               pCtx->inputBitmapOffset, sum);
+  }
+  return aggSumInteger(GET_INPUT_DATA_LIST(pCtx), pCtx->inputType, pCtx->size, pCtx->hasNull, sum);
+}
+
+static int32_t sumDoubleOfInput(SQLFunctionCtx *pCtx, double *sum) {
+  if (INPUT_HAS_BITMAP(pCtx)) {
+    return aggSumDoubleBitmap(GET_INPUT_DATA_LIST(pCtx), pCtx->inputType, pCtx->size, pCtx->pInputBitmap,
+                              pCtx->inputBitmapOffset, sum);
+  }
+  return aggSumDouble(GET_INPUT_DATA_LIST(pCtx), pCtx->inputType, pCtx->size, pCtx->hasNull, sum);
+}
+
 /*
  * count function does need the finalize, if data is missing, the default value, which is 0, is used
  * count function does not use the pCtx->interResBuf to keep the intermediate buffer
@@ -460,15 +480,10 @@ static void count_function(SQLFunctionCtx *pCtx) {
   if (pCtx->preAggVals.isSet) {
     numOfElem = pCtx->size - pCtx->preAggVals.statis.numOfNull;
   } else {
-    if (pCtx->hasNull) {
-      for (int32_t i = 0; i < pCtx->size; ++i) {
-        char *val = GET_INPUT_DATA(pCtx, i);
-        if (isNull(val, pCtx->inputType)) {
-          continue;
-        }
-        
-        numOfElem += 1;
-      }
+    if (INPUT_HAS_BITMAP(pCtx)) {
+      numOfElem = tdBitmapCount(pCtx->pInputBitmap, pCtx->inputBitmapOffset, pCtx->size);
+    } else if (pCtx->hasNull) {
+      numOfElem = aggCountNotNull(GET_INPUT_DATA_LIST(pCtx), pCtx->inputType, pCtx->inputBytes, pCtx->size);
     } else {
       //when counting on the primary time stamp column and no statistics data is presented, use the size value directly.
       numOfElem = pCtx->size;
@@ -484,10 +499,9 @@ static void count_function(SQLFunctionCtx *pCtx) {
 }
 
 static void count_func_merge(SQLFunctionCtx *pCtx) {
-  int64_t *pData = (int64_t *)GET_INPUT_DATA_LIST(pCtx);
-  for (int32_t i = 0; i < pCtx->size; ++i) {
-    *((int64_t *)pCtx->pOutput) += pData[i];
-  }
+  int64_t sum = 0;
+  aggSumInteger(GET_INPUT_DATA_LIST(pCtx), TSDB_DATA_TYPE_BIGINT, pCtx->size, false, &sum);
+  *((int64_t *)pCtx->pOutput) += sum;
   
   SET_VAL(pCtx, pCtx->size, 1);
 }
@@ -512,41 +526,6 @@ int32_t countRequired(SQLFunctionCtx *pCtx, STimeWindow* w, int32_t colId) {
 int32_t noDataRequired(SQLFunctionCtx *pCtx, STimeWindow* w, int32_t colId) {
   return BLK_DATA_NO_NEEDED;
 }
-#define LIST_ADD_N_DOUBLE_FLOAT(x, ctx, p, t, numOfElem, tsdbType)              \
-  do {                                                                \
-    t *d = (t *)(p);                                               \
-    for (int32_t i = 0; i < (ctx)->size; ++i) {                    \
-      if (((ctx)->hasNull) && isNull((char *)&(d)[i], tsdbType)) { \
-        continue;                                                  \
-      };                                                           \
-      SET_DOUBLE_VAL(&(x) , GET_DOUBLE_VAL(&(x)) + GET_FLOAT_VAL(&(d)[i]));                                               \
-      (numOfElem)++;                                               \
-    }                                                              \
-  } while(0)
-#define LIST_ADD_N_DOUBLE(x, ctx, p, t, numOfElem, tsdbType)              \
-  do {                                                                \
-    t *d = (t *)(p);                                               \
-    for (int32_t i = 0; i < (ctx)->size; ++i) {                    \
-      if (((ctx)->hasNull) && isNull((char *)&(d)[i], tsdbType)) { \
-        continue;                                                  \
-      };                                                           \
-      SET_DOUBLE_VAL(&(x) , (x) + (d)[i]);                                               \
-      (numOfElem)++;                                               \
-    }                                                              \
-  } while(0)
-
-#define LIST_ADD_N(x, ctx, p, t, numOfElem, tsdbType)              \
-  do {                                                                \
-    t *d = (t *)(p);                                               \
-    for (int32_t i = 0; i < (ctx)->size; ++i) {                    \
-      if (((ctx)->hasNull) && isNull((char *)&(d)[i], tsdbType)) { \
-        continue;                                                  \
-      };                                                           \
-      (x) += (d)[i];                                               \
-      (numOfElem)++;                                               \
-    }                                                              \
-  } while(0)
-
 #define UPDATE_DATA(ctx, left, right, num, sign, k) \
   do {                                              \
     if (((left) < (right)) ^ (sign)) {              \
@@ -565,20 +544,14 @@ int32_t noDataRequired(SQLFunctionCtx *pCtx, STimeWindow* w, int32_t colId) {
     }                                                       \
   } while (0)
 
-#define LOOPCHECK_N(val, list, ctx, tsdbType, sign, num)          \
-  for (int32_t i = 0; i < ((ctx)->size); ++i) {                   \
-    if ((ctx)->hasNull && isNull((char *)&(list)[i], tsdbType)) { \
-      continue;                                                   \
-    }                                                             \
-    TSKEY key = (ctx)->ptsList != NULL? GET_TS_DATA(ctx, i):0;    \
-    UPDATE_DATA(ctx, val, (list)[i], num, sign, key);             \
-  }
-
-#define TYPED_LOOPCHECK_N(type, data, list, ctx, tsdbType, sign, notNullElems) \
-  do {                                                                         \
-    type *_data = (type *)data;                                                \
-    type *_list = (type *)list;                                                \
-    LOOPCHECK_N(*_data, _list, ctx, tsdbType, sign, notNullElems);             \
+// update the min/max result by the value at position index of the input column
+#define UPDATE_MINMAX_AT(ctx, type, output, input, index, sign, k) \
+  do {                                                             \
+    type _v = ((type *)(input))[(index)];                          \
+    if ((*(type *)(output) < _v) ^ (sign)) {                       \
+      *(type *)(output) = _v;                                      \
+      DO_UPDATE_TAG_COLUMNS(ctx, k);                               \
+    }                                                              \
   } while (0)
 
 static void do_sum(SQLFunctionCtx *pCtx) {
@@ -600,39 +573,19 @@ static void do_sum(SQLFunctionCtx *pCtx) {
       SET_DOUBLE_VAL(retVal, *retVal + GET_DOUBLE_VAL((const char*)&(pCtx->preAggVals.statis.sum)));
     }
   } else {  // computing based on the true data block
-    void *pData = GET_INPUT_DATA_LIST(pCtx);
-    notNullElems = 0;
-
     if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
-      int64_t *retVal = (int64_t *)pCtx->pOutput;
-
-      if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, int8_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_SMALLINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, int16_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_INT) {
-        LIST_ADD_N(*retVal, pCtx, pData, int32_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_BIGINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, int64_t, notNullElems, pCtx->inputType);
-      }
+      int64_t sum = 0;
+      notNullElems = sumIntegerOfInput(pCtx, &sum);
+      *(int64_t *)pCtx->pOutput += sum;
     } else if (IS_UNSIGNED_NUMERIC_TYPE(pCtx->inputType)) {
-      uint64_t *retVal = (uint64_t *)pCtx->pOutput;
-
-      if (pCtx->inputType == TSDB_DATA_TYPE_UTINYINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, uint8_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_USMALLINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, uint16_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_UINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, uint32_t, notNullElems, pCtx->inputType);
-      } else if (pCtx->inputType == TSDB_DATA_TYPE_UBIGINT) {
-        LIST_ADD_N(*retVal, pCtx, pData, uint64_t, notNullElems, pCtx->inputType);
-      }
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_DOUBLE) {
-      double *retVal = (double *)pCtx->pOutput;
-      LIST_ADD_N_DOUBLE(*retVal, pCtx, pData, double, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_FLOAT) {
+      int64_t sum = 0;
+      notNullElems = sumIntegerOfInput(pCtx, &sum);
+      *(uint64_t *)pCtx->pOutput += (uint64_t)sum;
+    } else if (IS_FLOAT_TYPE(pCtx->inputType)) {
       double *retVal = (double *)pCtx->pOutput;
-      LIST_ADD_N_DOUBLE_FLOAT(*retVal, pCtx, pData, float, notNullElems, pCtx->inputType);
+      double  sum = 0;
+      notNullElems = sumDoubleOfInput(pCtx, &sum);
+      SET_DOUBLE_VAL(retVal, *retVal + sum);
     }
   }
   
@@ -662,22 +615,28 @@ static void sum_func_merge(SQLFunctionCtx *pCtx) {
   GET_TRUE_DATA_TYPE();
   assert(pCtx->stableQuery);
 
-  for (int32_t i = 0; i < pCtx->size; ++i) {
-    char *    input = GET_INPUT_DATA(pCtx, i);
-    SSumInfo *pInput = (SSumInfo *)input;
-    if (pInput->hasResult != DATA_SET_FLAG) {
-      continue;
+  // isum and usum share the bits of one 64 bit integer sum, dsum is only used for the float types
+  char *input = GET_INPUT_DATA_LIST(pCtx);
+  if (IS_FLOAT_TYPE(type)) {
+    double sum = 0;
+    for (int32_t i = 0; i < pCtx->size; ++i, input += pCtx->inputBytes) {
+      SSumInfo *pInput = (SSumInfo *)input;
+      if (pInput->hasResult == DATA_SET_FLAG) {
+        sum += pInput->dsum;
+        notNullElems++;
+      }
     }
-
-    notNullElems++;
-
-    if (IS_SIGNED_NUMERIC_TYPE(type)) {
-      *(int64_t *)pCtx->pOutput += pInput->isum;
-    } else if (IS_UNSIGNED_NUMERIC_TYPE(type)) {
-      *(uint64_t *) pCtx->pOutput += pInput->usum;
-    } else {
-      SET_DOUBLE_VAL((double *)pCtx->pOutput, *(double *)pCtx->pOutput + pInput->dsum);
+    SET_DOUBLE_VAL((double *)pCtx->pOutput, *(double *)pCtx->pOutput + sum);
+  } else {
+    uint64_t sum = 0;
+    for (int32_t i = 0; i < pCtx->size; ++i, input += pCtx->inputBytes) {
+      SSumInfo *pInput = (SSumInfo *)input;
+      if (pInput->hasResult == DATA_SET_FLAG) {
+        sum += pInput->usum;
+        notNullElems++;
+      }
     }
+    *(uint64_t *)pCtx->pOutput += sum;
   }
 
   SET_VAL(pCtx, notNullElems, 1);
@@ -789,28 +748,20 @@ static void avg_function(SQLFunctionCtx *pCtx) {
       *pVal += GET_DOUBLE_VAL((const char *)&(pCtx->preAggVals.statis.sum));
     }
   } else {
-    void *pData = GET_INPUT_DATA_LIST(pCtx);
-    
-    if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, int8_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_SMALLINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, int16_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_INT) {
-      LIST_ADD_N(*pVal, pCtx, pData, int32_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_BIGINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, int64_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_DOUBLE) {
-      LIST_ADD_N_DOUBLE(*pVal, pCtx, pData, double, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_FLOAT) {
-      LIST_ADD_N_DOUBLE_FLOAT(*pVal, pCtx, pData, float, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_UTINYINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, uint8_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_USMALLINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, uint16_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_UINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, uint32_t, notNullElems, pCtx->inputType);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_UBIGINT) {
-      LIST_ADD_N(*pVal, pCtx, pData, uint64_t, notNullElems, pCtx->inputType);
+    // the 64 bit integers are summed as double like before, their sum may not fit into 64 bits
+    if (pCtx->inputType == TSDB_DATA_TYPE_BIGINT || pCtx->inputType == TSDB_DATA_TYPE_UBIGINT ||
+        IS_FLOAT_TYPE(pCtx->inputType)) {
+      double sum = 0;
+      notNullElems = sumDoubleOfInput(pCtx, &sum);
+      *pVal += sum;
+    } else if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
+      int64_t sum = 0;
+      notNullElems = sumIntegerOfInput(pCtx, &sum);
+      *pVal += (double)sum;
+    } else if (IS_UNSIGNED_NUMERIC_TYPE(pCtx->inputType)) {
+      int64_t sum = 0;
+      notNullElems = sumIntegerOfInput(pCtx, &sum);
+      *pVal += (double)(uint64_t)sum;
     }
   }
   
@@ -984,55 +935,38 @@ static void minMax_function(SQLFunctionCtx *pCtx, char *pOutput, int32_t isMin,
     return;
   }
   
-  void  *p = GET_INPUT_DATA_LIST(pCtx);
-  TSKEY *tsList = GET_TS_LIST(pCtx);
+  void   *p = GET_INPUT_DATA_LIST(pCtx);
+  int32_t index = -1;
+
+  // every not null value is counted, and the block is applied to the result with its min/max value only once
+  if (INPUT_HAS_BITMAP(pCtx)) {
+    *notNullElems = aggMinMaxBitmap(p, pCtx->inputType, pCtx->size, pCtx->pInputBitmap, pCtx->inputBitmapOffset, isMin,
+                                    &index);
+  } else {
+    *notNullElems = aggMinMax(p, pCtx->inputType, pCtx->size, pCtx->hasNull, isMin, &index);
+  }
+  if (index < 0) {
+    return;
+  }
+
+  TSKEY key = (pCtx->ptsList != NULL) ? GET_TS_DATA(pCtx, index) : 0;
+  switch (pCtx->inputType) {
+    case TSDB_DATA_TYPE_TINYINT:   UPDATE_MINMAX_AT(pCtx, int8_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_SMALLINT:  UPDATE_MINMAX_AT(pCtx, int16_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_INT:       UPDATE_MINMAX_AT(pCtx, int32_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_BIGINT:    UPDATE_MINMAX_AT(pCtx, int64_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_UTINYINT:  UPDATE_MINMAX_AT(pCtx, uint8_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_USMALLINT: UPDATE_MINMAX_AT(pCtx, uint16_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_UINT:      UPDATE_MINMAX_AT(pCtx, uint32_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_UBIGINT:   UPDATE_MINMAX_AT(pCtx, uint64_t, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_FLOAT:     UPDATE_MINMAX_AT(pCtx, float, pOutput, p, index, isMin, key); break;
+    case TSDB_DATA_TYPE_DOUBLE:    UPDATE_MINMAX_AT(pCtx, double, pOutput, p, index, isMin, key); break;
+    default: break;
+  }
 
-  *notNullElems = 0;
-  
-  if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
-    if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
-      TYPED_LOOPCHECK_N(int8_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_SMALLINT) {
-      TYPED_LOOPCHECK_N(int16_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_INT) {
-      int32_t *pData = p;
-      int32_t *retVal = (int32_t*) pOutput;
-      
-      for (int32_t i = 0; i < pCtx->size; ++i) {
-        if (pCtx->hasNull && isNull((const char*)&pData[i], pCtx->inputType)) {
-          continue;
-        }
-        
-        if ((*retVal < pData[i]) ^ isMin) {
-          *retVal = pData[i];
-          TSKEY k = tsList[i];
-          
-          DO_UPDATE_TAG_COLUMNS(pCtx, k);
-        }
-        
-        *notNullElems += 1;
-      }
 #if defined(_DEBUG_VIEW)
-      qDebug("max value updated:%d", *retVal);
+  qDebug("min/max value updated, index:%d", index);
 #endif
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_BIGINT) {
-      TYPED_LOOPCHECK_N(int64_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    }
-  } else if (IS_UNSIGNED_NUMERIC_TYPE(pCtx->inputType)) {
-    if (pCtx->inputType == TSDB_DATA_TYPE_UTINYINT) {
-      TYPED_LOOPCHECK_N(uint8_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_USMALLINT) {
-      TYPED_LOOPCHECK_N(uint16_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_UINT) {
-      TYPED_LOOPCHECK_N(uint32_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    } else if (pCtx->inputType == TSDB_DATA_TYPE_UBIGINT) {
-      TYPED_LOOPCHECK_N(uint64_t, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-    }
-  } else if (pCtx->inputType == TSDB_DATA_TYPE_DOUBLE) {
-    TYPED_LOOPCHECK_N(double, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-  } else if (pCtx->inputType == TSDB_DATA_TYPE_FLOAT) {
-    TYPED_LOOPCHECK_N(float, pOutput, p, pCtx, pCtx->inputType, isMin, *notNullElems);
-  }
 }
 
 static bool min_func_setup(SQLFunctionCtx *pCtx, SResultRowCellInfo* pResultInfo) {
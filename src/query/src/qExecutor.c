@@ -460,7 +460,7 @@ static bool chkResultRowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SResultRowInfo *p
   SET_RES_WINDOW_KEY(pRuntimeEnv->keyBuf, pData, bytes, uid);
 
   SResultRow **p1 =
-      (SResultRow **)taosHashGet(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes));
+      (SResultRow **)qHashGet(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes));
 
   // in case of repeat scan/reverse scan, no new time window added.
   if (QUERY_IS_INTERVAL_QUERY(pRuntimeEnv->pQueryAttr)) {
@@ -476,7 +476,7 @@ static bool chkResultRowFromKey(SQueryRuntimeEnv *pRuntimeEnv, SResultRowInfo *p
         existed = (pResultRowInfo->pResult[0] == (*p1));
       } else {  // check if current pResultRowInfo contains the existed pResultRow
         SET_RES_EXT_WINDOW_KEY(pRuntimeEnv->keyBuf, pData, bytes, uid, pResultRowInfo);
-        int64_t* index = taosHashGet(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes));
+        int64_t* index = qHashGet(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes));
         if (index != NULL) {
           existed = true;
         } else {
@@ -498,7 +498,7 @@ static SResultRow* doSetResultOutBufByKey(SQueryRuntimeEnv* pRuntimeEnv, SResult
   SET_RES_WINDOW_KEY(pRuntimeEnv->keyBuf, pData, bytes, tableGroupId);
 
   SResultRow **p1 =
-      (SResultRow **)taosHashGet(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes));
+      (SResultRow **)qHashGet(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes));
 
   // in case of repeat scan/reverse scan, no new time window added.
   if (QUERY_IS_INTERVAL_QUERY(pRuntimeEnv->pQueryAttr)) {
@@ -515,7 +515,7 @@ static SResultRow* doSetResultOutBufByKey(SQueryRuntimeEnv* pRuntimeEnv, SResult
         pResultRowInfo->curPos = 0;
       } else {  // check if current pResultRowInfo contains the existed pResultRow
         SET_RES_EXT_WINDOW_KEY(pRuntimeEnv->keyBuf, pData, bytes, tid, pResultRowInfo);
-        int64_t* index = taosHashGet(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes));
+        int64_t* index = qHashGet(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes));
         if (index != NULL) {
           pResultRowInfo->curPos = (int32_t) *index;
           existed = true;
@@ -543,7 +543,9 @@ static SResultRow* doSetResultOutBufByKey(SQueryRuntimeEnv* pRuntimeEnv, SResult
       }
 
       // add a new result set for a new group
-      taosHashPut(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes), &pResult, POINTER_BYTES);
+      if (qHashPut(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(bytes), &pResult, POINTER_BYTES) != 0) {
+        longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+      }
     } else {
       pResult = *p1;
     }
@@ -553,7 +555,9 @@ static SResultRow* doSetResultOutBufByKey(SQueryRuntimeEnv* pRuntimeEnv, SResult
 
     int64_t index = pResultRowInfo->curPos;
     SET_RES_EXT_WINDOW_KEY(pRuntimeEnv->keyBuf, pData, bytes, tid, pResultRowInfo);
-    taosHashPut(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes), &index, POINTER_BYTES);
+    if (qHashPut(pRuntimeEnv->pResultRowListSet, pRuntimeEnv->keyBuf, GET_RES_EXT_WINDOW_KEY_LEN(bytes), &index, POINTER_BYTES) != 0) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
   }
 
   // too many time window in query
@@ -986,6 +990,7 @@ static void doApplyFunctions(SQueryRuntimeEnv* pRuntimeEnv, SQLFunctionCtx* pCtx
     int32_t pos = (QUERY_IS_ASC_QUERY(pQueryAttr)) ? offset : offset - (forwardStep - 1);
     if (pCtx[k].pInput != NULL) {
       pCtx[k].pInput = (char *)pCtx[k].pInput + pos * pCtx[k].inputBytes;
+      pCtx[k].inputBitmapOffset = pos;
     }
 
     if (tsCol != NULL) {
@@ -1011,6 +1016,7 @@ static void doApplyFunctions(SQueryRuntimeEnv* pRuntimeEnv, SQLFunctionCtx* pCtx
     // restore it
     pCtx[k].preAggVals.isSet = hasAggregates;
     pCtx[k].pInput = start;
+    pCtx[k].inputBitmapOffset = 0;
   }
 }
 
@@ -1218,6 +1224,8 @@ static void doSetInputDataBlock(SOperatorInfo* pOperator, SQLFunctionCtx* pCtx,
 
         // in case of the block distribution query, the inputBytes is not a constant value.
         pCtx[i].pInput = p->pData;
+        pCtx[i].pInputBitmap = p->pBitmap;
+        pCtx[i].inputBitmapOffset = 0;
         assert(p->info.colId == pColIndex->colId && pCtx[i].inputType == p->info.type);
 
         if (pCtx[i].functionId < 0) {
@@ -1243,6 +1251,7 @@ static void doSetInputDataBlock(SOperatorInfo* pOperator, SQLFunctionCtx* pCtx,
         SColumnInfoData* p = taosArrayGet(pBlock->pDataBlock, pColIndex->colIndex);
 
         pCtx[i].pInput = p->pData;
+        pCtx[i].pInputBitmap = NULL;
         assert(p->info.colId == pColIndex->colId && pCtx[i].inputType == p->info.type);
         for(int32_t j = 0; j < pBlock->info.rows; ++j) {
           char* dst = p->pData + j * p->info.bytes;
@@ -2106,8 +2115,8 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
   pRuntimeEnv->prevGroupId = INT32_MIN;
   pRuntimeEnv->pQueryAttr = pQueryAttr;
 
-  pRuntimeEnv->pResultRowHashTable = taosHashInit(numOfTables, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
-  pRuntimeEnv->pResultRowListSet = taosHashInit(numOfTables, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  pRuntimeEnv->pResultRowHashTable = qHashInit(numOfTables);
+  pRuntimeEnv->pResultRowListSet = qHashInit(numOfTables);
   pRuntimeEnv->keyBuf  = malloc(pQueryAttr->maxTableColumnWidth + sizeof(int64_t) + POINTER_BYTES);
   pRuntimeEnv->pool    = initResultRowPool(getResultRowSize(pRuntimeEnv));
 
@@ -2119,7 +2128,7 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
 
   pRuntimeEnv->sasArray = calloc(pQueryAttr->numOfOutput, sizeof(SArithmeticSupport));
 
-  if (pRuntimeEnv->sasArray == NULL || pRuntimeEnv->pResultRowHashTable == NULL || pRuntimeEnv->keyBuf == NULL ||
+  if (pRuntimeEnv->sasArray == NULL || pRuntimeEnv->pResultRowHashTable == NULL || pRuntimeEnv->pResultRowListSet == NULL || pRuntimeEnv->keyBuf == NULL ||
       pRuntimeEnv->prevRow == NULL  || pRuntimeEnv->tagVal == NULL) {
     goto _clean;
   }
@@ -2312,7 +2321,10 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
 
 _clean:
   tfree(pRuntimeEnv->sasArray);
-  tfree(pRuntimeEnv->pResultRowHashTable);
+  qHashCleanup(pRuntimeEnv->pResultRowHashTable);
+  pRuntimeEnv->pResultRowHashTable = NULL;
+  qHashCleanup(pRuntimeEnv->pResultRowListSet);
+  pRuntimeEnv->pResultRowListSet = NULL;
   tfree(pRuntimeEnv->keyBuf);
   tfree(pRuntimeEnv->prevRow);
   tfree(pRuntimeEnv->tagVal);
@@ -2371,13 +2383,13 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
   tfree(pRuntimeEnv->prevRow);
   tfree(pRuntimeEnv->tagVal);
 
-  taosHashCleanup(pRuntimeEnv->pResultRowHashTable);
+  qHashCleanup(pRuntimeEnv->pResultRowHashTable);
   pRuntimeEnv->pResultRowHashTable = NULL;
 
   taosHashCleanup(pRuntimeEnv->pTableRetrieveTsMap);
   pRuntimeEnv->pTableRetrieveTsMap = NULL;
 
-  taosHashCleanup(pRuntimeEnv->pResultRowListSet);
+  qHashCleanup(pRuntimeEnv->pResultRowListSet);
   pRuntimeEnv->pResultRowListSet = NULL;
 
   destroyOperatorInfo(pRuntimeEnv->proot);
@@ -2887,6 +2899,9 @@ void doCompactSDataBlock(SSDataBlock* pBlock, int32_t numOfRows, int8_t* p) {
           int16_t bytes = pColumnInfoData->info.bytes;
           memmove(((char*)pColumnInfoData->pData) + start * bytes, pColumnInfoData->pData + cstart * bytes,
                   len * bytes);
+          if (pColumnInfoData->pBitmap != NULL) {
+            tdBitmapCopy(pColumnInfoData->pBitmap, start, pColumnInfoData->pBitmap, cstart, len);
+          }
         }
 
         start += len;
@@ -2902,6 +2917,9 @@ void doCompactSDataBlock(SSDataBlock* pBlock, int32_t numOfRows, int8_t* p) {
 
       int16_t bytes = pColumnInfoData->info.bytes;
       memmove(pColumnInfoData->pData + start * bytes, pColumnInfoData->pData + cstart * bytes, len * bytes);
+      if (pColumnInfoData->pBitmap != NULL) {
+        tdBitmapCopy(pColumnInfoData->pBitmap, start, pColumnInfoData->pBitmap, cstart, len);
+      }
     }
 
     start += len;
@@ -3199,6 +3217,16 @@ int32_t loadDataBlockOnDemand(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTa
       return TSDB_CODE_SUCCESS;
     }
 
+    // the values of the equal and in conditions are not in the bloom filters of the block
+    if (pBlock->pBlockStatis != NULL && pQueryAttr->pFilters != NULL &&
+        !filterBloomExecute(pQueryAttr->pFilters, tsdbDataBlockMayContain, pTableScanInfo->pQueryHandle)) {
+      pCost->discardBlocks += 1;
+      qDebug("QInfo:0x%"PRIx64" data block discard by bloom filter, brange:%" PRId64 "-%" PRId64 ", rows:%d", pQInfo->qId,
+             pBlockInfo->window.skey, pBlockInfo->window.ekey, pBlockInfo->rows);
+      (*status) = BLK_DATA_DISCARD;
+      return TSDB_CODE_SUCCESS;
+    }
+
     pCost->totalCheckedRows += pBlockInfo->rows;
     pCost->loadBlocks += 1;
     pBlock->pDataBlock = tsdbRetrieveDataBlock(pTableScanInfo->pQueryHandle, NULL);
@@ -4434,7 +4462,7 @@ void queryCostStatis(SQInfo *pQInfo) {
   SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
   SQueryCostInfo *pSummary = &pQInfo->summary;
 
-  uint64_t hashSize = taosHashGetMemSize(pQInfo->runtimeEnv.pResultRowHashTable);
+  uint64_t hashSize = qHashGetMemSize(pQInfo->runtimeEnv.pResultRowHashTable);
   hashSize += taosHashGetMemSize(pRuntimeEnv->tableqinfoGroupInfo.map);
   pSummary->hashSize = hashSize;
 
@@ -5507,6 +5535,254 @@ static int32_t doMergeSDatablock(SSDataBlock* pDest, SSDataBlock* pSrc) {
   return TSDB_CODE_SUCCESS;
 }
 
+static void doSortDataBlock(SOrderOperatorInfo* pInfo) {
+  int32_t numOfCols = pInfo->pDataBlock->info.numOfCols;
+  void** pCols     = calloc(numOfCols, POINTER_BYTES);
+  SSchema* pSchema = calloc(numOfCols, sizeof(SSchema));
+
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    SColumnInfoData* p1 = taosArrayGet(pInfo->pDataBlock->pDataBlock, i);
+    pCols[i] = p1->pData;
+    pSchema[i].colId = p1->info.colId;
+    pSchema[i].bytes = p1->info.bytes;
+    pSchema[i].type  = (uint8_t) p1->info.type;
+  }
+
+  taoscQSort(pCols, pSchema, numOfCols, pInfo->pDataBlock->info.rows, pInfo->colIndex, pInfo->comp);
+
+  tfree(pCols);
+  tfree(pSchema);
+}
+
+static void doCopySortRow(SSDataBlock* pDest, int32_t destRow, SSDataBlock* pSrc, int32_t srcRow) {
+  for(int32_t i = 0; i < pDest->info.numOfCols; ++i) {
+    SColumnInfoData* pDestCol = taosArrayGet(pDest->pDataBlock, i);
+    SColumnInfoData* pSrcCol = taosArrayGet(pSrc->pDataBlock, i);
+
+    int32_t bytes = pDestCol->info.bytes;
+    memcpy(pDestCol->pData + destRow * bytes, pSrcCol->pData + srcRow * bytes, bytes);
+  }
+}
+
+static FORCE_INLINE char* getTopNKey(SOrderOperatorInfo* pInfo, SColumnInfoData* pKeyCol, int32_t pos) {
+  return pKeyCol->pData + pInfo->pHeap[pos] * pKeyCol->info.bytes;
+}
+
+// the heap keeps the last of the first topN rows in the order on its top
+static void doTopNHeapSiftUp(SOrderOperatorInfo* pInfo, SColumnInfoData* pKeyCol, int32_t pos) {
+  while (pos > 0) {
+    int32_t parent = (pos - 1) >> 1;
+    if (pInfo->comp(getTopNKey(pInfo, pKeyCol, pos), getTopNKey(pInfo, pKeyCol, parent)) <= 0) {
+      break;
+    }
+
+    SWAP(pInfo->pHeap[pos], pInfo->pHeap[parent], int32_t);
+    pos = parent;
+  }
+}
+
+static void doTopNHeapSiftDown(SOrderOperatorInfo* pInfo, SColumnInfoData* pKeyCol, int32_t pos, int32_t num) {
+  while (1) {
+    int32_t child = (pos << 1) + 1;
+    if (child >= num) {
+      break;
+    }
+
+    if (child + 1 < num && pInfo->comp(getTopNKey(pInfo, pKeyCol, child + 1), getTopNKey(pInfo, pKeyCol, child)) > 0) {
+      child += 1;
+    }
+
+    if (pInfo->comp(getTopNKey(pInfo, pKeyCol, child), getTopNKey(pInfo, pKeyCol, pos)) <= 0) {
+      break;
+    }
+
+    SWAP(pInfo->pHeap[pos], pInfo->pHeap[child], int32_t);
+    pos = child;
+  }
+}
+
+static void doAddTopNRows(SOrderOperatorInfo* pInfo, SSDataBlock* pBlock) {
+  SSDataBlock* pDest = pInfo->pDataBlock;
+  SColumnInfoData* pKeyCol = taosArrayGet(pDest->pDataBlock, pInfo->colIndex);
+  SColumnInfoData* pSrcKeyCol = taosArrayGet(pBlock->pDataBlock, pInfo->colIndex);
+
+  for(int32_t j = 0; j < pBlock->info.rows; ++j) {
+    int32_t num = pDest->info.rows;
+    if (num < pInfo->topN) {
+      doCopySortRow(pDest, num, pBlock, j);
+      pInfo->pHeap[num] = num;
+      pDest->info.rows += 1;
+      doTopNHeapSiftUp(pInfo, pKeyCol, num);
+    } else if (pInfo->comp(pSrcKeyCol->pData + j * pSrcKeyCol->info.bytes, getTopNKey(pInfo, pKeyCol, 0)) < 0) {
+      doCopySortRow(pDest, pInfo->pHeap[0], pBlock, j);
+      doTopNHeapSiftDown(pInfo, pKeyCol, 0, num);
+    }
+  }
+}
+
+// sort the rows of pDataBlock and write them into the pages of a new run, the group id of the pages is the run index
+static void doSpillSortRun(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SSDataBlock* pBlock = pInfo->pDataBlock;
+
+  if (pInfo->pSortBuf == NULL) {
+    int64_t inMemSize = ((int64_t)tsSortBufferSize << 20) / 4;
+    inMemSize = MAX(inMemSize, pInfo->pageSize * 2);
+    inMemSize = MIN(inMemSize, INT32_MAX - pInfo->pageSize);
+
+    int32_t code = createDiskbasedResultBuffer(&pInfo->pSortBuf, pInfo->pageSize, (int32_t)inMemSize, GET_QID(pRuntimeEnv));
+    if (code != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, code);
+    }
+  }
+
+  doSortDataBlock(pInfo);
+
+  int32_t groupId = pInfo->numOfRuns++;
+  int32_t rowsPerPage = (int32_t)((pInfo->pageSize - sizeof(tFilePage)) / pInfo->rowSize);
+
+  tFilePage* pPage = NULL;
+  for(int32_t j = 0; j < pBlock->info.rows; ++j) {
+    if (pPage == NULL || pPage->num == rowsPerPage) {
+      if (pPage != NULL) {
+        releaseResBufPage(pInfo->pSortBuf, pPage);
+      }
+
+      int32_t pageId = -1;
+      pPage = getNewDataBuf(pInfo->pSortBuf, groupId, &pageId);
+      if (pPage == NULL) {
+        longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+      }
+
+      pPage->num = 0;
+    }
+
+    char* dst = pPage->data + pPage->num * pInfo->rowSize;
+    for(int32_t i = 0; i < pBlock->info.numOfCols; ++i) {
+      SColumnInfoData* pCol = taosArrayGet(pBlock->pDataBlock, i);
+      memcpy(dst, pCol->pData + j * pCol->info.bytes, pCol->info.bytes);
+      dst += pCol->info.bytes;
+    }
+
+    pPage->num += 1;
+  }
+
+  if (pPage != NULL) {
+    releaseResBufPage(pInfo->pSortBuf, pPage);
+  }
+
+  qDebug("QInfo:0x%"PRIx64" %d rows of order by spilled as run %d", GET_QID(pRuntimeEnv), pBlock->info.rows, groupId);
+  pBlock->info.rows = 0;
+}
+
+static void doMoveSortRunCursor(SOrderOperatorInfo* pInfo, SSortRunCursor* pCursor) {
+  pCursor->rowIndex += 1;
+  if (pCursor->rowIndex < pCursor->pPage->num) {
+    return;
+  }
+
+  releaseResBufPage(pInfo->pSortBuf, pCursor->pPage);
+  pCursor->pPage = NULL;
+  pCursor->rowIndex = -1;
+
+  pCursor->pageIndex += 1;
+  if (pCursor->pageIndex < (int32_t)taosArrayGetSize(pCursor->pageIdList)) {
+    SPageInfo* pPageInfo = taosArrayGetP(pCursor->pageIdList, pCursor->pageIndex);
+    pCursor->pPage = getResBufPage(pInfo->pSortBuf, pPageInfo->pageId);
+    pCursor->rowIndex = 0;
+  }
+}
+
+static int32_t sortRunComparator(const void *pLeft, const void *pRight, void *param) {
+  SOrderOperatorInfo* pInfo = param;
+
+  SSortRunCursor* pLeftCursor = &pInfo->pCursor[*(int32_t*)pLeft];
+  SSortRunCursor* pRightCursor = &pInfo->pCursor[*(int32_t*)pRight];
+
+  // an exhausted run is always behind the others
+  if (pLeftCursor->rowIndex == -1) {
+    return 1;
+  }
+
+  if (pRightCursor->rowIndex == -1) {
+    return -1;
+  }
+
+  char* pLeftKey = pLeftCursor->pPage->data + pLeftCursor->rowIndex * pInfo->rowSize + pInfo->keyOffset;
+  char* pRightKey = pRightCursor->pPage->data + pRightCursor->rowIndex * pInfo->rowSize + pInfo->keyOffset;
+  return pInfo->comp(pLeftKey, pRightKey);
+}
+
+static void doPrepareSortRunsMerge(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+
+  pInfo->pCursor = calloc(pInfo->numOfRuns, sizeof(SSortRunCursor));
+  if (pInfo->pCursor == NULL) {
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+  }
+
+  for(int32_t i = 0; i < pInfo->numOfRuns; ++i) {
+    SSortRunCursor* pCursor = &pInfo->pCursor[i];
+    pCursor->pageIdList = getDataBufPagesIdList(pInfo->pSortBuf, i);
+
+    SPageInfo* pPageInfo = taosArrayGetP(pCursor->pageIdList, 0);
+    pCursor->pPage = getResBufPage(pInfo->pSortBuf, pPageInfo->pageId);
+  }
+
+  int32_t code = tLoserTreeCreate(&pInfo->pTree, pInfo->numOfRuns, pInfo, sortRunComparator);
+  if (code != TSDB_CODE_SUCCESS) {
+    longjmp(pRuntimeEnv->env, code);
+  }
+
+  pInfo->pRes = calloc(1, sizeof(SSDataBlock));
+  pInfo->pRes->info.numOfCols = pInfo->pDataBlock->info.numOfCols;
+  pInfo->pRes->pDataBlock = taosArrayInit(pInfo->pRes->info.numOfCols, sizeof(SColumnInfoData));
+  for(int32_t i = 0; i < pInfo->pRes->info.numOfCols; ++i) {
+    SColumnInfoData* pCol = taosArrayGet(pInfo->pDataBlock->pDataBlock, i);
+
+    SColumnInfoData col = {.info = pCol->info};
+    col.pData = malloc(pCol->info.bytes * pRuntimeEnv->resultInfo.capacity);
+    if (col.pData == NULL) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    taosArrayPush(pInfo->pRes->pDataBlock, &col);
+  }
+}
+
+static SSDataBlock* doMergeSortRuns(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SSDataBlock* pRes = pInfo->pRes;
+
+  pRes->info.rows = 0;
+  while (pRes->info.rows < pRuntimeEnv->resultInfo.capacity) {
+    int32_t index = pInfo->pTree->pNode[0].index;
+
+    SSortRunCursor* pCursor = &pInfo->pCursor[index];
+    if (pCursor->rowIndex == -1) {  // all runs are exhausted
+      doSetOperatorCompleted(pOperator);
+      break;
+    }
+
+    char* src = pCursor->pPage->data + pCursor->rowIndex * pInfo->rowSize;
+    for(int32_t i = 0; i < pRes->info.numOfCols; ++i) {
+      SColumnInfoData* pCol = taosArrayGet(pRes->pDataBlock, i);
+      memcpy(pCol->pData + pRes->info.rows * pCol->info.bytes, src, pCol->info.bytes);
+      src += pCol->info.bytes;
+    }
+
+    pRes->info.rows += 1;
+
+    doMoveSortRunCursor(pInfo, pCursor);
+    tLoserTreeAdjust(pInfo->pTree, index + pInfo->pTree->numOfEntries);
+  }
+
+  return (pRes->info.rows > 0)? pRes:NULL;
+}
+
 static SSDataBlock* doSort(void* param, bool* newgroup) {
   SOperatorInfo* pOperator = (SOperatorInfo*) param;
   if (pOperator->status == OP_EXEC_DONE) {
@@ -5514,6 +5790,9 @@ static SSDataBlock* doSort(void* param, bool* newgroup) {
   }
 
   SOrderOperatorInfo* pInfo = pOperator->info;
+  if (pOperator->status == OP_RES_TO_RETURN) {
+    return doMergeSortRuns(pOperator);
+  }
 
   SSDataBlock* pBlock = NULL;
   while(1) {
@@ -5521,36 +5800,45 @@ static SSDataBlock* doSort(void* param, bool* newgroup) {
     pBlock = pOperator->upstream[0]->exec(pOperator->upstream[0], newgroup);
     publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_AFTER_OPERATOR_EXEC);
 
-    // start to flush data into disk and try do multiway merge sort
     if (pBlock == NULL) {
-      doSetOperatorCompleted(pOperator);
       break;
     }
 
+    if (pInfo->topN > 0) {
+      doAddTopNRows(pInfo, pBlock);
+      continue;
+    }
+
+    // the rows beyond the sort buffer are sorted and flushed into disk as a run
+    if (pInfo->pDataBlock->info.rows > 0 && pInfo->pDataBlock->info.rows + pBlock->info.rows > pInfo->capacity) {
+      doSpillSortRun(pOperator);
+    }
+
     int32_t code = doMergeSDatablock(pInfo->pDataBlock, pBlock);
     if (code != TSDB_CODE_SUCCESS) {
-      // todo handle error
+      longjmp(pOperator->pRuntimeEnv->env, code);
     }
   }
 
-  int32_t numOfCols = pInfo->pDataBlock->info.numOfCols;
-  void** pCols     = calloc(numOfCols, POINTER_BYTES);
-  SSchema* pSchema = calloc(numOfCols, sizeof(SSchema));
+  if (pInfo->numOfRuns == 0) {
+    doSetOperatorCompleted(pOperator);
+    doSortDataBlock(pInfo);
+    return (pInfo->pDataBlock->info.rows > 0)? pInfo->pDataBlock:NULL;
+  }
 
-  for(int32_t i = 0; i < numOfCols; ++i) {
-    SColumnInfoData* p1 = taosArrayGet(pInfo->pDataBlock->pDataBlock, i);
-    pCols[i] = p1->pData;
-    pSchema[i].colId = p1->info.colId;
-    pSchema[i].bytes = p1->info.bytes;
-    pSchema[i].type  = (uint8_t) p1->info.type;
+  // flush the last run, and multiway merge all runs
+  if (pInfo->pDataBlock->info.rows > 0) {
+    doSpillSortRun(pOperator);
   }
 
-  __compar_fn_t  comp = getKeyComparFunc(pSchema[pInfo->colIndex].type, pInfo->order);
-  taoscQSort(pCols, pSchema, numOfCols, pInfo->pDataBlock->info.rows, pInfo->colIndex, comp);
+  for(int32_t i = 0; i < pInfo->pDataBlock->info.numOfCols; ++i) {
+    SColumnInfoData* pCol = taosArrayGet(pInfo->pDataBlock->pDataBlock, i);
+    tfree(pCol->pData);
+  }
 
-  tfree(pCols);
-  tfree(pSchema);
-  return (pInfo->pDataBlock->info.rows > 0)? pInfo->pDataBlock:NULL;
+  doPrepareSortRunsMerge(pOperator);
+  pOperator->status = OP_RES_TO_RETURN;
+  return doMergeSortRuns(pOperator);
 }
 
 SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal) {
@@ -5568,7 +5856,10 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
 
         if (col.info.colId == pOrderVal->orderColId) {
           pInfo->colIndex = i;
+          pInfo->keyOffset = pInfo->rowSize;
         }
+
+        pInfo->rowSize += col.info.bytes;
       }
 
       pDataBlock->info.numOfCols = numOfOutput;
@@ -5576,8 +5867,33 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
       pInfo->pDataBlock = pDataBlock;
   }
 
+  SColumnInfoData* pKeyCol = taosArrayGet(pInfo->pDataBlock->pDataBlock, pInfo->colIndex);
+  pInfo->comp = getKeyComparFunc(pKeyCol->info.type, pInfo->order);
+
+  // three quarters of the sort buffer for the rows sorted in memory, the rest for the pages of the spilled runs
+  int64_t capacity = (((int64_t)tsSortBufferSize << 20) / 4 * 3) / MAX(pInfo->rowSize, 1);
+  capacity = MAX(capacity, pRuntimeEnv->resultInfo.capacity);
+  pInfo->capacity = (int32_t)MIN(capacity, INT32_MAX / 2);
+
+  pInfo->pageSize = 64 * 1024;
+  while ((pInfo->pageSize - (int32_t)sizeof(tFilePage)) / pInfo->rowSize < 4) {
+    pInfo->pageSize <<= 1;
+  }
+
+  // only the first limit + offset rows are needed by the following limit operator
+  SLimitVal* pLimit = &pRuntimeEnv->pQueryAttr->limit;
+  if (pLimit->limit > 0 && pLimit->limit + pLimit->offset <= pInfo->capacity) {
+    pInfo->topN = (int32_t)(pLimit->limit + pLimit->offset);
+    pInfo->pHeap = malloc(sizeof(int32_t) * pInfo->topN);
+
+    for(int32_t i = 0; i < numOfOutput; ++i) {
+      SColumnInfoData* pCol = taosArrayGet(pInfo->pDataBlock->pDataBlock, i);
+      pCol->pData = malloc(pCol->info.bytes * pInfo->topN);
+    }
+  }
+
   SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
-  pOperator->name          = "InMemoryOrder";
+  pOperator->name          = "OrderOperator";
   pOperator->operatorType  = OP_Order;
   pOperator->blockingOptr  = true;
   pOperator->status        = OP_IN_EXECUTING;
@@ -5845,6 +6161,9 @@ static SSDataBlock* doLimit(void* param, bool* newgroup) {
 
         int16_t bytes = pColInfoData->info.bytes;
         memmove(pColInfoData->pData, pColInfoData->pData + bytes * pRuntimeEnv->currentOffset, remain * bytes);
+        if (pColInfoData->pBitmap != NULL) {
+          tdBitmapCopy(pColInfoData->pBitmap, 0, pColInfoData->pBitmap, (int32_t)pRuntimeEnv->currentOffset, remain);
+        }
       }
 
       pRuntimeEnv->currentOffset = 0;
@@ -6609,6 +6928,16 @@ static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput) {
 static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput) {
   SOrderOperatorInfo* pInfo = (SOrderOperatorInfo*) param;
   pInfo->pDataBlock = destroyOutputBuf(pInfo->pDataBlock);
+  pInfo->pRes = destroyOutputBuf(pInfo->pRes);
+
+  tfree(pInfo->pHeap);
+  tfree(pInfo->pCursor);
+  tfree(pInfo->pTree);
+
+  if (pInfo->pSortBuf != NULL) {
+    destroyResultBuf(pInfo->pSortBuf);
+    pInfo->pSortBuf = NULL;
+  }
 }
 
 static void destroyConditionOperatorInfo(void* param, int32_t numOfOutput) {
@@ -6618,7 +6947,7 @@ static void destroyConditionOperatorInfo(void* param, int32_t numOfOutput) {
 
 static void destroyDistinctOperatorInfo(void* param, int32_t numOfOutput) {
   SDistinctOperatorInfo* pInfo = (SDistinctOperatorInfo*) param;
-  taosHashCleanup(pInfo->pSet);
+  qHashCleanup(pInfo->pSet);
   tfree(pInfo->buf);
   taosArrayDestroy(pInfo->pDistinctDataInfo);
   pInfo->pRes = destroyOutputBuf(pInfo->pRes);
@@ -7253,7 +7582,7 @@ static SSDataBlock* hashDistinct(void* param, bool* newgroup) {
         SDistinctDataInfo* pDistDataInfo = taosArrayGet(pInfo->pDistinctDataInfo,  i);
         char* tmp = realloc(pResultColInfoData->pData, newSize * pDistDataInfo->bytes);
         if (tmp == NULL) {
-          return NULL;
+          longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
         } else {
           pResultColInfoData->pData = tmp;
         }
@@ -7263,9 +7592,11 @@ static SSDataBlock* hashDistinct(void* param, bool* newgroup) {
 
     for (int32_t i = 0; i < pBlock->info.rows; i++) {
       buildMultiDistinctKey(pInfo, pBlock, i);
-      if (taosHashGet(pInfo->pSet, pInfo->buf, pInfo->totalBytes) == NULL) {
-        int32_t dummy;
-        taosHashPut(pInfo->pSet, pInfo->buf, pInfo->totalBytes, &dummy, sizeof(dummy));
+      if (qHashGet(pInfo->pSet, pInfo->buf, pInfo->totalBytes) == NULL) {
+        int32_t dummy = 0;
+        if (qHashPut(pInfo->pSet, pInfo->buf, pInfo->totalBytes, &dummy, sizeof(dummy)) != 0) {
+          longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+        }
         for (int j = 0; j < taosArrayGetSize(pRes->pDataBlock); j++) {
           SDistinctDataInfo* pDistDataInfo = taosArrayGet(pInfo->pDistinctDataInfo, j);  // distinct meta info
           SColumnInfoData*   pColInfoData = taosArrayGet(pBlock->pDataBlock, pDistDataInfo->index); //src
@@ -7293,7 +7624,7 @@ SOperatorInfo* createDistinctOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperat
   pInfo->threshold       = tsMaxNumOfDistinctResults; // distinct result threshold
   pInfo->outputCapacity  = 4096;
   pInfo->pDistinctDataInfo = taosArrayInit(numOfOutput, sizeof(SDistinctDataInfo)); 
-  pInfo->pSet = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  pInfo->pSet = qHashInit(64);
   pInfo->pRes = createOutputBuf(pExpr, numOfOutput, (int32_t) pInfo->outputCapacity);
   
 
@@ -7377,6 +7708,13 @@ static bool validateQueryMsg(SQueryTableMsg *pQueryMsg) {
     return false;
   }
 
+  if (pQueryMsg->numOfPartitions > 1 &&
+      (pQueryMsg->partitionIndex < 0 || pQueryMsg->partitionIndex >= pQueryMsg->numOfPartitions)) {
+    qError("qmsg:%p illegal value of partition %d of %d", pQueryMsg, pQueryMsg->partitionIndex,
+           pQueryMsg->numOfPartitions);
+    return false;
+  }
+
   if (pQueryMsg->numOfOutput > TSDB_MAX_COLUMNS || pQueryMsg->numOfOutput <= 0) {
     qError("qmsg:%p illegal value of output columns %d", pQueryMsg, pQueryMsg->numOfOutput);
     return false;
@@ -7520,6 +7858,8 @@ int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SQueryParam* param) {
   pQueryMsg->udfContentOffset = htonl(pQueryMsg->udfContentOffset);
   pQueryMsg->udfContentLen    = htonl(pQueryMsg->udfContentLen);
   pQueryMsg->udfNum           = htonl(pQueryMsg->udfNum);
+  pQueryMsg->numOfPartitions  = htons(pQueryMsg->numOfPartitions);
+  pQueryMsg->partitionIndex   = htons(pQueryMsg->partitionIndex);
 
   // query msg safety check
   if (!validateQueryMsg(pQueryMsg)) {
@@ -802,6 +802,7 @@ int32_t filterAddField(SFilterInfo *info, void *desc, void **data, int32_t type,
     info->fields[type].fields[idx].flag = type;  
     info->fields[type].fields[idx].desc = desc;
     info->fields[type].fields[idx].data = data ? *data : NULL;
+    info->fields[type].fields[idx].bitmap = NULL;
 
     if (type == FLD_TYPE_COLUMN) {
       FILTER_SET_FLAG(info->fields[type].fields[idx].flag, FLD_DATA_NO_FREE);
@@ -2549,6 +2550,7 @@ int32_t filterGenerateComInfo(SFilterInfo *info) {
     info->cunits[i].rfunc = filterGetRangeCompFuncFromOptrs(unit->compare.optr, unit->compare.optr2);
     info->cunits[i].optr = FILTER_UNIT_OPTR(unit);
     info->cunits[i].colData = NULL;
+    info->cunits[i].colBitmap = NULL;
     info->cunits[i].colId = FILTER_UNIT_COL_ID(info, unit);
     
     if (unit->right.type == FLD_TYPE_VALUE) {
@@ -2592,6 +2594,7 @@ int32_t filterUpdateComUnits(SFilterInfo *info) {
     SFilterUnit *unit = &info->units[i];
 
     info->cunits[i].colData = FILTER_UNIT_COL_DATA(info, unit, 0);
+    info->cunits[i].colBitmap = FILTER_UNIT_COL_BITMAP(info, unit);
   }
 
   return TSDB_CODE_SUCCESS;
@@ -2796,7 +2799,7 @@ bool filterExecuteBasedOnStatisImpl(void *pinfo, int32_t numOfRows, int8_t** p,
         //} else {
           uint8_t optr = cunit->optr;
 
-          if (isNull(colData, cunit->dataType)) {
+          if (FILTER_UNIT_COL_IS_NULL(cunit, colData, i)) {
             (*p)[i] = optr == TSDB_RELATION_ISNULL ? true : false;
           } else {
             if (optr == TSDB_RELATION_NOTNULL) {
@@ -2886,7 +2889,7 @@ static FORCE_INLINE bool filterExecuteImplIsNull(void *pinfo, int32_t numOfRows,
   for (int32_t i = 0; i < numOfRows; ++i) {
     uint16_t uidx = info->groups[0].unitIdxs[0];
     void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    (*p)[i] = isNull(colData, info->cunits[uidx].dataType);
+    (*p)[i] = FILTER_UNIT_COL_IS_NULL(&info->cunits[uidx], colData, i);
     if ((*p)[i] == 0) {
       all = false;
     }    
@@ -2907,7 +2910,7 @@ static FORCE_INLINE bool filterExecuteImplNotNull(void *pinfo, int32_t numOfRows
   for (int32_t i = 0; i < numOfRows; ++i) {
     uint16_t uidx = info->groups[0].unitIdxs[0];
     void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    (*p)[i] = !isNull(colData, info->cunits[uidx].dataType);
+    (*p)[i] = !FILTER_UNIT_COL_IS_NULL(&info->cunits[uidx], colData, i);
     if ((*p)[i] == 0) {
       all = false;
     }
@@ -2931,6 +2934,26 @@ bool filterExecuteImplRange(void *pinfo, int32_t numOfRows, int8_t** p, SDataSta
   }
 
   *p = calloc(numOfRows, sizeof(int8_t));
+
+  // only the runs of valid rows are compared, the NULL rows are left unqualified
+  uint8_t *bitmap = info->cunits[0].colBitmap;
+  if (bitmap != NULL) {
+    all = (tdBitmapFind(bitmap, 0, numOfRows, false) == numOfRows);
+
+    for (int32_t s = tdBitmapFind(bitmap, 0, numOfRows, true); s < numOfRows; ) {
+      int32_t e = tdBitmapFind(bitmap, s, numOfRows, false);
+      char   *data = colData + dataSize * s;
+      for (int32_t i = s; i < e; ++i, data += dataSize) {
+        (*p)[i] = (*rfunc)(data, data, valData, valData2, func);
+        if ((*p)[i] == 0) {
+          all = false;
+        }
+      }
+      s = tdBitmapFind(bitmap, e, numOfRows, true);
+    }
+
+    return all;
+  }
   
   for (int32_t i = 0; i < numOfRows; ++i) {
     if (isNull(colData, info->cunits[0].dataType)) {
@@ -2964,7 +2987,7 @@ bool filterExecuteImplMisc(void *pinfo, int32_t numOfRows, int8_t** p, SDataStat
   for (int32_t i = 0; i < numOfRows; ++i) {
     uint16_t uidx = info->groups[0].unitIdxs[0];
     void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    if (isNull(colData, info->cunits[uidx].dataType)) {
+    if (FILTER_UNIT_COL_IS_NULL(&info->cunits[uidx], colData, i)) {
       all = false;
       continue;
     }
@@ -3005,7 +3028,7 @@ bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *
         //} else {
           uint8_t optr = cunit->optr;
 
-          if (isNull(colData, cunit->dataType)) {
+          if (FILTER_UNIT_COL_IS_NULL(cunit, colData, i)) {
             (*p)[i] = optr == TSDB_RELATION_ISNULL ? true : false;
           } else {
             if (optr == TSDB_RELATION_NOTNULL) {
@@ -3140,6 +3163,7 @@ int32_t filterSetColFieldData(SFilterInfo *info, int32_t numOfCols, SArray* pDat
       SColumnInfoData* pColInfo = taosArrayGet(pDataBlock, j);
       if (sch->colId == pColInfo->info.colId) {
         fi->data = pColInfo->pData;
+        fi->bitmap = pColInfo->pBitmap;
       
         break;
       }
@@ -3297,6 +3321,61 @@ bool filterRangeExecute(SFilterInfo *info, SDataStatis *pDataStatis, int32_t num
 
 
 
+static bool filterBloomUnitMayMatch(SFilterComUnit *cunit, filter_bloom_func func, void *param) {
+  if (cunit->optr == TSDB_RELATION_EQUAL) {
+    if (IS_VAR_DATA_TYPE(cunit->dataType)) {
+      return func(param, (int16_t)cunit->colId, varDataVal(cunit->valData), varDataLen(cunit->valData));
+    }
+
+    return func(param, (int16_t)cunit->colId, cunit->valData, tDataTypes[cunit->dataType].bytes);
+  }
+
+  // the in units of the other types are split into equal units
+  if (cunit->optr == TSDB_RELATION_IN && IS_VAR_DATA_TYPE(cunit->dataType)) {
+    SHashObj *set = (SHashObj *)cunit->valData;
+    void *p = taosHashIterate(set, NULL);
+    while (p) {
+      void *key = taosHashGetDataKey(set, p);
+      int32_t len = (int32_t)taosHashGetDataKeyLen(set, p);
+      if (func(param, (int16_t)cunit->colId, key, len)) {
+        taosHashCancelIterate(set, p);
+        return true;
+      }
+
+      p = taosHashIterate(set, p);
+    }
+
+    return false;
+  }
+
+  return true;
+}
+
+// check the equal and in conditions with the bloom filters of the block, false if no group can be matched
+bool filterBloomExecute(SFilterInfo *info, filter_bloom_func func, void *param) {
+  if (FILTER_EMPTY_RES(info)) {
+    return false;
+  }
+
+  if (FILTER_ALL_RES(info)) {
+    return true;
+  }
+
+  for (uint16_t g = 0; g < info->groupNum; ++g) {
+    SFilterGroup *group = &info->groups[g];
+    bool match = true;
+
+    for (uint16_t u = 0; u < group->unitNum && match; ++u) {
+      match = filterBloomUnitMayMatch(&info->cunits[group->unitIdxs[u]], func, param);
+    }
+
+    CHK_RET(match, true);
+  }
+
+  return false;
+}
+
+
 int32_t filterGetTimeRange(SFilterInfo *info, STimeWindow       *win) {
   SFilterRange ra = {0};
   SFilterRangeCtx *prev = filterInitRangeCtx(TSDB_DATA_TYPE_TIMESTAMP, FI_OPTION_TIMESTAMP);
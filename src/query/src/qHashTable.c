@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qHashTable.h"
+#include "hashfunc.h"
+
+#define QHASH_MIN_CAPACITY  16
+#define QHASH_ARENA_SIZE    (64 * 1024)
+#define QHASH_INDEX(_h, _c) ((_h) & ((_c) - 1))
+
+// the table grows before three quarters of the slots are used
+#define QHASH_NEED_GROW(_o) (((uint64_t)(_o)->size + 1) * 4 > (uint64_t)(_o)->capacity * 3)
+
+#define QHASH_SLOT_KEY(_s) (((_s)->keyLen <= QHASH_INLINE_KEY_LEN) ? (_s)->u.key : (_s)->u.pKey)
+
+// the keys of up to QHASH_INLINE_KEY_LEN bytes are mixed a word at a time, instead of MurmurHash3_32 byte by byte
+static FORCE_INLINE uint32_t qHashKey(const char *key, uint32_t keyLen) {
+  if (keyLen > QHASH_INLINE_KEY_LEN) {
+    return MurmurHash3_32(key, keyLen);
+  }
+
+  uint64_t h = keyLen * 0x9E3779B97F4A7C15ULL;
+  for (uint32_t i = 0; i < keyLen; i += sizeof(uint64_t)) {
+    uint64_t w = 0;
+    memcpy(&w, key + i, MIN(sizeof(uint64_t), keyLen - i));
+
+    h = (h ^ w) * 0xff51afd7ed558ccdULL;
+    h ^= h >> 32;
+  }
+
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 29;
+  return (uint32_t)h;
+}
+
+static FORCE_INLINE bool qHashKeyEqual(const SQHashSlot *pSlot, uint32_t hashVal, const void *key, uint32_t keyLen) {
+  return pSlot->hashVal == hashVal && pSlot->keyLen == keyLen && memcmp(QHASH_SLOT_KEY(pSlot), key, keyLen) == 0;
+}
+
+static SQHashSlot *qHashFind(SQHashObj *pHashObj, uint32_t hashVal, const void *key, uint32_t keyLen) {
+  uint32_t index = QHASH_INDEX(hashVal, pHashObj->capacity);
+
+  while (1) {
+    SQHashSlot *pSlot = &pHashObj->pSlots[index];
+    if (pSlot->keyLen == 0) {
+      return NULL;
+    }
+
+    if (qHashKeyEqual(pSlot, hashVal, key, keyLen)) {
+      return pSlot;
+    }
+
+    index = QHASH_INDEX(index + 1, pHashObj->capacity);
+  }
+}
+
+static char *qHashArenaAlloc(SQHashObj *pHashObj, int32_t len) {
+  SQHashArena *pArena = pHashObj->pArena;
+  if (pArena == NULL || pArena->size - pArena->used < len) {
+    int32_t size = MAX(QHASH_ARENA_SIZE, len);
+
+    pArena = malloc(sizeof(SQHashArena) + size);
+    if (pArena == NULL) {
+      return NULL;
+    }
+
+    pArena->next = pHashObj->pArena;
+    pArena->size = size;
+    pArena->used = 0;
+
+    pHashObj->pArena = pArena;
+    pHashObj->arenaSize += sizeof(SQHashArena) + size;
+  }
+
+  char *p = pArena->data + pArena->used;
+  pArena->used += len;
+  return p;
+}
+
+static int32_t qHashResize(SQHashObj *pHashObj, uint32_t newCapacity) {
+  SQHashSlot *pSlots = calloc(newCapacity, sizeof(SQHashSlot));
+  if (pSlots == NULL) {
+    return -1;
+  }
+
+  // the hash values are kept in the slots, so the keys are not hashed again
+  for (uint32_t i = 0; i < pHashObj->capacity; ++i) {
+    SQHashSlot *pSlot = &pHashObj->pSlots[i];
+    if (pSlot->keyLen == 0) {
+      continue;
+    }
+
+    uint32_t index = QHASH_INDEX(pSlot->hashVal, newCapacity);
+    while (pSlots[index].keyLen != 0) {
+      index = QHASH_INDEX(index + 1, newCapacity);
+    }
+
+    pSlots[index] = *pSlot;
+  }
+
+  tfree(pHashObj->pSlots);
+  pHashObj->pSlots = pSlots;
+  pHashObj->capacity = newCapacity;
+  return 0;
+}
+
+SQHashObj *qHashInit(size_t capacity) {
+  SQHashObj *pHashObj = calloc(1, sizeof(SQHashObj));
+  if (pHashObj == NULL) {
+    return NULL;
+  }
+
+  pHashObj->capacity = QHASH_MIN_CAPACITY;
+  while (pHashObj->capacity < capacity && pHashObj->capacity < (1u << 30)) {
+    pHashObj->capacity <<= 1;
+  }
+
+  pHashObj->pSlots = calloc(pHashObj->capacity, sizeof(SQHashSlot));
+  if (pHashObj->pSlots == NULL) {
+    free(pHashObj);
+    return NULL;
+  }
+
+  return pHashObj;
+}
+
+void *qHashGet(SQHashObj *pHashObj, const void *key, size_t keyLen) {
+  if (pHashObj->size == 0) {
+    return NULL;
+  }
+
+  SQHashSlot *pSlot = qHashFind(pHashObj, qHashKey(key, (uint32_t)keyLen), key, (uint32_t)keyLen);
+  return (pSlot == NULL) ? NULL : pSlot->data;
+}
+
+int32_t qHashPut(SQHashObj *pHashObj, const void *key, size_t keyLen, const void *data, size_t dataLen) {
+  assert(keyLen > 0 && dataLen <= QHASH_MAX_DATA_LEN);
+
+  uint32_t hashVal = qHashKey(key, (uint32_t)keyLen);
+
+  SQHashSlot *pSlot = qHashFind(pHashObj, hashVal, key, (uint32_t)keyLen);
+  if (pSlot != NULL) {
+    memcpy(pSlot->data, data, dataLen);
+    return 0;
+  }
+
+  if (QHASH_NEED_GROW(pHashObj) && qHashResize(pHashObj, pHashObj->capacity << 1) != 0) {
+    return -1;
+  }
+
+  uint32_t index = QHASH_INDEX(hashVal, pHashObj->capacity);
+  while (pHashObj->pSlots[index].keyLen != 0) {
+    index = QHASH_INDEX(index + 1, pHashObj->capacity);
+  }
+
+  pSlot = &pHashObj->pSlots[index];
+  if (keyLen <= QHASH_INLINE_KEY_LEN) {
+    memcpy(pSlot->u.key, key, keyLen);
+  } else {
+    pSlot->u.pKey = qHashArenaAlloc(pHashObj, (int32_t)keyLen);
+    if (pSlot->u.pKey == NULL) {
+      return -1;
+    }
+
+    memcpy(pSlot->u.pKey, key, keyLen);
+  }
+
+  pSlot->hashVal = hashVal;
+  pSlot->keyLen = (uint32_t)keyLen;
+  memcpy(pSlot->data, data, dataLen);
+
+  pHashObj->size += 1;
+  return 0;
+}
+
+int32_t qHashRemove(SQHashObj *pHashObj, const void *key, size_t keyLen) {
+  if (pHashObj->size == 0) {
+    return -1;
+  }
+
+  SQHashSlot *pSlot = qHashFind(pHashObj, qHashKey(key, (uint32_t)keyLen), key, (uint32_t)keyLen);
+  if (pSlot == NULL) {
+    return -1;
+  }
+
+  // move back the following slots of the run that may not be found any more through the emptied slot
+  uint32_t hole = (uint32_t)(pSlot - pHashObj->pSlots);
+  uint32_t index = hole;
+  while (1) {
+    index = QHASH_INDEX(index + 1, pHashObj->capacity);
+
+    SQHashSlot *pNext = &pHashObj->pSlots[index];
+    if (pNext->keyLen == 0) {
+      break;
+    }
+
+    // the distance from the home slot of the key, which must not become shorter than the distance of the hole
+    uint32_t home = QHASH_INDEX(pNext->hashVal, pHashObj->capacity);
+    if (QHASH_INDEX(index - home, pHashObj->capacity) >= QHASH_INDEX(index - hole, pHashObj->capacity)) {
+      pHashObj->pSlots[hole] = *pNext;
+      hole = index;
+    }
+  }
+
+  memset(&pHashObj->pSlots[hole], 0, sizeof(SQHashSlot));
+  pHashObj->size -= 1;
+  return 0;
+}
+
+static void qHashFreeArena(SQHashObj *pHashObj) {
+  while (pHashObj->pArena != NULL) {
+    SQHashArena *pNext = pHashObj->pArena->next;
+    free(pHashObj->pArena);
+    pHashObj->pArena = pNext;
+  }
+
+  pHashObj->arenaSize = 0;
+}
+
+void qHashClear(SQHashObj *pHashObj) {
+  if (pHashObj == NULL) {
+    return;
+  }
+
+  memset(pHashObj->pSlots, 0, sizeof(SQHashSlot) * pHashObj->capacity);
+  pHashObj->size = 0;
+  qHashFreeArena(pHashObj);
+}
+
+size_t qHashGetSize(const SQHashObj *pHashObj) {
+  return (pHashObj == NULL) ? 0 : pHashObj->size;
+}
+
+size_t qHashGetMemSize(const SQHashObj *pHashObj) {
+  if (pHashObj == NULL) {
+    return 0;
+  }
+
+  return sizeof(SQHashObj) + sizeof(SQHashSlot) * pHashObj->capacity + pHashObj->arenaSize;
+}
+
+void qHashCleanup(SQHashObj *pHashObj) {
+  if (pHashObj == NULL) {
+    return;
+  }
+
+  qHashFreeArena(pHashObj);
+  tfree(pHashObj->pSlots);
+  free(pHashObj);
+}
@@ -155,6 +155,12 @@ int32_t qCreateQueryInfo(void* tsdb, int32_t vgId, SQueryTableMsg* pQueryMsg, qi
       qDebug("qmsg:%p query on %u tables in one group from client", pQueryMsg, tableGroupInfo.numOfTables);
     }
 
+    // the other partitions of the tables are queried by other msgs, which the vnode runs in parallel
+    if (pQueryMsg->numOfPartitions > 1) {
+      tsdbPartitionTableGroup(&tableGroupInfo, pQueryMsg->numOfPartitions, pQueryMsg->partitionIndex);
+      qDebug("qmsg:%p query partition %d of %d", pQueryMsg, pQueryMsg->partitionIndex, pQueryMsg->numOfPartitions);
+    }
+
     int64_t el = taosGetTimestampUs() - st;
     qDebug("qmsg:%p tag filter completed, numOfTables:%u, elapsed time:%"PRId64"us", pQueryMsg, tableGroupInfo.numOfTables, el);
   } else {
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taosdef.h"
+#include "ttype.h"
+
+#include "qAggKernel.h"
+
+/*
+ * Rows per second of sum/avg/min/max/count over one column block. The "row" column is the row by row loop that
+ * sum_function/min_function used before the kernels, the other two are the kernels with and without SIMD.
+ */
+
+typedef struct {
+  const char *name;
+  int32_t     type;
+  int32_t     bytes;
+} SBenchType;
+
+static SBenchType types[] = {
+    {"tinyint", TSDB_DATA_TYPE_TINYINT, 1},   {"smallint", TSDB_DATA_TYPE_SMALLINT, 2},
+    {"int", TSDB_DATA_TYPE_INT, 4},           {"bigint", TSDB_DATA_TYPE_BIGINT, 8},
+    {"utinyint", TSDB_DATA_TYPE_UTINYINT, 1}, {"usmallint", TSDB_DATA_TYPE_USMALLINT, 2},
+    {"uint", TSDB_DATA_TYPE_UINT, 4},         {"ubigint", TSDB_DATA_TYPE_UBIGINT, 8},
+    {"float", TSDB_DATA_TYPE_FLOAT, 4},       {"double", TSDB_DATA_TYPE_DOUBLE, 8},
+};
+
+static const char *funcs[] = {"sum", "avg", "min", "max", "count"};
+
+// the loops of the former LIST_ADD_N and TYPED_LOOPCHECK_N macros
+#define ROW_SUM(T, acc)                                           \
+  do {                                                            \
+    T *d = (T *)data;                                             \
+    for (int32_t i = 0; i < rows; ++i) {                          \
+      if (hasNull && isNull((char *)&d[i], type)) continue;       \
+      (acc) += d[i];                                              \
+      n++;                                                        \
+    }                                                             \
+  } while (0)
+
+#define ROW_MINMAX(T)                                             \
+  do {                                                            \
+    T *d = (T *)data;                                             \
+    T  m = d[0];                                                  \
+    for (int32_t i = 0; i < rows; ++i) {                          \
+      if (hasNull && isNull((char *)&d[i], type)) continue;       \
+      if ((m < d[i]) ^ isMin) {                                   \
+        m = d[i];                                                 \
+        n++;                                                      \
+      }                                                           \
+    }                                                             \
+    sink += (double)m;                                            \
+  } while (0)
+
+static double sink = 0;
+
+static int32_t rowFunc(int32_t func, const SBenchType *pType, void *data, int32_t rows, bool hasNull) {
+  int32_t  type = pType->type;
+  int32_t  n = 0;
+  int64_t  isum = 0;
+  uint64_t usum = 0;
+  double   dsum = 0;
+  bool     isMin = (func == 2);
+
+  if (func == 4) {
+    for (int32_t i = 0; i < rows; ++i) {
+      if (hasNull && isNull((char *)data + i * pType->bytes, type)) continue;
+      n++;
+    }
+    return n;
+  }
+
+  if (func == 0 || func == 1) {
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT: if (func == 0) ROW_SUM(int8_t, isum); else ROW_SUM(int8_t, dsum); break;
+      case TSDB_DATA_TYPE_SMALLINT: if (func == 0) ROW_SUM(int16_t, isum); else ROW_SUM(int16_t, dsum); break;
+      case TSDB_DATA_TYPE_INT: if (func == 0) ROW_SUM(int32_t, isum); else ROW_SUM(int32_t, dsum); break;
+      case TSDB_DATA_TYPE_BIGINT: if (func == 0) ROW_SUM(int64_t, isum); else ROW_SUM(int64_t, dsum); break;
+      case TSDB_DATA_TYPE_UTINYINT: if (func == 0) ROW_SUM(uint8_t, usum); else ROW_SUM(uint8_t, dsum); break;
+      case TSDB_DATA_TYPE_USMALLINT: if (func == 0) ROW_SUM(uint16_t, usum); else ROW_SUM(uint16_t, dsum); break;
+      case TSDB_DATA_TYPE_UINT: if (func == 0) ROW_SUM(uint32_t, usum); else ROW_SUM(uint32_t, dsum); break;
+      case TSDB_DATA_TYPE_UBIGINT: if (func == 0) ROW_SUM(uint64_t, usum); else ROW_SUM(uint64_t, dsum); break;
+      case TSDB_DATA_TYPE_FLOAT: ROW_SUM(float, dsum); break;
+      case TSDB_DATA_TYPE_DOUBLE: ROW_SUM(double, dsum); break;
+    }
+    sink += (double)isum + (double)usum + dsum;
+    return n;
+  }
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT: ROW_MINMAX(int8_t); break;
+    case TSDB_DATA_TYPE_SMALLINT: ROW_MINMAX(int16_t); break;
+    case TSDB_DATA_TYPE_INT: ROW_MINMAX(int32_t); break;
+    case TSDB_DATA_TYPE_BIGINT: ROW_MINMAX(int64_t); break;
+    case TSDB_DATA_TYPE_UTINYINT: ROW_MINMAX(uint8_t); break;
+    case TSDB_DATA_TYPE_USMALLINT: ROW_MINMAX(uint16_t); break;
+    case TSDB_DATA_TYPE_UINT: ROW_MINMAX(uint32_t); break;
+    case TSDB_DATA_TYPE_UBIGINT: ROW_MINMAX(uint64_t); break;
+    case TSDB_DATA_TYPE_FLOAT: ROW_MINMAX(float); break;
+    case TSDB_DATA_TYPE_DOUBLE: ROW_MINMAX(double); break;
+  }
+  return n;
+}
+
+// the same split by type as sum_function/avg_function/min_function and count_function
+static int32_t kernelFunc(int32_t func, const SBenchType *pType, void *data, int32_t rows, bool hasNull) {
+  int32_t type = pType->type;
+  int32_t n = 0;
+  int64_t isum = 0;
+  double  dsum = 0;
+  int32_t index = -1;
+
+  switch (func) {
+    case 0:
+      if (IS_FLOAT_TYPE(type)) {
+        n = aggSumDouble(data, type, rows, hasNull, &dsum);
+      } else {
+        n = aggSumInteger(data, type, rows, hasNull, &isum);
+      }
+      break;
+    case 1:
+      if (IS_FLOAT_TYPE(type) || type == TSDB_DATA_TYPE_BIGINT || type == TSDB_DATA_TYPE_UBIGINT) {
+        n = aggSumDouble(data, type, rows, hasNull, &dsum);
+      } else {
+        n = aggSumInteger(data, type, rows, hasNull, &isum);
+      }
+      break;
+    case 2:
+    case 3:
+      n = aggMinMax(data, type, rows, hasNull, func == 2, &index);
+      break;
+    default:
+      n = aggCountNotNull(data, type, pType->bytes, rows);
+      break;
+  }
+
+  sink += (double)isum + dsum + index;
+  return n;
+}
+
+static void fillData(const SBenchType *pType, char *data, int32_t rows, bool hasNull) {
+  for (int32_t i = 0; i < rows; ++i) {
+    char *p = data + i * pType->bytes;
+    if (hasNull && rand() % 10 == 0) {
+      setNull(p, pType->type, pType->bytes);
+      continue;
+    }
+
+    int64_t v = rand() % 2000 - 1000;
+    switch (pType->type) {
+      case TSDB_DATA_TYPE_TINYINT: *(int8_t *)p = (int8_t)(v % 100); break;
+      case TSDB_DATA_TYPE_SMALLINT: *(int16_t *)p = (int16_t)v; break;
+      case TSDB_DATA_TYPE_INT: *(int32_t *)p = (int32_t)v; break;
+      case TSDB_DATA_TYPE_BIGINT: *(int64_t *)p = v; break;
+      case TSDB_DATA_TYPE_UTINYINT: *(uint8_t *)p = (uint8_t)(v & 0x7F); break;
+      case TSDB_DATA_TYPE_USMALLINT: *(uint16_t *)p = (uint16_t)(v + 1000); break;
+      case TSDB_DATA_TYPE_UINT: *(uint32_t *)p = (uint32_t)(v + 1000); break;
+      case TSDB_DATA_TYPE_UBIGINT: *(uint64_t *)p = (uint64_t)(v + 1000); break;
+      case TSDB_DATA_TYPE_FLOAT: *(float *)p = (float)v / 3; break;
+      case TSDB_DATA_TYPE_DOUBLE: *(double *)p = (double)v / 3; break;
+    }
+  }
+}
+
+static double mRowsPerSec(int64_t rows, int64_t us) { return us > 0 ? (double)rows / us : 0; }
+
+int main(int argc, char *argv[]) {
+  int32_t rows = 4096;
+  int32_t loops = 5000;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && i < argc - 1) {
+      loops = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-r]: rows per block, default: %d\n", rows);
+      printf("  [-l]: number of loops, default: %d\n", loops);
+      exit(0);
+    }
+  }
+
+  int32_t simd = aggGetSimdLevel();
+  char *  data = malloc((size_t)rows * sizeof(int64_t));
+
+  printf("rows:%d loops:%d simd level:%d, throughput in million rows/s\n", rows, loops, simd);
+  printf("%-10s %-6s %-5s %10s %10s %10s\n", "type", "func", "null", "row", "kernel", "kernel-simd");
+
+  for (int32_t t = 0; t < tListLen(types); t++) {
+    for (int32_t nulls = 0; nulls < 2; nulls++) {
+      srand(t);
+      fillData(&types[t], data, rows, nulls);
+
+      for (int32_t f = 0; f < tListLen(funcs); f++) {
+        int64_t st = taosGetTimestampUs();
+        for (int32_t l = 0; l < loops; l++) rowFunc(f, &types[t], data, rows, nulls);
+        int64_t rowUs = taosGetTimestampUs() - st;
+
+        aggSetSimdLevel(AGG_SIMD_NONE);
+        st = taosGetTimestampUs();
+        for (int32_t l = 0; l < loops; l++) kernelFunc(f, &types[t], data, rows, nulls);
+        int64_t scalarUs = taosGetTimestampUs() - st;
+
+        aggSetSimdLevel(simd);
+        st = taosGetTimestampUs();
+        for (int32_t l = 0; l < loops; l++) kernelFunc(f, &types[t], data, rows, nulls);
+        int64_t simdUs = taosGetTimestampUs() - st;
+
+        int64_t total = (int64_t)rows * loops;
+        printf("%-10s %-6s %-5s %10.1f %10.1f %10.1f\n", types[t].name, funcs[f], nulls ? "10%" : "no",
+               mRowsPerSec(total, rowUs), mRowsPerSec(total, scalarUs), mRowsPerSec(total, simdUs));
+      }
+    }
+  }
+
+  free(data);
+  return sink == 0.12345 ? 1 : 0;
+}
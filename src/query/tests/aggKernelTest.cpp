@@ -0,0 +1,322 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "taosdef.h"
+#include "tdataformat.h"
+#include "ttype.h"
+
+#include "qAggKernel.h"
+
+namespace {
+
+const int32_t kRows[] = {0, 1, 3, 7, 8, 31, 32, 33, 100, 4096};
+const double  kNullRatio[] = {0, 0.3, 1.0};
+
+template <typename T>
+void setNullValue(T *v, int32_t type) {
+  setNull((char *)v, type, sizeof(T));
+}
+
+// random values of the full range of the type, some of them NULL
+template <typename T>
+std::vector<T> genData(int32_t type, int32_t rows, double nullRatio, std::mt19937_64 &gen, int32_t range) {
+  std::vector<T>                         data(rows);
+  std::uniform_real_distribution<double> coin(0, 1);
+  for (int32_t i = 0; i < rows; ++i) {
+    if (coin(gen) < nullRatio) {
+      setNullValue(&data[i], type);
+      continue;
+    }
+
+    do {
+      if (IS_FLOAT_TYPE(type)) {
+        data[i] = (T)((double)(int64_t)(gen() % 20001 - 10000) / 8);
+      } else if (range > 0) {
+        data[i] = (T)(gen() % range);  // small range to have ties
+      } else {
+        data[i] = (T)gen();
+      }
+    } while (isNull(&data[i], type));
+  }
+  return data;
+}
+
+template <typename T>
+void checkKernels(int32_t type) {
+  std::mt19937_64 gen(11);
+
+  for (int32_t rows : kRows) {
+    for (double ratio : kNullRatio) {
+      for (int32_t range : {0, 5}) {
+        std::vector<T> data = genData<T>(type, rows, ratio, gen, range);
+        bool           hasNull = ratio > 0;
+
+        // reference results, computed row by row
+        uint64_t isum = 0;
+        double   dsum = 0;
+        int32_t  n = 0, minIdx = -1, maxIdx = -1;
+        for (int32_t i = 0; i < rows; ++i) {
+          if (isNull(&data[i], type)) continue;
+          n++;
+          isum += (uint64_t)(int64_t)data[i];
+          dsum += (double)data[i];
+          if (minIdx < 0 || data[i] <= data[minIdx]) minIdx = i;
+          if (maxIdx < 0 || data[i] > data[maxIdx]) maxIdx = i;
+        }
+
+        for (int32_t level : {AGG_SIMD_NONE, AGG_SIMD_AVX2}) {
+          aggSetSimdLevel(level);
+
+          EXPECT_EQ(aggCountNotNull(data.data(), type, sizeof(T), rows), n);
+
+          if (!IS_FLOAT_TYPE(type)) {
+            int64_t sum = 0;
+            EXPECT_EQ(aggSumInteger(data.data(), type, rows, hasNull, &sum), n);
+            EXPECT_EQ((uint64_t)sum, isum);
+          }
+
+          double sum = 0;
+          EXPECT_EQ(aggSumDouble(data.data(), type, rows, hasNull, &sum), n);
+          EXPECT_NEAR(sum, dsum, 1e-9 * (fabs(dsum) + 1));
+
+          int32_t index = -2;
+          EXPECT_EQ(aggMinMax(data.data(), type, rows, hasNull, true, &index), n);
+          EXPECT_EQ(index, minIdx) << "rows:" << rows << " ratio:" << ratio << " level:" << level;
+          EXPECT_EQ(aggMinMax(data.data(), type, rows, hasNull, false, &index), n);
+          EXPECT_EQ(index, maxIdx) << "rows:" << rows << " ratio:" << ratio << " level:" << level;
+        }
+      }
+    }
+  }
+
+  aggSetSimdLevel(AGG_SIMD_AVX2);
+}
+
+}  // namespace
+
+TEST(testCase, agg_kernel_signed_test) {
+  checkKernels<int8_t>(TSDB_DATA_TYPE_TINYINT);
+  checkKernels<int16_t>(TSDB_DATA_TYPE_SMALLINT);
+  checkKernels<int32_t>(TSDB_DATA_TYPE_INT);
+  checkKernels<int64_t>(TSDB_DATA_TYPE_BIGINT);
+}
+
+TEST(testCase, agg_kernel_unsigned_test) {
+  checkKernels<uint8_t>(TSDB_DATA_TYPE_UTINYINT);
+  checkKernels<uint16_t>(TSDB_DATA_TYPE_USMALLINT);
+  checkKernels<uint32_t>(TSDB_DATA_TYPE_UINT);
+  checkKernels<uint64_t>(TSDB_DATA_TYPE_UBIGINT);
+}
+
+TEST(testCase, agg_kernel_float_test) {
+  checkKernels<float>(TSDB_DATA_TYPE_FLOAT);
+  checkKernels<double>(TSDB_DATA_TYPE_DOUBLE);
+}
+
+// a column without NULL in its statistics is summed as it is, the NULL bits included
+TEST(testCase, agg_kernel_no_null_test) {
+  std::vector<int8_t> data(100, 1);
+  data[40] = (int8_t)TSDB_DATA_TINYINT_NULL;
+
+  for (int32_t level : {AGG_SIMD_NONE, AGG_SIMD_AVX2}) {
+    aggSetSimdLevel(level);
+
+    int64_t sum = 0;
+    EXPECT_EQ(aggSumInteger(data.data(), TSDB_DATA_TYPE_TINYINT, 100, false, &sum), 100);
+    EXPECT_EQ(sum, 99 - 128);
+    EXPECT_EQ(aggSumInteger(data.data(), TSDB_DATA_TYPE_TINYINT, 100, true, &sum), 99);
+    EXPECT_EQ(sum, 99);
+  }
+
+  aggSetSimdLevel(AGG_SIMD_AVX2);
+}
+
+TEST(testCase, agg_bitmap_ops_test) {
+  std::mt19937_64   gen(5);
+  const int32_t     n = 1000;
+  std::vector<bool> ref(n);
+  uint8_t           bitmap[TD_BITMAP_BYTES(1000)] = {0};
+
+  for (int32_t i = 0; i < n; ++i) {
+    ref[i] = (i / 70) % 3 == 0 || gen() % 4 == 0;  // long runs of both values and some noise
+    tdBitmapSetTo(bitmap, i, ref[i]);
+  }
+
+  for (int32_t start : {0, 1, 7, 8, 63, 64, 65, 500}) {
+    for (int32_t end : {start, start + 1, start + 9, start + 64, start + 130, n}) {
+      if (end > n) continue;
+
+      int32_t count = 0, firstSet = end, firstClear = end;
+      for (int32_t i = end - 1; i >= start; --i) {
+        count += ref[i];
+        if (ref[i]) firstSet = i;
+        if (!ref[i]) firstClear = i;
+      }
+      EXPECT_EQ(tdBitmapCount(bitmap, start, end - start), count);
+      EXPECT_EQ(tdBitmapFind(bitmap, start, end, true), firstSet);
+      EXPECT_EQ(tdBitmapFind(bitmap, start, end, false), firstClear);
+    }
+  }
+
+  // moving to the front, like the compaction of a block, in place
+  uint8_t moved[TD_BITMAP_BYTES(1000)];
+  for (int32_t from : {0, 3, 8, 64, 77}) {
+    memcpy(moved, bitmap, sizeof(bitmap));
+    tdBitmapCopy(moved, 0, moved, from, n - from);
+    for (int32_t i = 0; i < n - from; ++i) {
+      ASSERT_EQ(tdBitmapIsSet(moved, i), ref[i + from]) << "from:" << from << " i:" << i;
+    }
+  }
+
+  memcpy(moved, bitmap, sizeof(bitmap));
+  tdBitmapSetRange(moved, 5, 200, false);
+  EXPECT_EQ(tdBitmapFind(moved, 5, 205, true), 205);
+  tdBitmapSetRange(moved, 13, 100, true);
+  EXPECT_EQ(tdBitmapCount(moved, 0, n), tdBitmapCount(bitmap, 0, 5) + 100 + tdBitmapCount(bitmap, 205, n - 205));
+
+  std::vector<int32_t> data(n);
+  for (int32_t i = 0; i < n; ++i) {
+    data[i] = ref[i] ? (int32_t)i : (int32_t)TSDB_DATA_INT_NULL;
+  }
+  memset(moved, 0, sizeof(moved));
+  EXPECT_EQ(tdBitmapFromData(moved, data.data(), NULL, TSDB_DATA_TYPE_INT, n), n - tdBitmapCount(bitmap, 0, n));
+  EXPECT_EQ(memcmp(moved, bitmap, (n + 7) / 8), 0);
+}
+
+namespace {
+
+// the kernels over a bitmap give the same results as the kernels checking the NULL values
+template <typename T>
+void checkBitmapKernels(int32_t type) {
+  std::mt19937_64 gen(13);
+
+  for (int32_t rows : kRows) {
+    for (double ratio : kNullRatio) {
+      for (int32_t offset : {0, 5, 64}) {
+        std::vector<T> data = genData<T>(type, rows, ratio, gen, 5);
+        std::vector<uint8_t> bitmap(TD_BITMAP_BYTES(rows + offset) + 8);
+        for (int32_t i = 0; i < rows; ++i) {
+          tdBitmapSetTo(bitmap.data(), i + offset, !isNull(&data[i], type));
+        }
+
+        if (!IS_FLOAT_TYPE(type)) {
+          int64_t s1 = 0, s2 = 0;
+          EXPECT_EQ(aggSumIntegerBitmap(data.data(), type, rows, bitmap.data(), offset, &s1),
+                    aggSumInteger(data.data(), type, rows, true, &s2));
+          EXPECT_EQ(s1, s2);
+        }
+
+        double d1 = 0, d2 = 0;
+        EXPECT_EQ(aggSumDoubleBitmap(data.data(), type, rows, bitmap.data(), offset, &d1),
+                  aggSumDouble(data.data(), type, rows, true, &d2));
+        EXPECT_NEAR(d1, d2, 1e-9 * (fabs(d2) + 1));
+
+        for (bool isMin : {true, false}) {
+          int32_t i1 = -2, i2 = -2;
+          EXPECT_EQ(aggMinMaxBitmap(data.data(), type, rows, bitmap.data(), offset, isMin, &i1),
+                    aggMinMax(data.data(), type, rows, true, isMin, &i2));
+          EXPECT_EQ(i1, i2) << "rows:" << rows << " ratio:" << ratio << " offset:" << offset;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(testCase, agg_kernel_bitmap_test) {
+  checkBitmapKernels<int8_t>(TSDB_DATA_TYPE_TINYINT);
+  checkBitmapKernels<int32_t>(TSDB_DATA_TYPE_INT);
+  checkBitmapKernels<uint16_t>(TSDB_DATA_TYPE_USMALLINT);
+  checkBitmapKernels<uint64_t>(TSDB_DATA_TYPE_UBIGINT);
+  checkBitmapKernels<float>(TSDB_DATA_TYPE_FLOAT);
+  checkBitmapKernels<double>(TSDB_DATA_TYPE_DOUBLE);
+}
+
+// the rows set to NULL when two sub-blocks are merged are not counted by the kernels over the bitmap
+TEST(testCase, agg_bitmap_merge_null_test) {
+  STSchemaBuilder builder;
+  tdInitTSchemaBuilder(&builder, 0);
+  tdAddColToSchema(&builder, TSDB_DATA_TYPE_TIMESTAMP, PRIMARYKEY_TIMESTAMP_COL_INDEX, 8);
+  tdAddColToSchema(&builder, TSDB_DATA_TYPE_INT, 2, 4);
+  tdAddColToSchema(&builder, TSDB_DATA_TYPE_BINARY, 3, 12);
+  STSchema *pSchema = tdGetSchemaFromBuilder(&builder);
+  tdDestroyTSchemaBuilder(&builder);
+  ASSERT_NE(pSchema, nullptr);
+
+  const int32_t rows = 100;
+  SDataCols    *target = tdNewDataCols(3, rows * 2);
+  SDataCols    *source = tdNewDataCols(3, rows * 2);
+  ASSERT_EQ(tdInitDataCols(target, pSchema), 0);
+  ASSERT_EQ(tdInitDataCols(source, pSchema), 0);
+
+  int32_t nullInt = TSDB_DATA_INT_NULL;
+  char    nullBin[16] = {0};
+  setVardataNull(nullBin, TSDB_DATA_TYPE_BINARY);
+
+  // the first sub-block has the even keys, the second one the odd keys and every fourth even key again, its int
+  // column is all NULL and is set to NULL row by row in the merged block
+  for (int32_t i = 0; i < rows; ++i) {
+    TSKEY   key = i * 2;
+    int32_t val = i;
+    char    bin[16];
+    STR_TO_VARSTR(bin, "abc");
+    bool isNullRow = i % 5 == 3;
+    dataColAppendVal(target->cols, &key, target->numOfRows, target->maxPoints);
+    dataColAppendVal(target->cols + 1, isNullRow ? &nullInt : &val, target->numOfRows, target->maxPoints);
+    dataColAppendVal(target->cols + 2, isNullRow ? nullBin : bin, target->numOfRows, target->maxPoints);
+    target->numOfRows++;
+  }
+
+  for (int32_t i = 0; i < rows; ++i) {
+    TSKEY key = (i % 4 == 2) ? i * 2 : i * 2 + 1;
+    char  bin[16];
+    STR_TO_VARSTR(bin, "xyz");
+    bool isNullRow = i % 3 == 2;  // the first row is not NULL, it tells the column is not empty
+    dataColAppendVal(source->cols, &key, source->numOfRows, source->maxPoints);
+    dataColAppendVal(source->cols + 1, &nullInt, source->numOfRows, source->maxPoints);
+    dataColAppendVal(source->cols + 2, isNullRow ? nullBin : bin, source->numOfRows, source->maxPoints);
+    source->numOfRows++;
+  }
+
+  for (bool forceSetNull : {true, false}) {
+    SDataCols *pMerged = tdDupDataCols(target, true);
+    ASSERT_NE(pMerged, nullptr);
+    ASSERT_EQ(tdMergeDataCols(pMerged, source, source->numOfRows, NULL, forceSetNull), 0);
+
+    int32_t n = pMerged->numOfRows;
+    int32_t count = 0, binCount = 0, minIdx = -1, maxIdx = -1;
+    int64_t sum = 0;
+    int32_t *data = (int32_t *)pMerged->cols[1].pData;
+    for (int32_t i = 0; i < n; ++i) {
+      if (!isNull((char *)tdGetColDataOfRow(pMerged->cols + 2, i), TSDB_DATA_TYPE_BINARY)) binCount++;
+      if (isNull((char *)&data[i], TSDB_DATA_TYPE_INT)) continue;
+      count++;
+      sum += data[i];
+      if (minIdx < 0 || data[i] < data[minIdx]) minIdx = i;
+      if (maxIdx < 0 || data[i] > data[maxIdx]) maxIdx = i;
+    }
+    EXPECT_LT(count, n);
+
+    EXPECT_EQ(tdBitmapCount(pMerged->cols[1].pBitmap, 0, n), count);
+    EXPECT_EQ(tdBitmapCount(pMerged->cols[2].pBitmap, 0, n), binCount);
+
+    int64_t bsum = 0;
+    EXPECT_EQ(aggSumIntegerBitmap(data, TSDB_DATA_TYPE_INT, n, pMerged->cols[1].pBitmap, 0, &bsum), count);
+    EXPECT_EQ(bsum, sum);
+
+    int32_t index = -2;
+    EXPECT_EQ(aggMinMaxBitmap(data, TSDB_DATA_TYPE_INT, n, pMerged->cols[1].pBitmap, 0, true, &index), count);
+    EXPECT_EQ(index, minIdx);
+    EXPECT_EQ(aggMinMaxBitmap(data, TSDB_DATA_TYPE_INT, n, pMerged->cols[1].pBitmap, 0, false, &index), count);
+    EXPECT_EQ(index, maxIdx);
+
+    tdFreeDataCols(pMerged);
+  }
+
+  tdFreeDataCols(target);
+  tdFreeDataCols(source);
+  tdFreeSchema(pSchema);
+}
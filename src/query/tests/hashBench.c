@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "hash.h"
+#include "taosdef.h"
+
+#include "qHashTable.h"
+
+/*
+ * Million rows per second of the group by access pattern of the executor: the key of each row is looked up and put
+ * if it is new, with keys of a table uid and a column value. The "chained" column is SHashObj, which the result rows
+ * used before, the "open" column is SQHashObj. The memory of the nodes of SHashObj does not count the malloc overhead.
+ */
+
+static const int32_t keyLens[] = {12, 16, 24, 40};
+
+static void makeKey(char *buf, int32_t keyLen, int64_t v) {
+  uint64_t uid = 1000;
+  memset(buf, 0, keyLen);
+  memcpy(buf, &uid, sizeof(uid));
+  memcpy(buf + sizeof(uid), &v, MIN(sizeof(v), keyLen - sizeof(uid)));
+}
+
+static double mRowsPerSec(int64_t rows, int64_t us) { return us > 0 ? (double)rows / us : 0; }
+
+int main(int argc, char *argv[]) {
+  int32_t rows = 10000000;
+  int32_t groups = 1000000;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-g") == 0 && i < argc - 1) {
+      groups = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-r]: number of rows, default: %d\n", rows);
+      printf("  [-g]: number of distinct keys, default: %d\n", groups);
+      exit(0);
+    }
+  }
+
+  int64_t *values = malloc(sizeof(int64_t) * rows);
+  srand(1);
+  for (int32_t i = 0; i < rows; ++i) {
+    values[i] = (((int64_t)rand() << 31) ^ rand()) % groups;
+  }
+
+  printf("rows:%d groups:%d, throughput in million rows/s, memory in MB\n", rows, groups);
+  printf("%-6s %10s %10s %10s %10s\n", "keyLen", "chained", "open", "chainedMem", "openMem");
+
+  char    key[64];
+  int64_t sum = 0;
+
+  for (int32_t k = 0; k < tListLen(keyLens); ++k) {
+    int32_t keyLen = keyLens[k];
+
+    SHashObj *pChained = taosHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+    int64_t   st = taosGetTimestampUs();
+    for (int32_t i = 0; i < rows; ++i) {
+      makeKey(key, keyLen, values[i]);
+      void **p = taosHashGet(pChained, key, keyLen);
+      if (p == NULL) {
+        void *v = &values[i];
+        taosHashPut(pChained, key, keyLen, &v, POINTER_BYTES);
+      } else {
+        sum += (int64_t)(*p != NULL);
+      }
+    }
+    int64_t chainedUs = taosGetTimestampUs() - st;
+    size_t  chainedMem = taosHashGetMemSize(pChained) + taosHashGetSize(pChained) * (keyLen + POINTER_BYTES);
+    taosHashCleanup(pChained);
+
+    SQHashObj *pOpen = qHashInit(16);
+    st = taosGetTimestampUs();
+    for (int32_t i = 0; i < rows; ++i) {
+      makeKey(key, keyLen, values[i]);
+      void **p = qHashGet(pOpen, key, keyLen);
+      if (p == NULL) {
+        void *v = &values[i];
+        qHashPut(pOpen, key, keyLen, &v, POINTER_BYTES);
+      } else {
+        sum += (int64_t)(*p != NULL);
+      }
+    }
+    int64_t openUs = taosGetTimestampUs() - st;
+    size_t  openMem = qHashGetMemSize(pOpen);
+    qHashCleanup(pOpen);
+
+    printf("%-6d %10.1f %10.1f %10.1f %10.1f\n", keyLen, mRowsPerSec(rows, chainedUs), mRowsPerSec(rows, openUs),
+           chainedMem / 1048576.0, openMem / 1048576.0);
+  }
+
+  free(values);
+  return sum == -1 ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+
+#include "qHashTable.h"
+
+namespace {
+
+std::string makeKey(uint64_t uid, int64_t v, size_t len) {
+  std::string key(len, 'x');
+  memcpy(&key[0], &uid, sizeof(uid));
+  memcpy(&key[sizeof(uid)], &v, std::min(sizeof(v), len - sizeof(uid)));
+  return key;
+}
+
+}  // namespace
+
+TEST(testCase, qhash_put_get_test) {
+  SQHashObj *pHashObj = qHashInit(4);
+
+  // keys kept in the slot and in the arena
+  for (int64_t i = 0; i < 1000; ++i) {
+    std::string k1 = makeKey(1, i, 12);
+    std::string k2 = makeKey(1, i, 40);
+    ASSERT_EQ(qHashPut(pHashObj, k1.data(), k1.size(), &i, sizeof(i)), 0);
+    ASSERT_EQ(qHashPut(pHashObj, k2.data(), k2.size(), &i, sizeof(i)), 0);
+  }
+
+  ASSERT_EQ(qHashGetSize(pHashObj), 2000);
+
+  for (int64_t i = 0; i < 1000; ++i) {
+    std::string k1 = makeKey(1, i, 12);
+    std::string k2 = makeKey(1, i, 40);
+
+    int64_t *p1 = (int64_t *)qHashGet(pHashObj, k1.data(), k1.size());
+    int64_t *p2 = (int64_t *)qHashGet(pHashObj, k2.data(), k2.size());
+    ASSERT_TRUE(p1 != NULL && p2 != NULL);
+    ASSERT_EQ(*p1, i);
+    ASSERT_EQ(*p2, i);
+  }
+
+  // the same bytes with another length or uid are other keys
+  std::string k = makeKey(2, 5, 12);
+  ASSERT_TRUE(qHashGet(pHashObj, k.data(), k.size()) == NULL);
+  k = makeKey(1, 5, 16);
+  ASSERT_TRUE(qHashGet(pHashObj, k.data(), k.size()) == NULL);
+
+  // overwrite
+  int64_t v = -1;
+  k = makeKey(1, 5, 12);
+  ASSERT_EQ(qHashPut(pHashObj, k.data(), k.size(), &v, sizeof(v)), 0);
+  ASSERT_EQ(*(int64_t *)qHashGet(pHashObj, k.data(), k.size()), -1);
+  ASSERT_EQ(qHashGetSize(pHashObj), 2000);
+
+  qHashClear(pHashObj);
+  ASSERT_EQ(qHashGetSize(pHashObj), 0);
+  ASSERT_TRUE(qHashGet(pHashObj, k.data(), k.size()) == NULL);
+
+  qHashCleanup(pHashObj);
+}
+
+TEST(testCase, qhash_random_ops_test) {
+  std::mt19937_64                gen(7);
+  std::map<std::string, int64_t> expected;
+
+  SQHashObj *pHashObj = qHashInit(16);
+
+  // a small key space, so the probing runs are long and removals shift them back
+  for (int32_t i = 0; i < 200000; ++i) {
+    int64_t     v = (int64_t)(gen() % 5000);
+    size_t      len = (v % 3 == 0) ? 32 : 16;
+    std::string key = makeKey(v % 7, v, len);
+
+    switch (gen() % 3) {
+      case 0:
+      case 1:
+        ASSERT_EQ(qHashPut(pHashObj, key.data(), key.size(), &i, sizeof(int32_t)), 0);
+        expected[key] = i;
+        break;
+      default: {
+        int32_t ret = qHashRemove(pHashObj, key.data(), key.size());
+        ASSERT_EQ(ret == 0, expected.erase(key) == 1);
+        break;
+      }
+    }
+  }
+
+  ASSERT_EQ(qHashGetSize(pHashObj), expected.size());
+  for (auto &kv : expected) {
+    int32_t *p = (int32_t *)qHashGet(pHashObj, kv.first.data(), kv.first.size());
+    ASSERT_TRUE(p != NULL);
+    ASSERT_EQ(*p, kv.second);
+  }
+
+  qHashCleanup(pHashObj);
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taosdef.h"
+#include "tglobal.h"
+#include "ttype.h"
+
+#include "qExecutor.h"
+
+/*
+ * Rows per second of the order operator of an outer query, sorting random bigint keys with an int and a double column.
+ * Without a limit the rows beyond the sort buffer are spilled to disk in sorted runs and merged, with a limit only the
+ * first rows are kept by a heap. The result is checked to be in order.
+ */
+
+#define BENCH_BLOCK_ROWS 4096
+
+typedef struct {
+  int64_t      total;
+  int64_t      produced;
+  SSDataBlock *pBlock;
+} SBenchSource;
+
+static int64_t randKey() { return ((int64_t)rand() << 31) ^ rand(); }
+
+static SSDataBlock *doGenerateBlock(void *param, bool *newgroup) {
+  SOperatorInfo *pOperator = param;
+  SBenchSource * pSource = pOperator->info;
+
+  if (pSource->produced >= pSource->total) {
+    return NULL;
+  }
+
+  SSDataBlock *pBlock = pSource->pBlock;
+  pBlock->info.rows = (int32_t)MIN(BENCH_BLOCK_ROWS, pSource->total - pSource->produced);
+
+  int64_t *keys = (int64_t *)((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 0))->pData;
+  int32_t *seq = (int32_t *)((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 1))->pData;
+  double * val = (double *)((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 2))->pData;
+  for (int32_t i = 0; i < pBlock->info.rows; ++i) {
+    keys[i] = randKey();
+    seq[i] = (int32_t)(pSource->produced + i);
+    val[i] = (double)keys[i] / 3;
+  }
+
+  pSource->produced += pBlock->info.rows;
+  return pBlock;
+}
+
+static void initExpr(SExprInfo *pExpr, int16_t colId, int16_t type, int16_t bytes) {
+  memset(pExpr, 0, sizeof(SExprInfo));
+  pExpr->base.colInfo.colId = colId;
+  pExpr->base.colType = type;
+  pExpr->base.colBytes = bytes;
+  pExpr->base.resColId = colId;
+  pExpr->base.resType = type;
+  pExpr->base.resBytes = bytes;
+}
+
+static int32_t runBench(int64_t rows, int64_t limit, int32_t order) {
+  SQInfo *pQInfo = calloc(1, sizeof(SQInfo));
+  pQInfo->qId = 1;
+
+  SQueryRuntimeEnv *pRuntimeEnv = &pQInfo->runtimeEnv;
+  pRuntimeEnv->qinfo = pQInfo;
+  pRuntimeEnv->pQueryAttr = &pQInfo->query;
+  pRuntimeEnv->resultInfo.capacity = BENCH_BLOCK_ROWS;
+  pQInfo->query.limit.limit = (limit > 0) ? limit : -1;
+
+  SExprInfo expr[3];
+  initExpr(&expr[0], 1, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t));
+  initExpr(&expr[1], 2, TSDB_DATA_TYPE_INT, sizeof(int32_t));
+  initExpr(&expr[2], 3, TSDB_DATA_TYPE_DOUBLE, sizeof(double));
+
+  SBenchSource source = {.total = rows};
+  source.pBlock = createOutputBuf(expr, 3, BENCH_BLOCK_ROWS);
+  source.pBlock->info.numOfCols = 3;
+
+  SOperatorInfo upstream = {.name = "BenchSource", .status = OP_IN_EXECUTING, .info = &source, .exec = doGenerateBlock};
+  SOrderVal     orderVal = {.orderColId = 1, .order = order};
+
+  int32_t code = setjmp(pRuntimeEnv->env);
+  if (code != TSDB_CODE_SUCCESS) {
+    printf("failed to sort, code:0x%x\n", code);
+    return code;
+  }
+
+  SOperatorInfo *     pOperator = createOrderOperatorInfo(pRuntimeEnv, &upstream, expr, 3, &orderVal);
+  SOrderOperatorInfo *pInfo = pOperator->info;
+
+  int64_t st = taosGetTimestampUs();
+  int64_t numOfRows = 0;
+  int64_t prev = (order == TSDB_ORDER_ASC) ? INT64_MIN : INT64_MAX;
+  bool    sorted = true;
+  bool    newgroup = false;
+
+  SSDataBlock *pBlock = NULL;
+  while ((pBlock = pOperator->exec(pOperator, &newgroup)) != NULL) {
+    int64_t *keys = (int64_t *)((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, 0))->pData;
+    for (int32_t i = 0; i < pBlock->info.rows; ++i) {
+      if ((order == TSDB_ORDER_ASC && keys[i] < prev) || (order == TSDB_ORDER_DESC && keys[i] > prev)) {
+        sorted = false;
+      }
+      prev = keys[i];
+    }
+    numOfRows += pBlock->info.rows;
+  }
+
+  int64_t     us = taosGetTimestampUs() - st;
+  const char *mode = (pInfo->topN > 0) ? "top-n" : ((pInfo->numOfRuns > 0) ? "external" : "in-memory");
+  int64_t     expected = (pInfo->topN > 0) ? MIN(rows, pInfo->topN) : rows;
+
+  printf("%12" PRId64 " %10" PRId64 " %-5s %-10s %6d %10.2f %10.2f %s\n", rows, limit,
+         (order == TSDB_ORDER_ASC) ? "asc" : "desc", mode, pInfo->numOfRuns, us / 1000000.0,
+         us > 0 ? (double)rows / us : 0, (sorted && numOfRows == expected) ? "ok" : "WRONG");
+
+  pOperator->cleanup(pOperator->info, 3);
+  tfree(pOperator->info);
+  tfree(pOperator->upstream);
+  tfree(pOperator);
+  destroyOutputBuf(source.pBlock);
+  tfree(pQInfo);
+
+  return (sorted && numOfRows == expected) ? TSDB_CODE_SUCCESS : TSDB_CODE_QRY_APP_ERROR;
+}
+
+int main(int argc, char *argv[]) {
+  int64_t rows = 10000000;
+  int64_t limit = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      rows = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i < argc - 1) {
+      tsSortBufferSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && i < argc - 1) {
+      limit = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i < argc - 1) {
+      tstrncpy(tsTempDir, argv[++i], PATH_MAX);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-n]: number of rows to sort, default: %" PRId64 "\n", rows);
+      printf("  [-m]: sort buffer size in MB, default: %d\n", tsSortBufferSize);
+      printf("  [-l]: limit of the sorted rows, 0 for all of them, default: %" PRId64 "\n", limit);
+      printf("  [-d]: directory of the spilled runs, default: %s\n", tsTempDir);
+      exit(0);
+    }
+  }
+
+  srand(1);
+  printf("sort buffer:%dMB, elapsed time in seconds, throughput in million rows/s\n", tsSortBufferSize);
+  printf("%12s %10s %-5s %-10s %6s %10s %10s\n", "rows", "limit", "order", "mode", "runs", "time", "rate");
+
+  int32_t code = runBench(rows, limit, TSDB_ORDER_ASC);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = runBench(rows, limit, TSDB_ORDER_DESC);
+  }
+
+  return (code == TSDB_CODE_SUCCESS) ? 0 : 1;
+}
@@ -32,6 +32,7 @@
 #include "rpcCache.h"
 #include "rpcTcp.h"
 #include "rpcHead.h"
+#include "rpcPool.h"
 
 #define RPC_MSG_OVERHEAD (sizeof(SRpcReqContext) + sizeof(SRpcHead) + sizeof(SRpcDigest)) 
 #define rpcHeadFromCont(cont) ((SRpcHead *) ((char*)cont - sizeof(SRpcHead)))
@@ -217,7 +218,7 @@ static void  rpcDecRef(SRpcInfo *pRpc);
 
 static void rpcFree(void *p) {
   tTrace("free mem: %p", p);
-  free(p);
+  rpcFreeBuf(p);
 }
 
 int32_t rpcInit(void) {
@@ -346,11 +347,12 @@ void rpcClose(void *param) {
 void *rpcMallocCont(int contLen) {
   int size = contLen + RPC_MSG_OVERHEAD;
 
-  char *start = (char *)calloc(1, (size_t)size);
+  char *start = (char *)rpcMallocBuf(size);
   if (start == NULL) {
     tError("failed to malloc msg, size:%d", size);
     return NULL;
   } else {
+    memset(start, 0, (size_t)size);
     tTrace("malloc mem:%p size:%d", start, size);
   }
 
@@ -360,7 +362,7 @@ void *rpcMallocCont(int contLen) {
 void rpcFreeCont(void *cont) {
   if (cont) {
     char *temp = ((char *)cont) - sizeof(SRpcHead) - sizeof(SRpcReqContext);
-    free(temp);
+    rpcFreeBuf(temp);
     tTrace("free mem: %p", temp);
   }
 }
@@ -370,12 +372,12 @@ void *rpcReallocCont(void *ptr, int contLen) {
 
   char *start = ((char *)ptr) - sizeof(SRpcReqContext) - sizeof(SRpcHead);
   if (contLen == 0 ) {
-    free(start); 
+    rpcFreeBuf(start);
     return NULL;
   }
 
   int size = contLen + RPC_MSG_OVERHEAD;
-  start = realloc(start, size);
+  start = rpcReallocBuf(start, size);
   if (start == NULL) {
     tError("failed to realloc cont, size:%d", size);
     return NULL;
@@ -571,7 +573,7 @@ void rpcCancelRequest(int64_t rid) {
 static void rpcFreeMsg(void *msg) {
   if ( msg ) {
     char *temp = (char *)msg - sizeof(SRpcReqContext);
-    free(temp);
+    rpcFreeBuf(temp);
     tTrace("free mem: %p", temp);
   }
 }
@@ -1500,10 +1502,10 @@ static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead) {
     int contLen = htonl(pComp->contLen);
   
     // prepare the temporary buffer to decompress message
-    char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
-    pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
-  
-    if (pNewHead) {
+    char *temp = (char *)rpcMallocBuf(contLen + RPC_MSG_OVERHEAD);
+
+    if (temp) {
+      pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
       int compLen = rpcContLenFromMsg(pHead->msgLen) - overhead;
       int origLen = LZ4_decompress_safe((char*)(pCont + overhead), (char *)pNewHead->content, compLen, contLen);
       assert(origLen == contLen);
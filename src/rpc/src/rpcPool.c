@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tlockfree.h"
+#include "rpcPool.h"
+
+#define RPC_POOL_MIN_SHIFT   8                  // smallest block is 256 bytes
+#define RPC_POOL_CLASSES     9                  // largest block is 64KB, bigger buffers are not pooled
+#define RPC_POOL_CACHE_SIZE  (4 * 1024 * 1024)  // max bytes kept in the free list of each size class
+
+typedef struct SRpcBuf {
+  struct SRpcBuf *next;
+  int32_t         sclass;  // size class, -1 if the buffer is not pooled
+  int32_t         size;    // usable bytes after the header
+} SRpcBuf;
+
+typedef struct {
+  SRWLatch latch;
+  int32_t  numOfFree;
+  SRpcBuf *pFree;
+} SRpcBufClass;
+
+static SRpcBufClass tsRpcBufClass[RPC_POOL_CLASSES];
+
+static int32_t rpcGetBufClass(int32_t size) {
+  int32_t blockSize = 1 << RPC_POOL_MIN_SHIFT;
+  for (int32_t sclass = 0; sclass < RPC_POOL_CLASSES; ++sclass, blockSize <<= 1) {
+    if (size + (int32_t)sizeof(SRpcBuf) <= blockSize) return sclass;
+  }
+
+  return -1;
+}
+
+void *rpcMallocBuf(int32_t size) {
+  int32_t  sclass = rpcGetBufClass(size);
+  SRpcBuf *pBuf = NULL;
+
+  if (sclass >= 0) {
+    SRpcBufClass *pClass = tsRpcBufClass + sclass;
+    taosWLockLatch(&pClass->latch);
+    pBuf = pClass->pFree;
+    if (pBuf) {
+      pClass->pFree = pBuf->next;
+      pClass->numOfFree--;
+    }
+    taosWUnLockLatch(&pClass->latch);
+
+    if (pBuf == NULL) {
+      int32_t blockSize = 1 << (RPC_POOL_MIN_SHIFT + sclass);
+      pBuf = malloc(blockSize);
+      if (pBuf == NULL) return NULL;
+      pBuf->size = blockSize - (int32_t)sizeof(SRpcBuf);
+    }
+  } else {
+    pBuf = malloc(sizeof(SRpcBuf) + (size_t)size);
+    if (pBuf == NULL) return NULL;
+    pBuf->size = size;
+  }
+
+  pBuf->next = NULL;
+  pBuf->sclass = sclass;
+  return pBuf + 1;
+}
+
+void rpcFreeBuf(void *ptr) {
+  if (ptr == NULL) return;
+
+  SRpcBuf *pBuf = (SRpcBuf *)ptr - 1;
+  if (pBuf->sclass < 0) {
+    free(pBuf);
+    return;
+  }
+
+  SRpcBufClass *pClass = tsRpcBufClass + pBuf->sclass;
+  int32_t       maxFree = RPC_POOL_CACHE_SIZE >> (RPC_POOL_MIN_SHIFT + pBuf->sclass);
+
+  taosWLockLatch(&pClass->latch);
+  if (pClass->numOfFree < maxFree) {
+    pBuf->next = pClass->pFree;
+    pClass->pFree = pBuf;
+    pClass->numOfFree++;
+    pBuf = NULL;
+  }
+  taosWUnLockLatch(&pClass->latch);
+
+  free(pBuf);
+}
+
+void *rpcReallocBuf(void *ptr, int32_t size) {
+  if (ptr == NULL) return rpcMallocBuf(size);
+
+  SRpcBuf *pBuf = (SRpcBuf *)ptr - 1;
+  if (size <= pBuf->size) return ptr;
+
+  void *pNew = rpcMallocBuf(size);
+  if (pNew == NULL) return NULL;
+
+  memcpy(pNew, ptr, pBuf->size);
+  rpcFreeBuf(ptr);
+  return pNew;
+}
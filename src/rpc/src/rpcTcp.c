@@ -18,10 +18,16 @@
 #include "tutil.h"
 #include "taosdef.h"
 #include "taoserror.h"
+#include "tglobal.h"
 #include "rpcLog.h"
 #include "rpcHead.h"
+#include "rpcPool.h"
 #include "rpcTcp.h"
 
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0
+#endif
+
 typedef struct SFdObj {
   void              *signature;
   SOCKET             fd;          // TCP socket FD
@@ -29,6 +35,10 @@ typedef struct SFdObj {
   uint32_t           ip;
   uint16_t           port;
   int16_t            closedByApp; // 1: already closed by App
+  char              *pBuf;        // receive buffer, several messages may be parsed out of one read
+  int32_t            bufSize;
+  int32_t            start;       // offset of the first byte not parsed yet
+  int32_t            end;         // offset of the end of received data
   struct SThreadObj *pThreadObj;
   struct SFdObj     *prev;
   struct SFdObj     *next;
@@ -473,71 +483,127 @@ static void taosReportBrokenLink(SFdObj *pFdObj) {
   taosFreeFdObj(pFdObj);
 }
 
-static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
-  SRpcHead    rpcHead;
-  int32_t     msgLen, leftLen, retLen, headLen;
+static int taosReadTcpData(SFdObj *pFdObj) {
+  SThreadObj *pThreadObj = pFdObj->pThreadObj;
+  SRecvInfo   recvInfo;
+  int32_t     msgLen, leftLen, retLen, avail;
   char       *buffer, *msg;
 
-  SThreadObj *pThreadObj = pFdObj->pThreadObj;
+  if (pFdObj->pBuf == NULL) {
+    pFdObj->pBuf = malloc(tsRpcRecvBufSize);
+    if (pFdObj->pBuf == NULL) {
+      tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, tsRpcRecvBufSize);
+      return -1;
+    }
+    pFdObj->bufSize = tsRpcRecvBufSize;
+  }
 
-  headLen = taosReadMsg(pFdObj->fd, &rpcHead, sizeof(SRpcHead));
-  if (headLen != sizeof(SRpcHead)) {
-    tDebug("%s %p read error, FD:%p headLen:%d", pThreadObj->label, pFdObj->thandle, pFdObj, headLen);
-    return -1;
+  // move the partial message to the front, so the rest of it can be received
+  if (pFdObj->start > 0) {
+    memmove(pFdObj->pBuf, pFdObj->pBuf + pFdObj->start, pFdObj->end - pFdObj->start);
+    pFdObj->end -= pFdObj->start;
+    pFdObj->start = 0;
   }
 
-  msgLen = (int32_t)htonl((uint32_t)rpcHead.msgLen);
-  int32_t size = msgLen + tsRpcOverhead;
-  buffer = malloc(size);
-  if (NULL == buffer) {
-    tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
+  retLen = (int32_t)recv(pFdObj->fd, pFdObj->pBuf + pFdObj->end, pFdObj->bufSize - pFdObj->end, MSG_DONTWAIT);
+  if (retLen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+  if (retLen <= 0) {
+    tDebug("%s %p read error, FD:%p retLen:%d", pThreadObj->label, pFdObj->thandle, pFdObj, retLen);
     return -1;
-  } else {
-    tTrace("%s %p read data, FD:%p fd:%d TCP malloc mem:%p", pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd, buffer);
   }
 
-  msg = buffer + tsRpcOverhead;
-  leftLen = msgLen - headLen;
-  retLen = taosReadMsg(pFdObj->fd, msg + headLen, leftLen);
+  pFdObj->end += retLen;
 
-  if (leftLen != retLen) {
-    tError("%s %p read error, leftLen:%d retLen:%d FD:%p",
-            pThreadObj->label, pFdObj->thandle, leftLen, retLen, pFdObj);
-    free(buffer);
-    return -1;
-  }
+  while ((avail = pFdObj->end - pFdObj->start) >= (int32_t)sizeof(SRpcHead)) {
+    SRpcHead *pHead = (SRpcHead *)(pFdObj->pBuf + pFdObj->start);
+    msgLen = (int32_t)htonl((uint32_t)pHead->msgLen);
+    if (msgLen < (int32_t)sizeof(SRpcHead)) {
+      tError("%s %p invalid msg length:%d, FD:%p", pThreadObj->label, pFdObj->thandle, msgLen, pFdObj);
+      return -1;
+    }
 
-  memcpy(msg, &rpcHead, sizeof(SRpcHead));
+    // wait for the rest of message if it can be held by receive buffer
+    if (avail < msgLen && msgLen <= pFdObj->bufSize) break;
 
-  pInfo->msg = msg;
-  pInfo->msgLen = msgLen;
-  pInfo->ip = pFdObj->ip;
-  pInfo->port = pFdObj->port;
-  pInfo->shandle = pThreadObj->shandle;
-  pInfo->thandle = pFdObj->thandle;
-  pInfo->chandle = pFdObj;
-  pInfo->connType = RPC_CONN_TCP;
+    int32_t size = msgLen + tsRpcOverhead;
+    buffer = rpcMallocBuf(size);
+    if (NULL == buffer) {
+      tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
+      return -1;
+    } else {
+      tTrace("%s %p read data, FD:%p fd:%d TCP malloc mem:%p", pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd,
+             buffer);
+    }
 
-  if (pFdObj->closedByApp) {
-    free(buffer);
-    return -1;
+    msg = buffer + tsRpcOverhead;
+    if (avail >= msgLen) {
+      memcpy(msg, pFdObj->pBuf + pFdObj->start, msgLen);
+      pFdObj->start += msgLen;
+    } else {
+      // message is larger than the receive buffer, read the remaining part into message directly
+      memcpy(msg, pFdObj->pBuf + pFdObj->start, avail);
+      pFdObj->start = pFdObj->end = 0;
+
+      leftLen = msgLen - avail;
+      retLen = taosReadMsg(pFdObj->fd, msg + avail, leftLen);
+      if (leftLen != retLen) {
+        tError("%s %p read error, leftLen:%d retLen:%d FD:%p", pThreadObj->label, pFdObj->thandle, leftLen, retLen,
+               pFdObj);
+        rpcFreeBuf(buffer);
+        return -1;
+      }
+    }
+
+    if (pFdObj->closedByApp) {
+      rpcFreeBuf(buffer);
+      return -1;
+    }
+
+    recvInfo.msg = msg;
+    recvInfo.msgLen = msgLen;
+    recvInfo.ip = pFdObj->ip;
+    recvInfo.port = pFdObj->port;
+    recvInfo.shandle = pThreadObj->shandle;
+    recvInfo.thandle = pFdObj->thandle;
+    recvInfo.chandle = pFdObj;
+    recvInfo.connType = RPC_CONN_TCP;
+
+    pFdObj->thandle = (*(pThreadObj->processData))(&recvInfo);
+    if (pFdObj->thandle == NULL) {
+      taosFreeFdObj(pFdObj);
+      return 0;
+    }
   }
 
+  if (pFdObj->start == pFdObj->end) pFdObj->start = pFdObj->end = 0;
   return 0;
 }
 
-#define maxEvents 10
+#define TCP_DEF_EVENTS 16
 
 static void *taosProcessTcpData(void *param) {
-  SThreadObj        *pThreadObj = param;
-  SFdObj            *pFdObj;
-  struct epoll_event events[maxEvents];
-  SRecvInfo          recvInfo;
+  SThreadObj         *pThreadObj = param;
+  SFdObj             *pFdObj;
+  struct epoll_event  defEvents[TCP_DEF_EVENTS];
+  struct epoll_event *events = defEvents;
+  int                 maxEvents = TCP_DEF_EVENTS;
 
   char name[16] = {0};
   snprintf(name, tListLen(name), "%s-tcp", pThreadObj->label);
   setThreadName(name);
 
+  if (tsRpcMaxEvents > TCP_DEF_EVENTS) {
+    events = calloc(tsRpcMaxEvents, sizeof(struct epoll_event));
+    if (events != NULL) {
+      maxEvents = tsRpcMaxEvents;
+    } else {
+      tError("%s failed to allocate %d TCP epoll events, use %d", pThreadObj->label, tsRpcMaxEvents, maxEvents);
+      events = defEvents;
+    }
+  } else {
+    maxEvents = tsRpcMaxEvents;
+  }
+
   while (1) {
     int fdNum = epoll_wait(pThreadObj->pollFd, events, maxEvents, TAOS_EPOLL_WAIT_TIME);
     if (pThreadObj->stop) {
@@ -567,18 +633,17 @@ static void *taosProcessTcpData(void *param) {
         continue;
       }
 
-      if (taosReadTcpData(pFdObj, &recvInfo) < 0) {
+      if (taosReadTcpData(pFdObj) < 0) {
         shutdown(pFdObj->fd, SHUT_WR);
         continue;
       }
-
-      pFdObj->thandle = (*(pThreadObj->processData))(&recvInfo);
-      if (pFdObj->thandle == NULL) taosFreeFdObj(pFdObj);
     }
 
     if (pThreadObj->stop) break;
   }
 
+  if (events != defEvents) free(events);
+
   if (pThreadObj->pollFd >=0) {
     EpollClose(pThreadObj->pollFd);
     pThreadObj->pollFd = -1;
@@ -666,5 +731,6 @@ static void taosFreeFdObj(SFdObj *pFdObj) {
   tDebug("%s %p TCP connection is closed, FD:%p fd:%d numOfFds:%d",
           pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd, pThreadObj->numOfFds);
 
+  tfree(pFdObj->pBuf);
   tfree(pFdObj);
 }
@@ -22,6 +22,7 @@
 #include "rpcLog.h"
 #include "rpcUdp.h"
 #include "rpcHead.h"
+#include "rpcPool.h"
 
 #define RPC_MAX_UDP_CONNS 256
 #define RPC_MAX_UDP_PKTS 1000
@@ -219,7 +220,7 @@ static void *taosRecvUdpData(void *param) {
     }
 
     int32_t size = dataLen + tsRpcOverhead;
-    char *tmsg = malloc(size);
+    char *tmsg = rpcMallocBuf(size);
     if (NULL == tmsg) {
       tError("%s failed to allocate memory, size:%" PRId64, pConn->label, (int64_t)dataLen);
       continue;
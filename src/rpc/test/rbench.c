@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tutil.h"
+#include "tglobal.h"
+#include "rpcLog.h"
+#include "trpc.h"
+#include "taoserror.h"
+#include "taosmsg.h"
+
+typedef struct {
+  int       index;
+  SRpcEpSet epSet;
+  int       numOfReqs;
+  int       msgSize;
+  int64_t   sendUs;
+  int64_t  *latency;
+  tsem_t    rspSem;
+  pthread_t thread;
+  void     *pRpc;
+} SInfo;
+
+static int rspSize = 16;
+
+static void processRequest(SRpcMsg *pMsg, SRpcEpSet *pEpSet) {
+  SRpcMsg rspMsg = {0};
+
+  rpcFreeCont(pMsg->pCont);
+
+  rspMsg.pCont = rpcMallocCont(rspSize);
+  rspMsg.contLen = rspSize;
+  rspMsg.handle = pMsg->handle;
+  rpcSendResponse(&rspMsg);
+}
+
+static void processResponse(SRpcMsg *pMsg, SRpcEpSet *pEpSet) {
+  SInfo *pInfo = (SInfo *)pMsg->ahandle;
+
+  if (pMsg->code != 0) tError("thread:%d, response code:0x%x", pInfo->index, pMsg->code);
+  if (pEpSet) pInfo->epSet = *pEpSet;
+
+  rpcFreeCont(pMsg->pCont);
+  tsem_post(&pInfo->rspSem);
+}
+
+static void *sendRequest(void *param) {
+  SInfo  *pInfo = (SInfo *)param;
+  SRpcMsg rpcMsg = {0};
+
+  for (int i = 0; i < pInfo->numOfReqs; ++i) {
+    rpcMsg.pCont = rpcMallocCont(pInfo->msgSize);
+    rpcMsg.contLen = pInfo->msgSize;
+    rpcMsg.ahandle = pInfo;
+    rpcMsg.msgType = TSDB_MSG_TYPE_SUBMIT;
+
+    pInfo->sendUs = taosGetTimestampUs();
+    rpcSendRequest(pInfo->pRpc, &pInfo->epSet, &rpcMsg, NULL);
+    tsem_wait(&pInfo->rspSem);
+    pInfo->latency[i] = taosGetTimestampUs() - pInfo->sendUs;
+  }
+
+  return NULL;
+}
+
+static int compareLatency(const void *p1, const void *p2) {
+  int64_t v1 = *(int64_t *)p1, v2 = *(int64_t *)p2;
+  return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+}
+
+int main(int argc, char *argv[]) {
+  SRpcInit  init;
+  SRpcEpSet epSet;
+  int       msgSize = 128;
+  int       numOfReqs = 20000;
+  int       appThreads = 4;
+  int       rpcThreads = 2;
+  uint16_t  port = 7100;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-p") == 0 && i < argc - 1) {
+      port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      rpcThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i < argc - 1) {
+      msgSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rspSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numOfReqs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-a") == 0 && i < argc - 1) {
+      appThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-e") == 0 && i < argc - 1) {
+      tsRpcMaxEvents = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-b") == 0 && i < argc - 1) {
+      tsRpcRecvBufSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i < argc - 1) {
+      rpcDebugFlag = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-p port]: server port number, default is:%d\n", port);
+      printf("  [-t threads]: number of rpc threads, default is:%d\n", rpcThreads);
+      printf("  [-m msgSize]: request body size, default is:%d\n", msgSize);
+      printf("  [-r rspSize]: response body size, default is:%d\n", rspSize);
+      printf("  [-a threads]: number of app threads, default is:%d\n", appThreads);
+      printf("  [-n requests]: number of requests per thread, default is:%d\n", numOfReqs);
+      printf("  [-e events]: max epoll events per loop, default is:%d\n", tsRpcMaxEvents);
+      printf("  [-b bytes]: TCP receive buffer per connection, default is:%d\n", tsRpcRecvBufSize);
+      printf("  [-d debugFlag]: debug flag, default:%d\n", rpcDebugFlag);
+      printf("  [-h help]: print out this help\n\n");
+      exit(0);
+    }
+  }
+
+  // all requests go through the TCP path
+  tsRpcForceTcp = 1;
+  taosBlockSIGPIPE();
+  taosInitLog("rbench.log", 100000, 10);
+  rpcInit();
+
+  memset(&init, 0, sizeof(init));
+  init.localPort = port;
+  init.label = "SER";
+  init.numOfThreads = rpcThreads;
+  init.cfp = processRequest;
+  init.sessions = appThreads + 10;
+  init.idleTime = tsShellActivityTimer * 1500;
+  init.connType = TAOS_CONN_SERVER;
+
+  void *pServer = rpcOpen(&init);
+  if (pServer == NULL) {
+    printf("failed to start RPC server, reason:%s\n", tstrerror(terrno));
+    return -1;
+  }
+
+  memset(&init, 0, sizeof(init));
+  init.localPort = 0;
+  init.label = "APP";
+  init.numOfThreads = rpcThreads;
+  init.cfp = processResponse;
+  init.sessions = appThreads + 10;
+  init.idleTime = tsShellActivityTimer * 1000;
+  init.user = "bench";
+  init.connType = TAOS_CONN_CLIENT;
+
+  void *pClient = rpcOpen(&init);
+  if (pClient == NULL) {
+    printf("failed to start RPC client, reason:%s\n", tstrerror(terrno));
+    return -1;
+  }
+
+  memset(&epSet, 0, sizeof(epSet));
+  epSet.numOfEps = 1;
+  epSet.port[0] = port;
+  strcpy(epSet.fqdn[0], "127.0.0.1");
+
+  SInfo   *pInfo = calloc(appThreads, sizeof(SInfo));
+  int64_t *latency = calloc((size_t)appThreads * numOfReqs, sizeof(int64_t));
+
+  int64_t startUs = taosGetTimestampUs();
+  for (int i = 0; i < appThreads; ++i) {
+    pInfo[i].index = i;
+    pInfo[i].epSet = epSet;
+    pInfo[i].numOfReqs = numOfReqs;
+    pInfo[i].msgSize = msgSize;
+    pInfo[i].latency = latency + (size_t)i * numOfReqs;
+    pInfo[i].pRpc = pClient;
+    tsem_init(&pInfo[i].rspSem, 0, 0);
+    pthread_create(&pInfo[i].thread, NULL, sendRequest, pInfo + i);
+  }
+
+  for (int i = 0; i < appThreads; ++i) {
+    pthread_join(pInfo[i].thread, NULL);
+    tsem_destroy(&pInfo[i].rspSem);
+  }
+  int64_t usedUs = taosGetTimestampUs() - startUs;
+
+  int64_t total = (int64_t)appThreads * numOfReqs;
+  qsort(latency, total, sizeof(int64_t), compareLatency);
+
+  printf("threads:%d requests:%" PRId64 " msgSize:%d rspSize:%d maxEvents:%d recvBufSize:%d\n", appThreads, total,
+         msgSize, rspSize, tsRpcMaxEvents, tsRpcRecvBufSize);
+  if (total > 0) {
+    printf("%.1f msgs/sec, latency p50:%" PRId64 "us p99:%" PRId64 "us max:%" PRId64 "us\n",
+           total * 1000000.0 / usedUs, latency[total / 2], latency[total * 99 / 100], latency[total - 1]);
+  }
+
+  free(latency);
+  free(pInfo);
+  rpcClose(pClient);
+  rpcClose(pServer);
+  rpcCleanup();
+  taosCloseLog();
+
+  return 0;
+}
@@ -27,13 +27,15 @@ extern "C" {
 #define sWarn(...)  { if (sDebugFlag & DEBUG_WARN)  { taosPrintLog("SYN WARN ", sDebugFlag, __VA_ARGS__); }}
 #define sInfo(...)  { if (sDebugFlag & DEBUG_INFO)  { taosPrintLog("SYN ", sDebugFlag, __VA_ARGS__); }}
 #define sDebug(...) { if (sDebugFlag & DEBUG_DEBUG) { taosPrintLog("SYN ", sDebugFlag, __VA_ARGS__); }}
-#define sTrace(...) { if (sDebugFlag & DEBUG_TRACE) { taosPrintLog("SYN ", sDebugFlag, __VA_ARGS__); }}
+#define sTrace(...) { if (sDebugFlag & DEBUG_TRACE) { taosPrintDeferredLog("SYN ", sDebugFlag, __VA_ARGS__); }}
 
 #define SYNC_TCP_THREADS 2
 #define SYNC_MAX_NUM 2
 
 #define SYNC_MAX_SIZE (TSDB_MAX_WAL_SIZE + sizeof(SWalHead) + sizeof(SSyncHead) + 16)
 #define SYNC_RECV_BUFFER_SIZE (5*1024*1024)
+#define SYNC_MAX_CHUNK_SIZE (64*1024*1024 + SYNC_MAX_SIZE)
+#define SYNC_CHUNK_QUEUE_SIZE 4
 
 #define SYNC_MAX_FWDS 4096
 #define SYNC_FWD_TIMER 300
@@ -86,6 +88,7 @@ typedef struct SsyncPeer {
   SOCKET   peerFd;          // forward FD
   int32_t  numOfRetrieves;  // number of retrieves tried
   int32_t  fileChanged;     // a flag to indicate file is changed during retrieving process
+  int8_t   walChunk;        // wal is retrieved in compressed chunks
   int32_t  refCount;
   int8_t   isArb;
   int64_t  rid;
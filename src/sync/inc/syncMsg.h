@@ -76,7 +76,7 @@ typedef struct {
 typedef struct {
   SSyncHead head;
   int8_t    sync;
-  int8_t    reserved;
+  int8_t    walChunk;  // 1: the restoring peer accepts wal in compressed chunks
   uint16_t  tranId;
   int8_t    reserverd[4];
 } SSyncRsp;
@@ -113,10 +113,22 @@ typedef struct {
   int32_t   code;
 } SFwdRsp;
 
+typedef struct {
+  uint32_t signature;  // SYNC_CHUNK_SIGNATURE
+  int32_t  rawLen;     // length of the wal records in chunk, 0 means wal is synced over
+  int32_t  compLen;    // length of the compressed content following the head
+  int32_t  records;
+  uint64_t firstVer;
+  uint64_t lastVer;
+  uint64_t masterVer;  // version of the retrieving peer when chunk is sent, for lag report
+  uint32_t cksum;      // checksum of the compressed content
+} SWalChunkHead;
+
 #pragma pack(pop)
 
 #define SYNC_PROTOCOL_VERSION 1
 #define SYNC_SIGNATURE ((uint16_t)(0xCDEF))
+#define SYNC_CHUNK_SIGNATURE ((uint32_t)(0xFAFBCDEF))
 
 extern char *statusType[];
 
@@ -18,9 +18,12 @@
 #include "taoserror.h"
 #include "tlog.h"
 #include "tutil.h"
+#include "tglobal.h"
 #include "ttimer.h"
 #include "tsocket.h"
 #include "tqueue.h"
+#include "tchecksum.h"
+#include "tscompression.h"
 #include "twal.h"
 #include "tsync.h"
 #include "syncInt.h"
@@ -65,6 +68,231 @@ static int32_t syncRestoreFile(SSyncPeer *pPeer, uint64_t *fversion) {
   return 0;
 }
 
+typedef struct {
+  SWalChunkHead head;
+  char *        buffer;  // decompressed wal records, NULL if wal is synced over
+} SRecvChunk;
+
+typedef struct {
+  SSyncPeer *     pPeer;
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  notEmpty;
+  pthread_cond_t  notFull;
+  SRecvChunk      chunks[SYNC_CHUNK_QUEUE_SIZE];
+  int32_t         first;
+  int32_t         num;
+  int32_t         code;  // set if chunk can not be received
+  int8_t          stop;  // set if chunk can not be applied
+} SChunkQueue;
+
+static int32_t syncRecvOneChunk(SSyncPeer *pPeer, SRecvChunk *pChunk, char **cont, int32_t *contSize) {
+  SWalChunkHead *pHead = &pChunk->head;
+
+  if (taosReadMsg(pPeer->syncFd, pHead, sizeof(SWalChunkHead)) != sizeof(SWalChunkHead)) {
+    sError("%s, failed to read wal chunk head since %s", pPeer->id, strerror(errno));
+    return -1;
+  }
+
+  if (pHead->signature != SYNC_CHUNK_SIGNATURE || pHead->rawLen < 0 || pHead->rawLen > SYNC_MAX_CHUNK_SIZE ||
+      pHead->compLen < 0 || pHead->compLen > SYNC_MAX_CHUNK_SIZE + SYNC_MAX_CHUNK_SIZE / 255 + 17) {
+    sError("%s, invalid wal chunk head, signature:0x%x raw:%d comp:%d", pPeer->id, pHead->signature, pHead->rawLen,
+           pHead->compLen);
+    return -1;
+  }
+
+  if (pHead->rawLen == 0) return 0;  // wal is synced over
+
+  if (pHead->compLen > *contSize) {
+    char *tmp = realloc(*cont, pHead->compLen);
+    if (tmp == NULL) return -1;
+    *cont = tmp;
+    *contSize = pHead->compLen;
+  }
+
+  if (taosReadMsg(pPeer->syncFd, *cont, pHead->compLen) != pHead->compLen) {
+    sError("%s, failed to read wal chunk, comp:%d since %s", pPeer->id, pHead->compLen, strerror(errno));
+    return -1;
+  }
+
+  if (taosCalcChecksum(0, (uint8_t *)*cont, pHead->compLen) != pHead->cksum) {
+    sError("%s, wal chunk is corrupted, hver:%" PRIu64 "-%" PRIu64, pPeer->id, pHead->firstVer, pHead->lastVer);
+    return -1;
+  }
+
+  pChunk->buffer = malloc(pHead->rawLen);
+  if (pChunk->buffer == NULL) return -1;
+
+  if (tsDecompressStringImp(*cont, pHead->compLen, pChunk->buffer, pHead->rawLen) != pHead->rawLen) {
+    sError("%s, failed to decompress wal chunk, hver:%" PRIu64 "-%" PRIu64, pPeer->id, pHead->firstVer,
+           pHead->lastVer);
+    tfree(pChunk->buffer);
+    return -1;
+  }
+
+  return 0;
+}
+
+// receive and decompress the next chunks while the previous ones are applied
+static void *syncRecvWalChunks(void *param) {
+  SChunkQueue *pQueue = param;
+  SSyncPeer *  pPeer = pQueue->pPeer;
+  char *       cont = NULL;
+  int32_t      contSize = 0;
+
+  setThreadName("syncRecvChunk");
+
+  while (1) {
+    SRecvChunk chunk = {0};
+    int32_t    code = syncRecvOneChunk(pPeer, &chunk, &cont, &contSize);
+
+    pthread_mutex_lock(&pQueue->mutex);
+    while (code == 0 && pQueue->num >= SYNC_CHUNK_QUEUE_SIZE && !pQueue->stop) {
+      pthread_cond_wait(&pQueue->notFull, &pQueue->mutex);
+    }
+
+    if (code != 0 || pQueue->stop) {
+      pQueue->code = -1;
+      pthread_cond_signal(&pQueue->notEmpty);
+      pthread_mutex_unlock(&pQueue->mutex);
+      tfree(chunk.buffer);
+      break;
+    }
+
+    pQueue->chunks[(pQueue->first + pQueue->num) % SYNC_CHUNK_QUEUE_SIZE] = chunk;
+    pQueue->num++;
+    pthread_cond_signal(&pQueue->notEmpty);
+    pthread_mutex_unlock(&pQueue->mutex);
+
+    if (chunk.buffer == NULL) break;  // wal is synced over
+  }
+
+  tfree(cont);
+  return NULL;
+}
+
+static int32_t syncApplyOneChunk(SSyncPeer *pPeer, SRecvChunk *pChunk, uint64_t *lastVer) {
+  SSyncNode *pNode = pPeer->pSyncNode;
+  int32_t    offset = 0;
+
+  while (offset < pChunk->head.rawLen) {
+    SWalHead *pHead = (SWalHead *)(pChunk->buffer + offset);
+    if (offset + (int32_t)sizeof(SWalHead) > pChunk->head.rawLen || pHead->len < 0 ||
+        offset + (int32_t)sizeof(SWalHead) + pHead->len > pChunk->head.rawLen) {
+      sError("%s, incomplete record in wal chunk, offset:%d raw:%d", pPeer->id, offset, pChunk->head.rawLen);
+      return -1;
+    }
+
+    sTrace("%s, restore a record, qtype:wal len:%d hver:%" PRIu64, pPeer->id, pHead->len, pHead->version);
+
+    if (*lastVer == pHead->version) {
+      sError("%s, failed to restore record, same hver:%" PRIu64 ", wal sync failed", pPeer->id, *lastVer);
+      return -1;
+    }
+    *lastVer = pHead->version;
+
+    int32_t ret = (*pNode->writeToCacheFp)(pNode->vgId, pHead, TAOS_QTYPE_WAL, NULL);
+    if (ret != 0) {
+      sError("%s, failed to restore record since %s, hver:%" PRIu64, pPeer->id, tstrerror(ret), pHead->version);
+      return -1;
+    }
+
+    offset += sizeof(SWalHead) + pHead->len;
+  }
+
+  return 0;
+}
+
+static int32_t syncRestoreWalChunks(SSyncPeer *pPeer, uint64_t *wver) {
+  SChunkQueue queue;
+  memset(&queue, 0, sizeof(SChunkQueue));
+  queue.pPeer = pPeer;
+  pthread_mutex_init(&queue.mutex, NULL);
+  pthread_cond_init(&queue.notEmpty, NULL);
+  pthread_cond_init(&queue.notFull, NULL);
+
+  int32_t  code = -1;
+  uint64_t lastVer = 0;
+  int64_t  chunks = 0, records = 0, rawBytes = 0, compBytes = 0, masterVer = 0;
+  int64_t  startMs = taosGetTimestampMs();
+
+  sInfo("%s, start to restore wal in chunks", pPeer->id);
+
+  pthread_attr_t thattr;
+  pthread_attr_init(&thattr);
+  pthread_attr_setdetachstate(&thattr, PTHREAD_CREATE_JOINABLE);
+  int32_t ret = pthread_create(&queue.thread, &thattr, syncRecvWalChunks, &queue);
+  pthread_attr_destroy(&thattr);
+
+  if (ret != 0) {
+    sError("%s, failed to create thread to receive wal chunks since %s", pPeer->id, strerror(errno));
+  } else {
+    while (1) {
+      pthread_mutex_lock(&queue.mutex);
+      while (queue.num == 0 && queue.code == 0) {
+        pthread_cond_wait(&queue.notEmpty, &queue.mutex);
+      }
+
+      if (queue.num == 0) {
+        pthread_mutex_unlock(&queue.mutex);
+        break;
+      }
+
+      SRecvChunk chunk = queue.chunks[queue.first];
+      queue.first = (queue.first + 1) % SYNC_CHUNK_QUEUE_SIZE;
+      queue.num--;
+      pthread_cond_signal(&queue.notFull);
+      pthread_mutex_unlock(&queue.mutex);
+
+      if (chunk.buffer == NULL) {
+        code = 0;
+        break;
+      }
+
+      ret = syncApplyOneChunk(pPeer, &chunk, &lastVer);
+      free(chunk.buffer);
+      if (ret != 0) break;
+
+      chunks++;
+      records += chunk.head.records;
+      rawBytes += chunk.head.rawLen;
+      compBytes += chunk.head.compLen;
+      masterVer = chunk.head.masterVer;
+      sDebug("%s, wal chunk is restored, records:%d raw:%d comp:%d hver:%" PRIu64 " mver:%" PRIu64 " lag:%" PRId64,
+             pPeer->id, chunk.head.records, chunk.head.rawLen, chunk.head.compLen, lastVer, chunk.head.masterVer,
+             (int64_t)(chunk.head.masterVer - lastVer));
+    }
+
+    if (code != 0) {
+      // wake up the receiving thread, it may wait for a free slot or block on the socket
+      pthread_mutex_lock(&queue.mutex);
+      queue.stop = 1;
+      pthread_cond_signal(&queue.notFull);
+      pthread_mutex_unlock(&queue.mutex);
+      shutdown(pPeer->syncFd, SHUT_RD);
+    }
+
+    pthread_join(queue.thread, NULL);
+  }
+
+  for (int32_t i = 0; i < queue.num; ++i) {
+    tfree(queue.chunks[(queue.first + i) % SYNC_CHUNK_QUEUE_SIZE].buffer);
+  }
+
+  pthread_cond_destroy(&queue.notFull);
+  pthread_cond_destroy(&queue.notEmpty);
+  pthread_mutex_destroy(&queue.mutex);
+
+  int64_t elapsed = MAX(taosGetTimestampMs() - startMs, 1);
+  sInfo("%s, wal chunks are restored, code:%d chunks:%" PRId64 " records:%" PRId64 " raw:%" PRId64 " comp:%" PRId64
+        " elapsed:%" PRId64 "ms rate:%.2fMB/s %.0frecords/s last wver:%" PRIu64 " lag:%" PRId64,
+        pPeer->id, code, chunks, records, rawBytes, compBytes, elapsed, rawBytes * 1000.0 / elapsed / (1024 * 1024),
+        records * 1000.0 / elapsed, lastVer, (lastVer > 0) ? (int64_t)(masterVer - lastVer) : 0);
+
+  *wver = lastVer;
+  return code;
+}
+
 static int32_t syncRestoreWal(SSyncPeer *pPeer, uint64_t *wver) {
   SSyncNode *pNode = pPeer->pSyncNode;
   int32_t    ret, code = -1;
@@ -80,6 +308,11 @@ static int32_t syncRestoreWal(SSyncPeer *pPeer, uint64_t *wver) {
       break;
     }
 
+    if (pHead->signature == SYNC_CHUNK_SIGNATURE) {
+      free(pHead);
+      return syncRestoreWalChunks(pPeer, wver);
+    }
+
     if (pHead->len == 0) {
       sDebug("%s, wal is synced over, last wver:%" PRIu64, pPeer->id, lastVer);
       code = 0;
@@ -219,7 +452,7 @@ static int32_t syncRestoreDataStepByStep(SSyncPeer *pPeer) {
   uint64_t fversion = 0;
 
   sInfo("%s, start to restore, sstatus:%s", pPeer->id, syncStatus[pPeer->sstatus]);
-  SSyncRsp rsp = {.sync = 1, .tranId = syncGenTranId()};
+  SSyncRsp rsp = {.sync = 1, .walChunk = (tsSyncWalChunkSize > 0), .tranId = syncGenTranId()};
   if (taosWriteMsg(pPeer->syncFd, &rsp, sizeof(SSyncRsp)) != sizeof(SSyncRsp)) {
     sError("%s, failed to send sync rsp since %s", pPeer->id, strerror(errno));
     return -1;
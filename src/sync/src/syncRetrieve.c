@@ -21,6 +21,8 @@
 #include "tglobal.h"
 #include "ttimer.h"
 #include "tsocket.h"
+#include "tchecksum.h"
+#include "tscompression.h"
 #include "twal.h"
 #include "tsync.h"
 #include "syncInt.h"
@@ -170,7 +172,115 @@ static int32_t syncReadOneWalRecord(int32_t sfd, SWalHead *pHead) {
   return sizeof(SWalHead) + pHead->len;
 }
 
-static int64_t syncRetrieveLastWal(SSyncPeer *pPeer, char *name, uint64_t fversion, int64_t offset) {
+typedef struct {
+  char *   buffer;  // wal records not sent yet
+  char *   cont;    // compressed records
+  int32_t  capacity;
+  int32_t  size;    // chunk is sent once records reach the size
+  int32_t  len;
+  int32_t  records;
+  uint64_t firstVer;
+  uint64_t lastVer;
+  int64_t  chunks;
+  int64_t  totalRecords;
+  int64_t  rawBytes;
+  int64_t  compBytes;
+  int64_t  startMs;
+} SWalChunk;
+
+static SWalChunk *syncOpenWalChunk(SSyncPeer *pPeer) {
+  SWalChunk *pChunk = calloc(1, sizeof(SWalChunk));
+  if (pChunk == NULL) return NULL;
+
+  // a chunk holds one record at least
+  pChunk->size = tsSyncWalChunkSize;
+  pChunk->capacity = MAX(tsSyncWalChunkSize, SYNC_MAX_SIZE);
+  pChunk->buffer = malloc(pChunk->capacity);
+  pChunk->cont = malloc(pChunk->capacity + pChunk->capacity / 255 + 16 + 1);  // LZ4_compressBound + indicator
+  if (pChunk->buffer == NULL || pChunk->cont == NULL) {
+    tfree(pChunk->buffer);
+    tfree(pChunk->cont);
+    free(pChunk);
+    return NULL;
+  }
+
+  pChunk->startMs = taosGetTimestampMs();
+  sInfo("%s, retrieve wal in chunks, size:%d", pPeer->id, pChunk->size);
+  return pChunk;
+}
+
+static void syncCloseWalChunk(SSyncPeer *pPeer, SWalChunk *pChunk) {
+  if (pChunk == NULL) return;
+
+  int64_t elapsed = MAX(taosGetTimestampMs() - pChunk->startMs, 1);
+  sInfo("%s, wal chunks are retrieved, chunks:%" PRId64 " records:%" PRId64 " raw:%" PRId64 " comp:%" PRId64
+        " elapsed:%" PRId64 "ms rate:%.2fMB/s %.0frecords/s",
+        pPeer->id, pChunk->chunks, pChunk->totalRecords, pChunk->rawBytes, pChunk->compBytes, elapsed,
+        pChunk->rawBytes * 1000.0 / elapsed / (1024 * 1024), pChunk->totalRecords * 1000.0 / elapsed);
+
+  free(pChunk->buffer);
+  free(pChunk->cont);
+  free(pChunk);
+}
+
+static int32_t syncSendWalChunk(SSyncPeer *pPeer, SWalChunk *pChunk) {
+  SSyncNode *   pNode = pPeer->pSyncNode;
+  SWalChunkHead head = {.signature = SYNC_CHUNK_SIGNATURE, .masterVer = nodeVersion};
+
+  if (pChunk->len > 0) {
+    head.compLen =
+        tsCompressStringImp(pChunk->buffer, pChunk->len, pChunk->cont, pChunk->capacity + pChunk->capacity / 255 + 17);
+    head.rawLen = pChunk->len;
+    head.records = pChunk->records;
+    head.firstVer = pChunk->firstVer;
+    head.lastVer = pChunk->lastVer;
+    head.cksum = taosCalcChecksum(0, (uint8_t *)pChunk->cont, head.compLen);
+  }
+
+  if (taosWriteMsg(pPeer->syncFd, &head, sizeof(SWalChunkHead)) != sizeof(SWalChunkHead) ||
+      taosWriteMsg(pPeer->syncFd, pChunk->cont, head.compLen) != head.compLen) {
+    sError("%s, failed to send wal chunk since %s, records:%d hver:%" PRIu64 "-%" PRIu64, pPeer->id, strerror(errno),
+           head.records, head.firstVer, head.lastVer);
+    return -1;
+  }
+
+  sDebug("%s, wal chunk is sent, records:%d raw:%d comp:%d hver:%" PRIu64 "-%" PRIu64 " mver:%" PRIu64, pPeer->id,
+         head.records, head.rawLen, head.compLen, head.firstVer, head.lastVer, head.masterVer);
+
+  if (pChunk->len > 0) {
+    pChunk->chunks++;
+    pChunk->totalRecords += pChunk->records;
+    pChunk->rawBytes += pChunk->len;
+    pChunk->compBytes += head.compLen;
+  }
+
+  pChunk->len = 0;
+  pChunk->records = 0;
+  return 0;
+}
+
+static int32_t syncFlushWalChunk(SSyncPeer *pPeer, SWalChunk *pChunk) {
+  if (pChunk == NULL || pChunk->len == 0) return 0;
+  return syncSendWalChunk(pPeer, pChunk);
+}
+
+// forward a wal record to peer directly, or append it into chunk if wal is retrieved in chunks
+static int32_t syncForwardWalRecord(SSyncPeer *pPeer, SWalChunk *pChunk, SWalHead *pHead, int32_t wsize) {
+  if (pChunk == NULL) {
+    return (taosWriteMsg(pPeer->syncFd, pHead, wsize) == wsize) ? 0 : -1;
+  }
+
+  if (pChunk->len > 0 && pChunk->len + wsize > pChunk->size && syncSendWalChunk(pPeer, pChunk) < 0) return -1;
+
+  memcpy(pChunk->buffer + pChunk->len, pHead, wsize);
+  if (pChunk->records == 0) pChunk->firstVer = pHead->version;
+  pChunk->lastVer = pHead->version;
+  pChunk->len += wsize;
+  pChunk->records++;
+  return 0;
+}
+
+static int64_t syncRetrieveLastWal(SSyncPeer *pPeer, SWalChunk *pChunk, char *name, uint64_t fversion, int64_t offset) {
   int32_t sfd = open(name, O_RDONLY | O_BINARY);
   if (sfd < 0) {
     sError("%s, failed to open wal:%s for retrieve since:%s", pPeer->id, name, tstrerror(errno));
@@ -205,8 +315,7 @@ static int64_t syncRetrieveLastWal(SSyncPeer *pPeer, char *name, uint64_t fversi
     sTrace("%s, last wal is forwarded, hver:%" PRIu64, pPeer->id, pHead->version);
 
     int32_t wsize = (int32_t)code;
-    int32_t ret = taosWriteMsg(pPeer->syncFd, pHead, wsize);
-    if (ret != wsize) {
+    if (syncForwardWalRecord(pPeer, pChunk, pHead, wsize) < 0) {
       code = -1;
       sError("%s, failed to forward wal since %s, hver:%" PRIu64, pPeer->id, strerror(errno), pHead->version);
       break;
@@ -222,13 +331,16 @@ static int64_t syncRetrieveLastWal(SSyncPeer *pPeer, char *name, uint64_t fversi
     }
   }
 
+  // records in chunk shall reach peer before waiting for the wal to be updated
+  if (code >= 0 && syncFlushWalChunk(pPeer, pChunk) < 0) code = -1;
+
   free(pHead);
   close(sfd);
 
   return code;
 }
 
-static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index) {
+static int64_t syncProcessLastWal(SSyncPeer *pPeer, SWalChunk *pChunk, char *wname, int64_t index) {
   SSyncNode *pNode = pPeer->pSyncNode;
   int32_t    once = 0;  // last WAL has once ever been processed
   int64_t    offset = 0;
@@ -243,7 +355,7 @@ static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index)
     if (syncAreFilesModified(pNode, pPeer)) return -1;
     if (syncGetWalVersion(pNode, pPeer) < 0) return -1;
 
-    int64_t bytes = syncRetrieveLastWal(pPeer, fname, fversion, offset);
+    int64_t bytes = syncRetrieveLastWal(pPeer, pChunk, fname, fversion, offset);
     if (bytes < 0) {
       sInfo("%s, failed to retrieve last wal, bytes:%" PRId64, pPeer->id, bytes);
       return bytes;
@@ -284,6 +396,33 @@ static int64_t syncProcessLastWal(SSyncPeer *pPeer, char *wname, int64_t index)
   return -1;
 }
 
+// old wal file won't be modified, its records are read out into chunks
+static int64_t syncRetrieveOldWal(SSyncPeer *pPeer, SWalChunk *pChunk, char *name) {
+  int32_t sfd = open(name, O_RDONLY | O_BINARY);
+  if (sfd < 0) {
+    sError("%s, failed to open wal:%s for retrieve since %s", pPeer->id, name, strerror(errno));
+    return -1;
+  }
+
+  SWalHead *pHead = malloc(SYNC_MAX_SIZE);
+  int64_t   code = (pHead == NULL) ? -1 : 0;
+
+  while (code == 0) {
+    int32_t wsize = syncReadOneWalRecord(sfd, pHead);
+    if (wsize <= 0) {
+      code = wsize;
+      break;
+    }
+
+    code = syncForwardWalRecord(pPeer, pChunk, pHead, wsize);
+  }
+
+  tfree(pHead);
+  close(sfd);
+
+  return code;
+}
+
 static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
   SSyncNode * pNode = pPeer->pSyncNode;
   char        fname[TSDB_FILENAME_LEN * 3];
@@ -291,6 +430,25 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
   int32_t     size;
   int64_t     code = -1;
   int64_t     index = 0;
+  SWalChunk * pChunk = NULL;
+
+  if (pPeer->walChunk) {
+    pChunk = syncOpenWalChunk(pPeer);
+    if (pChunk == NULL) {
+      sError("%s, failed to allocate wal chunk", pPeer->id);
+      return -1;
+    }
+
+    // a wal head with chunk signature tells peer the records that follow are in chunks
+    SWalHead walHead;
+    memset(&walHead, 0, sizeof(walHead));
+    walHead.signature = SYNC_CHUNK_SIGNATURE;
+    if (taosWriteMsg(pPeer->syncFd, &walHead, sizeof(walHead)) != sizeof(walHead)) {
+      sError("%s, failed to send wal chunk head since %s", pPeer->id, strerror(errno));
+      syncCloseWalChunk(pPeer, pChunk);
+      return -1;
+    }
+  }
 
   while (1) {
     // retrieve wal info
@@ -308,7 +466,7 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
     }
 
     if (code == 0) {  // last wal
-      code = syncProcessLastWal(pPeer, wname, index);
+      code = syncProcessLastWal(pPeer, pChunk, wname, index);
       sInfo("%s, last wal processed, code:%" PRId64, pPeer->id, code);
       break;
     }
@@ -327,6 +485,21 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
     size = fstat.st_size;
     sInfo("%s, retrieve wal:%s size:%d", pPeer->id, fname, size);
 
+    if (pChunk != NULL) {
+      code = syncRetrieveOldWal(pPeer, pChunk, fname);
+      if (code < 0) {
+        sError("%s, failed to retrieve wal:%s in chunks, code:0x%" PRIx64, pPeer->id, fname, code);
+        break;
+      }
+
+      if (syncAreFilesModified(pNode, pPeer)) {
+        code = -1;
+        break;
+      }
+
+      continue;
+    }
+
     int32_t sfd = open(fname, O_RDONLY | O_BINARY);
     if (sfd < 0) {
       code = -1;
@@ -347,7 +520,15 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
     }
   }
 
-  if (code == 0) {
+  if (code == 0 && pChunk != NULL) {
+    // an empty chunk tells peer wal is synced over
+    if (syncFlushWalChunk(pPeer, pChunk) == 0 && syncSendWalChunk(pPeer, pChunk) == 0) {
+      pPeer->sstatus = TAOS_SYNC_STATUS_CACHE;
+      sInfo("%s, wal retrieve is finished, set sstatus:%s", pPeer->id, syncStatus[pPeer->sstatus]);
+    } else {
+      code = -1;
+    }
+  } else if (code == 0) {
     SWalHead walHead;
     memset(&walHead, 0, sizeof(walHead));
     if (taosWriteMsg(pPeer->syncFd, &walHead, sizeof(walHead)) == sizeof(walHead)) {
@@ -361,6 +542,7 @@ static int64_t syncRetrieveWal(SSyncPeer *pPeer) {
     sError("%s, failed to send wal since %s, code:0x%" PRIx64, pPeer->id, strerror(errno), code);
   }
 
+  syncCloseWalChunk(pPeer, pChunk);
   return code;
 }
 
@@ -382,7 +564,9 @@ static int32_t syncRetrieveFirstPkt(SSyncPeer *pPeer) {
     return -1;
   }
 
-  sInfo("%s, recv sync-data rsp from peer, tranId:%u rsp-tranId:%u", pPeer->id, msg.tranId, rsp.tranId);
+  pPeer->walChunk = (rsp.walChunk && tsSyncWalChunkSize > 0);
+  sInfo("%s, recv sync-data rsp from peer, tranId:%u rsp-tranId:%u walChunk:%d", pPeer->id, msg.tranId, rsp.tranId,
+        pPeer->walChunk);
   return 0;
 }
 
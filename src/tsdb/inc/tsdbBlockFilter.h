@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_BLOCK_FILTER_H_
+#define _TD_TSDB_BLOCK_FILTER_H_
+
+// Bloom filters of the integer and binary/nchar columns of a file block, so a block can be skipped by an equal or in
+// condition without loading its data. The filters are written right after the block data, outside SBlock.len, one
+// for each SBlockCol with bfBits set, in the order of the SBlockCols. The size of a filter only depends on its
+// bfBits, so the filter of a column is read without reading the others. Files written without filters, and readers
+// not knowing them, just see bfBits as 0 and skip nothing.
+#define TSDB_BLOCK_FILTER_MIN_BITS 6
+#define TSDB_BLOCK_FILTER_MAX_BITS 20
+#define TSDB_BLOCK_FILTER_BITS_PER_KEY 8
+#define TSDB_BLOCK_FILTER_HASHES 6  // with 8 to 16 bits a key, 2% to 0.1% false positives
+
+typedef struct {
+  uint32_t ndv;    // number of distinct not-null values of the column in the block
+  uint8_t  bits;   // log2 of the number of bits of the filter
+  uint8_t  nHash;  // number of hash functions
+  uint8_t  reserved[2];
+  uint8_t  data[];
+} SBlockFilter;
+
+#define TSDB_BLOCK_FILTER_SIZE(bits) (sizeof(SBlockFilter) + ((1u << (bits)) >> 3) + sizeof(TSCKSUM))
+
+bool tsdbHasBlockFilter(int8_t type);
+int  tsdbGetBlockFilterBits(SDataCol *pDataCol, int rows, void **ppBuf);
+void tsdbBuildBlockFilter(SDataCol *pDataCol, int rows, uint8_t bits, SBlockFilter *pFilter);
+bool tsdbBlockFilterMayContain(SBlockFilter *pFilter, const void *val, int32_t len);
+
+#endif /* _TD_TSDB_BLOCK_FILTER_H_ */
@@ -29,6 +29,10 @@ typedef struct {
   int            tBufBlocks;
   int            nBufBlocks;
   int            nRecycleBlocks;
+  int            nExtraBlocks;      // blocks grown beyond tBufBlocks, freed when returned
+  int            nPeakExtraBlocks;
+  int64_t        nGrows;
+  int64_t        nShrinks;
   int64_t        index;
   SList*         bufBlockList;  
 } STsdbBufPool;
@@ -40,6 +44,7 @@ void          tsdbFreeBufPool(STsdbBufPool* pBufPool);
 int           tsdbOpenBufPool(STsdbRepo* pRepo);
 void          tsdbCloseBufPool(STsdbRepo* pRepo);
 SListNode*    tsdbAllocBufBlockFromPool(STsdbRepo* pRepo);
+int           tsdbGrowBufPool(STsdbRepo* pRepo, SListNode** ppNode);
 int           tsdbExpandPool(STsdbRepo* pRepo, int32_t oldTotalBlocks);
 void          tsdbRecycleBufferBlock(STsdbBufPool* pPool, SListNode *pNode);
 
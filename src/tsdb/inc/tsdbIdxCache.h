@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_IDX_CACHE_H_
+#define _TD_TSDB_IDX_CACHE_H_
+
+// Block indexes of the head files, shared by the queries of a repository. The SBlockIdx part of a head file is
+// decoded once into an array ordered by tid, and the head file is mapped so the SBlockInfo of a table is copied from
+// memory. An item is referenced by the readers using it, and leaves the cache once its head file is no longer in the
+// FS after a commit, compaction or sync, or once it is the least recently used one and the memory of the cache is
+// beyond its max size.
+typedef struct STsdbIdxCache STsdbIdxCache;
+typedef struct SBlkIdxItem   SBlkIdxItem;
+
+STsdbIdxCache *tsdbNewIdxCache(int64_t maxSize);
+void           tsdbFreeIdxCache(STsdbIdxCache *pCache);
+void           tsdbInvalidateIdxCache(STsdbRepo *pRepo);
+SBlkIdxItem *  tsdbAcquireBlkIdx(STsdbRepo *pRepo, SDFileSet *pSet);
+void           tsdbReleaseBlkIdx(STsdbRepo *pRepo, SBlkIdxItem *pItem);
+SBlockIdx *    tsdbSearchBlkIdx(SBlkIdxItem *pItem, STable *pTable);
+void *         tsdbGetBlkInfoFromIdx(SBlkIdxItem *pItem, SBlockIdx *pBlkIdx);
+
+#endif /* _TD_TSDB_IDX_CACHE_H_ */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_LAST_H_
+#define _TD_TSDB_LAST_H_
+
+// Persistent store of the cached last row and last not-null columns of all the tables of a repository. The store is
+// written next to the CURRENT file by the commit thread once a commit is over, only the tables with data in the
+// committed memtable are encoded again. At open the store is mapped and the caches of the tables are filled from it
+// instead of reading back the last blocks of every table. The store is only used if the FS is still at the version
+// it was written with, and an entry only if its last key is the one of the table in the files.
+
+#define TSDB_LAST_STORE_MAGIC 0x5453414c  // "LAST"
+#define TSDB_LAST_STORE_VERSION 1
+#define TSDB_LAST_STORE_FNAME "last"
+#define TSDB_LAST_STORE_TEMP_FNAME "last.t"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t fsVersion;     // version of the FS the store matches
+  int8_t   cacheLastRow;  // cacheLast option the values are cached with
+  int8_t   reserved[3];
+  int64_t  totalPoints;   // total points of the FS the store matches
+  int64_t  size;          // size of the store, including the checksum at the end
+  int32_t  numOfTables;
+  int32_t  maxTid;
+} SLastStoreHead;
+
+typedef struct {
+  uint64_t uid;
+  int32_t  tid;
+  int32_t  len;           // length of the entry, 8 bytes aligned
+  TSKEY    lastKey;
+  int32_t  rowLen;        // length of the last row following the entry head, 0 if not cached
+  int16_t  numOfCols;     // number of SLastStoreCol following the row, -1 if the columns are not cached
+  int16_t  lastColSVersion;
+  int8_t   colsRestored;  // whether all the columns were restored when the store was taken
+  int8_t   reserved[7];
+} SLastStoreEntry;
+
+typedef struct {
+  int16_t  colId;
+  uint16_t bytes;         // length of the value following, 0 if the column has no not-null value
+  int32_t  reserved;
+  TSKEY    ts;
+} SLastStoreCol;
+
+typedef struct {
+  char *   pBuf;          // mapped store
+  int64_t  size;
+  int32_t  maxTid;
+  int64_t *offsets;       // offset of the entry of each tid, 0 if not in store
+} SLastStore;
+
+void             tsdbSaveLastStore(STsdbRepo *pRepo, SMemTable *pMem);
+int              tsdbOpenLastStore(STsdbRepo *pRepo, SLastStore *pStore, bool checkFS);
+void             tsdbCloseLastStore(SLastStore *pStore);
+SLastStoreEntry *tsdbGetLastStoreEntry(SLastStore *pStore, STable *pTable);
+bool             tsdbRestoreFromLastStore(STsdbRepo *pRepo, SLastStore *pStore, STable *pTable, TSKEY maxKey);
+
+#endif /* _TD_TSDB_LAST_H_ */
@@ -26,20 +26,49 @@ typedef struct {
   TSKEY keyLast;
 } SMergeInfo;
 
-typedef struct {
-  STable *           pTable;
-  SSkipListIterator *pIter;
-} SCommitIter;
+#define TSDB_MEM_ROW_CHUNK_MIN_ROWS 8
+#define TSDB_MEM_ROW_CHUNK_MAX_ROWS 1024
+
+// A chunk of rows with ascending keys. Rows arriving in key order are appended to the chunk list of a table, only
+// out-of-order rows go to the skiplist. A chunk is only appended by the write thread and never shrinks, so readers
+// can scan it without lock by reading nrows first. The first chunk of a table is small and each next one doubles up
+// to the max, so the tables with a few rows do not fill the buffer pool with empty slots.
+typedef struct SMemRowChunk {
+  struct SMemRowChunk *prev;
+  struct SMemRowChunk *next;
+  int32_t              nrows;
+  int32_t              capacity;
+  SMemRow              rows[];
+} SMemRowChunk;
 
 struct STableData {
-  uint64_t   uid;
-  TSKEY      keyFirst;
-  TSKEY      keyLast;
-  int64_t    numOfRows;
-  SSkipList* pData;
+  uint64_t      uid;
+  TSKEY         keyFirst;
+  TSKEY         keyLast;
+  TSKEY         keyBase;   // last key of the table when created, a key not larger may be in the imem or on disk
+  int64_t       numOfRows;
+  SSkipList*    pData;     // out-of-order rows
+  SMemRowChunk* pHead;     // in-order rows
+  SMemRowChunk* pTail;
+  int64_t       numOfAppendRows;
   T_REF_DECLARE()
 };
 
+// Iterator over both the in-order chunks and the out-of-order skiplist of a STableData. Keys never duplicate
+// between the two parts, so the iterator simply merges them. The iterator has value semantic and can be copied.
+typedef struct {
+  bool              start;
+  int32_t           order;
+  SSkipListIterator slIter;
+  SMemRowChunk*     pChunk;
+  int32_t           idx;
+} STableDataIter;
+
+typedef struct {
+  STable *        pTable;
+  STableDataIter *pIter;
+} SCommitIter;
+
 enum { TSDB_UPDATE_META, TSDB_DROP_META };
 
 #ifdef WINDOWS
@@ -67,27 +96,63 @@ void  tsdbUnTakeMemSnapShot(STsdbRepo* pRepo, SMemSnapshot* pSnapshot);
 void* tsdbAllocBytes(STsdbRepo* pRepo, int bytes);
 int   tsdbAsyncCommit(STsdbRepo* pRepo);
 int   tsdbSyncCommitConfig(STsdbRepo* pRepo);
-int   tsdbLoadDataFromCache(STable* pTable, SSkipListIterator* pIter, TSKEY maxKey, int maxRowsToRead, SDataCols* pCols,
+int   tsdbLoadDataFromCache(STable* pTable, STableDataIter* pIter, TSKEY maxKey, int maxRowsToRead, SDataCols* pCols,
                             TKEY* filterKeys, int nFilterKeys, bool keepDup, SMergeInfo* pMergeInfo);
 void* tsdbCommitData(STsdbRepo* pRepo);
 
-static FORCE_INLINE SMemRow tsdbNextIterRow(SSkipListIterator* pIter) {
-  if (pIter == NULL) return NULL;
+STableDataIter* tsdbCreateTableDataIter(STableData* pTableData);
+STableDataIter* tsdbCreateTableDataIterFromKey(STableData* pTableData, TKEY tkey, int32_t order);
+bool            tsdbTableDataIterNext(STableDataIter* pIter);
+void*           tsdbDestroyTableDataIter(STableDataIter* pIter);
+
+static FORCE_INLINE SMemRow tsdbChunkIterRow(STableDataIter* pIter) {
+  if (pIter->pChunk == NULL || pIter->idx < 0 || pIter->idx >= atomic_load_32(&(pIter->pChunk->nrows))) return NULL;
+  return pIter->pChunk->rows[pIter->idx];
+}
+
+static FORCE_INLINE SMemRow tsdbSkipListIterRow(STableDataIter* pIter) {
+  if (pIter->slIter.pSkipList == NULL) return NULL;
 
-  SSkipListNode* node = tSkipListIterGet(pIter);
+  SSkipListNode* node = tSkipListIterGet(&(pIter->slIter));
   if (node == NULL) return NULL;
 
   return (SMemRow)SL_GET_NODE_DATA(node);
 }
 
-static FORCE_INLINE TSKEY tsdbNextIterKey(SSkipListIterator* pIter) {
+// Return true if the current row of the iterator comes from the chunk list
+static FORCE_INLINE bool tsdbTableDataIterInChunk(STableDataIter* pIter, SMemRow* pRow) {
+  SMemRow crow = tsdbChunkIterRow(pIter);
+  SMemRow srow = tsdbSkipListIterRow(pIter);
+
+  if (crow == NULL || srow == NULL) {
+    *pRow = (crow == NULL) ? srow : crow;
+    return crow != NULL;
+  }
+
+  bool inChunk = (pIter->order == TSDB_ORDER_ASC) ? (memRowKey(crow) < memRowKey(srow))
+                                                  : (memRowKey(crow) > memRowKey(srow));
+  *pRow = inChunk ? crow : srow;
+  return inChunk;
+}
+
+static FORCE_INLINE SMemRow tsdbTableDataIterGet(STableDataIter* pIter) {
+  if (pIter == NULL || !pIter->start) return NULL;
+
+  SMemRow row = NULL;
+  tsdbTableDataIterInChunk(pIter, &row);
+  return row;
+}
+
+static FORCE_INLINE SMemRow tsdbNextIterRow(STableDataIter* pIter) { return tsdbTableDataIterGet(pIter); }
+
+static FORCE_INLINE TSKEY tsdbNextIterKey(STableDataIter* pIter) {
   SMemRow row = tsdbNextIterRow(pIter);
   if (row == NULL) return TSDB_DATA_TIMESTAMP_NULL;
 
   return memRowKey(row);
 }
 
-static FORCE_INLINE TKEY tsdbNextIterTKey(SSkipListIterator* pIter) {
+static FORCE_INLINE TKEY tsdbNextIterTKey(STableDataIter* pIter) {
   SMemRow row = tsdbNextIterRow(pIter);
   if (row == NULL) return TKEY_NULL;
 
@@ -28,6 +28,8 @@ typedef struct STable {
   STSchema*      tagSchema;
   SKVRow         tagVal;
   SSkipList*     pIndex;         // For TSDB_SUPER_TABLE, it is the skiplist index
+  STagIndex*     pTagIndex;      // For TSDB_SUPER_TABLE, it is the inverted index of all the tags
+  int32_t        tagIndexId;     // For TSDB_CHILD_TABLE, it is the id in the inverted index of the super table
   void*          eventHandler;   // TODO
   void*          streamHandler;  // TODO
   TSKEY          lastKey;
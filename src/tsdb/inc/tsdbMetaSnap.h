@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_META_SNAP_H_
+#define _TD_TSDB_META_SNAP_H_
+
+// Checkpoint of the META file: the live table records of the file packed one after another, without the records
+// overwritten or dropped since. It is written from the commit thread once the records appended to the META file since
+// the last checkpoint grow over a quarter of it, and it is bound to the size and magic of the META file it covers.
+// At open the snapshot is mapped and the tables are restored from it, then only the records appended after it are
+// read from the META file. The magic of the META file chains the checksums of all its records, so the records after
+// the snapshot must chain the magic of the snapshot to the magic of the file, otherwise the file is read as before.
+
+#define TSDB_META_SNAP_MAGIC 0x50534e4d  // "MNSP"
+#define TSDB_META_SNAP_VERSION 1
+#define TSDB_META_SNAP_FNAME "metasnap"
+#define TSDB_META_SNAP_TEMP_FNAME "metasnap.t"
+#define TSDB_META_SNAP_TAIL_RATIO 4  // rewrite the snapshot if the records after it exceed 1/4 of the file it covers
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  int64_t  mfSize;       // size of the META file the snapshot covers
+  uint32_t mfMagic;      // magic of the META file at that size
+  int32_t  numOfTables;
+  int64_t  size;         // size of the snapshot, including the checksum at the end
+} SMetaSnapHead;
+
+typedef struct {
+  uint64_t uid;
+  int64_t  offset;       // offset of the record in the META file
+  int32_t  contLen;      // length of the encoded table following the entry head
+  int32_t  len;          // length of the entry, 8 bytes aligned
+} SMetaSnapEntry;
+
+void tsdbSaveMetaSnap(STsdbRepo *pRepo);
+int  tsdbLoadMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, bool recoverMeta, bool *pLoaded);
+
+#endif /* _TD_TSDB_META_SNAP_H_ */
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_READ_AHEAD_H_
+#define _TD_TSDB_READ_AHEAD_H_
+
+// Reads of file blocks done by the read-ahead threads while the reader decompresses the blocks before them. A reader
+// submits the blocks it is going to load, at most depth blocks past the one it is loading, and takes them from
+// memory when it gets there. A read that is not there yet is done by the reader itself. Only the parts of the columns
+// the reader loads are read ahead.
+typedef struct STsdbReadAhead STsdbReadAhead;
+
+STsdbReadAhead *tsdbNewReadAhead();
+void            tsdbFreeReadAhead(STsdbReadAhead *pRa);
+int             tsdbReadAheadDepth(STsdbReadAhead *pRa);
+void            tsdbReadAheadSubmit(STsdbReadAhead *pRa, int fd, int64_t offset, int32_t len, int16_t numOfCols,
+                                    int32_t keyLen, int16_t *colIds, int ncolIds);
+int             tsdbReadAheadGet(STsdbReadAhead *pRa, int fd, int64_t offset, int32_t len, void **ppBuf);
+void            tsdbReadAheadClear(STsdbReadAhead *pRa);
+
+#endif /* _TD_TSDB_READ_AHEAD_H_ */
@@ -21,7 +21,10 @@
 #include "os.h"
 #include "tsdbFile.h"
 #include "tskiplist.h"
+#include "tsdbTagIndex.h"
 #include "tsdbMeta.h"
+#include "tsdbReadAhead.h"
+#include "tsdbBlockFilter.h"
 
 typedef struct SReadH SReadH;
 
@@ -67,7 +70,7 @@ typedef struct {
   int16_t  minIndex;
   int16_t  numOfNull;
   uint8_t  offsetH;
-  char     padding[1];
+  uint8_t  bfBits;  // log2 of the bits of the bloom filter of the column following the block, 0 if no filter
 } SBlockCol;
 
 // Code here just for back-ward compatibility
@@ -101,6 +104,13 @@ struct SReadH {
   SDataCols * pDCols[2];
   void *      pBuf;   // buffer
   void *      pCBuf;  // compression buffer
+  STsdbReadAhead *pRa;   // blocks read ahead of a scan, NULL if not reading ahead
+  bool            cacheIdx;  // whether the block index is taken from the cache of the repository
+  struct SBlkIdxItem *pIdxItem;  // cached block index in use, NULL if read from the head file
+  int64_t         statisKey;     // TSDB_BLOCK_KEY of the block whose statis part is in pBlkData, 0 if none
+  SBlockFilter *  pBlkFilter;    // bloom filter last loaded
+  int64_t         filterKey;     // TSDB_BLOCK_KEY of the block of pBlkFilter, 0 if none
+  int16_t         filterColId;   // column of pBlkFilter
 };
 
 #define TSDB_READ_REPO(rh) ((rh)->pRepo)
@@ -113,7 +123,9 @@ struct SReadH {
 #define TSDB_READ_BUF(rh) ((rh)->pBuf)
 #define TSDB_READ_COMP_BUF(rh) ((rh)->pCBuf)
 
+#define TSDB_KEY_COL_OFFSET 0
 #define TSDB_BLOCK_STATIS_SIZE(ncols) (sizeof(SBlockData) + sizeof(SBlockCol) * (ncols) + sizeof(TSCKSUM))
+#define TSDB_BLOCK_KEY(b) ((int64_t)(b)->offset * 2 + ((b)->last ? 1 : 0))
 
 int   tsdbInitReadH(SReadH *pReadh, STsdbRepo *pRepo);
 void  tsdbDestroyReadH(SReadH *pReadh);
@@ -125,6 +137,7 @@ int   tsdbLoadBlockInfo(SReadH *pReadh, void *pTarget);
 int   tsdbLoadBlockData(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlockInfo);
 int   tsdbLoadBlockDataCols(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo, int16_t *colIds, int numOfColsIds);
 int   tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock);
+int   tsdbLoadBlockFilter(SReadH *pReadh, SBlock *pBlock, int16_t colId, SBlockFilter **ppFilter);
 int   tsdbEncodeSBlockIdx(void **buf, SBlockIdx *pIdx);
 void *tsdbDecodeSBlockIdx(void *buf, SBlockIdx *pIdx);
 void  tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols);
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_TAG_INDEX_H_
+#define _TD_TSDB_TAG_INDEX_H_
+
+// Inverted index of the tag values of the child tables of a super table, one per tag column. Each child table has a
+// dense id in the index. A tag value maps to the ids of the tables that have it, found by a hash for equality and IN
+// and by a skiplist of the distinct values for ranges. A condition is answered as a bitmap of ids, so the conditions
+// on several tags are intersected before any table is touched. It is protected by the lock of the meta.
+typedef struct STagIndex STagIndex;
+
+struct STable;
+
+// test of one tag value against a condition, val is NULL if the table has no value of the tag
+typedef bool (*__tag_val_filter_fn_t)(const char *val, void *param);
+
+STagIndex *    tsdbNewTagIndex(STSchema *pTagSchema);
+void           tsdbFreeTagIndex(STagIndex *pIndex);
+int            tsdbTagIndexSetSchema(STagIndex *pIndex, STSchema *pTagSchema);
+int            tsdbTagIndexAdd(STagIndex *pIndex, struct STable *pTable);
+void           tsdbTagIndexRemove(STagIndex *pIndex, struct STable *pTable);
+int32_t        tsdbTagIndexCapacity(STagIndex *pIndex);
+struct STable *tsdbTagIndexGetTable(STagIndex *pIndex, int32_t id);
+int            tsdbTagIndexMatch(STagIndex *pIndex, SSchema *pSchema, uint8_t optr, const char *q,
+                                 __tag_val_filter_fn_t fp, void *param, uint8_t *bitmap);
+
+#endif /* _TD_TSDB_TAG_INDEX_H_ */
@@ -51,6 +51,7 @@ extern "C" {
 // Log
 #include "tsdbLog.h"
 // Meta
+#include "tsdbTagIndex.h"
 #include "tsdbMeta.h"
 // Buffer
 #include "tsdbBuffer.h"
@@ -62,6 +63,12 @@ extern "C" {
 #include "tsdbFS.h"
 // ReadImpl
 #include "tsdbReadImpl.h"
+// Read Ahead
+#include "tsdbReadAhead.h"
+// Block bloom filters
+#include "tsdbBlockFilter.h"
+// Block index cache
+#include "tsdbIdxCache.h"
 // Commit
 #include "tsdbCommit.h"
 // Compact
@@ -70,6 +77,10 @@ extern "C" {
 #include "tsdbCommitQueue.h"
 
 #include "tsdbRowMergeBuf.h"
+// Last value store
+#include "tsdbLast.h"
+// Meta snapshot
+#include "tsdbMetaSnap.h"
 // Main definitions
 struct STsdbRepo {
   uint8_t state;
@@ -97,6 +108,9 @@ struct STsdbRepo {
 
   SMergeBuf       mergeBuf;  //used when update=2
   int8_t          compactState;  // compact state: inCompact/noCompact/waitingCompact?
+  bool            lastStoreValid;  // the last store matches the files, the next commit takes the entries it keeps
+  STsdbIdxCache*  idxCache;      // block indexes shared by the queries, NULL if not cached
+  int64_t         metaSnapSize;  // size of the META file covered by the META snapshot, 0 if there is none
 };
 
 #define REPO_ID(r) (r)->config.tsdbId
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+static bool tsdbGetBlockFilterKey(SDataCol *pDataCol, int row, const void **ppKey, int32_t *len);
+static int  tsdbCompareHash(const void *arg1, const void *arg2);
+
+static FORCE_INLINE uint32_t tsdbBlockFilterHash2(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h | 1;
+}
+
+bool tsdbHasBlockFilter(int8_t type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_UTINYINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+    case TSDB_DATA_TYPE_UINT:
+    case TSDB_DATA_TYPE_UBIGINT:
+    case TSDB_DATA_TYPE_BINARY:
+    case TSDB_DATA_TYPE_NCHAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Get the bits of the filter of the column from its number of distinct values, 0 if no filter or -1 if failed
+int tsdbGetBlockFilterBits(SDataCol *pDataCol, int rows, void **ppBuf) {
+  const void *key;
+  int32_t     len;
+  int         nkeys = 0;
+
+  if (tsdbMakeRoom(ppBuf, sizeof(uint32_t) * rows) < 0) return -1;
+  uint32_t *hashes = (uint32_t *)(*ppBuf);
+
+  for (int i = 0; i < rows; i++) {
+    if (tsdbGetBlockFilterKey(pDataCol, i, &key, &len)) {
+      hashes[nkeys++] = MurmurHash3_32(key, len);
+    }
+  }
+
+  if (nkeys == 0) return 0;
+
+  qsort(hashes, nkeys, sizeof(uint32_t), tsdbCompareHash);
+  uint32_t ndv = 1;
+  for (int i = 1; i < nkeys; i++) {
+    if (hashes[i] != hashes[i - 1]) ndv++;
+  }
+
+  int bits = TSDB_BLOCK_FILTER_MIN_BITS;
+  while (bits < TSDB_BLOCK_FILTER_MAX_BITS && (1u << bits) < ndv * TSDB_BLOCK_FILTER_BITS_PER_KEY) {
+    bits++;
+  }
+
+  return bits;
+}
+
+// pFilter must have TSDB_BLOCK_FILTER_SIZE(bits) bytes, the checksum is appended
+void tsdbBuildBlockFilter(SDataCol *pDataCol, int rows, uint8_t bits, SBlockFilter *pFilter) {
+  uint32_t    mask = (1u << bits) - 1;
+  uint32_t    ndv = 0;
+  const void *key;
+  int32_t     len;
+
+  memset(pFilter, 0, TSDB_BLOCK_FILTER_SIZE(bits));
+  pFilter->bits = bits;
+  pFilter->nHash = TSDB_BLOCK_FILTER_HASHES;
+
+  for (int i = 0; i < rows; i++) {
+    if (!tsdbGetBlockFilterKey(pDataCol, i, &key, &len)) continue;
+
+    uint32_t h1 = MurmurHash3_32(key, len);
+    uint32_t h2 = tsdbBlockFilterHash2(h1);
+    bool     isNew = false;
+    for (int k = 0; k < pFilter->nHash; k++) {
+      uint32_t pos = (h1 + k * h2) & mask;
+      if ((pFilter->data[pos >> 3] & (1u << (pos & 7))) == 0) {
+        pFilter->data[pos >> 3] |= (uint8_t)(1u << (pos & 7));
+        isNew = true;
+      }
+    }
+
+    // values taken as false positives are not counted, so ndv is a slight underestimate
+    if (isNew) ndv++;
+  }
+
+  pFilter->ndv = ndv;
+  taosCalcChecksumAppend(0, (uint8_t *)pFilter, TSDB_BLOCK_FILTER_SIZE(bits));
+}
+
+// val is the value in the column type, or the content of a binary/nchar value without the length header
+bool tsdbBlockFilterMayContain(SBlockFilter *pFilter, const void *val, int32_t len) {
+  uint32_t mask = (1u << pFilter->bits) - 1;
+  uint32_t h1 = MurmurHash3_32(val, len);
+  uint32_t h2 = tsdbBlockFilterHash2(h1);
+
+  for (int k = 0; k < pFilter->nHash; k++) {
+    uint32_t pos = (h1 + k * h2) & mask;
+    if ((pFilter->data[pos >> 3] & (1u << (pos & 7))) == 0) return false;
+  }
+
+  return true;
+}
+
+static bool tsdbGetBlockFilterKey(SDataCol *pDataCol, int row, const void **ppKey, int32_t *len) {
+  const void *val = tdGetColDataOfRow(pDataCol, row);
+
+  if (isNull(val, pDataCol->type)) return false;
+
+  if (IS_VAR_DATA_TYPE(pDataCol->type)) {
+    *ppKey = varDataVal(val);
+    *len = varDataLen(val);
+  } else {
+    *ppKey = val;
+    *len = TYPE_BYTES[pDataCol->type];
+  }
+
+  return true;
+}
+
+static int tsdbCompareHash(const void *arg1, const void *arg2) {
+  uint32_t h1 = *(uint32_t *)arg1;
+  uint32_t h2 = *(uint32_t *)arg2;
+
+  if (h1 < h2) return -1;
+  if (h1 > h2) return 1;
+  return 0;
+}
@@ -17,8 +17,14 @@
 
 #define POOL_IS_EMPTY(b) (listNEles((b)->bufBlockList) == 0)
 
+extern int32_t tsMemPoolBudget;
+
+// bytes held by the buffer blocks of all vnodes on this dnode
+static int64_t tsdbPoolMemUsed = 0;
+
 static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize);
-static void           tsdbFreeBufBlock(STsdbBufBlock *pBufBlock);
+static void           tsdbFreeBufBlock(STsdbBufBlock *pBufBlock, int bufBlockSize);
+static bool           tsdbReservePoolMem(int64_t bytes);
 
 // ---------------- INTERNAL FUNCTIONS ----------------
 STsdbBufPool *tsdbNewBufPool() {
@@ -75,9 +81,10 @@ int tsdbOpenBufPool(STsdbRepo *pRepo) {
   for (int i = 0; i < pCfg->totalBlocks; i++) {
     STsdbBufBlock *pBufBlock = tsdbNewBufBlock(pPool->bufBlockSize);
     if (pBufBlock == NULL) goto _err;
+    atomic_add_fetch_64(&tsdbPoolMemUsed, pPool->bufBlockSize);
 
     if (tdListAppend(pPool->bufBlockList, (void *)(&pBufBlock)) < 0) {
-      tsdbFreeBufBlock(pBufBlock);
+      tsdbFreeBufBlock(pBufBlock, pPool->bufBlockSize);
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       goto _err;
     }
@@ -105,7 +112,7 @@ void tsdbCloseBufPool(STsdbRepo *pRepo) {
     SListNode *pNode = NULL;
     while ((pNode = tdListPopHead(pBufPool->bufBlockList)) != NULL) {
       tdListNodeGetData(pBufPool->bufBlockList, pNode, (void *)(&pBufBlock));
-      tsdbFreeBufBlock(pBufBlock);
+      tsdbFreeBufBlock(pBufBlock, pBufPool->bufBlockSize);
       free(pNode);
     }
   }
@@ -138,12 +145,70 @@ SListNode *tsdbAllocBufBlockFromPool(STsdbRepo *pRepo) {
   return pNode;
 }
 
+// Called when the memtable already holds its share of the pool. A free block is still taken if there is one,
+// otherwise the pool grows by one block if the budget of the dnode has room for it. Over the budget, the write waits
+// for the committing memtable to return its blocks. If there is none, *ppNode is NULL and the caller takes the rest
+// of the submit from the system memory, which commits the memtable right after it. A grown block is freed again when
+// the memtable returns it after commit.
+int tsdbGrowBufPool(STsdbRepo *pRepo, SListNode **ppNode) {
+  ASSERT(pRepo != NULL && pRepo->pPool != NULL);
+  ASSERT(IS_REPO_LOCKED(pRepo));
+
+  STsdbBufPool *pBufPool = pRepo->pPool;
+
+  *ppNode = NULL;
+  while (POOL_IS_EMPTY(pBufPool)) {
+    if (tsdbReservePoolMem(pBufPool->bufBlockSize)) {
+      STsdbBufBlock *pBufBlock = tsdbNewBufBlock(pBufPool->bufBlockSize);
+      if (pBufBlock == NULL) {
+        atomic_sub_fetch_64(&tsdbPoolMemUsed, pBufPool->bufBlockSize);
+        return -1;
+      }
+
+      if (tdListAppend(pBufPool->bufBlockList, (void *)(&pBufBlock)) < 0) {
+        tsdbFreeBufBlock(pBufBlock, pBufPool->bufBlockSize);
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        return -1;
+      }
+
+      pBufPool->nBufBlocks++;
+      pBufPool->nExtraBlocks++;
+      pBufPool->nGrows++;
+      if (pBufPool->nExtraBlocks > pBufPool->nPeakExtraBlocks) pBufPool->nPeakExtraBlocks = pBufPool->nExtraBlocks;
+
+      tsdbDebug("vgId:%d, buffer pool grows, nBufBlocks:%d nExtraBlocks:%d dnode pool memory:%" PRId64,
+                REPO_ID(pRepo), pBufPool->nBufBlocks, pBufPool->nExtraBlocks, atomic_load_64(&tsdbPoolMemUsed));
+      break;
+    }
+
+    if (pRepo->imem == NULL) {
+      tsdbDebug("vgId:%d, buffer pool can not grow over budget, dnode pool memory:%" PRId64, REPO_ID(pRepo),
+                atomic_load_64(&tsdbPoolMemUsed));
+      return 0;
+    }
+
+    pRepo->repoLocked = false;
+    pthread_cond_wait(&(pBufPool->poolNotEmpty), &(pRepo->mutex));
+    pRepo->repoLocked = true;
+  }
+
+  *ppNode = tsdbAllocBufBlockFromPool(pRepo);
+  return 0;
+}
+
+// Grows never cross the budget, but a write may still finish in system memory. So the vnode also holds new writes
+// while the pools of the dnode are at the budget and this vnode is one of those which grew.
+bool tsdbIsBufPoolFull(STsdbRepo *pRepo) {
+  if (tsMemPoolBudget <= 0 || pRepo->pPool->nExtraBlocks <= 0) return false;
+  return atomic_load_64(&tsdbPoolMemUsed) >= (int64_t)tsMemPoolBudget * 1024 * 1024;
+}
+
 // ---------------- LOCAL FUNCTIONS ----------------
 static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize) {
   STsdbBufBlock *pBufBlock = (STsdbBufBlock *)malloc(sizeof(*pBufBlock) + bufBlockSize);
   if (pBufBlock == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    goto _err;
+    return NULL;
   }
 
   pBufBlock->blockId = 0;
@@ -151,13 +216,27 @@ static STsdbBufBlock *tsdbNewBufBlock(int bufBlockSize) {
   pBufBlock->remain = bufBlockSize;
 
   return pBufBlock;
+}
 
-_err:
-  tsdbFreeBufBlock(pBufBlock);
-  return NULL;
+// Account the bytes of a new block if the pools of the dnode stay within the budget, concurrent vnodes race on it
+static bool tsdbReservePoolMem(int64_t bytes) {
+  int64_t budget = (int64_t)tsMemPoolBudget * 1024 * 1024;
+  int64_t used = atomic_load_64(&tsdbPoolMemUsed);
+
+  while (used + bytes <= budget) {
+    int64_t old = atomic_val_compare_exchange_64(&tsdbPoolMemUsed, used, used + bytes);
+    if (old == used) return true;
+    used = old;
+  }
+
+  return false;
 }
 
-static void tsdbFreeBufBlock(STsdbBufBlock *pBufBlock) { tfree(pBufBlock); }
+static void tsdbFreeBufBlock(STsdbBufBlock *pBufBlock, int bufBlockSize) {
+  if (pBufBlock == NULL) return;
+  atomic_sub_fetch_64(&tsdbPoolMemUsed, bufBlockSize);
+  tfree(pBufBlock);
+}
 
 int tsdbExpandPool(STsdbRepo* pRepo, int32_t oldTotalBlocks) {
   if (oldTotalBlocks == pRepo->config.totalBlocks) {
@@ -173,9 +252,10 @@ int tsdbExpandPool(STsdbRepo* pRepo, int32_t oldTotalBlocks) {
     for (int i = 0; i < pRepo->config.totalBlocks - oldTotalBlocks; i++) {
       STsdbBufBlock *pBufBlock = tsdbNewBufBlock(pPool->bufBlockSize);
       if (pBufBlock == NULL) goto err;
+      atomic_add_fetch_64(&tsdbPoolMemUsed, pPool->bufBlockSize);
 
       if (tdListAppend(pPool->bufBlockList, (void *)(&pBufBlock)) < 0) {
-        tsdbFreeBufBlock(pBufBlock);
+        tsdbFreeBufBlock(pBufBlock, pPool->bufBlockSize);
         terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
         err = TSDB_CODE_TDB_OUT_OF_MEMORY;
         goto err;
@@ -196,7 +276,24 @@ err:
 void tsdbRecycleBufferBlock(STsdbBufPool* pPool, SListNode *pNode) {
   STsdbBufBlock *pBufBlock = NULL;
   tdListNodeGetData(pPool->bufBlockList, pNode, (void *)(&pBufBlock));
-  tsdbFreeBufBlock(pBufBlock);
+  tsdbFreeBufBlock(pBufBlock, pPool->bufBlockSize);
   free(pNode);
   pPool->nBufBlocks--;
 }
+
+void tsdbGetBufPoolStatis(STsdbRepo *repo, STsdbBufPoolStatis *pStatis) {
+  STsdbBufPool *pPool = repo->pPool;
+
+  memset(pStatis, 0, sizeof(*pStatis));
+  if (tsdbLockRepo(repo) < 0) return;
+  pStatis->bufBlockSize = pPool->bufBlockSize;
+  pStatis->numOfBlocks = pPool->nBufBlocks;
+  pStatis->numOfFreeBlocks = (int32_t)listNEles(pPool->bufBlockList);
+  pStatis->numOfExtraBlocks = pPool->nExtraBlocks;
+  pStatis->peakExtraBlocks = pPool->nPeakExtraBlocks;
+  pStatis->numOfGrows = pPool->nGrows;
+  pStatis->numOfShrinks = pPool->nShrinks;
+  tsdbUnlockRepo(repo);
+
+  pStatis->dnodePoolMem = atomic_load_64(&tsdbPoolMemUsed);
+}
@@ -15,6 +15,7 @@
 #include "tsdbint.h"
 
 extern int32_t tsTsdbMetaCompactRatio;
+extern int32_t tsNumOfCommitFSetThreads;
 
 #define TSDB_MAX_SUBBLOCKS 8
 static FORCE_INLINE int TSDB_KEY_FID(TSKEY key, int32_t days, int8_t precision) {
@@ -44,6 +45,23 @@ typedef struct {
   SDataCols *  pDataCols;
 } SCommitH;
 
+typedef struct {
+  SDFileSet *pSet;    // existing FSET, NULL if commit to a new FSET
+  int        fid;
+  bool       hasMem;  // has memory data to commit, otherwise only apply retention
+  bool       done;
+  SDFileSet  wSet;    // FSET committed by worker
+} SCommitFSetTask;
+
+typedef struct {
+  STsdbRepo *      pRepo;
+  SRtn             rtn;
+  SCommitFSetTask *tasks;
+  int              ntasks;
+  int32_t          next;  // index of next task to pick
+  int32_t          code;
+} SCommitFSetPlan;
+
 #define TSDB_COMMIT_REPO(ch) TSDB_READ_REPO(&(ch->readh))
 #define TSDB_COMMIT_REPO_ID(ch) REPO_ID(TSDB_READ_REPO(&(ch->readh)))
 #define TSDB_COMMIT_WRITE_FSET(ch) (&((ch)->wSet))
@@ -61,6 +79,8 @@ static int  tsdbUpdateMetaRecord(STsdbFS *pfs, SMFile *pMFile, uint64_t uid, voi
 static int  tsdbDropMetaRecord(STsdbFS *pfs, SMFile *pMFile, uint64_t uid);
 static int  tsdbCompactMetaFile(STsdbRepo *pRepo, STsdbFS *pfs, SMFile *pMFile);
 static int  tsdbCommitTSData(STsdbRepo *pRepo);
+static int  tsdbCommitTSDataParallel(SCommitH *pCommith, SDFileSet *pSet);
+static void *tsdbCommitFSetWorker(void *arg);
 static void tsdbStartCommit(STsdbRepo *pRepo);
 static void tsdbEndCommit(STsdbRepo *pRepo, int eno);
 static int  tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid);
@@ -580,6 +600,8 @@ _err:
     taosHashCleanup(pfs->metaCache);
     pfs->metaCache = pfs->metaCacheComp;
     pfs->metaCacheComp = NULL;
+    // the records after the META snapshot are no longer those of the compacted file
+    pRepo->metaSnapSize = 0;
   } else {
     // remove meta.tmp file
     remove(mf.f.aname);
@@ -630,6 +652,12 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
     }
   }
 
+  if (tsNumOfCommitFSetThreads > 1) {
+    int code = tsdbCommitTSDataParallel(&commith, pSet);
+    tsdbDestroyCommitH(&commith);
+    return code;
+  }
+
   // Loop to commit to each file
   fid = tsdbNextCommitFid(&(commith));
   while (true) {
@@ -661,7 +689,7 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
         pSet = tsdbFSIterNext(&(commith.fsIter));
       }
 
-      if (tsdbCommitToFile(&commith, pCSet, cfid) < 0) {
+      if (tsdbCommitToFile(&commith, pCSet, cfid) < 0 || tsdbUpdateDFileSet(REPO_FS(pRepo), &(commith.wSet)) < 0) {
         tsdbDestroyCommitH(&commith);
         return -1;
       }
@@ -674,6 +702,156 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
   return 0;
 }
 
+// Commit FSETs in parallel: the FSETs to touch are planned on the calling thread in fid order, each worker owns
+// a private SCommitH and commits whole FSETs, and the results are applied to the FS status in fid order again.
+static int tsdbCommitTSDataParallel(SCommitH *pCommith, SDFileSet *pSet) {
+  STsdbRepo *     pRepo = TSDB_COMMIT_REPO(pCommith);
+  STsdbCfg *      pCfg = REPO_CFG(pRepo);
+  SCommitFSetPlan plan = {0};
+  int             nCommits = 0;
+  int             capacity = 0;
+  int             fid;
+  TSKEY           minKey, maxKey;
+
+  plan.pRepo = pRepo;
+  plan.rtn = pCommith->rtn;
+  plan.code = TSDB_CODE_SUCCESS;
+
+  // Plan the FSETs to commit, the commit iterators are only used to find out the next fid
+  fid = tsdbNextCommitFid(pCommith);
+  while (pSet != NULL || fid != TSDB_IVLD_FID) {
+    if (plan.ntasks >= capacity) {
+      capacity = (capacity == 0) ? 16 : capacity * 2;
+      SCommitFSetTask *tasks = (SCommitFSetTask *)realloc(plan.tasks, sizeof(SCommitFSetTask) * capacity);
+      if (tasks == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        tfree(plan.tasks);
+        return -1;
+      }
+      plan.tasks = tasks;
+    }
+
+    SCommitFSetTask *pTask = plan.tasks + plan.ntasks;
+    memset(pTask, 0, sizeof(*pTask));
+
+    if (pSet && (fid == TSDB_IVLD_FID || pSet->fid < fid)) {
+      pTask->pSet = pSet;
+      pTask->fid = pSet->fid;
+      pTask->hasMem = false;
+      pSet = tsdbFSIterNext(&(pCommith->fsIter));
+    } else {
+      if (pSet == NULL || pSet->fid > fid) {
+        pTask->pSet = NULL;
+        pTask->fid = fid;
+      } else {
+        pTask->pSet = pSet;
+        pTask->fid = pSet->fid;
+        pSet = tsdbFSIterNext(&(pCommith->fsIter));
+      }
+      pTask->hasMem = true;
+      nCommits++;
+
+      tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, pTask->fid, &minKey, &maxKey);
+      tsdbSeekCommitIter(pCommith, maxKey + 1);
+      fid = tsdbNextCommitFid(pCommith);
+    }
+
+    plan.ntasks++;
+  }
+
+  int nthreads = MIN(tsNumOfCommitFSetThreads, nCommits);
+  tsdbDebug("vgId:%d commit %d FSETs with %d threads", REPO_ID(pRepo), nCommits, nthreads);
+
+  if (nthreads <= 1) {
+    tsdbCommitFSetWorker(&plan);
+  } else {
+    pthread_t *threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+    if (threads == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      tfree(plan.tasks);
+      return -1;
+    }
+
+    int nstarted = 0;
+    for (; nstarted < nthreads; nstarted++) {
+      if (pthread_create(threads + nstarted, NULL, tsdbCommitFSetWorker, &plan) != 0) break;
+    }
+
+    // If no thread could be created, commit on the calling thread
+    if (nstarted == 0) tsdbCommitFSetWorker(&plan);
+
+    for (int i = 0; i < nstarted; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    free(threads);
+  }
+
+  // Apply the result in fid order. Committed FSETs are added even on error so their files are cleaned up when
+  // the FS transaction is rolled back.
+  for (int i = 0; i < plan.ntasks; i++) {
+    SCommitFSetTask *pTask = plan.tasks + i;
+
+    if (pTask->hasMem) {
+      if (pTask->done && tsdbUpdateDFileSet(REPO_FS(pRepo), &(pTask->wSet)) < 0) {
+        plan.code = terrno;
+      }
+    } else if (plan.code == TSDB_CODE_SUCCESS) {
+      if (tsdbApplyRtnOnFSet(pRepo, pTask->pSet, &(plan.rtn)) < 0) {
+        plan.code = terrno;
+      }
+    }
+  }
+
+  tfree(plan.tasks);
+
+  if (plan.code != TSDB_CODE_SUCCESS) {
+    terrno = plan.code;
+    return -1;
+  }
+
+  return 0;
+}
+
+static void *tsdbCommitFSetWorker(void *arg) {
+  SCommitFSetPlan *pPlan = (SCommitFSetPlan *)arg;
+  STsdbRepo *      pRepo = pPlan->pRepo;
+  STsdbCfg *       pCfg = REPO_CFG(pRepo);
+  SCommitH         commith;
+  TSKEY            minKey, maxKey;
+
+  setThreadName("tsdbCommitFSet");
+
+  if (tsdbInitCommitH(&commith, pRepo) < 0) {
+    atomic_val_compare_exchange_32(&(pPlan->code), TSDB_CODE_SUCCESS, terrno);
+    return NULL;
+  }
+  commith.rtn = pPlan->rtn;
+
+  // Tasks are picked in ascending fid order, so the commit iterators only move forward
+  while (atomic_load_32(&(pPlan->code)) == TSDB_CODE_SUCCESS) {
+    int idx = atomic_fetch_add_32(&(pPlan->next), 1);
+    if (idx >= pPlan->ntasks) break;
+
+    SCommitFSetTask *pTask = pPlan->tasks + idx;
+    if (!pTask->hasMem) continue;
+
+    tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, pTask->fid, &minKey, &maxKey);
+    tsdbSeekCommitIter(&commith, MAX(minKey, commith.rtn.minKey));
+
+    if (tsdbCommitToFile(&commith, pTask->pSet, pTask->fid) < 0) {
+      tsdbError("vgId:%d failed to commit FSET %d since %s", REPO_ID(pRepo), pTask->fid, tstrerror(terrno));
+      atomic_val_compare_exchange_32(&(pPlan->code), TSDB_CODE_SUCCESS, terrno);
+      break;
+    }
+
+    pTask->wSet = commith.wSet;
+    pTask->done = true;
+  }
+
+  tsdbDestroyCommitH(&commith);
+  return NULL;
+}
+
 static void tsdbStartCommit(STsdbRepo *pRepo) {
   SMemTable *pMem = pRepo->imem;
 
@@ -692,6 +870,8 @@ static void tsdbEndCommit(STsdbRepo *pRepo, int eno) {
     tsdbEndFSTxnWithError(REPO_FS(pRepo));
   } else {
     tsdbEndFSTxn(pRepo);
+    tsdbSaveLastStore(pRepo, pRepo->imem);
+    tsdbSaveMetaSnap(pRepo);
   }
 
   tsdbInfo("vgId:%d commit over, %s", REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed");
@@ -764,10 +944,6 @@ static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
   // Close commit file
   tsdbCloseCommitFile(pCommith, false);
 
-  if (tsdbUpdateDFileSet(REPO_FS(pRepo), &(pCommith->wSet)) < 0) {
-    return -1;
-  }
-
   return 0;
 }
 
@@ -798,12 +974,12 @@ static int tsdbCreateCommitIters(SCommitH *pCommith) {
   for (int i = 0; i < pMem->maxTables; i++) {
     if ((pCommith->iters[i].pTable != NULL) && (pMem->tData[i] != NULL) &&
         (TABLE_UID(pCommith->iters[i].pTable) == pMem->tData[i]->uid)) {
-      if ((pCommith->iters[i].pIter = tSkipListCreateIter(pMem->tData[i]->pData)) == NULL) {
+      if ((pCommith->iters[i].pIter = tsdbCreateTableDataIter(pMem->tData[i])) == NULL) {
         terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
         return -1;
       }
 
-      tSkipListIterNext(pCommith->iters[i].pIter);
+      tsdbTableDataIterNext(pCommith->iters[i].pIter);
     }
   }
 
@@ -816,7 +992,7 @@ static void tsdbDestroyCommitIters(SCommitH *pCommith) {
   for (int i = 1; i < pCommith->niters; i++) {
     if (pCommith->iters[i].pTable != NULL) {
       tsdbUnRefTable(pCommith->iters[i].pTable);
-      tSkipListDestroyIter(pCommith->iters[i].pIter);
+      tsdbDestroyTableDataIter(pCommith->iters[i].pIter);
     }
   }
 
@@ -1070,7 +1246,8 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDataCo
   pBlockData = (SBlockData *)(*ppBuf);
 
   // Get # of cols not all NULL(not including key column)
-  int nColsNotAllNull = 0;
+  int      nColsNotAllNull = 0;
+  uint32_t fsize = 0;  // size of the bloom filters
   for (int ncol = 1; ncol < pDataCols->numOfCols; ncol++) {  // ncol from 1, we skip the timestamp column
     SDataCol * pDataCol = pDataCols->cols + ncol;
     SBlockCol *pBlockCol = pBlockData->cols + nColsNotAllNull;
@@ -1088,6 +1265,14 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDataCo
                                                &(pBlockCol->sum), &(pBlockCol->minIndex), &(pBlockCol->maxIndex),
                                                &(pBlockCol->numOfNull));
     }
+
+    // sub-blocks never have their statis used, so they need no filters
+    if (tsBlockFilter && isSuper && tsdbHasBlockFilter(pDataCol->type)) {
+      int bits = tsdbGetBlockFilterBits(pDataCol, rowsToWrite, ppCBuf);
+      if (bits < 0) return -1;
+      pBlockCol->bfBits = (uint8_t)bits;
+      if (bits > 0) fsize += TSDB_BLOCK_FILTER_SIZE(bits);
+    }
     nColsNotAllNull++;
   }
 
@@ -1165,6 +1350,31 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDataCo
     return -1;
   }
 
+  // Write the bloom filters right after the block, in the order of the columns
+  if (fsize > 0) {
+    if (tsdbMakeRoom(ppCBuf, fsize) < 0) return -1;
+
+    uint32_t foffset = 0;
+    for (int ncol = 1, fcol = 0; ncol < pDataCols->numOfCols && fcol < nColsNotAllNull; ncol++) {
+      SDataCol * pDataCol = pDataCols->cols + ncol;
+      SBlockCol *pBlockCol = pBlockData->cols + fcol;
+
+      if (pDataCol->colId != pBlockCol->colId) continue;
+      fcol++;
+      if (pBlockCol->bfBits == 0) continue;
+
+      SBlockFilter *pFilter = POINTER_SHIFT(*ppCBuf, foffset);
+      tsdbBuildBlockFilter(pDataCol, rowsToWrite, pBlockCol->bfBits, pFilter);
+      foffset += TSDB_BLOCK_FILTER_SIZE(pBlockCol->bfBits);
+      tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(*ppCBuf, foffset - sizeof(TSCKSUM)));
+    }
+    ASSERT(foffset == fsize);
+
+    if (tsdbAppendDFile(pDFile, *ppCBuf, fsize, NULL) < (int)fsize) {
+      return -1;
+    }
+  }
+
   // Update pBlock membership vairables
   pBlock->last = isLast;
   pBlock->offset = offset;
@@ -1178,9 +1388,9 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDataCo
   pBlock->keyLast = dataColsKeyLast(pDataCols);
 
   tsdbDebug("vgId:%d tid:%d a block of data is written to file %s, offset %" PRId64
-            " numOfRows %d len %d numOfCols %" PRId16 " keyFirst %" PRId64 " keyLast %" PRId64,
+            " numOfRows %d len %d numOfCols %" PRId16 " keyFirst %" PRId64 " keyLast %" PRId64 " filters %u",
             REPO_ID(pRepo), TABLE_TID(pTable), TSDB_FILE_FULL_NAME(pDFile), offset, rowsToWrite, pBlock->len,
-            pBlock->numOfCols, pBlock->keyFirst, pBlock->keyLast);
+            pBlock->numOfCols, pBlock->keyFirst, pBlock->keyLast, fsize);
 
   return 0;
 }
@@ -1266,7 +1476,7 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
     keyLimit = pBlock[1].keyFirst - 1;
   }
 
-  SSkipListIterator titer = *(pIter->pIter);
+  STableDataIter titer = *(pIter->pIter);
   if (tsdbLoadBlockDataCols(&(pCommith->readh), pBlock, NULL, &colId, 1) < 0) return -1;
 
   tsdbLoadDataFromCache(pIter->pTable, &titer, keyLimit, INT32_MAX, NULL, pCommith->readh.pDCols[0]->cols[0].pData,
@@ -1444,7 +1654,7 @@ static void tsdbLoadAndMergeFromCache(SDataCols *pDataCols, int *iter, SCommitIt
 
       tdAppendMemRowToDataCol(row, pSchema, pTarget, true);
 
-      tSkipListIterNext(pCommitIter->pIter);
+      tsdbTableDataIterNext(pCommitIter->pIter);
     } else {
       if (update != TD_ROW_OVERWRITE_UPDATE) {
         //copy disk data
@@ -1466,7 +1676,7 @@ static void tsdbLoadAndMergeFromCache(SDataCols *pDataCols, int *iter, SCommitIt
         tdAppendMemRowToDataCol(row, pSchema, pTarget, update == TD_ROW_OVERWRITE_UPDATE);
       }
       (*iter)++;
-      tSkipListIterNext(pCommitIter->pIter);
+      tsdbTableDataIterNext(pCommitIter->pIter);
     }
 
     if (pTarget->numOfRows >= maxRows) break;
@@ -382,6 +382,9 @@ int tsdbEndFSTxn(STsdbRepo *pRepo) {
   // Apply actual change to each file and SDFileSet
   tsdbApplyFSTxnOnDisk(pfs->nstatus, pfs->cstatus);
 
+  // Drop the block indexes of the replaced head files
+  tsdbInvalidateIdxCache(pRepo);
+
   pfs->intxn = false;
   return 0;
 }
@@ -789,6 +792,22 @@ int tsdbLoadMetaCache(STsdbRepo *pRepo, bool recoverMeta) {
     return -1;
   }
 
+  bool loaded = false;
+  if (tsdbLoadMetaSnap(pRepo, pMFile, recoverMeta, &loaded) < 0) {
+    tsdbCloseMFile(pMFile);
+    return -1;
+  }
+
+  if (loaded) {
+    tsdbCloseMFile(pMFile);
+    return 0;
+  }
+
+  if (tsdbSeekMFile(pMFile, TSDB_FILE_HEAD_SIZE, SEEK_SET) < 0) {
+    tsdbCloseMFile(pMFile);
+    return -1;
+  }
+
   while (true) {
     int64_t tsize = tsdbReadMFile(pMFile, tbuf, sizeof(SKVRecord));
     if (tsize == 0) break;
@@ -915,8 +934,9 @@ static int tsdbScanRootDir(STsdbRepo *pRepo) {
   while ((pf = tfsReaddir(tdir))) {
     tfsbasename(pf, bname);
 
-    if (strcmp(bname, tsdbTxnFname[TSDB_TXN_CURR_FILE]) == 0 || strcmp(bname, "data") == 0) {
-      // Skip current file and data directory
+    if (strcmp(bname, tsdbTxnFname[TSDB_TXN_CURR_FILE]) == 0 || strcmp(bname, "data") == 0 ||
+        strcmp(bname, TSDB_LAST_STORE_FNAME) == 0 || strcmp(bname, TSDB_META_SNAP_FNAME) == 0) {
+      // Skip current file, last store, meta snapshot and data directory
       continue;
     }
 
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+struct SBlkIdxItem {
+  int32_t  ref;     // protected by the mutex of the cache
+  bool     cached;  // whether the item is in the cache
+  int32_t  fid;
+  int64_t  size;    // memory of the item, with the mapped head file
+  SDFInfo  info;    // info of the head file the item is loaded from
+  char     fname[TSDB_FILENAME_LEN];
+  SArray * aBlkIdx;  // SBlockIdx array ordered by tid
+  char *   pMap;     // mapped head file
+  int64_t  mapSize;
+  int8_t * verified;  // whether the checksum of the SBlockInfo of each SBlockIdx is checked
+};
+
+struct STsdbIdxCache {
+  pthread_mutex_t mutex;
+  uint64_t        epoch;    // increased each time the cache is invalidated
+  SArray *        items;    // SBlkIdxItem *, from the least recently used to the most recently used
+  int64_t         size;     // memory of the cached items
+  int64_t         maxSize;  // the least recently used items are evicted beyond it
+  int64_t         nHit;
+  int64_t         nMiss;
+  int64_t         nEvict;
+};
+
+static SBlkIdxItem *tsdbNewBlkIdxItem(STsdbRepo *pRepo, SDFileSet *pSet);
+static void         tsdbFreeBlkIdxItem(SBlkIdxItem *pItem);
+static bool         tsdbIsSameHeadFile(SBlkIdxItem *pItem, SDFile *pHeadf);
+static bool         tsdbIsHeadFileInFS(STsdbFS *pfs, const SDFInfo *pInfo, const char *fname, int fid);
+static void         tsdbUnrefBlkIdxItem(SBlkIdxItem *pItem);
+static void         tsdbRemoveBlkIdxItem(STsdbIdxCache *pCache, size_t idx);
+
+STsdbIdxCache *tsdbNewIdxCache(int64_t maxSize) {
+  STsdbIdxCache *pCache = calloc(1, sizeof(*pCache));
+  if (pCache == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pCache->items = taosArrayInit(16, POINTER_BYTES);
+  if (pCache->items == NULL) {
+    free(pCache);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pCache->maxSize = maxSize;
+  pthread_mutex_init(&pCache->mutex, NULL);
+  return pCache;
+}
+
+// All the readers must be over
+void tsdbFreeIdxCache(STsdbIdxCache *pCache) {
+  if (pCache == NULL) return;
+
+  for (size_t i = 0; i < taosArrayGetSize(pCache->items); i++) {
+    SBlkIdxItem *pItem = taosArrayGetP(pCache->items, i);
+    tsdbUnrefBlkIdxItem(pItem);
+  }
+
+  taosArrayDestroy(pCache->items);
+  pthread_mutex_destroy(&pCache->mutex);
+  free(pCache);
+}
+
+// Drop the items whose head files are replaced or removed, called when a FS transaction is over
+void tsdbInvalidateIdxCache(STsdbRepo *pRepo) {
+  STsdbIdxCache *pCache = pRepo->idxCache;
+  if (pCache == NULL) return;
+
+  pthread_mutex_lock(&pCache->mutex);
+  pCache->epoch++;
+  for (size_t i = 0; i < taosArrayGetSize(pCache->items);) {
+    SBlkIdxItem *pItem = taosArrayGetP(pCache->items, i);
+    if (tsdbIsHeadFileInFS(REPO_FS(pRepo), &pItem->info, pItem->fname, pItem->fid)) {
+      i++;
+      continue;
+    }
+
+    tsdbRemoveBlkIdxItem(pCache, i);
+  }
+  pthread_mutex_unlock(&pCache->mutex);
+}
+
+// Get the block index of the head file of the file set, NULL if it cannot be loaded
+SBlkIdxItem *tsdbAcquireBlkIdx(STsdbRepo *pRepo, SDFileSet *pSet) {
+  STsdbIdxCache *pCache = pRepo->idxCache;
+  SDFile *       pHeadf = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+  SBlkIdxItem *  pItem = NULL;
+
+  pthread_mutex_lock(&pCache->mutex);
+  for (size_t i = 0; i < taosArrayGetSize(pCache->items); i++) {
+    SBlkIdxItem *pCached = taosArrayGetP(pCache->items, i);
+    if (pCached->fid == TSDB_FSET_FID(pSet) && tsdbIsSameHeadFile(pCached, pHeadf)) {
+      pCached->ref++;
+      pCache->nHit++;
+      // move it to the most recently used end, there are a few items for the file sets of a vnode
+      taosArrayRemove(pCache->items, i);
+      taosArrayPush(pCache->items, &pCached);
+      pthread_mutex_unlock(&pCache->mutex);
+      return pCached;
+    }
+  }
+  uint64_t epoch = pCache->epoch;
+  pCache->nMiss++;
+  pthread_mutex_unlock(&pCache->mutex);
+
+  // load it out of the lock, and only cache it if the head file is still a current one
+  pItem = tsdbNewBlkIdxItem(pRepo, pSet);
+  if (pItem == NULL) return NULL;
+
+  bool inFS = tsdbIsHeadFileInFS(REPO_FS(pRepo), &pHeadf->info, TSDB_FILE_FULL_NAME(pHeadf), TSDB_FSET_FID(pSet));
+
+  pthread_mutex_lock(&pCache->mutex);
+  for (size_t i = 0; i < taosArrayGetSize(pCache->items); i++) {
+    SBlkIdxItem *pCached = taosArrayGetP(pCache->items, i);
+    if (pCached->fid == TSDB_FSET_FID(pSet) && tsdbIsSameHeadFile(pCached, pHeadf)) {
+      // loaded by another reader meanwhile
+      pCached->ref++;
+      pthread_mutex_unlock(&pCache->mutex);
+      tsdbFreeBlkIdxItem(pItem);
+      return pCached;
+    }
+  }
+
+  int32_t nEvict = 0;
+  if (inFS && epoch == pCache->epoch && pItem->size <= pCache->maxSize &&
+      taosArrayPush(pCache->items, &pItem) != NULL) {
+    pItem->cached = true;
+    pItem->ref++;
+    pCache->size += pItem->size;
+
+    // the items still used by the readers are freed once released
+    while (pCache->size > pCache->maxSize) {
+      tsdbRemoveBlkIdxItem(pCache, 0);
+      nEvict++;
+    }
+    pCache->nEvict += nEvict;
+  }
+  int64_t cacheSize = pCache->size;
+  pthread_mutex_unlock(&pCache->mutex);
+
+  tsdbDebug("vgId:%d block index of file %s is loaded, %" PRIzu " tables, size %" PRId64 ", cached %d, %d evicted, "
+            "cache size %" PRId64,
+            REPO_ID(pRepo), pItem->fname, taosArrayGetSize(pItem->aBlkIdx), pItem->size, pItem->cached, nEvict,
+            cacheSize);
+  return pItem;
+}
+
+void tsdbReleaseBlkIdx(STsdbRepo *pRepo, SBlkIdxItem *pItem) {
+  STsdbIdxCache *pCache = pRepo->idxCache;
+  if (pItem == NULL) return;
+
+  pthread_mutex_lock(&pCache->mutex);
+  tsdbUnrefBlkIdxItem(pItem);
+  pthread_mutex_unlock(&pCache->mutex);
+}
+
+SBlockIdx *tsdbSearchBlkIdx(SBlkIdxItem *pItem, STable *pTable) {
+  int32_t tid = TABLE_TID(pTable);
+  size_t  lo = 0, hi = taosArrayGetSize(pItem->aBlkIdx);
+
+  while (lo < hi) {
+    size_t     mid = (lo + hi) / 2;
+    SBlockIdx *pBlkIdx = taosArrayGet(pItem->aBlkIdx, mid);
+    if (pBlkIdx->tid == tid) {
+      return (pBlkIdx->uid == TABLE_UID(pTable)) ? pBlkIdx : NULL;
+    } else if (pBlkIdx->tid < tid) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return NULL;
+}
+
+// Get the SBlockInfo part of a table in the mapped head file, NULL if it is corrupted
+void *tsdbGetBlkInfoFromIdx(SBlkIdxItem *pItem, SBlockIdx *pBlkIdx) {
+  if (pItem->pMap == NULL || (int64_t)pBlkIdx->offset + pBlkIdx->len > pItem->mapSize) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    return NULL;
+  }
+
+  size_t idx = POINTER_DISTANCE(pBlkIdx, taosArrayGet(pItem->aBlkIdx, 0)) / sizeof(SBlockIdx);
+  char * pBlkInfo = pItem->pMap + pBlkIdx->offset;
+
+  if (!atomic_load_8(pItem->verified + idx)) {
+    if (!taosCheckChecksumWhole((uint8_t *)pBlkInfo, pBlkIdx->len)) {
+      terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+      return NULL;
+    }
+    atomic_store_8(pItem->verified + idx, 1);
+  }
+
+  return pBlkInfo;
+}
+
+static SBlkIdxItem *tsdbNewBlkIdxItem(STsdbRepo *pRepo, SDFileSet *pSet) {
+  SDFile *    pHeadf = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+  SBlockIdx   blkIdx;
+  struct stat st;
+
+  SBlkIdxItem *pItem = calloc(1, sizeof(*pItem));
+  if (pItem == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pItem->ref = 1;
+  pItem->size = sizeof(*pItem);
+  pItem->fid = TSDB_FSET_FID(pSet);
+  pItem->info = pHeadf->info;
+  tstrncpy(pItem->fname, TSDB_FILE_FULL_NAME(pHeadf), TSDB_FILENAME_LEN);
+
+  pItem->aBlkIdx = taosArrayInit(1024, sizeof(SBlockIdx));
+  if (pItem->aBlkIdx == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  // No data at all
+  if (pHeadf->info.offset <= 0) return pItem;
+
+  int fd = open(pItem->fname, O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    close(fd);
+    goto _err;
+  }
+
+  pItem->mapSize = st.st_size;
+#ifdef WINDOWS
+  pItem->pMap = malloc(pItem->mapSize);
+  if (pItem->pMap != NULL && taosRead(fd, pItem->pMap, pItem->mapSize) < pItem->mapSize) {
+    tfree(pItem->pMap);
+  }
+#else
+  pItem->pMap = mmap(NULL, pItem->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (pItem->pMap == MAP_FAILED) pItem->pMap = NULL;
+#endif
+  close(fd);
+
+  if (pItem->pMap == NULL) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  if ((int64_t)pHeadf->info.offset + pHeadf->info.len > pItem->mapSize ||
+      !taosCheckChecksumWhole((uint8_t *)(pItem->pMap + pHeadf->info.offset), pHeadf->info.len)) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d SBlockIdx part in file %s is corrupted, offset:%u len :%u", REPO_ID(pRepo), pItem->fname,
+              pHeadf->info.offset, pHeadf->info.len);
+    goto _err;
+  }
+
+  void *pStart = pItem->pMap + pHeadf->info.offset;
+  void *ptr = pStart;
+  while (POINTER_DISTANCE(ptr, pStart) < (pHeadf->info.len - sizeof(TSCKSUM))) {
+    ptr = tsdbDecodeSBlockIdx(ptr, &blkIdx);
+    ASSERT(ptr != NULL);
+
+    if (taosArrayPush(pItem->aBlkIdx, (void *)(&blkIdx)) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _err;
+    }
+  }
+
+  pItem->verified = calloc(taosArrayGetSize(pItem->aBlkIdx) + 1, sizeof(int8_t));
+  if (pItem->verified == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  pItem->size += pItem->mapSize + taosArrayGetSize(pItem->aBlkIdx) * (sizeof(SBlockIdx) + sizeof(int8_t));
+  return pItem;
+
+_err:
+  tsdbFreeBlkIdxItem(pItem);
+  return NULL;
+}
+
+static void tsdbFreeBlkIdxItem(SBlkIdxItem *pItem) {
+  if (pItem == NULL) return;
+
+  if (pItem->pMap != NULL) {
+#ifdef WINDOWS
+    tfree(pItem->pMap);
+#else
+    munmap(pItem->pMap, pItem->mapSize);
+#endif
+  }
+  taosArrayDestroy(pItem->aBlkIdx);
+  tfree(pItem->verified);
+  free(pItem);
+}
+
+static void tsdbUnrefBlkIdxItem(SBlkIdxItem *pItem) {
+  if (--pItem->ref == 0) {
+    tsdbFreeBlkIdxItem(pItem);
+  }
+}
+
+// Called with the mutex of the cache locked
+static void tsdbRemoveBlkIdxItem(STsdbIdxCache *pCache, size_t idx) {
+  SBlkIdxItem *pItem = taosArrayGetP(pCache->items, idx);
+
+  taosArrayRemove(pCache->items, idx);
+  pCache->size -= pItem->size;
+  pItem->cached = false;
+  tsdbUnrefBlkIdxItem(pItem);
+}
+
+static bool tsdbIsSameHeadFile(SBlkIdxItem *pItem, SDFile *pHeadf) {
+  return memcmp(&pItem->info, &pHeadf->info, sizeof(SDFInfo)) == 0 &&
+         strcmp(pItem->fname, TSDB_FILE_FULL_NAME(pHeadf)) == 0;
+}
+
+static bool tsdbIsHeadFileInFS(STsdbFS *pfs, const SDFInfo *pInfo, const char *fname, int fid) {
+  bool found = false;
+
+  if (tsdbRLockFS(pfs) < 0) return false;
+  SArray *df = pfs->cstatus->df;
+  for (size_t i = 0; i < taosArrayGetSize(df); i++) {
+    SDFileSet *pSet = taosArrayGet(df, i);
+    if (pSet->fid != fid) continue;
+
+    SDFile *pf = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+    found = (memcmp(&pf->info, pInfo, sizeof(SDFInfo)) == 0 && strcmp(TSDB_FILE_FULL_NAME(pf), fname) == 0);
+    break;
+  }
+  tsdbUnLockFS(pfs);
+
+  return found;
+}
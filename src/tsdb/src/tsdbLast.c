@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+#define TSDB_LAST_ALIGN(l) (((l) + 7) & (~((int64_t)7)))
+#define TSDB_LAST_HEAD(buf) ((SLastStoreHead *)(buf))
+
+static void tsdbGetLastStoreFname(int repoid, const char *bname, char fname[]);
+static int  tsdbReserveLastSnap(char **ppBuf, int64_t *pCap, int64_t len);
+static int  tsdbEncodeLastEntry(STsdbRepo *pRepo, STable *pTable, STSchema *pSchema, char **ppBuf, int64_t *pCap);
+static int  tsdbCopyLastEntry(SLastStoreEntry *pEntry, char **ppBuf, int64_t *pCap);
+static bool tsdbRestoreLastColsFromEntry(STable *pTable, SLastStoreEntry *pEntry, char *ptr, char *pEnd,
+                                         TSKEY maxKey);
+
+/**
+ * Write the last values of all the tables. Called from the commit thread after the FS transaction is over, so the
+ * store can be bound to the version of the FS it matches. The tables with data in the committed mem table are encoded
+ * from their caches, the others did not change in the files and keep their entries of the store of the last commit.
+ *
+ * The writes go on while the store is written, so the cache of a table may hold rows newer than the files. The entry
+ * is rejected at open as its last key does not match the files, and the table is scanned. Failure only costs a rescan
+ * at next open.
+ */
+void tsdbSaveLastStore(STsdbRepo *pRepo, SMemTable *pMem) {
+  STsdbCfg * pCfg = REPO_CFG(pRepo);
+  STsdbMeta *pMeta = pRepo->tsdbMeta;
+  STsdbFS *  pfs = REPO_FS(pRepo);
+  SLastStore prev;
+  bool       hasPrev = false;
+  char *     pBuf = NULL;
+  int64_t    cap = 1024 * 1024;
+  int32_t    numOfTables = 0;
+  int32_t    numOfEncoded = 0;
+  char       tfname[TSDB_FILENAME_LEN] = "\0";
+  char       fname[TSDB_FILENAME_LEN] = "\0";
+
+  if (!CACHE_LAST_ROW(pCfg) && !CACHE_LAST_NULL_COLUMN(pCfg)) {
+    pRepo->lastStoreValid = false;
+    return;
+  }
+
+  if (pRepo->lastStoreValid) {
+    hasPrev = (tsdbOpenLastStore(pRepo, &prev, false) == 0);
+  }
+  pRepo->lastStoreValid = false;
+
+  pBuf = malloc(cap);
+  if (pBuf == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  SLastStoreHead *pHead = TSDB_LAST_HEAD(pBuf);
+  memset(pHead, 0, sizeof(*pHead));
+  pHead->magic = TSDB_LAST_STORE_MAGIC;
+  pHead->version = TSDB_LAST_STORE_VERSION;
+  pHead->cacheLastRow = pCfg->cacheLastRow;
+  pHead->size = sizeof(SLastStoreHead);
+
+  // the meta is locked table by table, the tables can be created and dropped in between
+  for (int32_t tid = 1;; tid++) {
+    if (tsdbRLockRepoMeta(pRepo) < 0) goto _err;
+    if (tid >= pMeta->maxTables) {
+      TSDB_LAST_HEAD(pBuf)->maxTid = pMeta->maxTables - 1;
+      tsdbUnlockRepoMeta(pRepo);
+      break;
+    }
+
+    int     code = 0;
+    STable *pTable = pMeta->tables[tid];
+    if (pTable != NULL && tsdbGetTableLastKeyImpl(pTable) != TSKEY_INITIAL_VAL) {
+      SLastStoreEntry *pEntry = hasPrev ? tsdbGetLastStoreEntry(&prev, pTable) : NULL;
+      bool             changed = (tid < pMem->maxTables && pMem->tData[tid] != NULL);
+
+      if (pEntry != NULL && !changed) {
+        code = tsdbCopyLastEntry(pEntry, &pBuf, &cap);
+      } else {
+        // Get the schema before holding the latch of the table, a normal table latches itself to get its schema
+        STSchema *pSchema = tsdbGetTableLatestSchema(pTable);
+
+        TSDB_RLOCK_TABLE(pTable);
+        code = tsdbEncodeLastEntry(pRepo, pTable, pSchema, &pBuf, &cap);
+        TSDB_RUNLOCK_TABLE(pTable);
+        numOfEncoded++;
+      }
+      numOfTables++;
+    }
+    tsdbUnlockRepoMeta(pRepo);
+
+    if (code < 0) goto _err;
+  }
+
+  if (hasPrev) {
+    tsdbCloseLastStore(&prev);
+    hasPrev = false;
+  }
+
+  pHead = TSDB_LAST_HEAD(pBuf);
+  pHead->numOfTables = numOfTables;
+  pHead->fsVersion = FS_VERSION(pfs);
+  pHead->totalPoints = pfs->cstatus->meta.totalPoints;
+  pHead->size += sizeof(TSCKSUM);
+  taosCalcChecksumAppend(0, (uint8_t *)pBuf, (uint32_t)pHead->size);
+
+  tsdbGetLastStoreFname(REPO_ID(pRepo), TSDB_LAST_STORE_TEMP_FNAME, tfname);
+  tsdbGetLastStoreFname(REPO_ID(pRepo), TSDB_LAST_STORE_FNAME, fname);
+
+  int fd = open(tfname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0755);
+  if (fd < 0) {
+    tsdbWarn("vgId:%d failed to open file %s since %s", REPO_ID(pRepo), tfname, strerror(errno));
+    tfree(pBuf);
+    return;
+  }
+
+  if (taosWrite(fd, pBuf, pHead->size) < pHead->size || taosFsync(fd) < 0) {
+    tsdbWarn("vgId:%d failed to write file %s since %s", REPO_ID(pRepo), tfname, strerror(errno));
+    close(fd);
+    remove(tfname);
+    tfree(pBuf);
+    return;
+  }
+
+  close(fd);
+
+  if (taosRename(tfname, fname) < 0) {
+    tsdbWarn("vgId:%d failed to rename file %s to %s since %s", REPO_ID(pRepo), tfname, fname, strerror(errno));
+    remove(tfname);
+  } else {
+    pRepo->lastStoreValid = true;
+    tsdbDebug("vgId:%d last store of %d tables is saved, %d encoded, fs version %u size %" PRId64, REPO_ID(pRepo),
+              numOfTables, numOfEncoded, pHead->fsVersion, pHead->size);
+  }
+
+  tfree(pBuf);
+  return;
+
+_err:
+  tsdbWarn("vgId:%d failed to take last values since %s", REPO_ID(pRepo), tstrerror(terrno));
+  if (hasPrev) tsdbCloseLastStore(&prev);
+  tfree(pBuf);
+}
+
+// Map the store and check it still matches the FS if checkFS is set. Return -1 if there is no usable store.
+int tsdbOpenLastStore(STsdbRepo *pRepo, SLastStore *pStore, bool checkFS) {
+  STsdbFS *pfs = REPO_FS(pRepo);
+  char     fname[TSDB_FILENAME_LEN] = "\0";
+  struct stat st;
+
+  memset(pStore, 0, sizeof(*pStore));
+
+  tsdbGetLastStoreFname(REPO_ID(pRepo), TSDB_LAST_STORE_FNAME, fname);
+
+  int fd = open(fname, O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    tsdbDebug("vgId:%d no last store since %s", REPO_ID(pRepo), strerror(errno));
+    return -1;
+  }
+
+  if (fstat(fd, &st) < 0 || st.st_size < (int64_t)(sizeof(SLastStoreHead) + sizeof(TSCKSUM))) {
+    tsdbWarn("vgId:%d last store %s is invalid", REPO_ID(pRepo), fname);
+    close(fd);
+    return -1;
+  }
+
+  pStore->size = st.st_size;
+#ifdef WINDOWS
+  pStore->pBuf = malloc(pStore->size);
+  if (pStore->pBuf != NULL && taosRead(fd, pStore->pBuf, pStore->size) < pStore->size) {
+    tfree(pStore->pBuf);
+  }
+#else
+  pStore->pBuf = mmap(NULL, pStore->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (pStore->pBuf == MAP_FAILED) pStore->pBuf = NULL;
+#endif
+  close(fd);
+
+  if (pStore->pBuf == NULL) {
+    tsdbWarn("vgId:%d failed to load last store %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+    return -1;
+  }
+
+  SLastStoreHead *pHead = TSDB_LAST_HEAD(pStore->pBuf);
+  if (pHead->magic != TSDB_LAST_STORE_MAGIC || pHead->version != TSDB_LAST_STORE_VERSION ||
+      pHead->size != pStore->size || pHead->maxTid < 0 ||
+      !taosCheckChecksumWhole((uint8_t *)pStore->pBuf, (uint32_t)pStore->size)) {
+    tsdbWarn("vgId:%d last store %s is corrupted", REPO_ID(pRepo), fname);
+    tsdbCloseLastStore(pStore);
+    return -1;
+  }
+
+  if (checkFS && (pHead->fsVersion != FS_VERSION(pfs) || pHead->totalPoints != pfs->cstatus->meta.totalPoints)) {
+    tsdbInfo("vgId:%d last store is stale, fs version %u points %" PRId64 " while current %u points %" PRId64,
+             REPO_ID(pRepo), pHead->fsVersion, pHead->totalPoints, FS_VERSION(pfs), pfs->cstatus->meta.totalPoints);
+    tsdbCloseLastStore(pStore);
+    return -1;
+  }
+
+  pStore->maxTid = pHead->maxTid;
+  pStore->offsets = calloc(pStore->maxTid + 1, sizeof(int64_t));
+  if (pStore->offsets == NULL) {
+    tsdbCloseLastStore(pStore);
+    return -1;
+  }
+
+  int64_t offset = sizeof(SLastStoreHead);
+  int64_t end = pStore->size - sizeof(TSCKSUM);
+  for (int32_t i = 0; i < pHead->numOfTables; i++) {
+    SLastStoreEntry *pEntry = (SLastStoreEntry *)POINTER_SHIFT(pStore->pBuf, offset);
+    if (offset + (int64_t)sizeof(SLastStoreEntry) > end || pEntry->len < (int32_t)sizeof(SLastStoreEntry) ||
+        offset + pEntry->len > end || pEntry->tid <= 0 || pEntry->tid > pStore->maxTid) {
+      tsdbWarn("vgId:%d last store %s is corrupted at offset %" PRId64, REPO_ID(pRepo), fname, offset);
+      tsdbCloseLastStore(pStore);
+      return -1;
+    }
+
+    pStore->offsets[pEntry->tid] = offset;
+    offset += pEntry->len;
+  }
+
+  tsdbDebug("vgId:%d last store of %d tables is loaded, size %" PRId64, REPO_ID(pRepo), pHead->numOfTables,
+            pStore->size);
+  return 0;
+}
+
+void tsdbCloseLastStore(SLastStore *pStore) {
+  if (pStore->pBuf != NULL) {
+#ifdef WINDOWS
+    tfree(pStore->pBuf);
+#else
+    munmap(pStore->pBuf, pStore->size);
+    pStore->pBuf = NULL;
+#endif
+  }
+  tfree(pStore->offsets);
+  pStore->size = 0;
+  pStore->maxTid = 0;
+}
+
+SLastStoreEntry *tsdbGetLastStoreEntry(SLastStore *pStore, STable *pTable) {
+  int32_t tid = TABLE_TID(pTable);
+  if (tid > pStore->maxTid || pStore->offsets[tid] == 0) return NULL;
+
+  SLastStoreEntry *pEntry = (SLastStoreEntry *)POINTER_SHIFT(pStore->pBuf, pStore->offsets[tid]);
+  return (pEntry->uid == TABLE_UID(pTable)) ? pEntry : NULL;
+}
+
+// Fill the cached last row and last columns of the table from the store, maxKey is the max key of the table in the
+// files. Return true if the entry of the table is valid, then the last row needs no reading from the files. The
+// last columns are restored apart: if they cannot, hasRestoreLastColumn is left unset and they are read back.
+bool tsdbRestoreFromLastStore(STsdbRepo *pRepo, SLastStore *pStore, STable *pTable, TSKEY maxKey) {
+  STsdbCfg *       pCfg = REPO_CFG(pRepo);
+  SLastStoreEntry *pEntry = tsdbGetLastStoreEntry(pStore, pTable);
+
+  if (pEntry == NULL || pEntry->lastKey != maxKey) return false;
+
+  char *pEnd = POINTER_SHIFT(pEntry, pEntry->len);
+  char *ptr = POINTER_SHIFT(pEntry, sizeof(*pEntry));
+
+  if (CACHE_LAST_ROW(pCfg)) {
+    SMemRow row = (SMemRow)ptr;
+    if (pEntry->rowLen <= 0 || ptr + pEntry->rowLen > pEnd || pTable->lastRow != NULL ||
+        memRowTLen(row) != pEntry->rowLen || memRowKey(row) != maxKey ||
+        tsdbGetTableSchemaByVersion(pTable, memRowVersion(row)) == NULL) {
+      return false;
+    }
+
+    pTable->lastRow = taosTMalloc(pEntry->rowLen);
+    if (pTable->lastRow == NULL) return false;
+    memRowCpy(pTable->lastRow, row);
+  }
+
+  ptr = POINTER_SHIFT(ptr, TSDB_LAST_ALIGN(pEntry->rowLen));
+
+  if (CACHE_LAST_NULL_COLUMN(pCfg) && pEntry->numOfCols >= 0 && pTable->lastCols == NULL) {
+    if (!tsdbRestoreLastColsFromEntry(pTable, pEntry, ptr, pEnd, maxKey)) {
+      tsdbFreeLastColumns(pTable);
+    }
+  }
+
+  return true;
+}
+
+static bool tsdbRestoreLastColsFromEntry(STable *pTable, SLastStoreEntry *pEntry, char *ptr, char *pEnd,
+                                         TSKEY maxKey) {
+  STSchema *pSchema = tsdbGetTableLatestSchema(pTable);
+  if (pSchema == NULL || schemaVersion(pSchema) != pEntry->lastColSVersion ||
+      schemaNCols(pSchema) != pEntry->numOfCols) {
+    return false;
+  }
+
+  if (tsdbInitColIdCacheWithSchema(pTable, pSchema) < 0) return false;
+
+  for (int16_t i = 0; i < pEntry->numOfCols; i++) {
+    SLastStoreCol *pCol = (SLastStoreCol *)ptr;
+    if (ptr + sizeof(*pCol) > pEnd || ptr + sizeof(*pCol) + pCol->bytes > pEnd) return false;
+    if (pCol->colId != pTable->lastCols[i].colId || pCol->ts > maxKey) return false;
+
+    if (pCol->bytes > 0) {
+      SDataCol *pLastCol = &(pTable->lastCols[i]);
+      pLastCol->pData = malloc(pCol->bytes);
+      if (pLastCol->pData == NULL) return false;
+      memcpy(pLastCol->pData, POINTER_SHIFT(pCol, sizeof(*pCol)), pCol->bytes);
+      pLastCol->bytes = pCol->bytes;
+      pLastCol->ts = pCol->ts;
+      pTable->restoreColumnNum++;
+    }
+
+    ptr = POINTER_SHIFT(ptr, sizeof(*pCol) + TSDB_LAST_ALIGN(pCol->bytes));
+  }
+
+  if (pEntry->colsRestored || pTable->restoreColumnNum >= pEntry->numOfCols) {
+    pTable->hasRestoreLastColumn = true;
+  }
+
+  return true;
+}
+
+static void tsdbGetLastStoreFname(int repoid, const char *bname, char fname[]) {
+  snprintf(fname, TSDB_FILENAME_LEN, "%s/vnode/vnode%d/tsdb/%s", TFS_PRIMARY_PATH(), repoid, bname);
+}
+
+static int tsdbReserveLastSnap(char **ppBuf, int64_t *pCap, int64_t len) {
+  // always leave room for the checksum
+  len += sizeof(TSCKSUM);
+  if (len <= *pCap) return 0;
+
+  int64_t cap = *pCap;
+  while (cap < len) cap *= 2;
+
+  char *buf = realloc(*ppBuf, cap);
+  if (buf == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  *ppBuf = buf;
+  *pCap = cap;
+  return 0;
+}
+
+// Encode the last values of a table with its latch held
+static int tsdbEncodeLastEntry(STsdbRepo *pRepo, STable *pTable, STSchema *pSchema, char **ppBuf, int64_t *pCap) {
+  STsdbCfg *pCfg = REPO_CFG(pRepo);
+  SMemRow   row = CACHE_LAST_ROW(pCfg) ? pTable->lastRow : NULL;
+  int32_t   rowLen = (row == NULL) ? 0 : (int32_t)memRowTLen(row);
+  bool      hasCols = CACHE_LAST_NULL_COLUMN(pCfg) && pTable->lastCols != NULL;
+  // the value type is known by the latest schema only if the cache is still at the latest version
+  bool      typed = hasCols && pSchema != NULL && pTable->lastColSVersion == schemaVersion(pSchema) &&
+               pTable->maxColNum == schemaNCols(pSchema);
+  int64_t   len = sizeof(SLastStoreEntry) + TSDB_LAST_ALIGN(rowLen);
+
+  if (hasCols) {
+    for (int16_t i = 0; i < pTable->maxColNum; i++) {
+      len += sizeof(SLastStoreCol) + TSDB_LAST_ALIGN(pTable->lastCols[i].bytes);
+    }
+  }
+
+  int64_t offset = TSDB_LAST_HEAD(*ppBuf)->size;
+  if (tsdbReserveLastSnap(ppBuf, pCap, offset + len) < 0) return -1;
+
+  SLastStoreEntry *pEntry = (SLastStoreEntry *)POINTER_SHIFT(*ppBuf, offset);
+  memset(pEntry, 0, sizeof(*pEntry));
+  pEntry->uid = TABLE_UID(pTable);
+  pEntry->tid = TABLE_TID(pTable);
+  pEntry->lastKey = pTable->lastKey;
+  pEntry->rowLen = rowLen;
+  pEntry->numOfCols = hasCols ? pTable->maxColNum : -1;
+  pEntry->lastColSVersion = pTable->lastColSVersion;
+  pEntry->colsRestored = pTable->hasRestoreLastColumn;
+
+  char *ptr = POINTER_SHIFT(pEntry, sizeof(*pEntry));
+  if (rowLen > 0) memRowCpy(ptr, row);
+  ptr = POINTER_SHIFT(ptr, TSDB_LAST_ALIGN(rowLen));
+
+  for (int16_t i = 0; hasCols && i < pTable->maxColNum; i++) {
+    SDataCol *     pLastCol = &(pTable->lastCols[i]);
+    SLastStoreCol *pCol = (SLastStoreCol *)ptr;
+    uint16_t       bytes = pLastCol->bytes;
+
+    // the cache may hold a value shorter than its buffer
+    if (bytes > 0 && typed && IS_VAR_DATA_TYPE(schemaColAt(pSchema, i)->type)) {
+      bytes = (uint16_t)varDataTLen(pLastCol->pData);
+    }
+
+    pCol->colId = pLastCol->colId;
+    pCol->bytes = bytes;
+    pCol->reserved = 0;
+    pCol->ts = pLastCol->ts;
+    if (bytes > 0) memcpy(POINTER_SHIFT(pCol, sizeof(*pCol)), pLastCol->pData, bytes);
+
+    ptr = POINTER_SHIFT(ptr, sizeof(*pCol) + TSDB_LAST_ALIGN(bytes));
+  }
+
+  pEntry->len = (int32_t)((char *)ptr - (char *)pEntry);
+  TSDB_LAST_HEAD(*ppBuf)->size = offset + pEntry->len;
+  return 0;
+}
+
+static int tsdbCopyLastEntry(SLastStoreEntry *pEntry, char **ppBuf, int64_t *pCap) {
+  int64_t offset = TSDB_LAST_HEAD(*ppBuf)->size;
+  if (tsdbReserveLastSnap(ppBuf, pCap, offset + pEntry->len) < 0) return -1;
+
+  memcpy(POINTER_SHIFT(*ppBuf, offset), pEntry, pEntry->len);
+  TSDB_LAST_HEAD(*ppBuf)->size = offset + pEntry->len;
+  return 0;
+}
@@ -185,7 +185,7 @@ int tsdbCheckCommit(STsdbRepo *pRepo) {
 
   STsdbBufBlock *pBufBlock = tsdbGetCurrBufBlock(pRepo);
   ASSERT(pBufBlock != NULL);
-  if ((pRepo->mem->extraBuffList != NULL) ||
+  if ((pRepo->mem->extraBuffList != NULL) || (listNEles(pRepo->mem->bufBlockList) > pCfg->totalBlocks / 3) ||
       ((listNEles(pRepo->mem->bufBlockList) >= pCfg->totalBlocks / 3) && (pBufBlock->remain < TSDB_BUFFER_RESERVE))) {
     // trigger commit
     if (tsdbAsyncCommit(pRepo) < 0) return -1;
@@ -593,6 +593,15 @@ static STsdbRepo *tsdbNewRepo(STsdbCfg *pCfg, STsdbAppH *pAppH) {
     return NULL;
   }
 
+  if (tsBlockIdxCache) {
+    pRepo->idxCache = tsdbNewIdxCache((int64_t)tsBlockIdxCacheSize * 1024 * 1024);
+    if (pRepo->idxCache == NULL) {
+      tsdbError("vgId:%d failed to create block index cache since %s", REPO_ID(pRepo), tstrerror(terrno));
+      tsdbFreeRepo(pRepo);
+      return NULL;
+    }
+  }
+
   return pRepo;
 }
 
@@ -602,6 +611,7 @@ static void tsdbFreeRepo(STsdbRepo *pRepo) {
     tsdbFreeBufPool(pRepo->pPool);
     tsdbFreeMeta(pRepo->tsdbMeta);
     tsdbFreeMergeBuf(pRepo->mergeBuf);
+    tsdbFreeIdxCache(pRepo->idxCache);
     // tsdbFreeMemTable(pRepo->mem);
     // tsdbFreeMemTable(pRepo->imem);
     tsem_destroy(&(pRepo->readyToCommit));
@@ -809,13 +819,22 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
   SFSIter    fsiter;
   SReadH     readh;
   SDFileSet *pSet;
+  SLastStore store;
   STsdbMeta *pMeta = pRepo->tsdbMeta;
   STsdbCfg * pCfg = REPO_CFG(pRepo);
+  bool       hasStore = false;
+  int        numOfStored = 0;
+  int        numOfScanned = 0;
 
   if (tsdbInitReadH(&readh, pRepo) < 0) {
     return -1;
   }
 
+  if (CACHE_LAST_ROW(pCfg) || CACHE_LAST_NULL_COLUMN(pCfg)) {
+    hasStore = (tsdbOpenLastStore(pRepo, &store, true) == 0);
+  }
+  pRepo->lastStoreValid = hasStore;
+
   tsdbFSIterInit(&fsiter, REPO_FS(pRepo), TSDB_FS_ITER_BACKWARD);
 
   if (CACHE_LAST_NULL_COLUMN(pCfg)) {
@@ -829,13 +848,11 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
 
   while ((pSet = tsdbFSIterNext(&fsiter)) != NULL) {
     if (tsdbSetAndOpenReadFSet(&readh, pSet) < 0) {
-      tsdbDestroyReadH(&readh);
-      return -1;
+      goto _err;
     }
 
     if (tsdbLoadBlockIdx(&readh) < 0) {
-      tsdbDestroyReadH(&readh);
-      return -1;
+      goto _err;
     }
 
     for (int i = 1; i < pMeta->maxTables; i++) {
@@ -845,8 +862,7 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
       //tsdbInfo("tsdbRestoreInfo restore vgId:%d,table:%s", REPO_ID(pRepo), pTable->name->data);
 
       if (tsdbSetReadTable(&readh, pTable) < 0) {
-        tsdbDestroyReadH(&readh);
-        return -1;
+        goto _err;
       }
 
       TSKEY      lastKey = tsdbGetTableLastKeyImpl(pTable);
@@ -854,29 +870,43 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
       if (pIdx && lastKey < pIdx->maxKey) {
         pTable->lastKey = pIdx->maxKey;
 
-        if (CACHE_LAST_ROW(pCfg) && tsdbRestoreLastRow(pRepo, pTable, &readh, pIdx) != 0) {
-          tsdbDestroyReadH(&readh);
-          return -1;
+        // take the last values from the store if it matches the files, or read them back from the last blocks
+        if (hasStore && tsdbRestoreFromLastStore(pRepo, &store, pTable, pIdx->maxKey)) {
+          numOfStored++;
+        } else {
+          numOfScanned++;
+          if (CACHE_LAST_ROW(pCfg) && tsdbRestoreLastRow(pRepo, pTable, &readh, pIdx) != 0) {
+            goto _err;
+          }
         }
       }
       
       // restore NULL columns
       if (pIdx && CACHE_LAST_NULL_COLUMN(pCfg) && !pTable->hasRestoreLastColumn) {
         if (tsdbRestoreLastColumns(pRepo, pTable, &readh) != 0) {
-          tsdbDestroyReadH(&readh);
-          return -1;
+          goto _err;
         }
       }
     }
   }
 
   tsdbDestroyReadH(&readh);
+  if (hasStore) {
+    tsdbCloseLastStore(&store);
+    tsdbInfo("vgId:%d last values of %d tables are restored from last store, %d tables from files", REPO_ID(pRepo),
+             numOfStored, numOfScanned);
+  }
 
   if (CACHE_LAST_NULL_COLUMN(pCfg)) {
     atomic_store_8(&pRepo->hasCachedLastColumn, 1);
   }
 
   return 0;
+
+_err:
+  tsdbDestroyReadH(&readh);
+  if (hasStore) tsdbCloseLastStore(&store);
+  return -1;
 }
 
 int tsdbCacheLastData(STsdbRepo *pRepo, STsdbCfg* oldCfg) {
@@ -899,6 +929,9 @@ int tsdbCacheLastData(STsdbRepo *pRepo, STsdbCfg* oldCfg) {
     cacheLastCol = !CACHE_LAST_NULL_COLUMN(oldCfg) && CACHE_LAST_NULL_COLUMN(&(pRepo->config));
   }
 
+  // the entries of the last store are of the old option, the next commit encodes all the tables
+  pRepo->lastStoreValid = false;
+
   // calc max table idx and table num
   for (int i = 1; i < pMeta->maxTables; i++) {
     STable *pTable = pMeta->tables[i];
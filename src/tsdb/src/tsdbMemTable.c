@@ -22,6 +22,8 @@
 #define TSDB_DATA_SKIPLIST_LEVEL 5
 #define TSDB_MAX_INSERT_BATCH 512
 
+extern int32_t tsMemPoolBudget;
+
 typedef struct {
   int32_t  totalLen;
   int32_t  len;
@@ -49,6 +51,9 @@ static int          tsdbInitSubmitMsgIter(SSubmitMsg *pMsg, SSubmitMsgIter *pIte
 static int          tsdbGetSubmitMsgNext(SSubmitMsgIter *pIter, SSubmitBlk **pPBlock);
 static int          tsdbCheckTableSchema(STsdbRepo *pRepo, SSubmitBlk *pBlock, STable *pTable);
 static int          tsdbUpdateTableLatestInfo(STsdbRepo *pRepo, STable *pTable, SMemRow row);
+static int          tsdbAppendRowToChunk(STsdbRepo *pRepo, STableData *pTableData, SMemRow row);
+static SMemRow *    tsdbGetChunkRowByKey(STableData *pTableData, TSKEY key);
+static int          tsdbPutRowToTableData(STsdbRepo *pRepo, STableData *pTableData, SMemRow row, int64_t *pNewRows);
 
 static FORCE_INLINE int tsdbCheckRowRange(STsdbRepo *pRepo, STable *pTable, SMemRow row, TSKEY minKey, TSKEY maxKey,
                                           TSKEY now);
@@ -105,6 +110,10 @@ int tsdbUnRefMemTable(STsdbRepo *pRepo, SMemTable *pMemTable) {
       if (pBufPool->nRecycleBlocks > 0) {
         tsdbRecycleBufferBlock(pBufPool, pNode);
         pBufPool->nRecycleBlocks -= 1;
+      } else if (pBufPool->nExtraBlocks > 0) {
+        tsdbRecycleBufferBlock(pBufPool, pNode);
+        pBufPool->nExtraBlocks -= 1;
+        pBufPool->nShrinks++;
       } else {
         tdListAppendNode(pBufPool->bufBlockList, pNode);
       }      
@@ -210,6 +219,33 @@ void tsdbUnTakeMemSnapShot(STsdbRepo *pRepo, SMemSnapshot *pSnapshot) {
   pSnapshot->omem = NULL;
 }
 
+// The bytes out of the buffer pool are freed with the memtable, and make it committed after the current write
+static void *tsdbAllocBytesFromSystem(STsdbRepo *pRepo, int bytes) {
+  if (pRepo->mem->extraBuffList == NULL) {
+    pRepo->mem->extraBuffList = tdListNew(0);
+    if (pRepo->mem->extraBuffList == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return NULL;
+    }
+  }
+
+  ASSERT(pRepo->mem->extraBuffList != NULL);
+  SListNode *pNode = (SListNode *)malloc(sizeof(SListNode) + bytes);
+  if (pNode == NULL) {
+    if (listNEles(pRepo->mem->extraBuffList) == 0) {
+      tdListFree(pRepo->mem->extraBuffList);
+      pRepo->mem->extraBuffList = NULL;
+    }
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pNode->next = pNode->prev = NULL;
+  tdListAppendNode(pRepo->mem->extraBuffList, pNode);
+  tsdbTrace("vgId:%d allocate %d bytes from SYSTEM buffer block", REPO_ID(pRepo), bytes);
+  return (void *)(pNode->data);
+}
+
 void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
   STsdbCfg *     pCfg = &pRepo->config;
   STsdbBufBlock *pBufBlock = NULL;
@@ -226,36 +262,28 @@ void *tsdbAllocBytes(STsdbRepo *pRepo, int bytes) {
 
   pBufBlock = tsdbGetCurrBufBlock(pRepo);
   if ((pRepo->mem->extraBuffList != NULL) ||
-      ((listNEles(pRepo->mem->bufBlockList) >= pCfg->totalBlocks / 3) && (pBufBlock->remain < bytes))) {
+      ((tsMemPoolBudget <= 0) && (listNEles(pRepo->mem->bufBlockList) >= pCfg->totalBlocks / 3) &&
+       (pBufBlock->remain < bytes))) {
     // allocate from SYSTEM buffer pool
-    if (pRepo->mem->extraBuffList == NULL) {
-      pRepo->mem->extraBuffList = tdListNew(0);
-      if (pRepo->mem->extraBuffList == NULL) {
-        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    ptr = tsdbAllocBytesFromSystem(pRepo, bytes);
+  } else {  // allocate from TSDB buffer pool
+    if (pBufBlock == NULL || pBufBlock->remain < bytes) {
+      ASSERT(tsMemPoolBudget > 0 || listNEles(pRepo->mem->bufBlockList) < pCfg->totalBlocks / 3);
+      if (tsdbLockRepo(pRepo) < 0) return NULL;
+      SListNode *pNode = NULL;
+      if (listNEles(pRepo->mem->bufBlockList) < pCfg->totalBlocks / 3) {
+        pNode = tsdbAllocBufBlockFromPool(pRepo);
+      } else if (tsdbGrowBufPool(pRepo, &pNode) < 0) {
+        tsdbUnlockRepo(pRepo);
         return NULL;
       }
-    }
 
-    ASSERT(pRepo->mem->extraBuffList != NULL);
-    SListNode *pNode = (SListNode *)malloc(sizeof(SListNode) + bytes);
-    if (pNode == NULL) {
-      if (listNEles(pRepo->mem->extraBuffList) == 0) {
-        tdListFree(pRepo->mem->extraBuffList);
-        pRepo->mem->extraBuffList = NULL;
+      // the pools of the dnode are over budget and no commit returns blocks
+      if (pNode == NULL) {
+        if (tsdbUnlockRepo(pRepo) < 0) return NULL;
+        return tsdbAllocBytesFromSystem(pRepo, bytes);
       }
-      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-      return NULL;
-    }
 
-    pNode->next = pNode->prev = NULL;
-    tdListAppendNode(pRepo->mem->extraBuffList, pNode);
-    ptr = (void *)(pNode->data);
-    tsdbTrace("vgId:%d allocate %d bytes from SYSTEM buffer block", REPO_ID(pRepo), bytes);
-  } else {  // allocate from TSDB buffer pool
-    if (pBufBlock == NULL || pBufBlock->remain < bytes) {
-      ASSERT(listNEles(pRepo->mem->bufBlockList) < pCfg->totalBlocks / 3);
-      if (tsdbLockRepo(pRepo) < 0) return NULL;
-      SListNode *pNode = tsdbAllocBufBlockFromPool(pRepo);
       tdListAppendNode(pRepo->mem->bufBlockList, pNode);
       if (tsdbUnlockRepo(pRepo) < 0) return NULL;
       pBufBlock = tsdbGetCurrBufBlock(pRepo);
@@ -346,7 +374,7 @@ int tsdbSyncCommit(STsdbRepo *repo) {
  * 
  * The function tries to procceed AS MUCH AS POSSIBLE.
  */
-int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey, int maxRowsToRead, SDataCols *pCols,
+int tsdbLoadDataFromCache(STable *pTable, STableDataIter *pIter, TSKEY maxKey, int maxRowsToRead, SDataCols *pCols,
                           TKEY *filterKeys, int nFilterKeys, bool keepDup, SMergeInfo *pMergeInfo) {
   ASSERT(maxRowsToRead > 0 && nFilterKeys >= 0);
   if (pIter == NULL) return 0;
@@ -406,7 +434,7 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
         tsdbAppendTableRowToCols(pTable, pCols, &pSchema, row);
       }
 
-      tSkipListIterNext(pIter);
+      tsdbTableDataIterNext(pIter);
       row = tsdbNextIterRow(pIter);
       if (row == NULL || memRowKey(row) > maxKey) {
         rowKey = INT64_MAX;
@@ -436,7 +464,7 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
         }
       }
 
-      tSkipListIterNext(pIter);
+      tsdbTableDataIterNext(pIter);
       row = tsdbNextIterRow(pIter);
       if (row == NULL || memRowKey(row) > maxKey) {
         rowKey = INT64_MAX;
@@ -458,6 +486,142 @@ int tsdbLoadDataFromCache(STable *pTable, SSkipListIterator *pIter, TSKEY maxKey
   return 0;
 }
 
+STableDataIter *tsdbCreateTableDataIter(STableData *pTableData) {
+  STableDataIter *pIter = (STableDataIter *)calloc(1, sizeof(*pIter));
+  if (pIter == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  SSkipListIterator *pSlIter = tSkipListCreateIter(pTableData->pData);
+  if (pSlIter == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    free(pIter);
+    return NULL;
+  }
+
+  pIter->start = false;
+  pIter->order = TSDB_ORDER_ASC;
+  pIter->slIter = *pSlIter;
+  pIter->pChunk = atomic_load_ptr(&(pTableData->pHead));
+  pIter->idx = 0;
+  tSkipListDestroyIter(pSlIter);
+
+  return pIter;
+}
+
+STableDataIter *tsdbCreateTableDataIterFromKey(STableData *pTableData, TKEY tkey, int32_t order) {
+  ASSERT(order == TSDB_ORDER_ASC || order == TSDB_ORDER_DESC);
+
+  STableDataIter *pIter = (STableDataIter *)calloc(1, sizeof(*pIter));
+  if (pIter == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  SSkipListIterator *pSlIter =
+      tSkipListCreateIterFromVal(pTableData->pData, (const char *)&tkey, TSDB_DATA_TYPE_TIMESTAMP, order);
+  if (pSlIter == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    free(pIter);
+    return NULL;
+  }
+
+  pIter->start = false;
+  pIter->order = order;
+  pIter->slIter = *pSlIter;
+  tSkipListDestroyIter(pSlIter);
+
+  // Locate the first row >= key for ASC, or the last row <= key for DESC, in the chunk list
+  TSKEY         key = tdGetKey(tkey);
+  SMemRowChunk *pChunk = atomic_load_ptr(&(pTableData->pHead));
+  int32_t       nrows = 0;
+
+  if (order == TSDB_ORDER_ASC) {
+    while (pChunk) {
+      nrows = atomic_load_32(&(pChunk->nrows));
+      if (nrows > 0 && memRowKey(pChunk->rows[nrows - 1]) >= key) break;
+      if (atomic_load_ptr(&(pChunk->next)) == NULL) break;
+      pChunk = pChunk->next;
+    }
+
+    int32_t lo = 0, hi = nrows;
+    while (pChunk && lo < hi) {
+      int32_t mid = lo + ((hi - lo) >> 1);
+      if (memRowKey(pChunk->rows[mid]) < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    pIter->pChunk = pChunk;
+    pIter->idx = lo;
+  } else {
+    SMemRowChunk *pFound = NULL;
+    while (pChunk) {
+      nrows = atomic_load_32(&(pChunk->nrows));
+      if (nrows == 0 || memRowKey(pChunk->rows[0]) > key) break;
+      pFound = pChunk;
+      pChunk = atomic_load_ptr(&(pChunk->next));
+    }
+
+    pIter->pChunk = pFound;
+    pIter->idx = -1;
+    if (pFound) {
+      int32_t lo = 0, hi = atomic_load_32(&(pFound->nrows));
+      while (lo < hi) {
+        int32_t mid = lo + ((hi - lo) >> 1);
+        if (memRowKey(pFound->rows[mid]) <= key) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      pIter->idx = lo - 1;
+    }
+  }
+
+  return pIter;
+}
+
+bool tsdbTableDataIterNext(STableDataIter *pIter) {
+  if (pIter == NULL) return false;
+
+  if (!pIter->start) {
+    pIter->start = true;
+    if (pIter->slIter.pSkipList) tSkipListIterNext(&(pIter->slIter));
+    return tsdbTableDataIterGet(pIter) != NULL;
+  }
+
+  SMemRow row = NULL;
+  if (tsdbTableDataIterInChunk(pIter, &row)) {
+    if (pIter->order == TSDB_ORDER_ASC) {
+      pIter->idx++;
+      if (pIter->idx >= pIter->pChunk->capacity && atomic_load_ptr(&(pIter->pChunk->next)) != NULL) {
+        pIter->pChunk = pIter->pChunk->next;
+        pIter->idx = 0;
+      }
+    } else {
+      pIter->idx--;
+      if (pIter->idx < 0 && pIter->pChunk->prev != NULL) {
+        pIter->pChunk = pIter->pChunk->prev;
+        pIter->idx = pIter->pChunk->nrows - 1;
+      }
+    }
+  } else if (row != NULL) {
+    tSkipListIterNext(&(pIter->slIter));
+  } else {
+    return false;
+  }
+
+  return tsdbTableDataIterGet(pIter) != NULL;
+}
+
+void *tsdbDestroyTableDataIter(STableDataIter *pIter) {
+  tfree(pIter);
+  return NULL;
+}
+
 // ---------------- LOCAL FUNCTIONS ----------------
 static SMemTable* tsdbNewMemTable(STsdbRepo *pRepo) {
   STsdbMeta *pMeta = pRepo->tsdbMeta;
@@ -523,6 +687,7 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
   pTableData->uid = TABLE_UID(pTable);
   pTableData->keyFirst = INT64_MAX;
   pTableData->keyLast = 0;
+  pTableData->keyBase = tsdbGetTableLastKeyImpl(pTable);
   pTableData->numOfRows = 0;
 
   uint8_t skipListCreateFlags;
@@ -704,7 +869,7 @@ static int tsdbScanAndConvertSubmitMsg(STsdbRepo *pRepo, SSubmitMsg *pMsg) {
 //row1 has higher priority
 static SMemRow tsdbInsertDupKeyMerge(SMemRow row1, SMemRow row2, STsdbRepo* pRepo,
                                      STSchema **ppSchema1, STSchema **ppSchema2,
-                                     STable* pTable, int32_t* pPoints, SMemRow* pLastRow) {
+                                     STable* pTable, int32_t* pPoints, SMemRow* pLastRow, int32_t* pCode) {
   
   //for compatiblity, duplicate key inserted when update=0 should be also calculated as affected rows!
   if(row1 == NULL && row2 == NULL && pRepo->config.update == TD_ROW_DISCARD_UPDATE) {
@@ -714,7 +879,10 @@ static SMemRow tsdbInsertDupKeyMerge(SMemRow row1, SMemRow row2, STsdbRepo* pRep
 
   if(row2 == NULL || pRepo->config.update != TD_ROW_PARTIAL_UPDATE) {
     void* pMem = tsdbAllocBytes(pRepo, memRowTLen(row1));
-    if(pMem == NULL) return NULL;
+    if(pMem == NULL) {
+      *pCode = terrno;
+      return NULL;
+    }
     memRowCpy(pMem, row1);
     (*pPoints)++;
     *pLastRow = pMem;
@@ -747,7 +915,10 @@ static SMemRow tsdbInsertDupKeyMerge(SMemRow row1, SMemRow row2, STsdbRepo* pRep
   SMemRow tmp = tsdbMergeTwoRows(pBuf, row1, row2, pSchema1, pSchema2);
 
   void* pMem = tsdbAllocBytes(pRepo, memRowTLen(tmp));
-  if(pMem == NULL) return NULL;
+  if(pMem == NULL) {
+    *pCode = terrno;
+    return NULL;
+  }
   memRowCpy(pMem, tmp);
 
   (*pPoints)++;
@@ -756,10 +927,11 @@ static SMemRow tsdbInsertDupKeyMerge(SMemRow row1, SMemRow row2, STsdbRepo* pRep
 }
 
 static void* tsdbInsertDupKeyMergePacked(void** args) {
-  return tsdbInsertDupKeyMerge(args[0], args[1], args[2], (STSchema**)&args[3], (STSchema**)&args[4], args[5], args[6], args[7]);
+  return tsdbInsertDupKeyMerge(args[0], args[1], args[2], (STSchema**)&args[3], (STSchema**)&args[4], args[5], args[6], args[7], args[8]);
 }
 
-static void tsdbSetupSkipListHookFns(SSkipList* pSkipList, STsdbRepo *pRepo, STable *pTable, int32_t* pPoints, SMemRow* pLastRow) {
+static void tsdbSetupSkipListHookFns(SSkipList* pSkipList, STsdbRepo *pRepo, STable *pTable, int32_t* pPoints, SMemRow* pLastRow,
+                                     int32_t* pCode) {
 
   if(pSkipList->insertHandleFn == NULL) {
     tGenericSavedFunc *dupHandleSavedFunc = genericSavedFuncInit((GenericVaFunc)&tsdbInsertDupKeyMergePacked, 9);
@@ -771,6 +943,136 @@ static void tsdbSetupSkipListHookFns(SSkipList* pSkipList, STsdbRepo *pRepo, STa
   }
   pSkipList->insertHandleFn->args[6] = pPoints;
   pSkipList->insertHandleFn->args[7] = pLastRow;
+  pSkipList->insertHandleFn->args[8] = pCode;
+}
+
+static SMemRow tsdbChunkLastRow(STableData *pTableData) {
+  SMemRowChunk *pTail = pTableData->pTail;
+  if (pTail == NULL || pTail->nrows == 0) return NULL;
+  return pTail->rows[pTail->nrows - 1];
+}
+
+// The chunks are allocated from the buffer pool as the rows are, and released with the mem table
+static int tsdbAppendRowToChunk(STsdbRepo *pRepo, STableData *pTableData, SMemRow row) {
+  SMemRowChunk *pTail = pTableData->pTail;
+
+  if (pTail == NULL || pTail->nrows >= pTail->capacity) {
+    int32_t capacity = TSDB_MEM_ROW_CHUNK_MIN_ROWS;
+    if (pTail != NULL) capacity = MIN(pTail->capacity * 2, TSDB_MEM_ROW_CHUNK_MAX_ROWS);
+
+    // the rows before it in the buffer block have any length, the chunk is aligned for the atomic access
+    void *pMem = tsdbAllocBytes(pRepo, sizeof(SMemRowChunk) + sizeof(SMemRow) * capacity + sizeof(int64_t) - 1);
+    if (pMem == NULL) return -1;
+
+    SMemRowChunk *pChunk = (SMemRowChunk *)ALIGN8((uintptr_t)pMem);
+    pChunk->prev = pTail;
+    pChunk->next = NULL;
+    pChunk->nrows = 0;
+    pChunk->capacity = capacity;
+    if (pTail == NULL) {
+      atomic_store_ptr(&(pTableData->pHead), pChunk);
+    } else {
+      atomic_store_ptr(&(pTail->next), pChunk);
+    }
+    pTableData->pTail = pChunk;
+    pTail = pChunk;
+  }
+
+  // publish the row before the row count, so a reader never sees an unset slot
+  pTail->rows[pTail->nrows] = row;
+  atomic_store_32(&(pTail->nrows), pTail->nrows + 1);
+  pTableData->numOfAppendRows++;
+
+  return 0;
+}
+
+// Return the slot of the row with the key in the chunk list, or NULL if not found
+static SMemRow *tsdbGetChunkRowByKey(STableData *pTableData, TSKEY key) {
+  SMemRowChunk *pChunk = pTableData->pTail;
+
+  while (pChunk && pChunk->nrows > 0 && memRowKey(pChunk->rows[0]) > key) {
+    pChunk = pChunk->prev;
+  }
+  if (pChunk == NULL || pChunk->nrows == 0) return NULL;
+
+  int32_t lo = 0, hi = pChunk->nrows - 1;
+  while (lo <= hi) {
+    int32_t mid = lo + ((hi - lo) >> 1);
+    TSKEY   mkey = memRowKey(pChunk->rows[mid]);
+    if (mkey == key) {
+      return pChunk->rows + mid;
+    } else if (mkey < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return NULL;
+}
+
+// Put a row of submit block into the table data. Rows with key larger than any existing key are appended to the
+// chunk list, the rest go to the skiplist unless the key already exists in the chunk list, in which case the
+// duplicate is handled in place as the skiplist does. Return -1 if the row can not be allocated in the mem table.
+static int tsdbPutRowToTableData(STsdbRepo *pRepo, STableData *pTableData, SMemRow row, int64_t *pNewRows) {
+  SSkipList *        pSkipList = pTableData->pData;
+  tGenericSavedFunc *pDupHandle = pSkipList->insertHandleFn;
+  int32_t *          pCode = pDupHandle->args[8];
+  TSKEY              key = memRowKey(row);
+  SMemRow            lastRow = tsdbChunkLastRow(pTableData);
+  SMemRow            pData = NULL;
+
+  if ((lastRow == NULL || memRowKey(lastRow) < key) &&
+      (SL_SIZE(pSkipList) == 0 ||
+       memRowKey((SMemRow)SL_GET_NODE_DATA(SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, 0))) < key)) {
+    pDupHandle->args[0] = row;
+    pDupHandle->args[1] = NULL;
+    pData = genericInvoke(pDupHandle);
+    if (pData == NULL) {
+      terrno = *pCode;
+      return -1;
+    }
+    if (tsdbAppendRowToChunk(pRepo, pTableData, pData) < 0) return -1;
+
+    (*pNewRows)++;
+    return 0;
+  }
+
+  SMemRow *pSlot = (lastRow != NULL && memRowKey(lastRow) >= key) ? tsdbGetChunkRowByKey(pTableData, key) : NULL;
+  if (pSlot == NULL) {
+    uint32_t       osize = SL_SIZE(pSkipList);
+    SSkipListNode *pNode = tSkipListPut(pSkipList, row);
+    if (*pCode != TSDB_CODE_SUCCESS) {
+      terrno = *pCode;
+      return -1;
+    }
+
+    // a duplicated key is not put when update=0
+    if (pNode == NULL && SL_DUP_MODE(pSkipList) != SL_DISCARD_DUP_KEY) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+    (*pNewRows) += (SL_SIZE(pSkipList) - osize);
+    return 0;
+  }
+
+  if (SL_DUP_MODE(pSkipList) == SL_UPDATE_DUP_KEY) {
+    pDupHandle->args[0] = row;
+    pDupHandle->args[1] = *pSlot;
+    pData = genericInvoke(pDupHandle);
+    if (pData == NULL) {
+      terrno = *pCode;
+      return -1;
+    }
+    atomic_store_ptr(pSlot, pData);
+  } else {
+    // for compatiblity, duplicate key inserted when update=0 should be also calculated as affected rows!
+    pDupHandle->args[0] = NULL;
+    pDupHandle->args[1] = NULL;
+    genericInvoke(pDupHandle);
+  }
+
+  return 0;
 }
 
 static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *pAffectedRows) {
@@ -826,12 +1128,41 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
   ASSERT((pTableData != NULL) && pTableData->uid == TABLE_UID(pTable));
 
   SMemRow lastRow = NULL;
-  int64_t osize = SL_SIZE(pTableData->pData);
-  tsdbSetupSkipListHookFns(pTableData->pData, pRepo, pTable, &points, &lastRow);
-  tSkipListPutBatchByIter(pTableData->pData, &blkIter, (iter_next_fn_t)tsdbGetSubmitBlkNext);
-  int64_t dsize = SL_SIZE(pTableData->pData) - osize;
+  int64_t dsize = 0;
+  SMemRow row = NULL;
+  int32_t code = TSDB_CODE_SUCCESS;
+  SArray *pCqRows = NULL;
+  if (pRepo->appH.cqWatchTableFunc != NULL && (*pRepo->appH.cqWatchTableFunc)(pRepo->appH.cqH, TABLE_UID(pTable))) {
+    pCqRows = taosArrayInit(pBlock->numOfRows, POINTER_BYTES);
+    if (pCqRows == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  tsdbSetupSkipListHookFns(pTableData->pData, pRepo, pTable, &points, &lastRow, &code);
+  while ((row = tsdbGetSubmitBlkNext(&blkIter)) != NULL) {
+    int64_t osize = dsize;
+    if (tsdbPutRowToTableData(pRepo, pTableData, row, &dsize) < 0) {
+      // the rows put before stay in the mem table and are accounted below
+      code = terrno;
+      tsdbError("vgId:%d failed to insert row to table %s uid %" PRId64 " since %s", REPO_ID(pRepo),
+                TABLE_CHAR_NAME(pTable), TABLE_UID(pTable), tstrerror(code));
+      break;
+    }
+
+    // only the rows really added to the mem table are fed to the incremental CQs, duplicated keys are discarded
+    if (pCqRows != NULL && dsize > osize) taosArrayPush(pCqRows, &row);
+  }
   (*pAffectedRows) += points;
 
+  // the rows are folded after the insertion, not to block the write path on the CQ lock
+  if (pCqRows != NULL) {
+    (*pRepo->appH.cqAppendRowsFunc)(pRepo->appH.cqH, TABLE_UID(pTable), pCfg->update, pTableData->keyBase,
+                                    TARRAY_GET_START(pCqRows), (int32_t)taosArrayGetSize(pCqRows));
+    taosArrayDestroy(pCqRows);
+  }
+
 
   if(lastRow != NULL) {
     TSKEY lastRowKey = memRowKey(lastRow);
@@ -851,6 +1182,11 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
   pRepo->stat.pointsWritten += points * schemaNCols(pSchema);
   pRepo->stat.totalStorage += points * schemaVLen(pSchema);
 
+  if (code != TSDB_CODE_SUCCESS) {
+    terrno = code;
+    return -1;
+  }
+
   return 0;
 }
 
@@ -980,6 +1316,8 @@ static void updateTableLatestColumn(STsdbRepo *pRepo, STable *pTable, SMemRow ro
   SDataCol *pLatestCols = pTable->lastCols;
   int32_t kvIdx = 0;
 
+  // readers of the cached columns, e.g. the last store snapshot, hold the table latch
+  TSDB_WLOCK_TABLE(pTable);
   for (int16_t j = 0; j < schemaNCols(pSchema); j++) {
     STColumn *pTCol = schemaColAt(pSchema, j);
     // ignore not exist colId
@@ -1013,6 +1351,7 @@ static void updateTableLatestColumn(STsdbRepo *pRepo, STable *pTable, SMemRow ro
     //tsdbInfo("updateTableLatestColumn vgId:%d cache column %d for %d,%s", REPO_ID(pRepo), j, pDataCol->bytes, (char*)pDataCol->pData);
     pDataCol->ts = memRowKey(row);
   }
+  TSDB_WUNLOCK_TABLE(pTable);
 }
 
 static int tsdbUpdateTableLatestInfo(STsdbRepo *pRepo, STable *pTable, SMemRow row) {
@@ -116,6 +116,10 @@ int tsdbCreateTable(STsdbRepo *repo, STableCfg *pCfg) {
 
   // Register to meta
   tsdbWLockRepoMeta(pRepo);
+  if (superChanged && tsdbTagIndexSetSchema(super->pTagIndex, super->tagSchema) < 0) {
+    tsdbWarn("vgId:%d failed to update tag index of super table %s since %s, the new tags are not indexed",
+             REPO_ID(pRepo), TABLE_CHAR_NAME(super), tstrerror(terrno));
+  }
   if (newSuper) {
     if (tsdbAddTableToMeta(pRepo, super, true, false) < 0) {
       tsdbUnlockRepoMeta(pRepo);
@@ -392,17 +396,26 @@ int tsdbUpdateTableTagValue(STsdbRepo *repo, SUpdateTableTagValMsg *pMsg) {
   // STColumn *pCol = bsearch(&(pMsg->colId), pMsg->data, pMsg->numOfTags, sizeof(STColumn), colIdCompar);
   // ASSERT(pCol != NULL);
 
+  // all the tags are in the inverted index, only the first one is in the skiplist
+  tsdbWLockRepoMeta(pRepo);
+  if (pNewSchema != NULL && tsdbTagIndexSetSchema(pTable->pSuper->pTagIndex, pNewSchema) < 0) {
+    tsdbWarn("vgId:%d failed to update tag index of super table %s since %s, the new tags are not indexed",
+             REPO_ID(pRepo), TABLE_CHAR_NAME(pTable->pSuper), tstrerror(terrno));
+  }
   if (isChangeIndexCol) {
-    tsdbWLockRepoMeta(pRepo);
     tsdbRemoveTableFromIndex(pMeta, pTable);
+  } else {
+    tsdbTagIndexRemove(pTable->pSuper->pTagIndex, pTable);
   }
   TSDB_WLOCK_TABLE(pTable);
   tdSetKVRowDataOfCol(&(pTable->tagVal), pMsg->colId, pMsg->type, POINTER_SHIFT(pMsg->data, pMsg->schemaLen));
   TSDB_WUNLOCK_TABLE(pTable);
   if (isChangeIndexCol) {
     tsdbAddTableIntoIndex(pMeta, pTable, false);
-    tsdbUnlockRepoMeta(pRepo);
+  } else {
+    tsdbTagIndexAdd(pTable->pSuper->pTagIndex, pTable);
   }
+  tsdbUnlockRepoMeta(pRepo);
 
   // Update on file
   int tlen1 = (pNewSchema) ? tsdbGetTableEncodeSize(TSDB_UPDATE_META, pTable->pSuper) : 0;
@@ -812,6 +825,7 @@ static STable *tsdbNewTable() {
   pTable->maxColNum = 0;
   pTable->hasRestoreLastColumn = false;
   pTable->lastColSVersion = -1;
+  pTable->tagIndexId = -1;
   return pTable;
 }
 
@@ -852,6 +866,8 @@ static STable *tsdbCreateTableFromCfg(STableCfg *pCfg, bool isSuper, STable *pST
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       goto _err;
     }
+    pTable->pTagIndex = tsdbNewTagIndex(pTable->tagSchema);
+    if (pTable->pTagIndex == NULL) goto _err;
   } else {
     pTable->type = pCfg->type;
     tsize = strnlen(pCfg->name, TSDB_TABLE_NAME_LEN - 1);
@@ -920,6 +936,7 @@ static void tsdbFreeTable(STable *pTable) {
     kvRowFree(pTable->tagVal);
 
     tSkipListDestroy(pTable->pIndex);
+    tsdbFreeTagIndex(pTable->pTagIndex);
     taosTZfree(pTable->lastRow);    
     tfree(pTable->sql);
 
@@ -1052,6 +1069,7 @@ static int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper
   pTable->pSuper = pSTable;
 
   tSkipListPut(pSTable->pIndex, (void *)pTable);
+  tsdbTagIndexAdd(pSTable->pTagIndex, pTable);
 
   if (refSuper) T_REF_INC(pSTable);
   return 0;
@@ -1063,6 +1081,8 @@ static int tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable) {
   STable *pSTable = pTable->pSuper;
   ASSERT(pSTable != NULL);
 
+  tsdbTagIndexRemove(pSTable->pTagIndex, pTable);
+
   char* key = getTagIndexKey(pTable);
   SArray *res = tSkipListGet(pSTable->pIndex, key);
 
@@ -1323,6 +1343,11 @@ static void *tsdbDecodeTable(void *buf, STable **pRTable) {
         tsdbFreeTable(pTable);
         return NULL;
       }
+      pTable->pTagIndex = tsdbNewTagIndex(pTable->tagSchema);
+      if (pTable->pTagIndex == NULL) {
+        tsdbFreeTable(pTable);
+        return NULL;
+      }
     }
 
     if (TABLE_TYPE(pTable) == TSDB_STREAM_TABLE) {
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+#define TSDB_META_SNAP_ALIGN(l) (((l) + 7) & (~((int64_t)7)))
+#define TSDB_META_SNAP_BUF_SIZE (4 * 1024 * 1024)
+
+typedef struct {
+  int     fd;
+  char *  buf;
+  int64_t len;
+  TSCKSUM cksum;
+} SMetaSnapWriter;
+
+typedef struct {
+  char *  pBuf;  // mapped snapshot
+  int64_t size;
+} SMetaSnap;
+
+static void tsdbGetMetaSnapFname(int repoid, const char *bname, char fname[]);
+static int  tsdbWriteMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, const char *fname);
+static int  tsdbComparMetaRecord(const void *arg1, const void *arg2);
+static int  tsdbAppendMetaSnap(SMetaSnapWriter *pw, const void *data, int64_t len);
+static int  tsdbFlushMetaSnap(SMetaSnapWriter *pw);
+static int  tsdbOpenMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, SMetaSnap *pSnap);
+static void tsdbCloseMetaSnap(SMetaSnap *pSnap);
+static int  tsdbReadMetaTail(STsdbRepo *pRepo, SMFile *pMFile, SMetaSnapHead *pHead, char **ppTail, int64_t *pLen);
+static int  tsdbLoadMetaSnapCache(STsdbRepo *pRepo, SMetaSnap *pSnap, char *pTail, int64_t tailLen);
+static int  tsdbRestoreMetaSnap(STsdbRepo *pRepo, SMetaSnap *pSnap, char *pTail, int64_t tailLen);
+
+// Write a new snapshot of the META file if there is none or the records appended after it are too many. Called from
+// the commit thread after the FS transaction is over, the meta cache then matches the current META file. Failure
+// only costs reading the META file at next open.
+void tsdbSaveMetaSnap(STsdbRepo *pRepo) {
+  STsdbFS *pfs = REPO_FS(pRepo);
+  char     tfname[TSDB_FILENAME_LEN] = "\0";
+  char     fname[TSDB_FILENAME_LEN] = "\0";
+
+  if (pfs->cstatus->pmf == NULL) return;
+
+  SMFile  mf = pfs->cstatus->mf;
+  int64_t tailSize = mf.info.size - pRepo->metaSnapSize;
+  if (pRepo->metaSnapSize > 0 && tailSize >= 0 && tailSize * TSDB_META_SNAP_TAIL_RATIO <= pRepo->metaSnapSize) {
+    return;
+  }
+
+  tsdbGetMetaSnapFname(REPO_ID(pRepo), TSDB_META_SNAP_TEMP_FNAME, tfname);
+  tsdbGetMetaSnapFname(REPO_ID(pRepo), TSDB_META_SNAP_FNAME, fname);
+
+  int64_t st = taosGetTimestampMs();
+  if (tsdbWriteMetaSnap(pRepo, &mf, tfname) < 0) {
+    tsdbWarn("vgId:%d failed to write META snapshot %s since %s", REPO_ID(pRepo), tfname, tstrerror(terrno));
+    remove(tfname);
+    return;
+  }
+
+  if (taosRename(tfname, fname) < 0) {
+    tsdbWarn("vgId:%d failed to rename file %s to %s since %s", REPO_ID(pRepo), tfname, fname, strerror(errno));
+    remove(tfname);
+    return;
+  }
+
+  pRepo->metaSnapSize = mf.info.size;
+  tsdbInfo("vgId:%d META snapshot of %d tables is saved, META file size %" PRId64 ", %" PRId64 " ms", REPO_ID(pRepo),
+           taosHashGetSize(pfs->metaCache), mf.info.size, taosGetTimestampMs() - st);
+}
+
+// Fill the meta cache, and restore the tables if recoverMeta is set, from the snapshot and the records of the META
+// file after it. pLoaded is left false if there is no snapshot that matches the file, the caller then reads the whole
+// file and nothing is changed but the file offset.
+int tsdbLoadMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, bool recoverMeta, bool *pLoaded) {
+  STsdbFS * pfs = REPO_FS(pRepo);
+  SMetaSnap snap;
+  char *    pTail = NULL;
+  int64_t   tailLen = 0;
+
+  *pLoaded = false;
+  pRepo->metaSnapSize = 0;
+
+  if (tsdbOpenMetaSnap(pRepo, pMFile, &snap) < 0) return 0;
+
+  SMetaSnapHead *pHead = (SMetaSnapHead *)snap.pBuf;
+  if (tsdbReadMetaTail(pRepo, pMFile, pHead, &pTail, &tailLen) < 0 ||
+      tsdbLoadMetaSnapCache(pRepo, &snap, pTail, tailLen) < 0) {
+    taosHashClear(pfs->metaCache);
+    tfree(pTail);
+    tsdbCloseMetaSnap(&snap);
+    return 0;
+  }
+
+  if (recoverMeta && tsdbRestoreMetaSnap(pRepo, &snap, pTail, tailLen) < 0) {
+    tfree(pTail);
+    tsdbCloseMetaSnap(&snap);
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d META is loaded from snapshot of %d tables and %" PRId64 " bytes of records after it",
+           REPO_ID(pRepo), pHead->numOfTables, tailLen);
+
+  pRepo->metaSnapSize = pHead->mfSize;
+  *pLoaded = true;
+  tfree(pTail);
+  tsdbCloseMetaSnap(&snap);
+  return 0;
+}
+
+static void tsdbGetMetaSnapFname(int repoid, const char *bname, char fname[]) {
+  snprintf(fname, TSDB_FILENAME_LEN, "%s/vnode/vnode%d/tsdb/%s", TFS_PRIMARY_PATH(), repoid, bname);
+}
+
+// Copy the live records of the META file in the order of their offsets, the file is read forward in large chunks
+static int tsdbWriteMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, const char *fname) {
+  STsdbFS *       pfs = REPO_FS(pRepo);
+  SMetaSnapWriter writer = {.fd = -1};
+  SMetaSnapHead   head = {0};
+  SKVRecord *     records = NULL;
+  char *          pIn = NULL;
+  int64_t         inCap = TSDB_META_SNAP_BUF_SIZE;
+  int64_t         inStart = 0, inLen = 0;
+  char            padding[8] = {0};
+  int             code = -1;
+
+  int32_t numOfTables = (int32_t)taosHashGetSize(pfs->metaCache);
+  records = malloc(sizeof(SKVRecord) * (numOfTables + 1));
+  pIn = malloc(inCap);
+  writer.buf = malloc(TSDB_META_SNAP_BUF_SIZE);
+  if (records == NULL || pIn == NULL || writer.buf == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  head.magic = TSDB_META_SNAP_MAGIC;
+  head.version = TSDB_META_SNAP_VERSION;
+  head.mfSize = pMFile->info.size;
+  head.mfMagic = pMFile->info.magic;
+  head.numOfTables = numOfTables;
+  head.size = sizeof(SMetaSnapHead) + sizeof(TSCKSUM);
+
+  int32_t    n = 0;
+  SKVRecord *pRecord = taosHashIterate(pfs->metaCache, NULL);
+  while (pRecord) {
+    ASSERT(n < numOfTables);
+    records[n++] = *pRecord;
+    head.size += TSDB_META_SNAP_ALIGN(sizeof(SMetaSnapEntry) + pRecord->size);
+    pRecord = taosHashIterate(pfs->metaCache, pRecord);
+  }
+  qsort(records, n, sizeof(SKVRecord), tsdbComparMetaRecord);
+
+  if (tsdbOpenMFile(pMFile, O_RDONLY) < 0) goto _exit;
+
+  writer.fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0755);
+  if (writer.fd < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _exit;
+  }
+
+  if (tsdbAppendMetaSnap(&writer, &head, sizeof(head)) < 0) goto _exit;
+
+  for (int32_t i = 0; i < n; i++) {
+    SKVRecord *pRec = records + i;
+    int64_t    contOffset = pRec->offset + sizeof(SKVRecord);
+
+    if (contOffset < inStart || contOffset + pRec->size > inStart + inLen) {
+      if (pRec->size > inCap) {
+        char *tptr = realloc(pIn, pRec->size);
+        if (tptr == NULL) {
+          terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+          goto _exit;
+        }
+        pIn = tptr;
+        inCap = pRec->size;
+      }
+
+      if (tsdbSeekMFile(pMFile, contOffset, SEEK_SET) < 0) goto _exit;
+      inStart = contOffset;
+      inLen = tsdbReadMFile(pMFile, pIn, MIN(inCap, pMFile->info.size - contOffset));
+      if (inLen < 0) goto _exit;
+      if (inLen < pRec->size) {
+        terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+        goto _exit;
+      }
+    }
+
+    SMetaSnapEntry entry = {.uid = pRec->uid, .offset = pRec->offset, .contLen = (int32_t)pRec->size};
+    entry.len = (int32_t)TSDB_META_SNAP_ALIGN(sizeof(SMetaSnapEntry) + pRec->size);
+
+    if (tsdbAppendMetaSnap(&writer, &entry, sizeof(entry)) < 0 ||
+        tsdbAppendMetaSnap(&writer, pIn + (contOffset - inStart), pRec->size) < 0 ||
+        tsdbAppendMetaSnap(&writer, padding, entry.len - sizeof(entry) - pRec->size) < 0) {
+      goto _exit;
+    }
+  }
+
+  if (tsdbFlushMetaSnap(&writer) < 0) goto _exit;
+  TSCKSUM cksum = writer.cksum;
+  if (taosWrite(writer.fd, &cksum, sizeof(cksum)) < (int64_t)sizeof(cksum) || taosFsync(writer.fd) < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _exit;
+  }
+
+  code = 0;
+
+_exit:
+  if (writer.fd >= 0) close(writer.fd);
+  tsdbCloseMFile(pMFile);
+  tfree(writer.buf);
+  tfree(pIn);
+  tfree(records);
+  return code;
+}
+
+static int tsdbComparMetaRecord(const void *arg1, const void *arg2) {
+  int64_t offset1 = ((SKVRecord *)arg1)->offset;
+  int64_t offset2 = ((SKVRecord *)arg2)->offset;
+
+  if (offset1 < offset2) {
+    return -1;
+  } else if (offset1 > offset2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static int tsdbAppendMetaSnap(SMetaSnapWriter *pw, const void *data, int64_t len) {
+  while (len > 0) {
+    if (pw->len == TSDB_META_SNAP_BUF_SIZE && tsdbFlushMetaSnap(pw) < 0) return -1;
+
+    int64_t n = MIN(len, TSDB_META_SNAP_BUF_SIZE - pw->len);
+    memcpy(pw->buf + pw->len, data, n);
+    pw->len += n;
+    data = POINTER_SHIFT(data, n);
+    len -= n;
+  }
+
+  return 0;
+}
+
+// The checksum is chained over the flushed chunks, which is the checksum of the whole snapshot before it
+static int tsdbFlushMetaSnap(SMetaSnapWriter *pw) {
+  if (pw->len == 0) return 0;
+
+  pw->cksum = taosCalcChecksum(pw->cksum, (uint8_t *)pw->buf, (uint32_t)pw->len);
+  if (taosWrite(pw->fd, pw->buf, pw->len) < pw->len) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  pw->len = 0;
+  return 0;
+}
+
+// Map the snapshot and check it is intact and not larger than the META file. Return -1 if there is no usable one.
+static int tsdbOpenMetaSnap(STsdbRepo *pRepo, SMFile *pMFile, SMetaSnap *pSnap) {
+  char        fname[TSDB_FILENAME_LEN] = "\0";
+  struct stat st;
+
+  memset(pSnap, 0, sizeof(*pSnap));
+
+  tsdbGetMetaSnapFname(REPO_ID(pRepo), TSDB_META_SNAP_FNAME, fname);
+
+  int fd = open(fname, O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    tsdbDebug("vgId:%d no META snapshot since %s", REPO_ID(pRepo), strerror(errno));
+    return -1;
+  }
+
+  if (fstat(fd, &st) < 0 || st.st_size < (int64_t)(sizeof(SMetaSnapHead) + sizeof(TSCKSUM))) {
+    tsdbWarn("vgId:%d META snapshot %s is invalid", REPO_ID(pRepo), fname);
+    close(fd);
+    return -1;
+  }
+
+  pSnap->size = st.st_size;
+#ifdef WINDOWS
+  pSnap->pBuf = malloc(pSnap->size);
+  if (pSnap->pBuf != NULL && taosRead(fd, pSnap->pBuf, pSnap->size) < pSnap->size) {
+    tfree(pSnap->pBuf);
+  }
+#else
+  pSnap->pBuf = mmap(NULL, pSnap->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (pSnap->pBuf == MAP_FAILED) pSnap->pBuf = NULL;
+#endif
+  close(fd);
+
+  if (pSnap->pBuf == NULL) {
+    tsdbWarn("vgId:%d failed to load META snapshot %s since %s", REPO_ID(pRepo), fname, strerror(errno));
+    return -1;
+  }
+
+  SMetaSnapHead *pHead = (SMetaSnapHead *)pSnap->pBuf;
+  if (pHead->magic != TSDB_META_SNAP_MAGIC || pHead->version != TSDB_META_SNAP_VERSION ||
+      pHead->size != pSnap->size || pHead->numOfTables < 0 ||
+      !taosCheckChecksumWhole((uint8_t *)pSnap->pBuf, (uint32_t)pSnap->size)) {
+    tsdbWarn("vgId:%d META snapshot %s is corrupted", REPO_ID(pRepo), fname);
+    tsdbCloseMetaSnap(pSnap);
+    return -1;
+  }
+
+  if (pHead->mfSize < TSDB_FILE_HEAD_SIZE || pHead->mfSize > pMFile->info.size) {
+    tsdbInfo("vgId:%d META snapshot is stale, it covers %" PRId64 " bytes while META file size %" PRId64,
+             REPO_ID(pRepo), pHead->mfSize, pMFile->info.size);
+    tsdbCloseMetaSnap(pSnap);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tsdbCloseMetaSnap(SMetaSnap *pSnap) {
+  if (pSnap->pBuf != NULL) {
+#ifdef WINDOWS
+    tfree(pSnap->pBuf);
+#else
+    munmap(pSnap->pBuf, pSnap->size);
+    pSnap->pBuf = NULL;
+#endif
+  }
+  pSnap->size = 0;
+}
+
+// Read the records of the META file after the snapshot, they must end at the end of the file and chain the magic of
+// the snapshot to the magic of the file
+static int tsdbReadMetaTail(STsdbRepo *pRepo, SMFile *pMFile, SMetaSnapHead *pHead, char **ppTail, int64_t *pLen) {
+  SKVRecord rInfo;
+  uint32_t  magic = pHead->mfMagic;
+  int64_t   tailLen = pMFile->info.size - pHead->mfSize;
+
+  *ppTail = NULL;
+  *pLen = 0;
+
+  if (tsdbSeekMFile(pMFile, 0, SEEK_END) != pMFile->info.size) {
+    tsdbInfo("vgId:%d META snapshot is not used since META file %s is not of size %" PRId64, REPO_ID(pRepo),
+             TSDB_FILE_FULL_NAME(pMFile), pMFile->info.size);
+    return -1;
+  }
+
+  if (tailLen > 0) {
+    *ppTail = malloc(tailLen);
+    if (*ppTail == NULL) return -1;
+
+    if (tsdbSeekMFile(pMFile, pHead->mfSize, SEEK_SET) < 0 || tsdbReadMFile(pMFile, *ppTail, tailLen) < tailLen) {
+      tfree(*ppTail);
+      return -1;
+    }
+  }
+
+  int64_t pos = 0;
+  while (pos + (int64_t)sizeof(SKVRecord) <= tailLen) {
+
+    char *ptr = *ppTail + pos;
+    tsdbDecodeKVRecord(ptr, &rInfo);
+    if (rInfo.offset < 0) {
+      magic = taosCalcChecksum(magic, (uint8_t *)ptr, sizeof(SKVRecord));
+      pos += sizeof(SKVRecord);
+    } else {
+      if (rInfo.offset != pHead->mfSize + pos || rInfo.size < (int64_t)sizeof(TSCKSUM) ||
+          pos + (int64_t)sizeof(SKVRecord) + rInfo.size > tailLen) {
+        break;
+      }
+      pos += sizeof(SKVRecord) + rInfo.size;
+      magic = taosCalcChecksum(magic, (uint8_t *)(*ppTail + pos - sizeof(TSCKSUM)), sizeof(TSCKSUM));
+    }
+  }
+
+  if (pos != tailLen || magic != pMFile->info.magic) {
+    tsdbInfo("vgId:%d META snapshot does not match META file %s", REPO_ID(pRepo), TSDB_FILE_FULL_NAME(pMFile));
+    tfree(*ppTail);
+    return -1;
+  }
+
+  *pLen = tailLen;
+  return 0;
+}
+
+static int tsdbLoadMetaSnapCache(STsdbRepo *pRepo, SMetaSnap *pSnap, char *pTail, int64_t tailLen) {
+  STsdbFS *      pfs = REPO_FS(pRepo);
+  SMetaSnapHead *pHead = (SMetaSnapHead *)pSnap->pBuf;
+  SKVRecord      rInfo;
+  int64_t        offset = sizeof(SMetaSnapHead);
+  int64_t        end = pSnap->size - sizeof(TSCKSUM);
+
+  for (int32_t i = 0; i < pHead->numOfTables; i++) {
+    SMetaSnapEntry *pEntry = (SMetaSnapEntry *)POINTER_SHIFT(pSnap->pBuf, offset);
+    if (offset + (int64_t)sizeof(SMetaSnapEntry) > end || pEntry->contLen <= 0 ||
+        pEntry->len < (int64_t)sizeof(SMetaSnapEntry) + pEntry->contLen || offset + pEntry->len > end) {
+      tsdbWarn("vgId:%d META snapshot is corrupted at offset %" PRId64, REPO_ID(pRepo), offset);
+      return -1;
+    }
+
+    rInfo.uid = pEntry->uid;
+    rInfo.offset = pEntry->offset;
+    rInfo.size = pEntry->contLen;
+    if (taosHashPut(pfs->metaCache, (void *)(&rInfo.uid), sizeof(rInfo.uid), &rInfo, sizeof(rInfo)) < 0) {
+      return -1;
+    }
+
+    offset += pEntry->len;
+  }
+
+  for (int64_t pos = 0; pos < tailLen;) {
+    tsdbDecodeKVRecord(pTail + pos, &rInfo);
+    if (rInfo.offset < 0) {
+      taosHashRemove(pfs->metaCache, (void *)(&rInfo.uid), sizeof(rInfo.uid));
+      pos += sizeof(SKVRecord);
+    } else {
+      if (taosHashPut(pfs->metaCache, (void *)(&rInfo.uid), sizeof(rInfo.uid), &rInfo, sizeof(rInfo)) < 0) {
+        return -1;
+      }
+      pos += sizeof(SKVRecord) + rInfo.size;
+    }
+  }
+
+  return 0;
+}
+
+// Restore the tables whose latest record is in the snapshot from the mapped entries, then the others from the
+// records after it
+static int tsdbRestoreMetaSnap(STsdbRepo *pRepo, SMetaSnap *pSnap, char *pTail, int64_t tailLen) {
+  STsdbFS *      pfs = REPO_FS(pRepo);
+  SMetaSnapHead *pHead = (SMetaSnapHead *)pSnap->pBuf;
+  SKVRecord      rInfo;
+  int64_t        offset = sizeof(SMetaSnapHead);
+
+  for (int32_t i = 0; i < pHead->numOfTables; i++) {
+    SMetaSnapEntry *pEntry = (SMetaSnapEntry *)POINTER_SHIFT(pSnap->pBuf, offset);
+    SKVRecord *     pRecord = taosHashGet(pfs->metaCache, (void *)(&pEntry->uid), sizeof(pEntry->uid));
+
+    if (pRecord != NULL && pRecord->offset == pEntry->offset &&
+        tsdbRestoreTable(pRepo, POINTER_SHIFT(pEntry, sizeof(SMetaSnapEntry)), pEntry->contLen) < 0) {
+      tsdbError("vgId:%d failed to restore table, uid %" PRIu64 ", since %s", REPO_ID(pRepo), pEntry->uid,
+                tstrerror(terrno));
+      return -1;
+    }
+
+    offset += pEntry->len;
+  }
+
+  for (int64_t pos = 0; pos < tailLen;) {
+    tsdbDecodeKVRecord(pTail + pos, &rInfo);
+    if (rInfo.offset < 0) {
+      pos += sizeof(SKVRecord);
+      continue;
+    }
+
+    SKVRecord *pRecord = taosHashGet(pfs->metaCache, (void *)(&rInfo.uid), sizeof(rInfo.uid));
+    if (pRecord != NULL && pRecord->offset == rInfo.offset &&
+        tsdbRestoreTable(pRepo, pTail + pos + sizeof(SKVRecord), (int)rInfo.size) < 0) {
+      tsdbError("vgId:%d failed to restore table, uid %" PRIu64 ", since %s", REPO_ID(pRepo), rInfo.uid,
+                tstrerror(terrno));
+      return -1;
+    }
+
+    pos += sizeof(SKVRecord) + rInfo.size;
+  }
+
+  tsdbOrgMeta(pRepo);
+  return 0;
+}
@@ -46,6 +46,7 @@ enum {
   TSDB_CACHED_TYPE_NONE    = 0,
   TSDB_CACHED_TYPE_LASTROW = 1,
   TSDB_CACHED_TYPE_LAST    = 2,
+  TSDB_CACHED_TYPE_LAST_MERGED = 3,  // the cached last columns of all tables are merged into one block
 };
 
 typedef struct SQueryFilePos {
@@ -87,8 +88,8 @@ typedef struct STableCheckInfo {
   int32_t       numOfBlocks:29; // number of qualified data blocks not the original blocks
   uint8_t        chosen:2;       // indicate which iterator should move forward
   bool          initBuf;        // whether to initialize the in-memory skip list iterator or not
-  SSkipListIterator* iter;      // mem buffer skip list iterator
-  SSkipListIterator* iiter;     // imem buffer skip list iterator
+  STableDataIter* iter;         // mem buffer iterator
+  STableDataIter* iiter;        // imem buffer iterator
 } STableCheckInfo;
 
 typedef struct STableBlockInfo {
@@ -137,6 +138,7 @@ typedef struct STsdbQueryHandle {
   STableBlockInfo* pDataBlockInfo;
   SDataCols     *pDataCols;        // in order to hold current file data block
   int32_t        allocSize;        // allocated data block size
+  int32_t        raSlot;           // next slot of pDataBlockInfo to read ahead, INT32_MIN if none is read ahead yet
   SMemRef       *pMemRef;
   SArray        *defaultLoadColumn;// default load column
   SDataBlockLoadInfo dataBlockLoadInfo; /* record current block load information */
@@ -333,8 +335,8 @@ static void resetCheckInfo(STsdbQueryHandle* pQueryHandle) {
   for (int32_t i = 0; i < numOfTables; ++i) {
     STableCheckInfo* pCheckInfo = (STableCheckInfo*) taosArrayGet(pQueryHandle->pTableCheckInfo, i);
     pCheckInfo->lastKey = pQueryHandle->window.skey;
-    pCheckInfo->iter    = tSkipListDestroyIter(pCheckInfo->iter);
-    pCheckInfo->iiter   = tSkipListDestroyIter(pCheckInfo->iiter);
+    pCheckInfo->iter    = tsdbDestroyTableDataIter(pCheckInfo->iter);
+    pCheckInfo->iiter   = tsdbDestroyTableDataIter(pCheckInfo->iiter);
     pCheckInfo->initBuf = false;
 
     if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
@@ -431,6 +433,11 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
     goto _end;
   }
 
+  // NULL if read-ahead is disabled, then all blocks are read when they are loaded
+  pQueryHandle->rhelper.pRa = tsdbNewReadAhead();
+  pQueryHandle->rhelper.cacheIdx = true;
+  pQueryHandle->raSlot = INT32_MIN;
+
   assert(pCond != NULL && pMemRef != NULL);
   setQueryTimewindow(pQueryHandle, pCond);
 
@@ -452,7 +459,10 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
 
       colInfo.info = pCond->colList[i];
       colInfo.pData = calloc(1, EXTRA_BYTES + pQueryHandle->outputCapacity * pCond->colList[i].bytes);
-      if (colInfo.pData == NULL) {
+      colInfo.pBitmap = calloc(1, TD_BITMAP_BYTES(pQueryHandle->outputCapacity));
+      if (colInfo.pData == NULL || colInfo.pBitmap == NULL) {
+        tfree(colInfo.pData);
+        tfree(colInfo.pBitmap);
         goto _end;
       }
 
@@ -631,6 +641,11 @@ TsdbQueryHandleT tsdbQueryCacheLast(STsdbRepo *tsdb, STsdbQueryCond *pCond, STab
     return NULL;
   }
 
+  // all tables are in one group, only the latest value of each column among them matters
+  if (pQueryHandle->cachelastrow == TSDB_CACHED_TYPE_LAST && taosArrayGetSize(groupList->pGroupList) == 1) {
+    pQueryHandle->cachelastrow = TSDB_CACHED_TYPE_LAST_MERGED;
+  }
+
   if (pQueryHandle->cachelastrow) {
     pQueryHandle->type = TSDB_QUERY_TYPE_LAST;
   }
@@ -738,8 +753,7 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
     pMem = pMemT->tData[pCheckInfo->tableId.tid];
     if (pMem != NULL && pMem->uid == pCheckInfo->tableId.uid) { // check uid
       TKEY tLastKey = keyToTkey(pCheckInfo->lastKey);
-      pCheckInfo->iter =
-          tSkipListCreateIterFromVal(pMem->pData, (const char*)&tLastKey, TSDB_DATA_TYPE_TIMESTAMP, order);
+      pCheckInfo->iter = tsdbCreateTableDataIterFromKey(pMem, tLastKey, order);
     }
   }
 
@@ -747,8 +761,7 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
     pIMem = pIMemT->tData[pCheckInfo->tableId.tid];
     if (pIMem != NULL && pIMem->uid == pCheckInfo->tableId.uid) { // check uid
       TKEY tLastKey = keyToTkey(pCheckInfo->lastKey);
-      pCheckInfo->iiter =
-          tSkipListCreateIterFromVal(pIMem->pData, (const char*)&tLastKey, TSDB_DATA_TYPE_TIMESTAMP, order);
+      pCheckInfo->iiter = tsdbCreateTableDataIterFromKey(pIMem, tLastKey, order);
     }
   }
 
@@ -757,17 +770,16 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
     return false;
   }
 
-  bool memEmpty  = (pCheckInfo->iter == NULL) || (pCheckInfo->iter != NULL && !tSkipListIterNext(pCheckInfo->iter));
-  bool imemEmpty = (pCheckInfo->iiter == NULL) || (pCheckInfo->iiter != NULL && !tSkipListIterNext(pCheckInfo->iiter));
+  bool memEmpty  = (pCheckInfo->iter == NULL) || (pCheckInfo->iter != NULL && !tsdbTableDataIterNext(pCheckInfo->iter));
+  bool imemEmpty = (pCheckInfo->iiter == NULL) || (pCheckInfo->iiter != NULL && !tsdbTableDataIterNext(pCheckInfo->iiter));
   if (memEmpty && imemEmpty) { // buffer is empty
     return false;
   }
 
   if (!memEmpty) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    assert(node != NULL);
+    SMemRow row = tsdbTableDataIterGet(pCheckInfo->iter);
+    assert(row != NULL);
 
-    SMemRow row = (SMemRow)SL_GET_NODE_DATA(node);
     TSKEY   key = memRowKey(row);  // first timestamp in buffer
     tsdbDebug("%p uid:%" PRId64 ", tid:%d check data in mem from skey:%" PRId64 ", order:%d, ts range in buf:%" PRId64
               "-%" PRId64 ", lastKey:%" PRId64 ", numOfRows:%"PRId64", 0x%"PRIx64,
@@ -786,10 +798,9 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
   }
 
   if (!imemEmpty) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    assert(node != NULL);
+    SMemRow row = tsdbTableDataIterGet(pCheckInfo->iiter);
+    assert(row != NULL);
 
-    SMemRow row = (SMemRow)SL_GET_NODE_DATA(node);
     TSKEY   key = memRowKey(row);  // first timestamp in buffer
     tsdbDebug("%p uid:%" PRId64 ", tid:%d check data in imem from skey:%" PRId64 ", order:%d, ts range in buf:%" PRId64
               "-%" PRId64 ", lastKey:%" PRId64 ", numOfRows:%"PRId64", 0x%"PRIx64,
@@ -810,24 +821,18 @@ static bool initTableMemIterator(STsdbQueryHandle* pHandle, STableCheckInfo* pCh
 }
 
 static void destroyTableMemIterator(STableCheckInfo* pCheckInfo) {
-  tSkipListDestroyIter(pCheckInfo->iter);
-  tSkipListDestroyIter(pCheckInfo->iiter);
+  tsdbDestroyTableDataIter(pCheckInfo->iter);
+  tsdbDestroyTableDataIter(pCheckInfo->iiter);
 }
 
 static TSKEY extractFirstTraverseKey(STableCheckInfo* pCheckInfo, int32_t order, int32_t update) {
   SMemRow rmem = NULL, rimem = NULL;
   if (pCheckInfo->iter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    if (node != NULL) {
-      rmem = (SMemRow)SL_GET_NODE_DATA(node);
-    }
+    rmem = tsdbTableDataIterGet(pCheckInfo->iter);
   }
 
   if (pCheckInfo->iiter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    if (node != NULL) {
-      rimem = (SMemRow)SL_GET_NODE_DATA(node);
-    }
+    rimem = tsdbTableDataIterGet(pCheckInfo->iiter);
   }
 
   if (rmem == NULL && rimem == NULL) {
@@ -850,11 +855,11 @@ static TSKEY extractFirstTraverseKey(STableCheckInfo* pCheckInfo, int32_t order,
   if (r1 == r2) {
     if(update == TD_ROW_DISCARD_UPDATE){
       pCheckInfo->chosen = CHECKINFO_CHOSEN_IMEM;
-      tSkipListIterNext(pCheckInfo->iter);
+      tsdbTableDataIterNext(pCheckInfo->iter);
     }
     else if(update == TD_ROW_OVERWRITE_UPDATE) {
       pCheckInfo->chosen = CHECKINFO_CHOSEN_MEM;
-      tSkipListIterNext(pCheckInfo->iiter);
+      tsdbTableDataIterNext(pCheckInfo->iiter);
     } else {
       pCheckInfo->chosen = CHECKINFO_CHOSEN_BOTH;
     }
@@ -872,17 +877,11 @@ static TSKEY extractFirstTraverseKey(STableCheckInfo* pCheckInfo, int32_t order,
 static SMemRow getSMemRowInTableMem(STableCheckInfo* pCheckInfo, int32_t order, int32_t update, SMemRow* extraRow) {
   SMemRow rmem = NULL, rimem = NULL;
   if (pCheckInfo->iter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iter);
-    if (node != NULL) {
-      rmem = (SMemRow)SL_GET_NODE_DATA(node);
-    }
+    rmem = tsdbTableDataIterGet(pCheckInfo->iter);
   }
 
   if (pCheckInfo->iiter) {
-    SSkipListNode* node = tSkipListIterGet(pCheckInfo->iiter);
-    if (node != NULL) {
-      rimem = (SMemRow)SL_GET_NODE_DATA(node);
-    }
+    rimem = tsdbTableDataIterGet(pCheckInfo->iiter);
   }
 
   if (rmem == NULL && rimem == NULL) {
@@ -904,11 +903,11 @@ static SMemRow getSMemRowInTableMem(STableCheckInfo* pCheckInfo, int32_t order,
 
   if (r1 == r2) {
     if (update == TD_ROW_DISCARD_UPDATE) {
-      tSkipListIterNext(pCheckInfo->iter);
+      tsdbTableDataIterNext(pCheckInfo->iter);
       pCheckInfo->chosen = CHECKINFO_CHOSEN_IMEM;
       return rimem;
     } else if(update == TD_ROW_OVERWRITE_UPDATE){
-      tSkipListIterNext(pCheckInfo->iiter);
+      tsdbTableDataIterNext(pCheckInfo->iiter);
       pCheckInfo->chosen = CHECKINFO_CHOSEN_MEM;
       return rmem;
     } else {
@@ -941,7 +940,7 @@ static bool moveToNextRowInMem(STableCheckInfo* pCheckInfo) {
   bool hasNext = false;
   if (pCheckInfo->chosen == CHECKINFO_CHOSEN_MEM) {
     if (pCheckInfo->iter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iter);
+      hasNext = tsdbTableDataIterNext(pCheckInfo->iter);
     }
 
     if (hasNext) {
@@ -949,11 +948,11 @@ static bool moveToNextRowInMem(STableCheckInfo* pCheckInfo) {
     }
 
     if (pCheckInfo->iiter != NULL) {
-      return tSkipListIterGet(pCheckInfo->iiter) != NULL;
+      return tsdbTableDataIterGet(pCheckInfo->iiter) != NULL;
     }
   } else if (pCheckInfo->chosen == CHECKINFO_CHOSEN_IMEM){
     if (pCheckInfo->iiter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iiter);
+      hasNext = tsdbTableDataIterNext(pCheckInfo->iiter);
     }
 
     if (hasNext) {
@@ -961,14 +960,14 @@ static bool moveToNextRowInMem(STableCheckInfo* pCheckInfo) {
     }
 
     if (pCheckInfo->iter != NULL) {
-      return tSkipListIterGet(pCheckInfo->iter) != NULL;
+      return tsdbTableDataIterGet(pCheckInfo->iter) != NULL;
     }
   } else {
     if (pCheckInfo->iter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iter);
+      hasNext = tsdbTableDataIterNext(pCheckInfo->iter);
     }
     if (pCheckInfo->iiter != NULL) {
-      hasNext = tSkipListIterNext(pCheckInfo->iiter) || hasNext;
+      hasNext = tsdbTableDataIterNext(pCheckInfo->iiter) || hasNext;
     }
   }
 
@@ -1173,6 +1172,40 @@ static int32_t getFileCompInfo(STsdbQueryHandle* pQueryHandle, int32_t* numOfBlo
   return code;
 }
 
+/*
+ * Keep the next blocks of the scan being read while the block at slot is loaded and decompressed. The read-ahead
+ * starts with the first block that is really loaded, so the scans answered by the block statistics read nothing more.
+ * The blocks with sub-blocks are left to be read when they are loaded.
+ */
+static void readAheadFileBlocks(STsdbQueryHandle* pQueryHandle, int32_t slot) {
+  SReadH* pReadh = &pQueryHandle->rhelper;
+  int32_t depth = tsdbReadAheadDepth(pReadh->pRa);
+  if (depth <= 0) {
+    return;
+  }
+
+  int32_t step = ASCENDING_TRAVERSE(pQueryHandle->order)? 1:-1;
+  if (pQueryHandle->raSlot == INT32_MIN || (pQueryHandle->raSlot - slot) * step <= 0) {
+    pQueryHandle->raSlot = slot + step;
+  }
+
+  for(; (pQueryHandle->raSlot - slot) * step <= depth; pQueryHandle->raSlot += step) {
+    if (pQueryHandle->raSlot < 0 || pQueryHandle->raSlot >= pQueryHandle->numOfBlocks) {
+      break;
+    }
+
+    SBlock* pBlock = pQueryHandle->pDataBlockInfo[pQueryHandle->raSlot].compBlock;
+    if (pBlock->numOfSubBlocks > 1) {
+      continue;
+    }
+
+    SDFile* pDFile = (pBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+    tsdbReadAheadSubmit(pReadh->pRa, TSDB_FILE_FD(pDFile), pBlock->offset, pBlock->len, pBlock->numOfCols,
+                        pBlock->keyLen, pQueryHandle->defaultLoadColumn->pData,
+                        (int)(QH_GET_NUM_OF_COLS(pQueryHandle)));
+  }
+}
+
 static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo, int32_t slotIndex) {
   int64_t st = taosGetTimestampUs();
 
@@ -1200,6 +1233,8 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBloc
 
   int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
 
+  readAheadFileBlocks(pQueryHandle, slotIndex);
+
   int32_t ret = tsdbLoadBlockDataCols(&(pQueryHandle->rhelper), pBlock, pCheckInfo->pCompInfo, colIds, (int)(QH_GET_NUM_OF_COLS(pQueryHandle)));
   if (ret != TSDB_CODE_SUCCESS) {
     int32_t c = terrno;
@@ -1244,6 +1279,8 @@ _error:
 static int32_t getEndPosInDataBlock(STsdbQueryHandle* pQueryHandle, SDataBlockInfo* pBlockInfo);
 static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, int32_t start, int32_t end);
 static void moveDataToFront(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, int32_t numOfCols);
+static void setBitmapFromData(SColumnInfoData* pColInfo, int32_t start, int32_t num);
+static void moveColumnsToFront(SArray* pColumns, int32_t numOfCols, int32_t emptySize, int32_t numOfRows);
 static void doCheckGeneratedBlockRange(STsdbQueryHandle* pQueryHandle);
 static void copyAllRemainRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo, SDataBlockInfo* pBlockInfo, int32_t endPos);
 
@@ -1493,7 +1530,11 @@ static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t c
       pData = (char*)pColInfo->pData + (capacity - numOfRows - num) * pColInfo->info.bytes;
     }
 
+    int32_t dstRow = (int32_t)((pData - (char*)pColInfo->pData) / bytes);
+
     if (!isAllRowsNull(src) && pColInfo->info.colId == src->colId) {
+      tdBitmapCopy(pColInfo->pBitmap, dstRow, src->pBitmap, start, num);
+
       if (pColInfo->info.type != TSDB_DATA_TYPE_BINARY && pColInfo->info.type != TSDB_DATA_TYPE_NCHAR) {
         memmove(pData, (char*)src->pData + bytes * start, bytes * num);
       } else {  // handle the var-string
@@ -1510,6 +1551,8 @@ static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t c
       j++;
       i++;
     } else { // pColInfo->info.colId < src->colId, it is a NULL data
+      tdBitmapSetRange(pColInfo->pBitmap, dstRow, num, false);
+
       if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
         char* dst = pData;
 
@@ -1528,8 +1571,10 @@ static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t c
     SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
     if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
       pData = (char*)pColInfo->pData + numOfRows * pColInfo->info.bytes;
+      tdBitmapSetRange(pColInfo->pBitmap, numOfRows, num, false);
     } else {
       pData = (char*)pColInfo->pData + (capacity - numOfRows - num) * pColInfo->info.bytes;
+      tdBitmapSetRange(pColInfo->pBitmap, capacity - numOfRows - num, num, false);
     }
 
     if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
@@ -1748,6 +1793,26 @@ static void mergeTwoRowFromMem(STsdbQueryHandle* pQueryHandle, int32_t capacity,
       i++;
     }
   }
+
+  // the row may keep the values of a former row in the columns not updated, so the bits follow the data
+  int32_t pos = ASCENDING_TRAVERSE(pQueryHandle->order) ? numOfRows : (capacity - numOfRows - 1);
+  for (int32_t n = 0; n < numOfCols; ++n) {
+    setBitmapFromData(taosArrayGet(pQueryHandle->pColumns, n), pos, 1);
+  }
+}
+
+static void setBitmapFromData(SColumnInfoData* pColInfo, int32_t start, int32_t num) {
+  for (int32_t k = start; k < start + num; ++k) {
+    tdBitmapSetTo(pColInfo->pBitmap, k, !isNull(pColInfo->pData + k * pColInfo->info.bytes, pColInfo->info.type));
+  }
+}
+
+static void moveColumnsToFront(SArray* pColumns, int32_t numOfCols, int32_t emptySize, int32_t numOfRows) {
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pColumns, i);
+    memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
+    tdBitmapCopy(pColInfo->pBitmap, 0, pColInfo->pBitmap, emptySize, numOfRows);
+  }
 }
 
 static void moveDataToFront(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, int32_t numOfCols) {
@@ -1758,10 +1823,7 @@ static void moveDataToFront(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, i
   // if the buffer is not full in case of descending order query, move the data in the front of the buffer
   if (numOfRows < pQueryHandle->outputCapacity) {
     int32_t emptySize = pQueryHandle->outputCapacity - numOfRows;
-    for(int32_t i = 0; i < numOfCols; ++i) {
-      SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
-      memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
-    }
+    moveColumnsToFront(pQueryHandle->pColumns, numOfCols, emptySize, numOfRows);
   }
 }
 
@@ -2177,6 +2239,8 @@ static int32_t dataBlockOrderCompar(const void* pLeft, const void* pRight, void*
 }
 
 static int32_t createDataBlocksInfo(STsdbQueryHandle* pQueryHandle, int32_t numOfBlocks, int32_t* numOfAllocBlocks) {
+  pQueryHandle->raSlot = INT32_MIN;
+
   size_t size = sizeof(STableBlockInfo) * numOfBlocks;
 
   if (pQueryHandle->allocSize < size) {
@@ -2661,11 +2725,7 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
   // if the buffer is not full in case of descending order query, move the data in the front of the buffer
   if (!ASCENDING_TRAVERSE(pQueryHandle->order) && numOfRows < maxRowsToRead) {
     int32_t emptySize = maxRowsToRead - numOfRows;
-
-    for(int32_t i = 0; i < numOfCols; ++i) {
-      SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
-      memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
-    }
+    moveColumnsToFront(pQueryHandle->pColumns, numOfCols, emptySize, numOfRows);
   }
 
   int64_t elapsedTime = taosGetTimestampUs() - st;
@@ -2793,6 +2853,172 @@ static bool loadCachedLastRow(STsdbQueryHandle* pQueryHandle) {
 
 
 
+static void setCachedLastValue(SColumnInfoData* pColInfo, char* pData, const void* value) {
+  switch (pColInfo->info.type) {
+    case TSDB_DATA_TYPE_BINARY:
+    case TSDB_DATA_TYPE_NCHAR:
+      memcpy(pData, value, varDataTLen(value));
+      break;
+    case TSDB_DATA_TYPE_NULL:
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_UTINYINT:
+      *(uint8_t *)pData = *(uint8_t *)value;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+      *(uint16_t *)pData = *(uint16_t *)value;
+      break;
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_UINT:
+      *(uint32_t *)pData = *(uint32_t *)value;
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_UBIGINT:
+      *(uint64_t *)pData = *(uint64_t *)value;
+      break;
+    case TSDB_DATA_TYPE_FLOAT:
+      SET_FLOAT_PTR(pData, value);
+      break;
+    case TSDB_DATA_TYPE_DOUBLE:
+      SET_DOUBLE_PTR(pData, value);
+      break;
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      *(TSKEY *)pData = *(TSKEY *)value;
+      break;
+    default:
+      memcpy(pData, value, pColInfo->info.bytes);
+  }
+}
+
+static void setCachedLastRowNull(STsdbQueryHandle* pQueryHandle, int32_t rowIndex) {
+  int32_t tgNumOfCols = (int32_t)QH_GET_NUM_OF_COLS(pQueryHandle);
+
+  for (int32_t n = 0; n < tgNumOfCols; ++n) {
+    SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, n);
+    char*            pData = (char*)pColInfo->pData + rowIndex * pColInfo->info.bytes;
+
+    if (pColInfo->info.type == TSDB_DATA_TYPE_BINARY || pColInfo->info.type == TSDB_DATA_TYPE_NCHAR) {
+      setVardataNull(pData, pColInfo->info.type);
+    } else {
+      setNull(pData, pColInfo->info.type, pColInfo->info.bytes);
+    }
+  }
+}
+
+/*
+ * Merge the cached last columns of all tables of the only group into one block: each queried column takes one row
+ * which holds the latest not-null value of the column among the tables, so the block is bounded by the number of
+ * columns instead of tables * columns, and the last function of the group gets the same result.
+ */
+static bool loadMergedCachedLast(STsdbQueryHandle* pQueryHandle) {
+  int32_t tgNumOfCols = (int32_t)QH_GET_NUM_OF_COLS(pQueryHandle);
+  size_t  numOfTables = taosArrayGetSize(pQueryHandle->pTableCheckInfo);
+  int32_t numOfRows = 0;
+  int32_t priIdx = -1;
+  SQueryFilePos* cur = &pQueryHandle->cur;
+
+  assert(numOfTables > 0 && tgNumOfCols > 0);
+  if (pQueryHandle->activeIndex >= (int32_t)numOfTables - 1) {
+    return false;
+  }
+
+  // row of each queried column, and the timestamp of the value in the row
+  int32_t* rowIndex = malloc(tgNumOfCols * sizeof(int32_t));
+  TSKEY*   rowKey = malloc(tgNumOfCols * sizeof(TSKEY));
+  if (rowIndex == NULL || rowKey == NULL) {
+    tfree(rowIndex);
+    tfree(rowKey);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return false;
+  }
+
+  for (int32_t i = 0; i < tgNumOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
+    if (pColInfo->info.colId == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+      priIdx = i;
+    }
+    rowIndex[i] = -1;
+    rowKey[i] = TSKEY_INITIAL_VAL;
+  }
+
+  for (int32_t t = 0; t < numOfTables; ++t) {
+    STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, t);
+    STable*          pTable = pCheckInfo->pTableObj;
+
+    TSDB_RLOCK_TABLE(pTable);
+    if (pTable->lastCols == NULL || pTable->maxColNum <= 0) {
+      TSDB_RUNLOCK_TABLE(pTable);
+      continue;
+    }
+
+    int32_t i = 0, j = 0;
+    while (i < tgNumOfCols && j < pTable->maxColNum) {
+      SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
+      SDataCol*        pLastCol = &pTable->lastCols[j];
+
+      if (pLastCol->colId < pColInfo->info.colId) {
+        j++;
+        continue;
+      } else if (pLastCol->colId > pColInfo->info.colId) {
+        i++;
+        continue;
+      }
+
+      TSKEY key = (i == priIdx && pLastCol->bytes > 0) ? tdGetKey(*(TKEY*)pLastCol->pData) : pLastCol->ts;
+      if (pLastCol->bytes > 0 && (rowKey[i] == TSKEY_INITIAL_VAL || key > rowKey[i])) {
+        rowKey[i] = key;
+        if (i != priIdx) {
+          if (rowIndex[i] < 0) {
+            rowIndex[i] = numOfRows++;
+            assert(numOfRows < pQueryHandle->outputCapacity);
+            setCachedLastRowNull(pQueryHandle, rowIndex[i]);
+          }
+          setCachedLastValue(pColInfo, (char*)pColInfo->pData + rowIndex[i] * pColInfo->info.bytes, pLastCol->pData);
+        }
+      }
+
+      i++;
+      j++;
+    }
+    TSDB_RUNLOCK_TABLE(pTable);
+  }
+
+  // leave the real ts column as the last row, because last function only (not stable) use the last row as res
+  if (priIdx >= 0 && rowKey[priIdx] != TSKEY_INITIAL_VAL) {
+    rowIndex[priIdx] = numOfRows++;
+    setCachedLastRowNull(pQueryHandle, rowIndex[priIdx]);
+  }
+
+  // set the timestamp of each row, the row of the real ts column holds only the timestamp
+  if (priIdx >= 0) {
+    SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, priIdx);
+    for (int32_t i = 0; i < tgNumOfCols; ++i) {
+      if (rowIndex[i] >= 0) {
+        *(TSKEY*)((char*)pColInfo->pData + rowIndex[i] * pColInfo->info.bytes) = rowKey[i];
+      }
+    }
+  }
+
+  tfree(rowIndex);
+  tfree(rowKey);
+
+  // report the block as the one of the last table, which is in the group as well
+  pQueryHandle->activeIndex = (int32_t)numOfTables - 1;
+  if (numOfRows == 0) {
+    return false;
+  }
+
+  for (int32_t n = 0; n < tgNumOfCols; ++n) {
+    setBitmapFromData(taosArrayGet(pQueryHandle->pColumns, n), 0, numOfRows);
+  }
+
+  cur->rows     = numOfRows;
+  cur->mixBlock = true;
+
+  return true;
+}
+
 static bool loadCachedLast(STsdbQueryHandle* pQueryHandle) {
   // the last row is cached in buffer, return it directly.
   // here note that the pQueryHandle->window must be the TS_INITIALIZER
@@ -2832,50 +3058,16 @@ static bool loadCachedLast(STsdbQueryHandle* pQueryHandle) {
     
       if (pTable->lastCols[j].bytes > 0) {        
         void* value = pTable->lastCols[j].pData;
-        switch (pColInfo->info.type) {
-          case TSDB_DATA_TYPE_BINARY:
-          case TSDB_DATA_TYPE_NCHAR:
-            memcpy(pData, value, varDataTLen(value));
-            break;
-          case TSDB_DATA_TYPE_NULL:
-          case TSDB_DATA_TYPE_BOOL:
-          case TSDB_DATA_TYPE_TINYINT:
-          case TSDB_DATA_TYPE_UTINYINT:  
-            *(uint8_t *)pData = *(uint8_t *)value;
-            break;
-          case TSDB_DATA_TYPE_SMALLINT:
-          case TSDB_DATA_TYPE_USMALLINT:
-            *(uint16_t *)pData = *(uint16_t *)value;
-            break;
-          case TSDB_DATA_TYPE_INT:
-          case TSDB_DATA_TYPE_UINT:
-            *(uint32_t *)pData = *(uint32_t *)value;
-            break;
-          case TSDB_DATA_TYPE_BIGINT:
-          case TSDB_DATA_TYPE_UBIGINT:
-            *(uint64_t *)pData = *(uint64_t *)value;
-            break;
-          case TSDB_DATA_TYPE_FLOAT:
-            SET_FLOAT_PTR(pData, value);
-            break;
-          case TSDB_DATA_TYPE_DOUBLE:
-            SET_DOUBLE_PTR(pData, value);
-            break;
-          case TSDB_DATA_TYPE_TIMESTAMP:
-            if (pColInfo->info.colId == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
-              priKey = tdGetKey(*(TKEY *)value);
-              priIdx = i;
+        if (pColInfo->info.colId == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+          priKey = tdGetKey(*(TKEY *)value);
+          priIdx = i;
 
-              i++;
-              j++;
-              continue;
-            } else {
-              *(TSKEY *)pData = *(TSKEY *)value;
-            }
-            break;
-          default:
-            memcpy(pData, value, pColInfo->info.bytes);
+          i++;
+          j++;
+          continue;
         }
+
+        setCachedLastValue(pColInfo, pData, value);
     
         for (int32_t n = 0; n < tgNumOfCols; ++n) {
           if (n == i) {
@@ -2933,6 +3125,10 @@ static bool loadCachedLast(STsdbQueryHandle* pQueryHandle) {
     }
     
     if (numOfRows > 0) {
+      for (int32_t n = 0; n < tgNumOfCols; ++n) {
+        setBitmapFromData(taosArrayGet(pQueryHandle->pColumns, n), 0, numOfRows);
+      }
+
       cur->rows     = numOfRows;
       cur->mixBlock = true;
       
@@ -2991,6 +3187,8 @@ bool tsdbNextDataBlock(TsdbQueryHandleT pHandle) {
       return loadCachedLastRow(pQueryHandle);
     } else if (pQueryHandle->cachelastrow == TSDB_CACHED_TYPE_LAST) {
       return loadCachedLast(pQueryHandle);
+    } else if (pQueryHandle->cachelastrow == TSDB_CACHED_TYPE_LAST_MERGED) {
+      return loadMergedCachedLast(pQueryHandle);
     }
   }
 
@@ -3403,6 +3601,28 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
   return TSDB_CODE_SUCCESS;
 }
 
+bool tsdbDataBlockMayContain(TsdbQueryHandleT pQueryHandle, int16_t colId, const void* val, int32_t len) {
+  STsdbQueryHandle* pHandle = (STsdbQueryHandle*) pQueryHandle;
+
+  // rows merged from the cache are not in the filter
+  SQueryFilePos* c = &pHandle->cur;
+  if (c->fid == INT32_MIN || c->mixBlock) {
+    return true;
+  }
+
+  STableBlockInfo* pBlockInfo = &pHandle->pDataBlockInfo[c->slot];
+  if (pBlockInfo->compBlock->numOfSubBlocks > 1) {
+    return true;
+  }
+
+  SBlockFilter* pFilter = NULL;
+  if (tsdbLoadBlockFilter(&pHandle->rhelper, pBlockInfo->compBlock, colId, &pFilter) < 0 || pFilter == NULL) {
+    return true;
+  }
+
+  return tsdbBlockFilterMayContain(pFilter, val, len);
+}
+
 SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
   /**
    * In the following two cases, the data has been loaded to SColumnInfoData.
@@ -3441,11 +3661,7 @@ SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
         if (!ASCENDING_TRAVERSE(pHandle->order) && numOfRows < pHandle->outputCapacity) {
           int32_t emptySize = pHandle->outputCapacity - numOfRows;
           int32_t reqNumOfCols = (int32_t)taosArrayGetSize(pHandle->pColumns);
-
-          for(int32_t i = 0; i < reqNumOfCols; ++i) {
-            SColumnInfoData* pColInfo = taosArrayGet(pHandle->pColumns, i);
-            memmove((char*)pColInfo->pData, (char*)pColInfo->pData + emptySize * pColInfo->info.bytes, numOfRows * pColInfo->info.bytes);
-          }
+          moveColumnsToFront(pHandle->pColumns, reqNumOfCols, emptySize, numOfRows);
         }
 
         return pHandle->pColumns;
@@ -3641,18 +3857,10 @@ SArray* createTableGroup(SArray* pTableList, STSchema* pTagSchema, SColIndex* pC
   return pTableGroup;
 }
 
-static bool tableFilterFp(const void* pNode, void* param) {
+// the filter of a value of a tag, or of the table name, val is NULL if the table has no value of the tag
+static bool tagValueFilter(const char* val, void* param) {
   tQueryInfo* pInfo = (tQueryInfo*) param;
 
-  STable* pTable = (STable*)(SL_GET_NODE_DATA((SSkipListNode*)pNode));
-
-  char* val = NULL;
-  if (pInfo->sch.colId == TSDB_TBNAME_COLUMN_INDEX) {
-    val = (char*) TABLE_NAME(pTable);
-  } else {
-    val = tdGetKVRowValOfCol(pTable->tagVal, pInfo->sch.colId);
-  }
-
   if (pInfo->optr == TSDB_RELATION_ISNULL || pInfo->optr == TSDB_RELATION_NOTNULL) {
     if (pInfo->optr == TSDB_RELATION_ISNULL) {
       return (val == NULL) || isNull(val, pInfo->sch.type);
@@ -3723,6 +3931,149 @@ static bool tableFilterFp(const void* pNode, void* param) {
   return true;
 }
 
+static bool tableObjFilterFp(const void* pObj, void* param) {
+  tQueryInfo* pInfo = (tQueryInfo*) param;
+  STable*     pTable = (STable*) pObj;
+
+  char* val = NULL;
+  if (pInfo->sch.colId == TSDB_TBNAME_COLUMN_INDEX) {
+    val = (char*) TABLE_NAME(pTable);
+  } else {
+    val = tdGetKVRowValOfCol(pTable->tagVal, pInfo->sch.colId);
+  }
+
+  return tagValueFilter(val, param);
+}
+
+static bool tableFilterFp(const void* pNode, void* param) {
+  return tableObjFilterFp(SL_GET_NODE_DATA((SSkipListNode*)pNode), param);
+}
+
+#define TAG_INDEX_NONE      0  // the expression is not answered by the tag index
+#define TAG_INDEX_EXACT     1  // the bitmap holds the tables that pass the expression
+#define TAG_INDEX_CANDIDATE 2  // the bitmap holds more tables, each of them is filtered by the expression
+
+static int32_t applyExprToTagIndex(STagIndex* pIndex, tExprNode* pExpr, SExprTraverseSupp* param, uint8_t* bitmap,
+                                   int32_t nbytes) {
+  tExprNode* pLeft  = pExpr->_node.pLeft;
+  tExprNode* pRight = pExpr->_node.pRight;
+
+  // handle the leaf node, the same way as exprTreeApplyFilter
+  if (pLeft->nodeType != TSQL_NODE_EXPR || pRight->nodeType != TSQL_NODE_EXPR) {
+    param->setupInfoFn(pExpr, param->pExtInfo);
+
+    tQueryInfo* pInfo = pExpr->_node.info;
+    if (pInfo->sch.colId == TSDB_TBNAME_COLUMN_INDEX) {
+      return TAG_INDEX_NONE;
+    }
+
+    if (tsdbTagIndexMatch(pIndex, &pInfo->sch, pInfo->optr, pInfo->q, tagValueFilter, pInfo, bitmap) < 0) {
+      return TAG_INDEX_NONE;
+    }
+
+    return TAG_INDEX_EXACT;
+  }
+
+  uint8_t* pRightMap = calloc(1, nbytes);
+  if (pRightMap == NULL) {
+    return TAG_INDEX_NONE;
+  }
+
+  int32_t l = applyExprToTagIndex(pIndex, pLeft, param, bitmap, nbytes);
+  int32_t r = applyExprToTagIndex(pIndex, pRight, param, pRightMap, nbytes);
+  int32_t ret = TAG_INDEX_NONE;
+
+  uint64_t* pDst = (uint64_t*) bitmap;
+  uint64_t* pSrc = (uint64_t*) pRightMap;
+  int32_t   nwords = nbytes / sizeof(uint64_t);
+
+  if (pExpr->_node.optr == TSDB_RELATION_OR) {
+    // the tables passing the side not answered could be anywhere
+    if (l != TAG_INDEX_NONE && r != TAG_INDEX_NONE) {
+      for (int32_t i = 0; i < nwords; ++i) {
+        pDst[i] |= pSrc[i];
+      }
+      ret = (l == TAG_INDEX_EXACT && r == TAG_INDEX_EXACT) ? TAG_INDEX_EXACT : TAG_INDEX_CANDIDATE;
+    }
+  } else {
+    // the tables passing the side answered hold the tables passing both sides
+    if (l != TAG_INDEX_NONE && r != TAG_INDEX_NONE) {
+      for (int32_t i = 0; i < nwords; ++i) {
+        pDst[i] &= pSrc[i];
+      }
+      ret = (l == TAG_INDEX_EXACT && r == TAG_INDEX_EXACT) ? TAG_INDEX_EXACT : TAG_INDEX_CANDIDATE;
+    } else if (l != TAG_INDEX_NONE) {
+      ret = TAG_INDEX_CANDIDATE;
+    } else if (r != TAG_INDEX_NONE) {
+      memcpy(bitmap, pRightMap, nbytes);
+      ret = TAG_INDEX_CANDIDATE;
+    }
+  }
+
+  free(pRightMap);
+  return ret;
+}
+
+/**
+ * Find the tables by the inverted index of the tags of the super table. The postings of the conditions are combined
+ * as bitmaps before any table is touched, only the tables left are filtered one by one if a condition is not answered
+ * by the index. Return false if the expression is not answered by the index at all.
+ */
+static bool queryTableListByTagIndex(STable* pSTable, tExprNode* pExpr, SArray* pRes, SExprTraverseSupp* param) {
+  STagIndex* pIndex = pSTable->pTagIndex;
+  if (pIndex == NULL) {
+    return false;
+  }
+
+  int32_t  capacity = tsdbTagIndexCapacity(pIndex);
+  int32_t  nbytes = MAX(TD_BITMAP_BYTES(capacity), sizeof(uint64_t));
+  uint8_t* bitmap = calloc(1, nbytes);
+  if (bitmap == NULL) {
+    return false;
+  }
+
+  int32_t ret = applyExprToTagIndex(pIndex, pExpr, param, bitmap, nbytes);
+  if (ret == TAG_INDEX_NONE) {
+    free(bitmap);
+    return false;
+  }
+
+  SExprTraverseSupp supp = *param;
+  supp.nodeFilterFn = tableObjFilterFp;
+
+  for (int32_t id = tdBitmapFind(bitmap, 0, capacity, true); id < capacity;
+       id = tdBitmapFind(bitmap, id + 1, capacity, true)) {
+    STable* pTable = tsdbTagIndexGetTable(pIndex, id);
+    assert(pTable != NULL);
+
+    if (ret == TAG_INDEX_CANDIDATE && !exprTreeApplyFilter(pExpr, pTable, &supp)) {
+      continue;
+    }
+
+    STableKeyInfo info = {.pTable = (void*)pTable, .lastKey = TSKEY_INITIAL_VAL};
+    taosArrayPush(pRes, &info);
+  }
+
+  tsdbDebug("stable uid:%" PRIu64 " tables found by tag index:%" PRIzu ", %s", TABLE_UID(pSTable),
+            taosArrayGetSize(pRes), (ret == TAG_INDEX_EXACT) ? "exact" : "filtered");
+
+  free(bitmap);
+  return true;
+}
+
+// a condition on the first tag alone is answered by the skiplist of the super table, in the order of the tag
+static bool isSkipListIndexedQuery(tExprNode* pExpr, SExprTraverseSupp* param) {
+  if (pExpr->_node.pLeft->nodeType == TSQL_NODE_EXPR || pExpr->_node.pRight->nodeType == TSQL_NODE_EXPR) {
+    return false;
+  }
+
+  param->setupInfoFn(pExpr, param->pExtInfo);
+
+  tQueryInfo* pQueryInfo = pExpr->_node.info;
+  return pQueryInfo->indexed && (pQueryInfo->optr != TSDB_RELATION_LIKE && pQueryInfo->optr != TSDB_RELATION_MATCH &&
+                                 pQueryInfo->optr != TSDB_RELATION_IN);
+}
+
 static void getTableListfromSkipList(tExprNode *pExpr, SSkipList *pSkipList, SArray *result, SExprTraverseSupp *param);
 
 static int32_t doQueryTableList(STable* pSTable, SArray* pRes, tExprNode* pExpr) {
@@ -3733,7 +4084,9 @@ static int32_t doQueryTableList(STable* pSTable, SArray* pRes, tExprNode* pExpr)
       .pExtInfo = pSTable->tagSchema,
       };
 
-  getTableListfromSkipList(pExpr, pSTable->pIndex, pRes, &supp);
+  if (pExpr == NULL || isSkipListIndexedQuery(pExpr, &supp) || !queryTableListByTagIndex(pSTable, pExpr, pRes, &supp)) {
+    getTableListfromSkipList(pExpr, pSTable->pIndex, pRes, &supp);
+  }
   tExprTreeDestroy(pExpr, destroyHelper);
   return TSDB_CODE_SUCCESS;
 }
@@ -3920,6 +4273,7 @@ static void* doFreeColumnInfoData(SArray* pColumnInfoData) {
   for (int32_t i = 0; i < cols; ++i) {
     SColumnInfoData* pColInfo = taosArrayGet(pColumnInfoData, i);
     tfree(pColInfo->pData);
+    tfree(pColInfo->pBitmap);
   }
 
   taosArrayDestroy(pColumnInfoData);
@@ -4002,6 +4356,41 @@ void tsdbDestroyTableGroup(STableGroupInfo *pGroupList) {
   pGroupList->numOfTables = 0;
 }
 
+void tsdbPartitionTableGroup(STableGroupInfo *pGroupList, int32_t numOfParts, int32_t index) {
+  assert(pGroupList != NULL && numOfParts > 0 && index >= 0 && index < numOfParts);
+
+  size_t numOfGroup = taosArrayGetSize(pGroupList->pGroupList);
+  pGroupList->numOfTables = 0;
+
+  for(int32_t i = (int32_t)numOfGroup - 1; i >= 0; --i) {
+    SArray* p = taosArrayGetP(pGroupList->pGroupList, i);
+
+    size_t numOfTables = taosArrayGetSize(p);
+    int32_t n = 0;
+    for(int32_t j = 0; j < numOfTables; ++j) {
+      STableKeyInfo* pKeyInfo = taosArrayGet(p, j);
+      if (TABLE_TID((STable*)pKeyInfo->pTable) % numOfParts != index) {
+        tsdbUnRefTable(pKeyInfo->pTable);
+        continue;
+      }
+
+      if (n != j) {
+        taosArraySet(p, n, pKeyInfo);
+      }
+      n += 1;
+    }
+
+    if (n == 0) {
+      taosArrayDestroy(p);
+      taosArrayRemove(pGroupList->pGroupList, i);
+      continue;
+    }
+
+    taosArraySetSize(p, n);
+    pGroupList->numOfTables += (uint32_t)n;
+  }
+}
+
 static void applyFilterToSkipListNode(SSkipList *pSkipList, tExprNode *pExpr, SArray *pResult, SExprTraverseSupp *param) {
   SSkipListIterator* iter = tSkipListCreateIter(pSkipList);
 
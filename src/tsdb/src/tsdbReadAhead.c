@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+// Columns closer than this in a block are read together, a few bytes more cost less than another read
+#define TSDB_READ_AHEAD_MAX_GAP 4096
+
+typedef enum { RA_SLOT_EMPTY = 0, RA_SLOT_QUEUED, RA_SLOT_READING, RA_SLOT_DONE, RA_SLOT_FAILED } RA_SLOT_STATE_T;
+
+typedef struct {
+  int32_t offset;  // in the block
+  int32_t len;
+  int32_t pos;  // in the buffer of the slot
+} SReadAheadRange;
+
+typedef struct {
+  int8_t           state;
+  int              fd;
+  int64_t          offset;
+  int32_t          len;
+  int16_t          numOfCols;
+  int32_t          keyLen;
+  int              ncolIds;
+  int16_t *        colIds;  // the columns to read, a copy of the ones of the reader
+  int              nranges;
+  SReadAheadRange *ranges;  // the parts of the block in the buffer
+  void *           pBuf;
+  SListNode *      pNode;  // node of the slot in the queue of the pool, its data is the slot address
+} SReadAheadSlot;
+
+struct STsdbReadAhead {
+  int            depth;
+  int            nslots;  // depth + 1, the block being loaded keeps its slot while the next depth blocks are read
+  int            next;    // slot to take by the next submit
+  int64_t        hits;
+  int64_t        misses;
+  SReadAheadSlot slots[];
+};
+
+// All the slot states are protected by the lock of the pool, they change a few times per block only.
+typedef struct {
+  bool            stop;
+  pthread_mutex_t lock;
+  pthread_cond_t  queueNotEmpty;
+  pthread_cond_t  readDone;
+  int             nthreads;
+  SList *         queue;
+  pthread_t *     threads;
+} SReadAheadPool;
+
+static void *tsdbLoopReadAhead(void *arg);
+static void  tsdbReleaseReadAheadSlot(SReadAheadPool *pPool, SReadAheadSlot *pSlot);
+static void  tsdbDoReadAheadSlot(SReadAheadPool *pPool, SReadAheadSlot *pSlot);
+static int   tsdbReadAheadBlockCols(SReadAheadSlot *pSlot);
+static int   tsdbCompareReadAheadRange(const void *a, const void *b);
+
+static SReadAheadPool tsReadAheadPool = {0};
+
+int tsdbInitReadAheadPool() {
+  SReadAheadPool *pPool = &tsReadAheadPool;
+  int             nthreads = tsNumOfReadAheadThreads;
+
+  pPool->stop = false;
+  pPool->nthreads = 0;
+
+  // read-ahead is disabled, the readers read all the blocks themselves
+  if (tsReadAheadDepth <= 0 || nthreads <= 0) return 0;
+
+  pPool->queue = tdListNew(0);
+  if (pPool->queue == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pPool->threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+  if (pPool->threads == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    pPool->queue = tdListFree(pPool->queue);
+    return -1;
+  }
+
+  pthread_mutex_init(&(pPool->lock), NULL);
+  pthread_cond_init(&(pPool->queueNotEmpty), NULL);
+  pthread_cond_init(&(pPool->readDone), NULL);
+
+  for (int i = 0; i < nthreads; i++) {
+    pthread_create(pPool->threads + i, NULL, tsdbLoopReadAhead, NULL);
+  }
+  pPool->nthreads = nthreads;
+
+  tsdbDebug("read-ahead pool is initialized, threads:%d depth:%d", nthreads, tsReadAheadDepth);
+  return 0;
+}
+
+void tsdbCleanupReadAheadPool() {
+  SReadAheadPool *pPool = &tsReadAheadPool;
+  if (pPool->nthreads <= 0) return;
+
+  pthread_mutex_lock(&(pPool->lock));
+  if (pPool->stop) {
+    pthread_mutex_unlock(&(pPool->lock));
+    return;
+  }
+
+  pPool->stop = true;
+  pthread_cond_broadcast(&(pPool->queueNotEmpty));
+  pthread_mutex_unlock(&(pPool->lock));
+
+  for (int i = 0; i < pPool->nthreads; i++) {
+    pthread_join(pPool->threads[i], NULL);
+  }
+
+  // the readers are gone with the vnodes, the nodes still in the queue belong to their slots
+  while (tdListPopHead(pPool->queue) != NULL) {
+  }
+  pPool->queue = tdListFree(pPool->queue);
+
+  pthread_cond_destroy(&(pPool->readDone));
+  pthread_cond_destroy(&(pPool->queueNotEmpty));
+  pthread_mutex_destroy(&(pPool->lock));
+
+  tfree(pPool->threads);
+  pPool->nthreads = 0;
+}
+
+STsdbReadAhead *tsdbNewReadAhead() {
+  SReadAheadPool *pPool = &tsReadAheadPool;
+  if (pPool->nthreads <= 0 || pPool->stop) return NULL;
+
+  int             nslots = tsReadAheadDepth + 1;
+  STsdbReadAhead *pRa = calloc(1, sizeof(STsdbReadAhead) + sizeof(SReadAheadSlot) * nslots);
+  if (pRa == NULL) return NULL;
+
+  pRa->depth = tsReadAheadDepth;
+  pRa->nslots = nslots;
+
+  for (int i = 0; i < nslots; i++) {
+    SReadAheadSlot *pSlot = pRa->slots + i;
+    pSlot->fd = -1;
+    pSlot->pNode = (SListNode *)calloc(1, sizeof(SListNode) + sizeof(SReadAheadSlot *));
+    if (pSlot->pNode == NULL) {
+      tsdbFreeReadAhead(pRa);
+      return NULL;
+    }
+    *(SReadAheadSlot **)(pSlot->pNode->data) = pSlot;
+  }
+
+  return pRa;
+}
+
+void tsdbFreeReadAhead(STsdbReadAhead *pRa) {
+  if (pRa == NULL) return;
+
+  tsdbReadAheadClear(pRa);
+  for (int i = 0; i < pRa->nslots; i++) {
+    taosTZfree(pRa->slots[i].pBuf);
+    taosTZfree(pRa->slots[i].colIds);
+    taosTZfree(pRa->slots[i].ranges);
+    tfree(pRa->slots[i].pNode);
+  }
+
+  tsdbTrace("read-ahead %p is freed, hits:%" PRId64 " misses:%" PRId64, pRa, pRa->hits, pRa->misses);
+  free(pRa);
+}
+
+int tsdbReadAheadDepth(STsdbReadAhead *pRa) { return (pRa == NULL) ? 0 : pRa->depth; }
+
+/**
+ * Submit the block at [offset, offset + len) of the file to read ahead. Only its statis part and the parts of the
+ * columns in colIds, which are in ascending order, are read.
+ */
+void tsdbReadAheadSubmit(STsdbReadAhead *pRa, int fd, int64_t offset, int32_t len, int16_t numOfCols, int32_t keyLen,
+                         int16_t *colIds, int ncolIds) {
+  if (pRa == NULL || len <= 0 || ncolIds <= 0) return;
+
+  SReadAheadPool *pPool = &tsReadAheadPool;
+
+  pthread_mutex_lock(&(pPool->lock));
+  for (int i = 0; i < pRa->nslots; i++) {
+    SReadAheadSlot *pSlot = pRa->slots + i;
+    if (pSlot->state != RA_SLOT_EMPTY && pSlot->fd == fd && pSlot->offset == offset && pSlot->len == len) {
+      pthread_mutex_unlock(&(pPool->lock));
+      return;
+    }
+  }
+
+  SReadAheadSlot *pSlot = pRa->slots + pRa->next;
+  pRa->next = (pRa->next + 1) % pRa->nslots;
+  tsdbReleaseReadAheadSlot(pPool, pSlot);
+  pthread_mutex_unlock(&(pPool->lock));
+
+  // an empty slot is not touched by the threads
+  if (tsdbMakeRoom((void **)(&(pSlot->colIds)), sizeof(int16_t) * ncolIds) < 0) return;
+  if (tsdbMakeRoom((void **)(&(pSlot->ranges)), sizeof(SReadAheadRange) * (ncolIds + 1)) < 0) return;
+  memcpy(pSlot->colIds, colIds, sizeof(int16_t) * ncolIds);
+
+  pthread_mutex_lock(&(pPool->lock));
+  if (pPool->stop) {
+    pthread_mutex_unlock(&(pPool->lock));
+    return;
+  }
+
+  pSlot->fd = fd;
+  pSlot->offset = offset;
+  pSlot->len = len;
+  pSlot->numOfCols = numOfCols;
+  pSlot->keyLen = keyLen;
+  pSlot->ncolIds = ncolIds;
+  pSlot->nranges = 0;
+  pSlot->state = RA_SLOT_QUEUED;
+  tdListAppendNode(pPool->queue, pSlot->pNode);
+  pthread_cond_signal(&(pPool->queueNotEmpty));
+  pthread_mutex_unlock(&(pPool->lock));
+}
+
+/**
+ * Take the bytes [offset, offset + len) of the file from a block read ahead. Return 1 and set *ppBuf to the bytes
+ * if they are there, 0 if the reader has to read them itself. The bytes are valid until the next submit or clear.
+ */
+int tsdbReadAheadGet(STsdbReadAhead *pRa, int fd, int64_t offset, int32_t len, void **ppBuf) {
+  if (pRa == NULL) return 0;
+
+  SReadAheadPool *pPool = &tsReadAheadPool;
+  SReadAheadSlot *pSlot = NULL;
+
+  pthread_mutex_lock(&(pPool->lock));
+  for (int i = 0; i < pRa->nslots; i++) {
+    SReadAheadSlot *pIter = pRa->slots + i;
+    if (pIter->state != RA_SLOT_EMPTY && pIter->fd == fd && offset >= pIter->offset &&
+        offset + len <= pIter->offset + pIter->len) {
+      pSlot = pIter;
+      break;
+    }
+  }
+
+  if (pSlot == NULL) {
+    pRa->misses++;
+    pthread_mutex_unlock(&(pPool->lock));
+    return 0;
+  }
+
+  if (pSlot->state == RA_SLOT_QUEUED) {
+    // the threads are busy, the reader reads the block now instead of waiting for them
+    tdListPopNode(pPool->queue, pSlot->pNode);
+    tsdbDoReadAheadSlot(pPool, pSlot);
+  }
+
+  while (pSlot->state == RA_SLOT_READING) {
+    pthread_cond_wait(&(pPool->readDone), &(pPool->lock));
+  }
+
+  // a failed block is read again by the reader, which reports the error
+  int ret = 0;
+  if (pSlot->state == RA_SLOT_DONE) {
+    int64_t rel = offset - pSlot->offset;
+    for (int i = 0; i < pSlot->nranges; i++) {
+      SReadAheadRange *pRange = pSlot->ranges + i;
+      if (rel >= pRange->offset && rel + len <= pRange->offset + pRange->len) {
+        *ppBuf = POINTER_SHIFT(pSlot->pBuf, pRange->pos + (rel - pRange->offset));
+        ret = 1;
+        break;
+      }
+    }
+  }
+
+  if (ret) {
+    pRa->hits++;
+  } else {
+    pRa->misses++;
+  }
+
+  pthread_mutex_unlock(&(pPool->lock));
+  return ret;
+}
+
+// Drop all the blocks, before the files they are read from are closed.
+void tsdbReadAheadClear(STsdbReadAhead *pRa) {
+  if (pRa == NULL) return;
+
+  SReadAheadPool *pPool = &tsReadAheadPool;
+
+  pthread_mutex_lock(&(pPool->lock));
+  for (int i = 0; i < pRa->nslots; i++) {
+    tsdbReleaseReadAheadSlot(pPool, pRa->slots + i);
+  }
+  pRa->next = 0;
+  pthread_mutex_unlock(&(pPool->lock));
+}
+
+static void *tsdbLoopReadAhead(void *arg) {
+  SReadAheadPool *pPool = &tsReadAheadPool;
+
+  setThreadName("tsdbReadAhead");
+
+  pthread_mutex_lock(&(pPool->lock));
+  while (true) {
+    while (!pPool->stop && isListEmpty(pPool->queue)) {
+      pthread_cond_wait(&(pPool->queueNotEmpty), &(pPool->lock));
+    }
+
+    if (pPool->stop) break;
+
+    SListNode *pNode = tdListPopHead(pPool->queue);
+    tsdbDoReadAheadSlot(pPool, *(SReadAheadSlot **)(pNode->data));
+  }
+  pthread_mutex_unlock(&(pPool->lock));
+
+  return NULL;
+}
+
+// Called with the lock held and the slot out of the queue, the lock is released during the read.
+static void tsdbDoReadAheadSlot(SReadAheadPool *pPool, SReadAheadSlot *pSlot) {
+  pSlot->state = RA_SLOT_READING;
+  pthread_mutex_unlock(&(pPool->lock));
+
+  int code = tsdbReadAheadBlockCols(pSlot);
+
+  pthread_mutex_lock(&(pPool->lock));
+  pSlot->state = (code == 0) ? RA_SLOT_DONE : RA_SLOT_FAILED;
+  pthread_cond_broadcast(&(pPool->readDone));
+}
+
+/**
+ * Read the statis part of the block, which tells where the columns are, then the parts of the columns to read. The
+ * parts close to each other are read at once. Nothing is reported here, a failed block is read by the reader.
+ */
+static int tsdbReadAheadBlockCols(SReadAheadSlot *pSlot) {
+  int32_t statisSize = (int32_t)TSDB_BLOCK_STATIS_SIZE(pSlot->numOfCols);
+
+  pSlot->nranges = 0;
+  if (statisSize > pSlot->len) return -1;
+  if (tsdbMakeRoom(&(pSlot->pBuf), statisSize) < 0) return -1;
+  if (taosPRead(pSlot->fd, pSlot->pBuf, statisSize, pSlot->offset) != statisSize) return -1;
+  if (!taosCheckChecksumWhole((uint8_t *)(pSlot->pBuf), (uint32_t)statisSize)) return -1;
+
+  SBlockData *     pBlkData = (SBlockData *)(pSlot->pBuf);
+  SReadAheadRange *ranges = pSlot->ranges;
+  int              nranges = 0;
+  int              ccol = 0;
+
+  ranges[nranges++] = (SReadAheadRange){.offset = 0, .len = statisSize, .pos = 0};
+  for (int i = 0; i < pSlot->ncolIds; i++) {
+    int16_t          colId = pSlot->colIds[i];
+    SReadAheadRange *pRange = ranges + nranges;
+
+    if (colId == 0) {  // the key column
+      pRange->offset = statisSize + TSDB_KEY_COL_OFFSET;
+      pRange->len = pSlot->keyLen;
+    } else {
+      while (ccol < pSlot->numOfCols && pBlkData->cols[ccol].colId < colId) ccol++;
+      if (ccol >= pSlot->numOfCols || pBlkData->cols[ccol].colId != colId) continue;
+
+      pRange->offset = statisSize + tsdbGetBlockColOffset(pBlkData->cols + ccol);
+      pRange->len = pBlkData->cols[ccol].len;
+    }
+
+    if (pRange->len <= 0) continue;
+    if ((int64_t)pRange->offset + pRange->len > pSlot->len) return -1;
+    nranges++;
+  }
+
+  qsort(ranges + 1, nranges - 1, sizeof(SReadAheadRange), tsdbCompareReadAheadRange);
+
+  // merge the ranges, the first one always holds the statis part
+  int     nmerged = 1;
+  int32_t size = statisSize;
+  for (int i = 1; i < nranges; i++) {
+    SReadAheadRange *pLast = ranges + nmerged - 1;
+    int32_t          end = pLast->offset + pLast->len;
+
+    if (ranges[i].offset <= end + TSDB_READ_AHEAD_MAX_GAP) {
+      if (ranges[i].offset + ranges[i].len > end) {
+        size += ranges[i].offset + ranges[i].len - end;
+        pLast->len = ranges[i].offset + ranges[i].len - pLast->offset;
+      }
+    } else {
+      ranges[nmerged] = ranges[i];
+      ranges[nmerged].pos = size;
+      size += ranges[i].len;
+      nmerged++;
+    }
+  }
+
+  if (tsdbMakeRoom(&(pSlot->pBuf), size) < 0) return -1;
+
+  for (int i = 0; i < nmerged; i++) {
+    int32_t skip = (i == 0) ? statisSize : 0;  // the statis part is there already
+    int32_t rlen = ranges[i].len - skip;
+
+    if (rlen <= 0) continue;
+    if (taosPRead(pSlot->fd, POINTER_SHIFT(pSlot->pBuf, ranges[i].pos + skip), rlen,
+                  pSlot->offset + ranges[i].offset + skip) != rlen) {
+      return -1;
+    }
+  }
+
+  pSlot->nranges = nmerged;
+  return 0;
+}
+
+static int tsdbCompareReadAheadRange(const void *a, const void *b) {
+  int32_t offset1 = ((SReadAheadRange *)a)->offset;
+  int32_t offset2 = ((SReadAheadRange *)b)->offset;
+
+  if (offset1 < offset2) return -1;
+  if (offset1 > offset2) return 1;
+  return 0;
+}
+
+static void tsdbReleaseReadAheadSlot(SReadAheadPool *pPool, SReadAheadSlot *pSlot) {
+  if (pSlot->state == RA_SLOT_QUEUED) {
+    tdListPopNode(pPool->queue, pSlot->pNode);
+  }
+
+  while (pSlot->state == RA_SLOT_READING) {
+    pthread_cond_wait(&(pPool->readDone), &(pPool->lock));
+  }
+
+  pSlot->state = RA_SLOT_EMPTY;
+  pSlot->fd = -1;
+}
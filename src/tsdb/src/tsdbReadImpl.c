@@ -15,16 +15,16 @@
 
 #include "tsdbint.h"
 
-#define TSDB_KEY_COL_OFFSET 0
-
 static void tsdbResetReadTable(SReadH *pReadh);
 static void tsdbResetReadFile(SReadH *pReadh);
 static int  tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols);
 static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                         int maxPoints, char *buffer, int bufferSize);
+                                         int numOfNull, int maxPoints, char *buffer, int bufferSize);
 static int  tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols, int16_t *colIds,
                                       int numOfColIds);
 static int  tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol);
+static int  tsdbDecodeColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol,
+                              void *content, int64_t offset);
 
 int tsdbInitReadH(SReadH *pReadh, STsdbRepo *pRepo) {
   ASSERT(pReadh != NULL && pRepo != NULL);
@@ -68,10 +68,17 @@ void tsdbDestroyReadH(SReadH *pReadh) {
   pReadh->pDCols[1] = tdFreeDataCols(pReadh->pDCols[1]);
   pReadh->pBlkData = taosTZfree(pReadh->pBlkData);
   pReadh->pBlkInfo = taosTZfree(pReadh->pBlkInfo);
+  pReadh->pBlkFilter = taosTZfree(pReadh->pBlkFilter);
   pReadh->cidx = 0;
   pReadh->pBlkIdx = NULL;
   pReadh->pTable = NULL;
   pReadh->aBlkIdx = taosArrayDestroy(pReadh->aBlkIdx);
+  if (pReadh->pIdxItem) {
+    tsdbReleaseBlkIdx(pReadh->pRepo, pReadh->pIdxItem);
+    pReadh->pIdxItem = NULL;
+  }
+  tsdbFreeReadAhead(pReadh->pRa);
+  pReadh->pRa = NULL;
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
   pReadh->pRepo = NULL;
 }
@@ -97,11 +104,18 @@ int tsdbLoadBlockIdx(SReadH *pReadh) {
   SDFile *  pHeadf = TSDB_READ_HEAD_FILE(pReadh);
   SBlockIdx blkIdx;
 
-  ASSERT(taosArrayGetSize(pReadh->aBlkIdx) == 0);
+  ASSERT(taosArrayGetSize(pReadh->aBlkIdx) == 0 && pReadh->pIdxItem == NULL);
 
   // No data at all, just return
   if (pHeadf->info.offset <= 0) return 0;
 
+  if (pReadh->cacheIdx && pReadh->pRepo->idxCache != NULL) {
+    pReadh->pIdxItem = tsdbAcquireBlkIdx(pReadh->pRepo, TSDB_READ_FSET(pReadh));
+    if (pReadh->pIdxItem != NULL) return 0;
+    tsdbWarn("vgId:%d failed to get block index of file %s from cache since %s, read it from file",
+             TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno));
+  }
+
   if (tsdbSeekDFile(pHeadf, pHeadf->info.offset, SEEK_SET) < 0) {
     tsdbError("vgId:%d failed to load SBlockIdx part while seek file %s since %s, offset:%u len :%u",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), pHeadf->info.offset,
@@ -167,6 +181,11 @@ int tsdbSetReadTable(SReadH *pReadh, STable *pTable) {
     return -1;
   }
 
+  if (pReadh->pIdxItem != NULL) {
+    pReadh->pBlkIdx = tsdbSearchBlkIdx(pReadh->pIdxItem, pTable);
+    return 0;
+  }
+
   size_t size = taosArrayGetSize(pReadh->aBlkIdx);
   if (size > 0) {
     while (true) {
@@ -204,6 +223,25 @@ int tsdbLoadBlockInfo(SReadH *pReadh, void *pTarget) {
   SDFile *   pHeadf = TSDB_READ_HEAD_FILE(pReadh);
   SBlockIdx *pBlkIdx = pReadh->pBlkIdx;
 
+  if (pReadh->pIdxItem != NULL) {
+    // Copy it from the mapped head file, the checksum is only checked the first time
+    SBlockInfo *pSrc = tsdbGetBlkInfoFromIdx(pReadh->pIdxItem, pBlkIdx);
+    if (pSrc == NULL) {
+      tsdbError("vgId:%d SBlockInfo part in file %s is corrupted, offset:%u len :%u", TSDB_READ_REPO_ID(pReadh),
+                TSDB_FILE_FULL_NAME(pHeadf), pBlkIdx->offset, pBlkIdx->len);
+      return -1;
+    }
+
+    ASSERT(pBlkIdx->tid == pSrc->tid && pBlkIdx->uid == pSrc->uid);
+
+    if (pTarget == NULL) {
+      if (tsdbMakeRoom((void **)(&(pReadh->pBlkInfo)), pBlkIdx->len) < 0) return -1;
+      pTarget = pReadh->pBlkInfo;
+    }
+    memcpy(pTarget, (void *)pSrc, pBlkIdx->len);
+    return 0;
+  }
+
   if (tsdbSeekDFile(pHeadf, pBlkIdx->offset, SEEK_SET) < 0) {
     tsdbError("vgId:%d failed to load SBlockInfo part while seek file %s since %s, offset:%u len:%u",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), pBlkIdx->offset, pBlkIdx->len);
@@ -300,17 +338,25 @@ int tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock) {
   ASSERT(pBlock->numOfSubBlocks <= 1);
 
   SDFile *pDFile = (pBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+  size_t  size = TSDB_BLOCK_STATIS_SIZE(pBlock->numOfCols);
+  void *  pRaBuf = NULL;
 
-  if (tsdbSeekDFile(pDFile, pBlock->offset, SEEK_SET) < 0) {
-    tsdbError("vgId:%d failed to load block statis part while seek file %s to offset %" PRId64 " since %s",
-              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset, tstrerror(terrno));
-    return -1;
-  }
-
-  size_t size = TSDB_BLOCK_STATIS_SIZE(pBlock->numOfCols);
+  pReadh->statisKey = 0;
   if (tsdbMakeRoom((void **)(&(pReadh->pBlkData)), size) < 0) return -1;
 
-  int64_t nread = tsdbReadDFile(pDFile, (void *)(pReadh->pBlkData), size);
+  int64_t nread = 0;
+  if (tsdbReadAheadGet(pReadh->pRa, TSDB_FILE_FD(pDFile), pBlock->offset, (int32_t)size, &pRaBuf) > 0) {
+    memcpy(pReadh->pBlkData, pRaBuf, size);
+    nread = size;
+  } else {
+    if (tsdbSeekDFile(pDFile, pBlock->offset, SEEK_SET) < 0) {
+      tsdbError("vgId:%d failed to load block statis part while seek file %s to offset %" PRId64 " since %s",
+                TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset, tstrerror(terrno));
+      return -1;
+    }
+
+    nread = tsdbReadDFile(pDFile, (void *)(pReadh->pBlkData), size);
+  }
   if (nread < 0) {
     tsdbError("vgId:%d failed to load block statis part while read file %s since %s, offset:%" PRId64 " len :%" PRIzu,
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), (int64_t)pBlock->offset, size);
@@ -332,6 +378,67 @@ int tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock) {
     return -1;
   }
 
+  pReadh->statisKey = TSDB_BLOCK_KEY(pBlock);
+  return 0;
+}
+
+int tsdbLoadBlockFilter(SReadH *pReadh, SBlock *pBlock, int16_t colId, SBlockFilter **ppFilter) {
+  ASSERT(pBlock->numOfSubBlocks <= 1);
+
+  SDFile *pDFile = (pBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+  int64_t key = TSDB_BLOCK_KEY(pBlock);
+
+  *ppFilter = NULL;
+
+  if (pReadh->filterKey == key && pReadh->filterColId == colId) {
+    *ppFilter = pReadh->pBlkFilter;
+    return 0;
+  }
+
+  if (pReadh->statisKey != key && tsdbLoadBlockStatis(pReadh, pBlock) < 0) return -1;
+
+  // The filters follow the block data in the order of the columns
+  SBlockData *pBlockData = pReadh->pBlkData;
+  int64_t     offset = pBlock->offset + pBlock->len;
+  SBlockCol * pBlockCol = NULL;
+  for (int i = 0; i < pBlockData->numOfCols; i++) {
+    if (pBlockData->cols[i].colId == colId) {
+      pBlockCol = pBlockData->cols + i;
+      break;
+    }
+    if (pBlockData->cols[i].bfBits > 0) offset += TSDB_BLOCK_FILTER_SIZE(pBlockData->cols[i].bfBits);
+  }
+
+  if (pBlockCol == NULL || pBlockCol->bfBits == 0) return 0;
+
+  uint32_t size = TSDB_BLOCK_FILTER_SIZE(pBlockCol->bfBits);
+  pReadh->filterKey = 0;
+  if (tsdbMakeRoom((void **)(&(pReadh->pBlkFilter)), size) < 0) return -1;
+
+  if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) {
+    tsdbError("vgId:%d failed to load block filter while seek file %s to offset %" PRId64 " since %s",
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), offset, tstrerror(terrno));
+    return -1;
+  }
+
+  int64_t nread = tsdbReadDFile(pDFile, (void *)(pReadh->pBlkFilter), size);
+  if (nread < 0) {
+    tsdbError("vgId:%d failed to load block filter while read file %s since %s, offset:%" PRId64 " len :%u",
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), offset, size);
+    return -1;
+  }
+
+  if (nread < size || !taosCheckChecksumWhole((uint8_t *)(pReadh->pBlkFilter), size) ||
+      pReadh->pBlkFilter->bits != pBlockCol->bfBits) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d block filter in file %s is corrupted, offset:%" PRId64 " len :%u", TSDB_READ_REPO_ID(pReadh),
+              TSDB_FILE_FULL_NAME(pDFile), offset, size);
+    return -1;
+  }
+
+  pReadh->filterKey = key;
+  pReadh->filterColId = colId;
+  *ppFilter = pReadh->pBlkFilter;
   return 0;
 }
 
@@ -406,8 +513,15 @@ static void tsdbResetReadTable(SReadH *pReadh) {
 }
 
 static void tsdbResetReadFile(SReadH *pReadh) {
+  pReadh->statisKey = 0;
+  pReadh->filterKey = 0;
   tsdbResetReadTable(pReadh);
   taosArrayClear(pReadh->aBlkIdx);
+  if (pReadh->pIdxItem) {
+    tsdbReleaseBlkIdx(pReadh->pRepo, pReadh->pIdxItem);
+    pReadh->pIdxItem = NULL;
+  }
+  tsdbReadAheadClear(pReadh->pRa);
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
 }
 
@@ -471,12 +585,14 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
     int16_t  tcolId = 0;
     uint32_t toffset = TSDB_KEY_COL_OFFSET;
     int32_t  tlen = pBlock->keyLen;
+    int16_t  numOfNull = 0;
 
     if (dcol != 0) {
       SBlockCol *pBlockCol = &(pBlockData->cols[ccol]);
       tcolId = pBlockCol->colId;
       toffset = tsdbGetBlockColOffset(pBlockCol);
       tlen = pBlockCol->len;
+      numOfNull = pBlockCol->numOfNull;
     } else {
       ASSERT(pDataCol->colId == tcolId);
     }
@@ -488,7 +604,7 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
       }
 
       if (tsdbCheckAndDecodeColumnData(pDataCol, POINTER_SHIFT(pBlockData, tsize + toffset), tlen, pBlock->algorithm,
-                                       pBlock->numOfRows, pDataCols->maxPoints, TSDB_READ_COMP_BUF(pReadh),
+                                       pBlock->numOfRows, numOfNull, pDataCols->maxPoints, TSDB_READ_COMP_BUF(pReadh),
                                        (int)taosTSizeof(TSDB_READ_COMP_BUF(pReadh))) < 0) {
         tsdbError("vgId:%d file %s is broken at column %d block offset %" PRId64 " column offset %u",
                   TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tcolId, (int64_t)pBlock->offset, toffset);
@@ -512,7 +628,7 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
 }
 
 static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                        int maxPoints, char *buffer, int bufferSize) {
+                                        int numOfNull, int maxPoints, char *buffer, int bufferSize) {
   if (!taosCheckChecksumWhole((uint8_t *)content, len)) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
     return -1;
@@ -541,6 +657,13 @@ static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32
   if (IS_VAR_DATA_TYPE(pDataCol->type)) {
     dataColSetOffset(pDataCol, numOfRows);
   }
+
+  // the block statistics tell if the NULL values have to be searched for
+  if (numOfNull == 0) {
+    tdBitmapSetRange(pDataCol->pBitmap, 0, numOfRows, true);
+  } else {
+    tdBitmapFromData(pDataCol->pBitmap, pDataCol->pData, pDataCol->dataOff, pDataCol->type, numOfRows);
+  }
   return 0;
 }
 
@@ -624,14 +747,17 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
 static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol) {
   ASSERT(pDataCol->colId == pBlockCol->colId);
 
-  STsdbRepo *pRepo = TSDB_READ_REPO(pReadh);
-  STsdbCfg * pCfg = REPO_CFG(pRepo);
-  int        tsize = pDataCol->bytes * pBlock->numOfRows + COMP_OVERFLOW_BYTES;
+  int tsize = pDataCol->bytes * pBlock->numOfRows + COMP_OVERFLOW_BYTES;
 
-  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pBlockCol->len) < 0) return -1;
   if (tsdbMakeRoom((void **)(&TSDB_READ_COMP_BUF(pReadh)), tsize) < 0) return -1;
 
   int64_t offset = pBlock->offset + TSDB_BLOCK_STATIS_SIZE(pBlock->numOfCols) + tsdbGetBlockColOffset(pBlockCol);
+  void *  content = NULL;
+  if (tsdbReadAheadGet(pReadh->pRa, TSDB_FILE_FD(pDFile), offset, pBlockCol->len, &content) > 0) {
+    return tsdbDecodeColData(pReadh, pDFile, pBlock, pBlockCol, pDataCol, content, offset);
+  }
+
+  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pBlockCol->len) < 0) return -1;
   if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) {
     tsdbError("vgId:%d failed to load block column data while seek file %s to offset %" PRId64 " since %s",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), offset, tstrerror(terrno));
@@ -653,8 +779,16 @@ static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBloc
     return -1;
   }
 
-  if (tsdbCheckAndDecodeColumnData(pDataCol, pReadh->pBuf, pBlockCol->len, pBlock->algorithm, pBlock->numOfRows,
-                                   pCfg->maxRowsPerFileBlock, pReadh->pCBuf, (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
+  return tsdbDecodeColData(pReadh, pDFile, pBlock, pBlockCol, pDataCol, TSDB_READ_BUF(pReadh), offset);
+}
+
+static int tsdbDecodeColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol,
+                             void *content, int64_t offset) {
+  STsdbRepo *pRepo = TSDB_READ_REPO(pReadh);
+  STsdbCfg * pCfg = REPO_CFG(pRepo);
+
+  if (tsdbCheckAndDecodeColumnData(pDataCol, content, pBlockCol->len, pBlock->algorithm, pBlock->numOfRows,
+                                   pBlockCol->numOfNull, pCfg->maxRowsPerFileBlock, pReadh->pCBuf, (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
     tsdbError("vgId:%d file %s is broken at column %d offset %" PRId64, REPO_ID(pRepo), TSDB_FILE_FULL_NAME(pDFile),
               pBlockCol->colId, offset);
     return -1;
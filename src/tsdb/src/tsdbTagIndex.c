@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+#include "ttype.h"
+
+#define TSDB_TAG_INDEX_SL_LEVEL 5
+
+typedef struct {
+  SArray *ids;    // ids of the tables with the value, in no order
+  char    key[];  // the value, as it is in the tag row
+} STagPosting;
+
+typedef struct {
+  int16_t    colId;
+  int8_t     type;
+  int16_t    bytes;
+  SHashObj * pHash;    // value -> STagPosting *
+  SSkipList *pList;    // STagPosting * in the order of the values
+  SArray *   missing;  // ids of the tables without a value of the tag in their tag row
+  SArray *   pos;      // int32_t by id, the position of the id in the ids of its posting or in missing
+} STagColIndex;
+
+struct STagIndex {
+  SArray *cols;     // STagColIndex, in the order of the tag schema
+  SArray *pTables;  // STable * by id, NULL for a free id
+  SArray *freeIds;
+  bool    invalid;  // a table failed to be added, the index does not answer anymore
+};
+
+static char *        tsdbGetTagPostingKey(const void *pData);
+static int           tsdbInitTagColIndex(STagColIndex *pCol, STColumn *pTCol);
+static void          tsdbDestroyTagColIndex(STagColIndex *pCol);
+static int           tsdbTagColIndexAdd(STagColIndex *pCol, SKVRow tagVal, int32_t id);
+static void          tsdbTagColIndexRemove(STagColIndex *pCol, SKVRow tagVal, int32_t id);
+static STagColIndex *tsdbGetTagColIndex(STagIndex *pIndex, int16_t colId);
+static const char *  tsdbTagColIndexKey(STagColIndex *pCol, const char *val, size_t *len);
+static STagPosting * tsdbGetTagPosting(STagColIndex *pCol, const char *val);
+static bool          tsdbSetKeyToTagVal(int8_t type, const void *key, char *val);
+static int           tsdbAddTagIndexId(STagColIndex *pCol, SArray *ids, int32_t id);
+static void          tsdbRemoveTagIndexId(STagColIndex *pCol, SArray *ids, int32_t id);
+static void          tsdbSetTagIndexIds(SArray *ids, uint8_t *bitmap);
+
+STagIndex *tsdbNewTagIndex(STSchema *pTagSchema) {
+  STagIndex *pIndex = (STagIndex *)calloc(1, sizeof(*pIndex));
+  if (pIndex == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pIndex->cols = taosArrayInit(schemaNCols(pTagSchema), sizeof(STagColIndex));
+  pIndex->pTables = taosArrayInit(64, sizeof(STable *));
+  pIndex->freeIds = taosArrayInit(8, sizeof(int32_t));
+  if (pIndex->cols == NULL || pIndex->pTables == NULL || pIndex->freeIds == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbFreeTagIndex(pIndex);
+    return NULL;
+  }
+
+  if (tsdbTagIndexSetSchema(pIndex, pTagSchema) < 0) {
+    tsdbFreeTagIndex(pIndex);
+    return NULL;
+  }
+
+  return pIndex;
+}
+
+void tsdbFreeTagIndex(STagIndex *pIndex) {
+  if (pIndex == NULL) return;
+
+  for (size_t i = 0; i < taosArrayGetSize(pIndex->cols); i++) {
+    tsdbDestroyTagColIndex(taosArrayGet(pIndex->cols, i));
+  }
+
+  taosArrayDestroy(pIndex->cols);
+  taosArrayDestroy(pIndex->pTables);
+  taosArrayDestroy(pIndex->freeIds);
+  free(pIndex);
+}
+
+/**
+ * Make the columns of the index follow a new tag schema. The columns kept as they are keep their postings, the new
+ * ones are built from the tag values of the tables in the index.
+ */
+int tsdbTagIndexSetSchema(STagIndex *pIndex, STSchema *pTagSchema) {
+  SArray *cols = taosArrayInit(schemaNCols(pTagSchema), sizeof(STagColIndex));
+  if (cols == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  for (int i = 0; i < schemaNCols(pTagSchema); i++) {
+    STColumn *   pTCol = schemaColAt(pTagSchema, i);
+    STagColIndex col = {0};
+
+    STagColIndex *pOld = tsdbGetTagColIndex(pIndex, colColId(pTCol));
+    if (pOld != NULL && pOld->type == colType(pTCol) && pOld->bytes == colBytes(pTCol)) {
+      col = *pOld;
+      pOld->pHash = NULL;  // moved to the new columns, only the column id is left
+      pOld->pList = NULL;
+      pOld->missing = NULL;
+      pOld->pos = NULL;
+      taosArrayPush(cols, &col);
+      continue;
+    }
+
+    if (tsdbInitTagColIndex(&col, pTCol) < 0) goto _err;
+    taosArrayPush(cols, &col);
+
+    for (int32_t id = 0; id < taosArrayGetSize(pIndex->pTables); id++) {
+      STable *pTable = taosArrayGetP(pIndex->pTables, id);
+      if (pTable == NULL) continue;
+      if (tsdbTagColIndexAdd(taosArrayGetLast(cols), pTable->tagVal, id) < 0) goto _err;
+    }
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pIndex->cols); i++) {
+    tsdbDestroyTagColIndex(taosArrayGet(pIndex->cols, i));
+  }
+  taosArrayDestroy(pIndex->cols);
+  pIndex->cols = cols;
+
+  return 0;
+
+_err:
+  // give back the columns moved and free the ones built
+  for (size_t i = 0; i < taosArrayGetSize(cols); i++) {
+    STagColIndex *pCol = taosArrayGet(cols, i);
+    bool          moved = false;
+    for (size_t j = 0; j < taosArrayGetSize(pIndex->cols); j++) {
+      STagColIndex *pOld = taosArrayGet(pIndex->cols, j);
+      if (pOld->colId == pCol->colId && pOld->pHash == NULL) {
+        *pOld = *pCol;
+        moved = true;
+        break;
+      }
+    }
+    if (!moved) tsdbDestroyTagColIndex(pCol);
+  }
+  taosArrayDestroy(cols);
+  return -1;
+}
+
+int tsdbTagIndexAdd(STagIndex *pIndex, STable *pTable) {
+  int32_t id = -1;
+  if (taosArrayGetSize(pIndex->freeIds) > 0) {
+    id = *(int32_t *)taosArrayPop(pIndex->freeIds);
+    taosArraySet(pIndex->pTables, id, &pTable);
+  } else {
+    id = (int32_t)taosArrayGetSize(pIndex->pTables);
+    if (taosArrayPush(pIndex->pTables, &pTable) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _err;
+    }
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pIndex->cols); i++) {
+    if (tsdbTagColIndexAdd(taosArrayGet(pIndex->cols, i), pTable->tagVal, id) < 0) {
+      for (size_t j = 0; j < i; j++) {
+        tsdbTagColIndexRemove(taosArrayGet(pIndex->cols, j), pTable->tagVal, id);
+      }
+
+      STable *pNull = NULL;
+      taosArraySet(pIndex->pTables, id, &pNull);
+      taosArrayPush(pIndex->freeIds, &id);
+      goto _err;
+    }
+  }
+
+  pTable->tagIndexId = id;
+  return 0;
+
+_err:
+  tsdbWarn("table %s is not added to the tag index since %s, tag conditions of its super table are not indexed",
+           TABLE_CHAR_NAME(pTable), tstrerror(terrno));
+  pIndex->invalid = true;
+  return -1;
+}
+
+// Called before the tag values of the table change, the postings of the table are found by them.
+void tsdbTagIndexRemove(STagIndex *pIndex, STable *pTable) {
+  int32_t id = pTable->tagIndexId;
+  if (id < 0) return;
+
+  ASSERT(taosArrayGetP(pIndex->pTables, id) == pTable);
+  for (size_t i = 0; i < taosArrayGetSize(pIndex->cols); i++) {
+    tsdbTagColIndexRemove(taosArrayGet(pIndex->cols, i), pTable->tagVal, id);
+  }
+
+  STable *pNull = NULL;
+  taosArraySet(pIndex->pTables, id, &pNull);
+  taosArrayPush(pIndex->freeIds, &id);
+  pTable->tagIndexId = -1;
+}
+
+int32_t tsdbTagIndexCapacity(STagIndex *pIndex) { return (int32_t)taosArrayGetSize(pIndex->pTables); }
+
+STable *tsdbTagIndexGetTable(STagIndex *pIndex, int32_t id) { return taosArrayGetP(pIndex->pTables, id); }
+
+/**
+ * Set in the bitmap the ids of the tables whose value of the tag passes fp. The equality and IN are answered by the
+ * hash and the ranges walk the distinct values from the bound, other conditions test all the distinct values. Return
+ * -1 if the tag is not in the index, or not all the tables are.
+ */
+int tsdbTagIndexMatch(STagIndex *pIndex, SSchema *pSchema, uint8_t optr, const char *q, __tag_val_filter_fn_t fp,
+                      void *param, uint8_t *bitmap) {
+  if (pIndex->invalid) return -1;
+
+  STagColIndex *pCol = tsdbGetTagColIndex(pIndex, pSchema->colId);
+  if (pCol == NULL || pCol->type != pSchema->type) return -1;
+
+  // the float values are compared with a tolerance, they are not looked up or walked from a bound
+  bool isFloat = IS_FLOAT_TYPE(pCol->type);
+
+  if (optr == TSDB_RELATION_EQUAL && !isFloat) {
+    STagPosting *pPost = tsdbGetTagPosting(pCol, q);
+    if (pPost != NULL) tsdbSetTagIndexIds(pPost->ids, bitmap);
+  } else if (optr == TSDB_RELATION_IN && !isFloat) {
+    SHashObj *pSet = (SHashObj *)q;
+    char      val[sizeof(int64_t)];
+
+    void *p = taosHashIterate(pSet, NULL);
+    while (p != NULL) {
+      STagPosting *pPost = NULL;
+      char *       key = taosHashGetDataKey(pSet, p);
+      if (IS_VAR_DATA_TYPE(pCol->type)) {
+        void *pp = taosHashGet(pCol->pHash, key, taosHashGetDataKeyLen(pSet, p));
+        pPost = (pp == NULL) ? NULL : *(STagPosting **)pp;
+      } else if (tsdbSetKeyToTagVal(pCol->type, key, val)) {
+        pPost = tsdbGetTagPosting(pCol, val);
+      }
+
+      if (pPost != NULL) tsdbSetTagIndexIds(pPost->ids, bitmap);
+      p = taosHashIterate(pSet, p);
+    }
+  } else {
+    SSkipListIterator *pIter = NULL;
+    if ((optr == TSDB_RELATION_GREATER || optr == TSDB_RELATION_GREATER_EQUAL) && !isFloat) {
+      pIter = tSkipListCreateIterFromVal(pCol->pList, q, pCol->type, TSDB_ORDER_ASC);
+    } else if ((optr == TSDB_RELATION_LESS || optr == TSDB_RELATION_LESS_EQUAL) && !isFloat) {
+      pIter = tSkipListCreateIterFromVal(pCol->pList, q, pCol->type, TSDB_ORDER_DESC);
+    } else {
+      pIter = tSkipListCreateIter(pCol->pList);
+    }
+
+    if (pIter == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    while (tSkipListIterNext(pIter)) {
+      STagPosting *pPost = (STagPosting *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      if ((*fp)(pPost->key, param)) tsdbSetTagIndexIds(pPost->ids, bitmap);
+    }
+    tSkipListDestroyIter(pIter);
+  }
+
+  // the values of a set are never missing
+  if (optr != TSDB_RELATION_IN && (*fp)(NULL, param)) {
+    tsdbSetTagIndexIds(pCol->missing, bitmap);
+  }
+
+  return 0;
+}
+
+// ------------------ LOCAL FUNCTIONS ------------------
+static char *tsdbGetTagPostingKey(const void *pData) { return ((STagPosting *)pData)->key; }
+
+static int tsdbInitTagColIndex(STagColIndex *pCol, STColumn *pTCol) {
+  pCol->colId = colColId(pTCol);
+  pCol->type = colType(pTCol);
+  pCol->bytes = colBytes(pTCol);
+  pCol->pHash = taosHashInit(256, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  // a value is put once, the hash finds it before
+  pCol->pList = tSkipListCreate(TSDB_TAG_INDEX_SL_LEVEL, colType(pTCol), (uint16_t)colBytes(pTCol), NULL,
+                                SL_ALLOW_DUP_KEY, tsdbGetTagPostingKey);
+  pCol->missing = taosArrayInit(4, sizeof(int32_t));
+  pCol->pos = taosArrayInit(64, sizeof(int32_t));
+  if (pCol->pHash == NULL || pCol->pList == NULL || pCol->missing == NULL || pCol->pos == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbDestroyTagColIndex(pCol);
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tsdbDestroyTagColIndex(STagColIndex *pCol) {
+  if (pCol->pHash != NULL) {
+    void *p = taosHashIterate(pCol->pHash, NULL);
+    while (p != NULL) {
+      STagPosting *pPost = *(STagPosting **)p;
+      taosArrayDestroy(pPost->ids);
+      free(pPost);
+      p = taosHashIterate(pCol->pHash, p);
+    }
+    taosHashCleanup(pCol->pHash);
+    pCol->pHash = NULL;
+  }
+
+  tSkipListDestroy(pCol->pList);
+  pCol->pList = NULL;
+  pCol->missing = taosArrayDestroy(pCol->missing);
+  pCol->pos = taosArrayDestroy(pCol->pos);
+}
+
+static int tsdbTagColIndexAdd(STagColIndex *pCol, SKVRow tagVal, int32_t id) {
+  const char *val = tdGetKVRowValOfCol(tagVal, pCol->colId);
+  if (val == NULL) {
+    return tsdbAddTagIndexId(pCol, pCol->missing, id);
+  }
+
+  STagPosting *pPost = tsdbGetTagPosting(pCol, val);
+  if (pPost == NULL) {
+    size_t vlen = IS_VAR_DATA_TYPE(pCol->type) ? varDataTLen(val) : pCol->bytes;
+    pPost = (STagPosting *)calloc(1, sizeof(STagPosting) + vlen);
+    if (pPost == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    memcpy(pPost->key, val, vlen);
+    pPost->ids = taosArrayInit(4, sizeof(int32_t));
+    if (pPost->ids == NULL) {
+      free(pPost);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    size_t      klen = 0;
+    const char *key = tsdbTagColIndexKey(pCol, pPost->key, &klen);
+    if (taosHashPut(pCol->pHash, key, klen, &pPost, sizeof(pPost)) < 0) {
+      taosArrayDestroy(pPost->ids);
+      free(pPost);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    if (tSkipListPut(pCol->pList, pPost) == NULL) {
+      taosHashRemove(pCol->pHash, key, klen);
+      taosArrayDestroy(pPost->ids);
+      free(pPost);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  return tsdbAddTagIndexId(pCol, pPost->ids, id);
+}
+
+static void tsdbTagColIndexRemove(STagColIndex *pCol, SKVRow tagVal, int32_t id) {
+  const char *val = tdGetKVRowValOfCol(tagVal, pCol->colId);
+  if (val == NULL) {
+    tsdbRemoveTagIndexId(pCol, pCol->missing, id);
+    return;
+  }
+
+  STagPosting *pPost = tsdbGetTagPosting(pCol, val);
+  if (pPost == NULL) return;
+
+  tsdbRemoveTagIndexId(pCol, pPost->ids, id);
+  if (taosArrayGetSize(pPost->ids) == 0) {
+    size_t      klen = 0;
+    const char *key = tsdbTagColIndexKey(pCol, pPost->key, &klen);
+    tSkipListRemove(pCol->pList, pPost->key);
+    taosHashRemove(pCol->pHash, key, klen);
+    taosArrayDestroy(pPost->ids);
+    free(pPost);
+  }
+}
+
+static STagColIndex *tsdbGetTagColIndex(STagIndex *pIndex, int16_t colId) {
+  for (size_t i = 0; i < taosArrayGetSize(pIndex->cols); i++) {
+    STagColIndex *pCol = taosArrayGet(pIndex->cols, i);
+    if (pCol->colId == colId && pCol->pHash != NULL) return pCol;
+  }
+
+  return NULL;
+}
+
+// the bytes of a value the hash is keyed by, without the length of a var type
+static const char *tsdbTagColIndexKey(STagColIndex *pCol, const char *val, size_t *len) {
+  if (IS_VAR_DATA_TYPE(pCol->type)) {
+    *len = varDataLen(val);
+    return varDataVal(val);
+  }
+
+  *len = pCol->bytes;
+  return val;
+}
+
+static STagPosting *tsdbGetTagPosting(STagColIndex *pCol, const char *val) {
+  size_t      klen = 0;
+  const char *key = tsdbTagColIndexKey(pCol, val, &klen);
+
+  void *p = taosHashGet(pCol->pHash, key, klen);
+  return (p == NULL) ? NULL : *(STagPosting **)p;
+}
+
+// A value of an IN set, an int64 or an uint64 by the sign of the tag, as a value of the tag. Return false if it is
+// out of the range of the tag.
+static bool tsdbSetKeyToTagVal(int8_t type, const void *key, char *val) {
+  int64_t  v = *(int64_t *)key;
+  uint64_t u = *(uint64_t *)key;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:
+    case TSDB_DATA_TYPE_TINYINT:
+      if (v < INT8_MIN || v > INT8_MAX) return false;
+      *(int8_t *)val = (int8_t)v;
+      return true;
+    case TSDB_DATA_TYPE_SMALLINT:
+      if (v < INT16_MIN || v > INT16_MAX) return false;
+      *(int16_t *)val = (int16_t)v;
+      return true;
+    case TSDB_DATA_TYPE_INT:
+      if (v < INT32_MIN || v > INT32_MAX) return false;
+      *(int32_t *)val = (int32_t)v;
+      return true;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP:
+      *(int64_t *)val = v;
+      return true;
+    case TSDB_DATA_TYPE_UTINYINT:
+      if (u > UINT8_MAX) return false;
+      *(uint8_t *)val = (uint8_t)u;
+      return true;
+    case TSDB_DATA_TYPE_USMALLINT:
+      if (u > UINT16_MAX) return false;
+      *(uint16_t *)val = (uint16_t)u;
+      return true;
+    case TSDB_DATA_TYPE_UINT:
+      if (u > UINT32_MAX) return false;
+      *(uint32_t *)val = (uint32_t)u;
+      return true;
+    case TSDB_DATA_TYPE_UBIGINT:
+      *(uint64_t *)val = u;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static int tsdbAddTagIndexId(STagColIndex *pCol, SArray *ids, int32_t id) {
+  int32_t none = -1;
+  while (taosArrayGetSize(pCol->pos) <= (size_t)id) {
+    if (taosArrayPush(pCol->pos, &none) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  if (taosArrayPush(ids, &id) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  *(int32_t *)taosArrayGet(pCol->pos, id) = (int32_t)taosArrayGetSize(ids) - 1;
+  return 0;
+}
+
+// The last id of the list takes the place of the one removed, so an id is found by its position in constant time
+static void tsdbRemoveTagIndexId(STagColIndex *pCol, SArray *ids, int32_t id) {
+  if ((size_t)id >= taosArrayGetSize(pCol->pos)) return;
+
+  int32_t *pPos = taosArrayGet(pCol->pos, id);
+  int32_t  pos = *pPos;
+  if (pos < 0 || (size_t)pos >= taosArrayGetSize(ids) || *(int32_t *)taosArrayGet(ids, pos) != id) return;
+
+  int32_t last = *(int32_t *)taosArrayGetLast(ids);
+  *(int32_t *)taosArrayGet(ids, pos) = last;
+  *(int32_t *)taosArrayGet(pCol->pos, last) = pos;
+  taosArrayPop(ids);
+  *pPos = -1;
+}
+
+static void tsdbSetTagIndexIds(SArray *ids, uint8_t *bitmap) {
+  size_t   size = taosArrayGetSize(ids);
+  int32_t *pIds = (int32_t *)TARRAY_GET_START(ids);
+  for (size_t i = 0; i < size; i++) {
+    tdBitmapSetTo(bitmap, pIds[i], true);
+  }
+}
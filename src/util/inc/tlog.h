@@ -41,6 +41,13 @@ void    taosPrintLog(const char *flags, int32_t dflag, const char *format, ...)
 #endif
 ;
 
+// the line is formatted later by the log thread, the flags and the format must be string literals
+void    taosPrintDeferredLog(const char *flags, int32_t dflag, const char *format, ...)
+#ifdef __GNUC__
+ __attribute__((format(printf, 3, 4)))
+#endif
+;
+
 void    taosPrintLongString(const char * flags, int32_t dflag, const char *format, ...)
 #ifdef __GNUC__
  __attribute__((format(printf, 3, 4)))
@@ -55,7 +55,7 @@ int        taosGetQitem(taos_qall, int *type, void **pitem);
 void       taosResetQitems(taos_qall);
 
 taos_qset  taosOpenQset();
-void       taosCloseQset();
+void       taosCloseQset(taos_qset);
 void       taosQsetThreadResume(taos_qset param);
 int        taosAddIntoQset(taos_qset, taos_queue, void *ahandle);
 void       taosRemoveFromQset(taos_qset, taos_queue);
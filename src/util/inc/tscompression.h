@@ -50,6 +50,13 @@ extern "C" {
 #define HEAD_MODE(x)  x%2
 #define HEAD_ALGO(x)  x/2
 
+// SIMD level of the decompression kernels, detected from the CPU at first use
+#define COMP_SIMD_NONE   0
+#define COMP_SIMD_AVX2   1
+
+extern int tsCompressGetSimdLevel();
+extern int tsCompressSetSimdLevel(int level);
+
 extern int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsCompressBoolImp(const char *const input, const int nelements, char *const output);
@@ -66,6 +66,39 @@ static const int TEST_NUMBER = 1;
 #define ZIGZAG_ENCODE(T, v) ((u##T)((v) >> (sizeof(T) * 8 - 1))) ^ (((u##T)(v)) << 1)  // zigzag encode
 #define ZIGZAG_DECODE(T, v) ((v) >> 1) ^ -((T)((v)&1))                                 // zigzag decode
 
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(WINDOWS)
+#include <immintrin.h>
+#define TD_COMP_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+static int8_t tsCompSimdLevel = -1;  // -1 means not resolved yet
+
+static int tsCompressDetectSimdLevel() {
+#ifdef TD_COMP_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return COMP_SIMD_AVX2;
+#endif
+  return COMP_SIMD_NONE;
+}
+
+int tsCompressGetSimdLevel() {
+  int level = atomic_load_8(&tsCompSimdLevel);
+  if (level < 0) {
+    level = tsCompressDetectSimdLevel();
+    atomic_store_8(&tsCompSimdLevel, (int8_t)level);
+  }
+  return level;
+}
+
+int tsCompressSetSimdLevel(int level) {
+  int supported = tsCompressDetectSimdLevel();
+  if (level > supported) level = supported;
+  if (level < COMP_SIMD_NONE) level = COMP_SIMD_NONE;
+  atomic_store_8(&tsCompSimdLevel, (int8_t)level);
+  return level;
+}
+
 #ifdef TD_TSZ
 bool lossyFloat  = false;
 bool lossyDouble = false;
@@ -99,6 +132,257 @@ void tsCompressExit(){
 
 #endif
 
+#ifdef TD_COMP_AVX2
+/* ----------------------------------------------AVX2 Decompression
+ * ----------------------------------------------
+ * The decoders below produce exactly the same output as the scalar ones. Simple8B words are unpacked four values
+ * at a time with variable shifts and rebuilt with a vector prefix sum. Timestamp and float streams are byte aligned
+ * with a variable width per value, so there is nothing to gain from wide lanes; their kernels replace the byte by
+ * byte copies with one masked 8-byte load per value whenever the load is known to stay inside the input.
+ */
+
+// [a, b, c, d] => [a, a+b, a+b+c, a+b+c+d]
+static AVX2_TARGET inline __m256i tsPrefixSumEpi64(__m256i x) {
+  __m256i zero = _mm256_setzero_si256();
+  x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+  x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+  return x;
+}
+
+uint64_t decodeDoubleValue(const char *const input, int *const ipos, uint8_t flag);
+uint32_t decodeFloatValue(const char *const input, int *const ipos, uint8_t flag);
+
+// Read nbytes little endian bytes with a single 8-byte load, the caller makes sure the load stays inside the input.
+static FORCE_INLINE uint64_t tsLoadBytes(const char *const input, int nbytes) {
+  uint64_t v = 0;
+  memcpy(&v, input, LONG_BYTES);
+  return (nbytes >= LONG_BYTES) ? v : (v & INT64MASK(nbytes * BITS_PER_BYTE));
+}
+
+static FORCE_INLINE void tsSetIntValue(char *const output, int pos, const char type, int64_t value) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BIGINT:
+      *((int64_t *)output + pos) = value;
+      break;
+    case TSDB_DATA_TYPE_INT:
+      *((int32_t *)output + pos) = (int32_t)value;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      *((int16_t *)output + pos) = (int16_t)value;
+      break;
+    case TSDB_DATA_TYPE_TINYINT:
+      *((int8_t *)output + pos) = (int8_t)value;
+      break;
+  }
+}
+
+static AVX2_TARGET int tsDecompressINTAvx2(const char *const input, const int nelements, char *const output,
+                                           const char type) {
+  static const char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+  static const int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i pack32 = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+  int64_t     buf[240];
+  const char *ip = input + 1;
+  int         count = 0;
+  int64_t     prev_value = 0;
+
+  while (count < nelements) {
+    uint64_t w = 0;
+    memcpy(&w, ip, LONG_BYTES);
+    ip += LONG_BYTES;
+
+    int selector = (int)(w & INT64MASK(4));
+    if (selector == 15) {
+      uint64_t zigzag_value = w >> 4;
+      prev_value += ZIGZAG_DECODE(int64_t, zigzag_value);
+      tsSetIntValue(output, count++, type, prev_value);
+      continue;
+    }
+
+    int elems = selector_to_elems[selector];
+    int bit = bit_per_integer[selector];
+    int n = MIN(elems, nelements - count);
+
+    if (selector == 0 || selector == 1 || elems <= 2) {
+      // runs of zero diffs and words of wide values are cheaper to do one by one
+      for (int k = 0; k < n; k++) {
+        uint64_t zigzag_value = (selector <= 1) ? 0 : ((w >> (4 + bit * k)) & INT64MASK(bit));
+        prev_value += ZIGZAG_DECODE(int64_t, zigzag_value);
+        tsSetIntValue(output, count + k, type, prev_value);
+      }
+      count += n;
+      continue;
+    } else {
+      // store straight to the output if the padding lanes of the last group still land on rows to be decoded
+      bool    direct = (count + ((elems + 3) & ~3) <= nelements) &&
+                    (type == TSDB_DATA_TYPE_BIGINT || type == TSDB_DATA_TYPE_INT);
+      __m256i carry = _mm256_set1_epi64x(prev_value);
+      __m256i word = _mm256_set1_epi64x((int64_t)w);
+      __m256i mask = _mm256_set1_epi64x((int64_t)INT64MASK(bit));
+      __m256i shift = _mm256_setr_epi64x(4, 4 + bit, 4 + 2 * bit, 4 + 3 * bit);
+      __m256i step = _mm256_set1_epi64x(4 * bit);
+      __m256i v = zero;
+
+      for (int k = 0; k < elems; k += 4) {
+        v = _mm256_and_si256(_mm256_srlv_epi64(word, shift), mask);
+        v = _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(zero, _mm256_and_si256(v, one)));
+        v = _mm256_add_epi64(tsPrefixSumEpi64(v), carry);
+        carry = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+        shift = _mm256_add_epi64(shift, step);
+
+        if (!direct) {
+          _mm256_storeu_si256((__m256i *)(buf + k), v);
+        } else if (type == TSDB_DATA_TYPE_BIGINT) {
+          _mm256_storeu_si256((__m256i *)((int64_t *)output + count + k), v);
+        } else {
+          _mm_storeu_si128((__m128i *)((int32_t *)output + count + k),
+                           _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, pack32)));
+        }
+      }
+
+      // lanes beyond elems in the last group are garbage, the next word continues from the last valid one
+      int64_t last[4];
+      _mm256_storeu_si256((__m256i *)last, v);
+      prev_value = last[(elems - 1) & 3];
+
+      if (!direct) {
+        for (int k = 0; k < n; k++) tsSetIntValue(output, count + k, type, buf[k]);
+      }
+    }
+    count += n;
+  }
+
+  return count;
+}
+
+static AVX2_TARGET void tsDecompressTimestampAvx2(const char *const input, const int nelements, char *const output) {
+  int64_t *ostream = (int64_t *)output;
+  int      npairs = (nelements + 1) / 2;
+  int      ipos = 1;
+  int      opos = 0;
+  int64_t  prev_value = 0;
+  int64_t  prev_delta = 0;
+
+  // Every pair behind the current one owns a flag byte, so while at least eight of them remain an 8-byte load
+  // never runs past the input.
+  for (int p = 0; p + LONG_BYTES < npairs; p++, opos += 2) {
+    uint8_t  flags = input[ipos++];
+    uint64_t dd1 = 0, dd2 = 0;
+
+    if (flags != 0) {  // regular intervals leave both deltas of delta zero
+      int nbytes1 = flags & INT8MASK(4);
+      int nbytes2 = (flags >> 4) & INT8MASK(4);
+      dd1 = tsLoadBytes(input + ipos, nbytes1);
+      dd2 = tsLoadBytes(input + ipos + nbytes1, nbytes2);
+      ipos += nbytes1 + nbytes2;
+    }
+
+    prev_delta += ZIGZAG_DECODE(int64_t, dd1);
+    prev_value += prev_delta;
+    ostream[opos] = prev_value;
+    if (opos == 0) prev_delta = 0;  // the first value is stored as is
+    prev_delta += ZIGZAG_DECODE(int64_t, dd2);
+    prev_value += prev_delta;
+    ostream[opos + 1] = prev_value;
+  }
+
+  for (; opos < nelements; opos += 2) {
+    uint8_t  flags = input[ipos++];
+    uint64_t dd = 0;
+    int8_t   nbytes = flags & INT8MASK(4);
+
+    memcpy(&dd, input + ipos, nbytes);
+    ipos += nbytes;
+    prev_delta += ZIGZAG_DECODE(int64_t, dd);
+    prev_value += prev_delta;
+    ostream[opos] = prev_value;
+    if (opos == 0) prev_delta = 0;  // the first value is stored as is
+
+    if (opos + 1 == nelements) break;
+
+    dd = 0;
+    nbytes = (flags >> 4) & INT8MASK(4);
+    memcpy(&dd, input + ipos, nbytes);
+    ipos += nbytes;
+    prev_delta += ZIGZAG_DECODE(int64_t, dd);
+    prev_value += prev_delta;
+    ostream[opos + 1] = prev_value;
+  }
+}
+
+// Float and double streams carry at least three bytes per pair (a flag byte and one byte for each value), so an
+// 8-byte load is in bounds while three more pairs follow.
+static AVX2_TARGET void tsDecompressDoubleAvx2(const char *const input, const int nelements, char *const output) {
+  uint64_t *bstream = (uint64_t *)output;
+  int       ipos = 1;
+  int       i = 0;
+  uint64_t  prev_value = 0;
+
+  for (; i + 8 <= nelements; i += 2) {
+    uint8_t flags = input[ipos++];
+    uint8_t flag1 = flags & INT8MASK(4);
+    uint8_t flag2 = flags >> 4;
+    int     nbytes1 = (flag1 & INT8MASK(3)) + 1;
+    int     nbytes2 = (flag2 & INT8MASK(3)) + 1;
+
+    uint64_t diff1 = tsLoadBytes(input + ipos, nbytes1) << ((LONG_BYTES - nbytes1) * BITS_PER_BYTE * (flag1 >> 3));
+    uint64_t diff2 = tsLoadBytes(input + ipos + nbytes1, nbytes2)
+                     << ((LONG_BYTES - nbytes2) * BITS_PER_BYTE * (flag2 >> 3));
+    ipos += nbytes1 + nbytes2;
+
+    prev_value ^= diff1;
+    bstream[i] = prev_value;
+    prev_value ^= diff2;
+    bstream[i + 1] = prev_value;
+  }
+
+  for (uint8_t flags = 0; i < nelements; i++) {
+    if (i % 2 == 0) flags = input[ipos++];
+    prev_value ^= decodeDoubleValue(input, &ipos, flags & INT8MASK(4));
+    flags >>= 4;
+    bstream[i] = prev_value;
+  }
+}
+
+static AVX2_TARGET void tsDecompressFloatAvx2(const char *const input, const int nelements, char *const output) {
+  uint32_t *bstream = (uint32_t *)output;
+  int       ipos = 1;
+  int       i = 0;
+  uint32_t  prev_value = 0;
+
+  for (; i + 8 <= nelements; i += 2) {
+    uint8_t flags = input[ipos++];
+    uint8_t flag1 = flags & INT8MASK(4);
+    uint8_t flag2 = flags >> 4;
+    int     nbytes1 = (flag1 & INT8MASK(3)) + 1;
+    int     nbytes2 = (flag2 & INT8MASK(3)) + 1;
+
+    uint32_t diff1 = (uint32_t)tsLoadBytes(input + ipos, nbytes1)
+                     << ((FLOAT_BYTES - nbytes1) * BITS_PER_BYTE * (flag1 >> 3));
+    uint32_t diff2 = (uint32_t)tsLoadBytes(input + ipos + nbytes1, nbytes2)
+                     << ((FLOAT_BYTES - nbytes2) * BITS_PER_BYTE * (flag2 >> 3));
+    ipos += nbytes1 + nbytes2;
+
+    prev_value ^= diff1;
+    bstream[i] = prev_value;
+    prev_value ^= diff2;
+    bstream[i + 1] = prev_value;
+  }
+
+  for (uint8_t flags = 0; i < nelements; i++) {
+    if (i % 2 == 0) flags = input[ipos++];
+    prev_value ^= decodeFloatValue(input, &ipos, flags & INT8MASK(4));
+    flags >>= 4;
+    bstream[i] = prev_value;
+  }
+}
+
+#endif
+
 /*
  * Compress Integer (Simple8B).
  */
@@ -258,6 +542,13 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
     return nelements * word_length;
   }
 
+#ifdef TD_COMP_AVX2
+  if (tsCompressGetSimdLevel() >= COMP_SIMD_AVX2) {
+    tsDecompressINTAvx2(input, nelements, output, type);
+    return nelements * word_length;
+  }
+#endif
+
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
   char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
@@ -575,6 +866,12 @@ int tsDecompressTimestampImp(const char *const input, const int nelements, char
     memcpy(output, input + 1, nelements * LONG_BYTES);
     return nelements * LONG_BYTES;
   } else if (input[0] == 1) {  // Decompress
+#ifdef TD_COMP_AVX2
+    if (tsCompressGetSimdLevel() >= COMP_SIMD_AVX2) {
+      tsDecompressTimestampAvx2(input, nelements, output);
+      return nelements * LONG_BYTES;
+    }
+#endif
     int64_t *ostream = (int64_t *)output;
 
     int     ipos = 1, opos = 0;
@@ -755,6 +1052,13 @@ int tsDecompressDoubleImp(const char *const input, const int nelements, char *co
     return nelements * DOUBLE_BYTES;
   }
 
+#ifdef TD_COMP_AVX2
+  if (tsCompressGetSimdLevel() >= COMP_SIMD_AVX2) {
+    tsDecompressDoubleAvx2(input, nelements, output);
+    return nelements * DOUBLE_BYTES;
+  }
+#endif
+
   uint8_t  flags = 0;
   int      ipos = 1;
   int      opos = 0;
@@ -901,6 +1205,13 @@ int tsDecompressFloatImp(const char *const input, const int nelements, char *con
     return nelements * FLOAT_BYTES;
   }
 
+#ifdef TD_COMP_AVX2
+  if (tsCompressGetSimdLevel() >= COMP_SIMD_AVX2) {
+    tsDecompressFloatAvx2(input, nelements, output);
+    return nelements * FLOAT_BYTES;
+  }
+#endif
+
   uint8_t  flags = 0;
   int      ipos = 1;
   int      opos = 0;
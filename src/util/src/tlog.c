@@ -28,31 +28,93 @@
 #define MAX_LOGLINE_DUMP_CONTENT_SIZE (MAX_LOGLINE_DUMP_SIZE - 100)
 
 #define LOG_FILE_NAME_LEN          300
-#define TSDB_DEFAULT_LOG_BUF_SIZE (20 * 1024 * 1024)  // 20MB
 
 #define DEFAULT_LOG_INTERVAL 25
 #define LOG_INTERVAL_STEP 5
 #define MIN_LOG_INTERVAL 5
 #define MAX_LOG_INTERVAL 25
-#define LOG_MAX_WAIT_MSEC 1000
 
 #define LOG_BUF_BUFFER(x) ((x)->buffer)
-#define LOG_BUF_START(x)  ((x)->buffStart)
-#define LOG_BUF_END(x)    ((x)->buffEnd)
 #define LOG_BUF_SIZE(x)   ((x)->buffSize)
 #define LOG_BUF_MUTEX(x)  ((x)->buffMutex)
 
+/*
+ * Each thread that prints logs owns a ring buffer, written by that thread only and drained by the async log thread,
+ * so the lines are pushed without a lock. A line is saved in the ring as a record. A text record keeps the formatted
+ * line. A binary record keeps the time, the format and a copy of the arguments, and the line is formatted by the log
+ * thread. When the ring is full the thread waits for the log thread instead of dropping the line. The lines of one
+ * thread keep their order in the file, the lines of different threads are ordered by the drain of each ring.
+ */
+#define LOG_THREAD_BUF_SIZE (256 * 1024)   // power of 2, holds two of the longest records
+#define LOG_WRITE_BUF_SIZE  (1024 * 1024)  // the drained lines are written to the file in chunks of up to this size
+#define LOG_RECORD_ALIGN    16
+#define LOG_RECORD_LEN(_d)  ((int32_t)((sizeof(SLogRecord) + (_d) + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1)))
+#define LOG_RING_POS(_o)    ((int32_t)((_o) & (LOG_THREAD_BUF_SIZE - 1)))
+#define LOG_RING_USED(_r)   ((_r)->head - atomic_load_64(&(_r)->tail))
+
+#define LOG_RECORD_PAD    0  // skips the end of the ring buffer
+#define LOG_RECORD_TEXT   1
+#define LOG_RECORD_BINARY 2
+
+#define LOG_MAX_SPEC_LEN 32
+
+enum {
+  LOG_ARG_INT,
+  LOG_ARG_LONG,
+  LOG_ARG_LLONG,
+  LOG_ARG_SIZE,
+  LOG_ARG_INTMAX,
+  LOG_ARG_PTRDIFF,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_STR,
+  LOG_ARG_PTR,
+};
+
+typedef struct {
+  int32_t len;      // bytes of the record in the ring, a multiple of LOG_RECORD_ALIGN
+  int32_t type;
+  int32_t dataLen;  // bytes of the text, or of the binary head and the arguments
+  int32_t reserved;
+} SLogRecord;
+
+typedef struct {
+  int64_t     sec;
+  int64_t     tid;
+  const char *flags;
+  const char *format;
+  int32_t     usec;
+  int32_t     reserved;
+} SLogBinaryHead;
+
+typedef struct SLogRing {
+  int64_t          head;       // bytes pushed by the owner thread
+  int64_t          tail;       // bytes drained by the log thread
+  int64_t          lostLines;  // lines dropped since the log stopped
+  char *           buffer;
+  struct SLogRing *next;       // in the list of all the rings, which are never freed
+  struct SLogRing *nextFree;   // in the list of the rings of the exited threads, for the next new thread
+} SLogRing;
+
 typedef struct {
-  char *          buffer;
-  int32_t         buffStart;
-  int32_t         buffEnd;
+  int64_t sec;
+  int32_t len;
+  char    prefix[32];  // MM/DD HH:MM:SS. of the second
+} SLogTimeCache;
+
+typedef struct {
+  char *          buffer;      // the drained lines to be written
+  int32_t         buffLen;
   int32_t         buffSize;
-  int32_t         minBuffSize;
   int32_t         fd;
   int32_t         stop;
+  SLogRing *      pRings;
+  SLogRing *      pFreeRings;
+  int32_t         wakeup;      // the log thread is asked to drain the rings
+  int32_t         numOfWaits;  // threads waiting for their full rings to be drained
   pthread_t       asyncThread;
-  pthread_mutex_t buffMutex;
-  tsem_t          buffNotEmpty;
+  pthread_mutex_t buffMutex;   // protects the ring lists and the waits
+  pthread_cond_t  wakeupCond;
+  pthread_cond_t  drainedCond;
 } SLogBuff;
 
 typedef struct {
@@ -90,8 +152,17 @@ char    tsLogDir[PATH_MAX] = "/var/log/taos";
 #endif
 
 static SLogObj   tsLogObj = { .fileNum = 1 };
+static pthread_once_t             tsLogRingInit = PTHREAD_ONCE_INIT;
+static pthread_key_t              tsLogRingKey;
+static threadlocal SLogRing *     tsLogRing = NULL;
+static threadlocal SLogTimeCache  tsLogTime = {0};
+static threadlocal int8_t         tsIsLogThread = 0;
 static void *    taosAsyncOutputLog(void *param);
 static int32_t   taosPushLogBuffer(SLogBuff *tLogBuff, char *msg, int32_t msgLen);
+static SLogRing *taosGetLogRing(SLogBuff *tLogBuff);
+static SLogRecord *taosAllocLogRecord(SLogBuff *tLogBuff, SLogRing *pRing, int32_t dataLen);
+static void      taosCommitLogRecord(SLogRing *pRing, SLogRecord *pRecord);
+static void      taosWakeLogThread(SLogBuff *tLogBuff);
 static SLogBuff *taosLogBuffNew(int32_t bufSize);
 static void      taosCloseLogByFd(int32_t oldFd);
 static int32_t   taosOpenLogFile(char *fn, int32_t maxLines, int32_t maxFileNum);
@@ -108,7 +179,7 @@ static int32_t taosStartLog() {
 }
 
 int32_t taosInitLog(char *logName, int numOfLogLines, int maxFiles) {
-  tsLogObj.logHandle = taosLogBuffNew(TSDB_DEFAULT_LOG_BUF_SIZE);
+  tsLogObj.logHandle = taosLogBuffNew(LOG_WRITE_BUF_SIZE);
   if (tsLogObj.logHandle == NULL) return -1;
   if (taosOpenLogFile(logName, numOfLogLines, maxFiles) < 0) return -1;
   if (taosStartLog() < 0) return -1;
@@ -118,6 +189,7 @@ int32_t taosInitLog(char *logName, int numOfLogLines, int maxFiles) {
 static void taosStopLog() {
   if (tsLogObj.logHandle) {
     tsLogObj.logHandle->stop = 1;
+    taosWakeLogThread(tsLogObj.logHandle);
   }
 }
 
@@ -363,73 +435,384 @@ static int32_t taosOpenLogFile(char *fn, int32_t maxLines, int32_t maxFileNum) {
   return 0;
 }
 
-void taosPrintLog(const char *flags, int32_t dflag, const char *format, ...) {
-  if (tsTotalLogDirGB != 0 && tsAvailLogDirGB < tsMinimalLogDirGB) {
-    printf("server disk:%s space remain %.3f GB, total %.1f GB, stop print log.\n", tsLogDir, tsAvailLogDirGB, tsTotalLogDirGB);
-    fflush(stdout);
-    return;
+// print v in decimal, with leading zeros up to width digits
+static int32_t taosFormatLogNum(char *buffer, int64_t v, int32_t width) {
+  char     tmp[24];
+  int32_t  n = 0;
+  uint64_t u = (v < 0) ? (0 - (uint64_t)v) : (uint64_t)v;
+  do {
+    tmp[n++] = (char)('0' + u % 10);
+    u /= 10;
+  } while (u > 0);
+
+  while (n < width) tmp[n++] = '0';
+  if (v < 0) tmp[n++] = '-';
+
+  for (int32_t i = 0; i < n; ++i) buffer[i] = tmp[n - 1 - i];
+  return n;
+}
+
+// the date and time are formatted by localtime_r once per second, the microseconds and the thread id by hand
+static int32_t taosBuildLogHead(SLogTimeCache *pCache, char *buffer, int64_t sec, int32_t usec, int64_t tid,
+                                const char *flags) {
+  if (pCache->sec != sec || pCache->len == 0) {
+    struct tm Tm;
+    time_t    curTime = (time_t)sec;
+    localtime_r(&curTime, &Tm);
+
+    pCache->len = snprintf(pCache->prefix, sizeof(pCache->prefix), "%02d/%02d %02d:%02d:%02d.", Tm.tm_mon + 1,
+                           Tm.tm_mday, Tm.tm_hour, Tm.tm_min, Tm.tm_sec);
+    pCache->sec = sec;
   }
 
-  va_list        argpointer;
-  char           buffer[MAX_LOGLINE_BUFFER_SIZE] = { 0 };
-  int32_t        len;
-  struct tm      Tm, *ptm;
+  int32_t len = pCache->len;
+  memcpy(buffer, pCache->prefix, len);
+  len += taosFormatLogNum(buffer + len, usec, 6);
+  buffer[len++] = ' ';
+  len += taosFormatLogNum(buffer + len, tid, 8);
+  buffer[len++] = ' ';
+
+  while (*flags) buffer[len++] = *flags++;
+  return len;
+}
+
+static void taosCountLogLine() {
+  if (tsLogObj.maxLines > 0) {
+    atomic_add_fetch_32(&tsLogObj.lines, 1);
+
+    if ((tsLogObj.lines > tsLogObj.maxLines) && (tsLogObj.openInProgress == 0)) taosOpenNewLogFile();
+  }
+}
+
+static void taosOutputLog(int32_t dflag, char *buffer, int32_t len) {
+  if ((dflag & DEBUG_FILE) && tsLogObj.logHandle && tsLogObj.logHandle->fd >= 0) {
+    if (tsAsyncLog) {
+      taosPushLogBuffer(tsLogObj.logHandle, buffer, len);
+    } else {
+      taosWrite(tsLogObj.logHandle->fd, buffer, len);
+    }
+
+    taosCountLogLine();
+  }
+
+  if (dflag & DEBUG_SCREEN) taosWrite(1, buffer, (uint32_t)len);
+}
+
+static void taosVPrintLog(const char *flags, int32_t dflag, const char *format, va_list argpointer) {
+  char           buffer[MAX_LOGLINE_BUFFER_SIZE];
   struct timeval timeSecs;
-  time_t         curTime;
 
   gettimeofday(&timeSecs, NULL);
-  curTime = timeSecs.tv_sec;
-  ptm = localtime_r(&curTime, &Tm);
+  int32_t len = taosBuildLogHead(&tsLogTime, buffer, timeSecs.tv_sec, (int32_t)timeSecs.tv_usec,
+                                 taosGetSelfPthreadId(), flags);
 
-  len = sprintf(buffer, "%02d/%02d %02d:%02d:%02d.%06d %08" PRId64 " ", ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_hour,
-                ptm->tm_min, ptm->tm_sec, (int32_t)timeSecs.tv_usec, taosGetSelfPthreadId());
-  len += sprintf(buffer + len, "%s", flags);
-
-  va_start(argpointer, format);
   int32_t writeLen = vsnprintf(buffer + len, MAX_LOGLINE_CONTENT_SIZE, format, argpointer);
-  if (writeLen <= 0) {
-    char tmp[MAX_LOGLINE_DUMP_BUFFER_SIZE] = {0};
-    writeLen = vsnprintf(tmp, MAX_LOGLINE_DUMP_CONTENT_SIZE, format, argpointer);
-    strncpy(buffer + len, tmp, MAX_LOGLINE_CONTENT_SIZE);
-    len += MAX_LOGLINE_CONTENT_SIZE;
-  } else if (writeLen >= MAX_LOGLINE_CONTENT_SIZE) {
-    len += MAX_LOGLINE_CONTENT_SIZE;
-  } else {
+  if (writeLen >= MAX_LOGLINE_CONTENT_SIZE) {
+    len += MAX_LOGLINE_CONTENT_SIZE - 1;
+  } else if (writeLen > 0) {
     len += writeLen;
   }
-  va_end(argpointer);
 
   if (len > MAX_LOGLINE_SIZE) len = MAX_LOGLINE_SIZE;
 
   buffer[len++] = '\n';
   buffer[len] = 0;
 
-  if ((dflag & DEBUG_FILE) && tsLogObj.logHandle && tsLogObj.logHandle->fd >= 0) {
-    if (tsAsyncLog) {
-      taosPushLogBuffer(tsLogObj.logHandle, buffer, len);
-    } else {
-      taosWrite(tsLogObj.logHandle->fd, buffer, len);
+  taosOutputLog(dflag, buffer, len);
+  if (dflag == 255) nInfo(buffer, len);
+}
+
+static bool taosCheckLogDirSpace(const char *action) {
+  if (tsTotalLogDirGB != 0 && tsAvailLogDirGB < tsMinimalLogDirGB) {
+    printf("server disk:%s space remain %.3f GB, total %.1f GB, stop %s log.\n", tsLogDir, tsAvailLogDirGB,
+           tsTotalLogDirGB, action);
+    fflush(stdout);
+    return false;
+  }
+
+  return true;
+}
+
+void taosPrintLog(const char *flags, int32_t dflag, const char *format, ...) {
+  if (!taosCheckLogDirSpace("print")) return;
+
+  va_list argpointer;
+  va_start(argpointer, format);
+  taosVPrintLog(flags, dflag, format, argpointer);
+  va_end(argpointer);
+}
+
+/*
+ * The arguments of a conversion are saved by their type: the integers and pointers as 8 bytes, the floating points as
+ * a double, the strings with their length and the terminating zero. Return the end of the conversion, or NULL if it
+ * is not supported, such as '*' widths, %n, long doubles and wide characters.
+ */
+static const char *taosParseLogSpec(const char *p, int8_t *type) {
+  const char *start = p++;
+
+  while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') p++;
+  while (*p >= '0' && *p <= '9') p++;
+  if (*p == '.') {
+    p++;
+    while (*p >= '0' && *p <= '9') p++;
+  }
+
+  int8_t intType = LOG_ARG_INT;
+  bool   hasLen = true;
+  switch (*p) {
+    case 'h':
+      p += (p[1] == 'h') ? 2 : 1;
+      break;
+    case 'l':
+      if (p[1] == 'l') {
+        intType = LOG_ARG_LLONG;
+        p += 2;
+      } else {
+        intType = LOG_ARG_LONG;
+        p += 1;
+      }
+      break;
+    case 'q':
+      intType = LOG_ARG_LLONG;
+      p += 1;
+      break;
+    case 'z':
+      intType = LOG_ARG_SIZE;
+      p += 1;
+      break;
+    case 'j':
+      intType = LOG_ARG_INTMAX;
+      p += 1;
+      break;
+    case 't':
+      intType = LOG_ARG_PTRDIFF;
+      p += 1;
+      break;
+    default:
+      hasLen = false;
+      break;
+  }
+
+  switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      *type = intType;
+      break;
+    case 'c':
+      if (hasLen) return NULL;
+      *type = LOG_ARG_INT;
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      if (hasLen && intType != LOG_ARG_LONG) return NULL;
+      *type = LOG_ARG_DOUBLE;
+      break;
+    case 's':
+      if (hasLen) return NULL;
+      *type = LOG_ARG_STR;
+      break;
+    case 'p':
+      if (hasLen) return NULL;
+      *type = LOG_ARG_PTR;
+      break;
+    default:
+      return NULL;
+  }
+
+  p++;
+  return (p - start < LOG_MAX_SPEC_LEN) ? p : NULL;
+}
+
+// return the bytes of the saved arguments, or -1 if the format is not supported
+static int32_t taosSaveLogArgs(const char *format, char *args, int32_t size, va_list argpointer) {
+  int32_t len = 0;
+
+  for (const char *p = strchr(format, '%'); p != NULL; p = strchr(p + 1, '%')) {
+    if (p[1] == '%') {
+      p++;
+      continue;
+    }
+
+    int8_t type = 0;
+    const char *end = taosParseLogSpec(p, &type);
+    if (end == NULL) return -1;
+    p = end - 1;
+
+    if (size - len < (int32_t)sizeof(int64_t) + 1) return -1;
+
+    int64_t v = 0;
+    double  d = 0;
+    switch (type) {
+      case LOG_ARG_INT:     v = va_arg(argpointer, int); break;
+      case LOG_ARG_LONG:    v = va_arg(argpointer, long); break;
+      case LOG_ARG_LLONG:   v = va_arg(argpointer, long long); break;
+      case LOG_ARG_SIZE:    v = (int64_t)va_arg(argpointer, size_t); break;
+      case LOG_ARG_INTMAX:  v = va_arg(argpointer, intmax_t); break;
+      case LOG_ARG_PTRDIFF: v = va_arg(argpointer, ptrdiff_t); break;
+      case LOG_ARG_PTR:     v = (int64_t)(uintptr_t)va_arg(argpointer, void *); break;
+      case LOG_ARG_DOUBLE:
+        d = va_arg(argpointer, double);
+        memcpy(args + len, &d, sizeof(d));
+        len += sizeof(d);
+        continue;
+      default: {
+        const char *str = va_arg(argpointer, const char *);
+        if (str == NULL) str = "(null)";
+
+        // a string is cut to the space left, as the formatted line is cut to MAX_LOGLINE_CONTENT_SIZE
+        int32_t strLen = (int32_t)strnlen(str, MAX_LOGLINE_CONTENT_SIZE);
+        strLen = MIN(strLen, size - len - (int32_t)sizeof(int32_t) - 1);
+        memcpy(args + len, &strLen, sizeof(int32_t));
+        memcpy(args + len + sizeof(int32_t), str, strLen);
+        args[len + sizeof(int32_t) + strLen] = 0;
+        len += (int32_t)sizeof(int32_t) + strLen + 1;
+        continue;
+      }
     }
 
-    if (tsLogObj.maxLines > 0) {
-      atomic_add_fetch_32(&tsLogObj.lines, 1);
+    memcpy(args + len, &v, sizeof(v));
+    len += sizeof(v);
+  }
+
+  return len;
+}
+
+// format the saved arguments by the format, like vsnprintf of size bytes, return the length of the text
+static int32_t taosFormatLogArgs(char *buffer, int32_t size, const char *format, const char *args) {
+  int32_t     len = 0;
+  const char *p = format;
+
+  while (len < size - 1) {
+    const char *q = strchr(p, '%');
+    int32_t     n = (q == NULL) ? (int32_t)strlen(p) : (int32_t)(q - p);
 
-      if ((tsLogObj.lines > tsLogObj.maxLines) && (tsLogObj.openInProgress == 0)) taosOpenNewLogFile();
+    n = MIN(n, size - 1 - len);
+    memcpy(buffer + len, p, n);
+    len += n;
+    if (q == NULL || len >= size - 1) break;
+
+    if (q[1] == '%') {
+      buffer[len++] = '%';
+      p = q + 2;
+      continue;
+    }
+
+    int8_t      type = 0;
+    const char *end = taosParseLogSpec(q, &type);
+    if (end == NULL) break;
+    p = end;
+
+    char spec[LOG_MAX_SPEC_LEN];
+    memcpy(spec, q, end - q);
+    spec[end - q] = 0;
+
+    int64_t v = 0;
+    double  d = 0;
+    n = 0;
+    if (type == LOG_ARG_STR) {
+      int32_t strLen = 0;
+      memcpy(&strLen, args, sizeof(int32_t));
+      if (end - q == 2) {
+        n = MIN(strLen, size - 1 - len);
+        memcpy(buffer + len, args + sizeof(int32_t), n);
+      } else {
+        n = snprintf(buffer + len, size - len, spec, args + sizeof(int32_t));
+      }
+      args += sizeof(int32_t) + strLen + 1;
+    } else if (type == LOG_ARG_DOUBLE) {
+      memcpy(&d, args, sizeof(d));
+      n = snprintf(buffer + len, size - len, spec, d);
+      args += sizeof(d);
+    } else {
+      memcpy(&v, args, sizeof(v));
+      args += sizeof(v);
+
+      // plain %d, %ld and %lld, the usual integers of the trace lines
+      char conv = end[-1];
+      bool plain = (conv == 'd' || conv == 'i') && (end - q == 2 || (end - q <= 4 && q[1] == 'l'));
+      if (plain && size - len > 21) {
+        n = taosFormatLogNum(buffer + len, v, 0);
+      } else {
+        switch (type) {
+          case LOG_ARG_INT:     n = snprintf(buffer + len, size - len, spec, (int)v); break;
+          case LOG_ARG_LONG:    n = snprintf(buffer + len, size - len, spec, (long)v); break;
+          case LOG_ARG_LLONG:   n = snprintf(buffer + len, size - len, spec, (long long)v); break;
+          case LOG_ARG_SIZE:    n = snprintf(buffer + len, size - len, spec, (size_t)v); break;
+          case LOG_ARG_INTMAX:  n = snprintf(buffer + len, size - len, spec, (intmax_t)v); break;
+          case LOG_ARG_PTRDIFF: n = snprintf(buffer + len, size - len, spec, (ptrdiff_t)v); break;
+          default:              n = snprintf(buffer + len, size - len, spec, (void *)(uintptr_t)v); break;
+        }
+      }
     }
+
+    if (n > 0) len += MIN(n, size - 1 - len);
   }
 
-  if (dflag & DEBUG_SCREEN)
-      taosWrite(1, buffer, (uint32_t)len);
-  if (dflag == 255) nInfo(buffer, len);
+  return len;
 }
 
-void taosDumpData(unsigned char *msg, int32_t len) {
-  if (tsTotalLogDirGB != 0 && tsAvailLogDirGB < tsMinimalLogDirGB) {
-    printf("server disk:%s space remain %.3f GB, total %.1f GB, stop dump log.\n", tsLogDir, tsAvailLogDirGB, tsTotalLogDirGB);
-    fflush(stdout);
+void taosPrintDeferredLog(const char *flags, int32_t dflag, const char *format, ...) {
+  if (!taosCheckLogDirSpace("print")) return;
+
+  va_list argpointer;
+  va_start(argpointer, format);
+
+  // the lines on the screen and the lines written at once are formatted here
+  SLogRing *pRing = NULL;
+  if (tsAsyncLog && (dflag & DEBUG_FILE) && !(dflag & DEBUG_SCREEN) && dflag != 255 && tsLogObj.logHandle &&
+      tsLogObj.logHandle->fd >= 0 && !tsLogObj.logHandle->stop) {
+    pRing = taosGetLogRing(tsLogObj.logHandle);
+  }
+
+  char    args[MAX_LOGLINE_SIZE];
+  int32_t argsLen = -1;
+  if (pRing != NULL) {
+    va_list argcopy;
+    va_copy(argcopy, argpointer);
+    argsLen = taosSaveLogArgs(format, args, sizeof(args), argcopy);
+    va_end(argcopy);
+  }
+
+  if (argsLen < 0) {
+    taosVPrintLog(flags, dflag, format, argpointer);
+    va_end(argpointer);
     return;
   }
 
+  va_end(argpointer);
+
+  struct timeval timeSecs;
+  gettimeofday(&timeSecs, NULL);
+
+  SLogRecord *pRecord = taosAllocLogRecord(tsLogObj.logHandle, pRing, sizeof(SLogBinaryHead) + argsLen);
+  if (pRecord == NULL) return;
+
+  SLogBinaryHead *pHead = (SLogBinaryHead *)(pRecord + 1);
+  pHead->sec = timeSecs.tv_sec;
+  pHead->usec = (int32_t)timeSecs.tv_usec;
+  pHead->tid = taosGetSelfPthreadId();
+  pHead->flags = flags;
+  pHead->format = format;
+  memcpy(pHead + 1, args, argsLen);
+
+  pRecord->type = LOG_RECORD_BINARY;
+  taosCommitLogRecord(pRing, pRecord);
+  taosCountLogLine();
+}
+
+void taosDumpData(unsigned char *msg, int32_t len) {
+  if (!taosCheckLogDirSpace("dump")) return;
+
   char temp[256];
   int32_t  i, pos = 0, c = 0;
 
@@ -451,51 +834,32 @@ void taosDumpData(unsigned char *msg, int32_t len) {
 }
 
 void taosPrintLongString(const char *flags, int32_t dflag, const char *format, ...) {
-  if (tsTotalLogDirGB != 0 && tsAvailLogDirGB < tsMinimalLogDirGB) {
-    printf("server disk:%s space remain %.3f GB, total %.1f GB, stop write log.\n", tsLogDir, tsAvailLogDirGB, tsTotalLogDirGB);
-    fflush(stdout);
-    return;
-  }
+  if (!taosCheckLogDirSpace("write")) return;
 
   va_list        argpointer;
   char           buffer[MAX_LOGLINE_DUMP_BUFFER_SIZE];
-  int32_t        len;
-  struct tm      Tm, *ptm;
   struct timeval timeSecs;
-  time_t         curTime;
 
   gettimeofday(&timeSecs, NULL);
-  curTime = timeSecs.tv_sec;
-  ptm = localtime_r(&curTime, &Tm);
-
-  len = sprintf(buffer, "%02d/%02d %02d:%02d:%02d.%06d %08" PRId64 " ", ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_hour,
-                ptm->tm_min, ptm->tm_sec, (int32_t)timeSecs.tv_usec, taosGetSelfPthreadId());
-  len += sprintf(buffer + len, "%s", flags);
+  int32_t len = taosBuildLogHead(&tsLogTime, buffer, timeSecs.tv_sec, (int32_t)timeSecs.tv_usec,
+                                 taosGetSelfPthreadId(), flags);
 
   va_start(argpointer, format);
-  len += vsnprintf(buffer + len, MAX_LOGLINE_DUMP_CONTENT_SIZE, format, argpointer);
+  int32_t writeLen = vsnprintf(buffer + len, MAX_LOGLINE_DUMP_CONTENT_SIZE, format, argpointer);
   va_end(argpointer);
 
+  if (writeLen >= MAX_LOGLINE_DUMP_CONTENT_SIZE) {
+    len += MAX_LOGLINE_DUMP_CONTENT_SIZE - 1;
+  } else if (writeLen > 0) {
+    len += writeLen;
+  }
+
   if (len > MAX_LOGLINE_DUMP_SIZE) len = MAX_LOGLINE_DUMP_SIZE;
 
   buffer[len++] = '\n';
   buffer[len] = 0;
 
-  if ((dflag & DEBUG_FILE) && tsLogObj.logHandle && tsLogObj.logHandle->fd >= 0) {
-    if (tsAsyncLog) {
-      taosPushLogBuffer(tsLogObj.logHandle, buffer, len);
-    } else {
-      taosWrite(tsLogObj.logHandle->fd, buffer, len);
-    }
-    
-    if (tsLogObj.maxLines > 0) {
-      atomic_add_fetch_32(&tsLogObj.lines, 1);
-
-      if ((tsLogObj.lines > tsLogObj.maxLines) && (tsLogObj.openInProgress == 0)) taosOpenNewLogFile();
-    }
-  }
-
-  if (dflag & DEBUG_SCREEN) taosWrite(1, buffer, (uint32_t)len);
+  taosOutputLog(dflag, buffer, len);
 }
 
 #if 0
@@ -520,13 +884,13 @@ static SLogBuff *taosLogBuffNew(int32_t bufSize) {
   LOG_BUF_BUFFER(tLogBuff) = malloc(bufSize);
   if (LOG_BUF_BUFFER(tLogBuff) == NULL) goto _err;
 
-  LOG_BUF_START(tLogBuff) = LOG_BUF_END(tLogBuff) = 0;
+  tLogBuff->buffLen = 0;
   LOG_BUF_SIZE(tLogBuff) = bufSize;
-  tLogBuff->minBuffSize = bufSize / 10;
   tLogBuff->stop = 0;
 
   if (pthread_mutex_init(&LOG_BUF_MUTEX(tLogBuff), NULL) < 0) goto _err;
-  //tsem_init(&(tLogBuff->buffNotEmpty), 0, 0);
+  pthread_cond_init(&tLogBuff->wakeupCond, NULL);
+  pthread_cond_init(&tLogBuff->drainedCond, NULL);
 
   return tLogBuff;
 
@@ -538,164 +902,266 @@ _err:
 
 #if 0
 static void taosLogBuffDestroy(SLogBuff *tLogBuff) {
-  tsem_destroy(&(tLogBuff->buffNotEmpty));
+  pthread_cond_destroy(&tLogBuff->wakeupCond);
+  pthread_cond_destroy(&tLogBuff->drainedCond);
   pthread_mutex_destroy(&(tLogBuff->buffMutex));
   free(tLogBuff->buffer);
   tfree(tLogBuff);
 }
 #endif
 
-static void taosCopyLogBuffer(SLogBuff *tLogBuff, int32_t start, int32_t end, char *msg, int32_t msgLen) {
-  if (start > end) {
-    memcpy(LOG_BUF_BUFFER(tLogBuff) + end, msg, msgLen);
-  } else {
-    if (LOG_BUF_SIZE(tLogBuff) - end < msgLen) {
-      memcpy(LOG_BUF_BUFFER(tLogBuff) + end, msg, LOG_BUF_SIZE(tLogBuff) - end);
-      memcpy(LOG_BUF_BUFFER(tLogBuff), msg + LOG_BUF_SIZE(tLogBuff) - end, msgLen - LOG_BUF_SIZE(tLogBuff) + end);
-    } else {
-      memcpy(LOG_BUF_BUFFER(tLogBuff) + end, msg, msgLen);
-    }
-  }
-  LOG_BUF_END(tLogBuff) = (LOG_BUF_END(tLogBuff) + msgLen) % LOG_BUF_SIZE(tLogBuff);
+// the ring of an exiting thread may still have lines to drain, it is kept for the next new thread
+static void taosReleaseLogRing(void *param) {
+  SLogRing *pRing = param;
+  SLogBuff *tLogBuff = tsLogObj.logHandle;
+
+  pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+  pRing->nextFree = tLogBuff->pFreeRings;
+  tLogBuff->pFreeRings = pRing;
+  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
 }
 
-static int32_t taosPushLogBuffer(SLogBuff *tLogBuff, char *msg, int32_t msgLen) {
-  int32_t start = 0;
-  int32_t end = 0;
-  int32_t remainSize = 0;
-  static int64_t lostLine = 0;
-  char tmpBuf[40] = {0};
-  int32_t tmpBufLen = 0;
+static void taosInitLogRingKey() { pthread_key_create(&tsLogRingKey, taosReleaseLogRing); }
 
-  if (tLogBuff == NULL || tLogBuff->stop) return -1;
+static SLogRing *taosGetLogRing(SLogBuff *tLogBuff) {
+  if (tsLogRing != NULL) return tsLogRing;
+
+  pthread_once(&tsLogRingInit, taosInitLogRingKey);
 
   pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
-  start = LOG_BUF_START(tLogBuff);
-  end = LOG_BUF_END(tLogBuff);
+  SLogRing *pRing = tLogBuff->pFreeRings;
+  if (pRing) tLogBuff->pFreeRings = pRing->nextFree;
+  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
+
+  if (pRing == NULL) {
+    pRing = calloc(1, sizeof(SLogRing));
+    if (pRing == NULL) return NULL;
 
-  remainSize = (start > end) ? (start - end - 1) : (start + LOG_BUF_SIZE(tLogBuff) - end - 1);
+    pRing->buffer = malloc(LOG_THREAD_BUF_SIZE);
+    if (pRing->buffer == NULL) {
+      free(pRing);
+      return NULL;
+    }
 
-  if (lostLine > 0) {
-    sprintf(tmpBuf, "...Lost %"PRId64" lines here...\n", lostLine);
-    tmpBufLen = (int32_t)strlen(tmpBuf);
+    pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+    pRing->next = tLogBuff->pRings;
+    tLogBuff->pRings = pRing;
+    pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
   }
 
-  if (remainSize <= msgLen || ((lostLine > 0) && (remainSize <= (msgLen + tmpBufLen)))) {
-    lostLine++;
-    asyncLogLostLines++;
+  pRing->nextFree = NULL;
+  pthread_setspecific(tsLogRingKey, pRing);
+  tsLogRing = pRing;
+  return pRing;
+}
+
+static void taosGetLogWaitTime(struct timespec *ts, int32_t msec) {
+  int64_t ns = taosGetTimestampNs() + msec * 1000000LL;
+  ts->tv_sec = ns / 1000000000LL;
+  ts->tv_nsec = ns % 1000000000LL;
+}
+
+static void taosWakeLogThread(SLogBuff *tLogBuff) {
+  pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+  tLogBuff->wakeup = 1;
+  pthread_cond_signal(&tLogBuff->wakeupCond);
+  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
+}
+
+// a record never wraps around the end of the ring, the end is skipped by a pad record
+static SLogRecord *taosAllocLogRecord(SLogBuff *tLogBuff, SLogRing *pRing, int32_t dataLen) {
+  int32_t len = LOG_RECORD_LEN(dataLen);
+  int64_t head = pRing->head;
+  int32_t pos = LOG_RING_POS(head);
+  int32_t padLen = (pos + len > LOG_THREAD_BUF_SIZE) ? (LOG_THREAD_BUF_SIZE - pos) : 0;
+
+  while (LOG_RING_USED(pRing) + padLen + len > LOG_THREAD_BUF_SIZE) {
+    // nobody drains the ring any more
+    if (tLogBuff->stop || tsIsLogThread) {
+      pRing->lostLines++;
+      atomic_add_fetch_64(&asyncLogLostLines, 1);
+      return NULL;
+    }
+
+    // the tail is moved before the log thread signals under the mutex, so the wakeup is not missed
+    pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+    if (LOG_RING_USED(pRing) + padLen + len > LOG_THREAD_BUF_SIZE && !tLogBuff->stop) {
+      struct timespec ts;
+      taosGetLogWaitTime(&ts, MAX_LOG_INTERVAL);
+
+      tLogBuff->wakeup = 1;
+      tLogBuff->numOfWaits++;
+      pthread_cond_signal(&tLogBuff->wakeupCond);
+      pthread_cond_timedwait(&tLogBuff->drainedCond, &LOG_BUF_MUTEX(tLogBuff), &ts);
+      tLogBuff->numOfWaits--;
+    }
     pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
-    return -1;
   }
 
-  if (lostLine > 0) {
-    taosCopyLogBuffer(tLogBuff, start, end, tmpBuf, tmpBufLen);
-    lostLine = 0;
+  if (padLen > 0) {
+    SLogRecord *pPad = (SLogRecord *)(pRing->buffer + pos);
+    pPad->len = padLen;
+    pPad->type = LOG_RECORD_PAD;
+    pPad->dataLen = 0;
   }
 
-  taosCopyLogBuffer(tLogBuff, LOG_BUF_START(tLogBuff), LOG_BUF_END(tLogBuff), msg, msgLen);
+  SLogRecord *pRecord = (SLogRecord *)(pRing->buffer + LOG_RING_POS(head + padLen));
+  pRecord->len = len;
+  pRecord->dataLen = dataLen;
+  return pRecord;
+}
 
-  //int32_t w = atomic_sub_fetch_32(&waitLock, 1);
-  /*
-  if (w <= 0 || ((remainSize - msgLen - tmpBufLen) < (LOG_BUF_SIZE(tLogBuff) * 4 /5))) {
-    tsem_post(&(tLogBuff->buffNotEmpty));
-    dbgPostN++;
-  } else {
-    dbgNoPostN++;
-  }
-  */
+static void taosCommitLogRecord(SLogRing *pRing, SLogRecord *pRecord) {
+  int64_t head = pRing->head;
+  int32_t pos = LOG_RING_POS(head);
+  if (pos + pRecord->len > LOG_THREAD_BUF_SIZE) head += LOG_THREAD_BUF_SIZE - pos;
 
-  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
+  atomic_store_64(&pRing->head, head + pRecord->len);
+
+  // wake the log thread before the ring is full
+  SLogBuff *tLogBuff = tsLogObj.logHandle;
+  if (LOG_RING_USED(pRing) > LOG_THREAD_BUF_SIZE / 2 && atomic_load_32(&tLogBuff->wakeup) == 0) {
+    taosWakeLogThread(tLogBuff);
+  }
+}
 
+static int32_t taosPushLogText(SLogBuff *tLogBuff, SLogRing *pRing, const char *msg, int32_t msgLen) {
+  SLogRecord *pRecord = taosAllocLogRecord(tLogBuff, pRing, msgLen);
+  if (pRecord == NULL) return -1;
 
+  pRecord->type = LOG_RECORD_TEXT;
+  memcpy(pRecord + 1, msg, msgLen);
+  taosCommitLogRecord(pRing, pRecord);
   return 0;
 }
 
-static int32_t taosGetLogRemainSize(SLogBuff *tLogBuff, int32_t start, int32_t end) {
-  int32_t rSize = end - start;
+static int32_t taosPushLogBuffer(SLogBuff *tLogBuff, char *msg, int32_t msgLen) {
+  if (tLogBuff == NULL || tLogBuff->stop) return -1;
+
+  SLogRing *pRing = taosGetLogRing(tLogBuff);
+  if (pRing == NULL) {
+    taosWrite(tLogBuff->fd, msg, msgLen);
+    return 0;
+  }
+
+  if (pRing->lostLines > 0) {
+    char tmpBuf[40] = {0};
+    int32_t tmpBufLen = sprintf(tmpBuf, "...Lost %" PRId64 " lines here...\n", pRing->lostLines);
+    if (taosPushLogText(tLogBuff, pRing, tmpBuf, tmpBufLen) != 0) return -1;
+    pRing->lostLines = 0;
+  }
 
-  return rSize >= 0 ? rSize : LOG_BUF_SIZE(tLogBuff) + rSize;
+  return taosPushLogText(tLogBuff, pRing, msg, msgLen);
 }
 
-static void taosWriteLog(SLogBuff *tLogBuff) {
-  static int32_t lastDuration = 0;
-  int32_t remainChecked = 0;
-  int32_t start, end, pollSize;
-  
-  do {
-    if (remainChecked == 0) {
-      start = LOG_BUF_START(tLogBuff);
-      end = LOG_BUF_END(tLogBuff);
+static void taosFlushLogBuffer(SLogBuff *tLogBuff) {
+  if (tLogBuff->buffLen == 0) return;
 
-      if (start == end) {
-        dbgEmptyW++;
-        writeInterval = MAX_LOG_INTERVAL;
-        return;
-      }
+  taosWrite(tLogBuff->fd, LOG_BUF_BUFFER(tLogBuff), tLogBuff->buffLen);
 
-      pollSize = taosGetLogRemainSize(tLogBuff, start, end);
-      if (pollSize < tLogBuff->minBuffSize) {
-        lastDuration += writeInterval;
-        if (lastDuration < LOG_MAX_WAIT_MSEC) {
-          break;
-        }
-      }
+  dbgWN++;
+  dbgWSize += tLogBuff->buffLen;
+  tLogBuff->buffLen = 0;
+}
 
-      lastDuration = 0;
-    }
+static void taosFormatLogRecord(SLogBuff *tLogBuff, SLogTimeCache *pCache, SLogRecord *pRecord) {
+  if (LOG_BUF_SIZE(tLogBuff) - tLogBuff->buffLen < MAX_LOGLINE_BUFFER_SIZE) taosFlushLogBuffer(tLogBuff);
 
-    if (start < end) {
-      taosWrite(tLogBuff->fd, LOG_BUF_BUFFER(tLogBuff) + start, pollSize);
-    } else {
-        int32_t tsize = LOG_BUF_SIZE(tLogBuff) - start;
-        taosWrite(tLogBuff->fd, LOG_BUF_BUFFER(tLogBuff) + start, tsize);
+  SLogBinaryHead *pHead = (SLogBinaryHead *)(pRecord + 1);
+  char *          buffer = LOG_BUF_BUFFER(tLogBuff) + tLogBuff->buffLen;
 
-        taosWrite(tLogBuff->fd, LOG_BUF_BUFFER(tLogBuff), end);
-    }
+  int32_t len = taosBuildLogHead(pCache, buffer, pHead->sec, pHead->usec, pHead->tid, pHead->flags);
+  len += taosFormatLogArgs(buffer + len, MAX_LOGLINE_CONTENT_SIZE, pHead->format, (const char *)(pHead + 1));
+  if (len > MAX_LOGLINE_SIZE) len = MAX_LOGLINE_SIZE;
 
-    dbgWN++;
-    dbgWSize+=pollSize;
-    
-    if (pollSize < tLogBuff->minBuffSize) {
-      dbgSmallWN++;
-      if (writeInterval < MAX_LOG_INTERVAL) {
-        writeInterval += LOG_INTERVAL_STEP;
-      }
-    } else if (pollSize >  LOG_BUF_SIZE(tLogBuff)/3) {
-      dbgBigWN++;
-      writeInterval = MIN_LOG_INTERVAL;
-    } else if (pollSize > LOG_BUF_SIZE(tLogBuff)/4) {
-      if (writeInterval > MIN_LOG_INTERVAL) {
-        writeInterval -= LOG_INTERVAL_STEP;
-      }
-    }
+  buffer[len++] = '\n';
+  tLogBuff->buffLen += len;
+}
 
-    LOG_BUF_START(tLogBuff) = (LOG_BUF_START(tLogBuff) + pollSize) % LOG_BUF_SIZE(tLogBuff);
+// return the bytes that were in the ring
+static int32_t taosDrainLogRing(SLogBuff *tLogBuff, SLogTimeCache *pCache, SLogRing *pRing) {
+  int64_t head = atomic_load_64(&pRing->head);
+  int64_t tail = pRing->tail;
+  int32_t size = (int32_t)(head - tail);
 
-    start = LOG_BUF_START(tLogBuff);
-    end = LOG_BUF_END(tLogBuff);
+  while (tail < head) {
+    SLogRecord *pRecord = (SLogRecord *)(pRing->buffer + LOG_RING_POS(tail));
 
-    pollSize = taosGetLogRemainSize(tLogBuff, start, end);
-    if (pollSize < tLogBuff->minBuffSize) {
-      break;
+    if (pRecord->type == LOG_RECORD_TEXT) {
+      if (LOG_BUF_SIZE(tLogBuff) - tLogBuff->buffLen < pRecord->dataLen) taosFlushLogBuffer(tLogBuff);
+
+      memcpy(LOG_BUF_BUFFER(tLogBuff) + tLogBuff->buffLen, pRecord + 1, pRecord->dataLen);
+      tLogBuff->buffLen += pRecord->dataLen;
+    } else if (pRecord->type == LOG_RECORD_BINARY) {
+      taosFormatLogRecord(tLogBuff, pCache, pRecord);
     }
 
-    writeInterval = MIN_LOG_INTERVAL;
+    tail += pRecord->len;
+  }
+
+  atomic_store_64(&pRing->tail, tail);
+  return size;
+}
+
+static void taosWriteLog(SLogBuff *tLogBuff) {
+  static SLogTimeCache timeCache = {0};
+
+  // the rings are only added to the head of the list
+  pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+  SLogRing *pRing = tLogBuff->pRings;
+  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
 
-    remainChecked = 1;
-  }while (1);
+  int32_t maxSize = 0;
+  for (; pRing != NULL; pRing = pRing->next) {
+    int32_t size = taosDrainLogRing(tLogBuff, &timeCache, pRing);
+    maxSize = MAX(maxSize, size);
+  }
+
+  pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+  if (tLogBuff->numOfWaits > 0) pthread_cond_broadcast(&tLogBuff->drainedCond);
+  pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
+
+  taosFlushLogBuffer(tLogBuff);
+
+  // drain more often when a ring is filling up
+  if (maxSize == 0) {
+    dbgEmptyW++;
+    writeInterval = MAX_LOG_INTERVAL;
+  } else if (maxSize > LOG_THREAD_BUF_SIZE / 4) {
+    dbgBigWN++;
+    writeInterval = MIN_LOG_INTERVAL;
+  } else if (maxSize < LOG_THREAD_BUF_SIZE / 16) {
+    dbgSmallWN++;
+    if (writeInterval < MAX_LOG_INTERVAL) {
+      writeInterval += LOG_INTERVAL_STEP;
+    }
+  } else if (writeInterval > MIN_LOG_INTERVAL) {
+    writeInterval -= LOG_INTERVAL_STEP;
+  }
 }
 
 static void *taosAsyncOutputLog(void *param) {
   SLogBuff *tLogBuff = (SLogBuff *)param;
   setThreadName("log");
-  
+  tsIsLogThread = 1;
+
   while (1) {
-    taosMsleep(writeInterval);
+    pthread_mutex_lock(&LOG_BUF_MUTEX(tLogBuff));
+    if (!tLogBuff->wakeup && !tLogBuff->stop) {
+      struct timespec ts;
+      taosGetLogWaitTime(&ts, writeInterval);
+      pthread_cond_timedwait(&tLogBuff->wakeupCond, &LOG_BUF_MUTEX(tLogBuff), &ts);
+    }
+    tLogBuff->wakeup = 0;
+    pthread_mutex_unlock(&LOG_BUF_MUTEX(tLogBuff));
+
+    // the lines pushed before the stop are drained by this last pass
+    int32_t stop = atomic_load_32(&tLogBuff->stop);
 
     // Polling the buffer
     taosWriteLog(tLogBuff);
 
-    if (tLogBuff->stop) break;
+    if (stop) break;
   }
 
   return NULL;
@@ -17,22 +17,58 @@
 #include "tulog.h"
 #include "taoserror.h"
 #include "tqueue.h"
+#include "tlockfree.h"
+
+/*
+ * Producers never lock a queue: an item is pushed onto the 'tail' stack by CAS, in LIFO order. The consumer,
+ * serialized by the queue mutex, takes the whole stack in one atomic swap and reverses it into the 'head' list,
+ * so items are still read out in FIFO order. The qset of a queue is changed with its latch write-locked, producers
+ * read-lock it, so a qset is not closed while an item is counted and posted to it. Item nodes are recycled through
+ * the cache of the allocating thread, nodes freed by another thread are batched and pushed back to the remote list
+ * of their owner cache.
+ */
+
+#define QITEM_MIN_SHIFT    6     // smallest node is 64 bytes
+#define QITEM_CLASSES      7     // largest cached node is 4KB, bigger items are allocated by calloc
+#define QITEM_CACHE_SIZE   (1024 * 1024)  // max bytes kept in each size class of a thread cache
+#define QITEM_FREE_SLOTS   16    // slots to batch the nodes freed to other caches
+#define QITEM_FREE_BATCH   32    // nodes returned to the owner cache by one CAS
 
 typedef struct STaosQnode {
-  int                 type;
+  int32_t             type;
+  int32_t             sclass;  // size class in the item cache, -1 if allocated by calloc
   struct STaosQnode  *next;
+  struct SQitemCache *pCache;  // owner cache of the node
   char                item[];
 } STaosQnode;
 
+typedef struct {
+  struct SQitemCache *pOwner;
+  int32_t             sclass;
+  int32_t             num;
+  STaosQnode         *head;
+  STaosQnode         *tail;
+} SQitemBatch;
+
+typedef struct SQitemCache {
+  STaosQnode         *pFree[QITEM_CLASSES];
+  int32_t             numOfFree[QITEM_CLASSES];
+  STaosQnode *volatile pRemote[QITEM_CLASSES];      // nodes freed by other threads
+  int32_t             numOfRemote[QITEM_CLASSES];
+  SQitemBatch         batch[QITEM_FREE_SLOTS];  // nodes freed by this thread, not returned to the owner yet
+  struct SQitemCache *next;                     // for abandoned caches
+} SQitemCache;
+
 typedef struct STaosQueue {
   int32_t             itemSize;
   int32_t             numOfItems;
-  struct STaosQnode  *head;
-  struct STaosQnode  *tail;
+  struct STaosQnode  *head;    // consumer side, in FIFO order
+  struct STaosQnode *volatile tail;  // producer side, in LIFO order
   struct STaosQueue  *next;    // for queue set
   struct STaosQset   *qset;    // for queue set
   void               *ahandle; // for queue set
-  pthread_mutex_t     mutex;  
+  SRWLatch            latch;   // protects qset from the producers
+  pthread_mutex_t     mutex;   // serializes the consumers
 } STaosQueue;
 
 typedef struct STaosQset {
@@ -50,7 +86,204 @@ typedef struct STaosQall {
   int32_t       itemSize;
   int32_t       numOfItems;
 } STaosQall; 
-  
+
+static void taosFlushQitemBatch(SQitemBatch *pBatch);
+
+static pthread_once_t        tsQitemInit = PTHREAD_ONCE_INIT;
+static pthread_key_t         tsQitemKey;
+static pthread_mutex_t       tsQitemMutex = PTHREAD_MUTEX_INITIALIZER;
+static SQitemCache          *tsQitemAbandoned = NULL;
+static threadlocal SQitemCache *tsQitemCache = NULL;
+
+// the cache of an exiting thread may still own nodes in use, it is kept for the next new thread
+static void taosAbandonQitemCache(void *param) {
+  SQitemCache *pCache = param;
+  for (int32_t i = 0; i < QITEM_FREE_SLOTS; ++i) taosFlushQitemBatch(pCache->batch + i);
+
+  pthread_mutex_lock(&tsQitemMutex);
+  pCache->next = tsQitemAbandoned;
+  tsQitemAbandoned = pCache;
+  pthread_mutex_unlock(&tsQitemMutex);
+}
+
+static void taosInitQitemKey() { pthread_key_create(&tsQitemKey, taosAbandonQitemCache); }
+
+static SQitemCache *taosGetQitemCache() {
+  if (tsQitemCache != NULL) return tsQitemCache;
+
+  pthread_once(&tsQitemInit, taosInitQitemKey);
+
+  pthread_mutex_lock(&tsQitemMutex);
+  SQitemCache *pCache = tsQitemAbandoned;
+  if (pCache) tsQitemAbandoned = pCache->next;
+  pthread_mutex_unlock(&tsQitemMutex);
+
+  if (pCache == NULL) {
+    pCache = calloc(1, sizeof(SQitemCache));
+    if (pCache == NULL) return NULL;
+  }
+
+  pCache->next = NULL;
+  pthread_setspecific(tsQitemKey, pCache);
+  tsQitemCache = pCache;
+  return pCache;
+}
+
+#define QITEM_MAX_CACHED(sclass) (QITEM_CACHE_SIZE >> (QITEM_MIN_SHIFT + (sclass)))
+
+static void taosPutQnodeIntoCache(SQitemCache *pCache, STaosQnode *pNode) {
+  int32_t sclass = pNode->sclass;
+  if (pCache->numOfFree[sclass] >= QITEM_MAX_CACHED(sclass)) {
+    free(pNode);
+  } else {
+    pNode->next = pCache->pFree[sclass];
+    pCache->pFree[sclass] = pNode;
+    pCache->numOfFree[sclass]++;
+  }
+}
+
+static STaosQnode *taosGetQnodeFromCache(SQitemCache *pCache, int32_t sclass) {
+  // the nodes returned by other threads are taken over as the free list in one swap
+  if (pCache->pFree[sclass] == NULL && atomic_load_ptr(&pCache->pRemote[sclass]) != NULL) {
+    STaosQnode *pNode = atomic_exchange_ptr(&pCache->pRemote[sclass], NULL);
+    int32_t     num = atomic_exchange_32(&pCache->numOfRemote[sclass], 0);
+
+    pCache->pFree[sclass] = pNode;
+    pCache->numOfFree[sclass] = num;
+    if (num > QITEM_MAX_CACHED(sclass)) {
+      // trim the free list after a burst
+      for (int32_t i = 1; i < QITEM_MAX_CACHED(sclass) && pNode; ++i) pNode = pNode->next;
+      STaosQnode *pTrim = pNode ? pNode->next : NULL;
+      if (pNode) pNode->next = NULL;
+      pCache->numOfFree[sclass] = QITEM_MAX_CACHED(sclass);
+      while (pTrim) {
+        STaosQnode *pNext = pTrim->next;
+        free(pTrim);
+        pTrim = pNext;
+      }
+    }
+  }
+
+  STaosQnode *pNode = pCache->pFree[sclass];
+  if (pNode) {
+    pCache->pFree[sclass] = pNode->next;
+    pCache->numOfFree[sclass]--;
+  }
+
+  return pNode;
+}
+
+static void taosFlushQitemBatch(SQitemBatch *pBatch) {
+  if (pBatch->num == 0) return;
+
+  SQitemCache *pOwner = pBatch->pOwner;
+  STaosQnode  *pHead;
+  do {
+    pHead = atomic_load_ptr(&pOwner->pRemote[pBatch->sclass]);
+    pBatch->tail->next = pHead;
+  } while (atomic_val_compare_exchange_ptr(&pOwner->pRemote[pBatch->sclass], pHead, pBatch->head) != pHead);
+  atomic_add_fetch_32(&pOwner->numOfRemote[pBatch->sclass], pBatch->num);
+
+  memset(pBatch, 0, sizeof(SQitemBatch));
+}
+
+static void taosFreeQnode(STaosQnode *pNode) {
+  if (pNode->sclass < 0) {
+    free(pNode);
+    return;
+  }
+
+  SQitemCache *pOwner = pNode->pCache;
+  SQitemCache *pCache = taosGetQitemCache();
+  if (pCache == pOwner) {
+    taosPutQnodeIntoCache(pCache, pNode);
+    return;
+  }
+
+  if (pCache == NULL) {
+    pNode->next = NULL;
+    SQitemBatch batch = {pOwner, pNode->sclass, 1, pNode, pNode};
+    taosFlushQitemBatch(&batch);
+    return;
+  }
+
+  uintptr_t    slot = ((uintptr_t)pOwner >> 6) * QITEM_CLASSES + pNode->sclass;
+  SQitemBatch *pBatch = pCache->batch + (slot % QITEM_FREE_SLOTS);
+  if (pBatch->pOwner != pOwner || pBatch->sclass != pNode->sclass) {
+    taosFlushQitemBatch(pBatch);
+    pBatch->pOwner = pOwner;
+    pBatch->sclass = pNode->sclass;
+  }
+
+  pNode->next = pBatch->head;
+  pBatch->head = pNode;
+  if (pBatch->tail == NULL) pBatch->tail = pNode;
+  if (++pBatch->num >= QITEM_FREE_BATCH) taosFlushQitemBatch(pBatch);
+}
+
+// move the items written by producers to the consumer list, caller shall hold the queue mutex
+static int32_t taosCollectQitems(STaosQueue *queue) {
+  STaosQnode *pNode = atomic_exchange_ptr(&queue->tail, NULL);
+  STaosQnode *pList = NULL;
+  int32_t     num = 0;
+
+  while (pNode) {
+    STaosQnode *pNext = pNode->next;
+    pNode->next = pList;
+    pList = pNode;
+    pNode = pNext;
+    num++;
+  }
+
+  if (pList) {
+    if (queue->head == NULL) {
+      queue->head = pList;
+    } else {
+      STaosQnode *pLast = queue->head;
+      while (pLast->next) pLast = pLast->next;
+      pLast->next = pList;
+    }
+  }
+
+  return num;
+}
+
+static bool taosQueueEmpty(STaosQueue *queue) { return queue->head == NULL && atomic_load_ptr(&queue->tail) == NULL; }
+
+// take out the first item, caller shall hold the queue mutex
+static STaosQnode *taosPopQnode(STaosQueue *queue) {
+  if (queue->head == NULL) taosCollectQitems(queue);
+
+  STaosQnode *pNode = queue->head;
+  if (pNode) {
+    queue->head = pNode->next;
+    atomic_sub_fetch_32(&queue->numOfItems, 1);
+    if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, 1);
+  }
+
+  return pNode;
+}
+
+// take out all the items into qall, caller shall hold the queue mutex
+static int32_t taosPopAllQnodes(STaosQueue *queue, STaosQall *qall) {
+  int32_t num = 0;
+  for (STaosQnode *pNode = queue->head; pNode; pNode = pNode->next) num++;
+  num += taosCollectQitems(queue);
+
+  if (num > 0) {
+    qall->current = queue->head;
+    qall->start = queue->head;
+    qall->numOfItems = num;
+    qall->itemSize = queue->itemSize;
+
+    queue->head = NULL;
+    atomic_sub_fetch_32(&queue->numOfItems, num);
+    if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, num);
+  }
+
+  return num;
+}
+
 taos_queue taosOpenQueue() {
   
   STaosQueue *queue = (STaosQueue *) calloc(sizeof(STaosQueue), 1);
@@ -60,6 +293,7 @@ taos_queue taosOpenQueue() {
   }
 
   pthread_mutex_init(&queue->mutex, NULL);
+  taosInitRWLatch(&queue->latch);
 
   uTrace("queue:%p is opened", queue);
   return queue;
@@ -72,6 +306,7 @@ void taosCloseQueue(taos_queue param) {
   STaosQset  *qset;
 
   pthread_mutex_lock(&queue->mutex);
+  taosCollectQitems(queue);
   STaosQnode *pNode = queue->head;  
   queue->head = NULL;
   qset = queue->qset;
@@ -82,7 +317,7 @@ void taosCloseQueue(taos_queue param) {
   while (pNode) {
     pTemp = pNode;
     pNode = pNode->next;
-    free (pTemp);
+    taosFreeQnode(pTemp);
   }
 
   pthread_mutex_destroy(&queue->mutex);
@@ -92,9 +327,36 @@ void taosCloseQueue(taos_queue param) {
 }
 
 void *taosAllocateQitem(int size) {
-  STaosQnode *pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
-  
+  STaosQnode  *pNode = NULL;
+  SQitemCache *pCache = NULL;
+  int32_t      sclass = -1;
+  int32_t      nodeSize = (1 << QITEM_MIN_SHIFT);
+
+  for (int32_t i = 0; i < QITEM_CLASSES; ++i, nodeSize <<= 1) {
+    if (size + (int32_t)sizeof(STaosQnode) <= nodeSize) {
+      sclass = i;
+      break;
+    }
+  }
+
+  if (sclass >= 0) pCache = taosGetQitemCache();
+
+  if (pCache != NULL) {
+    pNode = taosGetQnodeFromCache(pCache, sclass);
+    if (pNode != NULL) {
+      memset(pNode->item, 0, size);
+    } else {
+      pNode = (STaosQnode *)calloc(nodeSize, 1);
+    }
+  } else {
+    sclass = -1;
+    pNode = (STaosQnode *)calloc(sizeof(STaosQnode) + size, 1);
+  }
+
   if (pNode == NULL) return NULL;
+
+  pNode->sclass = sclass;
+  pNode->pCache = pCache;
   uTrace("item:%p, node:%p is allocated", pNode->item, pNode);
   return (void *)pNode->item;
 }
@@ -105,32 +367,32 @@ void taosFreeQitem(void *param) {
   char *temp = (char *)param;
   temp -= sizeof(STaosQnode);
   uTrace("item:%p, node:%p is freed", param, temp);
-  free(temp);
+  taosFreeQnode((STaosQnode *)temp);
 }
 
 int taosWriteQitem(taos_queue param, int type, void *item) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQnode *pNode = (STaosQnode *)(((char *)item) - sizeof(STaosQnode));
+  STaosQnode *pTail;
   pNode->type = type;
-  pNode->next = NULL;
 
-  pthread_mutex_lock(&queue->mutex);
+  taosRLockLatch(&queue->latch);
 
-  if (queue->tail) {
-    queue->tail->next = pNode;
-    queue->tail = pNode;
-  } else {
-    queue->head = pNode;
-    queue->tail = pNode; 
-  }
+  // count the item first, so the number of items is never less than the items in queue
+  int32_t     numOfItems = atomic_add_fetch_32(&queue->numOfItems, 1);
+  STaosQset  *qset = queue->qset;
+  if (qset) atomic_add_fetch_32(&qset->numOfItems, 1);
 
-  queue->numOfItems++;
-  if (queue->qset) atomic_add_fetch_32(&queue->qset->numOfItems, 1);
-  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, queue->numOfItems);
+  do {
+    pTail = atomic_load_ptr(&queue->tail);
+    pNode->next = pTail;
+  } while (atomic_val_compare_exchange_ptr(&queue->tail, pTail, pNode) != pTail);
 
-  pthread_mutex_unlock(&queue->mutex);
+  uTrace("item:%p is put into queue:%p, type:%d items:%d", item, queue, type, numOfItems);
 
-  if (queue->qset) tsem_post(&queue->qset->sem);
+  if (qset) tsem_post(&qset->sem);
+
+  taosRUnLockLatch(&queue->latch);
 
   return 0;
 }
@@ -142,15 +404,10 @@ int taosReadQitem(taos_queue param, int *type, void **pitem) {
 
   pthread_mutex_lock(&queue->mutex);
 
-  if (queue->head) {
-      pNode = queue->head;
+  pNode = taosPopQnode(queue);
+  if (pNode) {
       *pitem = pNode->item;
       *type = pNode->type;
-      queue->head = pNode->next;
-      if (queue->head == NULL) 
-        queue->tail = NULL;
-      queue->numOfItems--;
-      if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, 1);
       code = 1;
       uDebug("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, *type, queue->numOfItems);
   } 
@@ -173,33 +430,13 @@ int taosReadAllQitems(taos_queue param, taos_qall p2) {
   STaosQueue *queue = (STaosQueue *)param;
   STaosQall  *qall = (STaosQall *)p2;
   int         code = 0;
-  bool        empty;
 
-  pthread_mutex_lock(&queue->mutex);
-
-  empty = queue->head == NULL;
-  if (!empty) {
-    memset(qall, 0, sizeof(STaosQall));
-    qall->current = queue->head;
-    qall->start = queue->head;
-    qall->numOfItems = queue->numOfItems;
-    qall->itemSize = queue->itemSize;
-    code = qall->numOfItems;
-
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->numOfItems = 0;
-    if (queue->qset) atomic_sub_fetch_32(&queue->qset->numOfItems, qall->numOfItems);
-  }
+  memset(qall, 0, sizeof(STaosQall));
 
+  pthread_mutex_lock(&queue->mutex);
+  code = taosPopAllQnodes(queue, qall);
   pthread_mutex_unlock(&queue->mutex);
 
-  // if source queue is empty, we set destination qall to empty too.
-  if (empty) {
-    qall->current = NULL;
-    qall->start = NULL;
-    qall->numOfItems = 0;
-  }
   return code;
 }
 
@@ -252,8 +489,10 @@ void taosCloseQset(taos_qset param) {
     STaosQueue *queue = qset->head;
     qset->head = qset->head->next;
 
+    taosWLockLatch(&queue->latch);
     queue->qset = NULL;
     queue->next = NULL;
+    taosWUnLockLatch(&queue->latch);
   }
   pthread_mutex_unlock(&qset->mutex);
 
@@ -286,8 +525,10 @@ int taosAddIntoQset(taos_qset p1, taos_queue p2, void *ahandle) {
   qset->numOfQueues++;
 
   pthread_mutex_lock(&queue->mutex);
-  atomic_add_fetch_32(&qset->numOfItems, queue->numOfItems);
+  taosWLockLatch(&queue->latch);
+  atomic_add_fetch_32(&qset->numOfItems, atomic_load_32(&queue->numOfItems));
   queue->qset = qset;
+  taosWUnLockLatch(&queue->latch);
   pthread_mutex_unlock(&queue->mutex);
 
   pthread_mutex_unlock(&qset->mutex);
@@ -328,9 +569,11 @@ void taosRemoveFromQset(taos_qset p1, taos_queue p2) {
       qset->numOfQueues--;
 
       pthread_mutex_lock(&queue->mutex);
-      atomic_sub_fetch_32(&qset->numOfItems, queue->numOfItems);
+      taosWLockLatch(&queue->latch);
+      atomic_sub_fetch_32(&qset->numOfItems, atomic_load_32(&queue->numOfItems));
       queue->qset = NULL;
       queue->next = NULL;
+      taosWUnLockLatch(&queue->latch);
       pthread_mutex_unlock(&queue->mutex);
     }
   } 
@@ -359,20 +602,15 @@ int taosReadQitemFromQset(taos_qset param, int *type, void **pitem, void **phand
     STaosQueue *queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (taosQueueEmpty(queue)) continue;
 
     pthread_mutex_lock(&queue->mutex);
 
-    if (queue->head) {
-        pNode = queue->head;
+    pNode = taosPopQnode(queue);
+    if (pNode) {
         *pitem = pNode->item;
         if (type) *type = pNode->type;
         if (phandle) *phandle = queue->ahandle;
-        queue->head = pNode->next;
-        if (queue->head == NULL) 
-          queue->tail = NULL;
-        queue->numOfItems--;
-        atomic_sub_fetch_32(&qset->numOfItems, 1);
         code = 1;
         uTrace("item:%p is read out from queue:%p, type:%d items:%d", *pitem, queue, pNode->type, queue->numOfItems);
     } 
@@ -401,22 +639,13 @@ int taosReadAllQitemsFromQset(taos_qset param, taos_qall p2, void **phandle) {
     queue = qset->current;
     if (queue) qset->current = queue->next;
     if (queue == NULL) break;
-    if (queue->head == NULL) continue;
+    if (taosQueueEmpty(queue)) continue;
 
     pthread_mutex_lock(&queue->mutex);
 
-    if (queue->head) {
-      qall->current = queue->head;
-      qall->start = queue->head;
-      qall->numOfItems = queue->numOfItems;
-      qall->itemSize = queue->itemSize;
-      code = qall->numOfItems;
+    code = taosPopAllQnodes(queue, qall);
+    if (code > 0) {
       *phandle = queue->ahandle;
-          
-      queue->head = NULL;
-      queue->tail = NULL;
-      queue->numOfItems = 0;
-      atomic_sub_fetch_32(&qset->numOfItems, qall->numOfItems);
       for (int j=1; j<qall->numOfItems; ++j) tsem_wait(&qset->sem);
     } 
 
@@ -433,20 +662,12 @@ int taosGetQueueItemsNumber(taos_queue param) {
   STaosQueue *queue = (STaosQueue *)param;
   if (!queue) return 0;
 
-  int num;
-  pthread_mutex_lock(&queue->mutex);
-  num = queue->numOfItems;
-  pthread_mutex_unlock(&queue->mutex);
-  return num;
+  return atomic_load_32(&queue->numOfItems);
 }
 
 int taosGetQsetItemsNumber(taos_qset param) {
   STaosQset *qset = (STaosQset *)param;
   if (!qset) return 0;
 
-  int num = 0;
-  pthread_mutex_lock(&qset->mutex);
-  num = qset->numOfItems;
-  pthread_mutex_unlock(&qset->mutex);
-  return num;
+  return atomic_load_32(&qset->numOfItems);
 }
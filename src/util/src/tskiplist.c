@@ -701,6 +701,10 @@ static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipL
         pSkipList->insertHandleFn->args[0] = pData;
         pSkipList->insertHandleFn->args[1] = NULL;
         pData = genericInvoke(pSkipList->insertHandleFn);
+        if (pData == NULL) {  // the data can not be allocated, nothing is inserted
+          tSkipListFreeNode(pNode);
+          return NULL;
+        }
       }
       pNode->pData = pData;
 
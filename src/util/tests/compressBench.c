@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taosdef.h"
+#include "tscompression.h"
+
+typedef int (*FCompress)(const char *const input, const int nelements, char *const output);
+
+typedef struct {
+  const char *name;
+  int         bytes;
+  FCompress   compress;
+  FCompress   decompress;
+} SCodec;
+
+static int compressInt(const char *const input, const int n, char *const output) {
+  return tsCompressINTImp(input, n, output, TSDB_DATA_TYPE_INT);
+}
+
+static int decompressInt(const char *const input, const int n, char *const output) {
+  return tsDecompressINTImp(input, n, output, TSDB_DATA_TYPE_INT);
+}
+
+static int compressBigint(const char *const input, const int n, char *const output) {
+  return tsCompressINTImp(input, n, output, TSDB_DATA_TYPE_BIGINT);
+}
+
+static int decompressBigint(const char *const input, const int n, char *const output) {
+  return tsDecompressINTImp(input, n, output, TSDB_DATA_TYPE_BIGINT);
+}
+
+static SCodec codecs[] = {
+    {"int", INT_BYTES, compressInt, decompressInt},
+    {"bigint", LONG_BYTES, compressBigint, decompressBigint},
+    {"timestamp", LONG_BYTES, tsCompressTimestampImp, tsDecompressTimestampImp},
+    {"float", FLOAT_BYTES, tsCompressFloatImp, tsDecompressFloatImp},
+    {"double", DOUBLE_BYTES, tsCompressDoubleImp, tsDecompressDoubleImp},
+};
+
+static const char *distributions[] = {"constant", "regular", "small-jitter", "random"};
+
+static void fillData(const SCodec *pCodec, int dist, char *data, int rows) {
+  int64_t v = 1600000000000L;
+  double  d = 20.0;
+
+  for (int i = 0; i < rows; i++) {
+    int64_t r = (int64_t)rand();
+    switch (dist) {
+      case 0: break;
+      case 1: v += 1000; d += 0.5; break;
+      case 2: v += 1000 + r % 16; d += (r % 16) / 100.0; break;
+      default: v = ((int64_t)r << 20) ^ rand(); d = (double)r / RAND_MAX; break;
+    }
+
+    if (strcmp(pCodec->name, "int") == 0) {
+      ((int32_t *)data)[i] = (int32_t)v;
+    } else if (strcmp(pCodec->name, "float") == 0) {
+      ((float *)data)[i] = (float)d;
+    } else if (strcmp(pCodec->name, "double") == 0) {
+      ((double *)data)[i] = d;
+    } else {
+      ((int64_t *)data)[i] = v;
+    }
+  }
+}
+
+static double mbPerSec(int64_t bytes, int64_t us) { return us > 0 ? (double)bytes / us : 0; }
+
+int main(int argc, char *argv[]) {
+  int rows = 4096;
+  int loops = 2000;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-r") == 0 && i < argc - 1) {
+      rows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && i < argc - 1) {
+      loops = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-r]: rows per block, default: %d\n", rows);
+      printf("  [-l]: number of loops, default: %d\n", loops);
+      exit(0);
+    }
+  }
+
+  int   simd = tsCompressGetSimdLevel();
+  char *data = malloc((size_t)rows * LONG_BYTES);
+  char *comp = malloc((size_t)rows * LONG_BYTES + 16);
+  char *out = malloc((size_t)rows * LONG_BYTES);
+
+  printf("rows:%d loops:%d simd level:%d, throughput in MB/s of uncompressed data\n", rows, loops, simd);
+  printf("%-10s %-13s %8s %10s %10s %10s\n", "codec", "distribution", "ratio", "encode", "decode", "decode-simd");
+
+  for (int c = 0; c < tListLen(codecs); c++) {
+    SCodec *pCodec = codecs + c;
+    for (int dist = 0; dist < tListLen(distributions); dist++) {
+      int64_t bytes = (int64_t)rows * pCodec->bytes;
+      int     clen = 0;
+
+      srand(dist);
+      fillData(pCodec, dist, data, rows);
+
+      int64_t st = taosGetTimestampUs();
+      for (int l = 0; l < loops; l++) clen = pCodec->compress(data, rows, comp);
+      int64_t encUs = taosGetTimestampUs() - st;
+
+      tsCompressSetSimdLevel(COMP_SIMD_NONE);
+      st = taosGetTimestampUs();
+      for (int l = 0; l < loops; l++) pCodec->decompress(comp, rows, out);
+      int64_t decUs = taosGetTimestampUs() - st;
+
+      tsCompressSetSimdLevel(simd);
+      st = taosGetTimestampUs();
+      for (int l = 0; l < loops; l++) pCodec->decompress(comp, rows, out);
+      int64_t simdUs = taosGetTimestampUs() - st;
+
+      if (memcmp(data, out, bytes) != 0) {
+        printf("%s/%s: decoded data mismatch\n", pCodec->name, distributions[dist]);
+        return 1;
+      }
+
+      printf("%-10s %-13s %8.2f %10.1f %10.1f %10.1f\n", pCodec->name, distributions[dist], (double)bytes / clen,
+             mbPerSec(bytes * loops, encUs), mbPerSec(bytes * loops, decUs), mbPerSec(bytes * loops, simdUs));
+    }
+  }
+
+  free(data);
+  free(comp);
+  free(out);
+  return 0;
+}
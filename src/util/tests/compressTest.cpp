@@ -0,0 +1,99 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "taosdef.h"
+#include "tscompression.h"
+
+namespace {
+
+const int kRows[] = {0, 1, 2, 3, 7, 239, 240, 241, 1000, 4096};
+
+// decode with the scalar code and with the best SIMD kernel, both must give back the input
+template <typename T>
+void checkDecode(const std::vector<T>& data, int (*compress)(const char* const, const int, char* const),
+                 int (*decompress)(const char* const, const int, char* const)) {
+  int               n = (int)data.size();
+  std::vector<char> comp(n * sizeof(T) + 16);
+  std::vector<T>    scalar(n + 1), simd(n + 1);
+
+  int clen = compress((const char*)data.data(), n, comp.data());
+  ASSERT_GE(clen, 0);
+
+  tsCompressSetSimdLevel(COMP_SIMD_NONE);
+  ASSERT_EQ(decompress(comp.data(), n, (char*)scalar.data()), (int)(n * sizeof(T)));
+  tsCompressSetSimdLevel(COMP_SIMD_AVX2);
+  ASSERT_EQ(decompress(comp.data(), n, (char*)simd.data()), (int)(n * sizeof(T)));
+
+  ASSERT_EQ(memcmp(scalar.data(), data.data(), n * sizeof(T)), 0);
+  ASSERT_EQ(memcmp(simd.data(), data.data(), n * sizeof(T)), 0);
+}
+
+template <typename T, char type>
+int compressInt(const char* const input, const int n, char* const output) {
+  return tsCompressINTImp(input, n, output, type);
+}
+
+template <typename T, char type>
+int decompressInt(const char* const input, const int n, char* const output) {
+  return tsDecompressINTImp(input, n, output, type);
+}
+
+template <typename T, char type>
+void intTest() {
+  std::mt19937_64 gen(7);
+  for (int n : kRows) {
+    // diff widths hitting every selector, zigzag values must stay within 60 bits to be encoded
+    for (int width : {0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 45, 60}) {
+      if (width > 8 * (int)sizeof(T)) break;
+      std::vector<T> data(n);
+      T              v = 0;
+      for (int i = 0; i < n; i++) {
+        int64_t d = width == 0 ? 0 : (int64_t)(gen() >> (64 - width)) - ((int64_t)1 << (width - 1));
+        v = (T)(v + d);
+        data[i] = v;
+      }
+      checkDecode<T>(data, compressInt<T, type>, decompressInt<T, type>);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(testCase, compress_simple8b_test) {
+  intTest<int8_t, TSDB_DATA_TYPE_TINYINT>();
+  intTest<int16_t, TSDB_DATA_TYPE_SMALLINT>();
+  intTest<int32_t, TSDB_DATA_TYPE_INT>();
+  intTest<int64_t, TSDB_DATA_TYPE_BIGINT>();
+}
+
+TEST(testCase, compress_timestamp_test) {
+  std::mt19937_64 gen(7);
+  for (int n : kRows) {
+    for (int jitter : {0, 1, 100, 1 << 20}) {
+      std::vector<int64_t> data(n);
+      int64_t              ts = 1600000000000L;
+      for (int i = 0; i < n; i++) {
+        ts += 1000 + (jitter ? (int64_t)(gen() % jitter) : 0);
+        data[i] = ts;
+      }
+      checkDecode<int64_t>(data, tsCompressTimestampImp, tsDecompressTimestampImp);
+    }
+  }
+}
+
+TEST(testCase, compress_float_test) {
+  std::mt19937_64                  gen(7);
+  std::normal_distribution<double> distr(20.0, 5.0);
+  for (int n : kRows) {
+    std::vector<double> dv(n);
+    std::vector<float>  fv(n);
+    for (int i = 0; i < n; i++) {
+      dv[i] = (i % 3 == 0) ? 20.5 : distr(gen);
+      fv[i] = (float)dv[i];
+    }
+    checkDecode<double>(dv, tsCompressDoubleImp, tsDecompressDoubleImp);
+    checkDecode<float>(fv, tsCompressFloatImp, tsDecompressFloatImp);
+  }
+}
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taosdef.h"
+#include "tglobal.h"
+#include "tlog.h"
+
+/*
+ * CPU nanoseconds per debug line spent by 1 to N printing threads, without the work of the log thread that writes
+ * the file, and the wall clock of all the lines in parentheses. The "mutex" column reproduces the previous
+ * log buffer: the time formatted by localtime_r and sprintf for each line, and one ring of 20MB locked by a mutex,
+ * which drops the lines when it is full. The "text" column is taosPrintLog and the "deferred" column is
+ * taosPrintDeferredLog, both on the rings of the threads.
+ */
+
+#define MUTEX_BUF_SIZE (20 * 1024 * 1024)
+
+extern int64_t asyncLogLostLines;
+
+typedef struct {
+  char           *buffer;
+  int32_t         start;
+  int32_t         end;
+  int32_t         fd;
+  int32_t         stop;
+  int64_t         lost;
+  pthread_mutex_t mutex;
+} SMutexLog;
+
+static SMutexLog mutexLog;
+static int32_t   numOfLines = 200000;
+static int64_t   cpuNs = 0;
+
+static int64_t taosGetThreadCpuNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void mutexPush(const char *msg, int32_t len) {
+  pthread_mutex_lock(&mutexLog.mutex);
+  int32_t start = mutexLog.start, end = mutexLog.end;
+  int32_t remain = (start > end) ? (start - end - 1) : (start + MUTEX_BUF_SIZE - end - 1);
+  if (remain <= len) {
+    mutexLog.lost++;
+  } else {
+    int32_t first = MIN(len, MUTEX_BUF_SIZE - end);
+    memcpy(mutexLog.buffer + end, msg, first);
+    memcpy(mutexLog.buffer, msg + first, len - first);
+    mutexLog.end = (end + len) % MUTEX_BUF_SIZE;
+  }
+  pthread_mutex_unlock(&mutexLog.mutex);
+}
+
+static void mutexPrintLog(const char *flags, const char *format, ...) {
+  char           buffer[1010];
+  struct tm      Tm, *ptm;
+  struct timeval timeSecs;
+  time_t         curTime;
+
+  gettimeofday(&timeSecs, NULL);
+  curTime = timeSecs.tv_sec;
+  ptm = localtime_r(&curTime, &Tm);
+
+  int32_t len = sprintf(buffer, "%02d/%02d %02d:%02d:%02d.%06d %08" PRId64 " ", ptm->tm_mon + 1, ptm->tm_mday,
+                        ptm->tm_hour, ptm->tm_min, ptm->tm_sec, (int32_t)timeSecs.tv_usec, taosGetSelfPthreadId());
+  len += sprintf(buffer + len, "%s", flags);
+
+  va_list argpointer;
+  va_start(argpointer, format);
+  len += vsnprintf(buffer + len, 900, format, argpointer);
+  va_end(argpointer);
+
+  buffer[len++] = '\n';
+  mutexPush(buffer, len);
+}
+
+static void *mutexDrain(void *param) {
+  while (1) {
+    pthread_mutex_lock(&mutexLog.mutex);
+    int32_t start = mutexLog.start, end = mutexLog.end;
+    pthread_mutex_unlock(&mutexLog.mutex);
+
+    if (start < end) {
+      taosWrite(mutexLog.fd, mutexLog.buffer + start, end - start);
+    } else if (start > end) {
+      taosWrite(mutexLog.fd, mutexLog.buffer + start, MUTEX_BUF_SIZE - start);
+      taosWrite(mutexLog.fd, mutexLog.buffer, end);
+    }
+
+    pthread_mutex_lock(&mutexLog.mutex);
+    mutexLog.start = end;
+    pthread_mutex_unlock(&mutexLog.mutex);
+
+    if (start == end && mutexLog.stop) break;
+    taosMsleep(5);
+  }
+  return NULL;
+}
+
+static void *mutexThread(void *param) {
+  int32_t id = *(int32_t *)param;
+  int64_t st = taosGetThreadCpuNs();
+  for (int32_t i = 0; i < numOfLines; ++i) {
+    mutexPrintLog("BCH ", "vgId:%d, thread:%d, write version:%" PRId64 " to table:%s, rows:%d", 2, id, (int64_t)i,
+                  "d1001", 100);
+  }
+  atomic_add_fetch_64(&cpuNs, taosGetThreadCpuNs() - st);
+  return NULL;
+}
+
+static void *textThread(void *param) {
+  int32_t id = *(int32_t *)param;
+  int64_t st = taosGetThreadCpuNs();
+  for (int32_t i = 0; i < numOfLines; ++i) {
+    taosPrintLog("BCH ", DEBUG_FILE | DEBUG_DEBUG, "vgId:%d, thread:%d, write version:%" PRId64 " to table:%s, rows:%d",
+                 2, id, (int64_t)i, "d1001", 100);
+  }
+  atomic_add_fetch_64(&cpuNs, taosGetThreadCpuNs() - st);
+  return NULL;
+}
+
+static void *deferredThread(void *param) {
+  int32_t id = *(int32_t *)param;
+  int64_t st = taosGetThreadCpuNs();
+  for (int32_t i = 0; i < numOfLines; ++i) {
+    taosPrintDeferredLog("BCH ", DEBUG_FILE | DEBUG_DEBUG,
+                         "vgId:%d, thread:%d, write version:%" PRId64 " to table:%s, rows:%d", 2, id, (int64_t)i,
+                         "d1001", 100);
+  }
+  atomic_add_fetch_64(&cpuNs, taosGetThreadCpuNs() - st);
+  return NULL;
+}
+
+// return the CPU nanoseconds of the printing threads per line, and the wall clock nanoseconds per line
+static double runThreads(void *(*fp)(void *), int32_t numOfThreads, double *wallNs) {
+  pthread_t *threads = malloc(sizeof(pthread_t) * numOfThreads);
+  int32_t *  ids = malloc(sizeof(int32_t) * numOfThreads);
+
+  cpuNs = 0;
+  int64_t st = taosGetTimestampUs();
+  for (int32_t i = 0; i < numOfThreads; ++i) {
+    ids[i] = i;
+    pthread_create(&threads[i], NULL, fp, &ids[i]);
+  }
+  for (int32_t i = 0; i < numOfThreads; ++i) pthread_join(threads[i], NULL);
+  int64_t us = taosGetTimestampUs() - st;
+
+  free(threads);
+  free(ids);
+  *wallNs = us * 1000.0 / ((double)numOfLines * numOfThreads);
+  return cpuNs / ((double)numOfLines * numOfThreads);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t maxThreads = 16;
+  char    dir[PATH_MAX] = "/tmp";
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numOfLines = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-t") == 0 && i < argc - 1) {
+      maxThreads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i < argc - 1) {
+      tstrncpy(dir, argv[++i], PATH_MAX);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-n]: lines printed by each thread, default: %d\n", numOfLines);
+      printf("  [-t]: max number of threads, default: %d\n", maxThreads);
+      printf("  [-d]: directory of the log files, default: %s\n", dir);
+      exit(0);
+    }
+  }
+
+  char name[PATH_MAX + 20];
+  snprintf(name, sizeof(name), "%s/mutexBench.log", dir);
+  mutexLog.buffer = malloc(MUTEX_BUF_SIZE);
+  mutexLog.fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
+  pthread_mutex_init(&mutexLog.mutex, NULL);
+
+  snprintf(name, sizeof(name), "%s/logBench", dir);
+  tsAsyncLog = 1;
+  if (mutexLog.fd < 0 || taosInitLog(name, 100000000, 1) != 0) {
+    printf("failed to open the log files in %s\n", dir);
+    return 1;
+  }
+
+  pthread_t drainThread;
+  pthread_create(&drainThread, NULL, mutexDrain, NULL);
+
+  printf("lines per thread:%d, nanoseconds per line\n", numOfLines);
+  printf("%8s %18s %18s %18s %12s\n", "threads", "mutex", "text", "deferred", "mutexLost");
+
+  for (int32_t t = 1; t <= maxThreads; t *= 2) {
+    int64_t lost = mutexLog.lost;
+    double  wall[3];
+    double  mutexNs = runThreads(mutexThread, t, &wall[0]);
+    double  textNs = runThreads(textThread, t, &wall[1]);
+    double  deferredNs = runThreads(deferredThread, t, &wall[2]);
+    printf("%8d %8.1f (%7.1f) %8.1f (%7.1f) %8.1f (%7.1f) %12" PRId64 "\n", t, mutexNs, wall[0], textNs, wall[1],
+           deferredNs, wall[2], mutexLog.lost - lost);
+  }
+
+  mutexLog.stop = 1;
+  pthread_join(drainThread, NULL);
+  taosCloseLog();
+  printf("lost lines of the thread rings:%" PRId64 "\n", asyncLogLostLines);
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tglobal.h"
+#include "tlog.h"
+
+namespace {
+
+const int32_t LOG_TEST_FLAG = DEBUG_FILE | DEBUG_TRACE | DEBUG_DEBUG | DEBUG_WARN | DEBUG_ERROR;
+
+void printLines(int32_t thread, int32_t num) {
+  for (int32_t i = 0; i < num; ++i) {
+    if (i % 2 == 0) {
+      taosPrintLog("TST ", LOG_TEST_FLAG, "thread:%d line:%d text", thread, i);
+    } else {
+      taosPrintDeferredLog("TST ", LOG_TEST_FLAG, "thread:%d line:%d deferred:%s", thread, i, "abc");
+    }
+  }
+}
+
+// the text after the flags of each line with the flags
+std::vector<std::string> readLines(const char *fileName) {
+  std::vector<std::string> lines;
+  std::ifstream            in(fileName);
+  std::string              line;
+  while (std::getline(in, line)) {
+    size_t pos = line.find("TST ");
+    if (pos != std::string::npos) lines.push_back(line.substr(pos + 4));
+  }
+  return lines;
+}
+
+}  // namespace
+
+TEST(testCase, log_deferred_thread_test) {
+  const char *logName = "/tmp/tlogtest/taoslog";
+  taosMkDir("/tmp/tlogtest", 0755);
+  remove("/tmp/tlogtest/taoslog.0");
+  remove("/tmp/tlogtest/taoslog.1");
+
+  tsAsyncLog = 1;
+  ASSERT_EQ(taosInitLog((char *)logName, 100000000, 1), 0);
+
+  // the deferred arguments are formatted as printf does
+  int64_t     i64 = -1234567890123LL;
+  uint64_t    u64 = 18446744073709551615ULL;
+  const char *nullStr = NULL;
+  char        str[] = "changed later";
+  taosPrintDeferredLog("TST ", LOG_TEST_FLAG, "fmt:%d %5u %-4x| %08.3f %e %g %c %% %s %.4s %10s %p %" PRId64 " %" PRIu64
+                       " %zu %ld %lld %hd", -7, 42u, 255, 3.14159, 1e-10, 2.5, 'z', "str", "truncated", "right",
+                       (void *)0x1234, i64, u64, (size_t)99, -5L, 6LL, (short)-3);
+  taosPrintDeferredLog("TST ", LOG_TEST_FLAG, "fmt:%s %s", nullStr, str);
+  strcpy(str, "XXXXXXXXXXXXX");
+
+  // not supported, formatted at once
+  taosPrintDeferredLog("TST ", LOG_TEST_FLAG, "fmt:%*d|%-*s|", 5, 1, 3, "a");
+
+  // each thread pushes more than its ring holds
+  const int32_t numOfThreads = 8;
+  const int32_t numOfLines = 20000;
+
+  std::vector<std::thread> threads;
+  for (int32_t i = 0; i < numOfThreads; ++i) threads.emplace_back(printLines, i, numOfLines);
+  for (auto &t : threads) t.join();
+
+  taosCloseLog();
+
+  std::vector<std::string> lines = readLines("/tmp/tlogtest/taoslog.0");
+
+  char expected[3][512];
+  snprintf(expected[0], sizeof(expected[0]), "fmt:%d %5u %-4x| %08.3f %e %g %c %% %s %.4s %10s %p %" PRId64 " %" PRIu64
+           " %zu %ld %lld %hd", -7, 42u, 255, 3.14159, 1e-10, 2.5, 'z', "str", "truncated", "right", (void *)0x1234, i64,
+           u64, (size_t)99, -5L, 6LL, (short)-3);
+  snprintf(expected[1], sizeof(expected[1]), "fmt:(null) changed later");
+  snprintf(expected[2], sizeof(expected[2]), "fmt:%*d|%-*s|", 5, 1, 3, "a");
+
+  std::vector<std::string> fmtLines;
+  std::map<int32_t, int32_t> next;
+  for (auto &line : lines) {
+    if (line.compare(0, 4, "fmt:") == 0) {
+      fmtLines.push_back(line);
+      continue;
+    }
+
+    int32_t thread = -1, seq = -1;
+    ASSERT_EQ(sscanf(line.c_str(), "thread:%d line:%d", &thread, &seq), 2) << line;
+
+    // no line is lost, and the lines of a thread keep their order
+    ASSERT_EQ(seq, next[thread]) << line;
+    next[thread] = seq + 1;
+
+    char text[128];
+    snprintf(text, sizeof(text), (seq % 2 == 0) ? "thread:%d line:%d text" : "thread:%d line:%d deferred:abc", thread,
+             seq);
+    ASSERT_EQ(line, text);
+  }
+
+  ASSERT_EQ(next.size(), (size_t)numOfThreads);
+  for (auto &kv : next) ASSERT_EQ(kv.second, numOfLines);
+
+  ASSERT_EQ(fmtLines.size(), 3u);
+  for (int32_t i = 0; i < 3; ++i) ASSERT_EQ(fmtLines[i], expected[i]);
+}
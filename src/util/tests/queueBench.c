@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os.h"
+#include "taosdef.h"
+#include "tqueue.h"
+
+// the previous queue in a queue set, a mutex protected list with one calloc per item, kept here as the baseline
+typedef struct SMutexNode {
+  int                type;
+  struct SMutexNode *next;
+  char               item[];
+} SMutexNode;
+
+typedef struct {
+  SMutexNode     *head;
+  SMutexNode     *tail;
+  int32_t         numOfItems;
+  int32_t         numOfQsetItems;
+  pthread_mutex_t mutex;
+  pthread_mutex_t qsetMutex;
+  tsem_t          sem;
+} SMutexQueue;
+
+static void *mutexAllocateItem(int size) {
+  SMutexNode *pNode = calloc(sizeof(SMutexNode) + size, 1);
+  return pNode ? pNode->item : NULL;
+}
+
+static void mutexFreeItem(void *item) { free((char *)item - sizeof(SMutexNode)); }
+
+static void mutexWriteItem(SMutexQueue *queue, int type, void *item) {
+  SMutexNode *pNode = (SMutexNode *)((char *)item - sizeof(SMutexNode));
+  pNode->type = type;
+  pNode->next = NULL;
+
+  pthread_mutex_lock(&queue->mutex);
+  if (queue->tail) {
+    queue->tail->next = pNode;
+  } else {
+    queue->head = pNode;
+  }
+  queue->tail = pNode;
+  queue->numOfItems++;
+  atomic_add_fetch_32(&queue->numOfQsetItems, 1);
+  pthread_mutex_unlock(&queue->mutex);
+
+  tsem_post(&queue->sem);
+}
+
+static int mutexReadAllItems(SMutexQueue *queue, SMutexNode **pList) {
+  tsem_wait(&queue->sem);
+
+  pthread_mutex_lock(&queue->qsetMutex);
+  pthread_mutex_lock(&queue->mutex);
+  int num = queue->numOfItems;
+  *pList = queue->head;
+  queue->head = queue->tail = NULL;
+  queue->numOfItems = 0;
+  atomic_sub_fetch_32(&queue->numOfQsetItems, num);
+  for (int i = 1; i < num; ++i) tsem_wait(&queue->sem);
+  pthread_mutex_unlock(&queue->mutex);
+  pthread_mutex_unlock(&queue->qsetMutex);
+
+  return num;
+}
+
+typedef struct {
+  int          lockFree;
+  int          numOfItems;
+  int          itemSize;
+  taos_queue   queue;
+  SMutexQueue *pMutexQueue;
+} SProducer;
+
+static void *produceItems(void *param) {
+  SProducer *pProducer = param;
+
+  for (int i = 0; i < pProducer->numOfItems; ++i) {
+    if (pProducer->lockFree) {
+      void *item = taosAllocateQitem(pProducer->itemSize);
+      taosWriteQitem(pProducer->queue, 1, item);
+    } else {
+      void *item = mutexAllocateItem(pProducer->itemSize);
+      mutexWriteItem(pProducer->pMutexQueue, 1, item);
+    }
+  }
+
+  return NULL;
+}
+
+// items per second passed from all producers to one consumer, which drains the queue like a vnode worker
+static double runBench(int lockFree, int numOfProducers, int numOfItems, int itemSize) {
+  SMutexQueue mutexQueue = {0};
+  taos_qset   qset = taosOpenQset();
+  taos_queue  queue = taosOpenQueue();
+  taos_qall   qall = taosAllocateQall();
+  pthread_t  *threads = calloc(numOfProducers, sizeof(pthread_t));
+  SProducer   producer = {lockFree, numOfItems, itemSize, queue, &mutexQueue};
+
+  pthread_mutex_init(&mutexQueue.mutex, NULL);
+  pthread_mutex_init(&mutexQueue.qsetMutex, NULL);
+  tsem_init(&mutexQueue.sem, 0, 0);
+  taosAddIntoQset(qset, queue, NULL);
+
+  int64_t st = taosGetTimestampUs();
+  for (int i = 0; i < numOfProducers; ++i) pthread_create(threads + i, NULL, produceItems, &producer);
+
+  int64_t total = (int64_t)numOfProducers * numOfItems;
+  for (int64_t consumed = 0; consumed < total;) {
+    if (lockFree) {
+      void *ahandle;
+      int   type;
+      void *item;
+      int   num = taosReadAllQitemsFromQset(qset, qall, &ahandle);
+      for (int i = 0; i < num; ++i) {
+        taosGetQitem(qall, &type, &item);
+        taosFreeQitem(item);
+      }
+      consumed += num;
+    } else {
+      SMutexNode *pNode;
+      consumed += mutexReadAllItems(&mutexQueue, &pNode);
+      while (pNode) {
+        SMutexNode *pNext = pNode->next;
+        mutexFreeItem(pNode->item);
+        pNode = pNext;
+      }
+    }
+  }
+  int64_t us = taosGetTimestampUs() - st;
+
+  for (int i = 0; i < numOfProducers; ++i) pthread_join(threads[i], NULL);
+
+  free(threads);
+  taosFreeQall(qall);
+  taosCloseQueue(queue);
+  taosCloseQset(qset);
+  pthread_mutex_destroy(&mutexQueue.mutex);
+  pthread_mutex_destroy(&mutexQueue.qsetMutex);
+  tsem_destroy(&mutexQueue.sem);
+
+  return us > 0 ? total * 1000000.0 / us : 0;
+}
+
+int main(int argc, char *argv[]) {
+  int numOfItems = 200000;
+  int itemSize = 64;
+  int maxProducers = 64;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      numOfItems = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && i < argc - 1) {
+      itemSize = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-p") == 0 && i < argc - 1) {
+      maxProducers = atoi(argv[++i]);
+    } else {
+      printf("\nusage: %s [options] \n", argv[0]);
+      printf("  [-n]: items written by each producer, default: %d\n", numOfItems);
+      printf("  [-s]: item size, default: %d\n", itemSize);
+      printf("  [-p]: max number of producers, default: %d\n", maxProducers);
+      exit(0);
+    }
+  }
+
+  printf("items per producer:%d item size:%d, throughput in items/sec\n", numOfItems, itemSize);
+  printf("%-10s %14s %14s\n", "producers", "mutex", "lock-free");
+
+  for (int p = 1; p <= maxProducers; p *= 2) {
+    double mutexRate = runBench(0, p, numOfItems, itemSize);
+    double lockFreeRate = runBench(1, p, numOfItems, itemSize);
+    printf("%-10d %14.0f %14.0f\n", p, mutexRate, lockFreeRate);
+  }
+
+  return 0;
+}
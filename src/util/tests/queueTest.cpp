@@ -0,0 +1,145 @@
+#include "os.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "tqueue.h"
+
+namespace {
+
+struct SItem {
+  int32_t producer;
+  int32_t seq;
+  char    payload[40];
+};
+
+void produce(taos_queue queue, int32_t producer, int32_t num) {
+  for (int32_t i = 0; i < num; ++i) {
+    // mix small cached items with large ones allocated by calloc
+    int32_t size = (i % 10 == 0) ? 8192 : (int32_t)sizeof(SItem);
+    SItem  *pItem = (SItem *)taosAllocateQitem(size);
+    ASSERT_NE(pItem, nullptr);
+    ASSERT_EQ(pItem->seq, 0);
+    pItem->producer = producer;
+    pItem->seq = i + 1;
+    taosWriteQitem(queue, producer, pItem);
+  }
+}
+
+}  // namespace
+
+TEST(testCase, queue_single_thread_test) {
+  taos_queue queue = taosOpenQueue();
+  taos_qall  qall = taosAllocateQall();
+  int        type;
+  void      *pItem;
+
+  ASSERT_EQ(taosReadQitem(queue, &type, &pItem), 0);
+
+  produce(queue, 1, 10);
+  ASSERT_EQ(taosGetQueueItemsNumber(queue), 10);
+
+  ASSERT_EQ(taosReadQitem(queue, &type, &pItem), 1);
+  ASSERT_EQ(((SItem *)pItem)->seq, 1);
+  taosFreeQitem(pItem);
+
+  produce(queue, 2, 5);
+  ASSERT_EQ(taosReadAllQitems(queue, qall), 14);
+  ASSERT_EQ(taosGetQueueItemsNumber(queue), 0);
+
+  // items still come out in FIFO order
+  for (int32_t i = 0; i < 14; ++i) {
+    ASSERT_EQ(taosGetQitem(qall, &type, &pItem), 1);
+    ASSERT_EQ(type, i < 9 ? 1 : 2);
+    ASSERT_EQ(((SItem *)pItem)->seq, i < 9 ? i + 2 : i - 8);
+    taosFreeQitem(pItem);
+  }
+  ASSERT_EQ(taosGetQitem(qall, &type, &pItem), 0);
+
+  produce(queue, 3, 3);
+  taosFreeQall(qall);
+  taosCloseQueue(queue);
+}
+
+TEST(testCase, queue_multi_producer_test) {
+  const int32_t numOfProducers = 8;
+  const int32_t numOfItems = 20000;
+
+  taos_qset  qset = taosOpenQset();
+  taos_queue queue = taosOpenQueue();
+  taos_qall  qall = taosAllocateQall();
+  taosAddIntoQset(qset, queue, (void *)queue);
+
+  std::vector<std::thread> producers;
+  for (int32_t p = 0; p < numOfProducers; ++p) producers.emplace_back(produce, queue, p, numOfItems);
+
+  std::vector<int32_t> lastSeq(numOfProducers, 0);
+  int32_t              total = 0;
+  while (total < numOfProducers * numOfItems) {
+    void *ahandle = NULL;
+    int   num = taosReadAllQitemsFromQset(qset, qall, &ahandle);
+    ASSERT_EQ(ahandle, (void *)queue);
+
+    for (int i = 0; i < num; ++i) {
+      int    type;
+      SItem *pItem;
+      ASSERT_EQ(taosGetQitem(qall, &type, (void **)&pItem), 1);
+      ASSERT_EQ(type, pItem->producer);
+      ASSERT_EQ(pItem->seq, lastSeq[type] + 1);
+      lastSeq[type] = pItem->seq;
+      taosFreeQitem(pItem);
+    }
+    total += num;
+  }
+
+  for (auto &t : producers) t.join();
+  ASSERT_EQ(taosGetQsetItemsNumber(qset), 0);
+
+  taosFreeQall(qall);
+  taosCloseQueue(queue);
+  taosCloseQset(qset);
+}
+
+// the queue is moved to a new qset and the old one is closed while the producers are writing
+TEST(testCase, queue_qset_switch_test) {
+  const int32_t numOfProducers = 4;
+  const int32_t numOfItems = 20000;
+
+  taos_queue queue = taosOpenQueue();
+  taos_qall  qall = taosAllocateQall();
+  taos_qset  qset = taosOpenQset();
+  taosAddIntoQset(qset, queue, (void *)queue);
+
+  std::vector<std::thread> producers;
+  for (int32_t p = 0; p < numOfProducers; ++p) producers.emplace_back(produce, queue, p, numOfItems);
+
+  int32_t total = 0;
+  for (int32_t round = 0; round < 500; ++round) {
+    taos_qset newQset = taosOpenQset();
+    taosRemoveFromQset(qset, queue);
+    taosCloseQset(qset);
+    qset = newQset;
+    taosAddIntoQset(qset, queue, (void *)queue);
+
+    if (round % 10 == 0) {
+      int num = taosReadAllQitems(queue, qall);
+      for (int i = 0; i < num; ++i) {
+        int   type;
+        void *pItem;
+        ASSERT_EQ(taosGetQitem(qall, &type, &pItem), 1);
+        taosFreeQitem(pItem);
+      }
+      total += num;
+    }
+  }
+
+  for (auto &t : producers) t.join();
+
+  // every item written is counted once in the qset holding the queue
+  EXPECT_EQ(taosGetQueueItemsNumber(queue), numOfProducers * numOfItems - total);
+  EXPECT_EQ(taosGetQsetItemsNumber(qset), taosGetQueueItemsNumber(queue));
+
+  taosFreeQall(qall);
+  taosCloseQueue(queue);
+  taosCloseQset(qset);
+}
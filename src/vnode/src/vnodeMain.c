@@ -320,6 +320,8 @@ int32_t vnodeOpen(int32_t vgId) {
   appH.cqH = pVnode->cq;
   appH.cqCreateFunc = cqCreate;
   appH.cqDropFunc = cqDrop;
+  appH.cqWatchTableFunc = cqWatchTable;
+  appH.cqAppendRowsFunc = cqAppendRows;
 
   terrno = 0;
   pVnode->tsdb = tsdbOpenRepo(&(pVnode->tsdbCfg), &appH);
@@ -30,6 +30,7 @@ static void    vnodeCleanupHash(void);
 static void    vnodeIncRef(void *ptNode);
 
 static SStep tsVnodeSteps[] = {
+  {"tsdb-readahead", tsdbInitReadAheadPool, tsdbCleanupReadAheadPool},
   {"vnode-backup", vnodeInitBackup,    vnodeCleanupBackup},
   {"vnode-worker", vnodeInitMWorker,    vnodeCleanupMWorker},
   {"vnode-write",  vnodeInitWrite,      vnodeCleanupWrite},
@@ -199,6 +200,21 @@ void vnodeBuildStatusMsg(void *param) {
   }
 }
 
+int32_t vnodeGetBufPoolStatis(int32_t vgId, STsdbBufPoolStatis *pStatis) {
+  SVnodeObj *pVnode = vnodeAcquireNotClose(vgId);
+  if (pVnode == NULL) return TSDB_CODE_VND_INVALID_VGROUP_ID;
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (pVnode->tsdb != NULL) {
+    tsdbGetBufPoolStatis(pVnode->tsdb, pStatis);
+  } else {
+    code = TSDB_CODE_APP_NOT_READY;
+  }
+
+  vnodeRelease(pVnode);
+  return code;
+}
+
 void vnodeSetAccess(SVgroupAccess *pAccess, int32_t numOfVnodes) {
   for (int32_t i = 0; i < numOfVnodes; ++i) {
     pAccess[i].vgId = htonl(pAccess[i].vgId);
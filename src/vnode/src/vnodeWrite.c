@@ -51,14 +51,19 @@ int32_t vnodeInitWrite(void) {
 void vnodeCleanupWrite() {}
 
 int32_t vnodeProcessWrite(void *vparam, void *wparam, int32_t qtype, void *rparam) {
+  int32_t code = vnodeLogWrite(vparam, wparam, qtype, rparam);
+  if (code < 0) return code;
+
+  return vnodeApplyWrite(vparam, wparam, code, rparam);
+}
+
+// Assign the version, forward to the peers and append to the WAL, return the code of the forward
+int32_t vnodeLogWrite(void *vparam, void *wparam, int32_t qtype, void *rparam) {
   int32_t    code = 0;
   SVnodeObj *pVnode = vparam;
   SWalHead * pHead = wparam;
   SVWriteMsg*pWrite = rparam;
 
-  SRspRet *pRspRet = NULL;
-  if (pWrite != NULL) pRspRet = &pWrite->rspRet;
-
   if (vnodeProcessWriteMsgFp[pHead->msgType] == NULL) {
     vError("vgId:%d, msg:%s not processed since no handle, qtype:%s hver:%" PRIu64, pVnode->vgId,
            taosMsg[pHead->msgType], qtypeStr[qtype], pHead->version);
@@ -108,8 +113,19 @@ int32_t vnodeProcessWrite(void *vparam, void *wparam, int32_t qtype, void *rpara
 
   pVnode->version = pHead->version;
 
-  // write data locally
-  code = (*vnodeProcessWriteMsgFp[pHead->msgType])(pVnode, pHead->cont, pRspRet);
+  return syncCode;
+}
+
+// Write the data of a logged message locally, syncCode is returned by vnodeLogWrite
+int32_t vnodeApplyWrite(void *vparam, void *wparam, int32_t syncCode, void *rparam) {
+  SVnodeObj *pVnode = vparam;
+  SWalHead * pHead = wparam;
+  SVWriteMsg*pWrite = rparam;
+
+  SRspRet *pRspRet = NULL;
+  if (pWrite != NULL) pRspRet = &pWrite->rspRet;
+
+  int32_t code = (*vnodeProcessWriteMsgFp[pHead->msgType])(pVnode, pHead->cont, pRspRet);
   if (code < 0) {
     if (syncCode > 0) atomic_sub_fetch_32(&pWrite->processedCount, 1);
     return code;
@@ -376,7 +392,7 @@ static int32_t vnodePerformFlowCtrl(SVWriteMsg *pWrite) {
   SVnodeObj *pVnode = pWrite->pVnode;
   if (pWrite->qtype != TAOS_QTYPE_RPC) return 0;
   if (pVnode->queuedWMsg < MAX_QUEUED_MSG_NUM && pVnode->queuedWMsgSize < MAX_QUEUED_MSG_SIZE &&
-      pVnode->flowctrlLevel <= 0)
+      pVnode->flowctrlLevel <= 0 && (pVnode->tsdb == NULL || !tsdbIsBufPoolFull(pVnode->tsdb)))
     return 0;
 
   if (tsEnableFlowCtrl == 0) {
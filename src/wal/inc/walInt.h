@@ -29,7 +29,7 @@ extern int32_t wDebugFlag;
 #define wWarn(...)  { if (wDebugFlag & DEBUG_WARN)  { taosPrintLog("WAL WARN ", 255, __VA_ARGS__); }}
 #define wInfo(...)  { if (wDebugFlag & DEBUG_INFO)  { taosPrintLog("WAL ", 255, __VA_ARGS__); }}
 #define wDebug(...) { if (wDebugFlag & DEBUG_DEBUG) { taosPrintLog("WAL ", wDebugFlag, __VA_ARGS__); }}
-#define wTrace(...) { if (wDebugFlag & DEBUG_TRACE) { taosPrintLog("WAL ", wDebugFlag, __VA_ARGS__); }}
+#define wTrace(...) { if (wDebugFlag & DEBUG_TRACE) { taosPrintDeferredLog("WAL ", wDebugFlag, __VA_ARGS__); }}
 
 #define WAL_PREFIX     "wal"
 #define WAL_PREFIX_LEN 3
@@ -39,6 +39,7 @@ extern int32_t wDebugFlag;
 #define WAL_PATH_LEN   (TSDB_FILENAME_LEN + 12)
 #define WAL_FILE_LEN   (WAL_PATH_LEN + 32)
 #define WAL_FILE_NUM   1 // 3
+#define WAL_GROUP_BUF_SIZE (1024 * 1024)  // a group is flushed early once its buffer grows past this size
 
 typedef struct {
   uint64_t version;
@@ -51,15 +52,33 @@ typedef struct {
   int32_t  fsyncPeriod;
   int32_t  fsyncSeq;
   int8_t   stop;
-  int8_t   reserved[3];
+  int8_t   groupCommit;
+  int8_t   flushing;    // a group leader is writing pFlushBuf out of the mutex
+  int8_t   reserved[1];
   char     path[WAL_PATH_LEN];
   char     name[WAL_FILE_LEN];
   pthread_mutex_t mutex;
+  pthread_cond_t  cond;  // signaled when a group is flushed
+
+  // group commit: records are appended to pBuf and written out in groups by walFsync
+  char *   pBuf;
+  char *   pFlushBuf;
+  int32_t  bufLen;
+  int32_t  bufSize;
+  int32_t  flushBufSize;
+  int32_t  bufRecords;
+  uint64_t appendSeq;  // number of records appended
+  uint64_t flushSeq;   // records up to this seq are written to the file
+  uint64_t syncSeq;    // records up to this seq are synced to disk
+  uint64_t failSeq;    // records in (failFrom, failSeq] were lost by a failed flush
+  uint64_t failFrom;
+  int32_t  failCode;
 } SWal;
 
 int32_t walGetNextFile(SWal *pWal, int64_t *nextFileId);
 int32_t walGetOldFile(SWal *pWal, int64_t curFileId, int32_t minDiff, int64_t *oldFileId);
 int32_t walGetNewFile(SWal *pWal, int64_t *newFileId);
+int32_t walFlushBuffer(SWal *pWal);
 
 #ifdef __cplusplus
 }
@@ -18,6 +18,7 @@
 #include "taoserror.h"
 #include "tref.h"
 #include "tfile.h"
+#include "tglobal.h"
 #include "twal.h"
 #include "walInt.h"
 
@@ -75,8 +76,10 @@ void *walOpen(char *path, SWalCfg *pCfg) {
   pWal->level = pCfg->walLevel;
   pWal->keep = pCfg->keep;
   pWal->fsyncPeriod = pCfg->fsyncPeriod;
+  pWal->groupCommit = tsWalGroupCommit;
   tstrncpy(pWal->path, path, sizeof(pWal->path));
   pthread_mutex_init(&pWal->mutex, NULL);
+  pthread_cond_init(&pWal->cond, NULL);
 
   pWal->fsyncSeq = pCfg->fsyncPeriod / 1000;
   if (pWal->fsyncSeq <= 0) pWal->fsyncSeq = 1;
@@ -92,7 +95,8 @@ void *walOpen(char *path, SWalCfg *pCfg) {
     return NULL;
   }
 
-  wDebug("vgId:%d, wal:%p is opened, level:%d fsyncPeriod:%d", pWal->vgId, pWal, pWal->level, pWal->fsyncPeriod);
+  wDebug("vgId:%d, wal:%p is opened, level:%d fsyncPeriod:%d groupCommit:%d", pWal->vgId, pWal, pWal->level,
+         pWal->fsyncPeriod, pWal->groupCommit);
 
   return pWal;
 }
@@ -133,6 +137,7 @@ void walClose(void *handle) {
 
   SWal *pWal = handle;
   pthread_mutex_lock(&pWal->mutex);
+  walFlushBuffer(pWal);
   tfClose(pWal->tfd);
   pthread_mutex_unlock(&pWal->mutex);
   taosRemoveRef(tsWal.refId, pWal->rid);
@@ -154,6 +159,9 @@ static void walFreeObj(void *wal) {
 
   tfClose(pWal->tfd);
   pthread_mutex_destroy(&pWal->mutex);
+  pthread_cond_destroy(&pWal->cond);
+  tfree(pWal->pBuf);
+  tfree(pWal->pFlushBuf);
   tfree(pWal);
 }
 
@@ -181,6 +189,11 @@ static void walFsyncAll() {
   while (pWal) {
     if (walNeedFsync(pWal)) {
       wTrace("vgId:%d, do fsync, level:%d seq:%d rseq:%d", pWal->vgId, pWal->level, pWal->fsyncSeq, tsWal.seq);
+      if (pWal->groupCommit) {
+        pthread_mutex_lock(&pWal->mutex);
+        walFlushBuffer(pWal);
+        pthread_mutex_unlock(&pWal->mutex);
+      }
       int32_t code = tfFsync(pWal->tfd);
       if (code != 0) {
         wError("vgId:%d, file:%s, failed to fsync since %s", pWal->vgId, pWal->name, strerror(code));
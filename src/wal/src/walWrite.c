@@ -39,6 +39,7 @@ int32_t walRenew(void *handle) {
   pthread_mutex_lock(&pWal->mutex);
 
   if (tfValid(pWal->tfd)) {
+    walFlushBuffer(pWal);
     tfClose(pWal->tfd);
     wDebug("vgId:%d, file:%s, it is closed while renew", pWal->vgId, pWal->name);
   }
@@ -96,7 +97,8 @@ void walRemoveAllOldFiles(void *handle) {
   int64_t fileId = -1;
 
   pthread_mutex_lock(&pWal->mutex);
-  
+
+  walFlushBuffer(pWal);
   tfClose(pWal->tfd);
   wDebug("vgId:%d, file:%s, it is closed before remove all wals", pWal->vgId, pWal->name);
 
@@ -134,11 +136,144 @@ static int walValidateChecksum(SWalHead *pHead) {
 
 #endif
 
+static SWalStatis tsWalStatis = {0};
+
+void walGetStatis(SWalStatis *pStatis) {
+  pStatis->numOfBatches = atomic_exchange_64(&tsWalStatis.numOfBatches, 0);
+  pStatis->numOfRecords = atomic_exchange_64(&tsWalStatis.numOfRecords, 0);
+  pStatis->numOfFsyncs = atomic_exchange_64(&tsWalStatis.numOfFsyncs, 0);
+  pStatis->fsyncUs = atomic_exchange_64(&tsWalStatis.fsyncUs, 0);
+}
+
+static int32_t walDoFsync(SWal *pWal, int64_t tfd) {
+  int64_t st = taosGetTimestampUs();
+  int32_t code = 0;
+
+  wTrace("vgId:%d, fileId:%" PRId64 ", do fsync", pWal->vgId, pWal->fileId);
+  if (tfFsync(tfd) < 0) {
+    code = TAOS_SYSTEM_ERROR(errno);
+    wError("vgId:%d, fileId:%" PRId64 ", fsync failed since %s", pWal->vgId, pWal->fileId, strerror(errno));
+  }
+
+  atomic_add_fetch_64(&tsWalStatis.numOfFsyncs, 1);
+  atomic_add_fetch_64(&tsWalStatis.fsyncUs, taosGetTimestampUs() - st);
+  return code;
+}
+
+static int32_t walWriteGroup(SWal *pWal, int64_t tfd, char *pBuf, int32_t len, int32_t records) {
+  if (len <= 0) return 0;
+
+  if (tfWrite(tfd, pBuf, len) != len) {
+    wError("vgId:%d, file:%s, failed to write %d records since %s", pWal->vgId, pWal->name, records, strerror(errno));
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  wTrace("vgId:%d, write wal group, fileId:%" PRId64 " records:%d len:%d", pWal->vgId, pWal->fileId, records, len);
+  atomic_add_fetch_64(&tsWalStatis.numOfBatches, 1);
+  atomic_add_fetch_64(&tsWalStatis.numOfRecords, records);
+  return 0;
+}
+
+static void walSetGroupResult(SWal *pWal, uint64_t seq, int32_t code, bool synced) {
+  if (code != 0) {
+    pWal->failFrom = pWal->flushSeq;
+    pWal->failSeq = seq;
+    pWal->failCode = code;
+  }
+
+  pWal->flushSeq = seq;
+  if (synced && code == 0) pWal->syncSeq = seq;
+}
+
+// Write out the pending group in place, the caller holds pWal->mutex
+int32_t walFlushBuffer(SWal *pWal) {
+  while (pWal->flushing) {
+    pthread_cond_wait(&pWal->cond, &pWal->mutex);
+  }
+
+  if (pWal->bufLen <= 0) return 0;
+
+  int32_t code = walWriteGroup(pWal, pWal->tfd, pWal->pBuf, pWal->bufLen, pWal->bufRecords);
+  walSetGroupResult(pWal, pWal->appendSeq, code, false);
+  pWal->bufLen = 0;
+  pWal->bufRecords = 0;
+
+  return code;
+}
+
+// Make every record appended so far durable. The first caller to find no flush in progress becomes the leader: it
+// takes the whole buffer, writes it with a single write and an optional fsync out of the mutex, while later writers
+// append to the other buffer and wait for the next group.
+static int32_t walFlushGroup(SWal *pWal, bool fsync) {
+  int32_t code = 0;
+
+  pthread_mutex_lock(&pWal->mutex);
+
+  uint64_t target = pWal->appendSeq;
+  while ((fsync ? pWal->syncSeq : pWal->flushSeq) < target) {
+    if (target > pWal->failFrom && target <= pWal->failSeq) break;
+
+    if (pWal->flushing) {
+      pthread_cond_wait(&pWal->cond, &pWal->mutex);
+      continue;
+    }
+
+    char *  pBuf = pWal->pBuf;
+    int32_t bufSize = pWal->bufSize;
+    int32_t len = pWal->bufLen;
+    int32_t records = pWal->bufRecords;
+    uint64_t seq = pWal->appendSeq;
+    int64_t tfd = pWal->tfd;
+
+    pWal->pBuf = pWal->pFlushBuf;
+    pWal->bufSize = pWal->flushBufSize;
+    pWal->pFlushBuf = pBuf;
+    pWal->flushBufSize = bufSize;
+    pWal->bufLen = 0;
+    pWal->bufRecords = 0;
+    pWal->flushing = 1;
+    pthread_mutex_unlock(&pWal->mutex);
+
+    int32_t ret = walWriteGroup(pWal, tfd, pBuf, len, records);
+    if (ret == 0 && fsync) ret = walDoFsync(pWal, tfd);
+
+    pthread_mutex_lock(&pWal->mutex);
+    walSetGroupResult(pWal, seq, ret, fsync);
+    pWal->flushing = 0;
+    pthread_cond_broadcast(&pWal->cond);
+  }
+
+  if (target > pWal->failFrom && target <= pWal->failSeq) code = pWal->failCode;
+
+  pthread_mutex_unlock(&pWal->mutex);
+
+  return code;
+}
+
+static int32_t walAppendToGroup(SWal *pWal, SWalHead *pHead, int32_t contLen) {
+  if (pWal->bufLen + contLen > pWal->bufSize) {
+    int32_t size = MAX(pWal->bufSize * 2, pWal->bufLen + contLen);
+    char *  pBuf = realloc(pWal->pBuf, size);
+    if (pBuf == NULL) return TSDB_CODE_WAL_OUT_OF_MEMORY;
+
+    pWal->pBuf = pBuf;
+    pWal->bufSize = size;
+  }
+
+  memcpy(pWal->pBuf + pWal->bufLen, pHead, contLen);
+  pWal->bufLen += contLen;
+  pWal->bufRecords++;
+  pWal->appendSeq++;
+
+  return 0;
+}
+
 int32_t walWrite(void *handle, SWalHead *pHead) {
   if (handle == NULL) return -1;
 
   SWal *  pWal = handle;
   int32_t code = 0;
+  bool    flush = false;
 
   // no wal
   if (!tfValid(pWal->tfd)) return 0;
@@ -157,32 +292,50 @@ int32_t walWrite(void *handle, SWalHead *pHead) {
 
   pthread_mutex_lock(&pWal->mutex);
 
-  if (tfWrite(pWal->tfd, pHead, contLen) != contLen) {
+  if (pWal->groupCommit) {
+    code = walAppendToGroup(pWal, pHead, contLen);
+    if (code != 0) {
+      wError("vgId:%d, file:%s, failed to append to wal group since %s", pWal->vgId, pWal->name, tstrerror(code));
+    } else {
+      wTrace("vgId:%d, append wal, fileId:%" PRId64 " hver:%" PRId64 " wver:%" PRIu64 " len:%d", pWal->vgId,
+             pWal->fileId, pHead->version, pWal->version, pHead->len);
+      pWal->version = pHead->version;
+      flush = (pWal->bufLen >= WAL_GROUP_BUF_SIZE);
+    }
+  } else if (tfWrite(pWal->tfd, pHead, contLen) != contLen) {
     code = TAOS_SYSTEM_ERROR(errno);
     wError("vgId:%d, file:%s, failed to write since %s", pWal->vgId, pWal->name, strerror(errno));
   } else {
     wTrace("vgId:%d, write wal, fileId:%" PRId64 " tfd:%" PRId64 " hver:%" PRId64 " wver:%" PRIu64 " len:%d", pWal->vgId,
            pWal->fileId, pWal->tfd, pHead->version, pWal->version, pHead->len);
     pWal->version = pHead->version;
+    atomic_add_fetch_64(&tsWalStatis.numOfBatches, 1);
+    atomic_add_fetch_64(&tsWalStatis.numOfRecords, 1);
   }
 
   pthread_mutex_unlock(&pWal->mutex);
 
   ASSERT(contLen == pHead->len + sizeof(SWalHead));
 
+  if (flush) code = walFlushGroup(pWal, false);
+
   return code;
 }
 
-void walFsync(void *handle, bool forceFsync) {
+int32_t walFsync(void *handle, bool forceFsync) {
   SWal *pWal = handle;
-  if (pWal == NULL || !tfValid(pWal->tfd)) return;
+  if (pWal == NULL || !tfValid(pWal->tfd)) return 0;
 
-  if (forceFsync || (pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0)) {
-    wTrace("vgId:%d, fileId:%" PRId64 ", do fsync", pWal->vgId, pWal->fileId);
-    if (tfFsync(pWal->tfd) < 0) {
-      wError("vgId:%d, fileId:%" PRId64 ", fsync failed since %s", pWal->vgId, pWal->fileId, strerror(errno));
-    }
+  bool fsync = forceFsync || (pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0);
+  if (pWal->groupCommit) {
+    return walFlushGroup(pWal, fsync);
+  }
+
+  if (fsync) {
+    return walDoFsync(pWal, pWal->tfd);
   }
+
+  return 0;
 }
 
 int32_t walRestore(void *handle, void *pVnode, FWalWrite writeFp) {
@@ -239,6 +392,9 @@ int32_t walGetWalFile(void *handle, char *fileName, int64_t *fileId) {
 
   pthread_mutex_lock(&(pWal->mutex));
 
+  // the peer reads the file directly, records still in the group buffer must be there
+  walFlushBuffer(pWal);
+
   int32_t code = walGetNextFile(pWal, fileId);
   if (code >= 0) {
     sprintf(fileName, "wal/%s%" PRId64, WAL_PREFIX, *fileId);
@@ -0,0 +1,159 @@
+// Checks the sql cache of the client with room for two entries: a select with leading spaces in upper case is cached,
+// the entry added the earliest is evicted by a new one when the cache is full, and an entry of the same sql with other
+// literals is replaced without evicting another one.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "taos.h"
+
+// not in taos.h
+extern int32_t tsSqlCacheSize;
+extern int64_t tscSqlCacheHits;
+extern int64_t tscSqlCacheMisses;
+
+#define PRINT_ERROR printf("\033[31m");
+#define PRINT_SUCCESS printf("\033[32m");
+
+#define TS0      1626861392000L
+#define NUM_ROWS 60
+
+static int failed = 0;
+
+static void check(int cond, const char *msg) {
+  if (cond) {
+    PRINT_SUCCESS
+    printf("%s\n", msg);
+  } else {
+    PRINT_ERROR
+    printf("failed: %s\n", msg);
+    failed++;
+  }
+}
+
+static void execute_simple_sql(TAOS *taos, char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+  taos_free_result(result);
+}
+
+// the first column of the first row as int64, whether the sql hits the cache is put in *hit
+static int64_t query_value(TAOS *taos, char *sql, int *hit) {
+  int64_t hits = tscSqlCacheHits;
+  int64_t misses = tscSqlCacheMisses;
+
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+
+  int64_t     value = -1;
+  TAOS_FIELD *fields = taos_fetch_fields(result);
+  TAOS_ROW    row = taos_fetch_row(result);
+  if (row != NULL && row[0] != NULL) {
+    value = (fields[0].type == TSDB_DATA_TYPE_INT) ? *(int32_t *)row[0] : *(int64_t *)row[0];
+  }
+  taos_free_result(result);
+
+  *hit = (tscSqlCacheHits == hits + 1 && tscSqlCacheMisses == misses);
+
+  // the entries are ordered by the milliseconds they are added in
+  usleep(2000);
+  return value;
+}
+
+// select count(*) of the rows from the k-th one, with the leading spaces and in upper case
+static int run_a(TAOS *taos, int k) {
+  char sql[256];
+  int  hit = 0;
+  sprintf(sql, "  SELECT COUNT(*) FROM tb WHERE ts >= %" PRId64, TS0 + k * 1000L);
+  check(query_value(taos, sql, &hit) == NUM_ROWS - k, "a: count of the rows");
+  return hit;
+}
+
+static int run_b(TAOS *taos, int k) {
+  char sql[256];
+  int  hit = 0;
+  sprintf(sql, "select count(c1) from tb where ts >= %" PRId64 " and ts < %" PRId64, TS0 + k * 1000L,
+          TS0 + NUM_ROWS * 1000L);
+  check(query_value(taos, sql, &hit) == NUM_ROWS - k, "b: count of the rows");
+  return hit;
+}
+
+static int run_c(TAOS *taos, int k, int minC1) {
+  char sql[256];
+  int  hit = 0;
+  sprintf(sql, "select sum(c1) from tb where ts >= %" PRId64 " and c1 >= %d", TS0 + k * 1000L, minC1);
+
+  int64_t sum = 0;
+  for (int i = (k > minC1) ? k : minC1; i < NUM_ROWS; i++) {
+    sum += i;
+  }
+  check(query_value(taos, sql, &hit) == sum, "c: sum of the rows");
+  return hit;
+}
+
+int main(int argc, char *argv[]) {
+  tsSqlCacheSize = 2;
+  if (argc > 1) {
+    taos_options(TSDB_OPTION_CONFIGDIR, argv[1]);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    PRINT_ERROR
+    printf("TDengine error: failed to connect\n");
+    exit(EXIT_FAILURE);
+  }
+
+  execute_simple_sql(taos, "drop database if exists sql_cache_api");
+  execute_simple_sql(taos, "create database sql_cache_api");
+  execute_simple_sql(taos, "use sql_cache_api");
+  execute_simple_sql(taos, "create table tb (ts timestamp, c1 int)");
+  for (int i = 0; i < NUM_ROWS; i++) {
+    char sql[128];
+    sprintf(sql, "insert into tb values (%" PRId64 ", %d)", TS0 + i * 1000L, i);
+    execute_simple_sql(taos, sql);
+  }
+
+  check(!run_a(taos, 0), "a is validated");
+  check(run_a(taos, 10), "a with leading spaces in upper case hits the cache");
+
+  check(!run_b(taos, 0), "b is validated");
+  check(!run_c(taos, 0, 0), "c is validated, a is evicted");
+  check(run_c(taos, 5, 0), "c hits the cache");
+  check(run_b(taos, 5), "b hits the cache");
+
+  check(!run_a(taos, 20), "a is validated again, b is evicted");
+  check(run_a(taos, 30), "a hits the cache");
+
+  // the cache is full of c and a
+  check(!run_c(taos, 10, 30), "c with another literal is validated and replaces c");
+  check(run_c(taos, 40, 30), "c with the other literal hits the cache");
+  check(run_a(taos, 40), "a is not evicted by the replacement");
+  check(!run_b(taos, 10), "b is validated again");
+
+  taos_close(taos);
+
+  if (failed > 0) {
+    PRINT_ERROR
+    printf("%d checks failed\n", failed);
+    printf("\033[0m");
+    exit(EXIT_FAILURE);
+  }
+
+  PRINT_SUCCESS
+  printf("all checks passed\n");
+  printf("\033[0m");
+  return 0;
+}
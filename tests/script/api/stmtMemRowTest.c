@@ -0,0 +1,356 @@
+// Checks the rows bound with taos_stmt_bind_param_batch for every column of a table, which are written as SMemRow
+// rows by the client: ordered and disordered batches, a server time mixed in a disordered batch, taos_stmt_reset and
+// single row binds mixed with the batches.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "taos.h"
+
+// not in taos.h
+int taos_stmt_reset(TAOS_STMT *stmt);
+
+#define PRINT_ERROR printf("\033[31m");
+#define PRINT_SUCCESS printf("\033[32m");
+
+#define MAX_ROWS 100
+
+typedef struct {
+  int64_t ts[MAX_ROWS];
+  int32_t c1[MAX_ROWS];
+  char    c1Null[MAX_ROWS];
+  char    c2[MAX_ROWS][10];
+  int32_t c2Len[MAX_ROWS];
+  char    c3[MAX_ROWS][16];
+  int32_t c3Len[MAX_ROWS];
+  double  c4[MAX_ROWS];
+  int32_t fixLen[MAX_ROWS];
+} SRows;
+
+static int failed = 0;
+
+static void check(int cond, const char *msg) {
+  if (cond) {
+    PRINT_SUCCESS
+    printf("%s\n", msg);
+  } else {
+    PRINT_ERROR
+    printf("failed: %s\n", msg);
+    failed++;
+  }
+}
+
+static void execute_simple_sql(TAOS *taos, char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+  taos_free_result(result);
+}
+
+// the first row of the result, the columns as int64, 1 if there is no row
+static int query_row(TAOS *taos, char *sql, int64_t *values, int num) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    return -1;
+  }
+
+  TAOS_FIELD *fields = taos_fetch_fields(result);
+  TAOS_ROW    row = taos_fetch_row(result);
+  if (row == NULL) {
+    taos_free_result(result);
+    return 1;
+  }
+
+  for (int i = 0; i < num; i++) {
+    if (row[i] == NULL) {
+      values[i] = INT64_MIN;
+    } else if (fields[i].type == TSDB_DATA_TYPE_BIGINT || fields[i].type == TSDB_DATA_TYPE_TIMESTAMP) {
+      values[i] = *(int64_t *)row[i];
+    } else if (fields[i].type == TSDB_DATA_TYPE_INT) {
+      values[i] = *(int32_t *)row[i];
+    } else if (fields[i].type == TSDB_DATA_TYPE_DOUBLE) {
+      values[i] = (int64_t)(*(double *)row[i]);
+    } else if (fields[i].type == TSDB_DATA_TYPE_BINARY || fields[i].type == TSDB_DATA_TYPE_NCHAR) {
+      int *lengths = taos_fetch_lengths(result);
+      values[i] = lengths[i];
+    }
+  }
+
+  taos_free_result(result);
+  return 0;
+}
+
+static void make_rows(SRows *rows, int num, int64_t ts0, int step) {
+  for (int i = 0; i < num; i++) {
+    rows->ts[i] = ts0 + (int64_t)i * step;
+    rows->c1[i] = i;
+    rows->c1Null[i] = (i % 10 == 9);
+    rows->c2Len[i] = sprintf(rows->c2[i], "b%d", i);
+    rows->c3Len[i] = sprintf(rows->c3[i], "n%d", i % 100);
+    rows->c4[i] = i * 2;
+    rows->fixLen[i] = sizeof(int64_t);
+  }
+}
+
+static void make_binds(TAOS_MULTI_BIND *params, SRows *rows, int num) {
+  memset(params, 0, sizeof(TAOS_MULTI_BIND) * 5);
+
+  params[0].buffer_type = TSDB_DATA_TYPE_TIMESTAMP;
+  params[0].buffer_length = sizeof(int64_t);
+  params[0].buffer = rows->ts;
+  params[0].length = rows->fixLen;
+  params[0].num = num;
+
+  params[1].buffer_type = TSDB_DATA_TYPE_INT;
+  params[1].buffer_length = sizeof(int32_t);
+  params[1].buffer = rows->c1;
+  params[1].length = rows->fixLen;
+  params[1].is_null = rows->c1Null;
+  params[1].num = num;
+
+  params[2].buffer_type = TSDB_DATA_TYPE_BINARY;
+  params[2].buffer_length = sizeof(rows->c2[0]);
+  params[2].buffer = rows->c2;
+  params[2].length = rows->c2Len;
+  params[2].num = num;
+
+  params[3].buffer_type = TSDB_DATA_TYPE_NCHAR;
+  params[3].buffer_length = sizeof(rows->c3[0]);
+  params[3].buffer = rows->c3;
+  params[3].length = rows->c3Len;
+  params[3].num = num;
+
+  params[4].buffer_type = TSDB_DATA_TYPE_DOUBLE;
+  params[4].buffer_length = sizeof(double);
+  params[4].buffer = rows->c4;
+  params[4].length = rows->fixLen;
+  params[4].num = num;
+}
+
+static TAOS_STMT *prepare_stmt(TAOS *taos, char *tbname) {
+  TAOS_STMT *stmt = taos_stmt_init(taos);
+  if (stmt == NULL || taos_stmt_prepare(stmt, "insert into ? values (?,?,?,?,?)", 0) != 0 ||
+      taos_stmt_set_tbname(stmt, tbname) != 0) {
+    PRINT_ERROR
+    printf("failed to prepare the statement of %s\n", tbname);
+    exit(EXIT_FAILURE);
+  }
+  return stmt;
+}
+
+static int bind_rows(TAOS_STMT *stmt, SRows *rows, int num) {
+  TAOS_MULTI_BIND params[5];
+  make_binds(params, rows, num);
+  if (taos_stmt_bind_param_batch(stmt, params) != 0) return -1;
+  return taos_stmt_add_batch(stmt);
+}
+
+// the sums of the bound rows
+static void expect_rows(TAOS *taos, char *tbname, int64_t count, int64_t sumC1, int64_t sumC4) {
+  char    sql[256];
+  int64_t values[4] = {0};
+  char    msg[256];
+
+  sprintf(sql, "select count(*), sum(c1), sum(c4), count(c1) from %s", tbname);
+  // no row at all for an empty table
+  int code = query_row(taos, sql, values, 4);
+  if (code == 1 && count == 0) code = 0;
+  sprintf(msg, "%s: rows %" PRId64 " sum(c1) %" PRId64 " sum(c4) %" PRId64 ", expected %" PRId64 " %" PRId64
+               " %" PRId64, tbname, values[0], values[1], values[2], count, sumC1, sumC4);
+  check(code == 0 && values[0] == count && values[1] == sumC1 && values[2] == sumC4, msg);
+}
+
+static void test_ordered_batch(TAOS *taos) {
+  SRows rows;
+  make_rows(&rows, MAX_ROWS, 1626861392000, 1);
+
+  TAOS_STMT *stmt = prepare_stmt(taos, "t1");
+  check(bind_rows(stmt, &rows, MAX_ROWS) == 0 && taos_stmt_execute(stmt) == 0, "ordered batch is inserted");
+  taos_stmt_close(stmt);
+
+  // c1 of every tenth row is null
+  int64_t sumC1 = 0;
+  for (int i = 0; i < MAX_ROWS; i++) sumC1 += rows.c1Null[i] ? 0 : rows.c1[i];
+  expect_rows(taos, "t1", MAX_ROWS, sumC1, MAX_ROWS * (MAX_ROWS - 1));
+
+  int64_t values[3] = {0};
+  int     code = query_row(taos, "select c1, c2, c3 from t1 where ts = 1626861392057", values, 3);
+  check(code == 0 && values[0] == 57 && values[1] == 3 && values[2] == 3, "ordered batch: the values of a row");
+}
+
+static void test_disordered_batch(TAOS *taos) {
+  SRows rows;
+  make_rows(&rows, MAX_ROWS, 1626861392000, 1);
+
+  // reversed, and every fifth row duplicates the one before it, so the first row is not there
+  SRows disordered;
+  memcpy(&disordered, &rows, sizeof(SRows));
+  for (int i = 0; i < MAX_ROWS; i++) {
+    int src = MAX_ROWS - 1 - i;
+    if (i % 5 == 4) src += 1;
+    disordered.ts[i] = rows.ts[src];
+    disordered.c1[i] = rows.c1[src];
+    disordered.c1Null[i] = rows.c1Null[src];
+    disordered.c4[i] = rows.c4[src];
+    disordered.c2Len[i] = sprintf(disordered.c2[i], "b%d", src);
+    disordered.c3Len[i] = sprintf(disordered.c3[i], "n%d", src % 100);
+  }
+
+  int64_t count = 0, sumC1 = 0, sumC4 = 0;
+  for (int i = 0; i < MAX_ROWS; i++) {
+    if (i % 5 == 4) continue;
+    int src = MAX_ROWS - 1 - i;
+    count++;
+    sumC1 += rows.c1Null[src] ? 0 : rows.c1[src];
+    sumC4 += (int64_t)rows.c4[src];
+  }
+
+  TAOS_STMT *stmt = prepare_stmt(taos, "t2");
+  check(bind_rows(stmt, &disordered, MAX_ROWS) == 0 && taos_stmt_execute(stmt) == 0, "disordered batch is inserted");
+  taos_stmt_close(stmt);
+  expect_rows(taos, "t2", count, sumC1, sumC4);
+
+  int64_t values[2] = {0};
+  int     code = query_row(taos, "select first(ts), last(ts) from t2", values, 2);
+  check(code == 0 && values[0] == 1626861392001 && values[1] == 1626861392099, "disordered batch: first and last");
+}
+
+static void test_server_time_in_disordered_batch(TAOS *taos) {
+  SRows rows;
+  make_rows(&rows, 10, 1626861392000, 1);
+
+  // the rows are disordered from the second one, a row later on has the time of the server
+  rows.ts[1] = 1626861391000;
+  rows.ts[8] = INT64_MIN;
+
+  TAOS_STMT *stmt = prepare_stmt(taos, "t3");
+  TAOS_MULTI_BIND params[5];
+  make_binds(params, &rows, 10);
+  check(taos_stmt_bind_param_batch(stmt, params) != 0, "server time mixed in a disordered batch is rejected");
+  taos_stmt_close(stmt);
+  expect_rows(taos, "t3", 0, 0, 0);
+}
+
+static void test_reset(TAOS *taos) {
+  SRows rows;
+  make_rows(&rows, MAX_ROWS, 1626861392000, 1);
+
+  SRows rows2;
+  make_rows(&rows2, 10, 1626861393000, 1);
+
+  // the rows bound before the reset are not inserted
+  TAOS_STMT *stmt = prepare_stmt(taos, "t4");
+  check(bind_rows(stmt, &rows, MAX_ROWS) == 0, "batch before the reset is bound");
+  check(bind_rows(stmt, &rows, 50) == 0, "another batch before the reset is bound");
+  check(taos_stmt_reset(stmt) == 0, "stmt is reset");
+  check(bind_rows(stmt, &rows2, 10) == 0 && taos_stmt_execute(stmt) == 0, "batch after the reset is inserted");
+  expect_rows(taos, "t4", 10, 36, 90);
+
+  // and the ones executed before it are kept, the table is set again after an execution
+  check(taos_stmt_set_tbname(stmt, "t4") == 0 && bind_rows(stmt, &rows, 40) == 0 && bind_rows(stmt, &rows, 40) == 0 && taos_stmt_execute(stmt) == 0,
+        "two batches are inserted");
+  check(taos_stmt_reset(stmt) == 0, "stmt is reset after the execution");
+  check(taos_stmt_set_tbname(stmt, "t4") == 0 && bind_rows(stmt, &rows, MAX_ROWS) == 0 && taos_stmt_execute(stmt) == 0, "batch after the reset is inserted");
+  taos_stmt_close(stmt);
+
+  int64_t sumC1 = 36;
+  for (int i = 0; i < MAX_ROWS; i++) sumC1 += rows.c1Null[i] ? 0 : rows.c1[i];
+  expect_rows(taos, "t4", MAX_ROWS + 10, sumC1, MAX_ROWS * (MAX_ROWS - 1) + 90);
+}
+
+static void test_mixed_binds(TAOS *taos) {
+  SRows rows;
+  make_rows(&rows, MAX_ROWS, 1626861392000, 2);
+
+  TAOS_STMT *stmt = prepare_stmt(taos, "t5");
+  check(bind_rows(stmt, &rows, 50) == 0, "batch is bound");
+
+  // one row between the rows of the batch, bound alone
+  int64_t   ts = 1626861392001;
+  int32_t   c1 = 1000;
+  char      c2[] = "single";
+  char      c3[] = "one";
+  double    c4 = 1000;
+  uintptr_t lengths[5] = {sizeof(ts), sizeof(c1), strlen(c2), strlen(c3), sizeof(c4)};
+  TAOS_BIND params[5];
+  memset(params, 0, sizeof(params));
+  params[0] = (TAOS_BIND){.buffer_type = TSDB_DATA_TYPE_TIMESTAMP, .buffer = &ts, .buffer_length = lengths[0],
+                          .length = &lengths[0]};
+  params[1] = (TAOS_BIND){.buffer_type = TSDB_DATA_TYPE_INT, .buffer = &c1, .buffer_length = lengths[1],
+                          .length = &lengths[1]};
+  params[2] = (TAOS_BIND){.buffer_type = TSDB_DATA_TYPE_BINARY, .buffer = c2, .buffer_length = lengths[2],
+                          .length = &lengths[2]};
+  params[3] = (TAOS_BIND){.buffer_type = TSDB_DATA_TYPE_NCHAR, .buffer = c3, .buffer_length = lengths[3],
+                          .length = &lengths[3]};
+  params[4] = (TAOS_BIND){.buffer_type = TSDB_DATA_TYPE_DOUBLE, .buffer = &c4, .buffer_length = lengths[4],
+                          .length = &lengths[4]};
+  check(taos_stmt_bind_param(stmt, params) == 0 && taos_stmt_add_batch(stmt) == 0, "single row is bound");
+
+  SRows rows2;
+  make_rows(&rows2, 10, 1626861393000, 1);
+  check(bind_rows(stmt, &rows2, 10) == 0 && taos_stmt_execute(stmt) == 0, "batch after the single row is inserted");
+  taos_stmt_close(stmt);
+
+  int64_t sumC1 = 1000 + 36;
+  int64_t sumC4 = 1000 + 90;
+  for (int i = 0; i < 50; i++) {
+    sumC1 += rows.c1Null[i] ? 0 : rows.c1[i];
+    sumC4 += (int64_t)rows.c4[i];
+  }
+  expect_rows(taos, "t5", 61, sumC1, sumC4);
+
+  int64_t values[2] = {0};
+  int     code = query_row(taos, "select c1, c2 from t5 where ts = 1626861392001", values, 2);
+  check(code == 0 && values[0] == 1000 && values[1] == 6, "single row: the values");
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    taos_options(TSDB_OPTION_CONFIGDIR, argv[1]);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    PRINT_ERROR
+    printf("TDengine error: failed to connect\n");
+    exit(EXIT_FAILURE);
+  }
+
+  execute_simple_sql(taos, "drop database if exists stmt_memrow");
+  execute_simple_sql(taos, "create database stmt_memrow");
+  execute_simple_sql(taos, "use stmt_memrow");
+  execute_simple_sql(taos, "create table st (ts timestamp, c1 int, c2 binary(10), c3 nchar(4), c4 double) tags (t1 int)");
+  for (int i = 1; i <= 5; i++) {
+    char sql[128];
+    sprintf(sql, "create table t%d using st tags (%d)", i, i);
+    execute_simple_sql(taos, sql);
+  }
+
+  test_ordered_batch(taos);
+  test_disordered_batch(taos);
+  test_server_time_in_disordered_batch(taos);
+  test_reset(taos);
+  test_mixed_binds(taos);
+
+  taos_close(taos);
+
+  if (failed > 0) {
+    PRINT_ERROR
+    printf("%d checks failed\n", failed);
+    printf("\033[0m");
+    exit(EXIT_FAILURE);
+  }
+
+  PRINT_SUCCESS
+  printf("all checks passed\n");
+  printf("\033[0m");
+  return 0;
+}
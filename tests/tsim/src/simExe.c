@@ -197,6 +197,12 @@ int32_t simExecuteExpression(SScript *script, char *exp) {
 
   if (op1Len == 1) {
     if (op1[0] == '=') {
+      // the variables like data00 are the cells of the query result, not writable
+      if (strncmp(var1 + 1, "data", 4) == 0) {
+        sprintf(script->error, "lineNum:%d. can not assign to %.*s", script->lines[script->linePos].lineNum, var1Len,
+                var1);
+        return -2;
+      }
       strcpy(simGetVariable(script, var1 + 1, var1Len - 1), t3);
     } else if (op1[0] == '<') {
       val0 = atoi(t0);
@@ -227,7 +233,7 @@ int32_t simExecuteExpression(SScript *script, char *exp) {
 }
 
 bool simExecuteExpCmd(SScript *script, char *option) {
-  simExecuteExpression(script, option);
+  if (simExecuteExpression(script, option) == -2) return false;
   script->linePos++;
   return true;
 }
@@ -235,6 +241,7 @@ bool simExecuteExpCmd(SScript *script, char *option) {
 bool simExecuteTestCmd(SScript *script, char *option) {
   int32_t result;
   result = simExecuteExpression(script, option);
+  if (result == -2) return false;
 
   if (result >= 0)
     script->linePos++;